@@ -0,0 +1,448 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Mock D3D12 device, queue, fence and DXGI adapter for driving the residency manager without a GPU.
+//
+// The GPU runs in one of two modes. Stepped: signals retire a fixed number of submissions after they were
+// executed and only when the caller asks, which keeps the simulator deterministic. Timed: a thread executes
+// each submission for a fixed time, honours queue waits and retires signals as it goes, which is what the
+// stress test uses to load the manager from several threads at once.
+
+#pragma once
+
+#include "ResidencySimulatorPlatform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ResidencyMocks
+{
+	struct MockDeviceStats
+	{
+		MockDeviceStats() { memset(this, 0, sizeof(*this)); }
+
+		UINT64 BytesMadeResident;
+		UINT64 BytesEvicted;
+		UINT64 MakeResidentCalls;
+		UINT64 EvictCalls;
+		// Times the CPU waited on a fence and how many submissions it waited for (stepped mode only)
+		UINT64 Stalls;
+		UINT64 StalledSubmissions;
+		// Queue waits on paging work which hadn't finished when they were submitted
+		UINT64 LateResidency;
+		UINT64 PeakUsage;
+	};
+
+	class MockGpu;
+
+	class MockPageable : public ID3D12Pageable
+	{
+	public:
+		MockPageable(UINT64 SizeIn) : Size(SizeIn), Resident(true) {}
+
+		// Owned by the app
+		ULONG Release() { return 1; }
+
+		const UINT64 Size;
+		bool Resident;
+	};
+
+	class MockFence : public ID3D12Fence
+	{
+	public:
+		MockFence(MockGpu* pGpuIn, UINT64 InitialValue) : pGpu(pGpuIn), CompletedValue(InitialValue) {}
+
+		UINT64 GetCompletedValue() { return CompletedValue; }
+		HRESULT SetEventOnCompletion(UINT64 Value, HANDLE Event);
+		HRESULT Signal(UINT64 Value);
+
+		MockGpu* pGpu;
+		std::atomic<UINT64> CompletedValue;
+	};
+
+	// Every queue shares one timeline and work completes in submission order
+	class MockGpu
+	{
+	public:
+		MockGpu(UINT32 LatencyIn, MockDeviceStats* pStatsIn) :
+			Latency(LatencyIn),
+			NumSubmissions(0),
+			pStats(pStatsIn),
+			SubmissionTime(0),
+			Running(false)
+		{}
+
+		~MockGpu()
+		{
+			StopTimeline();
+		}
+
+		// Execute each submission for the given time on a GPU thread instead of stepping
+		void StartTimeline(UINT32 MicrosecondsPerSubmission)
+		{
+			SubmissionTime = std::chrono::microseconds(MicrosecondsPerSubmission);
+			Running = true;
+			Timeline = std::thread([this] { RunTimeline(); });
+		}
+
+		// Retires everything that is still outstanding
+		void StopTimeline()
+		{
+			if (Timeline.joinable())
+			{
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					Running = false;
+				}
+				Condition.notify_all();
+				Timeline.join();
+			}
+
+			std::lock_guard<std::mutex> Lock(Mutex);
+			while (Pending.empty() == false)
+			{
+				CompleteOldest();
+			}
+		}
+
+		void QueueExecute()
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			NumSubmissions++;
+			if (Timeline.joinable())
+			{
+				PendingCommand Command = { PendingCommand::EXECUTE, nullptr, 0, NumSubmissions };
+				Pending.push_back(Command);
+				Condition.notify_all();
+			}
+		}
+
+		void QueueWait(MockFence* pFence, UINT64 Value)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+
+			// The paging work should always be done before the GPU gets here
+			if (pFence->CompletedValue < Value)
+			{
+				pStats->LateResidency++;
+			}
+
+			if (Timeline.joinable())
+			{
+				PendingCommand Command = { PendingCommand::WAIT, pFence, Value, NumSubmissions };
+				Pending.push_back(Command);
+				Condition.notify_all();
+			}
+		}
+
+		void QueueSignal(MockFence* pFence, UINT64 Value)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			PendingCommand Command = { PendingCommand::SIGNAL, pFence, Value, NumSubmissions };
+			Pending.push_back(Command);
+			Condition.notify_all();
+		}
+
+		// Timed mode only, blocks until everything submitted so far has executed
+		void WaitForIdle()
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Condition.wait(Lock, [this] { return Pending.empty() || Running == false; });
+		}
+
+		// Stepped mode only, completes the signals which are old enough
+		void Retire()
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			while (Pending.empty() == false && Pending.front().Submission + Latency <= NumSubmissions)
+			{
+				CompleteOldest();
+			}
+		}
+
+		// The CPU is blocked until the fence reaches the value
+		void WaitForFence(MockFence* pFence, UINT64 Value)
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			if (pFence->CompletedValue >= Value)
+			{
+				return;
+			}
+
+			pStats->Stalls++;
+			if (Timeline.joinable())
+			{
+				Condition.wait(Lock, [=] { return pFence->CompletedValue >= Value || Running == false; });
+				return;
+			}
+
+			while (pFence->CompletedValue < Value && Pending.empty() == false)
+			{
+				pStats->StalledSubmissions++;
+				CompleteOldest();
+			}
+		}
+
+		// Called when the CPU signals a fence
+		void FenceSignaled()
+		{
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+			}
+			Condition.notify_all();
+		}
+
+		const UINT32 Latency;
+		UINT64 NumSubmissions;
+		MockDeviceStats* pStats;
+
+	private:
+		struct PendingCommand
+		{
+			enum TYPE
+			{
+				EXECUTE,
+				WAIT,
+				SIGNAL
+			};
+
+			TYPE Type;
+			MockFence* pFence;
+			UINT64 Value;
+			UINT64 Submission;
+		};
+
+		// Mutex must be held
+		void CompleteOldest()
+		{
+			PendingCommand& Command = Pending.front();
+			if (Command.Type == PendingCommand::SIGNAL)
+			{
+				UINT64 Current = Command.pFence->CompletedValue;
+				while (Current < Command.Value && Command.pFence->CompletedValue.compare_exchange_weak(Current, Command.Value) == false) {}
+			}
+			Pending.pop_front();
+			Condition.notify_all();
+		}
+
+		void RunTimeline()
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			while (true)
+			{
+				Condition.wait(Lock, [this] { return Pending.empty() == false || Running == false; });
+				if (Running == false)
+				{
+					return;
+				}
+
+				PendingCommand& Command = Pending.front();
+				if (Command.Type == PendingCommand::EXECUTE)
+				{
+					const auto Finish = std::chrono::steady_clock::now() + SubmissionTime;
+					Condition.wait_until(Lock, Finish, [this] { return Running == false; });
+				}
+				else if (Command.Type == PendingCommand::WAIT)
+				{
+					MockFence* pFence = Command.pFence;
+					const UINT64 Value = Command.Value;
+					Condition.wait(Lock, [=] { return pFence->CompletedValue >= Value || Running == false; });
+				}
+
+				if (Running == false)
+				{
+					return;
+				}
+				CompleteOldest();
+			}
+		}
+
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		std::deque<PendingCommand> Pending;
+
+		std::thread Timeline;
+		std::chrono::microseconds SubmissionTime;
+		bool Running;
+	};
+
+	inline HRESULT MockFence::SetEventOnCompletion(UINT64 Value, HANDLE Event)
+	{
+		// The portable residency manager only ever blocks on the call
+		if (Event != nullptr)
+		{
+			return E_INVALIDARG;
+		}
+
+		pGpu->WaitForFence(this, Value);
+		return S_OK;
+	}
+
+	inline HRESULT MockFence::Signal(UINT64 Value)
+	{
+		UINT64 Current = CompletedValue;
+		while (Current < Value && CompletedValue.compare_exchange_weak(Current, Value) == false) {}
+
+		pGpu->FenceSignaled();
+		return S_OK;
+	}
+
+	class MockCommandQueue : public ID3D12CommandQueue
+	{
+	public:
+		MockCommandQueue(MockGpu* pGpuIn) : pGpu(pGpuIn) {}
+
+		HRESULT Wait(ID3D12Fence* pFence, UINT64 Value)
+		{
+			pGpu->QueueWait((MockFence*)pFence, Value);
+			return S_OK;
+		}
+
+		HRESULT Signal(ID3D12Fence* pFence, UINT64 Value)
+		{
+			pGpu->QueueSignal((MockFence*)pFence, Value);
+			return S_OK;
+		}
+
+		void ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists)
+		{
+			pGpu->QueueExecute();
+		}
+
+		HRESULT GetPrivateData(REFGUID Guid, UINT* pDataSize, void* pData)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			auto it = PrivateData.find(std::string((const char*)&Guid, sizeof(GUID)));
+			if (it == PrivateData.end() || *pDataSize < it->second.size())
+			{
+				return E_FAIL;
+			}
+			memcpy(pData, it->second.data(), it->second.size());
+			*pDataSize = UINT(it->second.size());
+			return S_OK;
+		}
+
+		HRESULT SetPrivateData(REFGUID Guid, UINT DataSize, const void* pData)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			PrivateData[std::string((const char*)&Guid, sizeof(GUID))].assign((const BYTE*)pData, (const BYTE*)pData + DataSize);
+			return S_OK;
+		}
+
+	private:
+		MockGpu* pGpu;
+		std::mutex Mutex;
+		std::map<std::string, std::vector<BYTE>> PrivateData;
+	};
+
+	class MockDevice : public ID3D12Device
+	{
+	public:
+		MockDevice(MockGpu* pGpuIn) : pGpu(pGpuIn), CurrentUsage(0), PagingMicrosecondsPerMB(0) {}
+
+		HRESULT CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID Riid, void** ppFence)
+		{
+			*ppFence = (ID3D12Fence*)new MockFence(pGpu, InitialValue);
+			return S_OK;
+		}
+
+		HRESULT MakeResident(UINT NumObjects, ID3D12Pageable* const* ppObjects)
+		{
+			UINT64 BytesPaged = 0;
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				pGpu->pStats->MakeResidentCalls++;
+				for (UINT i = 0; i < NumObjects; i++)
+				{
+					MockPageable* pObject = (MockPageable*)ppObjects[i];
+					if (pObject->Resident == false)
+					{
+						pObject->Resident = true;
+						BytesPaged += pObject->Size;
+					}
+				}
+				CurrentUsage += BytesPaged;
+				pGpu->pStats->BytesMadeResident += BytesPaged;
+				pGpu->pStats->PeakUsage = std::max(pGpu->pStats->PeakUsage, UINT64(CurrentUsage));
+			}
+
+			// MakeResident blocks until the data has been copied in
+			if (PagingMicrosecondsPerMB != 0 && BytesPaged != 0)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(BytesPaged * PagingMicrosecondsPerMB / (1024 * 1024)));
+			}
+			return S_OK;
+		}
+
+		HRESULT Evict(UINT NumObjects, ID3D12Pageable* const* ppObjects)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			pGpu->pStats->EvictCalls++;
+			for (UINT i = 0; i < NumObjects; i++)
+			{
+				MockPageable* pObject = (MockPageable*)ppObjects[i];
+				if (pObject->Resident)
+				{
+					pObject->Resident = false;
+					CurrentUsage -= pObject->Size;
+					pGpu->pStats->BytesEvicted += pObject->Size;
+				}
+			}
+			return S_OK;
+		}
+
+		MockGpu* pGpu;
+		std::atomic<UINT64> CurrentUsage;
+		// Time MakeResident takes per MB paged in, 0 to return immediately
+		UINT32 PagingMicrosecondsPerMB;
+
+	private:
+		std::mutex Mutex;
+	};
+
+	class MockAdapter : public IDXGIAdapter3
+	{
+	public:
+		MockAdapter(MockDevice* pDeviceIn) : pDevice(pDeviceIn), LocalBudget(0), NonLocalBudget(0) {}
+
+		HRESULT QueryVideoMemoryInfo(UINT NodeIndex, DXGI_MEMORY_SEGMENT_GROUP SegmentGroup, DXGI_QUERY_VIDEO_MEMORY_INFO* pInfo)
+		{
+			ZeroMemory(pInfo, sizeof(*pInfo));
+			if (SegmentGroup == DXGI_MEMORY_SEGMENT_GROUP_LOCAL)
+			{
+				pInfo->Budget = LocalBudget;
+				pInfo->CurrentUsage = pDevice->CurrentUsage;
+			}
+			else
+			{
+				pInfo->Budget = NonLocalBudget;
+			}
+			return S_OK;
+		}
+
+		MockDevice* pDevice;
+		// Can be changed from any thread to simulate other processes competing for memory
+		std::atomic<UINT64> LocalBudget;
+		std::atomic<UINT64> NonLocalBudget;
+	};
+
+	class MockCommandList : public ID3D12CommandList
+	{
+	};
+}
@@ -0,0 +1,457 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Replays a stream of residency sets (recorded with ResidencyManager::SetTraceFile or generated) against
+// a mock device, fence and budget and reports how much paging each eviction policy causes. The GPU is
+// simulated as retiring each submission a fixed number of submissions after it was executed, a stall
+// is counted every time the residency manager has to wait for the GPU to free up memory.
+
+#include "ResidencyMocks.h"
+
+// The simulator owns the clock so that runs are deterministic
+inline INT64& SimulatedTimestamp()
+{
+	static INT64 Timestamp = 0;
+	return Timestamp;
+}
+
+#define RESIDENCY_PORTABLE_THREADING 1
+#define RESIDENCY_SINGLE_THREADED 1
+#define RESIDENCY_QUERY_TIMESTAMP() SimulatedTimestamp()
+#define RESIDENCY_TIMESTAMP_FREQUENCY() INT64(1000000)
+
+#include "../d3dx12Residency.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace D3DX12Residency;
+using namespace ResidencyMocks;
+
+namespace
+{
+	struct TraceEvent
+	{
+		enum TYPE
+		{
+			OBJECT,
+			RELEASE,
+			BUDGET,
+			EXECUTE,
+			PREFETCH
+		};
+
+		TYPE Type;
+		UINT64 Id;			// Object or queue
+		UINT64 Value0;		// Object size, local budget or time in microseconds
+		UINT64 Value1;		// Non-local budget
+		std::vector<std::vector<UINT64>> Sets;
+
+		static TraceEvent Make(TYPE Type, UINT64 Id, UINT64 Value0, UINT64 Value1 = 0)
+		{
+			TraceEvent Event = {};
+			Event.Type = Type;
+			Event.Id = Id;
+			Event.Value0 = Value0;
+			Event.Value1 = Value1;
+			return Event;
+		}
+	};
+
+	struct SimulationStats : public MockDeviceStats
+	{
+		ResidencyStatistics Manager;
+	};
+
+	bool LoadTrace(const char* pFileName, std::vector<TraceEvent>& Trace)
+	{
+		std::ifstream File(pFileName);
+		if (File.is_open() == false)
+		{
+			return false;
+		}
+
+		std::string Line;
+		while (std::getline(File, Line))
+		{
+			std::istringstream Stream(Line);
+			std::string Command;
+			Stream >> Command;
+
+			TraceEvent Event = {};
+			if (Command == "object")
+			{
+				Event.Type = TraceEvent::OBJECT;
+				Stream >> Event.Id >> Event.Value0;
+			}
+			else if (Command == "release")
+			{
+				Event.Type = TraceEvent::RELEASE;
+				Stream >> Event.Id;
+			}
+			else if (Command == "budget")
+			{
+				Event.Type = TraceEvent::BUDGET;
+				Stream >> Event.Value0 >> Event.Value1;
+			}
+			else if (Command == "execute" || Command == "prefetch")
+			{
+				UINT32 Count = 0;
+				Event.Type = (Command == "execute") ? TraceEvent::EXECUTE : TraceEvent::PREFETCH;
+				Stream >> Event.Id >> Event.Value0 >> Count;
+
+				Event.Sets.resize(Count);
+				for (UINT32 i = 0; i < Count && std::getline(File, Line); i++)
+				{
+					std::istringstream SetStream(Line);
+					UINT32 SetSize = 0;
+					SetStream >> Command >> SetSize;
+					Event.Sets[i].resize(SetSize);
+					for (UINT32 x = 0; x < SetSize; x++)
+					{
+						SetStream >> Event.Sets[i][x];
+					}
+				}
+			}
+			else
+			{
+				// Comments and blank lines
+				continue;
+			}
+
+			Trace.push_back(Event);
+		}
+		return true;
+	}
+
+	// A camera circling through a level: a small set of objects is used every frame, large
+	// textures are streamed in and out as regions come into view and a sprinkling of small objects is used
+	// at random. Part way through the budget shrinks as if another app started using memory. With Prefetch
+	// the regions about to come into view are declared a few frames ahead.
+	void GenerateSyntheticTrace(UINT64 Budget, UINT32 NumFrames, bool Prefetch, std::vector<TraceEvent>& Trace)
+	{
+		const UINT64 MB = 1024 * 1024;
+		const UINT32 NumStatic = 64;
+		const UINT32 NumRegions = 48;
+		const UINT32 NumSmall = 400;
+		const UINT32 RegionWindow = 12;
+		const UINT32 ListsPerFrame = 3;
+		const UINT64 FrameTime = 16667;
+		const UINT32 FramesPerRegion = 4;
+
+		UINT64 NextId = 1;
+		std::vector<UINT64> Static, Regions, Small;
+
+		auto AddObject = [&](std::vector<UINT64>& Group, UINT64 Size)
+		{
+			TraceEvent Event = TraceEvent::Make(TraceEvent::OBJECT, NextId++, Size);
+			Group.push_back(Event.Id);
+			Trace.push_back(Event);
+		};
+
+		for (UINT32 i = 0; i < NumStatic; i++) AddObject(Static, 2 * MB);
+		for (UINT32 i = 0; i < NumRegions; i++) AddObject(Regions, (i % 3 == 0) ? 64 * MB : 16 * MB);
+		for (UINT32 i = 0; i < NumSmall; i++) AddObject(Small, MB / 4);
+
+		UINT32 Seed = 1;
+		auto Random = [&Seed]() { Seed = Seed * 1664525 + 1013904223; return Seed >> 8; };
+
+		UINT64 CurrentBudget = 0;
+		for (UINT32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			const UINT64 FrameBudget = (Frame >= NumFrames / 2 && Frame < NumFrames / 2 + NumFrames / 6) ? Budget * 3 / 4 : Budget;
+			if (FrameBudget != CurrentBudget)
+			{
+				TraceEvent Event = TraceEvent::Make(TraceEvent::BUDGET, 0, FrameBudget);
+				Trace.push_back(Event);
+				CurrentBudget = FrameBudget;
+			}
+
+			// Circle through the regions, a few frames per region
+			const UINT32 FirstRegion = (Frame / FramesPerRegion) % NumRegions;
+
+			if (Prefetch && Frame % FramesPerRegion == 0)
+			{
+				TraceEvent Event = TraceEvent::Make(TraceEvent::PREFETCH, 0, Frame * FrameTime);
+				Event.Sets.resize(1);
+				Event.Sets[0].push_back(Regions[(FirstRegion + RegionWindow) % NumRegions]);
+				Trace.push_back(Event);
+			}
+
+			TraceEvent Event = TraceEvent::Make(TraceEvent::EXECUTE, 1, Frame * FrameTime);
+			Event.Sets.resize(ListsPerFrame);
+			for (UINT32 i = 0; i < NumStatic; i++) Event.Sets[i % ListsPerFrame].push_back(Static[i]);
+			for (UINT32 i = 0; i < RegionWindow; i++) Event.Sets[i % ListsPerFrame].push_back(Regions[(FirstRegion + i) % NumRegions]);
+			for (UINT32 i = 0; i < NumSmall / 10; i++) Event.Sets[i % ListsPerFrame].push_back(Small[Random() % NumSmall]);
+			Trace.push_back(Event);
+		}
+	}
+
+	// A working set of three quarters of the budget which is cycled through every few frames, mixed with a
+	// scan over objects which come back so rarely that they are as good as used once (e.g. a level streamed
+	// past). Between two uses of a working set object more than the budget is touched, so LRU evicts every
+	// working set object just before it is needed again. ARC keeps the working set in T2 and evicts the
+	// scanned objects from T1, so it must page in less. Each frame is two submissions (e.g. a shadow pass
+	// and the main pass) using the same objects, which must not count as a reuse.
+	void GenerateScanTrace(UINT64 Budget, UINT32 NumFrames, std::vector<TraceEvent>& Trace)
+	{
+		const UINT64 ObjectSize = 32 * 1024 * 1024;
+		const UINT32 NumWorkingSet = UINT32(Budget * 3 / 4 / ObjectSize);
+		const UINT32 NumScan = 400;
+		const UINT32 WorkingSetPerFrame = 3;
+		const UINT32 ScanPerFrame = 2;
+		const UINT64 FrameTime = 16667;
+
+		for (UINT32 i = 0; i < NumWorkingSet + NumScan; i++)
+		{
+			TraceEvent Event = TraceEvent::Make(TraceEvent::OBJECT, 1 + i, ObjectSize);
+			Trace.push_back(Event);
+		}
+
+		TraceEvent BudgetEvent = TraceEvent::Make(TraceEvent::BUDGET, 0, Budget);
+		Trace.push_back(BudgetEvent);
+
+		for (UINT32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			TraceEvent Event = TraceEvent::Make(TraceEvent::EXECUTE, 1, Frame * FrameTime);
+			Event.Sets.resize(1);
+			for (UINT32 i = 0; i < WorkingSetPerFrame; i++) Event.Sets[0].push_back(1 + (Frame * WorkingSetPerFrame + i) % NumWorkingSet);
+			for (UINT32 i = 0; i < ScanPerFrame; i++) Event.Sets[0].push_back(1 + NumWorkingSet + (Frame * ScanPerFrame + i) % NumScan);
+			Trace.push_back(Event);
+
+			Event.Value0 += FrameTime / 2;
+			Trace.push_back(Event);
+		}
+	}
+
+	void Simulate(const std::vector<TraceEvent>& Trace, EVICTION_POLICY Policy, UINT32 GpuLatency, UINT32 MaxLatency, bool Predict, SimulationStats& Stats)
+	{
+		MockGpu Gpu(GpuLatency, &Stats);
+		MockDevice Device(&Gpu);
+		MockAdapter Adapter(&Device);
+		std::map<UINT64, MockCommandQueue*> Queues;
+		std::map<UINT64, std::pair<ManagedObject*, MockPageable*>> Objects;
+		std::vector<ResidencySet*> Sets;
+		std::vector<MockCommandList> CommandLists;
+
+		SimulatedTimestamp() = 0;
+
+		ResidencyManager* pManager = new ResidencyManager();
+		pManager->Initialize(&Device, 0, &Adapter, MaxLatency, Policy);
+		pManager->SetPredictivePrefetch(Predict);
+
+		for (const TraceEvent& Event : Trace)
+		{
+			switch (Event.Type)
+			{
+			case TraceEvent::OBJECT:
+			{
+				MockPageable* pPageable = new MockPageable(Event.Value0);
+				ManagedObject* pObject = new ManagedObject();
+				pObject->Initialize(pPageable, Event.Value0);
+
+				Device.CurrentUsage += Event.Value0;
+				pManager->BeginTrackingObject(pObject);
+				Objects[Event.Id] = std::make_pair(pObject, pPageable);
+				break;
+			}
+			case TraceEvent::RELEASE:
+			{
+				auto it = Objects.find(Event.Id);
+				if (it != Objects.end())
+				{
+					pManager->EndTrackingObject(it->second.first);
+					if (it->second.second->Resident)
+					{
+						Device.CurrentUsage -= it->second.second->Size;
+					}
+					delete it->second.first;
+					delete it->second.second;
+					Objects.erase(it);
+				}
+				break;
+			}
+			case TraceEvent::BUDGET:
+				Adapter.LocalBudget = Event.Value0;
+				Adapter.NonLocalBudget = Event.Value1;
+				break;
+			case TraceEvent::EXECUTE:
+			case TraceEvent::PREFETCH:
+			{
+				SimulatedTimestamp() = INT64(Event.Value0);
+
+				const UINT32 Count = UINT32(Event.Sets.size());
+				while (Sets.size() < Count)
+				{
+					Sets.push_back(pManager->CreateResidencySet());
+				}
+				CommandLists.resize(RESIDENCY_MAX(CommandLists.size(), Count));
+
+				std::vector<ID3D12CommandList*> ppCommandLists(Count);
+				for (UINT32 i = 0; i < Count; i++)
+				{
+					Sets[i]->Open();
+					for (UINT64 Id : Event.Sets[i])
+					{
+						auto it = Objects.find(Id);
+						if (it != Objects.end())
+						{
+							Sets[i]->Insert(it->second.first);
+						}
+					}
+					Sets[i]->Close();
+					ppCommandLists[i] = &CommandLists[i];
+				}
+
+				if (Event.Type == TraceEvent::PREFETCH)
+				{
+					pManager->Prefetch(Sets.data(), Count);
+					break;
+				}
+
+				MockCommandQueue*& pQueue = Queues[Event.Id];
+				if (pQueue == nullptr)
+				{
+					pQueue = new MockCommandQueue(&Gpu);
+				}
+
+				pManager->ExecuteCommandLists(pQueue, ppCommandLists.data(), Sets.data(), Count);
+				Gpu.Retire();
+				break;
+			}
+			}
+		}
+
+		pManager->GetStatistics(&Stats.Manager);
+
+		for (ResidencySet* pSet : Sets)
+		{
+			pManager->DestroyResidencySet(pSet);
+		}
+		for (auto& Object : Objects)
+		{
+			pManager->EndTrackingObject(Object.second.first);
+			delete Object.second.first;
+			delete Object.second.second;
+		}
+		pManager->Destroy();
+		delete pManager;
+
+		for (auto& Queue : Queues)
+		{
+			delete Queue.second;
+		}
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: ResidencySimulator [-trace <file>] [-scan] [-budget <MB>] [-frames <count>] [-gpulatency <submissions>] [-maxlatency <count>] [-prefetch] [-predict]\n");
+		printf("  Without -trace a synthetic streaming workload is generated using -budget and -frames, -prefetch adds prefetch requests to it.\n");
+		printf("  -scan generates a working set mixed with one shot objects instead, ARC must page in less than LRU on it.\n");
+		printf("  -predict enables the manager's predictive prefetching.\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* pTraceFile = nullptr;
+	UINT64 BudgetMB = 1024;
+	UINT32 NumFrames = 3000;
+	UINT32 GpuLatency = 3;
+	UINT32 MaxLatency = 6;
+	bool Prefetch = false;
+	bool Predict = false;
+	bool Scan = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string Arg = argv[i];
+		if (i + 1 < argc && Arg == "-trace") pTraceFile = argv[++i];
+		else if (i + 1 < argc && Arg == "-budget") BudgetMB = strtoull(argv[++i], nullptr, 10);
+		else if (i + 1 < argc && Arg == "-frames") NumFrames = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-gpulatency") GpuLatency = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-maxlatency") MaxLatency = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (Arg == "-prefetch") Prefetch = true;
+		else if (Arg == "-predict") Predict = true;
+		else if (Arg == "-scan") Scan = true;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	std::vector<TraceEvent> Trace;
+	if (pTraceFile)
+	{
+		if (LoadTrace(pTraceFile, Trace) == false)
+		{
+			printf("Failed to open trace %s\n", pTraceFile);
+			return 1;
+		}
+	}
+	else if (Scan)
+	{
+		GenerateScanTrace(BudgetMB * 1024 * 1024, NumFrames, Trace);
+	}
+	else
+	{
+		GenerateSyntheticTrace(BudgetMB * 1024 * 1024, NumFrames, Prefetch, Trace);
+	}
+
+	const struct
+	{
+		EVICTION_POLICY Policy;
+		const char* pName;
+	} Policies[] =
+	{
+		{ EVICTION_POLICY::LRU, "LRU" },
+		{ EVICTION_POLICY::CLOCK_PRO, "CLOCK-Pro" },
+		{ EVICTION_POLICY::ARC, "ARC" },
+		{ EVICTION_POLICY::LRU_K, "LRU-K" },
+	};
+
+	printf("%-10s %12s %12s %8s %8s %8s %8s %6s %9s %10s %9s %9s %9s\n",
+		"Policy", "Paged in MB", "Evicted MB", "MakeRes", "Evicts", "Stalls", "Stalled", "Late", "Peak MB",
+		"Late subs", "Late MB", "Prefetch", "Avoided");
+
+	UINT64 BytesMadeResident[ARRAYSIZE(Policies)];
+	for (UINT32 i = 0; i < ARRAYSIZE(Policies); i++)
+	{
+		SimulationStats Stats;
+		Simulate(Trace, Policies[i].Policy, GpuLatency, MaxLatency, Predict, Stats);
+		BytesMadeResident[i] = Stats.BytesMadeResident;
+
+		printf("%-10s %12.1f %12.1f %8llu %8llu %8llu %8llu %6llu %9.1f %10llu %9.1f %9.1f %9llu\n",
+			Policies[i].pName,
+			Stats.BytesMadeResident / (1024.0 * 1024.0),
+			Stats.BytesEvicted / (1024.0 * 1024.0),
+			Stats.MakeResidentCalls,
+			Stats.EvictCalls,
+			Stats.Stalls,
+			Stats.StalledSubmissions,
+			Stats.LateResidency,
+			Stats.PeakUsage / (1024.0 * 1024.0),
+			Stats.Manager.LateSubmissions,
+			Stats.Manager.LateBytes / (1024.0 * 1024.0),
+			Stats.Manager.PrefetchedBytes / (1024.0 * 1024.0),
+			Stats.Manager.StallsAvoided);
+	}
+
+	// Keeping one shot objects out of the way of the working set is what ARC is for
+	if (Scan && pTraceFile == nullptr && BytesMadeResident[2] >= BytesMadeResident[0])
+	{
+		printf("ARC paged in as much as LRU on the scan workload\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// The subset of Win32, D3D12 and DXGI declarations used by d3dx12Residency.h so that the residency
+// manager can be driven by mock devices without Windows or a GPU. Threads, events and timing come from
+// the standard library by building the manager with RESIDENCY_PORTABLE_THREADING. The D3D interfaces
+// are plain abstract classes, ResidencyMocks.h provides the implementations.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+typedef unsigned char BYTE;
+typedef int BOOL;
+typedef int32_t INT32;
+typedef uint32_t UINT32;
+typedef unsigned int UINT;
+typedef unsigned long ULONG;
+typedef uint32_t DWORD;
+typedef long long INT64;
+typedef unsigned long long UINT64;
+typedef size_t SIZE_T;
+typedef int32_t HRESULT;
+typedef void* HANDLE;
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define FORCEINLINE inline
+#define MAXUINT64 (~UINT64(0))
+
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define ZeroMemory(p, size) memset((p), 0, (size))
+#define CONTAINING_RECORD(address, type, field) ((type*)((char*)(address) - offsetof(type, field)))
+
+struct LIST_ENTRY
+{
+	LIST_ENTRY* Flink;
+	LIST_ENTRY* Blink;
+};
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+
+typedef const GUID& REFGUID;
+typedef const GUID& REFIID;
+
+#define IID_PPV_ARGS(ppType) GUID(), reinterpret_cast<void**>(ppType)
+
+inline void DebugBreak() {}
+
+enum D3D12_FENCE_FLAGS
+{
+	D3D12_FENCE_FLAG_NONE = 0
+};
+
+enum DXGI_MEMORY_SEGMENT_GROUP
+{
+	DXGI_MEMORY_SEGMENT_GROUP_LOCAL = 0,
+	DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL = 1
+};
+
+struct DXGI_QUERY_VIDEO_MEMORY_INFO
+{
+	UINT64 Budget;
+	UINT64 CurrentUsage;
+	UINT64 AvailableForReservation;
+	UINT64 CurrentReservation;
+};
+
+struct ID3D12Pageable
+{
+	virtual ~ID3D12Pageable() {}
+	virtual ULONG Release() { delete this; return 0; }
+};
+
+struct ID3D12Fence : public ID3D12Pageable
+{
+	virtual UINT64 GetCompletedValue() = 0;
+	virtual HRESULT SetEventOnCompletion(UINT64 Value, HANDLE Event) = 0;
+	virtual HRESULT Signal(UINT64 Value) = 0;
+};
+
+struct ID3D12CommandList
+{
+	virtual ~ID3D12CommandList() {}
+};
+
+struct ID3D12CommandQueue
+{
+	virtual ~ID3D12CommandQueue() {}
+	virtual HRESULT Wait(ID3D12Fence* pFence, UINT64 Value) = 0;
+	virtual HRESULT Signal(ID3D12Fence* pFence, UINT64 Value) = 0;
+	virtual void ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists) = 0;
+	virtual HRESULT GetPrivateData(REFGUID Guid, UINT* pDataSize, void* pData) = 0;
+	virtual HRESULT SetPrivateData(REFGUID Guid, UINT DataSize, const void* pData) = 0;
+};
+
+struct ID3D12Device
+{
+	virtual ~ID3D12Device() {}
+	virtual HRESULT CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID Riid, void** ppFence) = 0;
+	virtual HRESULT MakeResident(UINT NumObjects, ID3D12Pageable* const* ppObjects) = 0;
+	virtual HRESULT Evict(UINT NumObjects, ID3D12Pageable* const* ppObjects) = 0;
+};
+
+struct IDXGIAdapter3
+{
+	virtual ~IDXGIAdapter3() {}
+	virtual HRESULT QueryVideoMemoryInfo(UINT NodeIndex, DXGI_MEMORY_SEGMENT_GROUP SegmentGroup, DXGI_QUERY_VIDEO_MEMORY_INFO* pVideoMemoryInfo) = 0;
+};
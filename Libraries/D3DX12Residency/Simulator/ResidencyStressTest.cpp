@@ -0,0 +1,288 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Loads the residency manager from several threads at once, each submitting to its own queue, against a
+// mock GPU which executes work in real time while another thread keeps moving the budget around. Reports
+// the number of ExecuteCommandLists calls per second and the distribution of the time each call took.
+
+#include "ResidencyMocks.h"
+
+#define RESIDENCY_PORTABLE_THREADING 1
+
+#include "../d3dx12Residency.h"
+
+#include <cstdlib>
+#include <random>
+
+using namespace D3DX12Residency;
+using namespace ResidencyMocks;
+
+namespace
+{
+	struct StressOptions
+	{
+		UINT32 NumThreads;
+		UINT32 Seconds;
+		UINT32 NumObjects;
+		UINT64 BudgetMB;
+		UINT32 ObjectsPerSet;
+		UINT32 SetsPerSubmission;
+		UINT32 GpuMicroseconds;
+		UINT32 PagingMicrosecondsPerMB;
+		UINT32 MaxLatency;
+	};
+
+	struct ThreadResult
+	{
+		std::vector<UINT32> LatenciesUs;
+		UINT64 Failures;
+	};
+
+	// Each thread works on a window of objects which slides through the whole set, with some shared objects used by everyone
+	void SubmitThread(ResidencyManager* pManager, MockGpu* pGpu, const std::vector<ManagedObject*>* pObjects,
+		const StressOptions* pOptions, UINT32 ThreadIndex, const std::atomic<bool>* pStop, ThreadResult* pResult)
+	{
+		MockCommandQueue Queue(pGpu);
+		std::vector<MockCommandList> CommandLists(pOptions->SetsPerSubmission);
+		std::vector<ID3D12CommandList*> ppCommandLists(pOptions->SetsPerSubmission);
+		std::vector<ResidencySet*> Sets(pOptions->SetsPerSubmission);
+		for (UINT32 i = 0; i < pOptions->SetsPerSubmission; i++)
+		{
+			Sets[i] = pManager->CreateResidencySet();
+			ppCommandLists[i] = &CommandLists[i];
+		}
+
+		const UINT32 NumObjects = UINT32(pObjects->size());
+		const UINT32 NumShared = NumObjects / 20;
+		const UINT32 Window = RESIDENCY_MAX(pOptions->ObjectsPerSet * 2, 1u);
+
+		std::mt19937 Random(ThreadIndex + 1);
+		UINT32 WindowStart = (NumObjects / pOptions->NumThreads) * ThreadIndex;
+
+		while (pStop->load(std::memory_order_relaxed) == false)
+		{
+			for (ResidencySet* pSet : Sets)
+			{
+				pSet->Open();
+				for (UINT32 i = 0; i < pOptions->ObjectsPerSet; i++)
+				{
+					const UINT32 Index = (i % 4 == 0) ? Random() % NumShared : NumShared + (WindowStart + Random() % Window) % (NumObjects - NumShared);
+					pSet->Insert((*pObjects)[Index]);
+				}
+				pSet->Close();
+			}
+			WindowStart += Random() % 4;
+
+			const auto Start = std::chrono::steady_clock::now();
+			const HRESULT hr = pManager->ExecuteCommandLists(&Queue, ppCommandLists.data(), Sets.data(), pOptions->SetsPerSubmission);
+			const auto End = std::chrono::steady_clock::now();
+
+			pResult->LatenciesUs.push_back(UINT32(std::chrono::duration_cast<std::chrono::microseconds>(End - Start).count()));
+			if (FAILED(hr))
+			{
+				pResult->Failures++;
+			}
+		}
+
+		for (ResidencySet* pSet : Sets)
+		{
+			pManager->DestroyResidencySet(pSet);
+		}
+	}
+
+	// Another process is competing for memory, the budget wanders between half and all of what was requested
+	void BudgetThread(MockAdapter* pAdapter, UINT64 Budget, const std::atomic<bool>* pStop)
+	{
+		std::mt19937 Random(1234);
+		while (pStop->load(std::memory_order_relaxed) == false)
+		{
+			pAdapter->LocalBudget = Budget / 2 + (Budget / 2) * (Random() % 101) / 100;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+	}
+
+	UINT32 Percentile(const std::vector<UINT32>& Sorted, double Fraction)
+	{
+		if (Sorted.empty())
+		{
+			return 0;
+		}
+		return Sorted[std::min(Sorted.size() - 1, size_t(Sorted.size() * Fraction))];
+	}
+
+	void RunStress(EVICTION_POLICY Policy, const char* pName, const StressOptions& Options)
+	{
+		MockDeviceStats DeviceStats;
+		MockGpu Gpu(0, &DeviceStats);
+		MockDevice Device(&Gpu);
+		MockAdapter Adapter(&Device);
+		Device.PagingMicrosecondsPerMB = Options.PagingMicrosecondsPerMB;
+		Adapter.LocalBudget = Options.BudgetMB * 1024 * 1024;
+
+		Gpu.StartTimeline(Options.GpuMicroseconds);
+
+		ResidencyManager* pManager = new ResidencyManager();
+		pManager->Initialize(&Device, 0, &Adapter, Options.MaxLatency, Policy);
+
+		// Between 64KB and 8MB, skewed towards small objects, all starting out resident
+		std::mt19937 Random(42);
+		std::vector<MockPageable*> Pageables(Options.NumObjects);
+		std::vector<ManagedObject*> Objects(Options.NumObjects);
+		for (UINT32 i = 0; i < Options.NumObjects; i++)
+		{
+			const UINT64 Size = UINT64(64 * 1024) << (Random() % 8) >> (Random() % 4 == 0 ? 0 : 3);
+			Pageables[i] = new MockPageable(Size);
+			Objects[i] = new ManagedObject();
+			Objects[i]->Initialize(Pageables[i], Size);
+			Device.CurrentUsage += Size;
+			pManager->BeginTrackingObject(Objects[i]);
+		}
+
+		std::atomic<bool> Stop(false);
+		std::vector<ThreadResult> Results(Options.NumThreads);
+		std::vector<std::thread> Threads;
+		for (UINT32 i = 0; i < Options.NumThreads; i++)
+		{
+			Results[i].Failures = 0;
+			Threads.push_back(std::thread(SubmitThread, pManager, &Gpu, &Objects, &Options, i, &Stop, &Results[i]));
+		}
+		std::thread Budget(BudgetThread, &Adapter, Options.BudgetMB * 1024 * 1024, &Stop);
+
+		const auto Start = std::chrono::steady_clock::now();
+		std::this_thread::sleep_for(std::chrono::seconds(Options.Seconds));
+		Stop = true;
+
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+		Budget.join();
+		const double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+		// The manager releases the queue fences when it is destroyed, the GPU must be done with them first
+		Gpu.WaitForIdle();
+
+		ResidencyStatistics ManagerStats;
+		pManager->GetStatistics(&ManagerStats);
+
+		for (ManagedObject* pObject : Objects)
+		{
+			pManager->EndTrackingObject(pObject);
+			delete pObject;
+		}
+		pManager->Destroy();
+		delete pManager;
+		Gpu.StopTimeline();
+
+		for (MockPageable* pPageable : Pageables)
+		{
+			delete pPageable;
+		}
+
+		std::vector<UINT32> Latencies;
+		UINT64 Failures = 0;
+		for (ThreadResult& Result : Results)
+		{
+			Latencies.insert(Latencies.end(), Result.LatenciesUs.begin(), Result.LatenciesUs.end());
+			Failures += Result.Failures;
+		}
+		std::sort(Latencies.begin(), Latencies.end());
+
+		printf("%-10s %10.0f %8u %8u %8u %8u %8u %10.1f %8llu %8llu %9llu %7llu\n",
+			pName,
+			Latencies.size() / Elapsed,
+			Percentile(Latencies, 0.5),
+			Percentile(Latencies, 0.9),
+			Percentile(Latencies, 0.99),
+			Percentile(Latencies, 0.999),
+			Latencies.empty() ? 0 : Latencies.back(),
+			DeviceStats.BytesMadeResident / (1024.0 * 1024.0),
+			DeviceStats.Stalls,
+			DeviceStats.LateResidency,
+			ManagerStats.LateSubmissions,
+			Failures);
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: ResidencyStressTest [-policy lru|clockpro|arc|lruk] [-threads <count>] [-seconds <count>] [-objects <count>]\n");
+		printf("                           [-budget <MB>] [-setsize <objects>] [-sets <count>] [-gpuus <microseconds>]\n");
+		printf("                           [-pagingus <microseconds per MB>] [-maxlatency <count>]\n");
+		printf("  Without -policy every eviction policy is run in turn. Latencies are the time spent in ExecuteCommandLists.\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	StressOptions Options;
+	Options.NumThreads = 4;
+	Options.Seconds = 3;
+	Options.NumObjects = 4000;
+	Options.BudgetMB = 1024;
+	Options.ObjectsPerSet = 64;
+	Options.SetsPerSubmission = 2;
+	Options.GpuMicroseconds = 100;
+	Options.PagingMicrosecondsPerMB = 20;
+	Options.MaxLatency = 6;
+
+	const struct
+	{
+		EVICTION_POLICY Policy;
+		const char* pOption;
+		const char* pName;
+	} Policies[] =
+	{
+		{ EVICTION_POLICY::LRU, "lru", "LRU" },
+		{ EVICTION_POLICY::CLOCK_PRO, "clockpro", "CLOCK-Pro" },
+		{ EVICTION_POLICY::ARC, "arc", "ARC" },
+		{ EVICTION_POLICY::LRU_K, "lruk", "LRU-K" },
+	};
+	const char* pPolicy = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string Arg = argv[i];
+		if (i + 1 < argc && Arg == "-policy") pPolicy = argv[++i];
+		else if (i + 1 < argc && Arg == "-threads") Options.NumThreads = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-seconds") Options.Seconds = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-objects") Options.NumObjects = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-budget") Options.BudgetMB = strtoull(argv[++i], nullptr, 10);
+		else if (i + 1 < argc && Arg == "-setsize") Options.ObjectsPerSet = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-sets") Options.SetsPerSubmission = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-gpuus") Options.GpuMicroseconds = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-pagingus") Options.PagingMicrosecondsPerMB = UINT32(strtoul(argv[++i], nullptr, 10));
+		else if (i + 1 < argc && Arg == "-maxlatency") Options.MaxLatency = UINT32(strtoul(argv[++i], nullptr, 10));
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (Options.NumThreads == 0 || Options.NumObjects < 40 || Options.SetsPerSubmission == 0 || Options.MaxLatency == 0)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	printf("%-10s %10s %8s %8s %8s %8s %8s %10s %8s %8s %9s %7s\n",
+		"Policy", "Submits/s", "p50 us", "p90 us", "p99 us", "p99.9 us", "Max us", "Paged MB", "Stalls", "Late", "Late subs", "Failed");
+
+	for (UINT32 i = 0; i < ARRAYSIZE(Policies); i++)
+	{
+		if (pPolicy == nullptr || strcmp(pPolicy, Policies[i].pOption) == 0)
+		{
+			RunStress(Policies[i].Policy, Policies[i].pName, Options);
+		}
+	}
+
+	return 0;
+}
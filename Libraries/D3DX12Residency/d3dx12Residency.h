@@ -11,6 +11,31 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <new>
+
+// Set to 1 to use the C++ standard library for threads, events, locks and timing instead of Win32.
+// The D3D12 and DXGI declarations still have to be provided by the app.
+#ifndef RESIDENCY_PORTABLE_THREADING
+#define RESIDENCY_PORTABLE_THREADING 0
+#endif
+
+#if RESIDENCY_PORTABLE_THREADING
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Apps that drive time themselves (e.g. a simulator) can define both of these before including this file
+#ifndef RESIDENCY_QUERY_TIMESTAMP
+#define RESIDENCY_QUERY_TIMESTAMP() INT64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#define RESIDENCY_TIMESTAMP_FREQUENCY() INT64(1000000000)
+#endif
+#endif
+
 namespace D3DX12Residency
 {
 #if 0
@@ -24,7 +49,9 @@ namespace D3DX12Residency
 #define RESIDENCY_CHECK_RESULT(x) x
 #endif
 
+#ifndef RESIDENCY_SINGLE_THREADED
 #define RESIDENCY_SINGLE_THREADED 0
+#endif
 
 #define RESIDENCY_MIN(x,y) ((x) < (y) ? (x) : (y))
 #define RESIDENCY_MAX(x,y) ((x) > (y) ? (x) : (y))
@@ -32,12 +59,25 @@ namespace D3DX12Residency
 	// This size can be tuned to your app in order to save space
 #define MAX_NUM_CONCURRENT_CMD_LISTS 32
 
+	// Number of past references remembered per object for the LRU-K eviction policy
+#define RESIDENCY_LRU_K 2
+
 	namespace Internal
 	{
 		class CriticalSection
 		{
 			friend class ScopedLock;
 		public:
+#if RESIDENCY_PORTABLE_THREADING
+			CriticalSection() {}
+			~CriticalSection() {}
+
+		private:
+			void Enter() { CS.lock(); }
+			void Leave() { CS.unlock(); }
+
+			std::recursive_mutex CS;
+#else
 			CriticalSection()
 			{
 				InitializeCriticalSectionAndSpinCount(&CS, 8);
@@ -49,7 +89,11 @@ namespace D3DX12Residency
 			}
 
 		private:
+			void Enter() { EnterCriticalSection(&CS); }
+			void Leave() { LeaveCriticalSection(&CS); }
+
 			CRITICAL_SECTION CS;
+#endif
 		};
 
 		class ScopedLock
@@ -61,7 +105,7 @@ namespace D3DX12Residency
 			{
 				if (pCS)
 				{
-					EnterCriticalSection(&pCS->CS);
+					pCS->Enter();
 				}
 			};
 
@@ -69,7 +113,7 @@ namespace D3DX12Residency
 			{
 				if (pCS)
 				{
-					LeaveCriticalSection(&pCS->CS);
+					pCS->Leave();
 				}
 			}
 
@@ -78,6 +122,242 @@ namespace D3DX12Residency
 			CriticalSection* pCS;
 		};
 
+		// An auto or manual reset event
+		class Event
+		{
+		public:
+#if RESIDENCY_PORTABLE_THREADING
+			Event() : ManualReset(false), Signaled(false) {}
+
+			HRESULT Initialize(bool ManualResetIn)
+			{
+				ManualReset = ManualResetIn;
+				Signaled = false;
+				return S_OK;
+			}
+
+			void Destroy() {}
+
+			HRESULT Set()
+			{
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					Signaled = true;
+				}
+				Condition.notify_all();
+				return S_OK;
+			}
+
+			HRESULT Reset()
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Signaled = false;
+				return S_OK;
+			}
+
+			void Wait()
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				Condition.wait(Lock, [this] { return Signaled; });
+				if (ManualReset == false)
+				{
+					Signaled = false;
+				}
+			}
+
+		private:
+			std::mutex Mutex;
+			std::condition_variable Condition;
+			bool ManualReset;
+			bool Signaled;
+#else
+			Event() : Handle(nullptr) {}
+
+			HRESULT Initialize(bool ManualReset)
+			{
+				Handle = CreateEvent(nullptr, ManualReset, false, nullptr);
+				return (Handle == nullptr) ? HRESULT_FROM_WIN32(GetLastError()) : S_OK;
+			}
+
+			void Destroy()
+			{
+				if (Handle != nullptr)
+				{
+					CloseHandle(Handle);
+					Handle = nullptr;
+				}
+			}
+
+			HRESULT Set()
+			{
+				return SetEvent(Handle) ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+			}
+
+			HRESULT Reset()
+			{
+				return ResetEvent(Handle) ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+			}
+
+			void Wait()
+			{
+				WaitForSingleObject(Handle, INFINITE);
+			}
+
+			HANDLE GetHandle() { return Handle; }
+
+		private:
+			HANDLE Handle;
+#endif
+		};
+
+		class Thread
+		{
+		public:
+			typedef void(*ThreadProc)(void* pData);
+
+#if RESIDENCY_PORTABLE_THREADING
+			HRESULT Start(ThreadProc Proc, void* pData)
+			{
+				try
+				{
+					Worker = std::thread(Proc, pData);
+				}
+				catch (...)
+				{
+					return E_FAIL;
+				}
+				return S_OK;
+			}
+
+			void Join()
+			{
+				if (Worker.joinable())
+				{
+					Worker.join();
+				}
+			}
+
+		private:
+			std::thread Worker;
+#else
+			Thread() : Handle(nullptr), Proc(nullptr), pData(nullptr) {}
+
+			HRESULT Start(ThreadProc ProcIn, void* pDataIn)
+			{
+				Proc = ProcIn;
+				pData = pDataIn;
+				Handle = CreateThread(NULL, 0, ThreadStart, (void*) this, 0, nullptr);
+				return (Handle == nullptr) ? HRESULT_FROM_WIN32(GetLastError()) : S_OK;
+			}
+
+			void Join()
+			{
+				if (Handle != nullptr)
+				{
+					WaitForSingleObject(Handle, INFINITE);
+					CloseHandle(Handle);
+					Handle = nullptr;
+				}
+			}
+
+		private:
+			static unsigned long WINAPI ThreadStart(void* pThread)
+			{
+				Thread* pThis = (Thread*)pThread;
+				pThis->Proc(pThis->pData);
+				return 0;
+			}
+
+			HANDLE Handle;
+			ThreadProc Proc;
+			void* pData;
+#endif
+		};
+
+		inline INT64 QueryTimestamp()
+		{
+#if RESIDENCY_PORTABLE_THREADING
+			return RESIDENCY_QUERY_TIMESTAMP();
+#else
+			LARGE_INTEGER Time;
+			QueryPerformanceCounter(&Time);
+			return Time.QuadPart;
+#endif
+		}
+
+		inline INT64 QueryTimestampFrequency()
+		{
+#if RESIDENCY_PORTABLE_THREADING
+			return RESIDENCY_TIMESTAMP_FREQUENCY();
+#else
+			LARGE_INTEGER Frequency;
+			QueryPerformanceFrequency(&Frequency);
+			return Frequency.QuadPart;
+#endif
+		}
+
+		// Lock free ring buffer which is safe with exactly one producer thread and one consumer thread
+		template<typename T>
+		class SPSCQueue
+		{
+		public:
+			SPSCQueue() : pItems(nullptr), Capacity(0), Head(0), Tail(0) {}
+
+			~SPSCQueue()
+			{
+				delete[](pItems);
+			}
+
+			HRESULT Initialize(SIZE_T CapacityIn)
+			{
+				Capacity = CapacityIn;
+				pItems = new T[Capacity];
+				return (pItems == nullptr) ? E_OUTOFMEMORY : S_OK;
+			}
+
+			// Only called by the producer
+			bool TryPush(const T& Item)
+			{
+				const SIZE_T CurrentTail = Tail.load(std::memory_order_relaxed);
+				if (CurrentTail - Head.load(std::memory_order_acquire) >= Capacity)
+				{
+					return false;
+				}
+
+				pItems[CurrentTail % Capacity] = Item;
+				Tail.store(CurrentTail + 1, std::memory_order_release);
+				return true;
+			}
+
+			// Only called by the consumer
+			bool TryPop(T& Item)
+			{
+				const SIZE_T CurrentHead = Head.load(std::memory_order_relaxed);
+				if (CurrentHead == Tail.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+
+				Item = pItems[CurrentHead % Capacity];
+				Head.store(CurrentHead + 1, std::memory_order_release);
+				return true;
+			}
+
+			bool IsFull() const
+			{
+				return Tail.load(std::memory_order_acquire) - Head.load(std::memory_order_acquire) >= Capacity;
+			}
+
+		private:
+			T* pItems;
+			SIZE_T Capacity;
+
+			// Keep the consumer and producer indices on different cache lines
+			std::atomic<SIZE_T> Head;
+			BYTE HeadPadding[64 - sizeof(std::atomic<SIZE_T>)];
+			std::atomic<SIZE_T> Tail;
+		};
+
 		// One per Residency Manager
 		class SyncManager
 		{
@@ -117,9 +397,14 @@ namespace D3DX12Residency
 			Size(0),
 			ResidencyStatus(RESIDENCY_STATUS::RESIDENT),
 			LastGPUSyncPoint(0),
-			LastUsedTimestamp(0)
+			LastUsedTimestamp(0),
+			ReuseInterval(0),
+			Prefetched(false),
+			PolicyListIndex(0),
+			PolicyReferenced(false)
 		{
 			memset(CommandListsUsedOn, 0, sizeof(CommandListsUsedOn));
+			memset(ReferenceHistory, 0, sizeof(ReferenceHistory));
 		}
 
 		void Initialize(ID3D12Pageable* pUnderlyingIn, UINT64 ObjectSize)
@@ -142,11 +427,49 @@ namespace D3DX12Residency
 		UINT64 LastGPUSyncPoint;
 		UINT64 LastUsedTimestamp;
 
+		// Number of sync points between the last two uses, used to predict the next one
+		UINT64 ReuseInterval;
+		// Made resident ahead of time and not used by the GPU since
+		bool Prefetched;
+
 		// This is used to track which open command lists this resource is currently used on.
 		bool CommandListsUsedOn[MAX_NUM_CONCURRENT_CMD_LISTS];
 
 		// Linked list entry
 		LIST_ENTRY ListEntry;
+
+		// State owned by the eviction policy tracking this object
+		LIST_ENTRY PolicyListEntry;
+		UINT32 PolicyListIndex;
+		bool PolicyReferenced;
+		UINT64 ReferenceHistory[RESIDENCY_LRU_K];
+	};
+
+	// Counters describing how well paging is kept off the GPU's critical path
+	struct ResidencyStatistics
+	{
+		ResidencyStatistics()
+		{
+			memset(this, 0, sizeof(*this));
+		}
+
+		// Submissions executed and how many of them had to wait for objects to be made resident
+		UINT64 Submissions;
+		UINT64 LateSubmissions;
+
+		// Objects which were evicted when a submission needed them
+		UINT64 LateObjects;
+		UINT64 LateBytes;
+
+		// Objects made resident ahead of time, either requested by the app or predicted
+		UINT64 PrefetchedObjects;
+		UINT64 PrefetchedBytes;
+
+		// Prefetched objects which were resident when the GPU needed them
+		UINT64 StallsAvoided;
+
+		// Prefetched objects which were evicted again before being used
+		UINT64 PrefetchesWasted;
 	};
 
 	// This represents a set of objects which are referenced by a command list i.e. every time a resource
@@ -434,10 +757,15 @@ namespace D3DX12Residency
 
 			inline bool IsCompleted() { return LastUsedValue <= pFence->pFence->GetCompletedValue(); }
 
-			inline void WaitForCompletion(HANDLE Event)
+			inline void WaitForCompletion(Event* pEvent)
 			{
-				RESIDENCY_CHECK_RESULT(pFence->pFence->SetEventOnCompletion(LastUsedValue, Event));
-				RESIDENCY_CHECK_RESULT(WaitForSingleObject(Event, INFINITE));
+#if RESIDENCY_PORTABLE_THREADING
+				// Without an event the call blocks until the fence reaches the value
+				RESIDENCY_CHECK_RESULT(pFence->pFence->SetEventOnCompletion(LastUsedValue, nullptr));
+#else
+				RESIDENCY_CHECK_RESULT(pFence->pFence->SetEventOnCompletion(LastUsedValue, pEvent->GetHandle()));
+				pEvent->Wait();
+#endif
 			}
 
 			Fence* pFence;
@@ -477,13 +805,13 @@ namespace D3DX12Residency
 				return true;
 			}
 
-			inline void WaitForCompletion(HANDLE Event)
+			inline void WaitForCompletion(Event* pEvent)
 			{
 				for (UINT32 i = 0; i < NumQueueSyncPoints; i++)
 				{
 					if (pQueueSyncPoints[i].IsCompleted() == false)
 					{
-						pQueueSyncPoints[i].WaitForCompletion(Event);
+						pQueueSyncPoints[i].WaitForCompletion(pEvent);
 					}
 				}
 			}
@@ -495,291 +823,940 @@ namespace D3DX12Residency
 			QueueSyncPoint pQueueSyncPoints[1];
 		};
 
-		// A Least Recently Used Cache. Tracks all of the objects requested by the app so that objects
-		// that aren't used freqently can get evicted to help the app stay under buget.
-		class LRUCache
-		{
-		public:
-			LRUCache() :
-				NumResidentObjects(0),
-				NumEvictedObjects(0),
-				ResidentSize(0)
-			{
-				InitializeListHead(&ResidentObjectListHead);
-				InitializeListHead(&EvictedObjectListHead);
-			};
+	}
 
-			void Insert(ManagedObject* pObject)
-			{
-				if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
-				{
-					InsertHeadList(&ResidentObjectListHead, &pObject->ListEntry);
-					NumResidentObjects++;
-					ResidentSize += pObject->Size;
-				}
-				else
-				{
-					InsertHeadList(&EvictedObjectListHead, &pObject->ListEntry);
-					NumEvictedObjects++;
-				}
-			}
+	enum class EVICTION_POLICY
+	{
+		LRU,
+		CLOCK_PRO,
+		ARC,
+		LRU_K
+	};
 
-			void Remove(ManagedObject* pObject)
-			{
-				RemoveEntryList(&pObject->ListEntry);
-				if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
-				{
-					NumResidentObjects--;
-					ResidentSize -= pObject->Size;
-				}
-				else
-				{
-					NumEvictedObjects--;
-				}
-			}
+	// Tracks all of the objects requested by the app so that objects that aren't used freqently can get
+	// evicted to help the app stay under buget. Every resident object is kept in a list ordered by when it
+	// was last used, which drives the time based trimming. Derived policies decide which objects to evict
+	// when the app is over budget.
+	class EvictionPolicy
+	{
+	public:
+		EvictionPolicy() :
+			NumResidentObjects(0),
+			NumEvictedObjects(0),
+			ResidentSize(0),
+			CacheSize(0),
+			TicksPerSecond(1)
+		{
+			Internal::InitializeListHead(&ResidentObjectListHead);
+			Internal::InitializeListHead(&EvictedObjectListHead);
+		};
 
-			// When an object is used by the GPU we move it to the end of the list.
-			// This way things closer to the head of the list are the objects which
-			// are stale and better candidates for eviction
-			void ObjectReferenced(ManagedObject* pObject)
-			{
-				RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
+		virtual ~EvictionPolicy() {}
 
-				RemoveEntryList(&pObject->ListEntry);
-				InsertTailList(&ResidentObjectListHead, &pObject->ListEntry);
-			}
+		void Initialize(UINT64 TicksPerSecondIn)
+		{
+			TicksPerSecond = TicksPerSecondIn;
+		}
 
-			void MakeResident(ManagedObject* pObject)
-			{
-				RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::EVICTED);
+		UINT64 GetTicksPerSecond() const
+		{
+			return TicksPerSecond;
+		}
 
-				pObject->ResidencyStatus = ManagedObject::RESIDENCY_STATUS::RESIDENT;
-				RemoveEntryList(&pObject->ListEntry);
-				InsertTailList(&ResidentObjectListHead, &pObject->ListEntry);
+		// The total budget available to the app, policies which adapt to the amount of memory use this as their capacity
+		void SetCacheSize(UINT64 Size)
+		{
+			CacheSize = Size;
+		}
 
-				NumEvictedObjects--;
+		void Insert(ManagedObject* pObject)
+		{
+			if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
+			{
+				Internal::InsertHeadList(&ResidentObjectListHead, &pObject->ListEntry);
 				NumResidentObjects++;
 				ResidentSize += pObject->Size;
 			}
-
-			void Evict(ManagedObject* pObject)
+			else
 			{
-				RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
+				Internal::InsertHeadList(&EvictedObjectListHead, &pObject->ListEntry);
+				NumEvictedObjects++;
+			}
+
+			OnInsert(pObject);
+		}
 
-				pObject->ResidencyStatus = ManagedObject::RESIDENCY_STATUS::EVICTED;
-				RemoveEntryList(&pObject->ListEntry);
-				InsertTailList(&EvictedObjectListHead, &pObject->ListEntry);
+		void Remove(ManagedObject* pObject)
+		{
+			OnRemove(pObject);
 
+			Internal::RemoveEntryList(&pObject->ListEntry);
+			if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
+			{
 				NumResidentObjects--;
 				ResidentSize -= pObject->Size;
-				NumEvictedObjects++;
 			}
-
-			// Evict all of the resident objects used in sync points up to the specficied one (inclusive)
-			void TrimToSyncPointInclusive(INT64 CurrentUsage, INT64 CurrentBudget, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 SyncPoint)
+			else
 			{
-				NumObjectsToEvict = 0;
+				NumEvictedObjects--;
+			}
+		}
 
-				LIST_ENTRY* pResourceEntry = ResidentObjectListHead.Flink;
-				while (pResourceEntry != &ResidentObjectListHead)
-				{
-					ManagedObject* pObject = CONTAINING_RECORD(pResourceEntry, ManagedObject, ListEntry);
+		// When an object is used by the GPU we move it to the end of the list.
+		// This way things closer to the head of the list are the objects which
+		// are stale and better candidates for eviction
+		void ObjectReferenced(ManagedObject* pObject)
+		{
+			RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
 
-					if (pObject->LastGPUSyncPoint > SyncPoint || CurrentUsage < CurrentBudget)
-					{
-						break;
-					}
+			Internal::RemoveEntryList(&pObject->ListEntry);
+			Internal::InsertTailList(&ResidentObjectListHead, &pObject->ListEntry);
 
-					RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
+			OnReferenced(pObject);
+		}
 
-					EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
-					Evict(pObject);
+		void MakeResident(ManagedObject* pObject)
+		{
+			RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::EVICTED);
 
-					CurrentUsage -= pObject->Size;
+			pObject->ResidencyStatus = ManagedObject::RESIDENCY_STATUS::RESIDENT;
+			Internal::RemoveEntryList(&pObject->ListEntry);
+			Internal::InsertTailList(&ResidentObjectListHead, &pObject->ListEntry);
 
-					pResourceEntry = ResidentObjectListHead.Flink;
-				}
-			}
+			NumEvictedObjects--;
+			NumResidentObjects++;
+			ResidentSize += pObject->Size;
+
+			OnMakeResident(pObject);
+		}
+
+		void Evict(ManagedObject* pObject)
+		{
+			RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
+
+			pObject->ResidencyStatus = ManagedObject::RESIDENCY_STATUS::EVICTED;
+			Internal::RemoveEntryList(&pObject->ListEntry);
+			Internal::InsertTailList(&EvictedObjectListHead, &pObject->ListEntry);
+
+			NumResidentObjects--;
+			ResidentSize -= pObject->Size;
+			NumEvictedObjects++;
+
+			OnEvict(pObject);
+		}
+
+		// Evict resident objects used in sync points up to the specficied one (inclusive) until usage drops below the budget.
+		// This version allocates nothing and always succeeds, so it is the fallback when an override fails.
+		virtual HRESULT TrimToSyncPointInclusive(INT64 CurrentUsage, INT64 CurrentBudget, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 SyncPoint)
+		{
+			NumObjectsToEvict = 0;
 
-			// Trim all objects which are older than the specified time
-			void TrimAgedAllocations(DeviceWideSyncPoint* MaxSyncPoint, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 CurrentTimeStamp, UINT64 MinDelta)
+			while (CurrentUsage >= CurrentBudget)
 			{
-				LIST_ENTRY* pResourceEntry = ResidentObjectListHead.Flink;
-				while (pResourceEntry != &ResidentObjectListHead)
+				ManagedObject* pObject = SelectVictim(SyncPoint);
+				if (pObject == nullptr)
 				{
-					ManagedObject* pObject = CONTAINING_RECORD(pResourceEntry, ManagedObject, ListEntry);
+					break;
+				}
 
-					if ((MaxSyncPoint && pObject->LastGPUSyncPoint >= MaxSyncPoint->GenerationID) || // Only trim allocations done on the GPU
-						CurrentTimeStamp - pObject->LastUsedTimestamp <= MinDelta) // Don't evict things which have been used recently
-					{
-						break;
-					}
+				RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
 
-					RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
-					EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
-					Evict(pObject);
+				EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
+				Evict(pObject);
 
-					pResourceEntry = ResidentObjectListHead.Flink;
-				}
+				CurrentUsage -= pObject->Size;
 			}
+			return S_OK;
+		}
 
-			ManagedObject* GetResidentListHead()
+		// Trim all objects which are older than the specified time
+		void TrimAgedAllocations(Internal::DeviceWideSyncPoint* MaxSyncPoint, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 CurrentTimeStamp, UINT64 MinDelta)
+		{
+			LIST_ENTRY* pResourceEntry = ResidentObjectListHead.Flink;
+			while (pResourceEntry != &ResidentObjectListHead)
 			{
-				if (IsListEmpty(&ResidentObjectListHead))
+				ManagedObject* pObject = CONTAINING_RECORD(pResourceEntry, ManagedObject, ListEntry);
+
+				if ((MaxSyncPoint && pObject->LastGPUSyncPoint >= MaxSyncPoint->GenerationID) || // Only trim allocations done on the GPU
+					CurrentTimeStamp - pObject->LastUsedTimestamp <= MinDelta) // Don't evict things which have been used recently
 				{
-					return nullptr;
+					break;
 				}
-				return CONTAINING_RECORD(ResidentObjectListHead.Flink, ManagedObject, ListEntry);
+
+				RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
+				EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
+				Evict(pObject);
+
+				pResourceEntry = ResidentObjectListHead.Flink;
 			}
+		}
 
-			LIST_ENTRY ResidentObjectListHead;
-			LIST_ENTRY EvictedObjectListHead;
+		// The least recently used resident object, i.e. the one with the oldest sync point
+		ManagedObject* GetResidentListHead()
+		{
+			if (Internal::IsListEmpty(&ResidentObjectListHead))
+			{
+				return nullptr;
+			}
+			return CONTAINING_RECORD(ResidentObjectListHead.Flink, ManagedObject, ListEntry);
+		}
 
-			UINT32 NumResidentObjects;
-			UINT32 NumEvictedObjects;
+		LIST_ENTRY ResidentObjectListHead;
+		LIST_ENTRY EvictedObjectListHead;
 
-			UINT64 ResidentSize;
-		};
+		UINT32 NumResidentObjects;
+		UINT32 NumEvictedObjects;
 
-		class ResidencyManagerInternal
-		{
+		UINT64 ResidentSize;
+
+	protected:
+		// Notifications sent after the base class has updated the object's residency status
+		virtual void OnInsert(ManagedObject* /*pObject*/) {}
+		virtual void OnRemove(ManagedObject* /*pObject*/) {}
+		virtual void OnReferenced(ManagedObject* /*pObject*/) {}
+		virtual void OnMakeResident(ManagedObject* /*pObject*/) {}
+		virtual void OnEvict(ManagedObject* /*pObject*/) {}
+
+		// Returns the next object to evict or nullptr if there is none. Only objects last used at or before
+		// SyncPoint may be returned as the GPU may still be using the others.
+		virtual ManagedObject* SelectVictim(UINT64 SyncPoint) = 0;
+
+		static inline bool IsEvictable(ManagedObject* pObject, UINT64 SyncPoint)
+		{
+			return pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT && pObject->LastGPUSyncPoint <= SyncPoint;
+		}
+
+		UINT64 CacheSize;
+		UINT64 TicksPerSecond;
+	};
+
+	namespace Internal
+	{
+		// A Least Recently Used Cache. Always evicts the object which has gone the longest without being used.
+		class LRUCache : public EvictionPolicy
+		{
+		protected:
+			ManagedObject* SelectVictim(UINT64 SyncPoint)
+			{
+				ManagedObject* pObject = GetResidentListHead();
+				return (pObject && IsEvictable(pObject, SyncPoint)) ? pObject : nullptr;
+			}
+		};
+
+		// Adaptive Replacement Cache measured in bytes rather than pages. Objects used once live in T1 and
+		// objects used repeatedly in T2, recently evicted objects are remembered in the ghost lists B1 and B2.
+		// A fault on a ghost shifts the target size of T1 so that large textures which are reused don't get
+		// flushed by a stream of objects that are only touched once. Every submission references every
+		// object it uses, so references within CorrelatedReferencePeriod seconds of the one which put the
+		// object in T1 (e.g. the other command lists of the same frame) don't count as a reuse.
+		class ARCCache : public EvictionPolicy
+		{
 		public:
-			ResidencyManagerInternal(SyncManager* pSyncManagerIn) :
-				Device(nullptr),
-				AsyncThreadFence(1),
-				CompletionEvent(INVALID_HANDLE_VALUE),
-				AsyncThreadWorkCompletionEvent(INVALID_HANDLE_VALUE),
-				Adapter(nullptr),
-				AsyncWorkEvent(INVALID_HANDLE_VALUE),
-				AsyncWorkThread(INVALID_HANDLE_VALUE),
-				FinishAsyncWork(false),
-				cStartEvicted(false),
-				CurrentSyncPointGeneration(0),
-				NumQueuesSeen(0),
-				NodeMask(0),
-				CurrentAsyncWorkloadHead(0),
-				CurrentAsyncWorkloadTail(0),
-				cMinEvictionGracePeriod(1.0f),
-				cMaxEvictionGracePeriod(60.0f),
-				cTrimPercentageMemoryUsageThreshold(0.7f),
-				AsyncWorkQueue(nullptr),
-				MaxSoftwareQueueLatency(6),
-				AsyncWorkQueueSize(7),
-				pSyncManager(pSyncManagerIn)
+			ARCCache(double CorrelatedReferencePeriodIn = 0.1) :
+				CorrelatedReferencePeriod(CorrelatedReferencePeriodIn),
+				TargetT1Size(0)
 			{
-				Internal::InitializeListHead(&QueueFencesListHead);
-				Internal::InitializeListHead(&InFlightSyncPointsHead);
+				for (UINT32 i = 0; i < ARC_LIST_COUNT; i++)
+				{
+					InitializeListHead(&Lists[i]);
+					ListSize[i] = 0;
+				}
+			}
+
+		protected:
+			enum ARC_LIST
+			{
+				ARC_NONE,
+				ARC_T1,
+				ARC_T2,
+				ARC_B1,
+				ARC_B2,
+				ARC_LIST_COUNT
 			};
 
-			HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeMask, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency)
+			void OnInsert(ManagedObject* pObject)
 			{
-				Device = ParentDevice;
-				NodeMask = DeviceNodeMask;
-				Adapter = ParentAdapter;
-				MaxSoftwareQueueLatency = MaxLatency;
+				if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
+				{
+					MoveToT1(pObject);
+				}
+			}
 
-				AsyncWorkQueueSize = MaxLatency + 1;
-				AsyncWorkQueue = new AsyncWorkload[AsyncWorkQueueSize];
+			void OnRemove(ManagedObject* pObject)
+			{
+				MoveToList(pObject, ARC_NONE);
+			}
 
-				if (AsyncWorkQueue == nullptr)
+			void OnReferenced(ManagedObject* pObject)
+			{
+				const UINT64 CorrelatedTicks = UINT64(CorrelatedReferencePeriod * TicksPerSecond);
+				if (pObject->PolicyListIndex == ARC_T1 && pObject->LastUsedTimestamp - pObject->ReferenceHistory[0] <= CorrelatedTicks)
 				{
-					return E_OUTOFMEMORY;
+					// Still the first use, keep it in T1 but as the most recently used
+					MoveToList(pObject, ARC_T1);
 				}
+				else
+				{
+					MoveToList(pObject, ARC_T2);
+				}
+			}
 
-				LARGE_INTEGER Frequency;
-				QueryPerformanceFrequency(&Frequency);
+			void OnMakeResident(ManagedObject* pObject)
+			{
+				const UINT64 Size = RESIDENCY_MAX(pObject->Size, 1);
 
-				// Calculate how many QPC ticks are equivalent to the given time in seconds
-				MinEvictionGracePeriodTicks = UINT64(Frequency.QuadPart * cMinEvictionGracePeriod);
-				MaxEvictionGracePeriodTicks = UINT64(Frequency.QuadPart * cMaxEvictionGracePeriod);
+				if (pObject->PolicyListIndex == ARC_B1)
+				{
+					// Evicted too early from T1, give recently used objects more room
+					const UINT64 Delta = Size * RESIDENCY_MAX(ListSize[ARC_B2] / RESIDENCY_MAX(ListSize[ARC_B1], 1), 1);
+					TargetT1Size = CacheSize ? RESIDENCY_MIN(TargetT1Size + Delta, CacheSize) : TargetT1Size + Delta;
+					MoveToList(pObject, ARC_T2);
+				}
+				else if (pObject->PolicyListIndex == ARC_B2)
+				{
+					// Evicted too early from T2, give frequently used objects more room
+					const UINT64 Delta = Size * RESIDENCY_MAX(ListSize[ARC_B1] / RESIDENCY_MAX(ListSize[ARC_B2], 1), 1);
+					TargetT1Size = (TargetT1Size > Delta) ? TargetT1Size - Delta : 0;
+					MoveToList(pObject, ARC_T2);
+				}
+				else
+				{
+					MoveToT1(pObject);
+				}
 
-				HRESULT hr = S_OK;
-				hr = AsyncThreadFence.Initialize(Device);
+				TrimGhostLists();
+			}
 
-				if (SUCCEEDED(hr))
+			void OnEvict(ManagedObject* pObject)
+			{
+				MoveToList(pObject, (pObject->PolicyListIndex == ARC_T2) ? ARC_B2 : ARC_B1);
+				TrimGhostLists();
+			}
+
+			ManagedObject* SelectVictim(UINT64 SyncPoint)
+			{
+				const UINT32 First = (ListSize[ARC_T1] > TargetT1Size) ? ARC_T1 : ARC_T2;
+				const UINT32 Second = (First == ARC_T1) ? ARC_T2 : ARC_T1;
+
+				ManagedObject* pObject = FindEvictable(First, SyncPoint);
+				return pObject ? pObject : FindEvictable(Second, SyncPoint);
+			}
+
+		private:
+			ManagedObject* FindEvictable(UINT32 List, UINT64 SyncPoint)
+			{
+				LIST_ENTRY* pEntry = Lists[List].Flink;
+				while (pEntry != &Lists[List])
 				{
-					CompletionEvent = CreateEvent(nullptr, false, false, nullptr);
-					if (CompletionEvent == INVALID_HANDLE_VALUE)
+					ManagedObject* pObject = CONTAINING_RECORD(pEntry, ManagedObject, PolicyListEntry);
+					if (IsEvictable(pObject, SyncPoint))
 					{
-						hr = HRESULT_FROM_WIN32(GetLastError());
+						return pObject;
 					}
+					pEntry = pEntry->Flink;
 				}
+				return nullptr;
+			}
 
-				if (SUCCEEDED(hr))
+			// Ghost lists only hold as much history as the budget, older entries are forgotten
+			void TrimGhostLists()
+			{
+				if (CacheSize == 0)
+				{
+					return;
+				}
+
+				while (ListSize[ARC_T1] + ListSize[ARC_B1] > CacheSize && IsListEmpty(&Lists[ARC_B1]) == false)
+				{
+					MoveToList(CONTAINING_RECORD(Lists[ARC_B1].Flink, ManagedObject, PolicyListEntry), ARC_NONE);
+				}
+
+				while (ListSize[ARC_T1] + ListSize[ARC_T2] + ListSize[ARC_B1] + ListSize[ARC_B2] > 2 * CacheSize && IsListEmpty(&Lists[ARC_B2]) == false)
+				{
+					MoveToList(CONTAINING_RECORD(Lists[ARC_B2].Flink, ManagedObject, PolicyListEntry), ARC_NONE);
+				}
+			}
+
+			// The first reference is remembered so that references correlated with it can be told apart from reuse
+			void MoveToT1(ManagedObject* pObject)
+			{
+				pObject->ReferenceHistory[0] = pObject->LastUsedTimestamp;
+				MoveToList(pObject, ARC_T1);
+			}
+
+			// Moves the object to the most recently used end of the given list
+			void MoveToList(ManagedObject* pObject, UINT32 List)
+			{
+				if (pObject->PolicyListIndex != ARC_NONE)
+				{
+					RemoveEntryList(&pObject->PolicyListEntry);
+					ListSize[pObject->PolicyListIndex] -= pObject->Size;
+				}
+
+				pObject->PolicyListIndex = List;
+
+				if (List != ARC_NONE)
+				{
+					InsertTailList(&Lists[List], &pObject->PolicyListEntry);
+					ListSize[List] += pObject->Size;
+				}
+			}
+
+			const double CorrelatedReferencePeriod;
+
+			LIST_ENTRY Lists[ARC_LIST_COUNT];
+			UINT64 ListSize[ARC_LIST_COUNT];
+			UINT64 TargetT1Size;
+		};
+
+		// CLOCK-Pro measured in bytes. Objects are either hot or cold and sit on a single clock. New objects
+		// start cold in a test period, an object which is used again during its test period becomes hot.
+		// Cold objects stay on the clock after eviction until their test period ends so a quick reuse can be
+		// detected. The cold target adapts to how often that happens.
+		class ClockProCache : public EvictionPolicy
+		{
+		public:
+			ClockProCache() :
+				HandHot(&Clock),
+				HandCold(&Clock),
+				HandTest(&Clock),
+				NumOnClock(0),
+				HotSize(0),
+				NonResidentTestSize(0),
+				ColdTargetSize(0)
+			{
+				InitializeListHead(&Clock);
+			}
+
+		protected:
+			enum CLOCK_STATE
+			{
+				CLOCK_NONE,
+				CLOCK_HOT,
+				CLOCK_COLD,
+				CLOCK_COLD_TEST
+			};
+
+			void OnInsert(ManagedObject* pObject)
+			{
+				if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
+				{
+					Link(pObject, CLOCK_COLD_TEST);
+				}
+			}
+
+			void OnRemove(ManagedObject* pObject)
+			{
+				if (pObject->PolicyListIndex != CLOCK_NONE)
+				{
+					Unlink(pObject);
+				}
+			}
+
+			void OnReferenced(ManagedObject* pObject)
+			{
+				pObject->PolicyReferenced = true;
+			}
+
+			void OnMakeResident(ManagedObject* pObject)
+			{
+				if (pObject->PolicyListIndex == CLOCK_COLD_TEST)
+				{
+					// Reused while still in its test period, cold objects need more room
+					ColdTargetSize = CacheSize ? RESIDENCY_MIN(ColdTargetSize + pObject->Size, CacheSize) : ColdTargetSize + pObject->Size;
+					NonResidentTestSize -= pObject->Size;
+					Unlink(pObject);
+					Link(pObject, CLOCK_HOT);
+					RunHandHot();
+				}
+				else
 				{
-					AsyncThreadWorkCompletionEvent = CreateEvent(nullptr, false, false, nullptr);
-					if (AsyncThreadWorkCompletionEvent == INVALID_HANDLE_VALUE)
+					if (pObject->PolicyListIndex != CLOCK_NONE)
 					{
-						hr = HRESULT_FROM_WIN32(GetLastError());
+						Unlink(pObject);
 					}
+					Link(pObject, CLOCK_COLD_TEST);
 				}
+			}
 
-				if (SUCCEEDED(hr))
+			void OnEvict(ManagedObject* pObject)
+			{
+				pObject->PolicyReferenced = false;
+
+				if (pObject->PolicyListIndex == CLOCK_COLD_TEST)
+				{
+					// Stays on the clock so that a fault during the test period can be detected
+					NonResidentTestSize += pObject->Size;
+					RunHandTest();
+				}
+				else if (pObject->PolicyListIndex != CLOCK_NONE)
+				{
+					Unlink(pObject);
+				}
+			}
+
+			ManagedObject* SelectVictim(UINT64 SyncPoint)
+			{
+				// Every object is visited at most twice, once to clear its reference bit and once to evict it
+				for (UINT32 Steps = 2 * NumOnClock; Steps > 0 && HandCold != &Clock; Steps--)
 				{
-					AsyncWorkEvent = CreateEvent(nullptr, true, false, nullptr);
-					if (AsyncWorkEvent == INVALID_HANDLE_VALUE)
+					ManagedObject* pObject = CONTAINING_RECORD(HandCold, ManagedObject, PolicyListEntry);
+					HandCold = Next(HandCold);
+
+					if (pObject->PolicyListIndex == CLOCK_HOT || IsEvictable(pObject, SyncPoint) == false)
+					{
+						continue;
+					}
+
+					if (pObject->PolicyReferenced == false)
 					{
-						hr = HRESULT_FROM_WIN32(GetLastError());
+						return pObject;
+					}
+
+					pObject->PolicyReferenced = false;
+					if (pObject->PolicyListIndex == CLOCK_COLD_TEST)
+					{
+						// Reused during the test period
+						pObject->PolicyListIndex = CLOCK_HOT;
+						HotSize += pObject->Size;
+						RunHandHot();
+					}
+					else
+					{
+						// Give it another test period from the head of the clock
+						Unlink(pObject);
+						Link(pObject, CLOCK_COLD_TEST);
 					}
 				}
 
-#if !RESIDENCY_SINGLE_THREADED
-				if (SUCCEEDED(hr))
+				// Every cold object is in use, take a hot one instead
+				return DemoteHot(SyncPoint);
+			}
+
+		private:
+			// Demotes hot objects which haven't been referenced until the hot objects fit in their share of the budget
+			void RunHandHot()
+			{
+				if (CacheSize == 0)
 				{
-					AsyncWorkThread = CreateThread(NULL, 0, AsyncThreadStart, (void*) this, 0, nullptr);
+					return;
+				}
 
-					if (AsyncWorkThread == INVALID_HANDLE_VALUE)
+				const UINT64 HotTargetSize = (CacheSize > ColdTargetSize) ? CacheSize - ColdTargetSize : 0;
+				for (UINT32 Steps = 2 * NumOnClock; Steps > 0 && HotSize > HotTargetSize && HandHot != &Clock; Steps--)
+				{
+					ManagedObject* pObject = CONTAINING_RECORD(HandHot, ManagedObject, PolicyListEntry);
+
+					if (pObject->PolicyListIndex == CLOCK_HOT)
 					{
-						hr = HRESULT_FROM_WIN32(GetLastError());
+						HandHot = Next(HandHot);
+						if (pObject->PolicyReferenced)
+						{
+							pObject->PolicyReferenced = false;
+						}
+						else
+						{
+							pObject->PolicyListIndex = CLOCK_COLD;
+							HotSize -= pObject->Size;
+						}
+					}
+					else if (pObject->PolicyListIndex == CLOCK_COLD_TEST)
+					{
+						EndTestPeriod(pObject);
+					}
+					else
+					{
+						HandHot = Next(HandHot);
 					}
 				}
-#endif
+			}
 
-				return hr;
+			// Sweeps the hot hand until an unreferenced hot object which the GPU is done with is found
+			ManagedObject* DemoteHot(UINT64 SyncPoint)
+			{
+				for (UINT32 Steps = 2 * NumOnClock; Steps > 0 && HandHot != &Clock; Steps--)
+				{
+					ManagedObject* pObject = CONTAINING_RECORD(HandHot, ManagedObject, PolicyListEntry);
+
+					if (pObject->PolicyListIndex == CLOCK_COLD_TEST)
+					{
+						EndTestPeriod(pObject);
+						continue;
+					}
+
+					HandHot = Next(HandHot);
+					if (pObject->PolicyListIndex == CLOCK_HOT && IsEvictable(pObject, SyncPoint))
+					{
+						if (pObject->PolicyReferenced)
+						{
+							pObject->PolicyReferenced = false;
+						}
+						else
+						{
+							pObject->PolicyListIndex = CLOCK_COLD;
+							HotSize -= pObject->Size;
+							return pObject;
+						}
+					}
+				}
+				return nullptr;
 			}
 
-			void Destroy()
+			// Ends test periods until the evicted objects remembered on the clock are no bigger than the budget
+			void RunHandTest()
 			{
-				AsyncThreadFence.Destroy();
+				if (CacheSize == 0)
+				{
+					return;
+				}
 
-				if (CompletionEvent != INVALID_HANDLE_VALUE)
+				for (UINT32 Steps = NumOnClock; Steps > 0 && NonResidentTestSize > CacheSize && HandTest != &Clock; Steps--)
 				{
-					CloseHandle(CompletionEvent);
-					CompletionEvent = INVALID_HANDLE_VALUE;
+					ManagedObject* pObject = CONTAINING_RECORD(HandTest, ManagedObject, PolicyListEntry);
+
+					if (pObject->PolicyListIndex == CLOCK_COLD_TEST)
+					{
+						EndTestPeriod(pObject);
+					}
+					else
+					{
+						HandTest = Next(HandTest);
+					}
 				}
+			}
 
-#if !RESIDENCY_SINGLE_THREADED
-				AsyncWorkload* pWork = DequeueAsyncWork();
+			// The test period ended without a reuse, so cold objects need less room
+			void EndTestPeriod(ManagedObject* pObject)
+			{
+				if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::EVICTED)
+				{
+					ColdTargetSize = (ColdTargetSize > pObject->Size) ? ColdTargetSize - pObject->Size : 0;
+					Unlink(pObject);
+				}
+				else
+				{
+					pObject->PolicyListIndex = CLOCK_COLD;
+					AdvanceHandsPast(&pObject->PolicyListEntry);
+				}
+			}
+
+			// Places the object at the head of the clock, i.e. the last position the hot hand will reach
+			void Link(ManagedObject* pObject, UINT32 State)
+			{
+				pObject->PolicyListIndex = State;
+				pObject->PolicyReferenced = false;
+				InsertTailList(HandHot, &pObject->PolicyListEntry);
+				NumOnClock++;
+
+				if (State == CLOCK_HOT)
+				{
+					HotSize += pObject->Size;
+				}
+
+				if (HandHot == &Clock) HandHot = &pObject->PolicyListEntry;
+				if (HandCold == &Clock) HandCold = &pObject->PolicyListEntry;
+				if (HandTest == &Clock) HandTest = &pObject->PolicyListEntry;
+			}
+
+			void Unlink(ManagedObject* pObject)
+			{
+				if (pObject->PolicyListIndex == CLOCK_HOT)
+				{
+					HotSize -= pObject->Size;
+				}
+				else if (pObject->PolicyListIndex == CLOCK_COLD_TEST && pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::EVICTED)
+				{
+					NonResidentTestSize -= pObject->Size;
+				}
+
+				LIST_ENTRY* pEntry = &pObject->PolicyListEntry;
+				if (HandHot == pEntry) HandHot = Next(pEntry);
+				if (HandCold == pEntry) HandCold = Next(pEntry);
+				if (HandTest == pEntry) HandTest = Next(pEntry);
+
+				RemoveEntryList(pEntry);
+				pObject->PolicyListIndex = CLOCK_NONE;
+				NumOnClock--;
+
+				if (NumOnClock == 0)
+				{
+					HandHot = HandCold = HandTest = &Clock;
+				}
+			}
+
+			void AdvanceHandsPast(LIST_ENTRY* pEntry)
+			{
+				if (HandHot == pEntry) HandHot = Next(pEntry);
+				if (HandTest == pEntry) HandTest = Next(pEntry);
+			}
+
+			// The clock is circular, skip over the list head
+			LIST_ENTRY* Next(LIST_ENTRY* pEntry)
+			{
+				pEntry = pEntry->Flink;
+				return (pEntry == &Clock) ? pEntry->Flink : pEntry;
+			}
+
+			LIST_ENTRY Clock;
+			LIST_ENTRY* HandHot;
+			LIST_ENTRY* HandCold;
+			LIST_ENTRY* HandTest;
+			UINT32 NumOnClock;
+
+			UINT64 HotSize;
+			UINT64 NonResidentTestSize;
+			UINT64 ColdTargetSize;
+		};
+
+		// LRU-K which ranks objects by their estimated reuse rate (K over the time since the K-th most recent
+		// reference) divided by Size^SizeWeight. A weight of 0 gives classic LRU-K, larger weights favour
+		// evicting big objects which are used rarely over small objects which are used all the time.
+		class LRUKCache : public EvictionPolicy
+		{
+		public:
+			LRUKCache(double SizeWeightIn = 0.5, double CorrelatedReferencePeriodIn = 0.1) :
+				SizeWeight(SizeWeightIn),
+				CorrelatedReferencePeriod(CorrelatedReferencePeriodIn),
+				CurrentTime(0)
+			{
+			}
+
+			// Evicts in order of value instead of repeatedly scanning for the single worst object
+			HRESULT TrimToSyncPointInclusive(INT64 CurrentUsage, INT64 CurrentBudget, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 SyncPoint)
+			{
+				NumObjectsToEvict = 0;
+				if (CurrentUsage < CurrentBudget || NumResidentObjects == 0)
+				{
+					return S_OK;
+				}
+
+				struct Candidate
+				{
+					double Value;
+					ManagedObject* pObject;
+				};
+
+				Candidate* pCandidates = new (std::nothrow) Candidate[NumResidentObjects];
+				if (pCandidates == nullptr)
+				{
+					return E_OUTOFMEMORY;
+				}
+				UINT32 NumCandidates = 0;
+
+				LIST_ENTRY* pEntry = ResidentObjectListHead.Flink;
+				while (pEntry != &ResidentObjectListHead)
+				{
+					ManagedObject* pObject = CONTAINING_RECORD(pEntry, ManagedObject, ListEntry);
+					pEntry = pEntry->Flink;
+
+					if (IsEvictable(pObject, SyncPoint))
+					{
+						pCandidates[NumCandidates].Value = GetValue(pObject);
+						pCandidates[NumCandidates].pObject = pObject;
+						NumCandidates++;
+					}
+				}
+
+				// The resident list is in LRU order and stable_sort keeps it that way for equal values
+				std::stable_sort(pCandidates, pCandidates + NumCandidates,
+					[](const Candidate& a, const Candidate& b) { return a.Value < b.Value; });
+
+				for (UINT32 i = 0; i < NumCandidates && CurrentUsage >= CurrentBudget; i++)
+				{
+					ManagedObject* pObject = pCandidates[i].pObject;
+
+					EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
+					Evict(pObject);
+
+					CurrentUsage -= pObject->Size;
+				}
+
+				delete[](pCandidates);
+				return S_OK;
+			}
+
+		protected:
+			void OnReferenced(ManagedObject* pObject)
+			{
+				RecordReference(pObject);
+			}
+
+			void OnMakeResident(ManagedObject* pObject)
+			{
+				// History is kept while the object is evicted so a returning object keeps its rank
+				RecordReference(pObject);
+			}
+
+			ManagedObject* SelectVictim(UINT64 SyncPoint)
+			{
+				ManagedObject* pVictim = nullptr;
+				double VictimValue = 0.0;
+
+				LIST_ENTRY* pEntry = ResidentObjectListHead.Flink;
+				while (pEntry != &ResidentObjectListHead)
+				{
+					ManagedObject* pObject = CONTAINING_RECORD(pEntry, ManagedObject, ListEntry);
+					pEntry = pEntry->Flink;
+
+					if (IsEvictable(pObject, SyncPoint))
+					{
+						const double Value = GetValue(pObject);
+						if (pVictim == nullptr || Value < VictimValue)
+						{
+							pVictim = pObject;
+							VictimValue = Value;
+						}
+					}
+				}
+				return pVictim;
+			}
+
+		private:
+			void RecordReference(ManagedObject* pObject)
+			{
+				const UINT64 Now = pObject->LastUsedTimestamp;
+				CurrentTime = RESIDENCY_MAX(CurrentTime, Now);
+
+				// References close together (e.g. several command lists in one frame) count as one
+				const UINT64 CorrelatedTicks = UINT64(CorrelatedReferencePeriod * TicksPerSecond);
+				if (pObject->ReferenceHistory[0] != 0 && Now - pObject->ReferenceHistory[0] <= CorrelatedTicks)
+				{
+					pObject->ReferenceHistory[0] = Now;
+					return;
+				}
+
+				for (UINT32 i = RESIDENCY_LRU_K - 1; i > 0; i--)
+				{
+					pObject->ReferenceHistory[i] = pObject->ReferenceHistory[i - 1];
+				}
+				pObject->ReferenceHistory[0] = Now;
+			}
+
+			double GetValue(ManagedObject* pObject)
+			{
+				const UINT64 KthReference = pObject->ReferenceHistory[RESIDENCY_LRU_K - 1];
+
+				// Objects with less than K references have an unknown reuse rate and are evicted first
+				const double ReuseRate = (KthReference == 0) ? 0.0 :
+					double(RESIDENCY_LRU_K) * double(TicksPerSecond) / double(CurrentTime - KthReference + 1);
+
+				return ReuseRate / pow(double(RESIDENCY_MAX(pObject->Size, 1)), SizeWeight);
+			}
+
+			const double SizeWeight;
+			const double CorrelatedReferencePeriod;
+			UINT64 CurrentTime;
+		};
+
+		inline EvictionPolicy* CreateEvictionPolicy(EVICTION_POLICY Policy)
+		{
+			switch (Policy)
+			{
+			case EVICTION_POLICY::CLOCK_PRO:
+				return new ClockProCache();
+			case EVICTION_POLICY::ARC:
+				return new ARCCache();
+			case EVICTION_POLICY::LRU_K:
+				return new LRUKCache();
+			default:
+				return new LRUCache();
+			}
+		}
+
+		class ResidencyManagerInternal
+		{
+		public:
+			ResidencyManagerInternal(SyncManager* pSyncManagerIn) :
+				FinishAsyncWork(false),
+				NumQueuesSeen(0),
+				AsyncThreadFence(1),
+				CurrentSyncPointGeneration(0),
+				Device(nullptr),
+				NodeMask(0),
+				Adapter(nullptr),
+				Policy(nullptr),
+				OwnsPolicy(false),
+				pTraceFile(nullptr),
+				TraceStartTime(0),
+				PredictivePrefetch(false),
+				cMaxPredictedReuseInterval(256),
+				cStartEvicted(false),
+				cMinEvictionGracePeriod(1.0f),
+				cMaxEvictionGracePeriod(60.0f),
+				cTrimPercentageMemoryUsageThreshold(0.7f),
+				MaxSoftwareQueueLatency(6),
+				pSyncManager(pSyncManagerIn)
+			{
+				Internal::InitializeListHead(&QueueFencesListHead);
+				Internal::InitializeListHead(&InFlightSyncPointsHead);
+			};
+
+			HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeMask, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency, EvictionPolicy* pPolicy)
+			{
+				// Use the default policy if the app didn't provide one
+				OwnsPolicy = (pPolicy == nullptr);
+				Policy = OwnsPolicy ? new LRUCache() : pPolicy;
+
+				Device = ParentDevice;
+				NodeMask = DeviceNodeMask;
+				Adapter = ParentAdapter;
+				MaxSoftwareQueueLatency = MaxLatency;
+
+				HRESULT hr = AsyncWorkQueue.Initialize(MaxLatency);
+				if (FAILED(hr))
+				{
+					return hr;
+				}
+
+				const INT64 Frequency = Internal::QueryTimestampFrequency();
+
+				// Calculate how many timestamp ticks are equivalent to the given time in seconds
+				MinEvictionGracePeriodTicks = UINT64(Frequency * cMinEvictionGracePeriod);
+				MaxEvictionGracePeriodTicks = UINT64(Frequency * cMaxEvictionGracePeriod);
+
+				Policy->Initialize(Frequency);
+
+				hr = AsyncThreadFence.Initialize(Device);
 
-				while (pWork)
+				if (SUCCEEDED(hr))
 				{
-					pWork = DequeueAsyncWork();
+					hr = CompletionEvent.Initialize(false);
 				}
 
-				FinishAsyncWork = true;
-				if (SetEvent(AsyncWorkEvent) == false)
+				if (SUCCEEDED(hr))
 				{
-					RESIDENCY_CHECK_RESULT(HRESULT_FROM_WIN32(GetLastError()));
+					hr = AsyncThreadWorkCompletionEvent.Initialize(false);
 				}
 
-				if (AsyncWorkThread != INVALID_HANDLE_VALUE)
+				if (SUCCEEDED(hr))
 				{
-					CloseHandle(AsyncWorkThread);
-					AsyncWorkThread = INVALID_HANDLE_VALUE;
+					hr = AsyncWorkEvent.Initialize(true);
 				}
 
-				if (AsyncWorkEvent != INVALID_HANDLE_VALUE)
+#if !RESIDENCY_SINGLE_THREADED
+				if (SUCCEEDED(hr))
 				{
-					CloseHandle(AsyncWorkEvent);
-					AsyncWorkEvent = INVALID_HANDLE_VALUE;
+					hr = AsyncWorkThread.Start(AsyncThreadStart, (void*) this);
 				}
 #endif
 
-				if (AsyncThreadWorkCompletionEvent != INVALID_HANDLE_VALUE)
-				{
-					CloseHandle(AsyncThreadWorkCompletionEvent);
-					AsyncThreadWorkCompletionEvent = INVALID_HANDLE_VALUE;
-				}
+				return hr;
+			}
+
+			void Destroy()
+			{
+#if !RESIDENCY_SINGLE_THREADED
+				// The async thread finishes any outstanding work before exiting
+				FinishAsyncWork = true;
+				RESIDENCY_CHECK_RESULT(AsyncWorkEvent.Set());
+				AsyncWorkThread.Join();
+#endif
+
+				AsyncThreadFence.Destroy();
+
+				CompletionEvent.Destroy();
+				AsyncWorkEvent.Destroy();
+				AsyncThreadWorkCompletionEvent.Destroy();
 
 				while (Internal::IsListEmpty(&QueueFencesListHead) == false)
 				{
@@ -790,6 +1767,12 @@ namespace D3DX12Residency
 					Internal::RemoveHeadList(&QueueFencesListHead);
 					delete(pObject);
 				}
+
+				if (OwnsPolicy)
+				{
+					delete(Policy);
+				}
+				Policy = nullptr;
 			}
 
 			void BeginTrackingObject(ManagedObject* pObject)
@@ -805,28 +1788,79 @@ namespace D3DX12Residency
 						RESIDENCY_CHECK_RESULT(Device->Evict(1, &pObject->pUnderlying));
 					}
 
-					LRU.Insert(pObject);
+					Policy->Insert(pObject);
+
+					if (pTraceFile)
+					{
+						fprintf(pTraceFile, "object %llu %llu\n", UINT64(SIZE_T(pObject)), pObject->Size);
+					}
 				}
 			}
 
+			void TakePolicyOwnership()
+			{
+				OwnsPolicy = true;
+			}
+
 			void EndTrackingObject(ManagedObject* pObject)
 			{
 				Internal::ScopedLock Lock(&Mutex);
 
-				LRU.Remove(pObject);
+				Policy->Remove(pObject);
+
+				if (pTraceFile)
+				{
+					fprintf(pTraceFile, "release %llu\n", UINT64(SIZE_T(pObject)));
+				}
 			}
 
 			// One residency set per command-list
 			HRESULT ExecuteCommandLists(ID3D12CommandQueue* Queue, ID3D12CommandList** CommandLists, ResidencySet** ResidencySets, UINT32 Count)
 			{
+				if (pTraceFile)
+				{
+					RecordSets("execute", Queue, ResidencySets, Count);
+				}
+
 				return ExecuteSubset(Queue, CommandLists, ResidencySets, Count);
 			}
 
+			// Writes every tracked object, budget change and residency set to the file so that the stream can be
+			// replayed against other eviction policies offline. Pass nullptr to stop recording.
+			void SetTraceFile(FILE* pFile)
+			{
+				Internal::ScopedLock Lock(&Mutex);
+
+				pTraceFile = pFile;
+				if (pTraceFile == nullptr)
+				{
+					return;
+				}
+
+				TraceStartTime = Internal::QueryTimestamp();
+				TraceLocalBudget = TraceNonLocalBudget = 0;
+
+				// Objects tracked before recording started
+				for (LIST_ENTRY* pHead : { &Policy->ResidentObjectListHead, &Policy->EvictedObjectListHead })
+				{
+					for (LIST_ENTRY* pEntry = pHead->Flink; pEntry != pHead; pEntry = pEntry->Flink)
+					{
+						ManagedObject* pObject = CONTAINING_RECORD(pEntry, ManagedObject, ListEntry);
+						fprintf(pTraceFile, "object %llu %llu\n", UINT64(SIZE_T(pObject)), pObject->Size);
+					}
+				}
+			}
+
 		private:
 
-			HRESULT ExecuteSubset(ID3D12CommandQueue* Queue, ID3D12CommandList** CommandLists, ResidencySet** ResidencySets, UINT32 Count)
+			void RecordSets(const char* pCommand, ID3D12CommandQueue* Queue, ResidencySet** ResidencySets, UINT32 Count)
 			{
-				HRESULT hr = S_OK;
+				Internal::ScopedLock Lock(&Mutex);
+
+				if (pTraceFile == nullptr)
+				{
+					return;
+				}
 
 				DXGI_QUERY_VIDEO_MEMORY_INFO LocalMemory;
 				ZeroMemory(&LocalMemory, sizeof(LocalMemory));
@@ -836,7 +1870,34 @@ namespace D3DX12Residency
 				ZeroMemory(&NonLocalMemory, sizeof(NonLocalMemory));
 				GetCurrentBudget(&NonLocalMemory, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL);
 
+				if (LocalMemory.Budget != TraceLocalBudget || NonLocalMemory.Budget != TraceNonLocalBudget)
+				{
+					TraceLocalBudget = LocalMemory.Budget;
+					TraceNonLocalBudget = NonLocalMemory.Budget;
+					fprintf(pTraceFile, "budget %llu %llu\n", TraceLocalBudget, TraceNonLocalBudget);
+				}
+
+				const UINT64 ElapsedMicroseconds = UINT64((Internal::QueryTimestamp() - TraceStartTime) * 1000000.0 / Policy->GetTicksPerSecond());
+
+				fprintf(pTraceFile, "%s %llu %llu %u\n", pCommand, UINT64(SIZE_T(Queue)), ElapsedMicroseconds, Count);
+				for (UINT32 i = 0; i < Count; i++)
+				{
+					const INT32 SetSize = ResidencySets[i] ? ResidencySets[i]->CurrentSetSize : 0;
+					fprintf(pTraceFile, "set %d", SetSize);
+					for (INT32 x = 0; x < SetSize; x++)
+					{
+						fprintf(pTraceFile, " %llu", UINT64(SIZE_T(ResidencySets[i]->ppSet[x])));
+					}
+					fprintf(pTraceFile, "\n");
+				}
+			}
+
+			// Gathers up all of the unique objects referenced by the sets. NumSetsWithinBudget receives how many of the
+			// leading sets can be executed together without needing more than Budget bytes.
+			HRESULT CreateMasterSet(ResidencySet** ResidencySets, UINT32 Count, UINT64 Budget, ResidencySet** ppMasterSet, UINT64* pTotalSizeNeeded, UINT32* pNumSetsWithinBudget)
+			{
 				UINT64 TotalSizeNeeded = 0;
+				UINT32 NumSetsWithinBudget = Count;
 
 				UINT32 MaxObjectsReferenced = 0;
 				for (UINT32 i = 0; i < Count; i++)
@@ -856,12 +1917,14 @@ namespace D3DX12Residency
 				ResidencySet* pMasterSet = new ResidencySet();
 				if (pMasterSet == nullptr || pMasterSet->Initialize(pSyncManager, MaxObjectsReferenced) == false)
 				{
+					delete(pMasterSet);
 					return E_OUTOFMEMORY;
 				}
 
-				hr = pMasterSet->Open();
+				HRESULT hr = pMasterSet->Open();
 				if (FAILED(hr))
 				{
+					delete(pMasterSet);
 					return hr;
 				}
 
@@ -879,24 +1942,114 @@ namespace D3DX12Residency
 							}
 						}
 					}
+
+					if (TotalSizeNeeded > Budget && NumSetsWithinBudget == Count)
+					{
+						NumSetsWithinBudget = i;
+					}
 				}
 				// Close this set to free it's slot up for the app
 				hr = pMasterSet->Close();
 				if (FAILED(hr))
+				{
+					delete(pMasterSet);
+					return hr;
+				}
+
+				*ppMasterSet = pMasterSet;
+				*pTotalSizeNeeded = TotalSizeNeeded;
+				*pNumSetsWithinBudget = NumSetsWithinBudget;
+				return S_OK;
+			}
+
+		public:
+			// Asks the async thread to make the objects resident ahead of the command lists which will use them, as long
+			// as they fit in the remaining budget. Nothing is evicted to make room. Returns S_FALSE if the async thread
+			// is too far behind to take the request.
+			HRESULT Prefetch(ResidencySet** ResidencySets, UINT32 Count)
+			{
+				if (pTraceFile)
+				{
+					RecordSets("prefetch", nullptr, ResidencySets, Count);
+				}
+
+				ResidencySet* pMasterSet = nullptr;
+				UINT64 TotalSizeNeeded = 0;
+				UINT32 NumSetsWithinBudget = Count;
+
+				HRESULT hr = CreateMasterSet(ResidencySets, Count, MAXUINT64, &pMasterSet, &TotalSizeNeeded, &NumSetsWithinBudget);
+				if (FAILED(hr))
+				{
+					return hr;
+				}
+
+				Internal::ScopedLock Lock(&ExecutionCS);
+
+				// Prefetching is a hint, never hold up the app waiting for the async thread
+				if (AsyncWorkQueue.IsFull())
+				{
+					delete(pMasterSet);
+					return S_FALSE;
+				}
+
+				hr = EnqueueAsyncWork(pMasterSet, 0, CurrentSyncPointGeneration, true);
+#if RESIDENCY_SINGLE_THREADED
+				AsyncWorkload Workload;
+				if (DequeueAsyncWork(&Workload))
+				{
+					ProcessPagingWork(&Workload);
+				}
+#endif
+				return hr;
+			}
+
+			// Enables guessing which evicted objects are about to be used again from how often they were used in the past
+			void SetPredictivePrefetch(bool Enable)
+			{
+				PredictivePrefetch = Enable;
+			}
+
+			void GetStatistics(ResidencyStatistics* pStatistics)
+			{
+				Internal::ScopedLock Lock(&Mutex);
+				*pStatistics = Statistics;
+			}
+
+		private:
+			HRESULT ExecuteSubset(ID3D12CommandQueue* Queue, ID3D12CommandList** CommandLists, ResidencySet** ResidencySets, UINT32 Count)
+			{
+				HRESULT hr = S_OK;
+
+				DXGI_QUERY_VIDEO_MEMORY_INFO LocalMemory;
+				ZeroMemory(&LocalMemory, sizeof(LocalMemory));
+				GetCurrentBudget(&LocalMemory, DXGI_MEMORY_SEGMENT_GROUP_LOCAL);
+
+				DXGI_QUERY_VIDEO_MEMORY_INFO NonLocalMemory;
+				ZeroMemory(&NonLocalMemory, sizeof(NonLocalMemory));
+				GetCurrentBudget(&NonLocalMemory, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL);
+
+				const UINT64 TotalBudget = LocalMemory.Budget + NonLocalMemory.Budget;
+
+				ResidencySet* pMasterSet = nullptr;
+				UINT64 TotalSizeNeeded = 0;
+				UINT32 NumSetsWithinBudget = Count;
+
+				hr = CreateMasterSet(ResidencySets, Count, TotalBudget, &pMasterSet, &TotalSizeNeeded, &NumSetsWithinBudget);
+				if (FAILED(hr))
 				{
 					return hr;
 				}
 
 				// This set of commandlists can't possibly fit within the budget, they need to be split up. If the number of command lists is 1 there is
 				// nothing we can do
-				if (Count > 1 && TotalSizeNeeded > LocalMemory.Budget + NonLocalMemory.Budget)
+				if (Count > 1 && TotalSizeNeeded > TotalBudget)
 				{
 					delete(pMasterSet);
 
-					// Recursively try to find a small enough set to fit in memory
-					const UINT32 Half = Count / 2;
-					const HRESULT LowerHR = ExecuteSubset(Queue, CommandLists, ResidencySets, Half);
-					const HRESULT UpperHR = ExecuteSubset(Queue, &CommandLists[Half], &ResidencySets[Half], Count - Half);
+					// Execute the longest run of command lists which fits in the budget then carry on with the rest
+					const UINT32 Split = RESIDENCY_MAX(NumSetsWithinBudget, 1);
+					const HRESULT LowerHR = ExecuteSubset(Queue, CommandLists, ResidencySets, Split);
+					const HRESULT UpperHR = ExecuteSubset(Queue, &CommandLists[Split], &ResidencySets[Split], Count - Split);
 
 					return (LowerHR == S_OK && UpperHR == S_OK) ? S_OK : E_FAIL;
 				}
@@ -909,8 +2062,10 @@ namespace D3DX12Residency
 				memcpy((void*)FenceGuid.Data4, Queue, sizeof(ID3D12CommandQueue*));
 
 				Internal::Fence* QueueFence = nullptr;
-				// Find or create the fence for this queue
+				// Find or create the fence for this queue, the lock keeps the list of queue fences consistent when queues are used from several threads
 				{
+					Internal::ScopedLock Lock(&AsyncWorkMutex);
+
 					UINT32 Size = sizeof(Internal::Fence*);
 					hr = Queue->GetPrivateData(FenceGuid, &Size, &QueueFence);
 					if (FAILED(hr))
@@ -919,7 +2074,7 @@ namespace D3DX12Residency
 						hr = QueueFence->Initialize(Device);
 						Internal::InsertTailList(&QueueFencesListHead, &QueueFence->ListEntry);
 
-						InterlockedIncrement(&NumQueuesSeen);
+						NumQueuesSeen++;
 
 						if (SUCCEEDED(hr))
 						{
@@ -935,10 +2090,13 @@ namespace D3DX12Residency
 					Internal::ScopedLock Lock(&ExecutionCS);
 					// Evict or make resident all of the objects we identified above.
 					// This will run on an async thread, allowing the current to continue while still blocking the GPU if required
-					hr = EnqueueAsyncWork(pMasterSet, AsyncThreadFence.FenceValue, CurrentSyncPointGeneration);
+					hr = EnqueueAsyncWork(pMasterSet, AsyncThreadFence.FenceValue, CurrentSyncPointGeneration, false);
 #if RESIDENCY_SINGLE_THREADED
-					AsyncWorkload* pWorkload = DequeueAsyncWork();
-					ProcessPagingWork(pWorkload);
+					AsyncWorkload Workload;
+					if (DequeueAsyncWork(&Workload))
+					{
+						ProcessPagingWork(&Workload);
+					}
 #endif
 
 					// If there are some things that need to be made resident we need to make sure that the GPU
@@ -973,13 +2131,17 @@ namespace D3DX12Residency
 			struct AsyncWorkload
 			{
 				AsyncWorkload() :
+					SyncPointGeneration(0),
+					IsPrefetch(false),
 					pMasterSet(nullptr),
-					FenceValueToSignal(0),
-					SyncPointGeneration(0)
+					FenceValueToSignal(0)
 				{}
 
 				UINT64 SyncPointGeneration;
 
+				// Prefetches only make objects resident, they don't belong to a submission so nothing waits on them
+				bool IsPrefetch;
+
 				// List of objects to make resident
 				ResidencySet* pMasterSet;
 
@@ -987,57 +2149,49 @@ namespace D3DX12Residency
 				UINT64 FenceValueToSignal;
 			};
 
-			SIZE_T AsyncWorkQueueSize;
-			AsyncWorkload* AsyncWorkQueue;
+			// Written by the thread calling ExecuteCommandLists, read by the async thread
+			Internal::SPSCQueue<AsyncWorkload> AsyncWorkQueue;
 
-			HANDLE AsyncWorkEvent;
-			HANDLE AsyncWorkThread;
+			Internal::Event AsyncWorkEvent;
+			Internal::Thread AsyncWorkThread;
 			Internal::CriticalSection AsyncWorkMutex;
-			volatile bool FinishAsyncWork;
-			volatile SIZE_T CurrentAsyncWorkloadHead;
-			volatile SIZE_T CurrentAsyncWorkloadTail;
+			std::atomic<bool> FinishAsyncWork;
 
-			static unsigned long WINAPI AsyncThreadStart(void* pData)
+			static void AsyncThreadStart(void* pData)
 			{
 				ResidencyManagerInternal* pManager = (ResidencyManagerInternal*)pData;
 
 				while (1)
 				{
-					AsyncWorkload* pWork = pManager->DequeueAsyncWork();
-
-					while (pWork)
+					AsyncWorkload Work;
+					while (pManager->DequeueAsyncWork(&Work))
 					{
 						// Submit the work
-						pManager->ProcessPagingWork(pWork);
-						if (SetEvent(pManager->AsyncThreadWorkCompletionEvent) == false)
-						{
-							RESIDENCY_CHECK_RESULT(HRESULT_FROM_WIN32(GetLastError()));
-						}
-
-						// Get more work
-						pWork = pManager->DequeueAsyncWork();
-					}
-
-					//Wait until there is more work do be done
-					WaitForSingleObject(pManager->AsyncWorkEvent, INFINITE);
-					if (ResetEvent(pManager->AsyncWorkEvent) == false)
-					{
-						RESIDENCY_CHECK_RESULT(HRESULT_FROM_WIN32(GetLastError()));
+						pManager->ProcessPagingWork(&Work);
+						RESIDENCY_CHECK_RESULT(pManager->AsyncThreadWorkCompletionEvent.Set());
 					}
 
 					if (pManager->FinishAsyncWork)
 					{
-						return 0;
+						return;
 					}
-				}
 
-				return 0;
+					//Wait until there is more work do be done
+					pManager->AsyncWorkEvent.Wait();
+					RESIDENCY_CHECK_RESULT(pManager->AsyncWorkEvent.Reset());
+				}
 			}
 
 			// This will be run from a worker thread and will emulate a software queue for making gpu resources resident or evicted.
 			// The GPU will be synchronized by this queue to ensure that it never executes using an evicted resource.
 			void ProcessPagingWork(AsyncWorkload* pWork)
 			{
+				if (pWork->IsPrefetch)
+				{
+					ProcessPrefetchWork(pWork);
+					return;
+				}
+
 				Internal::DeviceWideSyncPoint* FirstUncompletedSyncPoint = DequeueCompletedSyncPoints();
 
 				// Use a union so that we only need 1 allocation
@@ -1056,42 +2210,71 @@ namespace D3DX12Residency
 				// the size of all the objects which will need to be made resident in order to execute this set.
 				UINT64 SizeToMakeResident = 0;
 
-				LARGE_INTEGER CurrentTime;
-				QueryPerformanceCounter(&CurrentTime);
+				const INT64 CurrentTime = Internal::QueryTimestamp();
 
 				{
 					// A lock must be taken here as the state of the objects will be altered
 					Internal::ScopedLock Lock(&Mutex);
 
 					pMakeResidentList = new ResidentScratchSpace[pWork->pMasterSet->CurrentSetSize];
-					pEvictionList = new ID3D12Pageable*[LRU.NumResidentObjects];
+					pEvictionList = new ID3D12Pageable*[Policy->NumResidentObjects];
 
 					// Mark the objects used by this command list to be made resident
 					for (INT32 i = 0; i < pWork->pMasterSet->CurrentSetSize; i++)
 					{
 						ManagedObject*& pObject = pWork->pMasterSet->ppSet[i];
+
+						// Remember how often the object is used so its next use can be predicted
+						if (pObject->LastGPUSyncPoint != 0)
+						{
+							pObject->ReuseInterval = pWork->SyncPointGeneration - pObject->LastGPUSyncPoint;
+						}
+
+						// Update the last sync point that this was used on
+						pObject->LastGPUSyncPoint = pWork->SyncPointGeneration;
+
+						pObject->LastUsedTimestamp = CurrentTime;
+
 						// If it's evicted we need to make it resident again
 						if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::EVICTED)
 						{
 							pMakeResidentList[NumObjectsToMakeResident++].pManagedObject = pObject;
-							LRU.MakeResident(pObject);
+							Policy->MakeResident(pObject);
 
 							SizeToMakeResident += pObject->Size;
+
+							// The GPU will have to wait for this one
+							Statistics.LateObjects++;
+							Statistics.LateBytes += pObject->Size;
+							if (pObject->Prefetched)
+							{
+								Statistics.PrefetchesWasted++;
+							}
 						}
+						else
+						{
+							Policy->ObjectReferenced(pObject);
 
-						// Update the last sync point that this was used on
-						pObject->LastGPUSyncPoint = pWork->SyncPointGeneration;
+							if (pObject->Prefetched)
+							{
+								Statistics.StallsAvoided++;
+							}
+						}
+						pObject->Prefetched = false;
+					}
 
-						pObject->LastUsedTimestamp = CurrentTime.QuadPart;
-						LRU.ObjectReferenced(pObject);
+					if (NumObjectsToMakeResident)
+					{
+						Statistics.LateSubmissions++;
 					}
+					Statistics.Submissions++;
 
 					DXGI_QUERY_VIDEO_MEMORY_INFO LocalMemory;
 					ZeroMemory(&LocalMemory, sizeof(LocalMemory));
 					GetCurrentBudget(&LocalMemory, DXGI_MEMORY_SEGMENT_GROUP_LOCAL);
 
 					UINT64 EvictionGracePeriod = GetCurrentEvictionGracePeriod(&LocalMemory);
-					LRU.TrimAgedAllocations(FirstUncompletedSyncPoint, pEvictionList, NumObjectsToEvict, CurrentTime.QuadPart, EvictionGracePeriod);
+					Policy->TrimAgedAllocations(FirstUncompletedSyncPoint, pEvictionList, NumObjectsToEvict, CurrentTime, EvictionGracePeriod);
 
 					if (NumObjectsToEvict)
 					{
@@ -1117,6 +2300,8 @@ namespace D3DX12Residency
 
 							INT64 AvailableSpace = TotalBudget - TotalUsage;
 
+							Policy->SetCacheSize(UINT64(RESIDENCY_MAX(TotalBudget, 0)));
+
 							UINT64 BatchSize = 0;
 							UINT32 NumObjectsInBatch = 0;
 							UINT32 BatchStart = MakeResidentIndex;
@@ -1152,7 +2337,7 @@ namespace D3DX12Residency
 
 							if (FAILED(hr) || ObjectsMadeResident != NumObjectsToMakeResident)
 							{
-								ManagedObject* pResidentHead = LRU.GetResidentListHead();
+								ManagedObject* pResidentHead = Policy->GetResidentListHead();
 
 								// Get the next sync point to wait for
 								FirstUncompletedSyncPoint = DequeueCompletedSyncPoints();
@@ -1192,7 +2377,11 @@ namespace D3DX12Residency
 								// Wait until the GPU is done
 								WaitForSyncPoint(GenerationToWaitFor);
 
-								LRU.TrimToSyncPointInclusive(TotalUsage + INT64(SizeToMakeResident), TotalBudget, pEvictionList, NumObjectsToEvict, GenerationToWaitFor);
+								hr = Policy->TrimToSyncPointInclusive(TotalUsage + INT64(SizeToMakeResident), TotalBudget, pEvictionList, NumObjectsToEvict, GenerationToWaitFor);
+								if (FAILED(hr))
+								{
+									Policy->EvictionPolicy::TrimToSyncPointInclusive(TotalUsage + INT64(SizeToMakeResident), TotalBudget, pEvictionList, NumObjectsToEvict, GenerationToWaitFor);
+								}
 
 								RESIDENCY_CHECK_RESULT(Device->Evict(NumObjectsToEvict, pEvictionList));
 							}
@@ -1206,6 +2395,11 @@ namespace D3DX12Residency
 
 					delete[](pMakeResidentList);
 					delete[](pEvictionList);
+
+					if (PredictivePrefetch)
+					{
+						PrefetchPredictedObjects(pWork->SyncPointGeneration);
+					}
 				}
 
 				// Tell the GPU that it's safe to execute since we made things resident
@@ -1214,44 +2408,149 @@ namespace D3DX12Residency
 				delete(pWork->pMasterSet);
 				pWork->pMasterSet = nullptr;
 			}
-			// The Enqueue and Dequeue Async Work functions are threadsafe as there is only 1 producer and 1 consumer, if that changes
-			// Synchronisation will be required
-			HRESULT EnqueueAsyncWork(ResidencySet* pMasterSet, UINT64 FenceValueToSignal, UINT64 SyncPointGeneration)
+			void ProcessPrefetchWork(AsyncWorkload* pWork)
 			{
-				// We can't get too far ahead of the worker thread otherwise huge hitches occur
-				while ((CurrentAsyncWorkloadTail - CurrentAsyncWorkloadHead) >= MaxSoftwareQueueLatency)
 				{
-					WaitForSingleObject(AsyncThreadWorkCompletionEvent, INFINITE);
+					Internal::ScopedLock Lock(&Mutex);
+
+					ManagedObject** ppObjects = new ManagedObject*[RESIDENCY_MAX(pWork->pMasterSet->CurrentSetSize, 1)];
+					UINT32 NumObjects = 0;
+
+					for (INT32 i = 0; i < pWork->pMasterSet->CurrentSetSize; i++)
+					{
+						ManagedObject* pObject = pWork->pMasterSet->ppSet[i];
+						if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::EVICTED)
+						{
+							ppObjects[NumObjects++] = pObject;
+						}
+					}
+
+					PrefetchObjects(ppObjects, NumObjects);
+					delete[](ppObjects);
+				}
+
+				delete(pWork->pMasterSet);
+				pWork->pMasterSet = nullptr;
+			}
+
+			// Makes as many of the evicted objects resident as fit in the space left in the budget
+			void PrefetchObjects(ManagedObject** ppObjects, UINT32 NumObjects)
+			{
+				if (NumObjects == 0)
+				{
+					return;
 				}
 
-				RESIDENCY_CHECK(CurrentAsyncWorkloadTail >= CurrentAsyncWorkloadHead);
+				DXGI_QUERY_VIDEO_MEMORY_INFO LocalMemory;
+				ZeroMemory(&LocalMemory, sizeof(LocalMemory));
+				GetCurrentBudget(&LocalMemory, DXGI_MEMORY_SEGMENT_GROUP_LOCAL);
+
+				DXGI_QUERY_VIDEO_MEMORY_INFO NonLocalMemory;
+				ZeroMemory(&NonLocalMemory, sizeof(NonLocalMemory));
+				GetCurrentBudget(&NonLocalMemory, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL);
+
+				INT64 AvailableSpace = INT64(LocalMemory.Budget + NonLocalMemory.Budget) - INT64(LocalMemory.CurrentUsage + NonLocalMemory.CurrentUsage);
 
-				const SIZE_T currentIndex = CurrentAsyncWorkloadTail % AsyncWorkQueueSize;
-				AsyncWorkQueue[currentIndex].pMasterSet = pMasterSet;
-				AsyncWorkQueue[currentIndex].FenceValueToSignal = FenceValueToSignal;
-				AsyncWorkQueue[currentIndex].SyncPointGeneration = SyncPointGeneration;
+				const INT64 CurrentTime = Internal::QueryTimestamp();
 
-				CurrentAsyncWorkloadTail++;
-				if (SetEvent(AsyncWorkEvent) == false)
+				ID3D12Pageable** ppUnderlying = new ID3D12Pageable*[NumObjects];
+				UINT32 NumToMakeResident = 0;
+				UINT64 BatchSize = 0;
+
+				for (UINT32 i = 0; i < NumObjects; i++)
 				{
-					return HRESULT_FROM_WIN32(GetLastError());
+					ManagedObject* pObject = ppObjects[i];
+					if (INT64(pObject->Size) > AvailableSpace)
+					{
+						continue;
+					}
+
+					AvailableSpace -= pObject->Size;
+					BatchSize += pObject->Size;
+
+					// Don't let the aged trimming take it away again before it gets used
+					pObject->LastUsedTimestamp = CurrentTime;
+					pObject->Prefetched = true;
+					Policy->MakeResident(pObject);
+
+					ppObjects[NumToMakeResident] = pObject;
+					ppUnderlying[NumToMakeResident++] = pObject->pUnderlying;
 				}
 
-				return S_OK;
+				if (NumToMakeResident)
+				{
+					if (SUCCEEDED(Device->MakeResident(NumToMakeResident, ppUnderlying)))
+					{
+						Statistics.PrefetchedObjects += NumToMakeResident;
+						Statistics.PrefetchedBytes += BatchSize;
+					}
+					else
+					{
+						// Leave them for the submission which uses them
+						for (UINT32 i = 0; i < NumToMakeResident; i++)
+						{
+							ppObjects[i]->Prefetched = false;
+							Policy->Evict(ppObjects[i]);
+						}
+					}
+				}
+
+				delete[](ppUnderlying);
+			}
+
+			// Objects used at a regular interval which were evicted are brought back shortly before their next expected use
+			void PrefetchPredictedObjects(UINT64 CurrentGeneration)
+			{
+				if (Policy->NumEvictedObjects == 0)
+				{
+					return;
+				}
+
+				ManagedObject** ppObjects = new ManagedObject*[Policy->NumEvictedObjects];
+				UINT32 NumObjects = 0;
+
+				LIST_ENTRY* pEntry = Policy->EvictedObjectListHead.Flink;
+				while (pEntry != &Policy->EvictedObjectListHead)
+				{
+					ManagedObject* pObject = CONTAINING_RECORD(pEntry, ManagedObject, ListEntry);
+					pEntry = pEntry->Flink;
+
+					if (pObject->ReuseInterval != 0 && pObject->ReuseInterval <= cMaxPredictedReuseInterval)
+					{
+						const UINT64 PredictedUse = pObject->LastGPUSyncPoint + pObject->ReuseInterval;
+						if (PredictedUse > CurrentGeneration && PredictedUse <= CurrentGeneration + MaxSoftwareQueueLatency)
+						{
+							ppObjects[NumObjects++] = pObject;
+						}
+					}
+				}
+
+				PrefetchObjects(ppObjects, NumObjects);
+				delete[](ppObjects);
 			}
 
-			AsyncWorkload* DequeueAsyncWork()
+			// The Enqueue and Dequeue Async Work functions are threadsafe as there is only 1 producer (serialised by ExecutionCS)
+			// and 1 consumer, if that changes Synchronisation will be required
+			HRESULT EnqueueAsyncWork(ResidencySet* pMasterSet, UINT64 FenceValueToSignal, UINT64 SyncPointGeneration, bool IsPrefetch)
 			{
-				if (CurrentAsyncWorkloadHead == CurrentAsyncWorkloadTail)
+				AsyncWorkload Work;
+				Work.pMasterSet = pMasterSet;
+				Work.FenceValueToSignal = FenceValueToSignal;
+				Work.SyncPointGeneration = SyncPointGeneration;
+				Work.IsPrefetch = IsPrefetch;
+
+				// We can't get too far ahead of the worker thread otherwise huge hitches occur
+				while (AsyncWorkQueue.TryPush(Work) == false)
 				{
-					return nullptr;
+					AsyncThreadWorkCompletionEvent.Wait();
 				}
 
-				const SIZE_T currentHead = CurrentAsyncWorkloadHead % AsyncWorkQueueSize;
-				AsyncWorkload* pWork = &AsyncWorkQueue[currentHead];
+				return AsyncWorkEvent.Set();
+			}
 
-				CurrentAsyncWorkloadHead++;
-				return pWork;
+			bool DequeueAsyncWork(AsyncWorkload* pWork)
+			{
+				return AsyncWorkQueue.TryPop(*pWork);
 			}
 
 			void GetCurrentBudget(DXGI_QUERY_VIDEO_MEMORY_INFO* InfoOut, DXGI_MEMORY_SEGMENT_GROUP Segment)
@@ -1335,7 +2634,7 @@ namespace D3DX12Residency
 					}
 					else
 					{
-						pPoint->WaitForCompletion(CompletionEvent);
+						pPoint->WaitForCompletion(&CompletionEvent);
 						Internal::RemoveHeadList(&InFlightSyncPointsHead);
 						delete(pPoint);
 						return;
@@ -1374,13 +2673,24 @@ namespace D3DX12Residency
 			LIST_ENTRY InFlightSyncPointsHead;
 			UINT64 CurrentSyncPointGeneration;
 
-			HANDLE CompletionEvent;
-			HANDLE AsyncThreadWorkCompletionEvent;
+			Internal::Event CompletionEvent;
+			Internal::Event AsyncThreadWorkCompletionEvent;
 
 			ID3D12Device* Device;
 			UINT NodeMask;
 			IDXGIAdapter3* Adapter;
-			Internal::LRUCache LRU;
+			EvictionPolicy* Policy;
+			bool OwnsPolicy;
+
+			FILE* pTraceFile;
+			INT64 TraceStartTime;
+			UINT64 TraceLocalBudget;
+			UINT64 TraceNonLocalBudget;
+
+			ResidencyStatistics Statistics;
+			bool PredictivePrefetch;
+			// Objects used less often than every this many submissions aren't worth predicting
+			const UINT64 cMaxPredictedReuseInterval;
 
 			Internal::CriticalSection Mutex;
 
@@ -1412,7 +2722,20 @@ namespace D3DX12Residency
 
 		FORCEINLINE HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeMask, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency)
 		{
-			return Manager.Initialize(ParentDevice, DeviceNodeMask, ParentAdapter, MaxLatency);
+			return Manager.Initialize(ParentDevice, DeviceNodeMask, ParentAdapter, MaxLatency, nullptr);
+		}
+
+		// The policy is owned by the app and must outlive the manager
+		FORCEINLINE HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeMask, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency, EvictionPolicy* pPolicy)
+		{
+			return Manager.Initialize(ParentDevice, DeviceNodeMask, ParentAdapter, MaxLatency, pPolicy);
+		}
+
+		FORCEINLINE HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeMask, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency, EVICTION_POLICY Policy)
+		{
+			HRESULT hr = Manager.Initialize(ParentDevice, DeviceNodeMask, ParentAdapter, MaxLatency, Internal::CreateEvictionPolicy(Policy));
+			Manager.TakePolicyOwnership();
+			return hr;
 		}
 
 		FORCEINLINE void Destroy()
@@ -1436,6 +2759,27 @@ namespace D3DX12Residency
 			return Manager.ExecuteCommandLists(Queue, CommandLists, ResidencySets, Count);
 		}
 
+		// Declare the residency sets of upcoming work (e.g. the next frame) so that they can be paged in early
+		FORCEINLINE HRESULT Prefetch(ResidencySet** ResidencySets, UINT32 Count)
+		{
+			return Manager.Prefetch(ResidencySets, Count);
+		}
+
+		FORCEINLINE void SetPredictivePrefetch(bool Enable)
+		{
+			Manager.SetPredictivePrefetch(Enable);
+		}
+
+		FORCEINLINE void GetStatistics(ResidencyStatistics* pStatistics)
+		{
+			Manager.GetStatistics(pStatistics);
+		}
+
+		FORCEINLINE void SetTraceFile(FILE* pFile)
+		{
+			Manager.SetTraceFile(pFile);
+		}
+
 		FORCEINLINE ResidencySet* CreateResidencySet()
 		{
 			ResidencySet* pSet = new ResidencySet();
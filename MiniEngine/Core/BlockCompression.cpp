@@ -0,0 +1,912 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "BlockCompression.h"
+#include "JobSystem.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	enum BlockFormat { kUnsupported, kBC1, kBC3, kBC4, kBC5, kBC7 };
+
+	BlockFormat GetBlockFormat( DXGI_FORMAT Format )
+	{
+		switch (Format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return kBC1;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return kBC3;
+		case DXGI_FORMAT_BC4_UNORM:
+			return kBC4;
+		case DXGI_FORMAT_BC5_UNORM:
+			return kBC5;
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return kBC7;
+		default:
+			return kUnsupported;
+		}
+	}
+
+	// The 16 pixels of a block with one register of four pixels per channel and row
+	struct BlockChannels
+	{
+		__m128 C[4][4];		// [Channel][Row]
+	};
+
+	void LoadBlock( const uint32_t Pixels[16], BlockChannels& Block )
+	{
+		const __m128i ByteMask = _mm_set1_epi32(0xFF);
+
+		for (int Row = 0; Row < 4; ++Row)
+		{
+			__m128i P = _mm_loadu_si128((const __m128i*)Pixels + Row);
+			Block.C[0][Row] = _mm_cvtepi32_ps(_mm_and_si128(P, ByteMask));
+			Block.C[1][Row] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(P, 8), ByteMask));
+			Block.C[2][Row] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(P, 16), ByteMask));
+			Block.C[3][Row] = _mm_cvtepi32_ps(_mm_srli_epi32(P, 24));
+		}
+	}
+
+	inline float HorizontalSum( __m128 V )
+	{
+		__m128 Swapped = _mm_shuffle_ps(V, V, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 Sums = _mm_add_ps(V, Swapped);
+		return _mm_cvtss_f32(_mm_add_ss(Sums, _mm_movehl_ps(Swapped, Sums)));
+	}
+
+	inline float HorizontalMin( __m128 V )
+	{
+		V = _mm_min_ps(V, _mm_shuffle_ps(V, V, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_min_ss(V, _mm_movehl_ps(V, V)));
+	}
+
+	inline float HorizontalMax( __m128 V )
+	{
+		V = _mm_max_ps(V, _mm_shuffle_ps(V, V, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_max_ss(V, _mm_movehl_ps(V, V)));
+	}
+
+	// The projection of each pixel onto Axis, one register per row
+	inline void Project( const BlockChannels& Block, int NumChannels, const float Axis[4], float Offset, __m128 Dots[4] )
+	{
+		for (int Row = 0; Row < 4; ++Row)
+		{
+			__m128 Dot = _mm_set1_ps(Offset);
+			for (int c = 0; c < NumChannels; ++c)
+				Dot = _mm_add_ps(Dot, _mm_mul_ps(Block.C[c][Row], _mm_set1_ps(Axis[c])));
+			Dots[Row] = Dot;
+		}
+	}
+
+	// Find the mean of the block and the axis along which it varies most, by power iteration on the covariance
+	// matrix.  Returns the extent of the block along the (unit length) axis, relative to the mean.
+	void FindPrincipalAxis( const BlockChannels& Block, int NumChannels, float Mean[4], float Axis[4],
+		float& MinT, float& MaxT )
+	{
+		__m128 Centered[4][4];
+		for (int c = 0; c < NumChannels; ++c)
+		{
+			__m128 Sum = _mm_add_ps(_mm_add_ps(Block.C[c][0], Block.C[c][1]), _mm_add_ps(Block.C[c][2], Block.C[c][3]));
+			Mean[c] = HorizontalSum(Sum) / 16.0f;
+
+			for (int Row = 0; Row < 4; ++Row)
+				Centered[c][Row] = _mm_sub_ps(Block.C[c][Row], _mm_set1_ps(Mean[c]));
+		}
+
+		float Covariance[4][4];
+		for (int c = 0; c < NumChannels; ++c)
+		{
+			for (int d = c; d < NumChannels; ++d)
+			{
+				__m128 Sum = _mm_mul_ps(Centered[c][0], Centered[d][0]);
+				for (int Row = 1; Row < 4; ++Row)
+					Sum = _mm_add_ps(Sum, _mm_mul_ps(Centered[c][Row], Centered[d][Row]));
+				Covariance[c][d] = Covariance[d][c] = HorizontalSum(Sum);
+			}
+		}
+
+		// Starting from the row of the channel with the most variance keeps the start off an orthogonal axis
+		int Largest = 0;
+		for (int c = 1; c < NumChannels; ++c)
+		{
+			if (Covariance[c][c] > Covariance[Largest][Largest])
+				Largest = c;
+		}
+
+		for (int c = 0; c < NumChannels; ++c)
+			Axis[c] = Covariance[Largest][c];
+
+		for (int Iteration = 0; Iteration < 8; ++Iteration)
+		{
+			float Next[4] = {};
+			float MaxComponent = 0.0f;
+			for (int c = 0; c < NumChannels; ++c)
+			{
+				for (int d = 0; d < NumChannels; ++d)
+					Next[c] += Covariance[c][d] * Axis[d];
+				MaxComponent = std::max(MaxComponent, fabsf(Next[c]));
+			}
+
+			if (MaxComponent == 0.0f)
+				break;
+
+			for (int c = 0; c < NumChannels; ++c)
+				Axis[c] = Next[c] / MaxComponent;
+		}
+
+		float LengthSq = 0.0f;
+		for (int c = 0; c < NumChannels; ++c)
+			LengthSq += Axis[c] * Axis[c];
+
+		// A solid block has no axis, so any will do
+		if (LengthSq == 0.0f)
+		{
+			for (int c = 0; c < NumChannels; ++c)
+				Axis[c] = 1.0f;
+			LengthSq = (float)NumChannels;
+		}
+
+		float InvLength = 1.0f / sqrtf(LengthSq);
+		float Offset = 0.0f;
+		for (int c = 0; c < NumChannels; ++c)
+		{
+			Axis[c] *= InvLength;
+			Offset -= Axis[c] * Mean[c];
+		}
+
+		__m128 Dots[4];
+		Project(Block, NumChannels, Axis, Offset, Dots);
+		MinT = HorizontalMin(_mm_min_ps(_mm_min_ps(Dots[0], Dots[1]), _mm_min_ps(Dots[2], Dots[3])));
+		MaxT = HorizontalMax(_mm_max_ps(_mm_max_ps(Dots[0], Dots[1]), _mm_max_ps(Dots[2], Dots[3])));
+	}
+
+	// Round each of four values to the nearest integer in [0, MaxStep] and store them
+	inline void StoreSteps( __m128 T, float MaxStep, int32_t Steps[4] )
+	{
+		T = _mm_min_ps(_mm_max_ps(T, _mm_setzero_ps()), _mm_set1_ps(MaxStep));
+		_mm_storeu_si128((__m128i*)Steps, _mm_cvtps_epi32(T));
+	}
+
+	//
+	// BC1 color blocks, also used by BC3
+	//
+
+	inline float Clamp255( float Value )
+	{
+		return std::min(std::max(Value, 0.0f), 255.0f);
+	}
+
+	inline uint16_t Quantize565( const float Color[3] )
+	{
+		int R = (int)(Clamp255(Color[0]) * (31.0f / 255.0f) + 0.5f);
+		int G = (int)(Clamp255(Color[1]) * (63.0f / 255.0f) + 0.5f);
+		int B = (int)(Clamp255(Color[2]) * (31.0f / 255.0f) + 0.5f);
+		return (uint16_t)(R << 11 | G << 5 | B);
+	}
+
+	inline void Expand565( uint16_t Color, int Out[3] )
+	{
+		int R = Color >> 11 & 31;
+		int G = Color >> 5 & 63;
+		int B = Color & 31;
+		Out[0] = R << 3 | R >> 2;
+		Out[1] = G << 2 | G >> 4;
+		Out[2] = B << 3 | B >> 2;
+	}
+
+	// Palette entries in index order.  Entries 2 and 3 lie a third and two thirds of the way from 0 to 1.
+	void BuildColorPalette( uint16_t C0, uint16_t C1, int Palette[4][3] )
+	{
+		Expand565(C0, Palette[0]);
+		Expand565(C1, Palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			Palette[2][c] = (2 * Palette[0][c] + Palette[1][c]) / 3;
+			Palette[3][c] = (Palette[0][c] + 2 * Palette[1][c]) / 3;
+		}
+	}
+
+	// Choose each pixel's index by projecting it onto the line between the endpoints.  Two bits per pixel.
+	uint32_t FindColorIndices( const BlockChannels& Block, const int P0[3], const int P1[3] )
+	{
+		float Dir[3] = { (float)(P1[0] - P0[0]), (float)(P1[1] - P0[1]), (float)(P1[2] - P0[2]) };
+		float LengthSq = Dir[0] * Dir[0] + Dir[1] * Dir[1] + Dir[2] * Dir[2];
+		if (LengthSq == 0.0f)
+			return 0;
+
+		// Scaled so that the endpoints project to 0 and 3
+		float Scale = 3.0f / LengthSq;
+		float Axis[3] = { Dir[0] * Scale, Dir[1] * Scale, Dir[2] * Scale };
+		float Offset = -(P0[0] * Axis[0] + P0[1] * Axis[1] + P0[2] * Axis[2]);
+
+		__m128 Dots[4];
+		Project(Block, 3, Axis, Offset, Dots);
+
+		static const uint32_t kStepToIndex[4] = { 0, 2, 3, 1 };
+
+		uint32_t Indices = 0;
+		for (int Row = 0; Row < 4; ++Row)
+		{
+			int32_t Steps[4];
+			StoreSteps(Dots[Row], 3.0f, Steps);
+			for (int i = 0; i < 4; ++i)
+				Indices |= kStepToIndex[Steps[i]] << (2 * (Row * 4 + i));
+		}
+
+		return Indices;
+	}
+
+	int ColorError( const uint32_t Pixels[16], const int Palette[4][3], uint32_t Indices )
+	{
+		int Error = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			const int* Entry = Palette[Indices >> (2 * i) & 3];
+			for (int c = 0; c < 3; ++c)
+			{
+				int Diff = (int)(Pixels[i] >> (8 * c) & 0xFF) - Entry[c];
+				Error += Diff * Diff;
+			}
+		}
+		return Error;
+	}
+
+	// Quantize a pair of endpoints, order them for four-color mode and pick indices.  Returns the squared error.
+	int FitColorEndpoints( const BlockChannels& Block, const uint32_t Pixels[16], const float E0[3], const float E1[3],
+		uint16_t& C0, uint16_t& C1, uint32_t& Indices )
+	{
+		C0 = Quantize565(E0);
+		C1 = Quantize565(E1);
+
+		// BC1 reads C0 <= C1 as three colors and transparent black
+		if (C0 < C1)
+			std::swap(C0, C1);
+
+		int Palette[4][3];
+		BuildColorPalette(C0, C1, Palette);
+
+		Indices = (C0 == C1) ? 0 : FindColorIndices(Block, Palette[0], Palette[1]);
+		return ColorError(Pixels, Palette, Indices);
+	}
+
+	// Solve for the endpoints that minimize the squared error of the block, holding its indices fixed
+	bool RefineColorEndpoints( const uint32_t Pixels[16], uint32_t Indices, float E0[3], float E1[3] )
+	{
+		static const float kWeight1[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float AA = 0.0f, BB = 0.0f, AB = 0.0f;
+		float AX[3] = {}, BX[3] = {};
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float B = kWeight1[Indices >> (2 * i) & 3];
+			float A = 1.0f - B;
+			AA += A * A;
+			BB += B * B;
+			AB += A * B;
+
+			for (int c = 0; c < 3; ++c)
+			{
+				float X = (float)(Pixels[i] >> (8 * c) & 0xFF);
+				AX[c] += A * X;
+				BX[c] += B * X;
+			}
+		}
+
+		float Determinant = AA * BB - AB * AB;
+		if (fabsf(Determinant) < 1e-6f)
+			return false;
+
+		float InvDeterminant = 1.0f / Determinant;
+		for (int c = 0; c < 3; ++c)
+		{
+			E0[c] = (AX[c] * BB - BX[c] * AB) * InvDeterminant;
+			E1[c] = (BX[c] * AA - AX[c] * AB) * InvDeterminant;
+		}
+
+		return true;
+	}
+
+	void EncodeColorBlock( const uint32_t Pixels[16], uint8_t Block[8] )
+	{
+		BlockChannels Channels;
+		LoadBlock(Pixels, Channels);
+
+		float Mean[4], Axis[4], MinT, MaxT;
+		FindPrincipalAxis(Channels, 3, Mean, Axis, MinT, MaxT);
+
+		// Pull the endpoints in a little.  Matching the extremes exactly costs the pixels in between more.
+		float Inset = (MaxT - MinT) / 16.0f;
+		float E0[3], E1[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			E0[c] = Mean[c] + Axis[c] * (MaxT - Inset);
+			E1[c] = Mean[c] + Axis[c] * (MinT + Inset);
+		}
+
+		uint16_t C0, C1;
+		uint32_t Indices;
+		int Error = FitColorEndpoints(Channels, Pixels, E0, E1, C0, C1, Indices);
+
+		if (Error > 0 && RefineColorEndpoints(Pixels, Indices, E0, E1))
+		{
+			uint16_t RefinedC0, RefinedC1;
+			uint32_t RefinedIndices;
+			if (FitColorEndpoints(Channels, Pixels, E0, E1, RefinedC0, RefinedC1, RefinedIndices) < Error)
+			{
+				C0 = RefinedC0;
+				C1 = RefinedC1;
+				Indices = RefinedIndices;
+			}
+		}
+
+		Block[0] = (uint8_t)C0;
+		Block[1] = (uint8_t)(C0 >> 8);
+		Block[2] = (uint8_t)C1;
+		Block[3] = (uint8_t)(C1 >> 8);
+		for (int i = 0; i < 4; ++i)
+			Block[4 + i] = (uint8_t)(Indices >> (8 * i));
+	}
+
+	void DecodeColorBlock( const uint8_t Block[8], uint32_t Pixels[16], bool AllowTransparent )
+	{
+		uint16_t C0 = (uint16_t)(Block[0] | Block[1] << 8);
+		uint16_t C1 = (uint16_t)(Block[2] | Block[3] << 8);
+		uint32_t Indices = Block[4] | Block[5] << 8 | Block[6] << 16 | (uint32_t)Block[7] << 24;
+
+		int Palette[4][3];
+		BuildColorPalette(C0, C1, Palette);
+
+		uint32_t Colors[4];
+		for (int i = 0; i < 4; ++i)
+			Colors[i] = Palette[i][0] | Palette[i][1] << 8 | Palette[i][2] << 16 | 0xFF000000;
+
+		if (C0 <= C1 && AllowTransparent)
+		{
+			Colors[2] = ((Palette[0][0] + Palette[1][0]) / 2) | ((Palette[0][1] + Palette[1][1]) / 2) << 8 |
+				((Palette[0][2] + Palette[1][2]) / 2) << 16 | 0xFF000000;
+			Colors[3] = 0;
+		}
+
+		for (int i = 0; i < 16; ++i)
+			Pixels[i] = Colors[Indices >> (2 * i) & 3];
+	}
+
+	//
+	// BC7 mode 6
+	//
+
+	const int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	class BitWriter
+	{
+	public:
+		BitWriter() : m_Low(0), m_High(0), m_Position(0) {}
+
+		void Write( uint64_t Value, uint32_t NumBits )
+		{
+			if (m_Position < 64)
+			{
+				m_Low |= Value << m_Position;
+				if (m_Position + NumBits > 64)
+					m_High |= Value >> (64 - m_Position);
+			}
+			else
+			{
+				m_High |= Value << (m_Position - 64);
+			}
+			m_Position += NumBits;
+		}
+
+		void Store( uint8_t Block[16] ) const
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				Block[i] = (uint8_t)(m_Low >> (8 * i));
+				Block[8 + i] = (uint8_t)(m_High >> (8 * i));
+			}
+		}
+
+	private:
+		uint64_t m_Low;
+		uint64_t m_High;
+		uint32_t m_Position;
+	};
+
+	class BitReader
+	{
+	public:
+		BitReader( const uint8_t Block[16] ) : m_Low(0), m_High(0), m_Position(0)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				m_Low |= (uint64_t)Block[i] << (8 * i);
+				m_High |= (uint64_t)Block[8 + i] << (8 * i);
+			}
+		}
+
+		uint32_t Read( uint32_t NumBits )
+		{
+			uint64_t Value;
+			if (m_Position < 64)
+			{
+				Value = m_Low >> m_Position;
+				if (m_Position + NumBits > 64)
+					Value |= m_High << (64 - m_Position);
+			}
+			else
+			{
+				Value = m_High >> (m_Position - 64);
+			}
+			m_Position += NumBits;
+			return (uint32_t)(Value & ((1ull << NumBits) - 1));
+		}
+
+	private:
+		uint64_t m_Low;
+		uint64_t m_High;
+		uint32_t m_Position;
+	};
+
+	// Mode 6 stores seven bits per channel and one p-bit, shared by the channels, as the lowest bit of each
+	void QuantizeBC7Endpoint( const float Endpoint[4], int Quantized[4], int& PBit )
+	{
+		float BestError = FLT_MAX;
+
+		for (int P = 0; P < 2; ++P)
+		{
+			int Candidate[4];
+			float Error = 0.0f;
+			for (int c = 0; c < 4; ++c)
+			{
+				Candidate[c] = std::min(std::max((int)floorf((Endpoint[c] - P) * 0.5f + 0.5f), 0), 127);
+				float Diff = (float)(Candidate[c] * 2 + P) - Endpoint[c];
+				Error += Diff * Diff;
+			}
+
+			if (Error < BestError)
+			{
+				BestError = Error;
+				PBit = P;
+				for (int c = 0; c < 4; ++c)
+					Quantized[c] = Candidate[c];
+			}
+		}
+	}
+
+	void FindBC7Indices( const BlockChannels& Block, const int E0[4], const int E1[4], uint32_t Indices[16] )
+	{
+		float Dir[4];
+		float LengthSq = 0.0f;
+		for (int c = 0; c < 4; ++c)
+		{
+			Dir[c] = (float)(E1[c] - E0[c]);
+			LengthSq += Dir[c] * Dir[c];
+		}
+
+		if (LengthSq == 0.0f)
+		{
+			for (int i = 0; i < 16; ++i)
+				Indices[i] = 0;
+			return;
+		}
+
+		// Scaled so that the endpoints project to weights 0 and 64
+		float Scale = 64.0f / LengthSq;
+		float Offset = 0.0f;
+		for (int c = 0; c < 4; ++c)
+		{
+			Dir[c] *= Scale;
+			Offset -= E0[c] * Dir[c];
+		}
+
+		__m128 Dots[4];
+		Project(Block, 4, Dir, Offset, Dots);
+
+		for (int Row = 0; Row < 4; ++Row)
+		{
+			// The weights are nearly even, so the nearest even step is at most one away from the nearest weight
+			int32_t Steps[4];
+			StoreSteps(_mm_mul_ps(Dots[Row], _mm_set1_ps(15.0f / 64.0f)), 15.0f, Steps);
+
+			float Weights[4];
+			_mm_storeu_ps(Weights, _mm_min_ps(_mm_max_ps(Dots[Row], _mm_setzero_ps()), _mm_set1_ps(64.0f)));
+
+			for (int i = 0; i < 4; ++i)
+			{
+				int Index = Steps[i];
+				float Weight = Weights[i];
+				if (Index < 15 && fabsf(Weight - kBC7Weights[Index + 1]) < fabsf(Weight - kBC7Weights[Index]))
+					++Index;
+				else if (Index > 0 && fabsf(Weight - kBC7Weights[Index - 1]) < fabsf(Weight - kBC7Weights[Index]))
+					--Index;
+				Indices[Row * 4 + i] = (uint32_t)Index;
+			}
+		}
+	}
+
+	//
+	// BC4 single channel blocks, also used by BC3 and BC5
+	//
+
+	inline uint8_t HorizontalMinU8( __m128i V )
+	{
+		V = _mm_min_epu8(V, _mm_srli_si128(V, 8));
+		V = _mm_min_epu8(V, _mm_srli_si128(V, 4));
+		V = _mm_min_epu8(V, _mm_srli_si128(V, 2));
+		V = _mm_min_epu8(V, _mm_srli_si128(V, 1));
+		return (uint8_t)_mm_cvtsi128_si32(V);
+	}
+
+	inline uint8_t HorizontalMaxU8( __m128i V )
+	{
+		V = _mm_max_epu8(V, _mm_srli_si128(V, 8));
+		V = _mm_max_epu8(V, _mm_srli_si128(V, 4));
+		V = _mm_max_epu8(V, _mm_srli_si128(V, 2));
+		V = _mm_max_epu8(V, _mm_srli_si128(V, 1));
+		return (uint8_t)_mm_cvtsi128_si32(V);
+	}
+
+	inline void GatherChannel( const uint32_t Pixels[16], int Channel, uint8_t Values[16] )
+	{
+		for (int i = 0; i < 16; ++i)
+			Values[i] = (uint8_t)(Pixels[i] >> (8 * Channel));
+	}
+}
+
+void BlockCompression::EncodeBC1( const uint32_t Pixels[16], uint8_t Block[8] )
+{
+	EncodeColorBlock(Pixels, Block);
+}
+
+void BlockCompression::EncodeBC3( const uint32_t Pixels[16], uint8_t Block[16] )
+{
+	uint8_t Alpha[16];
+	GatherChannel(Pixels, 3, Alpha);
+	EncodeBC4(Alpha, Block);
+	EncodeColorBlock(Pixels, Block + 8);
+}
+
+void BlockCompression::EncodeBC4( const uint8_t Values[16], uint8_t Block[8] )
+{
+	__m128i V = _mm_loadu_si128((const __m128i*)Values);
+	uint8_t Low = HorizontalMinU8(V);
+	uint8_t High = HorizontalMaxU8(V);
+
+	// With the larger endpoint first, the six entries between them step down in sevenths
+	Block[0] = High;
+	Block[1] = Low;
+
+	uint64_t Indices = 0;
+
+	if (High > Low)
+	{
+		static const uint64_t kStepToIndex[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Low16 = _mm_unpacklo_epi8(V, Zero);
+		const __m128i High16 = _mm_unpackhi_epi8(V, Zero);
+		const __m128i Words[4] =
+		{
+			_mm_unpacklo_epi16(Low16, Zero), _mm_unpackhi_epi16(Low16, Zero),
+			_mm_unpacklo_epi16(High16, Zero), _mm_unpackhi_epi16(High16, Zero)
+		};
+
+		const __m128 Top = _mm_set1_ps((float)High);
+		const __m128 Scale = _mm_set1_ps(7.0f / (High - Low));
+
+		for (int Row = 0; Row < 4; ++Row)
+		{
+			int32_t Steps[4];
+			StoreSteps(_mm_mul_ps(_mm_sub_ps(Top, _mm_cvtepi32_ps(Words[Row])), Scale), 7.0f, Steps);
+			for (int i = 0; i < 4; ++i)
+				Indices |= kStepToIndex[Steps[i]] << (3 * (Row * 4 + i));
+		}
+	}
+
+	for (int i = 0; i < 6; ++i)
+		Block[2 + i] = (uint8_t)(Indices >> (8 * i));
+}
+
+void BlockCompression::EncodeBC5( const uint8_t Red[16], const uint8_t Green[16], uint8_t Block[16] )
+{
+	EncodeBC4(Red, Block);
+	EncodeBC4(Green, Block + 8);
+}
+
+void BlockCompression::EncodeBC7( const uint32_t Pixels[16], uint8_t Block[16] )
+{
+	BlockChannels Channels;
+	LoadBlock(Pixels, Channels);
+
+	float Mean[4], Axis[4], MinT, MaxT;
+	FindPrincipalAxis(Channels, 4, Mean, Axis, MinT, MaxT);
+
+	float E0[4], E1[4];
+	for (int c = 0; c < 4; ++c)
+	{
+		E0[c] = Mean[c] + Axis[c] * MinT;
+		E1[c] = Mean[c] + Axis[c] * MaxT;
+	}
+
+	int Q0[4], Q1[4], P0, P1;
+	QuantizeBC7Endpoint(E0, Q0, P0);
+	QuantizeBC7Endpoint(E1, Q1, P1);
+
+	int Endpoint0[4], Endpoint1[4];
+	for (int c = 0; c < 4; ++c)
+	{
+		Endpoint0[c] = Q0[c] << 1 | P0;
+		Endpoint1[c] = Q1[c] << 1 | P1;
+	}
+
+	uint32_t Indices[16];
+	FindBC7Indices(Channels, Endpoint0, Endpoint1, Indices);
+
+	// Only three bits of the first index are stored, so its top bit must be zero.  Swapping the endpoints
+	// mirrors the indices, and the weights are symmetric.
+	if (Indices[0] & 8)
+	{
+		std::swap(Q0, Q1);
+		std::swap(P0, P1);
+		for (int i = 0; i < 16; ++i)
+			Indices[i] = 15 - Indices[i];
+	}
+
+	BitWriter Writer;
+	Writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; ++c)
+	{
+		Writer.Write(Q0[c], 7);
+		Writer.Write(Q1[c], 7);
+	}
+	Writer.Write(P0, 1);
+	Writer.Write(P1, 1);
+	Writer.Write(Indices[0], 3);
+	for (int i = 1; i < 16; ++i)
+		Writer.Write(Indices[i], 4);
+	Writer.Store(Block);
+}
+
+void BlockCompression::DecodeBC1( const uint8_t Block[8], uint32_t Pixels[16] )
+{
+	DecodeColorBlock(Block, Pixels, true);
+}
+
+void BlockCompression::DecodeBC3( const uint8_t Block[16], uint32_t Pixels[16] )
+{
+	uint8_t Alpha[16];
+	DecodeBC4(Block, Alpha);
+	DecodeColorBlock(Block + 8, Pixels, false);
+
+	for (int i = 0; i < 16; ++i)
+		Pixels[i] = (Pixels[i] & 0x00FFFFFF) | (uint32_t)Alpha[i] << 24;
+}
+
+void BlockCompression::DecodeBC4( const uint8_t Block[8], uint8_t Values[16] )
+{
+	int R0 = Block[0];
+	int R1 = Block[1];
+
+	uint8_t Palette[8];
+	Palette[0] = (uint8_t)R0;
+	Palette[1] = (uint8_t)R1;
+
+	if (R0 > R1)
+	{
+		for (int i = 2; i < 8; ++i)
+			Palette[i] = (uint8_t)(((8 - i) * R0 + (i - 1) * R1) / 7);
+	}
+	else
+	{
+		for (int i = 2; i < 6; ++i)
+			Palette[i] = (uint8_t)(((6 - i) * R0 + (i - 1) * R1) / 5);
+		Palette[6] = 0;
+		Palette[7] = 255;
+	}
+
+	uint64_t Indices = 0;
+	for (int i = 0; i < 6; ++i)
+		Indices |= (uint64_t)Block[2 + i] << (8 * i);
+
+	for (int i = 0; i < 16; ++i)
+		Values[i] = Palette[Indices >> (3 * i) & 7];
+}
+
+void BlockCompression::DecodeBC5( const uint8_t Block[16], uint8_t Red[16], uint8_t Green[16] )
+{
+	DecodeBC4(Block, Red);
+	DecodeBC4(Block + 8, Green);
+}
+
+bool BlockCompression::DecodeBC7( const uint8_t Block[16], uint32_t Pixels[16] )
+{
+	BitReader Reader(Block);
+
+	if (Reader.Read(7) != 1 << 6)
+	{
+		for (int i = 0; i < 16; ++i)
+			Pixels[i] = 0;
+		return false;
+	}
+
+	int E0[4], E1[4];
+	for (int c = 0; c < 4; ++c)
+	{
+		E0[c] = Reader.Read(7);
+		E1[c] = Reader.Read(7);
+	}
+
+	int P0 = Reader.Read(1);
+	int P1 = Reader.Read(1);
+	for (int c = 0; c < 4; ++c)
+	{
+		E0[c] = E0[c] << 1 | P0;
+		E1[c] = E1[c] << 1 | P1;
+	}
+
+	for (int i = 0; i < 16; ++i)
+	{
+		int Weight = kBC7Weights[Reader.Read(i == 0 ? 3 : 4)];
+
+		uint32_t Pixel = 0;
+		for (int c = 0; c < 4; ++c)
+			Pixel |= (uint32_t)(((64 - Weight) * E0[c] + Weight * E1[c] + 32) >> 6) << (8 * c);
+		Pixels[i] = Pixel;
+	}
+
+	return true;
+}
+
+bool BlockCompression::IsSupported( DXGI_FORMAT Format )
+{
+	return GetBlockFormat(Format) != kUnsupported;
+}
+
+size_t BlockCompression::GetBlockSize( DXGI_FORMAT Format )
+{
+	switch (GetBlockFormat(Format))
+	{
+	case kBC1:
+	case kBC4:
+		return 8;
+	case kBC3:
+	case kBC5:
+	case kBC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t BlockCompression::GetCompressedSize( DXGI_FORMAT Format, uint32_t Width, uint32_t Height )
+{
+	return (size_t)((Width + 3) / 4) * ((Height + 3) / 4) * GetBlockSize(Format);
+}
+
+void BlockCompression::CompressImage( DXGI_FORMAT Format, const uint32_t* Pixels, size_t RowPitch,
+	uint32_t Width, uint32_t Height, uint8_t* Dest )
+{
+	const BlockFormat Kind = GetBlockFormat(Format);
+	ASSERT(Kind != kUnsupported, "Unsupported block compressed format");
+	ASSERT(Width > 0 && Height > 0);
+
+	const uint32_t BlocksWide = (Width + 3) / 4;
+	const uint32_t BlocksHigh = (Height + 3) / 4;
+	const size_t BlockSize = GetBlockSize(Format);
+
+	JobSystem::ParallelFor(BlocksHigh, 0, [&]( size_t Begin, size_t End )
+	{
+		uint32_t Block[16];
+		uint8_t Red[16], Green[16];
+
+		for (size_t BlockY = Begin; BlockY < End; ++BlockY)
+		{
+			uint8_t* Out = Dest + BlockY * BlocksWide * BlockSize;
+
+			for (uint32_t BlockX = 0; BlockX < BlocksWide; ++BlockX, Out += BlockSize)
+			{
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					size_t SourceY = std::min<size_t>(BlockY * 4 + y, Height - 1);
+					const uint32_t* Row = (const uint32_t*)((const uint8_t*)Pixels + SourceY * RowPitch);
+					for (uint32_t x = 0; x < 4; ++x)
+						Block[y * 4 + x] = Row[std::min(BlockX * 4 + x, Width - 1)];
+				}
+
+				switch (Kind)
+				{
+				case kBC1:
+					EncodeBC1(Block, Out);
+					break;
+				case kBC3:
+					EncodeBC3(Block, Out);
+					break;
+				case kBC4:
+					GatherChannel(Block, 0, Red);
+					EncodeBC4(Red, Out);
+					break;
+				case kBC5:
+					GatherChannel(Block, 0, Red);
+					GatherChannel(Block, 1, Green);
+					EncodeBC5(Red, Green, Out);
+					break;
+				case kBC7:
+					EncodeBC7(Block, Out);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	});
+}
+
+bool BlockCompression::DecompressImage( DXGI_FORMAT Format, const uint8_t* Blocks, uint32_t Width, uint32_t Height,
+	uint32_t* Pixels, size_t RowPitch )
+{
+	const BlockFormat Kind = GetBlockFormat(Format);
+	ASSERT(Kind != kUnsupported, "Unsupported block compressed format");
+
+	const uint32_t BlocksWide = (Width + 3) / 4;
+	const uint32_t BlocksHigh = (Height + 3) / 4;
+	const size_t BlockSize = GetBlockSize(Format);
+
+	bool AllDecoded = true;
+	uint32_t Block[16];
+	uint8_t Red[16], Green[16];
+
+	for (uint32_t BlockY = 0; BlockY < BlocksHigh; ++BlockY)
+	{
+		for (uint32_t BlockX = 0; BlockX < BlocksWide; ++BlockX, Blocks += BlockSize)
+		{
+			switch (Kind)
+			{
+			case kBC1:
+				DecodeBC1(Blocks, Block);
+				break;
+			case kBC3:
+				DecodeBC3(Blocks, Block);
+				break;
+			case kBC4:
+				DecodeBC4(Blocks, Red);
+				for (int i = 0; i < 16; ++i)
+					Block[i] = Red[i] | 0xFF000000;
+				break;
+			case kBC5:
+				DecodeBC5(Blocks, Red, Green);
+				for (int i = 0; i < 16; ++i)
+					Block[i] = Red[i] | Green[i] << 8 | 0xFF000000;
+				break;
+			case kBC7:
+				AllDecoded = DecodeBC7(Blocks, Block) && AllDecoded;
+				break;
+			default:
+				break;
+			}
+
+			for (uint32_t y = 0; y < 4 && BlockY * 4 + y < Height; ++y)
+			{
+				uint32_t* Row = (uint32_t*)((uint8_t*)Pixels + (BlockY * 4 + y) * RowPitch);
+				for (uint32_t x = 0; x < 4 && BlockX * 4 + x < Width; ++x)
+					Row[BlockX * 4 + x] = Block[y * 4 + x];
+			}
+		}
+	}
+
+	return AllDecoded;
+}
@@ -0,0 +1,57 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  CPU encoders and decoders for the BC1, BC3, BC4, BC5 and BC7 block compressed formats.  The
+// encoders favor speed over the last decibel, since they run while textures load:  BC1 fits its endpoints to
+// the principal axis of the block's colors and then refines them once by least squares, BC4 spans the block's
+// range, and BC7 uses mode 6 alone (one subset, RGBA endpoints, 16 levels).  Index selection works on four pixels
+// at a time with SSE2.
+//
+// The decoders are for validating the encoders.  The BC7 decoder reads only mode 6, which is all the encoder
+// writes.
+
+#pragma once
+
+#include <cstdint>
+#include <dxgiformat.h>
+
+namespace BlockCompression
+{
+	// A block is 4x4 pixels in row order.  Pixels are RGBA8 with red in the low byte.  BC1 blocks are treated as
+	// opaque; use BC3 or BC7 for alpha.
+	void EncodeBC1( const uint32_t Pixels[16], uint8_t Block[8] );
+	void EncodeBC3( const uint32_t Pixels[16], uint8_t Block[16] );
+	void EncodeBC4( const uint8_t Values[16], uint8_t Block[8] );
+	void EncodeBC5( const uint8_t Red[16], const uint8_t Green[16], uint8_t Block[16] );
+	void EncodeBC7( const uint32_t Pixels[16], uint8_t Block[16] );
+
+	void DecodeBC1( const uint8_t Block[8], uint32_t Pixels[16] );
+	void DecodeBC3( const uint8_t Block[16], uint32_t Pixels[16] );
+	void DecodeBC4( const uint8_t Block[8], uint8_t Values[16] );
+	void DecodeBC5( const uint8_t Block[16], uint8_t Red[16], uint8_t Green[16] );
+
+	// Returns false, leaving the pixels transparent black, for blocks not encoded in mode 6
+	bool DecodeBC7( const uint8_t Block[16], uint32_t Pixels[16] );
+
+	// The BC1, BC3, BC4, BC5 and BC7 UNORM formats and their sRGB variants.  The encoders work on stored values,
+	// so sRGB data is compressed as it is.
+	bool IsSupported( DXGI_FORMAT Format );
+	size_t GetBlockSize( DXGI_FORMAT Format );
+	size_t GetCompressedSize( DXGI_FORMAT Format, uint32_t Width, uint32_t Height );
+
+	// Compress an RGBA8 image.  The last row and column are repeated to fill partial blocks at the edges.  BC4
+	// takes the red channel and BC5 red and green.  Rows of blocks are compressed in parallel by the job system
+	// when it is running, which is safe from inside a job too.  Dest must hold GetCompressedSize() bytes.
+	void CompressImage( DXGI_FORMAT Format, const uint32_t* Pixels, size_t RowPitch, uint32_t Width, uint32_t Height,
+		uint8_t* Dest );
+
+	// Expand to RGBA8 the way the GPU samples it:  BC4 gives (R, 0, 0, 255) and BC5 (R, G, 0, 255).  Returns false
+	// if a BC7 block uses a mode other than 6.
+	bool DecompressImage( DXGI_FORMAT Format, const uint8_t* Blocks, uint32_t Width, uint32_t Height,
+		uint32_t* Pixels, size_t RowPitch );
+}
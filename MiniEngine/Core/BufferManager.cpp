@@ -62,14 +62,9 @@ namespace Graphics
 	StructuredBuffer g_DoFFastQueue;
 	StructuredBuffer g_DoFFixupQueue;
 
-	ColorBuffer g_MotionPrepBuffer;
 	ColorBuffer g_LumaBuffer;
 	ColorBuffer g_TemporalBuffer[2];
-	ColorBuffer g_aBloomUAV1[2];	// 640x384 (1/3)
-	ColorBuffer g_aBloomUAV2[2];	// 320x192 (1/6)  
-	ColorBuffer g_aBloomUAV3[2];	// 160x96  (1/12)
-	ColorBuffer g_aBloomUAV4[2];	// 80x48   (1/24)
-	ColorBuffer g_aBloomUAV5[2];	// 40x24   (1/48)
+	ColorBuffer g_BloomBuffer;		// 640x384 (1/3)
 	ColorBuffer g_LumaLR;
 	ByteAddressBuffer g_Histogram;
 	StructuredBuffer g_FXAAWorkQueueH;
@@ -146,7 +141,8 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 						g_AOHighQuality4.Create( L"AO High Quality 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, esram );
 					esram.PopStack();	// End generating SSAO
 
-					g_ShadowBuffer.Create( L"Shadow Map", 2048, 2048 );//, esram );
+					// A 2x2 atlas of 2048x2048 shadow cascades
+					g_ShadowBuffer.Create( L"Shadow Map", 4096, 4096 );//, esram );
 
 				esram.PopStack();	// End Shading
 
@@ -172,7 +168,6 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 
 				esram.PushStack();	// Begin motion blur
 					g_VelocityBuffer.Create( L"Motion Vectors", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8G8_SNORM, esram );
-					g_MotionPrepBuffer.Create( L"Motion Blur Prep", bufferWidth1, bufferHeight1, 1, HDR_MOTION_FORMAT, esram );
 				esram.PopStack();	// End motion blur
 
 			esram.PopStack();	// End opaque geometry
@@ -187,19 +182,9 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 
 			esram.PushStack();	// Begin tone mapping
 				g_LumaLR.Create( L"Luma Buffer", kBloomWidth, kBloomHeight, 1, DXGI_FORMAT_R8_UINT, esram );
-				g_aBloomUAV1[1].Create( L"Bloom Buffer", kBloomWidth, kBloomHeight, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-
-				esram.PushStack();	// Begin generating bloom
-					g_aBloomUAV1[0].Create( L"Bloom Buffer 1a", kBloomWidth,    kBloomHeight,    1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV2[0].Create( L"Bloom Buffer 2a", kBloomWidth/2,  kBloomHeight/2,  1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV2[1].Create( L"Bloom Buffer 2b", kBloomWidth/2,  kBloomHeight/2,  1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV3[0].Create( L"Bloom Buffer 3a", kBloomWidth/4,  kBloomHeight/4,  1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV3[1].Create( L"Bloom Buffer 3b", kBloomWidth/4,  kBloomHeight/4,  1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV4[0].Create( L"Bloom Buffer 4a", kBloomWidth/8,  kBloomHeight/8,  1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV4[1].Create( L"Bloom Buffer 4b", kBloomWidth/8,  kBloomHeight/8,  1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV5[0].Create( L"Bloom Buffer 5a", kBloomWidth/16, kBloomHeight/16, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-					g_aBloomUAV5[1].Create( L"Bloom Buffer 5b", kBloomWidth/16, kBloomHeight/16, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-				esram.PopStack();	// End generating bloom
+				g_BloomBuffer.Create( L"Bloom Buffer", kBloomWidth, kBloomHeight, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
+
+				// The intermediate bloom buffers are transient textures of the bloom frame graph (see PostEffects)
 			esram.PopStack();	// End tone mapping
 
 			esram.PushStack();	// Begin antialiasing
@@ -271,20 +256,10 @@ void Graphics::DestroyRenderingBuffers()
 	g_DoFFastQueue.Destroy();
 	g_DoFFixupQueue.Destroy();
 
-	g_MotionPrepBuffer.Destroy();
 	g_LumaBuffer.Destroy();
 	g_TemporalBuffer[0].Destroy();
 	g_TemporalBuffer[1].Destroy();
-	g_aBloomUAV1[0].Destroy();
-	g_aBloomUAV1[1].Destroy();
-	g_aBloomUAV2[0].Destroy();
-	g_aBloomUAV2[1].Destroy();
-	g_aBloomUAV3[0].Destroy();
-	g_aBloomUAV3[1].Destroy();
-	g_aBloomUAV4[0].Destroy();
-	g_aBloomUAV4[1].Destroy();
-	g_aBloomUAV5[0].Destroy();
-	g_aBloomUAV5[1].Destroy();
+	g_BloomBuffer.Destroy();
 	g_LumaLR.Destroy();
 	g_Histogram.Destroy();
 	g_FXAAWorkQueueH.Destroy();
@@ -63,17 +63,12 @@ namespace Graphics
 	extern StructuredBuffer g_DoFFastQueue;
 	extern StructuredBuffer g_DoFFixupQueue;
 
-	extern ColorBuffer g_MotionPrepBuffer;		// R10G10B10A2
 	extern ColorBuffer g_LumaBuffer;
 	extern ColorBuffer g_TemporalBuffer[2];
 
 	enum { kBloomWidth = 640, kBloomHeight = 384 };
 
-	extern ColorBuffer g_aBloomUAV1[2];		// 640x384 (1/3)
-	extern ColorBuffer g_aBloomUAV2[2];		// 320x192 (1/6)  
-	extern ColorBuffer g_aBloomUAV3[2];		// 160x96  (1/12)
-	extern ColorBuffer g_aBloomUAV4[2];		// 80x48   (1/24)
-	extern ColorBuffer g_aBloomUAV5[2];		// 40x24   (1/48)
+	extern ColorBuffer g_BloomBuffer;		// 640x384 (1/3)
 	extern ColorBuffer g_LumaLR;
 	extern ByteAddressBuffer g_Histogram;
 	extern StructuredBuffer g_FXAAWorkQueueH;
@@ -124,6 +124,23 @@ void ColorBuffer::Create(const std::wstring& Name, uint32_t Width, uint32_t Heig
 	Create(Name, Width, Height, NumMips, Format);
 }
 
+void ColorBuffer::CreatePlaced(const std::wstring& Name, uint32_t Width, uint32_t Height, DXGI_FORMAT Format,
+	ID3D12Heap* Heap, uint64_t HeapOffset)
+{
+	D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, 1, 1, Format,
+		D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+	D3D12_CLEAR_VALUE ClearValue = {};
+	ClearValue.Format = Format;
+	ClearValue.Color[0] = m_ClearColor.R();
+	ClearValue.Color[1] = m_ClearColor.G();
+	ClearValue.Color[2] = m_ClearColor.B();
+	ClearValue.Color[3] = m_ClearColor.A();
+
+	CreatePlacedTextureResource(Graphics::g_Device, Name, ResourceDesc, ClearValue, Heap, HeapOffset);
+	CreateDerivedViews(Graphics::g_Device, Format, 1, 1);
+}
+
 void ColorBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount,
 	DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMem )
 {
@@ -43,6 +43,11 @@ public:
 	void Create(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips,
 		DXGI_FORMAT Format, EsramAllocator& Allocator);
 
+	// Create a color buffer without mips in a heap owned by the caller, such as the transient
+	// heap of a frame graph.  Buffers which overlap in the heap alias each other.
+	void CreatePlaced(const std::wstring& Name, uint32_t Width, uint32_t Height, DXGI_FORMAT Format,
+		ID3D12Heap* Heap, uint64_t HeapOffset);
+
 	// Create a color buffer.  If an address is supplied, memory will not be allocated.
 	// The vmem address allows you to alias buffers (which can be especially useful for
 	// reusing ESRAM across a frame.)
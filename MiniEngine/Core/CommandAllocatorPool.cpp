@@ -36,9 +36,10 @@ void CommandAllocatorPool::Shutdown()
 		m_AllocatorPool[i]->Release();
 
 	m_AllocatorPool.clear();
+	m_ReadyAllocators = std::queue<ID3D12CommandAllocator*>();
 }
 
-ID3D12CommandAllocator * CommandAllocatorPool::RequestAllocator(uint64_t CompletedFenceValue)
+ID3D12CommandAllocator * CommandAllocatorPool::RequestAllocator(void)
 {
 	std::lock_guard<std::mutex> LockGuard(m_AllocatorMutex);
 
@@ -46,14 +47,9 @@ ID3D12CommandAllocator * CommandAllocatorPool::RequestAllocator(uint64_t Complet
 
 	if (!m_ReadyAllocators.empty())
 	{
-		std::pair<uint64_t, ID3D12CommandAllocator*>& AllocatorPair = m_ReadyAllocators.front();
-
-		if (AllocatorPair.first <= CompletedFenceValue)
-		{
-			pAllocator = AllocatorPair.second;
-			ASSERT_SUCCEEDED(pAllocator->Reset());
-			m_ReadyAllocators.pop();
-		}
+		pAllocator = m_ReadyAllocators.front();
+		ASSERT_SUCCEEDED(pAllocator->Reset());
+		m_ReadyAllocators.pop();
 	}
 
 	// If no allocator's were ready to be reused, create a new one
@@ -69,10 +65,16 @@ ID3D12CommandAllocator * CommandAllocatorPool::RequestAllocator(uint64_t Complet
 	return pAllocator;
 }
 
-void CommandAllocatorPool::DiscardAllocator(uint64_t FenceValue, ID3D12CommandAllocator * Allocator)
+void CommandAllocatorPool::DiscardAllocator(ID3D12CommandAllocator * Allocator)
 {
 	std::lock_guard<std::mutex> LockGuard(m_AllocatorMutex);
 
-	// That fence value indicates we are free to reset the allocator
-	m_ReadyAllocators.push(std::make_pair(FenceValue, Allocator));
+	// The GPU is done with the allocator, so it is free to be reset
+	m_ReadyAllocators.push(Allocator);
+}
+
+bool CommandAllocatorPool::HasReadyAllocator(void)
+{
+	std::lock_guard<std::mutex> LockGuard(m_AllocatorMutex);
+	return !m_ReadyAllocators.empty();
 }
@@ -27,8 +27,14 @@ public:
 	void Create(ID3D12Device* pDevice);
 	void Shutdown();
 
-	ID3D12CommandAllocator* RequestAllocator(uint64_t CompletedFenceValue);
-	void DiscardAllocator(uint64_t FenceValue, ID3D12CommandAllocator* Allocator);
+	// Reuses a ready allocator, or creates a new one when there are none
+	ID3D12CommandAllocator* RequestAllocator(void);
+
+	// Return an allocator whose command lists the GPU has finished with.  The owning queue calls this when
+	// the fence for the allocator's last submission completes.
+	void DiscardAllocator(ID3D12CommandAllocator* Allocator);
+
+	bool HasReadyAllocator(void);
 
 	inline size_t Size() { return m_AllocatorPool.size(); }
 
@@ -37,6 +43,6 @@ private:
 
 	ID3D12Device* m_Device;
 	std::vector<ID3D12CommandAllocator*> m_AllocatorPool;
-	std::queue<std::pair<uint64_t, ID3D12CommandAllocator*>> m_ReadyAllocators;
+	std::queue<ID3D12CommandAllocator*> m_ReadyAllocators;
 	std::mutex m_AllocatorMutex;
 };
@@ -18,6 +18,7 @@
 #include "GraphicsCore.h"
 #include "DescriptorHeap.h"
 #include "EngineProfiling.h"
+#include "UploadManager.h"
 
 using namespace Graphics;
 
@@ -31,7 +32,18 @@ void ContextManager::DestroyAllContexts(void)
 CommandContext* ContextManager::AllocateContext(D3D12_COMMAND_LIST_TYPE Type)
 {
 	std::lock_guard<std::mutex> LockGuard(sm_ContextAllocationMutex);
+	return AllocateContextLocked(Type);
+}
+
+void ContextManager::AllocateContexts(D3D12_COMMAND_LIST_TYPE Type, UINT NumContexts, CommandContext** Contexts)
+{
+	std::lock_guard<std::mutex> LockGuard(sm_ContextAllocationMutex);
+	for (UINT i = 0; i < NumContexts; ++i)
+		Contexts[i] = AllocateContextLocked(Type);
+}
 
+CommandContext* ContextManager::AllocateContextLocked(D3D12_COMMAND_LIST_TYPE Type)
+{
 	auto& AvailableContexts = sm_AvailableContexts[Type];
 
 	CommandContext* ret = nullptr;
@@ -63,6 +75,9 @@ void ContextManager::FreeContext(CommandContext* UsedContext)
 
 void CommandContext::DestroyAllContexts(void)
 {
+	// The GPU is idle, so every retired page and heap can be returned before the pools are destroyed
+	g_CommandManager.ProcessCompletedFences();
+
 	LinearAllocator::DestroyAll();
 	DynamicDescriptorHeap::DestroyAll();
 	g_ContextManager.DestroyAllContexts();
@@ -87,17 +102,82 @@ ComputeContext& ComputeContext::Begin(const std::wstring& ID, bool Async)
 	return NewContext;
 }
 
-uint64_t CommandContext::Flush(bool WaitForCompletion)
+void GraphicsContext::BeginMultiple(UINT NumContexts, GraphicsContext** Contexts)
 {
-	FlushResourceBarriers();
+	g_ContextManager.AllocateContexts(D3D12_COMMAND_LIST_TYPE_DIRECT, NumContexts, (CommandContext**)Contexts);
+}
 
-	ASSERT(m_CurrentAllocator != nullptr);
+uint64_t CommandContext::ExecuteContexts( CommandContext* const* Contexts, UINT NumContexts )
+{
+	ASSERT(NumContexts > 0 && NumContexts <= kMaxBatchContexts);
 
-	uint64_t FenceValue = g_CommandManager.GetQueue(m_Type).ExecuteCommandList(m_CommandList);
+	D3D12_COMMAND_LIST_TYPE Type = Contexts[0]->m_Type;
+	CommandQueue& Queue = g_CommandManager.GetQueue(Type);
 
-	if (WaitForCompletion)
-		g_CommandManager.WaitForFence(FenceValue);
+	// Initial data uploads recorded so far must land before this work executes
+	if (Type != D3D12_COMMAND_LIST_TYPE_COPY)
+		g_UploadManager.SyncQueue(Queue);
+
+	for (UINT i = 0; i < NumContexts; ++i)
+	{
+		CommandContext& Context = *Contexts[i];
+		ASSERT(Context.m_Type == Type, "Batched contexts must target the same queue");
+		ASSERT(Context.m_CurrentAllocator != nullptr);
+
+		// Split barriers cannot span command lists
+		Context.m_StateTracker.EndSplitTransitions();
+		Context.FlushResourceBarriers();
+	}
+
+	// Each context may need a prologue list for its fix-up barriers
+	ID3D12CommandList* Lists[kMaxBatchContexts * 2];
+	ID3D12CommandAllocator* PrologueAllocators[kMaxBatchContexts];
+	UINT NumLists = 0;
+	UINT NumPrologues = 0;
+
+	// Hold the lock until the lists are queued so that contexts resolve in the order they execute
+	std::lock_guard<std::mutex> LockGuard(ResourceStateTracker::GetGlobalStateMutex());
+
+	for (UINT i = 0; i < NumContexts; ++i)
+	{
+		CommandContext& Context = *Contexts[i];
+
+		Context.m_StateTracker.ResolveGlobalStates(Context.m_FixupBarriers);
+
+		if (!Context.m_FixupBarriers.empty())
+		{
+			// Bring resources from the states left by earlier work into the states this context began with
+			ID3D12CommandAllocator*& PrologueAllocator = PrologueAllocators[NumPrologues++];
+			if (Context.m_PrologueList == nullptr)
+				g_CommandManager.CreateNewCommandList(Type, &Context.m_PrologueList, &PrologueAllocator);
+			else
+			{
+				PrologueAllocator = Queue.RequestAllocator();
+				Context.m_PrologueList->Reset(PrologueAllocator, nullptr);
+			}
+
+			Context.m_PrologueList->ResourceBarrier((UINT)Context.m_FixupBarriers.size(), Context.m_FixupBarriers.data());
+			Context.m_FixupBarriers.clear();
+
+			Lists[NumLists++] = Context.m_PrologueList;
+		}
+
+		Lists[NumLists++] = Context.m_CommandList;
+	}
+
+	uint64_t FenceValue = Queue.ExecuteCommandLists(NumLists, Lists);
 
+	for (UINT i = 0; i < NumContexts; ++i)
+		Contexts[i]->m_LastFenceValue = FenceValue;
+
+	for (UINT i = 0; i < NumPrologues; ++i)
+		Queue.DiscardAllocator(FenceValue, PrologueAllocators[i]);
+
+	return FenceValue;
+}
+
+void CommandContext::ReopenAfterFlush( void )
+{
 	//
 	// Reset the command list and restore previous state
 	//
@@ -116,41 +196,93 @@ uint64_t CommandContext::Flush(bool WaitForCompletion)
 	}
 
 	BindDescriptorHeaps();
+}
 
-	return FenceValue;
+void CommandContext::ReleaseToPool( uint64_t FenceValue )
+{
+	g_CommandManager.GetQueue(m_Type).DiscardAllocator(FenceValue, m_CurrentAllocator);
+	m_CurrentAllocator = nullptr;
+
+	m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
+	m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
+	m_DynamicDescriptorHeap.CleanupUsedHeaps(FenceValue);
+
+	// BeginMultiple() does not set an ID, so the next owner must not end this owner's profiling block
+	m_ID.clear();
+
+	g_ContextManager.FreeContext(this);
 }
 
-uint64_t CommandContext::Finish( bool WaitForCompletion )
+uint64_t CommandContext::Flush(bool WaitForCompletion)
 {
-	ASSERT(m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT || m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+	CommandContext* Self = this;
+	uint64_t FenceValue = ExecuteContexts(&Self, 1);
 
-	FlushResourceBarriers();
+	if (WaitForCompletion)
+		g_CommandManager.WaitForFence(FenceValue);
 
-	if (m_ID.length() > 0)
-		EngineProfiling::EndBlock(this);
+	ReopenAfterFlush();
 
-	ASSERT(m_CurrentAllocator != nullptr);
+	return FenceValue;
+}
 
-	CommandQueue& Queue = g_CommandManager.GetQueue(m_Type);
+uint64_t CommandContext::FlushWith( CommandContext* const* Contexts, UINT NumContexts, bool WaitForCompletion )
+{
+	ASSERT(NumContexts < kMaxBatchContexts);
 
-	uint64_t FenceValue = Queue.ExecuteCommandList(m_CommandList);
-	Queue.DiscardAllocator(FenceValue, m_CurrentAllocator);
-	m_CurrentAllocator = nullptr;
+	CommandContext* Batch[kMaxBatchContexts];
+	Batch[0] = this;
+	for (UINT i = 0; i < NumContexts; ++i)
+	{
+		Batch[i + 1] = Contexts[i];
+		if (Contexts[i]->m_ID.length() > 0)
+			EngineProfiling::EndBlock(Contexts[i]);
+	}
 
-	m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
-	m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
-	m_DynamicDescriptorHeap.CleanupUsedHeaps(FenceValue);
+	uint64_t FenceValue = ExecuteContexts(Batch, NumContexts + 1);
+
+	for (UINT i = 0; i < NumContexts; ++i)
+		Contexts[i]->ReleaseToPool(FenceValue);
 
 	if (WaitForCompletion)
 		g_CommandManager.WaitForFence(FenceValue);
 
-	g_ContextManager.FreeContext(this);
+	ReopenAfterFlush();
+
+	return FenceValue;
+}
+
+uint64_t CommandContext::Finish( bool WaitForCompletion )
+{
+	CommandContext* Self = this;
+	return FinishBatch(&Self, 1, WaitForCompletion);
+}
+
+uint64_t CommandContext::FinishBatch( CommandContext* const* Contexts, UINT NumContexts, bool WaitForCompletion )
+{
+	for (UINT i = 0; i < NumContexts; ++i)
+	{
+		CommandContext& Context = *Contexts[i];
+		ASSERT(Context.m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT || Context.m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+
+		if (Context.m_ID.length() > 0)
+			EngineProfiling::EndBlock(&Context);
+	}
+
+	uint64_t FenceValue = ExecuteContexts(Contexts, NumContexts);
+
+	for (UINT i = 0; i < NumContexts; ++i)
+		Contexts[i]->ReleaseToPool(FenceValue);
+
+	if (WaitForCompletion)
+		g_CommandManager.WaitForFence(FenceValue);
 
 	return FenceValue;
 }
 
 CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
 	m_Type(Type),
+	m_StateTracker(Type),
 	m_DynamicDescriptorHeap(*this),
 	m_CpuLinearAllocator(kCpuWritable), 
 	m_GpuLinearAllocator(kGpuExclusive)
@@ -158,19 +290,22 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
 	m_OwningManager = nullptr;
 	m_CommandList = nullptr;
 	m_CurrentAllocator = nullptr;
+	m_PrologueList = nullptr;
+	m_LastFenceValue = 0;
 	ZeroMemory(m_CurrentDescriptorHeaps, sizeof(m_CurrentDescriptorHeaps));
 
 	m_CurGraphicsRootSignature = nullptr;
 	m_CurGraphicsPipelineState = nullptr;
 	m_CurComputeRootSignature = nullptr;
 	m_CurComputePipelineState = nullptr;
-	m_NumBarriersToFlush = 0;
 }
 
 CommandContext::~CommandContext( void )
 {
 	if (m_CommandList != nullptr)
 		m_CommandList->Release();
+	if (m_PrologueList != nullptr)
+		m_PrologueList->Release();
 }
 
 void CommandContext::Initialize(void)
@@ -190,7 +325,7 @@ void CommandContext::Reset( void )
 	m_CurGraphicsPipelineState = nullptr;
 	m_CurComputeRootSignature = nullptr;
 	m_CurComputePipelineState = nullptr;
-	m_NumBarriersToFlush = 0;
+	m_StateTracker.Reset();
 
 	BindDescriptorHeaps();
 }
@@ -315,6 +450,12 @@ void GraphicsContext::ClearDepth( DepthBuffer& Target )
 	m_CommandList->ClearDepthStencilView(Target.GetDSV(), D3D12_CLEAR_FLAG_DEPTH, Target.GetClearDepth(), Target.GetClearStencil(), 0, nullptr );
 }
 
+void GraphicsContext::ClearDepth( DepthBuffer& Target, const D3D12_RECT& Rect )
+{
+	TransitionResource(Target, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
+	m_CommandList->ClearDepthStencilView(Target.GetDSV(), D3D12_CLEAR_FLAG_DEPTH, Target.GetClearDepth(), Target.GetClearStencil(), 1, &Rect );
+}
+
 void GraphicsContext::ClearStencil( DepthBuffer& Target )
 {
 	TransitionResource(Target, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
@@ -360,118 +501,50 @@ void GraphicsContext::SetScissor( const D3D12_RECT& rect )
 
 void CommandContext::TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate)
 {
-	D3D12_RESOURCE_STATES OldState = Resource.m_UsageState;
-
-	if (m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE)
-	{
-		ASSERT((OldState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == OldState);
-		ASSERT((NewState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == NewState);
-	}
-
-	if (OldState != NewState)
-	{
-		ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-		D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+	m_StateTracker.TransitionResource(Resource, NewState);
 
-		BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		BarrierDesc.Transition.pResource = Resource.GetResource();
-		BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-		BarrierDesc.Transition.StateBefore = OldState;
-		BarrierDesc.Transition.StateAfter = NewState;
-
-		// Check to see if we already started the transition
-		if (NewState == Resource.m_TransitioningState)
-		{
-			BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
-			Resource.m_TransitioningState = (D3D12_RESOURCE_STATES)-1;
-		}
-		else
-			BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-
-		Resource.m_UsageState = NewState;
-	}
-	else if (NewState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
-		InsertUAVBarrier(Resource, FlushImmediate);
-
-	if (FlushImmediate || m_NumBarriersToFlush == 16)
-	{
-		m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
-		m_NumBarriersToFlush = 0;
-	}
+	if (FlushImmediate)
+		FlushResourceBarriers();
 }
 
 void CommandContext::BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate)
 {
-	// If it's already transitioning, finish that transition
-	if (Resource.m_TransitioningState != (D3D12_RESOURCE_STATES)-1)
-		TransitionResource(Resource, Resource.m_TransitioningState);
-
-	D3D12_RESOURCE_STATES OldState = Resource.m_UsageState;
-
-	if (OldState != NewState)
-	{
-		ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-		D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
-
-		BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		BarrierDesc.Transition.pResource = Resource.GetResource();
-		BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-		BarrierDesc.Transition.StateBefore = OldState;
-		BarrierDesc.Transition.StateAfter = NewState;
-
-		BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
-
-		Resource.m_TransitioningState = NewState;
-	}
+	m_StateTracker.BeginResourceTransition(Resource, NewState);
 
-	if (FlushImmediate || m_NumBarriersToFlush == 16)
-	{
-		m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
-		m_NumBarriersToFlush = 0;
-	}
+	if (FlushImmediate)
+		FlushResourceBarriers();
 }
 
-
 void CommandContext::FlushResourceBarriers(void)
 {
-	if (m_NumBarriersToFlush == 0)
+	UINT NumBarriers = m_StateTracker.GetPendingBarrierCount();
+	if (NumBarriers == 0)
 		return;
 
-	m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
-	m_NumBarriersToFlush = 0;
+	m_CommandList->ResourceBarrier(NumBarriers, m_StateTracker.GetPendingBarriers());
+	m_StateTracker.ClearPendingBarriers();
 }
 
 void CommandContext::InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate)
 {
-	ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-	D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
-
-	BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-	BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	BarrierDesc.UAV.pResource = Resource.GetResource();
+	m_StateTracker.InsertUAVBarrier(Resource);
 
 	if (FlushImmediate)
-	{
-		m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
-		m_NumBarriersToFlush = 0;
-	}
+		FlushResourceBarriers();
 }
 
 void CommandContext::InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate)
 {
-	ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-	D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
-
-	BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
-	BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	BarrierDesc.Aliasing.pResourceBefore = Before.GetResource();
-	BarrierDesc.Aliasing.pResourceAfter = After.GetResource();
+	m_StateTracker.InsertAliasBarrier(Before, After);
 
 	if (FlushImmediate)
-	{
-		m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
-		m_NumBarriersToFlush = 0;
-	}
+		FlushResourceBarriers();
+}
+
+void CommandContext::DiscardResource(GpuResource& Resource)
+{
+	FlushResourceBarriers();
+	m_CommandList->DiscardResource(Resource.GetResource(), nullptr);
 }
 
 void CommandContext::WriteBuffer( GpuResource& Dest, size_t DestOffset, const void* BufferData, size_t NumBytes )
@@ -490,11 +563,19 @@ void CommandContext::FillBuffer( GpuResource& Dest, size_t DestOffset, DWParam V
 	CopyBufferRegion(Dest, DestOffset, TempSpace.Buffer, TempSpace.Offset, NumBytes );
 }
 
-void CommandContext::InitializeTexture( GpuResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[] )
+void CommandContext::InitializeTexture( GpuResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[],
+	UINT FirstSubresource )
 {
+	// Batch the upload on the copy queue when the resource is in a state the copy queue can use
+	if (g_UploadManager.CanUpload(Dest))
+	{
+		g_UploadManager.UploadTexture(Dest, FirstSubresource, NumSubresources, SubData);
+		return;
+	}
+
 	ID3D12Resource* UploadBuffer;
 
-	UINT64 uploadBufferSize = GetRequiredIntermediateSize(Dest.GetResource(), 0, NumSubresources);
+	UINT64 uploadBufferSize = GetRequiredIntermediateSize(Dest.GetResource(), FirstSubresource, NumSubresources);
 
 	CommandContext& InitContext = CommandContext::Begin();
 
@@ -524,7 +605,7 @@ void CommandContext::InitializeTexture( GpuResource& Dest, UINT NumSubresources,
 
 	// copy data to the intermediate upload heap and then schedule a copy from the upload heap to the default texture
 	InitContext.TransitionResource(Dest, D3D12_RESOURCE_STATE_COPY_DEST, true);
-	UpdateSubresources(InitContext.m_CommandList, Dest.GetResource(), UploadBuffer, 0, 0, NumSubresources, SubData);
+	UpdateSubresources(InitContext.m_CommandList, Dest.GetResource(), UploadBuffer, 0, FirstSubresource, NumSubresources, SubData);
 	InitContext.TransitionResource(Dest, D3D12_RESOURCE_STATE_GENERIC_READ, true);
 
 	// Execute the command list and wait for it to finish so we can release the upload buffer
@@ -601,6 +682,13 @@ void CommandContext::InitializeTextureArraySlice(GpuResource& Dest, UINT SliceIn
 
 void CommandContext::InitializeBuffer( GpuResource& Dest, const void* BufferData, size_t NumBytes, bool UseOffset, size_t Offset)
 {
+	// Batch the upload on the copy queue when the resource is in a state the copy queue can use
+	if (g_UploadManager.CanUpload(Dest))
+	{
+		g_UploadManager.UploadBuffer(Dest, UseOffset ? Offset : 0, BufferData, NumBytes);
+		return;
+	}
+
 	ID3D12Resource* UploadBuffer;
 
 	CommandContext& InitContext = CommandContext::Begin();
@@ -630,7 +718,7 @@ void CommandContext::InitializeBuffer( GpuResource& Dest, const void* BufferData
 
 	void* DestAddress;
 	UploadBuffer->Map(0, nullptr, &DestAddress);
-	SIMDMemCopy(DestAddress, BufferData, Math::DivideByMultiple(NumBytes, 16));
+	SIMDMemCopyParallel(DestAddress, BufferData, Math::DivideByMultiple(NumBytes, 16));
 	UploadBuffer->Unmap(0, nullptr);
 
 	// copy data to the intermediate upload heap and then schedule a copy from the upload heap to the default texture
@@ -23,6 +23,7 @@
 #include "PixelBuffer.h"
 #include "DynamicDescriptorHeap.h"
 #include "LinearAllocator.h"
+#include "ResourceStateTracker.h"
 #include "CommandSignature.h"
 #include "GraphicsCore.h"
 #include <vector>
@@ -51,22 +52,19 @@ struct DWParam
 	};
 };
 
-#define VALID_COMPUTE_QUEUE_RESOURCE_STATES \
-	( D3D12_RESOURCE_STATE_UNORDERED_ACCESS \
-	| D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE \
-	| D3D12_RESOURCE_STATE_COPY_DEST \
-	| D3D12_RESOURCE_STATE_COPY_SOURCE )
-
 class ContextManager
 {
 public:
 	ContextManager(void) {}
 
 	CommandContext* AllocateContext(D3D12_COMMAND_LIST_TYPE Type);
+	void AllocateContexts(D3D12_COMMAND_LIST_TYPE Type, UINT NumContexts, CommandContext** Contexts);
 	void FreeContext(CommandContext*);
 	void DestroyAllContexts();
 
 private:
+	CommandContext* AllocateContextLocked(D3D12_COMMAND_LIST_TYPE Type);
+
 	std::vector<std::unique_ptr<CommandContext> > sm_ContextPool[4];
 	std::queue<CommandContext*> sm_AvailableContexts[4];
 	std::mutex sm_ContextAllocationMutex;
@@ -95,6 +93,16 @@ public:
 	// Flush existing commands and release the current context
 	uint64_t Finish( bool WaitForCompletion = false );
 
+	// Flush this context's commands followed by those of other contexts of the same type, in array order, with
+	// a single ExecuteCommandLists call.  The other contexts are finished and released.  This one stays alive.
+	uint64_t FlushWith( CommandContext* const* Contexts, UINT NumContexts, bool WaitForCompletion = false );
+
+	// Finish several contexts of the same type with a single ExecuteCommandLists call.  Their commands execute
+	// in array order.
+	static uint64_t FinishBatch( CommandContext* const* Contexts, UINT NumContexts, bool WaitForCompletion = false );
+
+	static const UINT kMaxBatchContexts = 64;
+
 	// Prepare to render by reserving a command list and command allocator
 	void Initialize(void);
 
@@ -107,16 +115,29 @@ public:
 		return reinterpret_cast<ComputeContext&>(*this);
 	}
 
+	D3D12_COMMAND_LIST_TYPE GetType() const { return m_Type; }
+
+	// The fence of the last batch which executed this context's commands, or 0 if none has.  It only grows, so
+	// a change since an earlier read means the commands recorded before that read have been submitted.
+	uint64_t GetLastFenceValue() const { return m_LastFenceValue; }
+
 	void CopyBuffer( GpuResource& Dest, GpuResource& Src );
 	void CopyBufferRegion( GpuResource& Dest, size_t DestOffset, GpuResource& Src, size_t SrcOffset, size_t NumBytes );
 	void CopySubresource(GpuResource& Dest, UINT DestSubIndex, GpuResource& Src, UINT SrcSubIndex);
 	void CopyCounter(GpuResource& Dest, size_t DestOffset, StructuredBuffer& Src);
 	void ResetCounter(StructuredBuffer& Buf, uint32_t Value = 0);
 
-	static void InitializeTexture( GpuResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[] );
+	static void InitializeTexture( GpuResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[],
+		UINT FirstSubresource = 0 );
 	static void InitializeBuffer( GpuResource& Dest, const void* Data, size_t NumBytes , bool UseOffset = false, size_t Offset = 0);
 	static void InitializeTextureArraySlice(GpuResource& Dest, UINT SliceIndex, GpuResource& Src);
 
+	// Upload memory the CPU may write directly, valid until this context's commands have executed
+	DynAlloc ReserveUploadMemory( size_t SizeInBytes )
+	{
+		return m_CpuLinearAllocator.Allocate(SizeInBytes);
+	}
+
 	void WriteBuffer( GpuResource& Dest, size_t DestOffset, const void* Data, size_t NumBytes );
 	void FillBuffer( GpuResource& Dest, size_t DestOffset, DWParam Value, size_t NumBytes );
 
@@ -126,6 +147,11 @@ public:
 	void InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate = false);
 	void FlushResourceBarriers(void);
 
+	// Mark the contents of a resource as undefined.  Placed render targets must be discarded or cleared when
+	// first used after an aliasing barrier.  Pending barriers are flushed first, so transition the resource to
+	// the state DiscardResource() requires before calling this.
+	void DiscardResource(GpuResource& Resource);
+
 	void InsertTimeStamp( ID3D12QueryHeap* pQueryHeap, uint32_t QueryIdx );
 	void ResolveTimeStamps( ID3D12Resource* pReadbackHeap, ID3D12QueryHeap* pQueryHeap, uint32_t NumQueries );
 	void PIXBeginEvent(const wchar_t* label);
@@ -142,6 +168,12 @@ protected:
 	void FinishTimeStampQueryBatch();
 	void BindDescriptorHeaps( void );
 
+	// Resolve the resource states of the contexts in order and execute their command lists, each preceded by
+	// its fix-up barriers if it needs any.
+	static uint64_t ExecuteContexts( CommandContext* const* Contexts, UINT NumContexts );
+	void ReopenAfterFlush( void );
+	void ReleaseToPool( uint64_t FenceValue );
+
 	CommandListManager* m_OwningManager;
 	ID3D12GraphicsCommandList* m_CommandList;
 	ID3D12CommandAllocator* m_CurrentAllocator;
@@ -153,8 +185,9 @@ protected:
 
 	DynamicDescriptorHeap m_DynamicDescriptorHeap;
 
-	D3D12_RESOURCE_BARRIER m_ResourceBarrierBuffer[16];
-	UINT m_NumBarriersToFlush;
+	ResourceStateTracker m_StateTracker;
+	std::vector<D3D12_RESOURCE_BARRIER> m_FixupBarriers;
+	ID3D12GraphicsCommandList* m_PrologueList;	// Records fix-up barriers ahead of m_CommandList
 
 	ID3D12DescriptorHeap* m_CurrentDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
@@ -165,6 +198,7 @@ protected:
 	void SetID(const std::wstring& ID) { m_ID = ID; }
 
 	D3D12_COMMAND_LIST_TYPE m_Type;
+	uint64_t m_LastFenceValue;
 };
 
 class GraphicsContext : public CommandContext
@@ -176,10 +210,15 @@ public:
 		return CommandContext::Begin(ID).GetGraphicsContext();
 	}
 
+	// Reserve several contexts at once, e.g. to record parts of a pass on different threads.  Submit them
+	// with FlushWith() or FinishBatch() to keep their order.
+	static void BeginMultiple(UINT NumContexts, GraphicsContext** Contexts);
+
 	void ClearUAV( GpuBuffer& Target );
 	void ClearUAV( ColorBuffer& Target );
 	void ClearColor( ColorBuffer& Target );
 	void ClearDepth( DepthBuffer& Target );
+	void ClearDepth( DepthBuffer& Target, const D3D12_RECT& Rect );	// Clears only part, e.g. one tile of an atlas
 	void ClearStencil( DepthBuffer& Target );
 	void ClearDepthAndStencil( DepthBuffer& Target );
 
@@ -215,7 +254,7 @@ public:
 	void SetConstants( UINT RootIndex, DWParam X, DWParam Y, DWParam Z, DWParam W );
 	void SetConstantBuffer( UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS CBV );
 	void SetDynamicConstantBufferView( UINT RootIndex, size_t BufferSize, const void* BufferData );
-	void SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV );
+	void SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset = 0 );
 	void SetBufferUAV( UINT RootIndex, const GpuBuffer& UAV );
 	void SetDescriptorTable( UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle );
 
@@ -260,7 +299,7 @@ public:
 	void SetConstantBuffer( UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS CBV );
 	void SetDynamicConstantBufferView( UINT RootIndex, size_t BufferSize, const void* BufferData );
 	void SetDynamicSRV( UINT RootIndex, size_t BufferSize, const void* BufferData ); 
-	void SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV );
+	void SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset = 0 );
 	void SetBufferUAV( UINT RootIndex, const GpuBuffer& UAV );
 	void SetDescriptorTable( UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle );
 
@@ -482,27 +521,27 @@ inline void ComputeContext::SetDynamicSRV(UINT RootIndex, size_t BufferSize, con
 	m_CommandList->SetComputeRootShaderResourceView(RootIndex, cb.GpuAddress);
 }
 
-inline void GraphicsContext::SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV )
+inline void GraphicsContext::SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset )
 {
-	ASSERT((SRV.m_UsageState & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
-	m_CommandList->SetGraphicsRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress());
+	ASSERT((m_StateTracker.GetCurrentState(SRV) & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
+	m_CommandList->SetGraphicsRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress() + Offset);
 }
 
-inline void ComputeContext::SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV )
+inline void ComputeContext::SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset )
 {
-	ASSERT((SRV.m_UsageState & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) != 0);
-	m_CommandList->SetComputeRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress());
+	ASSERT((m_StateTracker.GetCurrentState(SRV) & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) != 0);
+	m_CommandList->SetComputeRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress() + Offset);
 }
 
 inline void GraphicsContext::SetBufferUAV( UINT RootIndex, const GpuBuffer& UAV )
 {
-	ASSERT((UAV.m_UsageState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
+	ASSERT((m_StateTracker.GetCurrentState(UAV) & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
 	m_CommandList->SetGraphicsRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress());
 }
 
 inline void ComputeContext::SetBufferUAV( UINT RootIndex, const GpuBuffer& UAV )
 {
-	ASSERT((UAV.m_UsageState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
+	ASSERT((m_StateTracker.GetCurrentState(UAV) & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
 	m_CommandList->SetComputeRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress());
 }
 
@@ -34,9 +34,12 @@ void CommandQueue::Shutdown()
 	if (m_CommandQueue == nullptr)
 		return;
 
-	m_AllocatorPool.Shutdown();
+	{
+		std::lock_guard<std::mutex> LockGuard(m_CallbackMutex);
+		m_FenceCallbacks.clear();
+	}
 
-	CloseHandle(m_FenceEventHandle);
+	m_AllocatorPool.Shutdown();
 
 	m_pFence->Release();
 
@@ -78,9 +81,6 @@ void CommandQueue::Create(ID3D12Device* pDevice)
 	m_pFence->SetName(L"CommandListManager::m_pFence");
 	m_pFence->Signal((uint64_t)m_Type << 56);
 
-	m_FenceEventHandle = CreateEvent(nullptr, false, false, nullptr);
-	ASSERT(m_FenceEventHandle != INVALID_HANDLE_VALUE);
-
 	m_AllocatorPool.Create(pDevice);
 
 	ASSERT(IsReady());
@@ -118,13 +118,19 @@ void CommandListManager::CreateNewCommandList( D3D12_COMMAND_LIST_TYPE Type, ID3
 }
 
 uint64_t CommandQueue::ExecuteCommandList( ID3D12CommandList* List )
+{
+	return ExecuteCommandLists(1, &List);
+}
+
+uint64_t CommandQueue::ExecuteCommandLists( UINT NumLists, ID3D12CommandList** Lists )
 {
 	std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
 
-	ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)List)->Close());
+	for (UINT i = 0; i < NumLists; ++i)
+		ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)Lists[i])->Close());
 
-	// Kickoff the command list
-	m_CommandQueue->ExecuteCommandLists(1, &List);
+	// Kickoff the command lists
+	m_CommandQueue->ExecuteCommandLists(NumLists, Lists);
 
 	// Signal the next fence value (with the GPU)
 	m_CommandQueue->Signal(m_pFence, m_NextFenceValue);
@@ -140,15 +146,60 @@ uint64_t CommandQueue::IncrementFence(void)
 	return m_NextFenceValue++;
 }
 
+uint64_t CommandQueue::PollCompletedFence(void)
+{
+	uint64_t CompletedValue = m_pFence->GetCompletedValue();
+
+	// Another thread may have polled at the same time and seen a later value.  Never let the last completed
+	// fence value regress.
+	uint64_t LastSeen = m_LastCompletedFenceValue;
+	while (CompletedValue > LastSeen && !m_LastCompletedFenceValue.compare_exchange_weak(LastSeen, CompletedValue))
+		;
+
+	return std::max(CompletedValue, LastSeen);
+}
+
 bool CommandQueue::IsFenceComplete(uint64_t FenceValue)
 {
-	// Avoid querying the fence value by testing against the last one seen.
-	// The max() is to protect against an unlikely race condition that could cause the last
-	// completed fence value to regress.
-	if (FenceValue > m_LastCompletedFenceValue)
-		m_LastCompletedFenceValue = std::max(m_LastCompletedFenceValue, m_pFence->GetCompletedValue());
+	// Avoid querying the fence value by testing against the last one seen
+	if (FenceValue <= m_LastCompletedFenceValue)
+		return true;
 
-	return FenceValue <= m_LastCompletedFenceValue;
+	return FenceValue <= PollCompletedFence();
+}
+
+void CommandQueue::OnFenceComplete(uint64_t FenceValue, std::function<void(void)> Callback)
+{
+	ASSERT(D3D12_COMMAND_LIST_TYPE(FenceValue >> 56) == m_Type, "Fence value belongs to another queue");
+
+	std::lock_guard<std::mutex> LockGuard(m_CallbackMutex);
+	m_FenceCallbacks.emplace(FenceValue, std::move(Callback));
+}
+
+void CommandQueue::ProcessCompletedFences(void)
+{
+	std::vector<std::function<void(void)>> ReadyCallbacks;
+
+	{
+		std::lock_guard<std::mutex> LockGuard(m_CallbackMutex);
+
+		if (m_FenceCallbacks.empty())
+			return;
+
+		// Only touch the fence when the oldest callback is not already known to be complete
+		uint64_t CompletedValue = m_LastCompletedFenceValue;
+		if (m_FenceCallbacks.begin()->first > CompletedValue)
+			CompletedValue = PollCompletedFence();
+
+		auto End = m_FenceCallbacks.upper_bound(CompletedValue);
+		for (auto Iter = m_FenceCallbacks.begin(); Iter != End; ++Iter)
+			ReadyCallbacks.push_back(std::move(Iter->second));
+		m_FenceCallbacks.erase(m_FenceCallbacks.begin(), End);
+	}
+
+	// Callbacks are run without the lock held so that they may register new callbacks
+	for (auto& Callback : ReadyCallbacks)
+		Callback();
 }
 
 namespace Graphics
@@ -168,21 +219,52 @@ void CommandQueue::StallForProducer(CommandQueue& Producer)
 	m_CommandQueue->Wait(Producer.m_pFence, Producer.m_NextFenceValue - 1);
 }
 
-void CommandQueue::WaitForFence(uint64_t FenceValue)
+namespace
 {
-	if (IsFenceComplete(FenceValue))
-		return;
+	// Each waiting thread has its own event, so threads waiting on different values of the same fence do not
+	// serialize behind one another.  The event is never closed while the thread lives because a fence may still
+	// hold it from a WaitForAnyFence() which returned early.  A stale signal only costs one extra poll.
+	struct ThreadWaitEvent
+	{
+		ThreadWaitEvent() : m_Handle(CreateEvent(nullptr, TRUE, FALSE, nullptr))
+		{
+			ASSERT(m_Handle != nullptr);
+		}
+
+		~ThreadWaitEvent()
+		{
+			CloseHandle(m_Handle);
+		}
 
-	// TODO:  Think about how this might affect a multi-threaded situation.  Suppose thread A
-	// wants to wait for fence 100, then thread B comes along and wants to wait for 99.  If
-	// the fence can only have one event set on completion, then thread B has to wait for 
-	// 100 before it knows 99 is ready.  Maybe insert sequential events?
+		HANDLE m_Handle;
+	};
+
+	HANDLE GetThreadWaitEvent(void)
 	{
-		std::lock_guard<std::mutex> LockGuard(m_EventMutex);
+		static thread_local ThreadWaitEvent s_WaitEvent;
+		ResetEvent(s_WaitEvent.m_Handle);
+		return s_WaitEvent.m_Handle;
+	}
+
+	// Graphics, compute and copy, in the order CommandListManager::GetQueue() picks them
+	uint32_t GetQueueIndex(uint64_t FenceValue)
+	{
+		switch (D3D12_COMMAND_LIST_TYPE(FenceValue >> 56))
+		{
+		case D3D12_COMMAND_LIST_TYPE_COMPUTE: return 1;
+		case D3D12_COMMAND_LIST_TYPE_COPY: return 2;
+		default: return 0;
+		}
+	}
+}
 
-		m_pFence->SetEventOnCompletion(FenceValue, m_FenceEventHandle);
-		WaitForSingleObject(m_FenceEventHandle, INFINITE);
-		m_LastCompletedFenceValue = FenceValue;
+void CommandQueue::WaitForFence(uint64_t FenceValue)
+{
+	while (!IsFenceComplete(FenceValue))
+	{
+		HANDLE WaitEvent = GetThreadWaitEvent();
+		m_pFence->SetEventOnCompletion(FenceValue, WaitEvent);
+		WaitForSingleObject(WaitEvent, INFINITE);
 	}
 }
 
@@ -192,14 +274,68 @@ void CommandListManager::WaitForFence(uint64_t FenceValue)
 	Producer.WaitForFence(FenceValue);
 }
 
+UINT CommandListManager::WaitForAnyFence(const uint64_t* FenceValues, UINT NumFences)
+{
+	ASSERT(NumFences > 0);
+
+	CommandQueue* Queues[] = { &m_GraphicsQueue, &m_ComputeQueue, &m_CopyQueue };
+
+	for (;;)
+	{
+		// Waiting for the earliest pending value of each queue is enough to know that one of the fences is done
+		uint64_t EarliestPending[] = { UINT64_MAX, UINT64_MAX, UINT64_MAX };
+
+		for (UINT i = 0; i < NumFences; ++i)
+		{
+			if (IsFenceComplete(FenceValues[i]))
+				return i;
+
+			uint32_t QueueIdx = GetQueueIndex(FenceValues[i]);
+			EarliestPending[QueueIdx] = std::min(EarliestPending[QueueIdx], FenceValues[i]);
+		}
+
+		// One event set by whichever fence gets there first
+		HANDLE WaitEvent = GetThreadWaitEvent();
+		for (uint32_t q = 0; q < 3; ++q)
+		{
+			if (EarliestPending[q] != UINT64_MAX)
+				Queues[q]->m_pFence->SetEventOnCompletion(EarliestPending[q], WaitEvent);
+		}
+		WaitForSingleObject(WaitEvent, INFINITE);
+	}
+}
+
+void CommandListManager::WaitForAllFences(const uint64_t* FenceValues, UINT NumFences)
+{
+	CommandQueue* Queues[] = { &m_GraphicsQueue, &m_ComputeQueue, &m_CopyQueue };
+
+	// Only the latest value of each queue needs to be waited on
+	uint64_t LatestPending[] = { 0, 0, 0 };
+
+	for (UINT i = 0; i < NumFences; ++i)
+	{
+		uint32_t QueueIdx = GetQueueIndex(FenceValues[i]);
+		LatestPending[QueueIdx] = std::max(LatestPending[QueueIdx], FenceValues[i]);
+	}
+
+	for (uint32_t q = 0; q < 3; ++q)
+	{
+		if (LatestPending[q] != 0)
+			Queues[q]->WaitForFence(LatestPending[q]);
+	}
+}
+
 ID3D12CommandAllocator* CommandQueue::RequestAllocator()
 {
-	uint64_t CompletedFence = m_pFence->GetCompletedValue();
+	// Allocators come back to the pool when their fence callbacks run.  Before growing the pool, give
+	// any which have finished since the last poll a chance to return.
+	if (!m_AllocatorPool.HasReadyAllocator())
+		ProcessCompletedFences();
 
-	return m_AllocatorPool.RequestAllocator(CompletedFence);
+	return m_AllocatorPool.RequestAllocator();
 }
 
 void CommandQueue::DiscardAllocator(uint64_t FenceValue, ID3D12CommandAllocator* Allocator)
 {
-	m_AllocatorPool.DiscardAllocator(FenceValue, Allocator);
+	OnFenceComplete(FenceValue, [this, Allocator]( void ) { m_AllocatorPool.DiscardAllocator(Allocator); });
 }
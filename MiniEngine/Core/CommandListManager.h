@@ -15,7 +15,10 @@
 
 #include <vector>
 #include <queue>
+#include <map>
 #include <mutex>
+#include <atomic>
+#include <functional>
 #include <stdint.h>
 #include "CommandAllocatorPool.h"
 
@@ -23,6 +26,7 @@ class CommandQueue
 {
 	friend class CommandListManager;
 	friend class CommandContext;
+	friend class UploadManager;
 
 public:
 	CommandQueue(D3D12_COMMAND_LIST_TYPE Type);
@@ -38,6 +42,8 @@ public:
 
 	uint64_t IncrementFence(void);
 	bool IsFenceComplete(uint64_t FenceValue);
+	uint64_t PollCompletedFence(void);
+	uint64_t GetLastCompletedFence(void) const { return m_LastCompletedFenceValue; }
 	void StallForFence(uint64_t FenceValue);
 	void StallForProducer(CommandQueue& Producer);
 	void WaitForFence(uint64_t FenceValue);
@@ -47,9 +53,17 @@ public:
 
 	uint64_t GetNextFenceValue() { return m_NextFenceValue; }
 
+	// Run a function once the fence reaches a value.  Callbacks run during ProcessCompletedFences(), in fence
+	// order, on whichever thread calls it.  They should only take short-lived locks and must not wait on the GPU.
+	void OnFenceComplete(uint64_t FenceValue, std::function<void(void)> Callback);
+
+	// Query the fence once and run every callback whose fence value has been reached
+	void ProcessCompletedFences(void);
+
 private:
 
 	uint64_t ExecuteCommandList(ID3D12CommandList* List);
+	uint64_t ExecuteCommandLists(UINT NumLists, ID3D12CommandList** Lists);
 	ID3D12CommandAllocator* RequestAllocator(void);
 	void DiscardAllocator(uint64_t FenceValueForReset, ID3D12CommandAllocator* Allocator);
 
@@ -59,13 +73,14 @@ private:
 
 	CommandAllocatorPool m_AllocatorPool;
 	std::mutex m_FenceMutex;
-	std::mutex m_EventMutex;
+	std::mutex m_CallbackMutex;
 
 	// Lifetime of these objects is managed by the descriptor cache
 	ID3D12Fence* m_pFence;
 	uint64_t m_NextFenceValue;
-	uint64_t m_LastCompletedFenceValue;
-	HANDLE m_FenceEventHandle;
+	std::atomic<uint64_t> m_LastCompletedFenceValue;
+
+	std::multimap<uint64_t, std::function<void(void)>> m_FenceCallbacks;
 
 };
 
@@ -113,6 +128,25 @@ public:
 	// The CPU will wait for a fence to reach a specified value
 	void WaitForFence(uint64_t FenceValue);
 
+	// The CPU will wait for any or all of several fences, which may belong to different queues.  WaitForAnyFence()
+	// returns the index of a fence which has completed.
+	UINT WaitForAnyFence(const uint64_t* FenceValues, UINT NumFences);
+	void WaitForAllFences(const uint64_t* FenceValues, UINT NumFences);
+
+	// Run a function once a fence completes.  See CommandQueue::OnFenceComplete().
+	void OnFenceComplete(uint64_t FenceValue, std::function<void(void)> Callback)
+	{
+		GetQueue(D3D12_COMMAND_LIST_TYPE(FenceValue >> 56)).OnFenceComplete(FenceValue, std::move(Callback));
+	}
+
+	// Poll each queue's fence once and run the callbacks of completed fences.  Called once per frame.
+	void ProcessCompletedFences(void)
+	{
+		m_GraphicsQueue.ProcessCompletedFences();
+		m_ComputeQueue.ProcessCompletedFences();
+		m_CopyQueue.ProcessCompletedFences();
+	}
+
 	// The CPU will wait for all command queues to empty (so that the GPU is idle)
 	void IdleGPU(void)
 	{
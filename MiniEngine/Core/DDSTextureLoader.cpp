@@ -26,6 +26,7 @@
 #include "GpuResource.h"
 #include "GraphicsCore.h"
 #include "CommandContext.h"
+#include "UploadManager.h"
 #include "Utility.h"
 
 struct handle_closer { void operator()(HANDLE h) { if (h) CloseHandle(h); } };
@@ -34,33 +35,26 @@ inline HANDLE safe_handle( HANDLE h ) { return (h == INVALID_HANDLE_VALUE) ? 0 :
 
 
 //--------------------------------------------------------------------------------------
-static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
-                                        std::unique_ptr<uint8_t[]>& ddsData,
-                                        DDS_HEADER** header,
-                                        uint8_t** bitData,
-                                        size_t* bitSize
-                                      )
+static HRESULT OpenDDSFile( _In_z_ const wchar_t* fileName,
+                            ScopedHandle& hFile,
+                            size_t* fileSize
+                          )
 {
-    if (!header || !bitData || !bitSize)
-    {
-        return E_POINTER;
-    }
-
     // open the file
 #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
-    ScopedHandle hFile( safe_handle( CreateFile2( fileName,
-                                                  GENERIC_READ,
-                                                  FILE_SHARE_READ,
-                                                  OPEN_EXISTING,
-                                                  nullptr ) ) );
+    hFile.reset( safe_handle( CreateFile2( fileName,
+                                           GENERIC_READ,
+                                           FILE_SHARE_READ,
+                                           OPEN_EXISTING,
+                                           nullptr ) ) );
 #else
-    ScopedHandle hFile( safe_handle( CreateFileW( fileName,
-                                                  GENERIC_READ,
-                                                  FILE_SHARE_READ,
-                                                  nullptr,
-                                                  OPEN_EXISTING,
-                                                  FILE_ATTRIBUTE_NORMAL,
-                                                  nullptr ) ) );
+    hFile.reset( safe_handle( CreateFileW( fileName,
+                                           GENERIC_READ,
+                                           FILE_SHARE_READ,
+                                           nullptr,
+                                           OPEN_EXISTING,
+                                           FILE_ATTRIBUTE_NORMAL,
+                                           nullptr ) ) );
 #endif
 
     if ( !hFile )
@@ -94,65 +88,33 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
         return E_FAIL;
     }
 
-    // create enough space for the file data
-    ddsData.reset( new (std::nothrow) uint8_t[ FileSize.LowPart ] );
-    if (!ddsData)
-    {
-        return E_OUTOFMEMORY;
-    }
-
-    // read the data in
-    DWORD BytesRead = 0;
-    if (!ReadFile( hFile.get(),
-                   ddsData.get(),
-                   FileSize.LowPart,
-                   &BytesRead,
-                   nullptr
-                 ))
-    {
-        return HRESULT_FROM_WIN32( GetLastError() );
-    }
-
-    if (BytesRead < FileSize.LowPart)
-    {
-        return E_FAIL;
-    }
-
-    // DDS files always start with the same magic number ("DDS ")
-    uint32_t dwMagicNumber = *( const uint32_t* )( ddsData.get() );
-    if (dwMagicNumber != DDS_MAGIC)
-    {
-        return E_FAIL;
-    }
+    *fileSize = FileSize.LowPart;
+    return S_OK;
+}
 
-    auto hdr = reinterpret_cast<DDS_HEADER*>( ddsData.get() + sizeof( uint32_t ) );
 
-    // Verify header to validate DDS file
-    if (hdr->size != sizeof(DDS_HEADER) ||
-        hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+//--------------------------------------------------------------------------------------
+static HRESULT ReadFileRange( _In_ HANDLE hFile,
+                              _In_ size_t offset,
+                              _In_ size_t size,
+                              _Out_writes_bytes_(size) uint8_t* dest
+                            )
+{
+    LARGE_INTEGER FilePos;
+    FilePos.QuadPart = static_cast<LONGLONG>( offset );
+    if (!SetFilePointerEx( hFile, FilePos, nullptr, FILE_BEGIN ))
     {
-        return E_FAIL;
+        return HRESULT_FROM_WIN32( GetLastError() );
     }
 
-    size_t offset = sizeof( uint32_t ) + sizeof( DDS_HEADER );
-
-    // Check for extensions
-    if (hdr->ddspf.flags & DDS_FOURCC)
+    // Files larger than 4 GB were rejected when they were opened
+    DWORD BytesRead = 0;
+    if (!ReadFile( hFile, dest, static_cast<DWORD>( size ), &BytesRead, nullptr ))
     {
-		if (MAKEFOURCC( 'D', 'X', '1', '0' ) == hdr->ddspf.fourCC)
-			offset += sizeof(DDS_HEADER_DXT10);
+        return HRESULT_FROM_WIN32( GetLastError() );
     }
 
-    // Must be long enough for all headers and magic value
-    if (FileSize.LowPart < offset)
-        return E_FAIL;
-
-    // setup the pointers in the process request
-    *header = hdr;
-    *bitData = ddsData.get() + offset;
-    *bitSize = FileSize.LowPart - offset;
-
-    return S_OK;
+    return (BytesRead < size) ? HRESULT_FROM_WIN32( ERROR_HANDLE_EOF ) : S_OK;
 }
 
 
@@ -306,6 +268,42 @@ size_t BitsPerPixel( _In_ DXGI_FORMAT fmt )
 }
 
 
+//--------------------------------------------------------------------------------------
+// Block compressed formats need the top mip of a texture to be a whole number of 4x4 blocks
+//--------------------------------------------------------------------------------------
+static bool IsBlockCompressed( _In_ DXGI_FORMAT fmt )
+{
+    switch( fmt )
+    {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
 //--------------------------------------------------------------------------------------
 // Get surface information for a particular format
 //--------------------------------------------------------------------------------------
@@ -686,127 +684,127 @@ static DXGI_FORMAT MakeSRGB( _In_ DXGI_FORMAT format )
 
 
 //--------------------------------------------------------------------------------------
-static HRESULT FillInitData( _In_ size_t width,
-                             _In_ size_t height,
-                             _In_ size_t depth,
-                             _In_ size_t mipCount,
-                             _In_ size_t arraySize,
-                             _In_ DXGI_FORMAT format,
-                             _In_ size_t maxsize,
-                             _In_ size_t bitSize,
-                             _In_reads_bytes_(bitSize) const uint8_t* bitData,
-                             _Out_ size_t& twidth,
-                             _Out_ size_t& theight,
-                             _Out_ size_t& tdepth,
-                             _Out_ size_t& skipMip,
-                             _Out_writes_(mipCount*arraySize) D3D12_SUBRESOURCE_DATA* initData )
+// Point initData at numMips mips of each array slice, starting at firstMip.  bitData holds the first of those
+// mips for slice 0, and each following slice starts sliceStride bytes later.
+//--------------------------------------------------------------------------------------
+static void FillInitData( _In_ const DDS_TEXTURE_LAYOUT& layout,
+                          _In_ size_t firstMip,
+                          _In_ size_t numMips,
+                          _In_ const uint8_t* bitData,
+                          _In_ size_t sliceStride,
+                          _Out_writes_(numMips*layout.arraySize) D3D12_SUBRESOURCE_DATA* initData )
 {
-    if ( !bitData || !initData )
+    const size_t firstOffset = layout.mips[firstMip].offset;
+
+    size_t index = 0;
+    for( size_t j = 0; j < layout.arraySize; j++ )
     {
-        return E_POINTER;
+        const uint8_t* pSliceBits = bitData + j * sliceStride;
+
+        for( size_t i = firstMip; i < firstMip + numMips; i++ )
+        {
+            const DDS_MIP_LAYOUT& mip = layout.mips[i];
+            initData[index].pData = ( const void* )( pSliceBits + mip.offset - firstOffset );
+            initData[index].RowPitch = static_cast<LONG_PTR>( mip.rowPitch );
+            initData[index].SlicePitch = static_cast<LONG_PTR>( mip.slicePitch );
+            ++index;
+        }
     }
+}
 
-    skipMip = 0;
-    twidth = 0;
-    theight = 0;
-    tdepth = 0;
 
-    size_t NumBytes = 0;
-    size_t RowBytes = 0;
-    const uint8_t* pSrcBits = bitData;
-    const uint8_t* pEndBits = bitData + bitSize;
+//--------------------------------------------------------------------------------------
+static void CreateTextureView( _In_ ID3D12Device* d3dDevice,
+                               _In_ ID3D12Resource* tex,
+                               _In_ const DDS_TEXTURE_LAYOUT& layout,
+                               _In_ DXGI_FORMAT format,
+                               _In_ size_t mipCount,
+                               _In_ size_t mostDetailedMip,
+                               _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+{
+    const UINT MostDetailedMip = static_cast<UINT>( mostDetailedMip );
+    const UINT MipLevels = static_cast<UINT>( mipCount - mostDetailedMip );
+    const UINT ArraySize = static_cast<UINT>( layout.arraySize );
 
-    size_t index = 0;
-    for( size_t j = 0; j < arraySize; j++ )
+    D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+    SRVDesc.Format = format;
+    SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+    switch ( layout.resDim )
     {
-        size_t w = width;
-        size_t h = height;
-        size_t d = depth;
-        for( size_t i = 0; i < mipCount; i++ )
+    case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+        if (ArraySize > 1)
         {
-            GetSurfaceInfo( w,
-                            h,
-                            format,
-                            &NumBytes,
-                            &RowBytes,
-                            nullptr
-                          );
-
-            if ( (mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize) )
-            {
-                if ( !twidth )
-                {
-                    twidth = w;
-                    theight = h;
-                    tdepth = d;
-                }
-
-                assert(index < mipCount * arraySize);
-                _Analysis_assume_(index < mipCount * arraySize);
-                initData[index].pData = ( const void* )pSrcBits;
-                initData[index].RowPitch = static_cast<UINT>( RowBytes );
-                initData[index].SlicePitch = static_cast<UINT>( NumBytes );
-                ++index;
-            }
-            else if ( !j )
-            {
-                // Count number of skipped mipmaps (first item only)
-                ++skipMip;
-            }
+            SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
+            SRVDesc.Texture1DArray.MostDetailedMip = MostDetailedMip;
+            SRVDesc.Texture1DArray.MipLevels = MipLevels;
+            SRVDesc.Texture1DArray.ArraySize = ArraySize;
+        }
+        else
+        {
+            SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
+            SRVDesc.Texture1D.MostDetailedMip = MostDetailedMip;
+            SRVDesc.Texture1D.MipLevels = MipLevels;
+        }
+        break;
 
-            if (pSrcBits + (NumBytes*d) > pEndBits)
+    case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
+        if ( layout.isCubeMap )
+        {
+            if (ArraySize > 6)
             {
-                return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
-            }
-  
-            pSrcBits += NumBytes * d;
+                SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+                SRVDesc.TextureCubeArray.MostDetailedMip = MostDetailedMip;
+                SRVDesc.TextureCubeArray.MipLevels = MipLevels;
 
-            w = w >> 1;
-            h = h >> 1;
-            d = d >> 1;
-            if (w == 0)
-            {
-                w = 1;
+                // Earlier we set arraySize to (NumCubes * 6)
+                SRVDesc.TextureCubeArray.NumCubes = ArraySize / 6;
             }
-            if (h == 0)
+            else
             {
-                h = 1;
-            }
-            if (d == 0)
-            {
-                d = 1;
+                SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+                SRVDesc.TextureCube.MostDetailedMip = MostDetailedMip;
+                SRVDesc.TextureCube.MipLevels = MipLevels;
             }
         }
+        else if (ArraySize > 1)
+        {
+            SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+            SRVDesc.Texture2DArray.MostDetailedMip = MostDetailedMip;
+            SRVDesc.Texture2DArray.MipLevels = MipLevels;
+            SRVDesc.Texture2DArray.ArraySize = ArraySize;
+        }
+        else
+        {
+            SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            SRVDesc.Texture2D.MostDetailedMip = MostDetailedMip;
+            SRVDesc.Texture2D.MipLevels = MipLevels;
+        }
+        break;
+
+    case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+        SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        SRVDesc.Texture3D.MostDetailedMip = MostDetailedMip;
+        SRVDesc.Texture3D.MipLevels = MipLevels;
+        break;
     }
 
-    return (index > 0) ? S_OK : E_FAIL;
+    d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
 }
 
 
 //--------------------------------------------------------------------------------------
 static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
-                                   _In_ uint32_t resDim,
-                                   _In_ size_t width,
-                                   _In_ size_t height,
-                                   _In_ size_t depth,
+                                   _In_ const DDS_TEXTURE_LAYOUT& layout,
+                                   _In_ size_t topMip,
                                    _In_ size_t mipCount,
-                                   _In_ size_t arraySize,
                                    _In_ DXGI_FORMAT format,
-                                   _In_ bool forceSRGB,
-                                   _In_ bool isCubeMap,
-                                   _In_reads_opt_(mipCount*arraySize) D3D12_SUBRESOURCE_DATA* initData,
-                                   _Outptr_opt_ ID3D12Resource** texture,
-                                   _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+                                   _Outptr_ ID3D12Resource** texture )
 {
     if ( !d3dDevice )
         return E_POINTER;
 
-    HRESULT hr = E_FAIL;
-
-    if ( forceSRGB )
-    {
-        format = MakeSRGB( format );
-    }
+    const DDS_MIP_LAYOUT& top = layout.mips[topMip];
 
 	D3D12_HEAP_PROPERTIES HeapProps;
 	HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
@@ -816,167 +814,202 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
 	HeapProps.VisibleNodeMask = 1;
 
 	D3D12_RESOURCE_DESC ResourceDesc;
+	ResourceDesc.Dimension = layout.resDim;
 	ResourceDesc.Alignment = 0;
-	ResourceDesc.Width = static_cast<UINT64>( width );
-	ResourceDesc.Height = static_cast<UINT>( height );
-	ResourceDesc.DepthOrArraySize = static_cast<UINT>( arraySize );
-	ResourceDesc.MipLevels = static_cast<UINT>( mipCount );
+	ResourceDesc.Width = static_cast<UINT64>( top.width );
+	ResourceDesc.Height = static_cast<UINT>( top.height );
+	ResourceDesc.DepthOrArraySize = static_cast<UINT16>( layout.resDim == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? top.depth : layout.arraySize );
+	ResourceDesc.MipLevels = static_cast<UINT16>( mipCount );
 	ResourceDesc.Format = format;
 	ResourceDesc.SampleDesc.Count = 1;
 	ResourceDesc.SampleDesc.Quality = 0;
 	ResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 	ResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    switch ( resDim ) 
+    return d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, MY_IID_PPV_ARGS(texture));
+}
+
+
+//--------------------------------------------------------------------------------------
+// Upload numMips mips of every array slice, starting at firstMip, to a texture with resourceMips mips.  When only
+// part of each mip chain is written, the slices are not a contiguous run of subresources and are uploaded one at
+// a time.
+//--------------------------------------------------------------------------------------
+static void UploadMips( _In_ ID3D12Resource* tex,
+                        _In_ size_t arraySize,
+                        _In_ size_t resourceMips,
+                        _In_ size_t firstMip,
+                        _In_ size_t numMips,
+                        _In_ D3D12_SUBRESOURCE_DATA* initData,
+                        _In_ bool waitForUpload )
+{
+    GpuResource DestTexture(tex, D3D12_RESOURCE_STATE_COMMON);
+
+    const size_t numUploads = (numMips == resourceMips) ? 1 : arraySize;
+    const size_t subresourcesPerUpload = (numMips == resourceMips) ? numMips * arraySize : numMips;
+
+    uint64_t LastUploadID = 0;
+
+    for( size_t j = 0; j < numUploads; j++ )
     {
-        case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
-            {
-				ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE1D;
+        UINT FirstSubresource = static_cast<UINT>( j * resourceMips + firstMip );
+        UINT NumSubresources = static_cast<UINT>( subresourcesPerUpload );
+        D3D12_SUBRESOURCE_DATA* SubData = initData + j * subresourcesPerUpload;
+
+        // Without the upload manager, InitializeTexture() waits for the copy itself
+        if ( waitForUpload && Graphics::g_UploadManager.CanUpload(DestTexture) )
+            LastUploadID = Graphics::g_UploadManager.UploadTexture(DestTexture, FirstSubresource, NumSubresources, SubData);
+        else
+            CommandContext::InitializeTexture(DestTexture, NumSubresources, SubData, FirstSubresource);
+    }
 
-                ID3D12Resource* tex = nullptr;
-                hr = d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
-					D3D12_RESOURCE_STATE_COMMON, nullptr, MY_IID_PPV_ARGS(&tex));
+    if ( LastUploadID != 0 )
+        Graphics::g_UploadManager.WaitForUpload(LastUploadID);
+}
 
-                if (SUCCEEDED( hr ) && tex != nullptr)
-                {
-					D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
-                    SRVDesc.Format = format;
-					SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-
-                    if (arraySize > 1)
-                    {
-						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
-                        SRVDesc.Texture1DArray.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
-						SRVDesc.Texture1DArray.ArraySize = static_cast<UINT>( arraySize );
-                    }
-                    else
-                    {
-						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
-                        SRVDesc.Texture1D.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
-                    }
-
-                    d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
-
-                    if (texture != nullptr)
-                    {
-                        *texture = tex;
-                    }
-                    else
-                    {
-                        tex->SetName(L"DDSTextureLoader");
-                        tex->Release();
-                    }
-                }
-            }
-           break;
 
-        case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
-            {
-				ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+//--------------------------------------------------------------------------------------
+// Create the texture and upload the mips kept by the layout.  bitData holds the first kept mip of slice 0, and
+// each following slice starts sliceStride bytes later.
+//--------------------------------------------------------------------------------------
+static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
+                                     _In_ const DDS_TEXTURE_LAYOUT& layout,
+                                     _In_ const uint8_t* bitData,
+                                     _In_ size_t sliceStride,
+                                     _In_ unsigned int loadFlags,
+                                     _Outptr_opt_ ID3D12Resource** texture,
+                                     _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+{
+    const size_t skipMip = layout.skipMip;
+    const size_t loadMips = layout.mipCount - skipMip;
 
-                ID3D12Resource* tex = nullptr;
-                hr = d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
-					D3D12_RESOURCE_STATE_COMMON, nullptr, MY_IID_PPV_ARGS(&tex));
+    // With reserved mips, the resource keeps the file's full mip chain and the loaded mips start at skipMip
+    const bool reserveMips = (loadFlags & DDS_LOADER_RESERVE_SKIPPED_MIPS) != 0;
+    const size_t resourceMips = reserveMips ? layout.mipCount : loadMips;
+    const size_t firstLoadedMip = reserveMips ? skipMip : 0;
 
-                if (SUCCEEDED( hr ) && tex != 0)
-                {
-					D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
-                    SRVDesc.Format = format;
-					SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-
-					if ( isCubeMap )
-					{
-                        if (arraySize > 6)
-                        {
-                            SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
-                            SRVDesc.TextureCubeArray.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
-
-                            // Earlier we set arraySize to (NumCubes * 6)
-                            SRVDesc.TextureCubeArray.NumCubes = static_cast<UINT>( arraySize / 6 );
-                        }
-                        else
-                        {
-                            SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-                            SRVDesc.TextureCube.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
-                        }
-					}
-                    else if (arraySize > 1)
-                    {
-						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-                        SRVDesc.Texture2DArray.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
-						SRVDesc.Texture2DArray.ArraySize = static_cast<UINT>( arraySize );
-                    }
-                    else
-                    {
-						SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-                        SRVDesc.Texture2D.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
-						SRVDesc.Texture2D.MostDetailedMip = 0;
-                    }
-
-                    d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
-
-                    if (texture != nullptr)
-                    {
-                        *texture = tex;
-                    }
-                    else
-                    {
-                        tex->SetName(L"DDSTextureLoader");
-                        tex->Release();
-                    }
-                }
-            }
-            break;
+    DXGI_FORMAT format = layout.format;
+    if ( loadFlags & DDS_LOADER_FORCE_SRGB )
+    {
+        format = MakeSRGB( format );
+    }
 
-        case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
-            {
-				ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
-				ResourceDesc.DepthOrArraySize = static_cast<UINT>( depth );
+    std::unique_ptr<D3D12_SUBRESOURCE_DATA[]> initData( new (std::nothrow) D3D12_SUBRESOURCE_DATA[loadMips * layout.arraySize] );
+    if ( !initData )
+    {
+        return E_OUTOFMEMORY;
+    }
 
-                ID3D12Resource* tex = nullptr;
-                hr = d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
-					D3D12_RESOURCE_STATE_COMMON, nullptr, MY_IID_PPV_ARGS(&tex));
+    FillInitData( layout, skipMip, loadMips, bitData, sliceStride, initData.get() );
 
-                if (SUCCEEDED( hr ) && tex != nullptr)
-                {
-					D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
-                    SRVDesc.Format = format;
-					SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-
-					SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
-                    SRVDesc.Texture3D.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
-					SRVDesc.Texture3D.MostDetailedMip = 0;
-
-                    d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
-
-                    if (texture != nullptr)
-                    {
-                        *texture = tex;
-                    }
-                    else
-                    {
-                        tex->SetName(L"DDSTextureLoader");
-                        tex->Release();
-                    }
-                }
-            }
-           break;
+    ID3D12Resource* tex = nullptr;
+    HRESULT hr = CreateD3DResources( d3dDevice, layout, skipMip - firstLoadedMip, resourceMips, format, &tex );
+    if ( FAILED(hr) )
+    {
+        return hr;
     }
 
-    return hr;
+    CreateTextureView( d3dDevice, tex, layout, format, resourceMips, firstLoadedMip, textureView );
+    UploadMips( tex, layout.arraySize, resourceMips, firstLoadedMip, loadMips, initData.get(), false );
+
+    tex->SetName(L"DDSTextureLoader");
+
+    if (texture != nullptr)
+    {
+        *texture = tex;
+    }
+    else
+    {
+        tex->Release();
+    }
+
+    return S_OK;
 }
 
+
 //--------------------------------------------------------------------------------------
-static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
-                                     _In_ const DDS_HEADER* header,
-                                     _In_reads_bytes_(bitSize) const uint8_t* bitData,
-                                     _In_ size_t bitSize,
-                                     _In_ size_t maxsize,
-                                     _In_ bool forceSRGB,
-                                     _Outptr_opt_ ID3D12Resource** texture,
-                                     _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+static DDS_ALPHA_MODE GetAlphaMode( _In_ const DDS_HEADER* header )
+{
+    if ( header->ddspf.flags & DDS_FOURCC )
+    {
+        if ( MAKEFOURCC( 'D', 'X', '1', '0' ) == header->ddspf.fourCC )
+        {
+            auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>( (const char*)header + sizeof(DDS_HEADER) );
+            auto mode = static_cast<DDS_ALPHA_MODE>( d3d10ext->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK );
+            switch( mode )
+            {
+            case DDS_ALPHA_MODE_STRAIGHT:
+            case DDS_ALPHA_MODE_PREMULTIPLIED:
+            case DDS_ALPHA_MODE_OPAQUE:
+            case DDS_ALPHA_MODE_CUSTOM:
+                return mode;
+            }
+        }
+        else if ( ( MAKEFOURCC( 'D', 'X', 'T', '2' ) == header->ddspf.fourCC )
+                  || ( MAKEFOURCC( 'D', 'X', 'T', '4' ) == header->ddspf.fourCC ) )
+        {
+            return DDS_ALPHA_MODE_PREMULTIPLIED;
+        }
+    }
+
+    return DDS_ALPHA_MODE_UNKNOWN;
+}
+
+
+_Use_decl_annotations_
+HRESULT GetDDSTextureLayout(
+    const uint8_t* headerData,
+    size_t headerDataSize,
+    size_t maxsize,
+    size_t skipMips,
+    DDS_TEXTURE_LAYOUT* layout,
+    DDS_ALPHA_MODE* alphaMode )
 {
-    HRESULT hr = S_OK;
+    if ( alphaMode )
+    {
+        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+    }
+
+    if (!headerData || !layout)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (headerDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+    {
+        return E_FAIL;
+    }
+
+    uint32_t dwMagicNumber = *( const uint32_t* )( headerData );
+    if (dwMagicNumber != DDS_MAGIC)
+    {
+        return E_FAIL;
+    }
+
+    auto header = reinterpret_cast<const DDS_HEADER*>( headerData + sizeof( uint32_t ) );
+
+    // Verify header to validate DDS file
+    if (header->size != sizeof(DDS_HEADER) ||
+        header->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    {
+        return E_FAIL;
+    }
+
+    size_t offset = sizeof(DDS_HEADER) + sizeof(uint32_t);
+
+    // Check for extensions
+    if (header->ddspf.flags & DDS_FOURCC)
+    {
+        if (MAKEFOURCC( 'D', 'X', '1', '0' ) == header->ddspf.fourCC)
+            offset += sizeof(DDS_HEADER_DXT10);
+    }
+
+    // Must be long enough for all headers and magic value
+    if (headerDataSize < offset)
+        return E_FAIL;
+
+    static_assert(DDS_MAX_HEADER_SIZE == sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10), "DDS_MAX_HEADER_SIZE is wrong");
 
     UINT width = header->width;
     UINT height = header->height;
@@ -1143,83 +1176,103 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
+    // Lay out the mip chain of one array slice and count the top mips to skip
+    layout->resDim = static_cast<D3D12_RESOURCE_DIMENSION>( resDim );
+    layout->format = format;
+    layout->isCubeMap = isCubeMap;
+    layout->mipCount = mipCount;
+    layout->arraySize = arraySize;
+    layout->dataOffset = offset;
+
+    size_t sliceSize = 0;
+    size_t oversizedMips = 0;
+    size_t lastTopMip = 0;
+    const bool blockCompressed = IsBlockCompressed( format );
+
+    size_t w = width;
+    size_t h = height;
+    size_t d = depth;
+    for( size_t i = 0; i < mipCount; i++ )
     {
-        // Create the texture
-		UINT subresourceCount = static_cast<UINT>(mipCount) * arraySize;
-		std::unique_ptr<D3D12_SUBRESOURCE_DATA[]> initData( new (std::nothrow) D3D12_SUBRESOURCE_DATA[subresourceCount] );
-        if ( !initData )
-        {
-            return E_OUTOFMEMORY;
-        }
+        DDS_MIP_LAYOUT& mip = layout->mips[i];
+        mip.width = w;
+        mip.height = h;
+        mip.depth = d;
+        mip.offset = sliceSize;
+        GetSurfaceInfo( w, h, format, &mip.slicePitch, &mip.rowPitch, nullptr );
 
-        size_t skipMip = 0;
-        size_t twidth = 0;
-        size_t theight = 0;
-        size_t tdepth = 0;
-        hr = FillInitData( width, height, depth, mipCount, arraySize, format, maxsize, bitSize, bitData,
-                           twidth, theight, tdepth, skipMip, initData.get() );
+        sliceSize += mip.slicePitch * d;
 
-        if ( SUCCEEDED(hr) )
+        if ( maxsize && (w > maxsize || h > maxsize || d > maxsize) )
         {
-            hr = CreateD3DResources( d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
-                                     format, forceSRGB,
-                                     isCubeMap, initData.get(), texture, textureView );
+            ++oversizedMips;
+        }
 
-            if ( FAILED(hr) && !maxsize && (mipCount > 1) )
-            {
-                // Retry with a maxsize determined by feature level
-                maxsize = (resDim == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
-                            ? 2048 /*D3D10_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
-                            : 8192 /*D3D10_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
-
-                hr = FillInitData( width, height, depth, mipCount, arraySize, format, maxsize, bitSize, bitData,
-                                   twidth, theight, tdepth, skipMip, initData.get() );
-                if ( SUCCEEDED(hr) )
-                {
-                    hr = CreateD3DResources( d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
-                                             format, forceSRGB,
-                                             isCubeMap, initData.get(), texture, textureView );
-                }
-            }
+        if ( !blockCompressed || (w % 4 == 0 && h % 4 == 0) )
+        {
+            lastTopMip = i;
         }
 
-		if (SUCCEEDED(hr))
-		{
-			GpuResource DestTexture(*texture, D3D12_RESOURCE_STATE_COMMON);
-			CommandContext::InitializeTexture(DestTexture, subresourceCount, initData.get());
-		}
-	}
+        w = std::max<size_t>( w >> 1, 1 );
+        h = std::max<size_t>( h >> 1, 1 );
+        d = std::max<size_t>( d >> 1, 1 );
+    }
 
-    return hr;
+    layout->sliceSize = sliceSize;
+    layout->skipMip = std::min( std::max( oversizedMips, skipMips ), lastTopMip );
+
+    if ( alphaMode )
+        *alphaMode = GetAlphaMode( header );
+
+    return S_OK;
 }
 
 
-//--------------------------------------------------------------------------------------
-static DDS_ALPHA_MODE GetAlphaMode( _In_ const DDS_HEADER* header )
+_Use_decl_annotations_
+HRESULT CreateDDSTextureFromMemoryEx(
+    ID3D12Device* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    size_t skipMips,
+    unsigned int loadFlags,
+    ID3D12Resource** texture,
+    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+    DDS_ALPHA_MODE* alphaMode,
+    DDS_TEXTURE_LAYOUT* layout )
 {
-    if ( header->ddspf.flags & DDS_FOURCC )
+    if ( texture )
     {
-        if ( MAKEFOURCC( 'D', 'X', '1', '0' ) == header->ddspf.fourCC )
-        {
-            auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>( (const char*)header + sizeof(DDS_HEADER) );
-            auto mode = static_cast<DDS_ALPHA_MODE>( d3d10ext->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK );
-            switch( mode )
-            {
-            case DDS_ALPHA_MODE_STRAIGHT:
-            case DDS_ALPHA_MODE_PREMULTIPLIED:
-            case DDS_ALPHA_MODE_OPAQUE:
-            case DDS_ALPHA_MODE_CUSTOM:
-                return mode;
-            }
-        }
-        else if ( ( MAKEFOURCC( 'D', 'X', 'T', '2' ) == header->ddspf.fourCC )
-                  || ( MAKEFOURCC( 'D', 'X', 'T', '4' ) == header->ddspf.fourCC ) )
-        {
-            return DDS_ALPHA_MODE_PREMULTIPLIED;
-        }
+        *texture = nullptr;
     }
 
-    return DDS_ALPHA_MODE_UNKNOWN;
+    if (!d3dDevice || !ddsData)
+    {
+        return E_INVALIDARG;
+    }
+
+    DDS_TEXTURE_LAYOUT ddsLayout;
+    HRESULT hr = GetDDSTextureLayout( ddsData, ddsDataSize, maxsize, skipMips, &ddsLayout, alphaMode );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (ddsDataSize < ddsLayout.dataOffset + ddsLayout.sliceSize * ddsLayout.arraySize)
+    {
+        return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+    }
+
+    const uint8_t* bitData = ddsData + ddsLayout.dataOffset + ddsLayout.mips[ddsLayout.skipMip].offset;
+
+    hr = CreateTextureFromDDS( d3dDevice, ddsLayout, bitData, ddsLayout.sliceSize, loadFlags, texture, textureView );
+
+    if ( SUCCEEDED(hr) && layout )
+    {
+        *layout = ddsLayout;
+    }
+
+    return hr;
 }
 
 
@@ -1233,68 +1286,102 @@ HRESULT CreateDDSTextureFromMemory(
 	ID3D12Resource** texture,
 	D3D12_CPU_DESCRIPTOR_HANDLE textureView,
 	DDS_ALPHA_MODE* alphaMode )
+{
+    return CreateDDSTextureFromMemoryEx( d3dDevice, ddsData, ddsDataSize, maxsize, 0,
+                                         forceSRGB ? DDS_LOADER_FORCE_SRGB : DDS_LOADER_DEFAULT,
+                                         texture, textureView, alphaMode );
+}
+
+
+_Use_decl_annotations_
+HRESULT CreateDDSTextureFromFileEx(
+    ID3D12Device* d3dDevice,
+    const wchar_t* fileName,
+    size_t maxsize,
+    size_t skipMips,
+    unsigned int loadFlags,
+    ID3D12Resource** texture,
+    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+    DDS_ALPHA_MODE* alphaMode,
+    DDS_TEXTURE_LAYOUT* layout )
 {
     if ( texture )
     {
         *texture = nullptr;
     }
 
-	if ( alphaMode )
+    if ( alphaMode )
     {
         *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
     }
 
-    if (!d3dDevice || !ddsData)
+    if (!d3dDevice || !fileName)
     {
         return E_INVALIDARG;
     }
 
-    // Validate DDS file in memory
-    if (ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+    ScopedHandle hFile;
+    size_t fileSize = 0;
+    HRESULT hr = OpenDDSFile( fileName, hFile, &fileSize );
+    if (FAILED(hr))
     {
-        return E_FAIL;
+        return hr;
     }
 
-    uint32_t dwMagicNumber = *( const uint32_t* )( ddsData );
-    if (dwMagicNumber != DDS_MAGIC)
+    // Read the headers first so that only the mips being loaded need to be read
+    uint8_t headerData[DDS_MAX_HEADER_SIZE];
+    const size_t headerSize = std::min( fileSize, sizeof(headerData) );
+    hr = ReadFileRange( hFile.get(), 0, headerSize, headerData );
+    if (FAILED(hr))
     {
-        return E_FAIL;
+        return hr;
     }
 
-    auto header = reinterpret_cast<const DDS_HEADER*>( ddsData + sizeof( uint32_t ) );
+    DDS_TEXTURE_LAYOUT ddsLayout;
+    hr = GetDDSTextureLayout( headerData, headerSize, maxsize, skipMips, &ddsLayout, alphaMode );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
 
-    // Verify header to validate DDS file
-    if (header->size != sizeof(DDS_HEADER) ||
-        header->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    if (fileSize < ddsLayout.dataOffset + ddsLayout.sliceSize * ddsLayout.arraySize)
     {
-        return E_FAIL;
+        return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
     }
 
-	size_t offset = sizeof(DDS_HEADER) + sizeof(uint32_t);
+    // The kept mips are the tail of each slice's mip chain
+    const size_t skippedSize = ddsLayout.mips[ddsLayout.skipMip].offset;
+    const size_t keptSize = ddsLayout.sliceSize - skippedSize;
 
-    // Check for extensions
-    if (header->ddspf.flags & DDS_FOURCC)
+    std::unique_ptr<uint8_t[]> bitData( new (std::nothrow) uint8_t[keptSize * ddsLayout.arraySize] );
+    if (!bitData)
     {
-		if (MAKEFOURCC( 'D', 'X', '1', '0' ) == header->ddspf.fourCC)
-			offset += sizeof(DDS_HEADER_DXT10);
+        return E_OUTOFMEMORY;
     }
 
-    // Must be long enough for all headers and magic value
-    if (ddsDataSize < offset)
-        return E_FAIL;
-
-    HRESULT hr = CreateTextureFromDDS( d3dDevice,
-                                       header, ddsData + offset, ddsDataSize - offset, maxsize,
-                                       forceSRGB, texture, textureView );
-    if ( SUCCEEDED(hr) )
+    if (skippedSize == 0)
+    {
+        hr = ReadFileRange( hFile.get(), ddsLayout.dataOffset, keptSize * ddsLayout.arraySize, bitData.get() );
+    }
+    else
     {
-        if (texture != nullptr && *texture != nullptr)
+        for( size_t j = 0; j < ddsLayout.arraySize && SUCCEEDED(hr); j++ )
         {
-			(*texture)->SetName(L"DDSTextureLoader");
+            hr = ReadFileRange( hFile.get(), ddsLayout.dataOffset + j * ddsLayout.sliceSize + skippedSize,
+                                keptSize, bitData.get() + j * keptSize );
         }
+    }
+
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = CreateTextureFromDDS( d3dDevice, ddsLayout, bitData.get(), keptSize, loadFlags, texture, textureView );
 
-        if ( alphaMode )
-            *alphaMode = GetAlphaMode( header );
+    if ( SUCCEEDED(hr) && layout )
+    {
+        *layout = ddsLayout;
     }
 
     return hr;
@@ -1311,38 +1398,81 @@ HRESULT CreateDDSTextureFromFile(
 	D3D12_CPU_DESCRIPTOR_HANDLE textureView,
 	DDS_ALPHA_MODE* alphaMode )
 {
-    if ( texture )
+    return CreateDDSTextureFromFileEx( d3dDevice, fileName, maxsize, 0,
+                                       forceSRGB ? DDS_LOADER_FORCE_SRGB : DDS_LOADER_DEFAULT,
+                                       texture, textureView, alphaMode );
+}
+
+
+_Use_decl_annotations_
+HRESULT LoadDDSSkippedMips(
+    ID3D12Device* d3dDevice,
+    const wchar_t* fileName,
+    const DDS_TEXTURE_LAYOUT& layout,
+    unsigned int loadFlags,
+    ID3D12Resource* texture,
+    D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+{
+    if (!d3dDevice || !fileName || !texture)
     {
-        *texture = nullptr;
+        return E_INVALIDARG;
     }
 
-	if ( alphaMode )
+    if (layout.skipMip == 0)
     {
-        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+        return S_OK;
     }
 
-    if (!d3dDevice || !fileName)
+    // Only a texture created with DDS_LOADER_RESERVE_SKIPPED_MIPS has room for the skipped mips
+    if (texture->GetDesc().MipLevels != layout.mipCount)
     {
         return E_INVALIDARG;
     }
 
-    DDS_HEADER* header = nullptr;
-    uint8_t* bitData = nullptr;
-    size_t bitSize = 0;
+    ScopedHandle hFile;
+    size_t fileSize = 0;
+    HRESULT hr = OpenDDSFile( fileName, hFile, &fileSize );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (fileSize < layout.dataOffset + layout.sliceSize * layout.arraySize)
+    {
+        return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+    }
+
+    // The skipped mips are the head of each slice's mip chain
+    const size_t skippedSize = layout.mips[layout.skipMip].offset;
+
+    std::unique_ptr<uint8_t[]> bitData( new (std::nothrow) uint8_t[skippedSize * layout.arraySize] );
+    std::unique_ptr<D3D12_SUBRESOURCE_DATA[]> initData( new (std::nothrow) D3D12_SUBRESOURCE_DATA[layout.skipMip * layout.arraySize] );
+    if (!bitData || !initData)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    for( size_t j = 0; j < layout.arraySize && SUCCEEDED(hr); j++ )
+    {
+        hr = ReadFileRange( hFile.get(), layout.dataOffset + j * layout.sliceSize, skippedSize,
+                            bitData.get() + j * skippedSize );
+    }
 
-    std::unique_ptr<uint8_t[]> ddsData;
-    HRESULT hr = LoadTextureDataFromFile( fileName, ddsData, &header, &bitData, &bitSize );
     if (FAILED(hr))
     {
         return hr;
     }
 
-    hr = CreateTextureFromDDS( d3dDevice,
-                               header, bitData, bitSize, maxsize,
-                               forceSRGB, texture, textureView );
+    FillInitData( layout, 0, layout.skipMip, bitData.get(), skippedSize, initData.get() );
+    UploadMips( texture, layout.arraySize, layout.mipCount, 0, layout.skipMip, initData.get(), true );
 
-    if ( alphaMode )
-        *alphaMode = GetAlphaMode( header );
+    DXGI_FORMAT format = layout.format;
+    if ( loadFlags & DDS_LOADER_FORCE_SRGB )
+    {
+        format = MakeSRGB( format );
+    }
 
-    return hr;
+    CreateTextureView( d3dDevice, texture, layout, format, layout.mipCount, 0, textureView );
+
+    return S_OK;
 }
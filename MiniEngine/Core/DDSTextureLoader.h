@@ -36,6 +36,57 @@ enum DDS_ALPHA_MODE
     DDS_ALPHA_MODE_CUSTOM        = 4,
 };
 
+enum DDS_LOADER_FLAGS
+{
+    DDS_LOADER_DEFAULT              = 0,
+    DDS_LOADER_FORCE_SRGB           = 0x1,
+
+    // Create the texture with its full mip chain but upload only the mips that were loaded.  The view starts at
+    // the first loaded mip until LoadDDSSkippedMips() fills in the rest.
+    DDS_LOADER_RESERVE_SKIPPED_MIPS = 0x2,
+};
+
+// The magic number and headers never take more than this many bytes at the start of a DDS file
+const size_t DDS_MAX_HEADER_SIZE = 148;
+
+struct DDS_MIP_LAYOUT
+{
+    size_t width;
+    size_t height;
+    size_t depth;
+    size_t rowPitch;
+    size_t slicePitch;      // Bytes in one depth slice
+    size_t offset;          // From the start of the array slice
+};
+
+// Where each surface of a DDS file lies, computed from the headers alone.  The file stores one array slice (or
+// cube face) at a time with its whole mip chain, so the mips that remain after skipping the top ones form one
+// contiguous range per slice.
+struct DDS_TEXTURE_LAYOUT
+{
+    D3D12_RESOURCE_DIMENSION resDim;
+    DXGI_FORMAT format;
+    bool isCubeMap;
+    size_t mipCount;        // In the file
+    size_t arraySize;       // Cube faces are counted, so a cube map has six
+    size_t skipMip;         // Number of top mips left out of the load
+    size_t dataOffset;      // Where the surface data starts in the file
+    size_t sliceSize;       // Bytes in one array slice, all mips
+    DDS_MIP_LAYOUT mips[D3D12_REQ_MIP_LEVELS];
+};
+
+// Validate the headers and compute the layout without touching surface data.  headerData needs to hold no more
+// than DDS_MAX_HEADER_SIZE bytes.  Top mips are skipped while any dimension is larger than maxsize (when it is
+// not zero), and then until at least skipMips are skipped.  The smallest mip is always left, and for block
+// compressed formats so is the smallest mip whose width and height are multiples of 4.
+HRESULT __cdecl GetDDSTextureLayout( _In_reads_bytes_(headerDataSize) const uint8_t* headerData,
+                                     _In_ size_t headerDataSize,
+                                     _In_ size_t maxsize,
+                                     _In_ size_t skipMips,
+                                     _Out_ DDS_TEXTURE_LAYOUT* layout,
+                                     _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                   );
+
 HRESULT __cdecl CreateDDSTextureFromMemory( _In_ ID3D12Device* d3dDevice,
                                                 _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
                                                 _In_ size_t ddsDataSize,
@@ -55,4 +106,40 @@ HRESULT __cdecl CreateDDSTextureFromFile( _In_ ID3D12Device* d3dDevice,
                                             _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
                                             );
 
+// The file version reads only the headers and the byte ranges of the mips being loaded
+HRESULT __cdecl CreateDDSTextureFromMemoryEx( _In_ ID3D12Device* d3dDevice,
+                                              _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                              _In_ size_t ddsDataSize,
+                                              _In_ size_t maxsize,
+                                              _In_ size_t skipMips,
+                                              _In_ unsigned int loadFlags,
+                                              _Outptr_opt_ ID3D12Resource** texture,
+                                              _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+                                              _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+                                              _Out_opt_ DDS_TEXTURE_LAYOUT* layout = nullptr
+                                            );
+
+HRESULT __cdecl CreateDDSTextureFromFileEx( _In_ ID3D12Device* d3dDevice,
+                                            _In_z_ const wchar_t* szFileName,
+                                            _In_ size_t maxsize,
+                                            _In_ size_t skipMips,
+                                            _In_ unsigned int loadFlags,
+                                            _Outptr_opt_ ID3D12Resource** texture,
+                                            _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+                                            _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+                                            _Out_opt_ DDS_TEXTURE_LAYOUT* layout = nullptr
+                                          );
+
+// Read and upload the top mips skipped when the texture was created with DDS_LOADER_RESERVE_SKIPPED_MIPS, then
+// point the view at the full mip chain.  layout is the one returned when the texture was created, and loadFlags
+// must match too.  The view is rewritten only after the upload completes, but it must not be copied by another
+// thread while it is being rewritten.
+HRESULT __cdecl LoadDDSSkippedMips( _In_ ID3D12Device* d3dDevice,
+                                    _In_z_ const wchar_t* szFileName,
+                                    _In_ const DDS_TEXTURE_LAYOUT& layout,
+                                    _In_ unsigned int loadFlags,
+                                    _In_ ID3D12Resource* texture,
+                                    _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView
+                                  );
+
 size_t BitsPerPixel(_In_ DXGI_FORMAT fmt);
@@ -31,18 +31,19 @@ using namespace Graphics;
 
 std::mutex DynamicDescriptorHeap::sm_Mutex;
 std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DynamicDescriptorHeap::sm_DescriptorHeapPool;
-std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> DynamicDescriptorHeap::sm_RetiredDescriptorHeaps;
 std::queue<ID3D12DescriptorHeap*> DynamicDescriptorHeap::sm_AvailableDescriptorHeaps;
 uint32_t DynamicDescriptorHeap::sm_DescriptorSize = 0;
 
 ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(void)
 {
-	std::lock_guard<std::mutex> LockGuard(sm_Mutex);
+	std::unique_lock<std::mutex> Lock(sm_Mutex);
 
-	while (!sm_RetiredDescriptorHeaps.empty() && g_CommandManager.IsFenceComplete(sm_RetiredDescriptorHeaps.front().first))
+	// Retired heaps return when their fence callbacks run, which take sm_Mutex
+	if (sm_AvailableDescriptorHeaps.empty())
 	{
-		sm_AvailableDescriptorHeaps.push(sm_RetiredDescriptorHeaps.front().second);
-		sm_RetiredDescriptorHeaps.pop();
+		Lock.unlock();
+		g_CommandManager.ProcessCompletedFences();
+		Lock.lock();
 	}
 
 	if (!sm_AvailableDescriptorHeaps.empty())
@@ -67,9 +68,15 @@ ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(void)
 
 void DynamicDescriptorHeap::DiscardDescriptorHeaps( uint64_t FenceValue, const std::vector<ID3D12DescriptorHeap*>& UsedHeaps )
 {
-	std::lock_guard<std::mutex> LockGuard(sm_Mutex);
-	for (auto iter = UsedHeaps.begin(); iter != UsedHeaps.end(); ++iter)
-		sm_RetiredDescriptorHeaps.push(std::make_pair(FenceValue, *iter));
+	if (UsedHeaps.empty())
+		return;
+
+	g_CommandManager.OnFenceComplete(FenceValue, [UsedHeaps]( void )
+	{
+		std::lock_guard<std::mutex> LockGuard(sm_Mutex);
+		for (auto iter = UsedHeaps.begin(); iter != UsedHeaps.end(); ++iter)
+			sm_AvailableDescriptorHeaps.push(*iter);
+	});
 }
 
 void DynamicDescriptorHeap::RetireCurrentHeap( void )
@@ -32,7 +32,11 @@ public:
 	DynamicDescriptorHeap(CommandContext& OwningContext);
 	~DynamicDescriptorHeap();
 
-	static void DestroyAll(void) { sm_DescriptorHeapPool.clear(); }
+	static void DestroyAll(void)
+	{
+		sm_AvailableDescriptorHeaps = std::queue<ID3D12DescriptorHeap*>();
+		sm_DescriptorHeapPool.clear();
+	}
 
 	void CleanupUsedHeaps( uint64_t fenceValue );
 
@@ -87,7 +91,6 @@ private:
 	static const uint32_t kNumDescriptorsPerHeap = 1024;
 	static std::mutex sm_Mutex;
 	static std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> sm_DescriptorHeapPool;
-	static std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> sm_RetiredDescriptorHeaps;
 	static std::queue<ID3D12DescriptorHeap*> sm_AvailableDescriptorHeaps;
 	static uint32_t sm_DescriptorSize;
 
@@ -338,6 +338,13 @@ public:
 
 	static void PushProfilingMarker( const wstring& name, CommandContext* Context );
 	static void PopProfilingMarker( CommandContext* Context );
+	static uint32_t GetDepth( void )
+	{
+		uint32_t Depth = 0;
+		for (NestedTimingTree* node = sm_CurrentNode; node != nullptr && node != &sm_RootScope; node = node->m_Parent)
+			++Depth;
+		return Depth;
+	}
 	static void Update( void );
 	static void UpdateTimes( void )
 	{
@@ -359,6 +366,7 @@ public:
 	static float GetTotalCpuTime(void) { return s_TotalCpuTime.GetAvg(); }
 	static float GetTotalGpuTime(void) { return s_TotalGpuTime.GetAvg(); }
 	static float GetFrameDelta(void) { return s_FrameDelta.GetAvg(); }
+	static float GetLastFrameDelta(void) { return s_FrameDelta.GetLast(); }
 
 	static void Display( TextContext& Text, float x )
 	{
@@ -448,11 +456,21 @@ namespace EngineProfiling
 		NestedTimingTree::PopProfilingMarker(Context);
 	}
 
+	uint32_t GetBlockDepth()
+	{
+		return NestedTimingTree::GetDepth();
+	}
+
 	bool IsPaused()
 	{
 		return Paused;
 	}
 
+	float GetGpuFrameTime( void )
+	{
+		return NestedTimingTree::GetLastFrameDelta();
+	}
+
 	void DisplayFrameRate( TextContext& Text )
 	{
 		if (!DrawFrameRate)
@@ -508,6 +526,10 @@ void NestedTimingTree::PushProfilingMarker( const wstring& name, CommandContext*
 
 void NestedTimingTree::PopProfilingMarker( CommandContext* Context )
 {
+	ASSERT(sm_CurrentNode != &sm_RootScope, "EndBlock() without a matching BeginBlock()");
+	if (sm_CurrentNode == &sm_RootScope)
+		return;
+
 	sm_CurrentNode->StopTiming(Context);
 	sm_CurrentNode = sm_CurrentNode->m_Parent;
 }
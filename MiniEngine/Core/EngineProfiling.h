@@ -25,6 +25,12 @@ namespace EngineProfiling
 	void BeginBlock(const std::wstring& name, CommandContext* Context = nullptr);
 	void EndBlock(CommandContext* Context = nullptr);
 
+	// The number of blocks begun and not yet ended
+	uint32_t GetBlockDepth();
+
+	// Seconds between the starts of the last two frames on the GPU.  When GPU bound, this is the GPU frame time.
+	float GetGpuFrameTime();
+
 	void DisplayFrameRate(TextContext& Text);
 	void DisplayPerfGraph(GraphicsContext& Text);
 	void Display(TextContext& Text, float x, float y, float w, float h);
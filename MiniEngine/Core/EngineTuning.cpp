@@ -165,7 +165,7 @@ void VariableGroup::SaveToFile( FILE* file, int fileMargin )
 			fprintf(file, "%*c + %s ...\r\n", fileMargin, ' ', buffer);
 			subGroup->SaveToFile(file, fileMargin + 5);
 		}
-		else if (dynamic_cast<CallbackTrigger*>(iter->second) == nullptr)
+		else if (dynamic_cast<CallbackTrigger*>(iter->second) == nullptr && dynamic_cast<StatVar*>(iter->second) == nullptr)
 		{
 			fprintf(file, "%*c %s:  %s\r\n", fileMargin, ' ', buffer, iter->second->ToString().c_str());
 		}		
@@ -498,6 +498,25 @@ void CallbackTrigger::SetValue(FILE* file, const std::string& setting)
 	fscanf_s(file, scanString.c_str(), skippedLines, _countof(skippedLines));
 }
 
+StatVar::StatVar( const std::string& path, const char* format )
+	: EngineVar(path)
+{
+	m_Value = 0.0f;
+	m_Format = format;
+}
+
+void StatVar::DisplayValue( TextContext& Text ) const
+{
+	Text.DrawFormattedString(m_Format, m_Value);
+}
+
+std::string StatVar::ToString( void ) const
+{
+	char buf[128];
+	sprintf_s(buf, m_Format, m_Value);
+	return buf;
+}
+
 //=====================================================================================================================
 // EngineTuning namespace methods
 
@@ -618,7 +637,8 @@ void EngineTuning::Display( GraphicsContext& Context, float x, float y, float w,
 	s_ScrollTopTrigger = y + h * 0.2f;
 	s_ScrollBottomTrigger = y + h * 0.8f;
 
-	Context.SetScissor((uint32_t)Floor(x), (uint32_t)Floor(y), (uint32_t)Ceiling(x + w), (uint32_t)Ceiling(y + h));
+	// Text is batched, so go through the text context to keep the frame rate outside of the scissor
+	Text.GetCommandContext().SetScissor((uint32_t)Floor(x), (uint32_t)Floor(y), (uint32_t)Ceiling(x + w), (uint32_t)Ceiling(y + h));
 
 	Text.ResetCursor(x, y - s_ScrollOffset );
 	Text.SetColor( Color(0.5f, 1.0f, 1.0f) );
@@ -627,7 +647,7 @@ void EngineTuning::Display( GraphicsContext& Context, float x, float y, float w,
 
 	VariableGroup::sm_RootGroup.Display( Text, x, sm_SelectedVariable );
 	
-	EngineProfiling::DisplayPerfGraph(Context);
+	EngineProfiling::DisplayPerfGraph(Text.GetCommandContext());
 
 	Text.End();
 	Context.SetScissor(0, 0, 1920, 1080);
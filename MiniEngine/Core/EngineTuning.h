@@ -165,6 +165,24 @@ private:
 	mutable uint32_t m_BangDisplay;
 };
 
+// A value measured by the engine and shown alongside the tunable variables.  It cannot be edited and is not
+// saved with the settings.
+class StatVar : public EngineVar
+{
+public:
+	StatVar( const std::string& path, const char* format = "%-11.3f" );
+	StatVar& operator=( float val ) { m_Value = val; return *this; }
+	operator float() const { return m_Value; }
+
+	virtual void DisplayValue( TextContext& Text ) const override;
+	virtual std::string ToString( void ) const override;
+	virtual void SetValue( FILE* file, const std::string& setting ) override {}
+
+private:
+	float m_Value;
+	const char* m_Format;
+};
+
 class GraphicsContext;
 
 namespace EngineTuning
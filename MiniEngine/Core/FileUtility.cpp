@@ -130,8 +130,14 @@ ByteArray Utility::ReadFileSync( const wstring& fileName)
 	return ReadFileHelperEx(make_shared<wstring>(fileName));
 }
 
-task<ByteArray> Utility::ReadFileAsync(const wstring& fileName)
+ByteArray Utility::ReadFileAsync(const wstring& fileName, JobSystem::Counter& ReadCounter)
 {
 	shared_ptr<wstring> SharedPtr = make_shared<wstring>(fileName);
-	return create_task( [=] { return ReadFileHelperEx(SharedPtr); } );
+	ByteArray Result = make_shared<vector<byte> >();
+	JobSystem::Run( [=] {
+		ByteArray Contents = ReadFileHelperEx(SharedPtr);
+		if (Contents != NullFile)
+			Result->swap(*Contents);
+	}, &ReadCounter );
+	return Result;
 }
@@ -16,12 +16,11 @@
 #include "pch.h"
 #include <vector>
 #include <string>
-#include <ppl.h>
+#include "JobSystem.h"
 
 namespace Utility
 {
 	using namespace std;
-	using namespace concurrency;
 
 	typedef shared_ptr<vector<byte> > ByteArray;
 	extern ByteArray NullFile;
@@ -31,7 +30,8 @@ namespace Utility
 	// This operation blocks until the entire file is read.
 	ByteArray ReadFileSync(const wstring& fileName);
 
-	// Same as previous except that it does not block but instead returns a task.
-	task<ByteArray> ReadFileAsync(const wstring& fileName);
+	// Same as previous except that it does not block.  The file is read by a job, and the returned array is
+	// filled in once ReadCounter reaches zero.  It is left empty if the file cannot be read.
+	ByteArray ReadFileAsync(const wstring& fileName, JobSystem::Counter& ReadCounter);
 
 } // namespace Utility
@@ -0,0 +1,591 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "FrameGraph.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "CommandListManager.h"
+#include "EngineProfiling.h"
+#include "Utility.h"
+#include <algorithm>
+
+using namespace Graphics;
+
+namespace
+{
+	inline uint64_t AlignUp( uint64_t Value, uint64_t Alignment )
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	inline bool operator==( const FrameGraph::TextureDesc& A, const FrameGraph::TextureDesc& B )
+	{
+		return A.Width == B.Width && A.Height == B.Height && A.Format == B.Format;
+	}
+
+	FrameGraph::AllocationInfo QueryDeviceAllocationInfo( const FrameGraph::TextureDesc& Desc )
+	{
+		D3D12_RESOURCE_DESC ResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(Desc.Format, Desc.Width, Desc.Height, 1, 1, 1, 0,
+			D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+		D3D12_RESOURCE_ALLOCATION_INFO Info = g_Device->GetResourceAllocationInfo(0, 1, &ResourceDesc);
+
+		FrameGraph::AllocationInfo Result = { Info.SizeInBytes, Info.Alignment };
+		return Result;
+	}
+}
+
+void FrameGraph::PassBuilder::Read( ResourceHandle Resource, D3D12_RESOURCE_STATES State )
+{
+	ASSERT(Resource < m_Graph.m_Resources.size());
+	ResourceUse Use = { Resource, State, false };
+	m_Graph.m_Passes[m_PassIndex].Uses.push_back(Use);
+}
+
+void FrameGraph::PassBuilder::Write( ResourceHandle Resource, D3D12_RESOURCE_STATES State )
+{
+	ASSERT(Resource < m_Graph.m_Resources.size());
+	ResourceUse Use = { Resource, State, true };
+	m_Graph.m_Passes[m_PassIndex].Uses.push_back(Use);
+}
+
+void FrameGraph::PassBuilder::SetSideEffects( void )
+{
+	m_Graph.m_Passes[m_PassIndex].HasSideEffects = true;
+}
+
+GpuResource& FrameGraph::PassResources::GetResource( ResourceHandle Resource ) const
+{
+	const ResourceNode& Node = m_Graph.m_Resources[Resource];
+	if (Node.IsTransient())
+	{
+		ASSERT(Node.pPlaced != nullptr, "Transient texture %ls is not used by any pass which runs", Node.Name.c_str());
+		return *Node.pPlaced;
+	}
+	return *Node.pImported;
+}
+
+ColorBuffer& FrameGraph::PassResources::GetColorBuffer( ResourceHandle Resource ) const
+{
+	return static_cast<ColorBuffer&>(GetResource(Resource));
+}
+
+FrameGraph::FrameGraph( const std::wstring& Name ) :
+	m_Name(Name),
+	m_IsCompiled(false),
+	m_HeapSize(0)
+{
+	std::memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+FrameGraph::~FrameGraph()
+{
+	Destroy();
+}
+
+void FrameGraph::Reset( void )
+{
+	m_Passes.clear();
+	m_Resources.clear();
+	m_IsCompiled = false;
+}
+
+FrameGraph::ResourceHandle FrameGraph::CreateTexture( const std::wstring& Name, const TextureDesc& Desc )
+{
+	ASSERT(!m_IsCompiled, "Reset the frame graph before adding to it");
+
+	ResourceNode Node = {};
+	Node.Name = Name;
+	Node.Desc = Desc;
+	m_Resources.push_back(Node);
+	return (ResourceHandle)m_Resources.size() - 1;
+}
+
+FrameGraph::ResourceHandle FrameGraph::ImportResource( GpuResource& Resource )
+{
+	ASSERT(!m_IsCompiled, "Reset the frame graph before adding to it");
+
+	ResourceNode Node = {};
+	Node.pImported = &Resource;
+	m_Resources.push_back(Node);
+	return (ResourceHandle)m_Resources.size() - 1;
+}
+
+void FrameGraph::AddPass( const std::wstring& Name, const SetupFunc& Setup, const ExecuteFunc& Execute )
+{
+	ASSERT(!m_IsCompiled, "Reset the frame graph before adding to it");
+
+	PassNode Node;
+	Node.Name = Name;
+	Node.Execute = Execute;
+	Node.HasSideEffects = false;
+	Node.IsCulled = false;
+	m_Passes.push_back(Node);
+
+	PassBuilder Builder(*this, (uint32_t)m_Passes.size() - 1);
+	Setup(Builder);
+}
+
+void FrameGraph::Compile( void )
+{
+	Compile(QueryDeviceAllocationInfo);
+}
+
+void FrameGraph::Compile( const SizeQueryFunc& SizeQuery )
+{
+	CullPasses();
+	ComputeLifetimes();
+	AssignHeapOffsets(SizeQuery);
+	ComputeBarriers();
+
+	m_Stats.NumPasses = (uint32_t)m_Passes.size();
+	m_Stats.NumCulledPasses = 0;
+	m_Stats.NumBarriers = 0;
+	for (auto& Pass : m_Passes)
+	{
+		m_Stats.NumCulledPasses += Pass.IsCulled ? 1 : 0;
+		for (auto& PassBarrier : Pass.Barriers)
+			m_Stats.NumBarriers += PassBarrier.Type != kDiscard ? 1 : 0;
+	}
+
+	m_IsCompiled = true;
+}
+
+// Walk the passes backwards, starting from what must be kept:  imported resources and passes with side
+// effects.  A pass is needed if it writes something a later needed pass reads.  A write which is not also a
+// read hides whatever earlier passes wrote, so those passes are culled unless somebody reads in between.
+void FrameGraph::CullPasses( void )
+{
+	std::vector<bool> IsNeeded(m_Resources.size());
+	for (size_t i = 0; i < m_Resources.size(); ++i)
+		IsNeeded[i] = !m_Resources[i].IsTransient();
+
+	for (size_t i = m_Passes.size(); i > 0; --i)
+	{
+		PassNode& Pass = m_Passes[i - 1];
+
+		bool IsLive = Pass.HasSideEffects;
+		for (auto& Use : Pass.Uses)
+		{
+			if (Use.IsWrite && IsNeeded[Use.Resource])
+				IsLive = true;
+		}
+
+		Pass.IsCulled = !IsLive;
+		if (!IsLive)
+			continue;
+
+		for (auto& Use : Pass.Uses)
+		{
+			if (Use.IsWrite && m_Resources[Use.Resource].IsTransient())
+				IsNeeded[Use.Resource] = false;
+		}
+
+		for (auto& Use : Pass.Uses)
+		{
+			if (!Use.IsWrite)
+				IsNeeded[Use.Resource] = true;
+		}
+	}
+}
+
+void FrameGraph::ComputeLifetimes( void )
+{
+	for (auto& Resource : m_Resources)
+	{
+		Resource.IsUsed = false;
+		Resource.pPlaced = nullptr;
+		Resource.AliasedResource = kInvalidResource;
+	}
+
+	for (uint32_t PassIndex = 0; PassIndex < (uint32_t)m_Passes.size(); ++PassIndex)
+	{
+		const PassNode& Pass = m_Passes[PassIndex];
+		if (Pass.IsCulled)
+			continue;
+
+		for (auto& Use : Pass.Uses)
+		{
+			ResourceNode& Resource = m_Resources[Use.Resource];
+			if (!Resource.IsUsed)
+			{
+				ASSERT(Use.IsWrite || !Resource.IsTransient(), "Transient texture %ls is read before it is written",
+					Resource.Name.c_str());
+				Resource.IsUsed = true;
+				Resource.FirstPass = PassIndex;
+			}
+			Resource.LastPass = PassIndex;
+		}
+	}
+}
+
+// Place the largest textures first.  Each texture goes at the lowest offset which does not overlap a texture
+// already placed that is alive at the same time.
+void FrameGraph::AssignHeapOffsets( const SizeQueryFunc& SizeQuery )
+{
+	std::vector<ResourceHandle> Transients;
+	m_Stats.UnaliasedBytes = 0;
+
+	for (ResourceHandle i = 0; i < (ResourceHandle)m_Resources.size(); ++i)
+	{
+		ResourceNode& Resource = m_Resources[i];
+		if (!Resource.IsTransient() || !Resource.IsUsed)
+			continue;
+
+		AllocationInfo Info = SizeQuery(Resource.Desc);
+		ASSERT(Info.Alignment != 0 && (Info.Alignment & (Info.Alignment - 1)) == 0);
+		Resource.SizeInBytes = Info.SizeInBytes;
+		Resource.Alignment = Info.Alignment;
+		m_Stats.UnaliasedBytes += AlignUp(Info.SizeInBytes, Info.Alignment);
+		Transients.push_back(i);
+	}
+
+	std::stable_sort(Transients.begin(), Transients.end(), [this]( ResourceHandle A, ResourceHandle B )
+	{
+		return m_Resources[A].SizeInBytes > m_Resources[B].SizeInBytes;
+	});
+
+	struct Interval { uint64_t Begin, End; };
+	std::vector<Interval> Occupied;
+	uint64_t HeapSize = 0;
+
+	for (size_t i = 0; i < Transients.size(); ++i)
+	{
+		ResourceNode& Resource = m_Resources[Transients[i]];
+
+		Occupied.clear();
+		for (size_t j = 0; j < i; ++j)
+		{
+			const ResourceNode& Placed = m_Resources[Transients[j]];
+			if (Placed.FirstPass <= Resource.LastPass && Resource.FirstPass <= Placed.LastPass)
+			{
+				Interval Range = { Placed.HeapOffset, Placed.HeapOffset + Placed.SizeInBytes };
+				Occupied.push_back(Range);
+			}
+		}
+
+		std::sort(Occupied.begin(), Occupied.end(), []( const Interval& A, const Interval& B ) { return A.Begin < B.Begin; });
+
+		uint64_t Offset = 0;
+		for (auto& Range : Occupied)
+		{
+			if (AlignUp(Offset, Resource.Alignment) + Resource.SizeInBytes <= Range.Begin)
+				break;
+			Offset = std::max(Offset, Range.End);
+		}
+
+		Resource.HeapOffset = AlignUp(Offset, Resource.Alignment);
+		HeapSize = std::max(HeapSize, Resource.HeapOffset + Resource.SizeInBytes);
+	}
+
+	// Every texture sharing memory with another needs an aliasing barrier at its first use.  The previous
+	// occupant is the overlapping texture that died last before then, or if there is none, the one which died
+	// last in the previous frame.
+	for (ResourceHandle i : Transients)
+	{
+		ResourceNode& Resource = m_Resources[i];
+		ResourceHandle Before = kInvalidResource;
+		ResourceHandle LastInFrame = kInvalidResource;
+
+		for (ResourceHandle j : Transients)
+		{
+			const ResourceNode& Other = m_Resources[j];
+			if (j == i || Other.HeapOffset >= Resource.HeapOffset + Resource.SizeInBytes ||
+				Resource.HeapOffset >= Other.HeapOffset + Other.SizeInBytes)
+				continue;
+
+			if (Other.LastPass < Resource.FirstPass &&
+				(Before == kInvalidResource || Other.LastPass > m_Resources[Before].LastPass))
+				Before = j;
+
+			if (LastInFrame == kInvalidResource || Other.LastPass > m_Resources[LastInFrame].LastPass)
+				LastInFrame = j;
+		}
+
+		Resource.AliasedResource = Before != kInvalidResource ? Before : LastInFrame;
+	}
+
+	m_Stats.NumTransientTextures = (uint32_t)Transients.size();
+	m_Stats.HeapBytes = HeapSize;
+}
+
+// Each resource takes the combined state of all its uses in a pass, so a transition is only needed when that
+// changes between passes.  Back to back unordered access needs a UAV barrier instead.  Transient textures
+// start the frame in the state the previous frame left them in.
+void FrameGraph::ComputeBarriers( void )
+{
+	struct CombinedUse
+	{
+		ResourceHandle Resource;
+		D3D12_RESOURCE_STATES State;
+		bool IsWrite;
+	};
+
+	std::vector<std::vector<CombinedUse>> PassUses(m_Passes.size());
+	std::vector<D3D12_RESOURCE_STATES> CurrentStates(m_Resources.size(), kUnknownState);
+	std::vector<bool> HasPendingUAVWrite(m_Resources.size(), false);
+
+	for (size_t PassIndex = 0; PassIndex < m_Passes.size(); ++PassIndex)
+	{
+		PassNode& Pass = m_Passes[PassIndex];
+		Pass.Barriers.clear();
+		if (Pass.IsCulled)
+			continue;
+
+		std::vector<CombinedUse>& Combined = PassUses[PassIndex];
+		for (auto& Use : Pass.Uses)
+		{
+			auto Iter = std::find_if(Combined.begin(), Combined.end(),
+				[&Use]( const CombinedUse& C ) { return C.Resource == Use.Resource; });
+
+			if (Iter == Combined.end())
+			{
+				CombinedUse NewUse = { Use.Resource, Use.State, Use.IsWrite };
+				Combined.push_back(NewUse);
+			}
+			else if (Use.IsWrite || Iter->IsWrite)
+			{
+				ASSERT(Iter->State == Use.State, "Pass %ls uses %u in two states while writing it",
+					Pass.Name.c_str(), Use.Resource);
+				Iter->IsWrite = true;
+			}
+			else
+			{
+				Iter->State |= Use.State;
+			}
+		}
+
+		for (auto& Use : Combined)
+			CurrentStates[Use.Resource] = Use.State;
+	}
+
+	// The state each transient texture was last used in is what it starts the next frame in
+	for (size_t i = 0; i < m_Resources.size(); ++i)
+	{
+		if (!m_Resources[i].IsTransient())
+			CurrentStates[i] = kUnknownState;
+	}
+
+	for (uint32_t PassIndex = 0; PassIndex < (uint32_t)m_Passes.size(); ++PassIndex)
+	{
+		PassNode& Pass = m_Passes[PassIndex];
+		if (Pass.IsCulled)
+			continue;
+
+		for (auto& Use : PassUses[PassIndex])
+		{
+			const ResourceNode& Resource = m_Resources[Use.Resource];
+
+			if (Resource.IsTransient() && Resource.FirstPass == PassIndex)
+			{
+				if (Resource.AliasedResource != kInvalidResource)
+				{
+					Barrier Alias = { kAliasingBarrier, Use.Resource, Resource.AliasedResource, kUnknownState, kUnknownState };
+					Pass.Barriers.push_back(Alias);
+				}
+
+				// A copy initializes the texture by itself.  Anything else writing it starts from a discard.
+				if (Use.State != D3D12_RESOURCE_STATE_COPY_DEST)
+				{
+					Barrier Discard = { kDiscard, Use.Resource, kInvalidResource, kUnknownState, Use.State };
+					Pass.Barriers.push_back(Discard);
+				}
+			}
+
+			if (CurrentStates[Use.Resource] != Use.State)
+			{
+				Barrier Transition = { kTransitionBarrier, Use.Resource, kInvalidResource,
+					CurrentStates[Use.Resource], Use.State };
+				Pass.Barriers.push_back(Transition);
+			}
+			else if (Use.State == D3D12_RESOURCE_STATE_UNORDERED_ACCESS && HasPendingUAVWrite[Use.Resource])
+			{
+				Barrier UAV = { kUAVBarrier, Use.Resource, kInvalidResource, Use.State, Use.State };
+				Pass.Barriers.push_back(UAV);
+			}
+
+			CurrentStates[Use.Resource] = Use.State;
+			HasPendingUAVWrite[Use.Resource] = Use.IsWrite && Use.State == D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+		}
+	}
+}
+
+bool FrameGraph::IsPassCulled( uint32_t PassIndex ) const
+{
+	ASSERT(m_IsCompiled && PassIndex < m_Passes.size());
+	return m_Passes[PassIndex].IsCulled;
+}
+
+const std::vector<FrameGraph::Barrier>& FrameGraph::GetPassBarriers( uint32_t PassIndex ) const
+{
+	ASSERT(m_IsCompiled && PassIndex < m_Passes.size());
+	return m_Passes[PassIndex].Barriers;
+}
+
+uint64_t FrameGraph::GetHeapOffset( ResourceHandle Resource ) const
+{
+	ASSERT(m_IsCompiled && Resource < m_Resources.size());
+	ASSERT(m_Resources[Resource].IsTransient() && m_Resources[Resource].IsUsed);
+	return m_Resources[Resource].HeapOffset;
+}
+
+void FrameGraph::CreateHeap( uint64_t SizeInBytes )
+{
+	// The textures placed in the old heap may still be in use
+	if (m_Heap != nullptr)
+		g_CommandManager.IdleGPU();
+
+	m_PlacedTextures.clear();
+	m_Heap = nullptr;
+
+	D3D12_HEAP_DESC HeapDesc = {};
+	HeapDesc.SizeInBytes = SizeInBytes;
+	HeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+	HeapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	HeapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	HeapDesc.Properties.CreationNodeMask = 1;
+	HeapDesc.Properties.VisibleNodeMask = 1;
+	HeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	HeapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+	ASSERT_SUCCEEDED( g_Device->CreateHeap(&HeapDesc, MY_IID_PPV_ARGS(&m_Heap)) );
+	m_HeapSize = SizeInBytes;
+
+#ifndef RELEASE
+	m_Heap->SetName((m_Name + L" Transient Heap").c_str());
+#endif
+
+	Utility::Printf(L"%s:  %u transient textures use %llu KB of aliased memory instead of %llu KB\n", m_Name.c_str(),
+		m_Stats.NumTransientTextures, m_Stats.HeapBytes / 1024, m_Stats.UnaliasedBytes / 1024);
+}
+
+ColorBuffer* FrameGraph::FindOrCreatePlacedTexture( const ResourceNode& Resource, const CommandContext& Context )
+{
+	for (auto& Placed : m_PlacedTextures)
+	{
+		if (Placed->HeapOffset == Resource.HeapOffset && Placed->Desc == Resource.Desc)
+		{
+			Placed->IsUsed = true;
+			Placed->LastContext = &Context;
+			Placed->LastContextFence = Context.GetLastFenceValue();
+			Placed->ReleaseFence = 0;
+			return &Placed->Buffer;
+		}
+	}
+
+	PlacedTexture* NewTexture = new PlacedTexture;
+	NewTexture->Desc = Resource.Desc;
+	NewTexture->HeapOffset = Resource.HeapOffset;
+	NewTexture->IsUsed = true;
+	NewTexture->LastContext = &Context;
+	NewTexture->LastContextFence = Context.GetLastFenceValue();
+	NewTexture->ReleaseFence = 0;
+	NewTexture->Buffer.CreatePlaced(Resource.Name, Resource.Desc.Width, Resource.Desc.Height, Resource.Desc.Format,
+		m_Heap.Get(), Resource.HeapOffset);
+	m_PlacedTextures.emplace_back(NewTexture);
+
+	return &NewTexture->Buffer;
+}
+
+// Builds with other sizes or lifetimes leave textures behind which would otherwise pile up until the heap
+// grows.  The context which recorded a texture's last use may not have been submitted yet, so its fence is
+// only known once the context's last fence value moves on.  A context taken from the pool again by then
+// only reports a later fence, which is still safe to wait for.
+void FrameGraph::ReleaseUnusedPlacedTextures( void )
+{
+	for (auto& Placed : m_PlacedTextures)
+	{
+		if (Placed->IsUsed || Placed->ReleaseFence != 0)
+			continue;
+
+		uint64_t SubmittedFence = Placed->LastContext->GetLastFenceValue();
+		if (SubmittedFence != Placed->LastContextFence)
+			Placed->ReleaseFence = SubmittedFence;
+	}
+
+	m_PlacedTextures.erase(std::remove_if(m_PlacedTextures.begin(), m_PlacedTextures.end(),
+		[]( const std::unique_ptr<PlacedTexture>& Placed )
+		{
+			return !Placed->IsUsed && Placed->ReleaseFence != 0 && g_CommandManager.IsFenceComplete(Placed->ReleaseFence);
+		}), m_PlacedTextures.end());
+}
+
+void FrameGraph::Execute( ComputeContext& Context )
+{
+	ASSERT(m_IsCompiled, "Compile the frame graph before executing it");
+
+	if (m_Stats.HeapBytes > m_HeapSize)
+		CreateHeap(m_Stats.HeapBytes);
+
+	for (auto& Placed : m_PlacedTextures)
+		Placed->IsUsed = false;
+
+	for (auto& Resource : m_Resources)
+	{
+		if (Resource.IsTransient() && Resource.IsUsed)
+			Resource.pPlaced = FindOrCreatePlacedTexture(Resource, Context);
+	}
+
+	ReleaseUnusedPlacedTextures();
+
+	// Direct command lists only discard render targets in the render target state.  The placed textures are
+	// all render targets, since the heap only holds render target and depth textures.
+	const D3D12_RESOURCE_STATES DiscardState = Context.GetType() == D3D12_COMMAND_LIST_TYPE_DIRECT ?
+		D3D12_RESOURCE_STATE_RENDER_TARGET : D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+
+	PassResources Resources(*this);
+
+	for (auto& Pass : m_Passes)
+	{
+		if (Pass.IsCulled)
+			continue;
+
+		for (auto& PassBarrier : Pass.Barriers)
+		{
+			GpuResource& Resource = Resources.GetResource(PassBarrier.Resource);
+
+			switch (PassBarrier.Type)
+			{
+			case kTransitionBarrier:
+				Context.TransitionResource(Resource, PassBarrier.StateAfter);
+				break;
+			case kUAVBarrier:
+				Context.InsertUAVBarrier(Resource);
+				break;
+			case kAliasingBarrier:
+			{
+				// Textures with the same description at the same offset share one placed resource
+				GpuResource& Before = Resources.GetResource(PassBarrier.AliasedResource);
+				if (&Before != &Resource)
+					Context.InsertAliasBarrier(Before, Resource);
+				break;
+			}
+			case kDiscard:
+				Context.TransitionResource(Resource, DiscardState);
+				Context.DiscardResource(Resource);
+				Context.TransitionResource(Resource, PassBarrier.StateAfter);
+				break;
+			}
+		}
+
+		ScopedTimer _prof(Pass.Name, Context);
+		Pass.Execute(Context, Resources);
+	}
+}
+
+void FrameGraph::Destroy( void )
+{
+	for (auto& Resource : m_Resources)
+		Resource.pPlaced = nullptr;
+
+	m_PlacedTextures.clear();
+	m_Heap = nullptr;
+	m_HeapSize = 0;
+}
@@ -0,0 +1,214 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  A frame graph records a sequence of compute passes together with the resources each one
+// reads and writes, then compiles them before any GPU work is recorded.  Compiling culls passes whose output
+// nobody uses, works out the barriers between passes, and gives every transient texture an offset in a
+// shared heap.  Transient textures only exist between their first and last use, so textures whose
+// lifetimes do not overlap are placed in the same memory and alias each other.
+//
+// Textures which outlive the graph (the scene color buffer, the final outputs) are imported.  A pass which
+// writes an imported resource, or which is marked as having side effects, is never culled.
+//
+// Passes run in the order they were added, so a pass must be added after the passes whose output it reads.
+// Compile() does not touch the device when it is given a size query, so it can run without one.
+//
+// A transient texture has undefined contents at its first use, and the pass which first uses it must write
+// all of it.  The graph discards it just before then, since a placed render target has to be initialized
+// each time it takes over memory.
+//
+// Placed textures which a build does not use are released once the context which recorded their last use
+// has been submitted and its work has completed.
+
+#pragma once
+
+#include "ColorBuffer.h"
+#include <vector>
+#include <functional>
+
+class CommandContext;
+class ComputeContext;
+
+class FrameGraph
+{
+public:
+
+	typedef uint32_t ResourceHandle;
+	static const ResourceHandle kInvalidResource = 0xFFFFFFFF;
+
+	// The state an imported resource is in before its first use is not known until execution
+	static const D3D12_RESOURCE_STATES kUnknownState = (D3D12_RESOURCE_STATES)-1;
+
+	struct TextureDesc
+	{
+		uint32_t Width;
+		uint32_t Height;
+		DXGI_FORMAT Format;
+	};
+
+	struct AllocationInfo
+	{
+		uint64_t SizeInBytes;
+		uint64_t Alignment;
+	};
+
+	typedef std::function<AllocationInfo(const TextureDesc&)> SizeQueryFunc;
+
+	// A discard is not a barrier, but it has to be ordered with the barriers before the first use of a texture
+	enum BarrierType { kTransitionBarrier, kUAVBarrier, kAliasingBarrier, kDiscard };
+
+	struct Barrier
+	{
+		BarrierType Type;
+		ResourceHandle Resource;
+		ResourceHandle AliasedResource;		// For aliasing barriers, the previous occupant of the memory
+		D3D12_RESOURCE_STATES StateBefore;
+		D3D12_RESOURCE_STATES StateAfter;		// For discards, the state of the first use
+	};
+
+	struct Stats
+	{
+		uint32_t NumPasses;
+		uint32_t NumCulledPasses;
+		uint32_t NumTransientTextures;
+		uint32_t NumBarriers;
+		uint64_t UnaliasedBytes;	// What the transient textures would take if each had its own memory
+		uint64_t HeapBytes;			// What they take when aliased
+	};
+
+	class PassBuilder
+	{
+	public:
+		void Read( ResourceHandle Resource, D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE );
+		void Write( ResourceHandle Resource, D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_UNORDERED_ACCESS );
+
+		// Keep the pass even if nothing reads what it writes
+		void SetSideEffects( void );
+
+	private:
+		friend class FrameGraph;
+		PassBuilder( FrameGraph& Graph, uint32_t PassIndex ) : m_Graph(Graph), m_PassIndex(PassIndex) {}
+		PassBuilder& operator=( const PassBuilder& );
+
+		FrameGraph& m_Graph;
+		uint32_t m_PassIndex;
+	};
+
+	class PassResources
+	{
+	public:
+		GpuResource& GetResource( ResourceHandle Resource ) const;
+		ColorBuffer& GetColorBuffer( ResourceHandle Resource ) const;
+
+	private:
+		friend class FrameGraph;
+		PassResources( const FrameGraph& Graph ) : m_Graph(Graph) {}
+		PassResources& operator=( const PassResources& );
+
+		const FrameGraph& m_Graph;
+	};
+
+	typedef std::function<void(PassBuilder&)> SetupFunc;
+	typedef std::function<void(ComputeContext&, const PassResources&)> ExecuteFunc;
+
+	FrameGraph( const std::wstring& Name );
+	~FrameGraph();
+
+	// Forget the passes and resources of the previous frame.  The transient heap and the textures placed in
+	// it are kept for reuse.
+	void Reset( void );
+
+	ResourceHandle CreateTexture( const std::wstring& Name, const TextureDesc& Desc );
+	ResourceHandle ImportResource( GpuResource& Resource );
+	ResourceHandle ImportColorBuffer( ColorBuffer& Buffer ) { return ImportResource(Buffer); }
+
+	// The setup function runs immediately to declare what the pass reads and writes.  The execute function
+	// runs during Execute() unless the pass is culled.
+	void AddPass( const std::wstring& Name, const SetupFunc& Setup, const ExecuteFunc& Execute );
+
+	// Cull, schedule barriers and assign heap offsets.  The first version asks the device for texture sizes.
+	void Compile( void );
+	void Compile( const SizeQueryFunc& SizeQuery );
+
+	// Place the transient textures in the heap, growing it if needed, and record the passes
+	void Execute( ComputeContext& Context );
+
+	// Release the heap and the placed textures.  The GPU must be done with them.
+	void Destroy( void );
+
+	// Results of the last Compile()
+	bool IsPassCulled( uint32_t PassIndex ) const;
+	const std::vector<Barrier>& GetPassBarriers( uint32_t PassIndex ) const;
+	uint64_t GetHeapOffset( ResourceHandle Resource ) const;
+	const Stats& GetStats( void ) const { return m_Stats; }
+
+private:
+
+	struct ResourceUse
+	{
+		ResourceHandle Resource;
+		D3D12_RESOURCE_STATES State;
+		bool IsWrite;
+	};
+
+	struct PassNode
+	{
+		std::wstring Name;
+		ExecuteFunc Execute;
+		std::vector<ResourceUse> Uses;
+		bool HasSideEffects;
+		bool IsCulled;
+		std::vector<Barrier> Barriers;
+	};
+
+	struct ResourceNode
+	{
+		std::wstring Name;
+		TextureDesc Desc;
+		GpuResource* pImported;
+		ColorBuffer* pPlaced;		// Backs a transient texture during Execute()
+		bool IsUsed;
+		uint32_t FirstPass;
+		uint32_t LastPass;
+		uint64_t SizeInBytes;
+		uint64_t Alignment;
+		uint64_t HeapOffset;
+		ResourceHandle AliasedResource;
+
+		bool IsTransient( void ) const { return pImported == nullptr; }
+	};
+
+	struct PlacedTexture
+	{
+		TextureDesc Desc;
+		uint64_t HeapOffset;
+		ColorBuffer Buffer;
+		bool IsUsed;				// By the build being executed
+		const CommandContext* LastContext;	// Recorded the last build which used it
+		uint64_t LastContextFence;	// That context's last fence value when the build was recorded
+		uint64_t ReleaseFence;		// Once unused and submitted, the fence after which it can be released
+	};
+
+	void CullPasses( void );
+	void ComputeLifetimes( void );
+	void AssignHeapOffsets( const SizeQueryFunc& SizeQuery );
+	void ComputeBarriers( void );
+	void CreateHeap( uint64_t SizeInBytes );
+	ColorBuffer* FindOrCreatePlacedTexture( const ResourceNode& Resource, const CommandContext& Context );
+	void ReleaseUnusedPlacedTextures( void );
+
+	std::wstring m_Name;
+	std::vector<PassNode> m_Passes;
+	std::vector<ResourceNode> m_Resources;
+	bool m_IsCompiled;
+	Stats m_Stats;
+
+	Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap;
+	uint64_t m_HeapSize;
+	std::vector<std::unique_ptr<PlacedTexture>> m_PlacedTextures;
+};
@@ -0,0 +1,88 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "FramePacer.h"
+#include "SystemTime.h"
+#include <mmsystem.h>
+#include <cmath>
+
+namespace
+{
+	// Hold off pacing until the averages have settled
+	const uint32_t kMinSamples = 8;
+
+	// Variations in CPU time within this many deviations of the average are absorbed by starting earlier
+	const float kCpuDeviationScale = 2.0f;
+
+	// Sleep() can overshoot by about a millisecond even with the timer period raised, so spin for the rest
+	const double kSpinTime = 0.001;
+}
+
+FramePacer::FramePacer( float Smoothing, float SafetyMargin )
+	: m_Smoothing(Smoothing), m_SafetyMargin(SafetyMargin)
+{
+	ASSERT(Smoothing > 0.0f && Smoothing <= 1.0f);
+	Reset();
+}
+
+void FramePacer::Reset( void )
+{
+	m_CpuAverage = 0.0f;
+	m_CpuDeviation = 0.0f;
+	m_GpuAverage = 0.0f;
+	m_NumCpuSamples = 0;
+	m_NumGpuSamples = 0;
+}
+
+void FramePacer::RecordFrame( float CpuTime, float GpuTime )
+{
+	if (m_NumCpuSamples++ == 0)
+		m_CpuAverage = CpuTime;
+	else
+	{
+		m_CpuDeviation += m_Smoothing * (fabsf(CpuTime - m_CpuAverage) - m_CpuDeviation);
+		m_CpuAverage += m_Smoothing * (CpuTime - m_CpuAverage);
+	}
+
+	if (GpuTime <= 0.0f)
+		return;
+
+	if (m_NumGpuSamples++ == 0)
+		m_GpuAverage = GpuTime;
+	else
+		m_GpuAverage += m_Smoothing * (GpuTime - m_GpuAverage);
+}
+
+float FramePacer::GetStartDelay( void ) const
+{
+	if (m_NumCpuSamples < kMinSamples || m_NumGpuSamples < kMinSamples)
+		return 0.0f;
+
+	float Delay = m_GpuAverage - (m_CpuAverage + kCpuDeviationScale * m_CpuDeviation) - m_SafetyMargin;
+	return Delay > 0.0f ? Delay : 0.0f;
+}
+
+void FramePacer::SleepUntil( int64_t TargetTick )
+{
+	double Remaining = SystemTime::TimeBetweenTicks(SystemTime::GetCurrentTick(), TargetTick);
+
+	if (Remaining > 2.0 * kSpinTime)
+	{
+		// The default timer period is too coarse to wake within a frame's margin
+		timeBeginPeriod(1);
+		Sleep((DWORD)((Remaining - kSpinTime) * 1000.0));
+		timeEndPeriod(1);
+
+		Remaining = SystemTime::TimeBetweenTicks(SystemTime::GetCurrentTick(), TargetTick);
+	}
+
+	if (Remaining > 0.0)
+		SystemTime::BusyLoopSleep((float)Remaining);
+}
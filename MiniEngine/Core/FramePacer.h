@@ -0,0 +1,53 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  Predicts how long to hold back the start of a frame so that the CPU finishes it just as the
+// GPU is ready for it.  When the GPU is the bottleneck, starting the frame as early as the swap chain allows
+// only means input is sampled earlier and waits longer to reach the screen.
+//
+// Predictions come from moving averages of recorded CPU and GPU frame times.  The predictor has no dependence
+// on D3D or on the clock, so a recorded trace of frame times can be replayed through it.
+
+#pragma once
+
+#include <cstdint>
+
+class FramePacer
+{
+public:
+	// Smoothing is the weight given to each new sample.  SafetyMargin, in seconds, is left between the predicted
+	// end of the CPU frame and the predicted end of the GPU frame.
+	FramePacer( float Smoothing = 0.1f, float SafetyMargin = 0.001f );
+
+	void Reset( void );
+
+	// Add one frame's measurements, in seconds.  CpuTime runs from the start of the frame, when input is sampled,
+	// to the call to Present().  GpuTime is how long the GPU took to draw the frame, or zero if it is not known.
+	void RecordFrame( float CpuTime, float GpuTime );
+
+	// How long to wait, once the swap chain will accept another frame, before starting it.  Zero when the CPU is
+	// the bottleneck or too few frames have been recorded.
+	float GetStartDelay( void ) const;
+
+	float GetPredictedCpuTime( void ) const { return m_CpuAverage; }
+	float GetPredictedGpuTime( void ) const { return m_GpuAverage; }
+
+	// Sleep until the performance counter reaches a tick.  The thread sleeps for all but the last millisecond,
+	// which it spins through with SystemTime::BusyLoopSleep().
+	static void SleepUntil( int64_t TargetTick );
+
+private:
+	float m_Smoothing;
+	float m_SafetyMargin;
+
+	float m_CpuAverage;
+	float m_CpuDeviation;		// Mean absolute deviation of the CPU time
+	float m_GpuAverage;
+	uint32_t m_NumCpuSamples;
+	uint32_t m_NumGpuSamples;
+};
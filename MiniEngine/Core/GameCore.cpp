@@ -19,6 +19,7 @@
 #include "BufferManager.h"
 #include "CommandContext.h"
 #include "PostEffects.h"
+#include "JobSystem.h"
 
 namespace Graphics
 {
@@ -32,6 +33,7 @@ namespace GameCore
 
 	void InitializeApplication( IGameApp& game )
 	{
+		JobSystem::Initialize();
 		Graphics::Initialize();
 		SystemTime::Initialize();
 		GameInput::Initialize();
@@ -45,6 +47,7 @@ namespace GameCore
 		game.Cleanup();
 
 		GameInput::Shutdown();
+		JobSystem::Shutdown();
 	}
 
 	bool UpdateApplication( IGameApp& game )
@@ -21,18 +21,18 @@ class GpuResource
 	friend class CommandContext;
 	friend class GraphicsContext;
 	friend class ComputeContext;
+	friend class UploadManager;
+	friend class ResourceStateTracker;
 
 public:
 	GpuResource() : 
 		m_GpuVirtualAddress(D3D12_GPU_VIRTUAL_ADDRESS_NULL),
-		m_UsageState(D3D12_RESOURCE_STATE_COMMON),
-		m_TransitioningState((D3D12_RESOURCE_STATES)-1)
+		m_UsageState(D3D12_RESOURCE_STATE_COMMON)
 	{}
 
 	GpuResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES CurrentState) :
 		m_pResource(pResource),
-		m_UsageState(CurrentState),
-		m_TransitioningState((D3D12_RESOURCE_STATES)-1)
+		m_UsageState(CurrentState)
 	{
 		m_GpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
 	}
@@ -54,6 +54,5 @@ protected:
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_pResource;
 	D3D12_RESOURCE_STATES m_UsageState;
-	D3D12_RESOURCE_STATES m_TransitioningState;
 	D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress;
 };
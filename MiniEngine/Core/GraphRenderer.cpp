@@ -20,6 +20,7 @@
 #include "GameInput.h"
 #include "SystemTime.h"
 #include "EngineProfiling.h"
+#include "SlidingWindowMinMax.h"
 
 #include "CompiledShaders/PerfGraphBackgroundVS.h"
 #include "CompiledShaders/PerfGraphVS.h"
@@ -48,32 +49,40 @@ __declspec(align(16)) struct CBGraph
 
 class GraphVector;
 
+// One graph's history:  a ring of NodeCount samples for each of its variables, stored one variable after
+// another in a single array and mirrored in a GPU buffer of the same layout.  Only the samples written since
+// the last draw are copied to the GPU.
 class PerfGraph
 {
 friend GraphVector;
 public:
 	PerfGraph( uint32_t NodeCount, uint32_t debugVarCount, Color color = Color(1.0f, 0.0f, 0.5f), bool IsGraphed = false ) : m_IsGraphed(IsGraphed), 
-		m_NodeCount(NodeCount), m_Color(color), m_DebugVarCount(debugVarCount)
+		m_NodeCount(NodeCount), m_Color(color), m_DebugVarCount(debugVarCount), m_Samples(NodeCount * debugVarCount, 0.0f),
+		m_HasNewSamples(false), m_FirstNewFrame(0), m_LastNewFrame(0)
 	{
-		for (uint32_t i = 0; i < debugVarCount; ++i)		
-			m_PerfTimesCPUBuffer.emplace_back(new float[NodeCount]);
+		// The vertex shader wraps with a mask
+		ASSERT(Math::IsPowerOfTwo(NodeCount));
+		m_SampleBuffer.Create(L"Perf Graph Samples", NodeCount * debugVarCount, sizeof(float), m_Samples.data());
 	}
 
-	~PerfGraph()
-	{
-		Clear();
-	}
-
-	void Clear(){ m_PerfTimesCPUBuffer.clear();} 
 	bool IsGraphed(){ return m_IsGraphed; }
 	Color GetColor(){ return m_Color; }
 	void SetColor(Color color){m_Color = color;}
-	void UpdateGraph( float* timeStamps, uint32_t frameID )
+	void UpdateGraph( const float* timeStamps, uint32_t frameID )
 	{
+		const uint32_t Slot = frameID & (m_NodeCount - 1);
 		for(uint32_t i = 0; i < m_DebugVarCount; i++)
-			m_PerfTimesCPUBuffer[i][frameID % m_NodeCount] = timeStamps[i];
+			m_Samples[i * m_NodeCount + Slot] = timeStamps[i];
+
+		if (!m_HasNewSamples)
+			m_FirstNewFrame = frameID;
+		m_LastNewFrame = frameID;
+		m_HasNewSamples = true;
 	} 	
 
+	// Copy the samples written since the last upload, at most one run per variable on either side of the wrap
+	void UploadSamples( CommandContext& Context );
+
 	//RenderGraph renders both graph backgrounds and line graphs 
 	//
 	//To render backgrounds, set s_GraphBackgroundPSO, set primitive topology to triangle strip, 
@@ -91,21 +100,25 @@ public:
 		uint32_t debugVarCount, float topMargin, const float* MaxArray, uint32_t frameID);
 
 private:
-	std::vector<std::unique_ptr<float[]>> m_PerfTimesCPUBuffer;
 	uint32_t m_NodeCount;
 	bool m_IsGraphed;
 	Color m_Color;
 	uint32_t m_ColorKey;
 	uint32_t m_DebugVarCount;
+
+	std::vector<float> m_Samples;		// [Variable * NodeCount + Frame % NodeCount]
+	StructuredBuffer m_SampleBuffer;
+	bool m_HasNewSamples;
+	uint32_t m_FirstNewFrame;
+	uint32_t m_LastNewFrame;
 };
 
 
 class GraphVector 
 {
 public:
-	GraphVector(uint32_t MaxActiveGraphs, uint32_t DebugVarCount) : m_MaxActiveGraphs(MaxActiveGraphs),
-		m_ActiveGraphs(0), m_DebugVarCount(DebugVarCount), m_MinAbs((float)PERF_GRAPH_ERROR),
-		m_MaxAbs(0.0f), m_FrameOfMinAbs(0), m_FrameOfMaxAbs(0)
+	GraphVector(uint32_t MaxActiveGraphs, uint32_t DebugVarCount, uint32_t NodeCount) : m_MaxActiveGraphs(MaxActiveGraphs),
+		m_ActiveGraphs(0), m_DebugVarCount(DebugVarCount), m_MinAbs(0.0f), m_MaxAbs(0.0f)
 	{
 		// Fill color array with set of possible graph colors (up to 8 different colors)
 		m_ColorArray.reset(new Color[MaxActiveGraphs]);
@@ -121,18 +134,18 @@ public:
 		
 		m_Max.reset(new float[DebugVarCount]); 
 		m_Min.reset(new float[DebugVarCount]);
-		m_FrameOfMax.reset(new uint32_t[DebugVarCount]);
-		m_FrameOfMin.reset(new uint32_t[DebugVarCount]);
 		m_PresetMax.reset(new float[DebugVarCount]);
+		m_Windows.reset(new SlidingWindowMinMax[DebugVarCount]);
 
+		// Each graph being drawn adds a sample per variable per frame
 		for (uint32_t i = 0; i < DebugVarCount; ++i)
 		{
 			m_Max[i] = 0.0f;
-			m_Min[i] = (float)PERF_GRAPH_ERROR;
-			m_FrameOfMax[i] = m_FrameOfMin[i] = 0;
+			m_Min[i] = 0.0f;
 			m_PresetMax[i] = 30.0f;
+			m_Windows[i].Reset(NodeCount, MaxActiveGraphs);
 		}
-
+		m_AbsWindow.Reset(NodeCount, MaxActiveGraphs * DebugVarCount);
 	}
 
 	void Clear()
@@ -196,48 +209,19 @@ public:
 			m_PresetMax[i] = maxArray[i];
 	}
 	
-	void ManageMax(float* InputNode, uint32_t nodeCount, uint32_t FrameID)
+	// Track the extremes over the last NodeCount frames, across variables (absolute) and per variable (relative)
+	void ManageMax(const float* InputNode, uint32_t FrameID)
 	{
 		for (uint32_t i = 0; i < m_DebugVarCount; ++i)
 		{
-			//Absolute min max
-			if (FrameID - m_FrameOfMinAbs > nodeCount)
-				m_MinAbs = (float)PERF_GRAPH_ERROR;
-		
-			if (FrameID - m_FrameOfMaxAbs > nodeCount)
-				m_MaxAbs = 0.0f;
-		
-			if (InputNode[i] > m_MaxAbs)
-			{
-				m_MaxAbs = InputNode[i];
-				m_FrameOfMaxAbs = FrameID;
-			}
-
-			if (InputNode[i] < m_MinAbs)
-			{
-				m_MinAbs = InputNode[i];
-				m_FrameOfMinAbs = FrameID;
-			}
-
-			//Relative min max
-			if (FrameID - m_FrameOfMax[i] > nodeCount)
-				m_Max[i] = 0.0f;
-	
-			if (FrameID - m_FrameOfMin[i] > nodeCount)
-				m_Min[i] = (float)PERF_GRAPH_ERROR;
-
-			if (InputNode[i] > m_Max[i])
-			{
-				m_Max[i] = InputNode[i];
-				m_FrameOfMax[i] = FrameID;
-			}
-			if (InputNode[i] < m_Min[i])
-			{
-				m_Min[i] = InputNode[i];
-				m_FrameOfMin[i] = FrameID;
-			}
+			m_AbsWindow.AddSample(FrameID, InputNode[i]);
+			m_Windows[i].AddSample(FrameID, InputNode[i]);
+			m_Max[i] = m_Windows[i].GetMax();
+			m_Min[i] = m_Windows[i].GetMin();
 		}
 
+		m_MaxAbs = m_AbsWindow.GetMax();
+		m_MinAbs = m_AbsWindow.GetMin();
 	}
 
 	std::vector<std::unique_ptr<PerfGraph>> m_Graphs;
@@ -252,14 +236,12 @@ private:
 	
 	float m_MaxAbs;
 	float m_MinAbs;
-	uint32_t m_FrameOfMaxAbs;
-	uint32_t m_FrameOfMinAbs;
+	SlidingWindowMinMax m_AbsWindow;
 
 	std::unique_ptr<float[]> m_PresetMax;
 	std::unique_ptr<float[]> m_Max; 
 	std::unique_ptr<float[]> m_Min;
-	std::unique_ptr<uint32_t[]> m_FrameOfMax;
-	std::unique_ptr<uint32_t[]> m_FrameOfMin;
+	std::unique_ptr<SlidingWindowMinMax[]> m_Windows;
 };
 
 namespace
@@ -268,8 +250,8 @@ namespace
 	GraphicsPSO s_RenderPerfGraphPSO;
 	GraphicsPSO s_GraphBackgroundPSO;
 	uint32_t s_FrameID;
-	GraphVector GlobalGraphs = GraphVector(2, 1);
-	GraphVector ProfileGraphs = GraphVector(MAX_ACTIVE_PROFILE_GRAPHS, PROFILE_DEBUG_VAR_COUNT);
+	GraphVector GlobalGraphs = GraphVector(2, 1, GLOBAL_NODE_COUNT);
+	GraphVector ProfileGraphs = GraphVector(MAX_ACTIVE_PROFILE_GRAPHS, PROFILE_DEBUG_VAR_COUNT, PROFILE_NODE_COUNT);
 	uint32_t s_NumStamps = 0;
 	uint32_t s_SelectedTimerIndex;
 } // {anonymous} namespace
@@ -374,16 +356,15 @@ void GraphRenderer::Update( XMFLOAT2 InputNode, GraphHandle GraphID, bool IsGrap
 		ProfileGraphs.m_Graphs[GraphID]->UpdateGraph(input, s_FrameID);
 		if (ProfileGraphs.m_Graphs[GraphID]->IsGraphed())
 		{
-			float times[4] = {InputNode.x, InputNode.y};
-			ProfileGraphs.ManageMax(times, PROFILE_NODE_COUNT, s_FrameID);
+			ProfileGraphs.ManageMax(input, s_FrameID);
 		}
 	}
 	else // Type == PerfGraph::Global
 	{
 		GlobalGraphs.m_Graphs[0]->UpdateGraph(&InputNode.x, s_FrameID);
 		GlobalGraphs.m_Graphs[1]->UpdateGraph(&InputNode.y, s_FrameID);
-		GlobalGraphs.ManageMax(&InputNode.x, GLOBAL_NODE_COUNT, s_FrameID);
-		//GlobalGraphs.ManageMax(&InputNode.y, GLOBAL_NODE_COUNT, s_FrameID);
+		GlobalGraphs.ManageMax(&InputNode.x, s_FrameID);
+		//GlobalGraphs.ManageMax(&InputNode.y, s_FrameID);
 	}	
 }
 
@@ -520,6 +501,41 @@ void GraphRenderer::SetSelectedIndex(uint32_t selectedIndex)
 //
 //---------------------------------------------------------------------
 
+void PerfGraph::UploadSamples( CommandContext& Context )
+{
+	if (!m_HasNewSamples)
+		return;
+
+	// Samples older than the ring have already been overwritten
+	uint32_t Count = m_LastNewFrame - m_FirstNewFrame + 1;
+	if (Count > m_NodeCount)
+		Count = m_NodeCount;
+
+	const uint32_t FirstSlot = (m_LastNewFrame - Count + 1) & (m_NodeCount - 1);
+	const uint32_t FirstRun = std::min(Count, m_NodeCount - FirstSlot);
+
+	// WriteBuffer() reads from 16-byte aligned memory
+	__declspec(align(16)) float Staging[GLOBAL_NODE_COUNT];
+	ASSERT(m_NodeCount <= GLOBAL_NODE_COUNT);
+
+	for (uint32_t i = 0; i < m_DebugVarCount; ++i)
+	{
+		const float* Ring = &m_Samples[i * m_NodeCount];
+		const size_t RingOffset = sizeof(float) * i * m_NodeCount;
+
+		memcpy(Staging, Ring + FirstSlot, sizeof(float) * FirstRun);
+		Context.WriteBuffer(m_SampleBuffer, RingOffset + sizeof(float) * FirstSlot, Staging, sizeof(float) * FirstRun);
+
+		if (Count > FirstRun)
+		{
+			memcpy(Staging, Ring, sizeof(float) * (Count - FirstRun));
+			Context.WriteBuffer(m_SampleBuffer, RingOffset, Staging, sizeof(float) * (Count - FirstRun));
+		}
+	}
+
+	m_HasNewSamples = false;
+}
+
 void PerfGraph::RenderGraph(GraphicsContext& Context, uint32_t vertexCount, D3D12_VIEWPORT& viewport, uint32_t debugVarCount, float topMargin)
 {
 	viewport.TopLeftY += topMargin;
@@ -549,9 +565,12 @@ void PerfGraph::RenderGraph(GraphicsContext& Context, uint32_t vertexCount, D3D1
 	Context.SetDynamicConstantBufferView(0, sizeof(CBGraph), &graphConstants);
 	Context.SetPipelineState(s_RenderPerfGraphPSO);
 
+	UploadSamples(Context);
+	Context.TransitionResource(m_SampleBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
+
 	for (uint32_t i = 0; i < debugVarCount; ++i)
 	{
-		Context.SetDynamicSRV(2, sizeof(float) * m_NodeCount, m_PerfTimesCPUBuffer[i].get());
+		Context.SetBufferSRV(2, m_SampleBuffer, sizeof(float) * m_NodeCount * i);
 		Context.SetConstants(3, i, 1.0f / YScale);
 		Context.SetViewport(viewport);
 		Context.Draw(vertexCount);
@@ -574,10 +593,13 @@ void PerfGraph::RenderGraph( GraphicsContext& Context, uint32_t vertexCount, D3D
 	graphConstants.FrameID = frameID;
 	Context.SetDynamicConstantBufferView(0, sizeof(CBGraph), &graphConstants);
 	Context.SetPipelineState(s_RenderPerfGraphPSO);
+
+	UploadSamples(Context);
+	Context.TransitionResource(m_SampleBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
 	
 	for (uint32_t i = 0; i < debugVarCount; ++i)
 	{
-		Context.SetDynamicSRV(2, sizeof(float) * m_NodeCount, m_PerfTimesCPUBuffer[i].get());
+		Context.SetBufferSRV(2, m_SampleBuffer, sizeof(float) * m_NodeCount * i);
 		Context.SetConstants(3, i, 1.0f / MaxArray[i]);
 		Context.SetViewport(viewport);
 		Context.Draw(vertexCount);
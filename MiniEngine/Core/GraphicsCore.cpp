@@ -25,8 +25,11 @@
 #include "DescriptorHeap.h"
 #include "CommandContext.h"
 #include "CommandListManager.h"
+#include "UploadManager.h"
 #include "RootSignature.h"
 #include "CommandSignature.h"
+#include "NullDevice.h"
+#include "FramePacer.h"
 #include "ParticleEffectManager.h"
 #include "GraphRenderer.h"
 
@@ -82,6 +85,26 @@ namespace
 	BoolVar s_EnableVSync("Timing/VSync", true);
 	BoolVar s_LimitTo30Hz("Timing/Limit To 30Hz", false);
 	BoolVar s_DropRandomFrames("Timing/Drop Random Frames", false);
+
+	// How many presented frames may be queued before the CPU waits to start the next one.  Fewer frames in
+	// flight means less input latency, at the risk of starving the GPU.
+	IntVar s_MaxFrameLatency("Timing/Max Frame Latency", 2, 1, SWAP_CHAIN_BUFFER_COUNT);
+
+	// Hold back the start of each frame so that it is submitted just as the GPU can take it
+	BoolVar s_EnableFramePacing("Timing/Frame Pacing", false);
+
+	StatVar s_InputToPresentTime("Timing/Latency/Input To Present (ms)");
+	StatVar s_AvgInputToPresentTime("Timing/Latency/Input To Present Avg (ms)");
+	StatVar s_SwapChainWaitTime("Timing/Latency/Swap Chain Wait (ms)");
+	StatVar s_PacingDelay("Timing/Latency/Pacing Delay (ms)");
+
+	FramePacer s_FramePacer;
+
+	// The swap chain signals this when it will accept another frame
+	HANDLE s_FrameLatencyWaitableObject = nullptr;
+	int32_t s_AppliedFrameLatency = 0;
+
+	const UINT kSwapChainFlags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH | DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
 }
 
 namespace Graphics
@@ -147,9 +170,11 @@ namespace Graphics
 	}
 
 	ID3D12Device* g_Device = nullptr;
+	bool g_UseNullDevice = false;
 
 	CommandListManager g_CommandManager;
 	ContextManager g_ContextManager;
+	UploadManager g_UploadManager;
 
 	D3D_FEATURE_LEVEL g_D3DFeatureLevel = D3D_FEATURE_LEVEL_11_0;
 
@@ -232,9 +257,37 @@ namespace Graphics
 	EnumVar DebugZoom("Graphics/Display/Magnify Pixels", kDebugZoomOff, 3, DebugZoomLabels);
 }
 
+// Without a swap chain, the display planes are ordinary render targets which are never shown
+static void CreateHeadlessDisplayPlanes(void)
+{
+	D3D12_HEAP_PROPERTIES HeapProps = {};
+	HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+	HeapProps.CreationNodeMask = 1;
+	HeapProps.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC Desc = {};
+	Desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	Desc.Width = g_DisplayWidth;
+	Desc.Height = g_DisplayHeight;
+	Desc.DepthOrArraySize = 1;
+	Desc.MipLevels = 1;
+	Desc.Format = SwapChainFormat;
+	Desc.SampleDesc.Count = 1;
+	Desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+	for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+	{
+		ComPtr<ID3D12Resource> DisplayPlane;
+		ASSERT_SUCCEEDED(g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &Desc,
+			D3D12_RESOURCE_STATE_PRESENT, nullptr, MY_IID_PPV_ARGS(&DisplayPlane)));
+		g_DisplayPlane[i].CreateFromSwapChain(L"Headless Display Buffer", DisplayPlane.Detach());
+	}
+}
+
 void Graphics::Resize(uint32_t width, uint32_t height)
 {
-	ASSERT(s_PrimarySwapChain != nullptr);
+	ASSERT(s_PrimarySwapChain != nullptr || g_UseNullDevice);
 
 	g_DisplayWidth = width;
 	g_DisplayHeight = height;
@@ -246,7 +299,14 @@ void Graphics::Resize(uint32_t width, uint32_t height)
 	for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
 		g_DisplayPlane[i].Destroy();
 
-	ASSERT_SUCCEEDED(s_PrimarySwapChain->ResizeBuffers(SWAP_CHAIN_BUFFER_COUNT, width, height, SwapChainFormat, 0));
+	if (s_PrimarySwapChain == nullptr)
+	{
+		CreateHeadlessDisplayPlanes();
+		g_CurrentBuffer = 0;
+		return;
+	}
+
+	ASSERT_SUCCEEDED(s_PrimarySwapChain->ResizeBuffers(SWAP_CHAIN_BUFFER_COUNT, width, height, SwapChainFormat, kSwapChainFlags));
 
 	for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
 	{
@@ -261,52 +321,61 @@ void Graphics::Resize(uint32_t width, uint32_t height)
 // Initialize the DirectX resources required to run.
 void Graphics::Initialize(void)
 {
-	ASSERT(s_PrimarySwapChain == nullptr, "Graphics has already been initialized");
+	ASSERT(g_Device == nullptr, "Graphics has already been initialized");
 
 	Microsoft::WRL::ComPtr<ID3D12Device> pDevice;
+	Microsoft::WRL::ComPtr<IDXGIFactory4> dxgiFactory;
 
-#if _DEBUG
-	Microsoft::WRL::ComPtr<ID3D12Debug> debugInterface;
-	if (SUCCEEDED(D3D12GetDebugInterface(MY_IID_PPV_ARGS(&debugInterface))))
-		debugInterface->EnableDebugLayer();
+	if (g_UseNullDevice)
+	{
+		Utility::Print("Using the null device.  Nothing will be rendered or presented.\n");
+		ASSERT_SUCCEEDED(NullDevice::CreateDevice(MY_IID_PPV_ARGS(&pDevice)));
+		g_Device = pDevice.Detach();
+	}
 	else
-		Utility::Print("WARNING:  Unable to enable D3D12 debug validation layer\n");
+	{
+#if _DEBUG
+		Microsoft::WRL::ComPtr<ID3D12Debug> debugInterface;
+		if (SUCCEEDED(D3D12GetDebugInterface(MY_IID_PPV_ARGS(&debugInterface))))
+			debugInterface->EnableDebugLayer();
+		else
+			Utility::Print("WARNING:  Unable to enable D3D12 debug validation layer\n");
 #endif
 
-	// Obtain the DXGI factory
-	Microsoft::WRL::ComPtr<IDXGIFactory4> dxgiFactory;
-	ASSERT_SUCCEEDED(CreateDXGIFactory2(0, MY_IID_PPV_ARGS(&dxgiFactory)));
+		// Obtain the DXGI factory
+		ASSERT_SUCCEEDED(CreateDXGIFactory2(0, MY_IID_PPV_ARGS(&dxgiFactory)));
 
-	// Create the D3D graphics device
-	Microsoft::WRL::ComPtr<IDXGIAdapter1> pAdapter;
+		// Create the D3D graphics device
+		Microsoft::WRL::ComPtr<IDXGIAdapter1> pAdapter;
 
-	static const bool bUseWarpDriver = false;
+		static const bool bUseWarpDriver = false;
 
-	if (!bUseWarpDriver)
-	{
-		for (uint32_t Idx = 0; DXGI_ERROR_NOT_FOUND != dxgiFactory->EnumAdapters1(Idx, &pAdapter); ++Idx)
+		if (!bUseWarpDriver)
 		{
-			DXGI_ADAPTER_DESC1 desc;
-			pAdapter->GetDesc1(&desc);
-			if (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE)
-				continue;
-
-			if (SUCCEEDED(D3D12CreateDevice(pAdapter.Get(), D3D_FEATURE_LEVEL_11_0, MY_IID_PPV_ARGS(&pDevice))))
+			for (uint32_t Idx = 0; DXGI_ERROR_NOT_FOUND != dxgiFactory->EnumAdapters1(Idx, &pAdapter); ++Idx)
 			{
+				DXGI_ADAPTER_DESC1 desc;
 				pAdapter->GetDesc1(&desc);
-				Utility::Printf(L"D3D12-capable hardware found:  %s (%u MB)\n", desc.Description, desc.DedicatedVideoMemory >> 20);
-				g_Device = pDevice.Detach();
-				break;
+				if (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE)
+					continue;
+
+				if (SUCCEEDED(D3D12CreateDevice(pAdapter.Get(), D3D_FEATURE_LEVEL_11_0, MY_IID_PPV_ARGS(&pDevice))))
+				{
+					pAdapter->GetDesc1(&desc);
+					Utility::Printf(L"D3D12-capable hardware found:  %s (%u MB)\n", desc.Description, desc.DedicatedVideoMemory >> 20);
+					g_Device = pDevice.Detach();
+					break;
+				}
 			}
 		}
-	}
 
-	if (g_Device == nullptr)
-	{
-		Utility::Print("Failed to find a hardware adapter.  Falling back to WARP.\n");
-		ASSERT_SUCCEEDED(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&pAdapter)));
-		ASSERT_SUCCEEDED(D3D12CreateDevice(pAdapter.Get(), D3D_FEATURE_LEVEL_11_0, MY_IID_PPV_ARGS(&pDevice)));
-		g_Device = pDevice.Detach();
+		if (g_Device == nullptr)
+		{
+			Utility::Print("Failed to find a hardware adapter.  Falling back to WARP.\n");
+			ASSERT_SUCCEEDED(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&pAdapter)));
+			ASSERT_SUCCEEDED(D3D12CreateDevice(pAdapter.Get(), D3D_FEATURE_LEVEL_11_0, MY_IID_PPV_ARGS(&pDevice)));
+			g_Device = pDevice.Detach();
+		}
 	}
 	
 
@@ -341,26 +410,40 @@ void Graphics::Initialize(void)
 
 	g_CommandManager.Create(g_Device);
 
-	DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
-	swapChainDesc.BufferDesc.Width = g_DisplayWidth;
-	swapChainDesc.BufferDesc.Height = g_DisplayHeight;
-	swapChainDesc.BufferDesc.Format = SwapChainFormat;
-	swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-	swapChainDesc.SampleDesc.Quality = 0;
-	swapChainDesc.SampleDesc.Count = 1;
-	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;// | DXGI_USAGE_UNORDERED_ACCESS;
-	swapChainDesc.BufferCount = SWAP_CHAIN_BUFFER_COUNT;
-	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
-	swapChainDesc.OutputWindow = GameCore::g_hWnd;
-	swapChainDesc.Windowed = TRUE;
-	swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
-	ASSERT_SUCCEEDED(dxgiFactory->CreateSwapChain( g_CommandManager.GetCommandQueue(), &swapChainDesc, &s_PrimarySwapChain ));
+	// Staging memory for initial resource data uploaded on the copy queue
+	g_UploadManager.Create(64 * 1024 * 1024);
 
-	for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+	if (g_UseNullDevice)
+		CreateHeadlessDisplayPlanes();
+	else
 	{
-		ComPtr<ID3D12Resource> DisplayPlane;
-		ASSERT_SUCCEEDED(s_PrimarySwapChain->GetBuffer(i, MY_IID_PPV_ARGS(&DisplayPlane)));
-		g_DisplayPlane[i].CreateFromSwapChain(L"Primary SwapChain Buffer", DisplayPlane.Detach());
+		DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
+		swapChainDesc.BufferDesc.Width = g_DisplayWidth;
+		swapChainDesc.BufferDesc.Height = g_DisplayHeight;
+		swapChainDesc.BufferDesc.Format = SwapChainFormat;
+		swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+		swapChainDesc.SampleDesc.Quality = 0;
+		swapChainDesc.SampleDesc.Count = 1;
+		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;// | DXGI_USAGE_UNORDERED_ACCESS;
+		swapChainDesc.BufferCount = SWAP_CHAIN_BUFFER_COUNT;
+		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+		swapChainDesc.OutputWindow = GameCore::g_hWnd;
+		swapChainDesc.Windowed = TRUE;
+		swapChainDesc.Flags = kSwapChainFlags;
+		ASSERT_SUCCEEDED(dxgiFactory->CreateSwapChain( g_CommandManager.GetCommandQueue(), &swapChainDesc, &s_PrimarySwapChain ));
+
+		ComPtr<IDXGISwapChain2> SwapChain2;
+		ASSERT_SUCCEEDED(s_PrimarySwapChain->QueryInterface(MY_IID_PPV_ARGS(&SwapChain2)));
+		ASSERT_SUCCEEDED(SwapChain2->SetMaximumFrameLatency(s_MaxFrameLatency));
+		s_AppliedFrameLatency = s_MaxFrameLatency;
+		s_FrameLatencyWaitableObject = SwapChain2->GetFrameLatencyWaitableObject();
+
+		for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+		{
+			ComPtr<ID3D12Resource> DisplayPlane;
+			ASSERT_SUCCEEDED(s_PrimarySwapChain->GetBuffer(i, MY_IID_PPV_ARGS(&DisplayPlane)));
+			g_DisplayPlane[i].CreateFromSwapChain(L"Primary SwapChain Buffer", DisplayPlane.Detach());
+		}
 	}
 
 	SamplerLinearWrapDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
@@ -554,20 +637,28 @@ void Graphics::Initialize(void)
 void Graphics::Terminate(void)
 {
 	g_CommandManager.IdleGPU();
-	s_PrimarySwapChain->SetFullscreenState(FALSE, nullptr);
+	if (s_PrimarySwapChain != nullptr)
+		s_PrimarySwapChain->SetFullscreenState(FALSE, nullptr);
 }
 
 void Graphics::Shutdown(void)
 {
+	g_UploadManager.Shutdown();
 	CommandContext::DestroyAllContexts();
 	g_CommandManager.Shutdown();
 	GpuTimeManager::Shutdown();
-	s_PrimarySwapChain->Release();
+	if (s_FrameLatencyWaitableObject != nullptr)
+	{
+		CloseHandle(s_FrameLatencyWaitableObject);
+		s_FrameLatencyWaitableObject = nullptr;
+	}
+	SAFE_RELEASE(s_PrimarySwapChain);
 	PSO::DestroyAll();
 	RootSignature::DestroyAll();
 
 	DispatchIndirectCommandSignature.Destroy();
 	DrawIndirectCommandSignature.Destroy();
+	SamplerDescriptor::DestroyAll();
 	DescriptorAllocator::DestroyAll();
 
 	DestroyRenderingBuffers();
@@ -681,13 +772,26 @@ void Graphics::Present(void)
 	// Close the final context to be executed before frame present.
 	Context.Finish();
 
+	// Recycle everything the GPU has finished with.  This is the one fence poll per queue each frame.
+	g_CommandManager.ProcessCompletedFences();
+
 	g_CurrentBuffer = (g_CurrentBuffer + 1) % SWAP_CHAIN_BUFFER_COUNT;
 
 	UINT PresentInterval = s_EnableVSync ? std::min(4, (int)Round(s_FrameTime * 60.0f)) : 0;
 
-	s_PrimarySwapChain->Present(PresentInterval, 0);
+	if (s_PrimarySwapChain != nullptr)
+		s_PrimarySwapChain->Present(PresentInterval, 0);
 
+	// Input is sampled at the start of the frame, so this is how long the newest input took to be presented
+	int64_t PresentTick = SystemTime::GetCurrentTick();
+	if (s_FrameStartTick != 0)
+	{
+		float InputToPresentTime = (float)SystemTime::TimeBetweenTicks(s_FrameStartTick, PresentTick);
+		s_FramePacer.RecordFrame(InputToPresentTime, EngineProfiling::GetGpuFrameTime());
 
+		s_InputToPresentTime = InputToPresentTime * 1000.0f;
+		s_AvgInputToPresentTime = s_FramePacer.GetPredictedCpuTime() * 1000.0f;
+	}
 
 	// Test robustness to handle spikes in CPU time
 	//if (s_DropRandomFrames)
@@ -696,6 +800,30 @@ void Graphics::Present(void)
 	//		BusyLoopSleep(0.010);
 	//}
 
+	// Don't start the next frame until the swap chain has room for it.  Waiting here rather than in the next
+	// Present() keeps input from going stale while the frame sits in the queue.
+	if (s_FrameLatencyWaitableObject != nullptr)
+	{
+		if (s_AppliedFrameLatency != s_MaxFrameLatency)
+		{
+			ComPtr<IDXGISwapChain2> SwapChain2;
+			ASSERT_SUCCEEDED(s_PrimarySwapChain->QueryInterface(MY_IID_PPV_ARGS(&SwapChain2)));
+			ASSERT_SUCCEEDED(SwapChain2->SetMaximumFrameLatency(s_MaxFrameLatency));
+			s_AppliedFrameLatency = s_MaxFrameLatency;
+		}
+
+		WaitForSingleObjectEx(s_FrameLatencyWaitableObject, 1000, TRUE);
+	}
+
+	int64_t SwapChainReadyTick = SystemTime::GetCurrentTick();
+	s_SwapChainWaitTime = (float)SystemTime::TicksToMillisecs(SwapChainReadyTick - PresentTick);
+
+	// Then hold off until the CPU would finish the frame just as the GPU is ready for it
+	float PacingDelay = s_EnableFramePacing ? s_FramePacer.GetStartDelay() : 0.0f;
+	if (PacingDelay > 0.0f)
+		FramePacer::SleepUntil(SwapChainReadyTick + SystemTime::SecondsToTicks(PacingDelay));
+	s_PacingDelay = PacingDelay * 1000.0f;
+
 	int64_t CurrentTick = SystemTime::GetCurrentTick();
 
 	if (s_EnableVSync)
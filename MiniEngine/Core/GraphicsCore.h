@@ -24,6 +24,7 @@ class CommandContext;
 class CommandListManager;
 class CommandSignature;
 class ContextManager;
+class UploadManager;
 
 namespace Graphics
 {
@@ -54,8 +55,13 @@ namespace Graphics
 	float GetFrameRate(void);
 
 	extern ID3D12Device* g_Device;
+
+	// Run on the null device, with no GPU, window or swap chain.  Set before Initialize().  See NullDevice.h.
+	extern bool g_UseNullDevice;
+
 	extern CommandListManager g_CommandManager;
 	extern ContextManager g_ContextManager;
+	extern UploadManager g_UploadManager;
 
 	extern D3D_FEATURE_LEVEL g_D3DFeatureLevel;
 
@@ -0,0 +1,359 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "JobSystem.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace JobSystem
+{
+	struct Job
+	{
+		std::function<void(void)> Func;
+		Counter* pCounter;
+
+		void Execute(void)
+		{
+			Func();
+			if (pCounter != nullptr)
+				pCounter->m_Value.fetch_sub(1, std::memory_order_release);
+		}
+	};
+
+	// Chase-Lev deque with a fixed capacity.  Only the owning worker calls Push() and Pop(), which work on the
+	// bottom end.  Any thread may call Steal(), which takes from the top end.  The indices only increase (apart
+	// from Pop() temporarily reserving the bottom slot), and a slot is the index modulo the capacity.
+	class WorkStealingDeque
+	{
+	public:
+		static const int64_t kCapacity = 4096;
+
+		WorkStealingDeque() : m_Top(0), m_Bottom(0)
+		{
+			for (int64_t i = 0; i < kCapacity; ++i)
+				m_Jobs[i].store(nullptr, std::memory_order_relaxed);
+		}
+
+		// Returns false when the deque is full
+		bool Push( Job* NewJob )
+		{
+			int64_t Bottom = m_Bottom.load(std::memory_order_relaxed);
+			int64_t Top = m_Top.load(std::memory_order_acquire);
+			if (Bottom - Top >= kCapacity)
+				return false;
+
+			m_Jobs[Bottom & (kCapacity - 1)].store(NewJob, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		Job* Pop( void )
+		{
+			int64_t Bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+			m_Bottom.store(Bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t Top = m_Top.load(std::memory_order_relaxed);
+
+			if (Top > Bottom)
+			{
+				// Empty
+				m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			Job* PoppedJob = m_Jobs[Bottom & (kCapacity - 1)].load(std::memory_order_relaxed);
+			if (Top == Bottom)
+			{
+				// Last job.  Race the thieves for it.
+				if (!m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					PoppedJob = nullptr;
+				m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+			}
+			return PoppedJob;
+		}
+
+		Job* Steal( void )
+		{
+			int64_t Top = m_Top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t Bottom = m_Bottom.load(std::memory_order_acquire);
+
+			if (Top >= Bottom)
+				return nullptr;
+
+			Job* StolenJob = m_Jobs[Top & (kCapacity - 1)].load(std::memory_order_relaxed);
+			if (!m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+			return StolenJob;
+		}
+
+	private:
+		alignas(64) std::atomic<int64_t> m_Top;
+		alignas(64) std::atomic<int64_t> m_Bottom;
+		alignas(64) std::atomic<Job*> m_Jobs[kCapacity];
+	};
+
+	static const int32_t kNotAWorker = -1;
+
+	std::vector<std::thread> s_Workers;
+	std::unique_ptr<WorkStealingDeque[]> s_Deques;
+	uint32_t s_NumWorkers = 0;
+
+	// Jobs submitted by threads which are not workers, and by workers whose deque is full
+	std::mutex s_SharedQueueMutex;
+	std::deque<Job*> s_SharedQueue;
+
+	std::mutex s_SleepMutex;
+	std::condition_variable s_WakeCondition;
+	std::atomic<int32_t> s_NumQueuedJobs(0);
+	std::atomic<int32_t> s_NumSleeping(0);
+	std::atomic<bool> s_Quit(false);
+
+	thread_local int32_t s_WorkerIndex = kNotAWorker;
+	thread_local uint32_t s_VictimSeed = 0;
+
+	Job* FindJob( void )
+	{
+		Job* FoundJob = nullptr;
+
+		if (s_WorkerIndex != kNotAWorker)
+			FoundJob = s_Deques[s_WorkerIndex].Pop();
+
+		if (FoundJob == nullptr && s_NumQueuedJobs.load(std::memory_order_relaxed) > 0)
+		{
+			{
+				std::lock_guard<std::mutex> LockGuard(s_SharedQueueMutex);
+				if (!s_SharedQueue.empty())
+				{
+					FoundJob = s_SharedQueue.front();
+					s_SharedQueue.pop_front();
+				}
+			}
+
+			// Steal from the other workers, starting with a different victim each time to spread contention
+			if (FoundJob == nullptr)
+			{
+				s_VictimSeed = s_VictimSeed * 1664525u + 1013904223u;
+				uint32_t FirstVictim = (s_VictimSeed >> 16) % s_NumWorkers;
+
+				for (uint32_t i = 0; i < s_NumWorkers && FoundJob == nullptr; ++i)
+				{
+					uint32_t Victim = (FirstVictim + i) % s_NumWorkers;
+					if ((int32_t)Victim != s_WorkerIndex)
+						FoundJob = s_Deques[Victim].Steal();
+				}
+			}
+		}
+
+		if (FoundJob != nullptr)
+			s_NumQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+		return FoundJob;
+	}
+
+	void WorkerThread( int32_t WorkerIndex )
+	{
+		s_WorkerIndex = WorkerIndex;
+		s_VictimSeed = (uint32_t)WorkerIndex * 2654435761u;
+
+		while (!s_Quit.load(std::memory_order_acquire))
+		{
+			Job* NextJob = FindJob();
+
+			// Spin briefly before sleeping.  Jobs often come in bursts (e.g. ParallelFor), and waking a
+			// sleeping thread costs far more than a job.
+			for (uint32_t Spin = 0; NextJob == nullptr && Spin < 32; ++Spin)
+			{
+				std::this_thread::yield();
+				NextJob = FindJob();
+			}
+
+			if (NextJob != nullptr)
+			{
+				NextJob->Execute();
+				delete NextJob;
+				continue;
+			}
+
+			std::unique_lock<std::mutex> Lock(s_SleepMutex);
+			s_NumSleeping.fetch_add(1);
+			s_WakeCondition.wait(Lock, [] { return s_NumQueuedJobs.load() > 0 || s_Quit.load(); });
+			s_NumSleeping.fetch_sub(1);
+		}
+	}
+}
+
+void JobSystem::Initialize( uint32_t NumWorkers )
+{
+	ASSERT(s_NumWorkers == 0, "The job system is already running");
+
+	if (NumWorkers == 0)
+	{
+		uint32_t NumHardwareThreads = std::thread::hardware_concurrency();
+		NumWorkers = NumHardwareThreads > 1 ? NumHardwareThreads - 1 : 1;
+	}
+
+	s_Quit = false;
+	s_Deques.reset(new WorkStealingDeque[NumWorkers]);
+	s_NumWorkers = NumWorkers;
+
+	s_Workers.reserve(NumWorkers);
+	for (uint32_t i = 0; i < NumWorkers; ++i)
+		s_Workers.emplace_back(WorkerThread, (int32_t)i);
+}
+
+void JobSystem::Shutdown( void )
+{
+	if (s_NumWorkers == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> LockGuard(s_SleepMutex);
+		s_Quit = true;
+	}
+	s_WakeCondition.notify_all();
+
+	for (auto& Worker : s_Workers)
+		Worker.join();
+	s_Workers.clear();
+
+	// Run whatever was left so that nobody waits on a counter forever
+	while (RunPendingJob())
+		;
+
+	s_NumWorkers = 0;
+	s_Deques.reset();
+}
+
+uint32_t JobSystem::GetNumWorkers( void )
+{
+	return s_NumWorkers;
+}
+
+void JobSystem::Run( const std::function<void(void)>& Func, Counter* pCounter )
+{
+	if (s_NumWorkers == 0)
+	{
+		Func();
+		return;
+	}
+
+	Job* NewJob = new Job;
+	NewJob->Func = Func;
+	NewJob->pCounter = pCounter;
+
+	if (pCounter != nullptr)
+		pCounter->m_Value.fetch_add(1, std::memory_order_relaxed);
+
+	// Count the job before it becomes visible, so that a worker which finds it never sees a negative count
+	s_NumQueuedJobs.fetch_add(1);
+
+	if (s_WorkerIndex == kNotAWorker || !s_Deques[s_WorkerIndex].Push(NewJob))
+	{
+		std::lock_guard<std::mutex> LockGuard(s_SharedQueueMutex);
+		s_SharedQueue.push_back(NewJob);
+	}
+
+	// Taking the lock orders this wake-up after a worker which is about to sleep has checked the job count
+	if (s_NumSleeping.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> LockGuard(s_SleepMutex);
+		}
+		s_WakeCondition.notify_one();
+	}
+}
+
+bool JobSystem::RunPendingJob( void )
+{
+	if (s_Deques == nullptr)
+		return false;
+
+	Job* NextJob = FindJob();
+	if (NextJob == nullptr)
+		return false;
+
+	NextJob->Execute();
+	delete NextJob;
+	return true;
+}
+
+void JobSystem::Wait( Counter& JobCounter )
+{
+	while (!JobCounter.IsComplete())
+	{
+		if (!RunPendingJob())
+			std::this_thread::yield();
+	}
+}
+
+namespace JobSystem
+{
+	// Shared by the thread calling ParallelFor() and its helper jobs.  Helpers which only start after every
+	// chunk was taken return without touching the caller's stack, so the state is reference counted.
+	struct ParallelForState
+	{
+		std::function<void(size_t, size_t)> Func;
+		size_t Count;
+		size_t GrainSize;
+		size_t NumChunks;
+		std::atomic<size_t> NextChunk;
+		std::atomic<size_t> NumChunksDone;
+
+		void RunChunks( void )
+		{
+			for (size_t Chunk = NextChunk.fetch_add(1); Chunk < NumChunks; Chunk = NextChunk.fetch_add(1))
+			{
+				size_t Begin = Chunk * GrainSize;
+				Func(Begin, std::min(Begin + GrainSize, Count));
+				NumChunksDone.fetch_add(1, std::memory_order_release);
+			}
+		}
+	};
+}
+
+void JobSystem::ParallelFor( size_t Count, size_t GrainSize, const std::function<void(size_t, size_t)>& Func )
+{
+	if (Count == 0)
+		return;
+
+	// Aim for a few chunks per thread so that uneven chunks balance out
+	if (GrainSize == 0)
+		GrainSize = std::max<size_t>(1, Count / ((s_NumWorkers + 1) * 4));
+
+	if (s_NumWorkers == 0 || GrainSize >= Count)
+	{
+		Func(0, Count);
+		return;
+	}
+
+	std::shared_ptr<ParallelForState> State = std::make_shared<ParallelForState>();
+	State->Func = Func;
+	State->Count = Count;
+	State->GrainSize = GrainSize;
+	State->NumChunks = (Count + GrainSize - 1) / GrainSize;
+	State->NextChunk = 0;
+	State->NumChunksDone = 0;
+
+	// Each helper keeps taking chunks until there are none left, so one per worker is enough
+	size_t NumHelpers = std::min<size_t>(State->NumChunks - 1, s_NumWorkers);
+	for (size_t i = 0; i < NumHelpers; ++i)
+		Run([State] { State->RunChunks(); });
+
+	State->RunChunks();
+
+	// The remaining chunks are running on other threads.  Running other jobs here could start one which
+	// waits on whatever the caller is in the middle of, so just wait for them.
+	while (State->NumChunksDone.load(std::memory_order_acquire) < State->NumChunks)
+		std::this_thread::yield();
+}
@@ -0,0 +1,67 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  A work-stealing job scheduler built on std::thread.  Every worker owns a Chase-Lev deque.  It
+// pushes and pops jobs at the bottom of its own deque without locking, and idle workers steal from the top of
+// the other workers' deques.  Jobs submitted from threads which are not workers go through a shared queue.
+//
+// Completion is tracked with counters.  A counter is incremented when a job is submitted against it and
+// decremented when the job finishes, so a job that depends on others waits on their counter.  Waiting runs
+// other jobs instead of blocking, so jobs may wait on jobs they spawned.  Until Initialize() is called (and
+// after Shutdown()) jobs run inline on the submitting thread.
+//
+// A job run by Wait() sits on top of the waiting code on the same stack, and the waiting code cannot resume
+// until it returns.  So Wait() must not be called by code which other jobs may block on, such as a job in the
+// middle of loading a resource other jobs are waiting for.  ParallelFor() does not have this problem:  while
+// its chunks finish on other threads, the caller only runs chunks of the same loop, so it is safe to use
+// anywhere, including inside jobs.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+namespace JobSystem
+{
+	class Counter
+	{
+	public:
+		Counter() : m_Value(0) {}
+
+		bool IsComplete(void) const { return m_Value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend struct Job;
+		friend void Run( const std::function<void(void)>&, Counter* );
+
+		Counter(const Counter&);
+		Counter& operator=(const Counter&);
+
+		std::atomic<int32_t> m_Value;
+	};
+
+	// Start the workers.  By default there is one worker per hardware thread, less one for the main thread.
+	void Initialize( uint32_t NumWorkers = 0 );
+	void Shutdown( void );
+
+	uint32_t GetNumWorkers( void );
+
+	// Queue a job.  If a counter is given, it is incremented now and decremented once the job has run.
+	void Run( const std::function<void(void)>& Func, Counter* pCounter = nullptr );
+
+	// Run queued jobs until the counter reaches zero
+	void Wait( Counter& JobCounter );
+
+	// Run one queued job if there is any.  Returns false when no job could be found.
+	bool RunPendingJob( void );
+
+	// Split [0, Count) into chunks of at most GrainSize elements and call Func(Begin, End) for each chunk in
+	// parallel.  Returns when every chunk has been processed.  A GrainSize of zero picks one based on the
+	// number of workers.  The calling thread processes chunks too, but never runs unrelated jobs.
+	void ParallelFor( size_t Count, size_t GrainSize, const std::function<void(size_t Begin, size_t End)>& Func );
+}
@@ -34,12 +34,15 @@ LinearAllocatorPageManager LinearAllocator::sm_PageManager[2];
 
 LinearAllocationPage* LinearAllocatorPageManager::RequestPage()
 {
-	lock_guard<mutex> LockGuard(m_Mutex);
+	unique_lock<mutex> Lock(m_Mutex);
 
-	while (!m_RetiredPages.empty() && g_CommandManager.IsFenceComplete(m_RetiredPages.front().first))
+	// Retired pages return when their fence callbacks run.  Before growing the pool, give any which have
+	// finished since the last poll a chance to return.  The callbacks take m_Mutex.
+	if (m_AvailablePages.empty())
 	{
-		m_AvailablePages.push(m_RetiredPages.front().second);
-		m_RetiredPages.pop();
+		Lock.unlock();
+		g_CommandManager.ProcessCompletedFences();
+		Lock.lock();
 	}
 
 	LinearAllocationPage* PagePtr = nullptr;
@@ -59,10 +62,23 @@ LinearAllocationPage* LinearAllocatorPageManager::RequestPage()
 }
 
 void LinearAllocatorPageManager::DiscardPages( uint64_t FenceValue, const vector<LinearAllocationPage*>& UsedPages )
+{
+	if (UsedPages.empty())
+		return;
+
+	g_CommandManager.OnFenceComplete(FenceValue, [this, UsedPages]( void )
+	{
+		lock_guard<mutex> LockGuard(m_Mutex);
+		for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
+			m_AvailablePages.push(*iter);
+	});
+}
+
+void LinearAllocatorPageManager::Destroy( void )
 {
 	lock_guard<mutex> LockGuard(m_Mutex);
-	for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
-		m_RetiredPages.push(make_pair(FenceValue, *iter));
+	m_AvailablePages = queue<LinearAllocationPage*>();
+	m_PagePool.clear();
 }
 
 LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage( void )
@@ -87,7 +87,7 @@ public:
 	LinearAllocationPage* RequestPage( void );
 	void DiscardPages( uint64_t FenceID, const std::vector<LinearAllocationPage*>& Pages );
 
-	void Destroy( void ) { m_PagePool.clear(); }
+	void Destroy( void );
 
 private:
 
@@ -97,7 +97,6 @@ private:
 
 	LinearAllocatorType m_AllocationType;
 	std::vector<std::unique_ptr<LinearAllocationPage> > m_PagePool;
-	std::queue<std::pair<uint64_t, LinearAllocationPage*> > m_RetiredPages;
 	std::queue<LinearAllocationPage*> m_AvailablePages;
 	std::mutex m_Mutex;
 };
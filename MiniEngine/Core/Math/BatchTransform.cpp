@@ -0,0 +1,305 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "BatchTransform.h"
+#include <intrin.h>
+
+using namespace Math;
+using namespace Math::BatchTransform;
+
+// Matrix4 keeps its basis vectors and translation in rows r[0] to r[3], and Matrix4 * v sums the rows weighted by
+// the components of v.  So component j of a transformed point is x * m[0][j] + y * m[1][j] + z * m[2][j] + m[3][j].
+namespace
+{
+	bool DetectAVXAndFMA( void )
+	{
+		int CPUInfo[4];
+		__cpuid(CPUInfo, 1);
+
+		// The OS must save the upper halves of the YMM registers for AVX to be usable
+		const bool HasOSXSAVE = (CPUInfo[2] & (1 << 27)) != 0;
+		const bool HasAVX = (CPUInfo[2] & (1 << 28)) != 0;
+		const bool HasFMA = (CPUInfo[2] & (1 << 12)) != 0;
+		return HasOSXSAVE && HasAVX && HasFMA && (_xgetbv(0) & 6) == 6;
+	}
+
+	bool UseAVX( void )
+	{
+		static const bool s_HasAVXAndFMA = DetectAVXAndFMA();
+		return s_HasAVXAndFMA;
+	}
+
+	// The elements of a matrix splatted across AVX registers
+	struct SplatMatrix
+	{
+		SplatMatrix( const Matrix4& Xform )
+		{
+			XMFLOAT4X4 Elements;
+			XMStoreFloat4x4(&Elements, Xform);
+			for (uint32_t Row = 0; Row < 4; ++Row)
+			{
+				for (uint32_t Column = 0; Column < 4; ++Column)
+				{
+					m[Row][Column] = _mm256_set1_ps(Elements.m[Row][Column]);
+					Abs[Row][Column] = _mm256_set1_ps(fabsf(Elements.m[Row][Column]));
+				}
+			}
+		}
+
+		__m256 m[4][4];
+		__m256 Abs[4][4];
+	};
+
+	__forceinline __m256 TransformComponent( const SplatMatrix& M, uint32_t j, __m256 x, __m256 y, __m256 z )
+	{
+		return _mm256_fmadd_ps(z, M.m[2][j], _mm256_fmadd_ps(y, M.m[1][j], _mm256_fmadd_ps(x, M.m[0][j], M.m[3][j])));
+	}
+
+	// Each AVX function handles whole groups of eight objects, or two matrices, and returns how many it did
+	size_t TransformPointsAVX( const Matrix4& Xform, const PointStreams& In, const PointStreams& Out, float* OutW, size_t Count )
+	{
+		const SplatMatrix M(Xform);
+
+		size_t i = 0;
+		for (; i + 8 <= Count; i += 8)
+		{
+			const __m256 x = _mm256_loadu_ps(In.X + i);
+			const __m256 y = _mm256_loadu_ps(In.Y + i);
+			const __m256 z = _mm256_loadu_ps(In.Z + i);
+
+			_mm256_storeu_ps(Out.X + i, TransformComponent(M, 0, x, y, z));
+			_mm256_storeu_ps(Out.Y + i, TransformComponent(M, 1, x, y, z));
+			_mm256_storeu_ps(Out.Z + i, TransformComponent(M, 2, x, y, z));
+			if (OutW != nullptr)
+				_mm256_storeu_ps(OutW + i, TransformComponent(M, 3, x, y, z));
+		}
+
+		_mm256_zeroupper();
+		return i;
+	}
+
+	size_t TransformSpheresAVX( const Matrix4& Xform, float RadiusScale, const SphereStreams& In, const SphereStreams& Out, size_t Count )
+	{
+		const SplatMatrix M(Xform);
+		const __m256 Scale = _mm256_set1_ps(RadiusScale);
+
+		size_t i = 0;
+		for (; i + 8 <= Count; i += 8)
+		{
+			const __m256 x = _mm256_loadu_ps(In.X + i);
+			const __m256 y = _mm256_loadu_ps(In.Y + i);
+			const __m256 z = _mm256_loadu_ps(In.Z + i);
+
+			_mm256_storeu_ps(Out.X + i, TransformComponent(M, 0, x, y, z));
+			_mm256_storeu_ps(Out.Y + i, TransformComponent(M, 1, x, y, z));
+			_mm256_storeu_ps(Out.Z + i, TransformComponent(M, 2, x, y, z));
+			_mm256_storeu_ps(Out.Radius + i, _mm256_mul_ps(_mm256_loadu_ps(In.Radius + i), Scale));
+		}
+
+		_mm256_zeroupper();
+		return i;
+	}
+
+	// Transform the center, and sum the extents along each basis vector with signs dropped
+	size_t TransformBoxesAVX( const Matrix4& Xform, const BoxStreams& In, const BoxStreams& Out, size_t Count )
+	{
+		const SplatMatrix M(Xform);
+		const __m256 Half = _mm256_set1_ps(0.5f);
+
+		size_t i = 0;
+		for (; i + 8 <= Count; i += 8)
+		{
+			const __m256 MinX = _mm256_loadu_ps(In.MinX + i);
+			const __m256 MinY = _mm256_loadu_ps(In.MinY + i);
+			const __m256 MinZ = _mm256_loadu_ps(In.MinZ + i);
+			const __m256 MaxX = _mm256_loadu_ps(In.MaxX + i);
+			const __m256 MaxY = _mm256_loadu_ps(In.MaxY + i);
+			const __m256 MaxZ = _mm256_loadu_ps(In.MaxZ + i);
+
+			const __m256 cx = _mm256_mul_ps(_mm256_add_ps(MinX, MaxX), Half);
+			const __m256 cy = _mm256_mul_ps(_mm256_add_ps(MinY, MaxY), Half);
+			const __m256 cz = _mm256_mul_ps(_mm256_add_ps(MinZ, MaxZ), Half);
+			const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(MaxX, MinX), Half);
+			const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(MaxY, MinY), Half);
+			const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(MaxZ, MinZ), Half);
+
+			float* OutMin[3] = { Out.MinX + i, Out.MinY + i, Out.MinZ + i };
+			float* OutMax[3] = { Out.MaxX + i, Out.MaxY + i, Out.MaxZ + i };
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				const __m256 Center = TransformComponent(M, j, cx, cy, cz);
+				const __m256 Extent = _mm256_fmadd_ps(ez, M.Abs[2][j], _mm256_fmadd_ps(ey, M.Abs[1][j], _mm256_mul_ps(ex, M.Abs[0][j])));
+				_mm256_storeu_ps(OutMin[j], _mm256_sub_ps(Center, Extent));
+				_mm256_storeu_ps(OutMax[j], _mm256_add_ps(Center, Extent));
+			}
+		}
+
+		_mm256_zeroupper();
+		return i;
+	}
+
+	// Two rows of In at a time, one per 128-bit lane.  Each output row sums the rows of Xform weighted by the
+	// elements of the same row of In.
+	size_t MultiplyMatricesAVX( const Matrix4& Xform, const Matrix4* In, Matrix4* Out, size_t Count )
+	{
+		const XMMATRIX X = Xform;
+		__m256 Rows[4];
+		for (uint32_t k = 0; k < 4; ++k)
+			Rows[k] = _mm256_broadcast_ps(&X.r[k]);
+
+		for (size_t i = 0; i < Count; ++i)
+		{
+			const float* Source = (const float*)&In[i];
+			float* Dest = (float*)&Out[i];
+
+			for (uint32_t Half = 0; Half < 2; ++Half)
+			{
+				const __m256 Pair = _mm256_loadu_ps(Source + Half * 8);
+				__m256 Result = _mm256_mul_ps(_mm256_permute_ps(Pair, 0x00), Rows[0]);
+				Result = _mm256_fmadd_ps(_mm256_permute_ps(Pair, 0x55), Rows[1], Result);
+				Result = _mm256_fmadd_ps(_mm256_permute_ps(Pair, 0xAA), Rows[2], Result);
+				Result = _mm256_fmadd_ps(_mm256_permute_ps(Pair, 0xFF), Rows[3], Result);
+				_mm256_storeu_ps(Dest + Half * 8, Result);
+			}
+		}
+
+		_mm256_zeroupper();
+		return Count;
+	}
+
+	__forceinline __m256 LoadRowPair( const Matrix4* In, size_t i, uint32_t Row )
+	{
+		const float* First = (const float*)&In[i] + Row * 4;
+		const float* Second = (const float*)&In[i + 1] + Row * 4;
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(First)), _mm_loadu_ps(Second), 1);
+	}
+
+	__forceinline void StoreRowPair( Matrix4* Out, size_t i, uint32_t Row, __m256 Pair )
+	{
+		_mm_storeu_ps((float*)&Out[i] + Row * 4, _mm256_castps256_ps128(Pair));
+		_mm_storeu_ps((float*)&Out[i + 1] + Row * 4, _mm256_extractf128_ps(Pair, 1));
+	}
+
+	// Two matrices at a time, one per 128-bit lane.  Transposing the rows yields the inverse basis, with the old
+	// translation in w, and the new translation is minus the old one rotated by the inverse basis.
+	size_t OrthoInvertMatricesAVX( const Matrix4* In, Matrix4* Out, size_t Count )
+	{
+		const __m256 Zero = _mm256_setzero_ps();
+		const __m256 One = _mm256_set1_ps(1.0f);
+
+		size_t i = 0;
+		for (; i + 2 <= Count; i += 2)
+		{
+			const __m256 r0 = LoadRowPair(In, i, 0);
+			const __m256 r1 = LoadRowPair(In, i, 1);
+			const __m256 r2 = LoadRowPair(In, i, 2);
+			const __m256 r3 = LoadRowPair(In, i, 3);
+
+			const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+			const __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+			const __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+			const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+			const __m256 c0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m256 c1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+			const __m256 c2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+
+			__m256 Translation = _mm256_mul_ps(_mm256_permute_ps(r3, 0x00), c0);
+			Translation = _mm256_fmadd_ps(_mm256_permute_ps(r3, 0x55), c1, Translation);
+			Translation = _mm256_fmadd_ps(_mm256_permute_ps(r3, 0xAA), c2, Translation);
+
+			StoreRowPair(Out, i, 0, _mm256_blend_ps(c0, Zero, 0x88));
+			StoreRowPair(Out, i, 1, _mm256_blend_ps(c1, Zero, 0x88));
+			StoreRowPair(Out, i, 2, _mm256_blend_ps(c2, Zero, 0x88));
+			StoreRowPair(Out, i, 3, _mm256_blend_ps(_mm256_sub_ps(Zero, Translation), One, 0x88));
+		}
+
+		_mm256_zeroupper();
+		return i;
+	}
+
+	float GetRadiusScale( const Matrix4& Xform )
+	{
+		return Sqrt(Max(Max(LengthSquare(Vector3(Xform.GetX())), LengthSquare(Vector3(Xform.GetY()))), LengthSquare(Vector3(Xform.GetZ()))));
+	}
+}
+
+void BatchTransform::TransformPoints( const Matrix4& Xform, const PointStreams& In, const PointStreams& Out, float* OutW, size_t Count )
+{
+	size_t i = UseAVX() ? TransformPointsAVX(Xform, In, Out, OutW, Count) : 0;
+
+	for (; i < Count; ++i)
+	{
+		Vector4 Point = Xform * Vector3(In.X[i], In.Y[i], In.Z[i]);
+		Out.X[i] = Point.GetX();
+		Out.Y[i] = Point.GetY();
+		Out.Z[i] = Point.GetZ();
+		if (OutW != nullptr)
+			OutW[i] = Point.GetW();
+	}
+}
+
+void BatchTransform::TransformSpheres( const Matrix4& Xform, const SphereStreams& In, const SphereStreams& Out, size_t Count )
+{
+	const float RadiusScale = GetRadiusScale(Xform);
+
+	size_t i = UseAVX() ? TransformSpheresAVX(Xform, RadiusScale, In, Out, Count) : 0;
+
+	for (; i < Count; ++i)
+	{
+		Vector4 Center = Xform * Vector3(In.X[i], In.Y[i], In.Z[i]);
+		Out.X[i] = Center.GetX();
+		Out.Y[i] = Center.GetY();
+		Out.Z[i] = Center.GetZ();
+		Out.Radius[i] = In.Radius[i] * RadiusScale;
+	}
+}
+
+void BatchTransform::TransformBoxes( const Matrix4& Xform, const BoxStreams& In, const BoxStreams& Out, size_t Count )
+{
+	size_t i = UseAVX() ? TransformBoxesAVX(Xform, In, Out, Count) : 0;
+
+	const Vector3 AbsX = Abs(Vector3(Xform.GetX()));
+	const Vector3 AbsY = Abs(Vector3(Xform.GetY()));
+	const Vector3 AbsZ = Abs(Vector3(Xform.GetZ()));
+
+	for (; i < Count; ++i)
+	{
+		Vector3 Min(In.MinX[i], In.MinY[i], In.MinZ[i]);
+		Vector3 Max(In.MaxX[i], In.MaxY[i], In.MaxZ[i]);
+		Vector3 Center = Vector3(Xform * ((Min + Max) * 0.5f));
+		Vector3 Extent = (Max - Min) * 0.5f;
+		Extent = AbsX * Extent.GetX() + AbsY * Extent.GetY() + AbsZ * Extent.GetZ();
+
+		Min = Center - Extent;
+		Max = Center + Extent;
+		Out.MinX[i] = Min.GetX();
+		Out.MinY[i] = Min.GetY();
+		Out.MinZ[i] = Min.GetZ();
+		Out.MaxX[i] = Max.GetX();
+		Out.MaxY[i] = Max.GetY();
+		Out.MaxZ[i] = Max.GetZ();
+	}
+}
+
+void BatchTransform::MultiplyMatrices( const Matrix4& Xform, const Matrix4* In, Matrix4* Out, size_t Count )
+{
+	size_t i = UseAVX() ? MultiplyMatricesAVX(Xform, In, Out, Count) : 0;
+
+	for (; i < Count; ++i)
+		Out[i] = Xform * In[i];
+}
+
+void BatchTransform::OrthoInvertMatrices( const Matrix4* In, Matrix4* Out, size_t Count )
+{
+	size_t i = UseAVX() ? OrthoInvertMatricesAVX(In, Out, Count) : 0;
+
+	for (; i < Count; ++i)
+		Out[i] = OrthoInvert(In[i]);
+}
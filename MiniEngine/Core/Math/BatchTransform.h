@@ -0,0 +1,68 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  Transforms for thousands of objects at a time.  Points, spheres and boxes are passed as
+// structures of arrays, one array per component, so that eight objects fill an AVX register with no
+// shuffling.  Matrices stay as arrays of Matrix4, since that is how they are uploaded.
+//
+// Each function uses AVX and FMA when the processor and OS support them, and otherwise falls back on the
+// Matrix4 and OrthoInvert() code it matches, one object at a time.  FMA rounds once where the fallback rounds
+// twice, so the two paths can differ in the last bit or so.
+//
+// The input and output of a call may be the same arrays.
+
+#pragma once
+
+#include "VectorMath.h"
+
+namespace Math
+{
+	namespace BatchTransform
+	{
+		struct PointStreams
+		{
+			float* X;
+			float* Y;
+			float* Z;
+		};
+
+		struct SphereStreams
+		{
+			float* X;
+			float* Y;
+			float* Z;
+			float* Radius;
+		};
+
+		struct BoxStreams
+		{
+			float* MinX;
+			float* MinY;
+			float* MinZ;
+			float* MaxX;
+			float* MaxY;
+			float* MaxZ;
+		};
+
+		// Out = Xform * Vector3(In), with w = 1.  OutW may be null when Xform is affine.
+		void TransformPoints( const Matrix4& Xform, const PointStreams& In, const PointStreams& Out, float* OutW, size_t Count );
+
+		// Xform must be affine.  Radii grow by the longest of its basis vectors, which keeps the spheres
+		// bounding under rotation and scale, but not under shear.
+		void TransformSpheres( const Matrix4& Xform, const SphereStreams& In, const SphereStreams& Out, size_t Count );
+
+		// The axis-aligned boxes which bound the transformed boxes.  Xform must be affine.
+		void TransformBoxes( const Matrix4& Xform, const BoxStreams& In, const BoxStreams& Out, size_t Count );
+
+		// Out[i] = Xform * In[i], which applies In[i] first
+		void MultiplyMatrices( const Matrix4& Xform, const Matrix4* In, Matrix4* Out, size_t Count );
+
+		// Out[i] = OrthoInvert(In[i]).  Each 3x3 must be orthonormal.
+		void OrthoInvertMatrices( const Matrix4* In, Matrix4* Out, size_t Count );
+	}
+}
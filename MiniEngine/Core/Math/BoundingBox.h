@@ -0,0 +1,121 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+#include "VectorMath.h"
+#include <cfloat>
+
+namespace Math
+{
+	class AxisAlignedBox
+	{
+	public:
+		// An empty box, which grows to fit the first point added
+		AxisAlignedBox() : m_min(FLT_MAX, FLT_MAX, FLT_MAX), m_max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+		explicit AxisAlignedBox( EZeroTag ) : m_min(kZero), m_max(kZero) {}
+		AxisAlignedBox( Vector3 min, Vector3 max ) : m_min(min), m_max(max) {}
+
+		void AddPoint( Vector3 point );
+		void AddBoundingBox( const AxisAlignedBox& box );
+
+		bool IsEmpty( void ) const;
+
+		Vector3 GetMin( void ) const { return m_min; }
+		Vector3 GetMax( void ) const { return m_max; }
+		Vector3 GetCenter( void ) const { return (m_min + m_max) * 0.5f; }
+		Vector3 GetDimensions( void ) const { return m_max - m_min; }
+		Vector3 GetExtent( void ) const { return (m_max - m_min) * 0.5f; }	// Half of the dimensions
+
+		// The box which bounds the transformed box
+		friend AxisAlignedBox operator* ( const AffineTransform& xform, const AxisAlignedBox& box );
+
+	private:
+
+		Vector3 m_min;
+		Vector3 m_max;
+	};
+
+	// A box at any orientation, stored as the transform of the cube from -1 to 1.  The basis vectors go from the
+	// center to the middles of three faces, so they are orthogonal unless the box was sheared.
+	class OrientedBox
+	{
+	public:
+		OrientedBox() {}
+		explicit OrientedBox( const AxisAlignedBox& box );
+		OrientedBox( const AffineTransform& xform, const AxisAlignedBox& box );
+
+		Vector3 GetCenter( void ) const { return m_repr.GetTranslation(); }
+		const Matrix3& GetHalfAxes( void ) const { return m_repr.GetBasis(); }
+
+		// How far the box reaches along a direction, from its center
+		Scalar GetProjectedExtent( Vector3 direction ) const;
+
+		friend OrientedBox operator* ( const AffineTransform& xform, const OrientedBox& box );
+
+	private:
+
+		AffineTransform m_repr;
+	};
+
+	//=======================================================================================================
+	// Inline implementations
+	//
+
+	inline void AxisAlignedBox::AddPoint( Vector3 point )
+	{
+		m_min = Min(point, m_min);
+		m_max = Max(point, m_max);
+	}
+
+	inline void AxisAlignedBox::AddBoundingBox( const AxisAlignedBox& box )
+	{
+		m_min = Min(box.m_min, m_min);
+		m_max = Max(box.m_max, m_max);
+	}
+
+	inline bool AxisAlignedBox::IsEmpty( void ) const
+	{
+		return !XMVector3LessOrEqual(m_min, m_max);
+	}
+
+	inline AxisAlignedBox operator* ( const AffineTransform& xform, const AxisAlignedBox& box )
+	{
+		// Each axis of the new box reaches as far as the absolute values of the basis allow
+		Matrix3 AbsBasis(Abs(xform.GetX()), Abs(xform.GetY()), Abs(xform.GetZ()));
+		Vector3 Center = xform * box.GetCenter();
+		Vector3 Extent = AbsBasis * box.GetExtent();
+		return AxisAlignedBox(Center - Extent, Center + Extent);
+	}
+
+	inline OrientedBox::OrientedBox( const AxisAlignedBox& box )
+		: m_repr(Matrix3::MakeScale(box.GetExtent()), box.GetCenter())
+	{
+	}
+
+	inline OrientedBox::OrientedBox( const AffineTransform& xform, const AxisAlignedBox& box )
+		: m_repr(xform * AffineTransform(Matrix3::MakeScale(box.GetExtent()), box.GetCenter()))
+	{
+	}
+
+	inline Scalar OrientedBox::GetProjectedExtent( Vector3 direction ) const
+	{
+		// Transposing the half axes dots the direction with each of them at once
+		Vector3 Reach = Abs(Transpose(m_repr.GetBasis()) * direction);
+		return Dot(Reach, Vector3(kOne));
+	}
+
+	inline OrientedBox operator* ( const AffineTransform& xform, const OrientedBox& box )
+	{
+		OrientedBox result;
+		result.m_repr = xform * box.m_repr;
+		return result;
+	}
+
+} // namespace Math
@@ -0,0 +1,433 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "BoundingVolumes.h"
+#include <emmintrin.h>
+#include <cmath>
+
+using namespace Math;
+
+namespace
+{
+	inline const float* PositionAt( const void* Positions, size_t Stride, size_t Index )
+	{
+		return (const float*)((const uint8_t*)Positions + Stride * Index);
+	}
+
+	// Reading four floats is safe whenever another position follows, because the stride is at least three floats.
+	// The fourth lane holds whatever comes next and is ignored.
+	__forceinline __m128 LoadPosition( const float* p )
+	{
+		return _mm_loadu_ps(p);
+	}
+
+	// The last position may end the buffer, so it must be read as exactly three floats
+	__forceinline __m128 LoadLastPosition( const float* p )
+	{
+		return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const double*)p)), _mm_load_ss(p + 2));
+	}
+
+	__forceinline Vector3 ToVector3( __m128 v )
+	{
+		// Copy z into w, as Vector3 does
+		return Vector3(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 1, 0)));
+	}
+
+	// Grows a sphere just enough to take in each point which lies outside it, moving the center toward the point
+	void GrowSphere( const void* Positions, size_t Stride, size_t Count, float Center[3], float& Radius )
+	{
+		float RadiusSq = Radius * Radius;
+
+		for (size_t i = 0; i < Count; ++i)
+		{
+			const float* p = PositionAt(Positions, Stride, i);
+			float dx = p[0] - Center[0];
+			float dy = p[1] - Center[1];
+			float dz = p[2] - Center[2];
+			float DistanceSq = dx * dx + dy * dy + dz * dz;
+			if (DistanceSq <= RadiusSq)
+				continue;
+
+			float Distance = sqrtf(DistanceSq);
+			float NewRadius = (Radius + Distance) * 0.5f;
+			float Shift = (NewRadius - Radius) / Distance;
+			Center[0] += dx * Shift;
+			Center[1] += dy * Shift;
+			Center[2] += dz * Shift;
+			Radius = NewRadius;
+			RadiusSq = Radius * Radius;
+		}
+	}
+
+	size_t FindFarthest( const void* Positions, size_t Stride, size_t Count, const float From[3] )
+	{
+		size_t Farthest = 0;
+		float FarthestSq = -1.0f;
+
+		for (size_t i = 0; i < Count; ++i)
+		{
+			const float* p = PositionAt(Positions, Stride, i);
+			float dx = p[0] - From[0];
+			float dy = p[1] - From[1];
+			float dz = p[2] - From[2];
+			float DistanceSq = dx * dx + dy * dy + dz * dz;
+			if (DistanceSq > FarthestSq)
+			{
+				FarthestSq = DistanceSq;
+				Farthest = i;
+			}
+		}
+
+		return Farthest;
+	}
+
+	//
+	// The smallest sphere around a handful of points, by Welzl's algorithm.  It works in doubles because the
+	// circumspheres of nearly degenerate supports are badly conditioned.
+	//
+
+	struct ExactSphere
+	{
+		double Center[3];
+		double RadiusSq;	// Negative when the sphere is empty
+	};
+
+	struct SupportSet
+	{
+		double Points[4][3];
+		int Count;
+	};
+
+	inline double DistanceSq( const double a[3], const double b[3] )
+	{
+		double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	inline bool Encloses( const ExactSphere& S, const double p[3] )
+	{
+		return S.RadiusSq >= 0.0 && DistanceSq(S.Center, p) <= S.RadiusSq * (1.0 + 1e-9) + 1e-12;
+	}
+
+	inline void Cross( const double a[3], const double b[3], double r[3] )
+	{
+		r[0] = a[1] * b[2] - a[2] * b[1];
+		r[1] = a[2] * b[0] - a[0] * b[2];
+		r[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	inline double Dot( const double a[3], const double b[3] )
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	ExactSphere SphereThrough( const double a[3], const double b[3] )
+	{
+		ExactSphere S;
+		for (int k = 0; k < 3; ++k)
+			S.Center[k] = (a[k] + b[k]) * 0.5;
+		S.RadiusSq = DistanceSq(a, b) * 0.25;
+		return S;
+	}
+
+	// The sphere whose great circle passes through three points
+	ExactSphere SphereThrough( const double a[3], const double b[3], const double c[3] )
+	{
+		double ab[3], ac[3], n[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			ab[k] = b[k] - a[k];
+			ac[k] = c[k] - a[k];
+		}
+		Cross(ab, ac, n);
+
+		double nn = Dot(n, n);
+		if (nn <= 1e-12 * Dot(ab, ab) * Dot(ac, ac))
+		{
+			// Collinear, so the two points farthest apart determine the sphere
+			ExactSphere S = SphereThrough(a, b);
+			ExactSphere T = SphereThrough(a, c);
+			ExactSphere U = SphereThrough(b, c);
+			if (T.RadiusSq > S.RadiusSq)
+				S = T;
+			if (U.RadiusSq > S.RadiusSq)
+				S = U;
+			return S;
+		}
+
+		double nab[3], acn[3];
+		Cross(n, ab, nab);
+		Cross(ac, n, acn);
+
+		double Scale = 0.5 / nn;
+		double abSq = Dot(ab, ab);
+		double acSq = Dot(ac, ac);
+
+		ExactSphere S;
+		double Offset[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			Offset[k] = (acSq * nab[k] + abSq * acn[k]) * Scale;
+			S.Center[k] = a[k] + Offset[k];
+		}
+		S.RadiusSq = Dot(Offset, Offset);
+		return S;
+	}
+
+	ExactSphere SphereThrough( const double a[3], const double b[3], const double c[3], const double d[3] )
+	{
+		double u[3], v[3], w[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			u[k] = b[k] - a[k];
+			v[k] = c[k] - a[k];
+			w[k] = d[k] - a[k];
+		}
+
+		double vw[3], wu[3], uv[3];
+		Cross(v, w, vw);
+		Cross(w, u, wu);
+		Cross(u, v, uv);
+
+		double Det = Dot(u, vw);
+		double Scale = sqrt(Dot(u, u) * Dot(v, v) * Dot(w, w));
+		if (fabs(Det) <= 1e-9 * Scale)
+		{
+			// Coplanar, so take the smallest circumsphere of three of the points which also encloses the fourth
+			const double* Points[4] = { a, b, c, d };
+			ExactSphere Best;
+			Best.RadiusSq = -1.0;
+			for (int Skip = 0; Skip < 4; ++Skip)
+			{
+				const double* Tri[3];
+				for (int k = 0, n = 0; k < 4; ++k)
+				{
+					if (k != Skip)
+						Tri[n++] = Points[k];
+				}
+				ExactSphere S = SphereThrough(Tri[0], Tri[1], Tri[2]);
+				if (Encloses(S, Points[Skip]) && (Best.RadiusSq < 0.0 || S.RadiusSq < Best.RadiusSq))
+					Best = S;
+			}
+			return Best;
+		}
+
+		ExactSphere S;
+		double Offset[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			Offset[k] = (Dot(u, u) * vw[k] + Dot(v, v) * wu[k] + Dot(w, w) * uv[k]) / (2.0 * Det);
+			S.Center[k] = a[k] + Offset[k];
+		}
+		S.RadiusSq = Dot(Offset, Offset);
+		return S;
+	}
+
+	ExactSphere SphereFromSupport( const SupportSet& R )
+	{
+		ExactSphere S;
+		switch (R.Count)
+		{
+		case 0:
+			S.Center[0] = S.Center[1] = S.Center[2] = 0.0;
+			S.RadiusSq = -1.0;
+			return S;
+		case 1:
+			S.Center[0] = R.Points[0][0];
+			S.Center[1] = R.Points[0][1];
+			S.Center[2] = R.Points[0][2];
+			S.RadiusSq = 0.0;
+			return S;
+		case 2:
+			return SphereThrough(R.Points[0], R.Points[1]);
+		case 3:
+			return SphereThrough(R.Points[0], R.Points[1], R.Points[2]);
+		default:
+			return SphereThrough(R.Points[0], R.Points[1], R.Points[2], R.Points[3]);
+		}
+	}
+
+	ExactSphere Welzl( const double (*Points)[3], int Count, SupportSet R )
+	{
+		if (Count == 0 || R.Count == 4)
+			return SphereFromSupport(R);
+
+		ExactSphere S = Welzl(Points, Count - 1, R);
+		if (Encloses(S, Points[Count - 1]))
+			return S;
+
+		// The point lies on the smallest sphere around the first Count points
+		for (int k = 0; k < 3; ++k)
+			R.Points[R.Count][k] = Points[Count - 1][k];
+		R.Count++;
+		return Welzl(Points, Count - 1, R);
+	}
+
+	// EPOS directions, as four groups of four in structure of arrays form.  The unused lanes are zero.
+	__declspec(align(16)) const float kDirectionX[16] = { 1, 0, 0, 1,   1, 1, 1, 1,   1, 1, 0, 1,   1, 0, 0, 0 };
+	__declspec(align(16)) const float kDirectionY[16] = { 0, 1, 0, 1,   1,-1,-1, 1,  -1, 0, 1, 0,   0, 1, 0, 0 };
+	__declspec(align(16)) const float kDirectionZ[16] = { 0, 0, 1, 1,  -1, 1,-1, 0,   0, 1, 1,-1,   0,-1, 0, 0 };
+}
+
+AxisAlignedBox Math::ComputeBoundingBox( const void* Positions, size_t Stride, size_t Count )
+{
+	ASSERT(Stride >= sizeof(float) * 3);
+
+	if (Count == 0)
+		return AxisAlignedBox();
+
+	// Four pairs of accumulators keep consecutive vertices from waiting on each other's min and max
+	__m128 Min0 = LoadLastPosition(PositionAt(Positions, Stride, Count - 1));
+	__m128 Max0 = Min0, Min1 = Min0, Max1 = Min0, Min2 = Min0, Max2 = Min0, Min3 = Min0, Max3 = Min0;
+
+	// Every position but the last has another after it, so it can be read with one load
+	const size_t Body = Count - 1;
+	const uint8_t* p = (const uint8_t*)Positions;
+
+	size_t i = 0;
+	for (; i + 4 <= Body; i += 4, p += Stride * 4)
+	{
+		__m128 P0 = LoadPosition((const float*)p);
+		__m128 P1 = LoadPosition((const float*)(p + Stride));
+		__m128 P2 = LoadPosition((const float*)(p + Stride * 2));
+		__m128 P3 = LoadPosition((const float*)(p + Stride * 3));
+		Min0 = _mm_min_ps(Min0, P0);
+		Max0 = _mm_max_ps(Max0, P0);
+		Min1 = _mm_min_ps(Min1, P1);
+		Max1 = _mm_max_ps(Max1, P1);
+		Min2 = _mm_min_ps(Min2, P2);
+		Max2 = _mm_max_ps(Max2, P2);
+		Min3 = _mm_min_ps(Min3, P3);
+		Max3 = _mm_max_ps(Max3, P3);
+	}
+	for (; i < Body; ++i, p += Stride)
+	{
+		__m128 P0 = LoadPosition((const float*)p);
+		Min0 = _mm_min_ps(Min0, P0);
+		Max0 = _mm_max_ps(Max0, P0);
+	}
+
+	Min0 = _mm_min_ps(_mm_min_ps(Min0, Min1), _mm_min_ps(Min2, Min3));
+	Max0 = _mm_max_ps(_mm_max_ps(Max0, Max1), _mm_max_ps(Max2, Max3));
+
+	return AxisAlignedBox(ToVector3(Min0), ToVector3(Max0));
+}
+
+BoundingSphere Math::ComputeBoundingSphereRitter( const void* Positions, size_t Stride, size_t Count )
+{
+	ASSERT(Stride >= sizeof(float) * 3);
+
+	if (Count == 0)
+		return BoundingSphere(Vector3(kZero), 0.0f);
+
+	// Start with the sphere through two points which are far apart:  the point farthest from an arbitrary
+	// point, and the point farthest from that
+	const float* First = PositionAt(Positions, Stride, 0);
+	const float* A = PositionAt(Positions, Stride, FindFarthest(Positions, Stride, Count, First));
+	const float* B = PositionAt(Positions, Stride, FindFarthest(Positions, Stride, Count, A));
+
+	float Center[3] = { (A[0] + B[0]) * 0.5f, (A[1] + B[1]) * 0.5f, (A[2] + B[2]) * 0.5f };
+	float dx = B[0] - A[0], dy = B[1] - A[1], dz = B[2] - A[2];
+	float Radius = sqrtf(dx * dx + dy * dy + dz * dz) * 0.5f;
+
+	GrowSphere(Positions, Stride, Count, Center, Radius);
+
+	return BoundingSphere(Vector3(Center[0], Center[1], Center[2]), Radius);
+}
+
+BoundingSphere Math::ComputeBoundingSphereEPOS( const void* Positions, size_t Stride, size_t Count, uint32_t NumDirections )
+{
+	ASSERT(Stride >= sizeof(float) * 3);
+	ASSERT(NumDirections == 3 || NumDirections == 7 || NumDirections == 13);
+
+	if (Count == 0)
+		return BoundingSphere(Vector3(kZero), 0.0f);
+
+	const uint32_t NumGroups = (NumDirections + 3) / 4;
+
+	__m128 DirX[4], DirY[4], DirZ[4];
+	__m128 MinProj[4], MaxProj[4];
+	__m128i MinIndex[4], MaxIndex[4];
+	for (uint32_t g = 0; g < NumGroups; ++g)
+	{
+		DirX[g] = _mm_load_ps(kDirectionX + g * 4);
+		DirY[g] = _mm_load_ps(kDirectionY + g * 4);
+		DirZ[g] = _mm_load_ps(kDirectionZ + g * 4);
+		MinProj[g] = _mm_set1_ps(FLT_MAX);
+		MaxProj[g] = _mm_set1_ps(-FLT_MAX);
+		MinIndex[g] = _mm_setzero_si128();
+		MaxIndex[g] = _mm_setzero_si128();
+	}
+
+	// Project each point onto four directions at a time, and keep the index of the extremes along each.
+	// Indices are 32 bits, so this handles up to four billion points.
+	for (size_t i = 0; i < Count; ++i)
+	{
+		const float* p = PositionAt(Positions, Stride, i);
+		const __m128 x = _mm_set1_ps(p[0]);
+		const __m128 y = _mm_set1_ps(p[1]);
+		const __m128 z = _mm_set1_ps(p[2]);
+		const __m128i Index = _mm_set1_epi32((int)i);
+
+		for (uint32_t g = 0; g < NumGroups; ++g)
+		{
+			__m128 Proj = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, DirX[g]), _mm_mul_ps(y, DirY[g])), _mm_mul_ps(z, DirZ[g]));
+
+			__m128i Below = _mm_castps_si128(_mm_cmplt_ps(Proj, MinProj[g]));
+			__m128i Above = _mm_castps_si128(_mm_cmpgt_ps(Proj, MaxProj[g]));
+			MinIndex[g] = _mm_or_si128(_mm_and_si128(Below, Index), _mm_andnot_si128(Below, MinIndex[g]));
+			MaxIndex[g] = _mm_or_si128(_mm_and_si128(Above, Index), _mm_andnot_si128(Above, MaxIndex[g]));
+			MinProj[g] = _mm_min_ps(MinProj[g], Proj);
+			MaxProj[g] = _mm_max_ps(MaxProj[g], Proj);
+		}
+	}
+
+	// The smallest sphere around the extreme points
+	double Extremes[26][3];
+	int NumExtremes = 0;
+	for (uint32_t g = 0; g < NumGroups; ++g)
+	{
+		__declspec(align(16)) uint32_t Indices[2][4];
+		_mm_store_si128((__m128i*)Indices[0], MinIndex[g]);
+		_mm_store_si128((__m128i*)Indices[1], MaxIndex[g]);
+
+		for (uint32_t Lane = 0; Lane < 4 && g * 4 + Lane < NumDirections; ++Lane)
+		{
+			for (uint32_t End = 0; End < 2; ++End)
+			{
+				const float* p = PositionAt(Positions, Stride, Indices[End][Lane]);
+				Extremes[NumExtremes][0] = p[0];
+				Extremes[NumExtremes][1] = p[1];
+				Extremes[NumExtremes][2] = p[2];
+				++NumExtremes;
+			}
+		}
+	}
+
+	SupportSet NoSupport;
+	NoSupport.Count = 0;
+	ExactSphere Exact = Welzl(Extremes, NumExtremes, NoSupport);
+
+	// Then grow it to take in the rest.  Should the exact sphere fail on a degenerate set of extremes, growing
+	// from a single point still gives a bounding sphere.
+	float Center[3] = { (float)Exact.Center[0], (float)Exact.Center[1], (float)Exact.Center[2] };
+	float Radius = (float)sqrt(Exact.RadiusSq);
+	if (!(Exact.RadiusSq >= 0.0))
+	{
+		Center[0] = (float)Extremes[0][0];
+		Center[1] = (float)Extremes[0][1];
+		Center[2] = (float)Extremes[0][2];
+		Radius = 0.0f;
+	}
+
+	GrowSphere(Positions, Stride, Count, Center, Radius);
+
+	return BoundingSphere(Vector3(Center[0], Center[1], Center[2]), Radius);
+}
@@ -0,0 +1,32 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  Bounding volumes computed from point sets, usually the vertex positions of a mesh.  The points
+// are read as three floats every Stride bytes, so positions can be read in place from an interleaved vertex
+// buffer.
+//
+// Ritter's sphere takes two passes over the points and is typically 5-20% larger than the smallest sphere.
+// EPOS (extremal points optimal sphere, Larsson 2008) takes the points which lie farthest along a few fixed
+// directions, finds the smallest sphere around just those, and grows it to fit the rest.  It costs a little more
+// and usually comes within a few percent of the smallest sphere.
+//
+
+#pragma once
+
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+
+namespace Math
+{
+	AxisAlignedBox ComputeBoundingBox( const void* Positions, size_t Stride, size_t Count );
+
+	BoundingSphere ComputeBoundingSphereRitter( const void* Positions, size_t Stride, size_t Count );
+
+	// NumDirections is 3, 7 or 13:  the axes, then the cube diagonals, then the cube edge diagonals
+	BoundingSphere ComputeBoundingSphereEPOS( const void* Positions, size_t Stride, size_t Count, uint32_t NumDirections = 7 );
+}
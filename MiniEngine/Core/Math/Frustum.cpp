@@ -86,8 +86,9 @@ Frustum::Frustum( const Matrix4& ProjMat )
 		float Right	 = ( 1.0f - ProjMatF[12]) * RcpXX;
 		float Top	 = ( 1.0f - ProjMatF[13]) * RcpYY;
 		float Bottom = (-1.0f - ProjMatF[13]) * RcpYY;
-		float Front	 = ( 0.0f - ProjMatF[14]) * RcpZZ;
-		float Back   = ( 1.0f - ProjMatF[14]) * RcpZZ;
+		// Clip depths 0 and 1 solve to view Z, which is negated to get distances in front of the camera
+		float Front	 = (ProjMatF[14] - 0.0f) * RcpZZ;
+		float Back   = (ProjMatF[14] - 1.0f) * RcpZZ;
 
 		// Check for reverse Z here.  The bounding planes need to point into the frustum.
 		if (Front < Back)
@@ -15,6 +15,7 @@
 
 #include "BoundingPlane.h"
 #include "BoundingSphere.h"
+#include "BoundingBox.h"
 
 namespace Math
 {
@@ -41,7 +42,19 @@ namespace Math
 
 		// Test whether the bounding sphere intersects the frustum.  Intersection is defined as either being
 		// fully contained in the frustum, or by intersecting one or more of the planes.
-		bool IntersectSphere( BoundingSphere sphere );
+		bool IntersectSphere( BoundingSphere sphere ) const;
+
+		// Test whether the box intersects the frustum.  Only the corner of the box farthest along each plane's
+		// normal (the p-vertex) is tested against that plane, so this is exact for boxes which lie completely
+		// outside one plane, and conservative near the frustum's edges and corners, like IntersectSphere().
+		bool IntersectBoundingBox( const AxisAlignedBox& box ) const;
+
+		// Test whether the box is completely inside the frustum, by testing the corner nearest to each plane
+		// (the n-vertex).  Objects which pass don't need to be tested further, e.g. their children in a hierarchy.
+		bool ContainsBoundingBox( const AxisAlignedBox& box ) const;
+
+		// The oriented equivalent of IntersectBoundingBox()
+		bool IntersectOrientedBox( const OrientedBox& box ) const;
 
 		friend Frustum  operator* ( const OrthogonalTransform& xform, const Frustum& frustum );	// Fast
 		friend Frustum  operator* ( const AffineTransform& xform, const Frustum& frustum );		// Slow
@@ -63,7 +76,7 @@ namespace Math
 	// Inline implementations
 	//
 
-	inline bool Frustum::IntersectSphere( BoundingSphere sphere )
+	inline bool Frustum::IntersectSphere( BoundingSphere sphere ) const
 	{
 		float radius = sphere.GetRadius();
 		for (int i = 0; i < 6; ++i)
@@ -74,6 +87,42 @@ namespace Math
 		return true;
 	}
 
+	inline bool Frustum::IntersectBoundingBox( const AxisAlignedBox& box ) const
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			BoundingPlane plane = m_FrustumPlanes[i];
+			Vector3 farCorner = Select(box.GetMin(), box.GetMax(), plane.GetNormal() > Vector3(kZero));
+			if (plane.DistanceFromPoint(farCorner) < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	inline bool Frustum::ContainsBoundingBox( const AxisAlignedBox& box ) const
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			BoundingPlane plane = m_FrustumPlanes[i];
+			Vector3 nearCorner = Select(box.GetMax(), box.GetMin(), plane.GetNormal() > Vector3(kZero));
+			if (plane.DistanceFromPoint(nearCorner) < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	inline bool Frustum::IntersectOrientedBox( const OrientedBox& box ) const
+	{
+		Vector3 center = box.GetCenter();
+		for (int i = 0; i < 6; ++i)
+		{
+			BoundingPlane plane = m_FrustumPlanes[i];
+			if (plane.DistanceFromPoint(center) + box.GetProjectedExtent(plane.GetNormal()) < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
 	inline Frustum operator* ( const OrthogonalTransform& xform, const Frustum& frustum )
 	{
 		Frustum result;
@@ -13,8 +13,165 @@
 
 #include "pch.h"
 #include "Random.h"
+#include <random>
 
 namespace Math
 {
 	RandomNumberGenerator g_RNG;
 }
+
+using namespace Math;
+
+namespace
+{
+	// Jump polynomials from the xoshiro128+ reference:  2^64 and 2^96 numbers ahead
+	const uint32_t kJump[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+	const uint32_t kLongJump[4] = { 0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662 };
+
+	// SplitMix64 spreads a small seed over the whole state, which must not be all zero
+	uint64_t SplitMix64( uint64_t& x )
+	{
+		uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// Four steps of xoshiro128+ at once, one per lane
+	__forceinline __m128i StepLanes( __m128i State[4] )
+	{
+		const __m128i Result = _mm_add_epi32(State[0], State[3]);
+		const __m128i Shifted = _mm_slli_epi32(State[1], 9);
+
+		State[2] = _mm_xor_si128(State[2], State[0]);
+		State[3] = _mm_xor_si128(State[3], State[1]);
+		State[1] = _mm_xor_si128(State[1], State[2]);
+		State[0] = _mm_xor_si128(State[0], State[3]);
+		State[2] = _mm_xor_si128(State[2], Shifted);
+		State[3] = _mm_or_si128(_mm_slli_epi32(State[3], 11), _mm_srli_epi32(State[3], 21));
+
+		return Result;
+	}
+
+	// The high 32 bits of each lane's 32x32 bit product, so each result is in [0, Range)
+	__forceinline __m128i ScaleLanes( __m128i Bits, __m128i Range )
+	{
+		const __m128i Even = _mm_mul_epu32(Bits, Range);
+		const __m128i Odd = _mm_mul_epu32(_mm_srli_epi64(Bits, 32), Range);
+		const __m128i HighMask = _mm_set_epi32(-1, 0, -1, 0);
+		return _mm_or_si128(_mm_srli_epi64(Even, 32), _mm_and_si128(Odd, HighMask));
+	}
+}
+
+void RandomNumberGenerator::ApplyJump( uint32_t State[4], const uint32_t Polynomial[4] )
+{
+	uint32_t Jumped[4] = { 0, 0, 0, 0 };
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		for (uint32_t b = 0; b < 32; ++b)
+		{
+			if (Polynomial[i] & 1u << b)
+			{
+				for (uint32_t w = 0; w < 4; ++w)
+					Jumped[w] ^= State[w];
+			}
+			Step(State);
+		}
+	}
+
+	for (uint32_t w = 0; w < 4; ++w)
+		State[w] = Jumped[w];
+}
+
+void RandomNumberGenerator::SetSeed( uint32_t Seed, uint32_t Stream )
+{
+	uint64_t x = Seed;
+	const uint64_t Low = SplitMix64(x);
+	const uint64_t High = SplitMix64(x);
+	m_State[0] = (uint32_t)Low;
+	m_State[1] = (uint32_t)(Low >> 32);
+	m_State[2] = (uint32_t)High;
+	m_State[3] = (uint32_t)(High >> 32);
+
+	for (uint32_t i = 0; i < Stream; ++i)
+		Jump();
+
+	// Lane n starts (n + 1) * 2^96 numbers past the scalar stream
+	uint32_t Lane[4][4];
+	uint32_t State[4] = { m_State[0], m_State[1], m_State[2], m_State[3] };
+	for (uint32_t n = 0; n < 4; ++n)
+	{
+		ApplyJump(State, kLongJump);
+		for (uint32_t w = 0; w < 4; ++w)
+			Lane[w][n] = State[w];
+	}
+
+	for (uint32_t w = 0; w < 4; ++w)
+		m_LaneState[w] = _mm_setr_epi32(Lane[w][0], Lane[w][1], Lane[w][2], Lane[w][3]);
+}
+
+void RandomNumberGenerator::SeedFromEntropy( void )
+{
+	std::random_device Device;
+	SetSeed(Device());
+}
+
+void RandomNumberGenerator::Jump( void )
+{
+	ApplyJump(m_State, kJump);
+}
+
+void RandomNumberGenerator::FillInts( int32_t* Dest, size_t Count, int32_t MinVal, int32_t MaxVal )
+{
+	ASSERT(MinVal <= MaxVal);
+
+	const uint64_t Range = (uint64_t)((int64_t)MaxVal - MinVal) + 1;
+	const bool FullRange = Range > 0xFFFFFFFFull;
+	const __m128i vRange = _mm_set1_epi32((int32_t)(uint32_t)Range);
+	const __m128i vMin = _mm_set1_epi32(MinVal);
+
+	size_t i = 0;
+	for (; i + 4 <= Count; i += 4)
+	{
+		__m128i Bits = StepLanes(m_LaneState);
+		if (!FullRange)
+			Bits = _mm_add_epi32(ScaleLanes(Bits, vRange), vMin);
+		_mm_storeu_si128((__m128i*)(Dest + i), Bits);
+	}
+
+	if (i < Count)
+	{
+		__m128i Bits = StepLanes(m_LaneState);
+		if (!FullRange)
+			Bits = _mm_add_epi32(ScaleLanes(Bits, vRange), vMin);
+
+		__declspec(align(16)) int32_t Last[4];
+		_mm_store_si128((__m128i*)Last, Bits);
+		for (uint32_t n = 0; i < Count; ++i, ++n)
+			Dest[i] = Last[n];
+	}
+}
+
+void RandomNumberGenerator::FillFloats( float* Dest, size_t Count, float MinVal, float MaxVal )
+{
+	const __m128 vScale = _mm_set1_ps((MaxVal - MinVal) * (1.0f / 16777216.0f));
+	const __m128 vMin = _mm_set1_ps(MinVal);
+
+	size_t i = 0;
+	for (; i + 4 <= Count; i += 4)
+	{
+		__m128 Unit = _mm_cvtepi32_ps(_mm_srli_epi32(StepLanes(m_LaneState), 8));
+		_mm_storeu_ps(Dest + i, _mm_add_ps(_mm_mul_ps(Unit, vScale), vMin));
+	}
+
+	if (i < Count)
+	{
+		__m128 Unit = _mm_cvtepi32_ps(_mm_srli_epi32(StepLanes(m_LaneState), 8));
+
+		__declspec(align(16)) float Last[4];
+		_mm_store_ps(Last, _mm_add_ps(_mm_mul_ps(Unit, vScale), vMin));
+		for (uint32_t n = 0; i < Count; ++i, ++n)
+			Dest[i] = Last[n];
+	}
+}
@@ -14,53 +14,114 @@
 #pragma once
 
 #include "Common.h"
-#include <random>
 
 namespace Math
 {
+	// xoshiro128+ (Blackman and Vigna).  Four words of state, a handful of integer operations per number, and the
+	// same sequence on every run for a given seed.  The low bits of xoshiro128+ are its weakest, so every result
+	// is taken from the high bits.
+	//
+	// Seeding is explicit:  a generator starts from kDefaultSeed unless given another, and only SeedFromEntropy()
+	// makes it differ from run to run.  Each stream from Jump() is 2^64 numbers past the last, so threads can share
+	// a seed without overlapping.  The Fill functions run four more streams side by side in SSE lanes, placed 2^96
+	// numbers apart, so they never overlap the scalar stream or any thread's stream either.
 	class RandomNumberGenerator
 	{
 	public:
-		RandomNumberGenerator() : m_gen(m_rd())
+		static const uint32_t kDefaultSeed = 0x5EED;
+
+		explicit RandomNumberGenerator( uint32_t Seed = kDefaultSeed, uint32_t Stream = 0 )
 		{
+			SetSeed(Seed, Stream);
 		}
 
 		// Default int range is [MIN_INT, MAX_INT].  Max value is included.
 		int32_t NextInt( void )
 		{
-			return std::uniform_int_distribution<int32_t>(0x80000000, 0x7FFFFFFF)(m_gen);
+			return (int32_t)Next();
 		}
 
 		int32_t NextInt( int32_t MaxVal )
 		{
-			return std::uniform_int_distribution<int32_t>(0, MaxVal)(m_gen);
+			return NextInt(0, MaxVal);
 		}
 
 		int32_t NextInt( int32_t MinVal, int32_t MaxVal )
 		{
-			return std::uniform_int_distribution<int32_t>(MinVal, MaxVal)(m_gen);
+			ASSERT(MinVal <= MaxVal);
+			return MinVal + (int32_t)NextBelow((uint64_t)((int64_t)MaxVal - MinVal) + 1);
 		}
 
 		// Default float range is [0.0f, 1.0f).  Max value is excluded.
 		float NextFloat( float MaxVal = 1.0f )
 		{
-			return std::uniform_real_distribution<float>(0.0f, MaxVal)(m_gen);
+			return ToUnitFloat(Next()) * MaxVal;
 		}
 
 		float NextFloat( float MinVal, float MaxVal )
 		{
-			return std::uniform_real_distribution<float>(MinVal, MaxVal)(m_gen);
+			return MinVal + ToUnitFloat(Next()) * (MaxVal - MinVal);
 		}
 
-		void SetSeed( UINT s )
+		// Fill an array with the same distributions as NextInt() and NextFloat(), four at a time.  The ints
+		// skip the rejection step NextInt() uses to stay exact, so each value's probability may be off by up to
+		// (MaxVal - MinVal + 1) / 2^32.
+		void FillInts( int32_t* Dest, size_t Count, int32_t MinVal, int32_t MaxVal );
+		void FillFloats( float* Dest, size_t Count, float MinVal = 0.0f, float MaxVal = 1.0f );
+
+		// Seeding resets the Fill lanes too.  Stream selects one of the sequences reached with Jump().
+		void SetSeed( uint32_t Seed, uint32_t Stream = 0 );
+		void SeedFromEntropy( void );
+
+		// Advance 2^64 numbers, to the start of the next stream
+		void Jump( void );
+
+	private:
+		static uint32_t Step( uint32_t State[4] )
 		{
-			m_gen.seed(s);
+			const uint32_t Result = State[0] + State[3];
+			const uint32_t Shifted = State[1] << 9;
+
+			State[2] ^= State[0];
+			State[3] ^= State[1];
+			State[1] ^= State[2];
+			State[0] ^= State[3];
+			State[2] ^= Shifted;
+			State[3] = State[3] << 11 | State[3] >> 21;
+
+			return Result;
 		}
 
-	private:
+		uint32_t Next( void ) { return Step(m_State); }
+
+		// The top 24 bits fill a float's mantissa exactly
+		static float ToUnitFloat( uint32_t Bits )
+		{
+			return (float)(Bits >> 8) * (1.0f / 16777216.0f);
+		}
+
+		// Lemire's multiply and shift, rejecting the few products that would favor some results
+		uint32_t NextBelow( uint64_t Range )
+		{
+			if (Range > 0xFFFFFFFFull)
+				return Next();
+
+			uint64_t Product = (uint64_t)Next() * Range;
+			if ((uint32_t)Product < (uint32_t)Range)
+			{
+				const uint32_t Threshold = (uint32_t)(0x100000000ull % Range);
+				while ((uint32_t)Product < Threshold)
+					Product = (uint64_t)Next() * Range;
+			}
+			return (uint32_t)(Product >> 32);
+		}
+
+		static void ApplyJump( uint32_t State[4], const uint32_t Polynomial[4] );
+
+		uint32_t m_State[4];
 
-		std::random_device m_rd;
-		std::minstd_rand m_gen;
+		// Word i of each of the four Fill lanes
+		__m128i m_LaneState[4];
 	};
 
 	extern RandomNumberGenerator g_RNG;
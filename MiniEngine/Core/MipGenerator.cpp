@@ -0,0 +1,401 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include <intrin.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace MipGenerator;
+
+namespace
+{
+	// Half-width of the Kaiser window in destination texels, and the shape of the window
+	const float kKaiserWidth = 3.0f;
+	const float kKaiserAlpha = 4.0f;
+
+	// Levels smaller than this are filtered on the calling thread, since the jobs would cost more than they save
+	const size_t kParallelThreshold = 64 * 64;
+
+	bool DetectAVX( void )
+	{
+		int CPUInfo[4];
+		__cpuid(CPUInfo, 1);
+
+		// The OS must save the upper halves of the YMM registers for AVX to be usable
+		const bool HasOSXSAVE = (CPUInfo[2] & (1 << 27)) != 0;
+		const bool HasAVX = (CPUInfo[2] & (1 << 28)) != 0;
+		return HasOSXSAVE && HasAVX && (_xgetbv(0) & 6) == 6;
+	}
+
+	bool UseAVX( void )
+	{
+		static const bool s_HasAVX = DetectAVX();
+		return s_HasAVX;
+	}
+
+	//
+	// Filter kernels
+	//
+
+	// The weights for one axis of the destination.  Each destination texel reads NumTaps source texels.  Indices
+	// are clamped to the edge of the source.
+	struct AxisKernel
+	{
+		uint32_t NumTaps;
+		std::vector<uint32_t> Indices;	// [DestIndex * NumTaps + Tap]
+		std::vector<float> Weights;
+	};
+
+	float BesselI0( float x )
+	{
+		float Sum = 1.0f;
+		float Term = 1.0f;
+		float HalfX = 0.5f * x;
+
+		for (int k = 1; k < 32 && Term > Sum * 1e-8f; ++k)
+		{
+			Term *= (HalfX / k) * (HalfX / k);
+			Sum += Term;
+		}
+
+		return Sum;
+	}
+
+	float KaiserSinc( float x )
+	{
+		if (fabsf(x) >= kKaiserWidth)
+			return 0.0f;
+
+		const float Pi = 3.14159265f;
+		float Sinc = x == 0.0f ? 1.0f : sinf(Pi * x) / (Pi * x);
+		float Ratio = x / kKaiserWidth;
+		return Sinc * BesselI0(kKaiserAlpha * sqrtf(1.0f - Ratio * Ratio)) / BesselI0(kKaiserAlpha);
+	}
+
+	void BuildKernel( FilterType Filter, uint32_t SrcSize, uint32_t DestSize, AxisKernel& Kernel )
+	{
+		// Source texels per destination texel, which is more than two when the source size is odd
+		const float Scale = (float)SrcSize / DestSize;
+		const float Radius = (Filter == kBoxFilter ? 0.5f : kKaiserWidth) * Scale;
+
+		Kernel.NumTaps = 1;
+		for (uint32_t d = 0; d < DestSize; ++d)
+		{
+			const float Center = (d + 0.5f) * Scale;
+			const int First = (int)floorf(Center - Radius);
+			const int Last = (int)ceilf(Center + Radius) - 1;
+			Kernel.NumTaps = std::max(Kernel.NumTaps, (uint32_t)(Last - First + 1));
+		}
+
+		Kernel.Indices.resize(DestSize * Kernel.NumTaps);
+		Kernel.Weights.resize(DestSize * Kernel.NumTaps);
+
+		for (uint32_t d = 0; d < DestSize; ++d)
+		{
+			const float Center = (d + 0.5f) * Scale;
+			const int First = (int)floorf(Center - Radius);
+
+			uint32_t* Indices = &Kernel.Indices[d * Kernel.NumTaps];
+			float* Weights = &Kernel.Weights[d * Kernel.NumTaps];
+			float Sum = 0.0f;
+
+			for (uint32_t t = 0; t < Kernel.NumTaps; ++t)
+			{
+				const int i = First + (int)t;
+
+				// The box weighs each texel by its overlap with the destination texel
+				if (Filter == kBoxFilter)
+					Weights[t] = std::max(0.0f, std::min(i + 1.0f, Center + Radius) - std::max((float)i, Center - Radius));
+				else
+					Weights[t] = KaiserSinc((i + 0.5f - Center) / Scale);
+
+				Indices[t] = (uint32_t)std::min(std::max(i, 0), (int)SrcSize - 1);
+				Sum += Weights[t];
+			}
+
+			for (uint32_t t = 0; t < Kernel.NumTaps; ++t)
+				Weights[t] /= Sum;
+		}
+	}
+
+	//
+	// Color conversion
+	//
+
+	float SRGBToLinear( float x )
+	{
+		return x <= 0.04045f ? x / 12.92f : powf((x + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB( float x )
+	{
+		return x <= 0.0031308f ? 12.92f * x : 1.055f * powf(x, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// Linear values are looked up in steps of 1/65535, which is a twentieth of a step of the output even at the
+	// steepest part of the curve
+	struct SRGBTables
+	{
+		SRGBTables()
+		{
+			for (int i = 0; i < 256; ++i)
+				ToLinear[i] = SRGBToLinear(i * (1.0f / 255.0f));
+
+			for (int i = 0; i < 65536; ++i)
+				FromLinear[i] = (uint8_t)(LinearToSRGB(i * (1.0f / 65535.0f)) * 255.0f + 0.5f);
+		}
+
+		float ToLinear[256];
+		uint8_t FromLinear[65536];
+	};
+
+	const SRGBTables& GetSRGBTables( void )
+	{
+		static const SRGBTables s_Tables;
+		return s_Tables;
+	}
+
+	// Expand a row to floats in [0, 1], one register per pixel
+	void ConvertRow( const uint32_t* Src, uint32_t Width, bool sRGB, __m128* Dest )
+	{
+		const __m128 Scale = _mm_set1_ps(1.0f / 255.0f);
+
+		if (sRGB)
+		{
+			const float* ToLinear = GetSRGBTables().ToLinear;
+			for (uint32_t x = 0; x < Width; ++x)
+			{
+				uint32_t P = Src[x];
+				Dest[x] = _mm_setr_ps(ToLinear[P & 0xFF], ToLinear[P >> 8 & 0xFF], ToLinear[P >> 16 & 0xFF],
+					(P >> 24) * (1.0f / 255.0f));
+			}
+			return;
+		}
+
+		const __m128i Zero = _mm_setzero_si128();
+		uint32_t x = 0;
+
+		for (; x + 4 <= Width; x += 4)
+		{
+			__m128i P = _mm_loadu_si128((const __m128i*)(Src + x));
+			__m128i Low = _mm_unpacklo_epi8(P, Zero);
+			__m128i High = _mm_unpackhi_epi8(P, Zero);
+			Dest[x + 0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(Low, Zero)), Scale);
+			Dest[x + 1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(Low, Zero)), Scale);
+			Dest[x + 2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(High, Zero)), Scale);
+			Dest[x + 3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(High, Zero)), Scale);
+		}
+
+		for (; x < Width; ++x)
+		{
+			__m128i P = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)Src[x]), Zero);
+			Dest[x] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(P, Zero)), Scale);
+		}
+	}
+
+	uint32_t PackPixel( __m128 Color, bool sRGB )
+	{
+		Color = _mm_min_ps(_mm_max_ps(Color, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+		__m128i Bytes = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Color, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+		Bytes = _mm_packs_epi32(Bytes, Bytes);
+		Bytes = _mm_packus_epi16(Bytes, Bytes);
+		uint32_t Pixel = (uint32_t)_mm_cvtsi128_si32(Bytes);
+
+		if (!sRGB)
+			return Pixel;
+
+		int32_t Indices[4];
+		_mm_storeu_si128((__m128i*)Indices,
+			_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Color, _mm_set1_ps(65535.0f)), _mm_set1_ps(0.5f))));
+
+		const uint8_t* FromLinear = GetSRGBTables().FromLinear;
+		return (Pixel & 0xFF000000) | FromLinear[Indices[0]] | FromLinear[Indices[1]] << 8 | FromLinear[Indices[2]] << 16;
+	}
+
+	void AccumulateRowSSE( __m128* Accum, const __m128* Row, uint32_t Width, float Weight )
+	{
+		const __m128 W = _mm_set1_ps(Weight);
+		for (uint32_t x = 0; x < Width; ++x)
+			Accum[x] = _mm_add_ps(Accum[x], _mm_mul_ps(Row[x], W));
+	}
+
+	// Two pixels per register
+	void AccumulateRowAVX( __m128* Accum, const __m128* Row, uint32_t Width, float Weight )
+	{
+		const __m256 W = _mm256_set1_ps(Weight);
+		float* Dest = (float*)Accum;
+		const float* Src = (const float*)Row;
+
+		uint32_t x = 0;
+		for (; x + 2 <= Width; x += 2)
+			_mm256_storeu_ps(Dest + x * 4, _mm256_add_ps(_mm256_loadu_ps(Dest + x * 4), _mm256_mul_ps(_mm256_loadu_ps(Src + x * 4), W)));
+
+		_mm256_zeroupper();
+
+		if (x < Width)
+			Accum[x] = _mm_add_ps(Accum[x], _mm_mul_ps(Row[x], _mm_set1_ps(Weight)));
+	}
+
+	//
+	// The scalar reference
+	//
+
+	float UnpackChannel( uint32_t Pixel, uint32_t Channel, bool sRGB )
+	{
+		float Value = (Pixel >> (8 * Channel) & 0xFF) * (1.0f / 255.0f);
+		return sRGB && Channel < 3 ? SRGBToLinear(Value) : Value;
+	}
+
+	uint32_t PackChannel( float Value, uint32_t Channel, bool sRGB )
+	{
+		Value = std::min(std::max(Value, 0.0f), 1.0f);
+		if (sRGB && Channel < 3)
+			Value = LinearToSRGB(Value);
+		return std::min((uint32_t)(Value * 255.0f + 0.5f), 255u) << (8 * Channel);
+	}
+}
+
+uint32_t MipGenerator::GetNumMips( uint32_t Width, uint32_t Height )
+{
+	uint32_t NumMips = 1;
+	for (uint32_t Size = std::max(Width, Height); Size > 1; Size >>= 1)
+		++NumMips;
+	return NumMips;
+}
+
+void MipGenerator::Downsample( FilterType Filter, bool sRGB, const uint32_t* Src, size_t SrcPitch, uint32_t SrcWidth,
+	uint32_t SrcHeight, uint32_t* Dest, size_t DestPitch )
+{
+	ASSERT(SrcWidth > 0 && SrcHeight > 0);
+
+	const uint32_t DestWidth = std::max(SrcWidth >> 1, 1u);
+	const uint32_t DestHeight = std::max(SrcHeight >> 1, 1u);
+
+	AxisKernel KernelX, KernelY;
+	BuildKernel(Filter, SrcWidth, DestWidth, KernelX);
+	BuildKernel(Filter, SrcHeight, DestHeight, KernelY);
+
+	auto AccumulateRow = UseAVX() ? AccumulateRowAVX : AccumulateRowSSE;
+
+	auto FilterRows = [&]( size_t Begin, size_t End )
+	{
+		std::vector<__m128> Converted(SrcWidth);
+		std::vector<__m128> Accum(SrcWidth);
+
+		for (size_t y = Begin; y < End; ++y)
+		{
+			// Filter the source rows down to one, then filter that row across
+			const uint32_t* RowIndices = &KernelY.Indices[y * KernelY.NumTaps];
+			const float* RowWeights = &KernelY.Weights[y * KernelY.NumTaps];
+
+			std::fill(Accum.begin(), Accum.end(), _mm_setzero_ps());
+
+			for (uint32_t t = 0; t < KernelY.NumTaps; ++t)
+			{
+				if (RowWeights[t] == 0.0f)
+					continue;
+
+				ConvertRow((const uint32_t*)((const uint8_t*)Src + RowIndices[t] * SrcPitch), SrcWidth, sRGB, Converted.data());
+				AccumulateRow(Accum.data(), Converted.data(), SrcWidth, RowWeights[t]);
+			}
+
+			uint32_t* DestRow = (uint32_t*)((uint8_t*)Dest + y * DestPitch);
+
+			for (uint32_t x = 0; x < DestWidth; ++x)
+			{
+				const uint32_t* Indices = &KernelX.Indices[x * KernelX.NumTaps];
+				const float* Weights = &KernelX.Weights[x * KernelX.NumTaps];
+
+				__m128 Sum = _mm_setzero_ps();
+				for (uint32_t t = 0; t < KernelX.NumTaps; ++t)
+					Sum = _mm_add_ps(Sum, _mm_mul_ps(Accum[Indices[t]], _mm_set1_ps(Weights[t])));
+
+				DestRow[x] = PackPixel(Sum, sRGB);
+			}
+		}
+	};
+
+	if ((size_t)DestWidth * DestHeight < kParallelThreshold)
+		FilterRows(0, DestHeight);
+	else
+		JobSystem::ParallelFor(DestHeight, 0, FilterRows);
+}
+
+void MipGenerator::DownsampleReference( FilterType Filter, bool sRGB, const uint32_t* Src, size_t SrcPitch,
+	uint32_t SrcWidth, uint32_t SrcHeight, uint32_t* Dest, size_t DestPitch )
+{
+	const uint32_t DestWidth = std::max(SrcWidth >> 1, 1u);
+	const uint32_t DestHeight = std::max(SrcHeight >> 1, 1u);
+
+	AxisKernel KernelX, KernelY;
+	BuildKernel(Filter, SrcWidth, DestWidth, KernelX);
+	BuildKernel(Filter, SrcHeight, DestHeight, KernelY);
+
+	for (uint32_t y = 0; y < DestHeight; ++y)
+	{
+		uint32_t* DestRow = (uint32_t*)((uint8_t*)Dest + y * DestPitch);
+
+		for (uint32_t x = 0; x < DestWidth; ++x)
+		{
+			float Sum[4] = {};
+
+			for (uint32_t ty = 0; ty < KernelY.NumTaps; ++ty)
+			{
+				const uint32_t SrcY = KernelY.Indices[y * KernelY.NumTaps + ty];
+				const float WeightY = KernelY.Weights[y * KernelY.NumTaps + ty];
+				const uint32_t* SrcRow = (const uint32_t*)((const uint8_t*)Src + SrcY * SrcPitch);
+
+				for (uint32_t tx = 0; tx < KernelX.NumTaps; ++tx)
+				{
+					const uint32_t Pixel = SrcRow[KernelX.Indices[x * KernelX.NumTaps + tx]];
+					const float Weight = WeightY * KernelX.Weights[x * KernelX.NumTaps + tx];
+
+					for (uint32_t c = 0; c < 4; ++c)
+						Sum[c] += Weight * UnpackChannel(Pixel, c, sRGB);
+				}
+			}
+
+			uint32_t Pixel = 0;
+			for (uint32_t c = 0; c < 4; ++c)
+				Pixel |= PackChannel(Sum[c], c, sRGB);
+			DestRow[x] = Pixel;
+		}
+	}
+}
+
+void MipGenerator::GenerateMipChain( std::vector<MipLevel>& Chain, FilterType Filter, bool sRGB, uint32_t MaxLevels )
+{
+	ASSERT(Chain.size() == 1, "Chain must hold only the source image");
+	ASSERT(Chain[0].Pixels.size() == (size_t)Chain[0].Width * Chain[0].Height);
+
+	uint32_t NumLevels = GetNumMips(Chain[0].Width, Chain[0].Height);
+	if (MaxLevels > 0 && MaxLevels < NumLevels)
+		NumLevels = MaxLevels;
+
+	Chain.reserve(NumLevels);
+
+	while (Chain.size() < NumLevels)
+	{
+		const MipLevel& Src = Chain.back();
+
+		MipLevel Next;
+		Next.Width = std::max(Src.Width >> 1, 1u);
+		Next.Height = std::max(Src.Height >> 1, 1u);
+		Next.Pixels.resize((size_t)Next.Width * Next.Height);
+
+		Downsample(Filter, sRGB, Src.Pixels.data(), Src.Width * sizeof(uint32_t), Src.Width, Src.Height,
+			Next.Pixels.data(), Next.Width * sizeof(uint32_t));
+
+		Chain.push_back(std::move(Next));
+	}
+}
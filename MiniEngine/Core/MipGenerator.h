@@ -0,0 +1,55 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  Generates mip chains on the CPU for textures that are loaded without one.  ColorBuffer does
+// the same on the GPU, but only for render targets.
+//
+// Each level is half the size of the one above, rounded down, as in ColorBuffer::GenerateMipMaps().  Where the
+// level above has an odd dimension, the filter covers the extra texel instead of undersampling:  the box
+// filter weighs each source texel by how much of it falls inside the destination texel, so 5 texels become 2
+// with weights of 1, 1 and 0.5.  The Kaiser filter is a windowed sinc, which keeps more detail in the smaller
+// levels at the cost of more taps.
+//
+// sRGB images are filtered in linear space and converted back, as g_GenerateMipsGammaPSO does.  The conversion
+// back uses the exact sRGB curve rather than the shader's cheaper fit to it:  each level here is filtered from
+// the 8-bit level above, so the fit's error would compound down the chain.  Alpha is always linear.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace MipGenerator
+{
+	enum FilterType { kBoxFilter, kKaiserFilter };
+
+	// Pixels are RGBA8 with red in the low byte, with no padding between rows
+	struct MipLevel
+	{
+		uint32_t Width;
+		uint32_t Height;
+		std::vector<uint32_t> Pixels;
+	};
+
+	// Levels in a full chain, down to 1x1
+	uint32_t GetNumMips( uint32_t Width, uint32_t Height );
+
+	// Filter one level down to the next.  Rows of the destination are filtered in parallel by the job system
+	// when it is running, which is safe from inside a job too.  Pitches are in bytes.
+	void Downsample( FilterType Filter, bool sRGB, const uint32_t* Src, size_t SrcPitch, uint32_t SrcWidth,
+		uint32_t SrcHeight, uint32_t* Dest, size_t DestPitch );
+
+	// The same filter done one tap at a time without SIMD, for validating Downsample().  Results differ by at
+	// most one in any channel, from the order of the sums.
+	void DownsampleReference( FilterType Filter, bool sRGB, const uint32_t* Src, size_t SrcPitch, uint32_t SrcWidth,
+		uint32_t SrcHeight, uint32_t* Dest, size_t DestPitch );
+
+	// Chain[0] holds the source image.  The levels below it are appended, each filtered from the one above,
+	// until there are MaxLevels or the last is 1x1.
+	void GenerateMipChain( std::vector<MipLevel>& Chain, FilterType Filter, bool sRGB, uint32_t MaxLevels = 0 );
+}
@@ -20,6 +20,7 @@
 #include "Camera.h"
 #include "PostEffects.h"
 #include "SystemTime.h"
+#include "FrameGraph.h"
 
 #include "CompiledShaders/CameraMotionBlurPrePassCS.h"
 #include "CompiledShaders/CameraMotionBlurPrePassLinearZCS.h"
@@ -53,6 +54,11 @@ namespace MotionBlur
 	ComputePSO s_MotionBlurPrePassCS;
 	ComputePSO s_MotionBlurFinalPassCS[2];
 	ComputePSO s_CameraVelocityCS[2];
+
+	// Schedules the blur passes.  The half resolution prep buffer is its transient texture.
+	FrameGraph s_MotionBlurGraph(L"Motion Blur");
+
+	FrameGraph::ResourceHandle CreatePrepBuffer( FrameGraph& Graph );
 }
 
 void MotionBlur::Initialize( void )
@@ -84,6 +90,14 @@ void MotionBlur::Initialize( void )
 
 void MotionBlur::Shutdown( void )
 {
+	s_MotionBlurGraph.Destroy();
+}
+
+FrameGraph::ResourceHandle MotionBlur::CreatePrepBuffer( FrameGraph& Graph )
+{
+	FrameGraph::TextureDesc Desc = { (g_SceneColorBuffer.GetWidth() + 1) / 2, (g_SceneColorBuffer.GetHeight() + 1) / 2,
+		DXGI_FORMAT_R16G16B16A16_FLOAT };
+	return Graph.CreateTexture(L"Motion Blur Prep", Desc);
 }
 
 // Linear Z ends up being faster since we haven't officially decompressed the depth buffer.  You 
@@ -141,45 +155,80 @@ void MotionBlur::RenderCameraBlur( CommandContext& BaseContext, const Matrix4& r
 	params.MaxTemporalBlend = TemporalMaxLerp;
 
 	Context.SetDynamicConstantBufferView(1, sizeof(PrePassCB), &params);
-	Context.TransitionResource(g_VelocityBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-	if (UseLinearZ)
-		Context.TransitionResource(g_LinearDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	else
-		Context.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
 	if (Enable)
 	{
-		Context.TransitionResource(g_MotionPrepBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-		Context.SetPipelineState(s_CameraMotionBlurPrePassCS[UseLinearZ ? 1 : 0]);
-		Context.SetDynamicDescriptor(3, 0, g_SceneColorBuffer.GetSRV());
-		Context.SetDynamicDescriptor(3, 1, UseLinearZ ? g_LinearDepth.GetSRV() : g_SceneDepthBuffer.GetDepthSRV());
-		Context.SetDynamicDescriptor(2, 0, g_MotionPrepBuffer.GetUAV());
-		Context.SetDynamicDescriptor(2, 1, g_VelocityBuffer.GetUAV());
-		Context.SetDynamicDescriptor(2, 2, g_ReprojectionBuffer.GetUAV());
-		Context.Dispatch2D(g_MotionPrepBuffer.GetWidth(), g_MotionPrepBuffer.GetHeight());
-
-		Context.SetConstants(0, 1.0f / Width, 1.0f / Height, (int32_t)MaxSampleCount, (float)StepSize );
-
-		Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		Context.TransitionResource(g_VelocityBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		Context.TransitionResource(g_MotionPrepBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetUAV());
-		Context.SetDynamicDescriptor(3, 0, g_SceneColorBuffer.GetSRV());
-		Context.SetDynamicDescriptor(3, 1, g_VelocityBuffer.GetSRV());
-		Context.SetDynamicDescriptor(3, 2, g_MotionPrepBuffer.GetSRV());
-
-		Context.SetPipelineState(s_MotionBlurFinalPassCS[0]);
+		typedef FrameGraph::ResourceHandle ResourceHandle;
+
+		FrameGraph& Graph = s_MotionBlurGraph;
+		Graph.Reset();
+
+		ResourceHandle SceneColor = Graph.ImportColorBuffer(g_SceneColorBuffer);
+		ResourceHandle Depth = UseLinearZ ? Graph.ImportColorBuffer(g_LinearDepth) : Graph.ImportResource(g_SceneDepthBuffer);
+		ResourceHandle Velocity = Graph.ImportColorBuffer(g_VelocityBuffer);
+		ResourceHandle Reprojection = Graph.ImportColorBuffer(g_ReprojectionBuffer);
+		ResourceHandle MotionPrep = CreatePrepBuffer(Graph);
+
+		Graph.AddPass(L"Camera Blur Prep",
+			[=]( FrameGraph::PassBuilder& Builder )
+			{
+				Builder.Read(SceneColor);
+				Builder.Read(Depth);
+				Builder.Write(MotionPrep);
+				Builder.Write(Velocity);
+				Builder.Write(Reprojection);
+			},
+			[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+			{
+				ColorBuffer& PrepBuffer = Resources.GetColorBuffer(MotionPrep);
+
+				PassContext.SetPipelineState(s_CameraMotionBlurPrePassCS[UseLinearZ ? 1 : 0]);
+				PassContext.SetDynamicDescriptor(3, 0, g_SceneColorBuffer.GetSRV());
+				PassContext.SetDynamicDescriptor(3, 1, UseLinearZ ? g_LinearDepth.GetSRV() : g_SceneDepthBuffer.GetDepthSRV());
+				PassContext.SetDynamicDescriptor(2, 0, PrepBuffer.GetUAV());
+				PassContext.SetDynamicDescriptor(2, 1, g_VelocityBuffer.GetUAV());
+				PassContext.SetDynamicDescriptor(2, 2, g_ReprojectionBuffer.GetUAV());
+				PassContext.Dispatch2D(PrepBuffer.GetWidth(), PrepBuffer.GetHeight());
+			});
+
+		Graph.AddPass(L"Camera Blur",
+			[=]( FrameGraph::PassBuilder& Builder )
+			{
+				Builder.Read(Velocity);
+				Builder.Read(MotionPrep);
+				Builder.Read(SceneColor, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+				Builder.Write(SceneColor);
+			},
+			[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+			{
+				PassContext.SetConstants(0, 1.0f / Width, 1.0f / Height, (int32_t)MaxSampleCount, (float)StepSize );
+
+				PassContext.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetUAV());
+				PassContext.SetDynamicDescriptor(3, 0, g_SceneColorBuffer.GetSRV());
+				PassContext.SetDynamicDescriptor(3, 1, g_VelocityBuffer.GetSRV());
+				PassContext.SetDynamicDescriptor(3, 2, Resources.GetColorBuffer(MotionPrep).GetSRV());
+
+				PassContext.SetPipelineState(s_MotionBlurFinalPassCS[0]);
+				PassContext.Dispatch2D(Width, Height);
+			});
+
+		Graph.Compile();
+		Graph.Execute(Context);
 	}
 	else
 	{
+		Context.TransitionResource(g_VelocityBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+		if (UseLinearZ)
+			Context.TransitionResource(g_LinearDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		else
+			Context.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
 		Context.SetPipelineState(s_CameraVelocityCS[UseLinearZ ? 1 : 0]);
 		Context.SetDynamicDescriptor(3, 0, UseLinearZ ? g_LinearDepth.GetSRV() : g_SceneDepthBuffer.GetDepthSRV());
 		Context.SetDynamicDescriptor(2, 0, g_ReprojectionBuffer.GetUAV());
+		Context.Dispatch2D(Width, Height);
 	}
-	Context.Dispatch2D(Width, Height);
 }
 
 void MotionBlur::RenderObjectBlur( CommandContext& BaseContext, ColorBuffer& velocityBuffer )
@@ -193,30 +242,60 @@ void MotionBlur::RenderObjectBlur( CommandContext& BaseContext, ColorBuffer& vel
 
 	Context.SetRootSignature(s_RootSignature);
 
-	Context.TransitionResource(g_MotionPrepBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	Context.TransitionResource(velocityBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-	D3D12_CPU_DESCRIPTOR_HANDLE Pass1SRVs[] = { g_SceneColorBuffer.GetSRV(), velocityBuffer.GetSRV() };
-	Context.SetDynamicDescriptors(2, 0, 1, &g_MotionPrepBuffer.GetUAV());
-	Context.SetDynamicDescriptors(3, 0, 2, Pass1SRVs);
-
-	Context.SetPipelineState(s_MotionBlurPrePassCS);
-	Context.Dispatch2D(g_MotionPrepBuffer.GetWidth(), g_MotionPrepBuffer.GetHeight());
-
-	Context.SetConstants(0, 1.0f / g_SceneColorBuffer.GetWidth(), 1.0f / g_SceneColorBuffer.GetHeight(), (float)TemporalMaxLerp );
-
-	Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	Context.TransitionResource(velocityBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	Context.TransitionResource(g_MotionPrepBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-	D3D12_CPU_DESCRIPTOR_HANDLE Pass2UAVs[] = { g_SceneColorBuffer.GetUAV() };
-	D3D12_CPU_DESCRIPTOR_HANDLE Pass2SRVs[] = { g_SceneColorBuffer.GetSRV(), velocityBuffer.GetSRV(), g_MotionPrepBuffer.GetSRV() };
-
-	Context.SetDynamicDescriptors(2, 0, 1, Pass2UAVs);
-	Context.SetDynamicDescriptors(3, 0, 3, Pass2SRVs);
-	Context.SetPipelineState(s_MotionBlurFinalPassCS[0]);
-	Context.Dispatch2D(g_SceneColorBuffer.GetWidth(), g_SceneColorBuffer.GetHeight());
+	typedef FrameGraph::ResourceHandle ResourceHandle;
+
+	FrameGraph& Graph = s_MotionBlurGraph;
+	Graph.Reset();
+
+	ColorBuffer* pVelocityBuffer = &velocityBuffer;
+
+	ResourceHandle SceneColor = Graph.ImportColorBuffer(g_SceneColorBuffer);
+	ResourceHandle Velocity = Graph.ImportColorBuffer(velocityBuffer);
+	ResourceHandle MotionPrep = CreatePrepBuffer(Graph);
+
+	Graph.AddPass(L"Object Blur Prep",
+		[=]( FrameGraph::PassBuilder& Builder )
+		{
+			Builder.Read(SceneColor);
+			Builder.Read(Velocity);
+			Builder.Write(MotionPrep);
+		},
+		[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+		{
+			ColorBuffer& PrepBuffer = Resources.GetColorBuffer(MotionPrep);
+
+			D3D12_CPU_DESCRIPTOR_HANDLE Pass1SRVs[] = { g_SceneColorBuffer.GetSRV(), pVelocityBuffer->GetSRV() };
+			PassContext.SetDynamicDescriptors(2, 0, 1, &PrepBuffer.GetUAV());
+			PassContext.SetDynamicDescriptors(3, 0, 2, Pass1SRVs);
+
+			PassContext.SetPipelineState(s_MotionBlurPrePassCS);
+			PassContext.Dispatch2D(PrepBuffer.GetWidth(), PrepBuffer.GetHeight());
+		});
+
+	Graph.AddPass(L"Object Blur",
+		[=]( FrameGraph::PassBuilder& Builder )
+		{
+			Builder.Read(Velocity);
+			Builder.Read(MotionPrep);
+			Builder.Read(SceneColor, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			Builder.Write(SceneColor);
+		},
+		[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+		{
+			PassContext.SetConstants(0, 1.0f / g_SceneColorBuffer.GetWidth(), 1.0f / g_SceneColorBuffer.GetHeight(), (float)TemporalMaxLerp );
+
+			D3D12_CPU_DESCRIPTOR_HANDLE Pass2UAVs[] = { g_SceneColorBuffer.GetUAV() };
+			D3D12_CPU_DESCRIPTOR_HANDLE Pass2SRVs[] = { g_SceneColorBuffer.GetSRV(), pVelocityBuffer->GetSRV(),
+				Resources.GetColorBuffer(MotionPrep).GetSRV() };
+
+			PassContext.SetDynamicDescriptors(2, 0, 1, Pass2UAVs);
+			PassContext.SetDynamicDescriptors(3, 0, 3, Pass2SRVs);
+			PassContext.SetPipelineState(s_MotionBlurFinalPassCS[0]);
+			PassContext.Dispatch2D(g_SceneColorBuffer.GetWidth(), g_SceneColorBuffer.GetHeight());
+		});
+
+	Graph.Compile();
+	Graph.Execute(Context);
 }
 
 void TemporalAA::ApplyTemporalAA(CommandContext& BaseContext)
@@ -0,0 +1,1273 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "NullDevice.h"
+#include "DDSTextureLoader.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <type_traits>
+#include <algorithm>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const uint64_t kPageSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	const uint64_t kMSAAPageSize = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+	const UINT kDescriptorSize = 32;
+
+	std::atomic<uint32_t> s_SimulatedLatency(0);
+
+	inline uint64_t AlignUp( uint64_t Value, uint64_t Alignment )
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	bool IsCpuVisible( const D3D12_HEAP_PROPERTIES& Properties )
+	{
+		switch (Properties.Type)
+		{
+		case D3D12_HEAP_TYPE_UPLOAD:
+		case D3D12_HEAP_TYPE_READBACK:
+			return true;
+		case D3D12_HEAP_TYPE_CUSTOM:
+			return Properties.CPUPageProperty != D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE;
+		default:
+			return false;
+		}
+	}
+
+	bool IsBlockCompressed( DXGI_FORMAT Format )
+	{
+		return (Format >= DXGI_FORMAT_BC1_TYPELESS && Format <= DXGI_FORMAT_BC5_SNORM) ||
+			(Format >= DXGI_FORMAT_BC6H_TYPELESS && Format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	}
+
+	bool IsDepthStencil( DXGI_FORMAT Format )
+	{
+		switch (Format)
+		{
+		case DXGI_FORMAT_R32G8X24_TYPELESS:
+		case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+		case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+		case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+		case DXGI_FORMAT_R24G8_TYPELESS:
+		case DXGI_FORMAT_D24_UNORM_S8_UINT:
+		case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+		case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	UINT GetMipLevels( const D3D12_RESOURCE_DESC& Desc )
+	{
+		if (Desc.MipLevels != 0)
+			return Desc.MipLevels;
+
+		uint64_t Largest = std::max<uint64_t>(Desc.Width, Desc.Height);
+		if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+			Largest = std::max<uint64_t>(Largest, Desc.DepthOrArraySize);
+
+		UINT Levels = 1;
+		while (Largest > 1)
+		{
+			Largest >>= 1;
+			++Levels;
+		}
+		return Levels;
+	}
+
+	UINT GetSubresourceCount( const D3D12_RESOURCE_DESC& Desc )
+	{
+		if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			return 1;
+		if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+			return GetMipLevels(Desc);
+		return GetMipLevels(Desc) * Desc.DepthOrArraySize;
+	}
+
+	// Follows the layout rules of real drivers:  rows are 256-byte aligned and subresources 512-byte aligned
+	void ComputeCopyableFootprints( const D3D12_RESOURCE_DESC& Desc, UINT FirstSubresource, UINT NumSubresources,
+		UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes,
+		UINT64* pTotalBytes )
+	{
+		if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			ASSERT(FirstSubresource == 0 && NumSubresources == 1);
+
+			if (pLayouts != nullptr)
+			{
+				pLayouts[0].Offset = BaseOffset;
+				pLayouts[0].Footprint.Format = DXGI_FORMAT_UNKNOWN;
+				pLayouts[0].Footprint.Width = (UINT)Desc.Width;
+				pLayouts[0].Footprint.Height = 1;
+				pLayouts[0].Footprint.Depth = 1;
+				pLayouts[0].Footprint.RowPitch = (UINT)AlignUp(Desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+			}
+			if (pNumRows != nullptr)
+				pNumRows[0] = 1;
+			if (pRowSizeInBytes != nullptr)
+				pRowSizeInBytes[0] = Desc.Width;
+			if (pTotalBytes != nullptr)
+				*pTotalBytes = Desc.Width;
+			return;
+		}
+
+		const UINT MipLevels = GetMipLevels(Desc);
+		const bool IsVolume = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+		const bool IsCompressed = IsBlockCompressed(Desc.Format);
+		const uint64_t BitsPerElement = std::max<uint64_t>(BitsPerPixel(Desc.Format), 8) * (IsCompressed ? 16 : 1);
+
+		uint64_t Offset = BaseOffset;
+		uint64_t TotalBytes = 0;
+
+		for (UINT i = 0; i < NumSubresources; ++i)
+		{
+			UINT MipLevel = (FirstSubresource + i) % MipLevels;
+
+			UINT Width = std::max<UINT>(1, (UINT)(Desc.Width >> MipLevel));
+			UINT Height = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE1D ? 1 : std::max<UINT>(1, Desc.Height >> MipLevel);
+			UINT Depth = IsVolume ? std::max<UINT>(1, Desc.DepthOrArraySize >> MipLevel) : 1;
+
+			UINT NumRows = IsCompressed ? (Height + 3) / 4 : Height;
+			uint64_t RowSize = (IsCompressed ? (Width + 3) / 4 : Width) * BitsPerElement / 8;
+			UINT RowPitch = (UINT)AlignUp(RowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+
+			Offset = AlignUp(Offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+			if (pLayouts != nullptr)
+			{
+				pLayouts[i].Offset = Offset;
+				pLayouts[i].Footprint.Format = Desc.Format;
+				pLayouts[i].Footprint.Width = IsCompressed ? (UINT)AlignUp(Width, 4) : Width;
+				pLayouts[i].Footprint.Height = IsCompressed ? (UINT)AlignUp(Height, 4) : Height;
+				pLayouts[i].Footprint.Depth = Depth;
+				pLayouts[i].Footprint.RowPitch = RowPitch;
+			}
+			if (pNumRows != nullptr)
+				pNumRows[i] = NumRows;
+			if (pRowSizeInBytes != nullptr)
+				pRowSizeInBytes[i] = RowSize;
+
+			TotalBytes = Offset + (uint64_t)RowPitch * (NumRows * Depth - 1) + RowSize - BaseOffset;
+			Offset += (uint64_t)RowPitch * NumRows * Depth;
+		}
+
+		if (pTotalBytes != nullptr)
+			*pTotalBytes = TotalBytes;
+	}
+
+	uint64_t GetResourceSize( const D3D12_RESOURCE_DESC& Desc )
+	{
+		uint64_t TotalBytes;
+		ComputeCopyableFootprints(Desc, 0, GetSubresourceCount(Desc), 0, nullptr, nullptr, nullptr, &TotalBytes);
+		return TotalBytes;
+	}
+
+	// Host memory standing in for video memory.  It is page aligned so that offsets keep the alignment
+	// they would have on a GPU.
+	struct AlignedFree
+	{
+		void operator()( uint8_t* Memory ) const { _aligned_free(Memory); }
+	};
+	typedef std::unique_ptr<uint8_t[], AlignedFree> HostMemory;
+
+	HostMemory AllocateHostMemory( uint64_t Size )
+	{
+		uint8_t* Memory = (uint8_t*)_aligned_malloc((size_t)Size, (size_t)kPageSize);
+		ASSERT(Memory != nullptr, "Out of host memory for a null device allocation");
+		std::memset(Memory, 0, (size_t)Size);
+		return HostMemory(Memory);
+	}
+
+	template <typename T>
+	HRESULT ReturnObject( T* Object, REFIID riid, void** ppvObject )
+	{
+		HRESULT hr = ppvObject != nullptr ? Object->QueryInterface(riid, ppvObject) : S_FALSE;
+		Object->Release();
+		return hr;
+	}
+
+	struct GuidLess
+	{
+		bool operator()( const GUID& A, const GUID& B ) const { return std::memcmp(&A, &B, sizeof(GUID)) < 0; }
+	};
+
+	// Reference counting and private data shared by every null object
+	template <typename Interface>
+	class NullObject : public Interface
+	{
+	public:
+		NullObject() : m_RefCount(1) {}
+		virtual ~NullObject() {}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface( REFIID riid, void** ppvObject ) override
+		{
+			if (ppvObject == nullptr)
+				return E_POINTER;
+
+			if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D12Object) || IsInterface(riid))
+			{
+				*ppvObject = static_cast<Interface*>(this);
+				AddRef();
+				return S_OK;
+			}
+
+			*ppvObject = nullptr;
+			return E_NOINTERFACE;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef( void ) override
+		{
+			return ++m_RefCount;
+		}
+
+		ULONG STDMETHODCALLTYPE Release( void ) override
+		{
+			ULONG RefCount = --m_RefCount;
+			if (RefCount == 0)
+				delete this;
+			return RefCount;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetPrivateData( REFGUID guid, UINT* pDataSize, void* pData ) override
+		{
+			if (pDataSize == nullptr)
+				return E_INVALIDARG;
+
+			std::lock_guard<std::mutex> LockGuard(m_PrivateDataMutex);
+
+			auto Iter = m_PrivateData.find(guid);
+			if (Iter == m_PrivateData.end())
+			{
+				*pDataSize = 0;
+				return DXGI_ERROR_NOT_FOUND;
+			}
+
+			UINT DataSize = (UINT)Iter->second.size();
+			if (pData != nullptr)
+			{
+				if (*pDataSize < DataSize)
+				{
+					*pDataSize = DataSize;
+					return DXGI_ERROR_MORE_DATA;
+				}
+				std::memcpy(pData, Iter->second.data(), DataSize);
+
+				auto Interface = m_PrivateInterfaces.find(guid);
+				if (Interface != m_PrivateInterfaces.end())
+					Interface->second->AddRef();
+			}
+			*pDataSize = DataSize;
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE SetPrivateData( REFGUID guid, UINT DataSize, const void* pData ) override
+		{
+			std::lock_guard<std::mutex> LockGuard(m_PrivateDataMutex);
+
+			m_PrivateInterfaces.erase(guid);
+			if (pData == nullptr)
+				m_PrivateData.erase(guid);
+			else
+				m_PrivateData[guid].assign((const uint8_t*)pData, (const uint8_t*)pData + DataSize);
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE SetPrivateDataInterface( REFGUID guid, const IUnknown* pData ) override
+		{
+			IUnknown* pInterface = const_cast<IUnknown*>(pData);
+			SetPrivateData(guid, pInterface != nullptr ? sizeof(pInterface) : 0, pInterface != nullptr ? &pInterface : nullptr);
+
+			if (pInterface != nullptr)
+			{
+				std::lock_guard<std::mutex> LockGuard(m_PrivateDataMutex);
+				m_PrivateInterfaces[guid] = pInterface;
+			}
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE SetName( LPCWSTR Name ) override
+		{
+			std::lock_guard<std::mutex> LockGuard(m_PrivateDataMutex);
+			m_Name = Name != nullptr ? Name : L"";
+			return S_OK;
+		}
+
+	protected:
+		virtual bool IsInterface( REFIID riid ) const
+		{
+			return riid == __uuidof(Interface);
+		}
+
+	private:
+		std::atomic<ULONG> m_RefCount;
+		std::mutex m_PrivateDataMutex;
+		std::map<GUID, std::vector<uint8_t>, GuidLess> m_PrivateData;
+		std::map<GUID, Microsoft::WRL::ComPtr<IUnknown>, GuidLess> m_PrivateInterfaces;
+		std::wstring m_Name;
+	};
+
+	class NullD3D12Device;
+
+	// Keeps its device alive, like real device children do
+	template <typename Interface>
+	class NullDeviceChild : public NullObject<Interface>
+	{
+	public:
+		NullDeviceChild( ID3D12Device* Device ) : m_Device(Device)
+		{
+			m_Device->AddRef();
+		}
+
+		~NullDeviceChild()
+		{
+			m_Device->Release();
+		}
+
+		HRESULT STDMETHODCALLTYPE GetDevice( REFIID riid, void** ppvDevice ) override
+		{
+			return m_Device->QueryInterface(riid, ppvDevice);
+		}
+
+	protected:
+		bool IsInterface( REFIID riid ) const override
+		{
+			return riid == __uuidof(Interface) || riid == __uuidof(ID3D12DeviceChild) ||
+				(std::is_base_of<ID3D12Pageable, Interface>::value && riid == __uuidof(ID3D12Pageable)) ||
+				(std::is_base_of<ID3D12CommandList, Interface>::value && riid == __uuidof(ID3D12CommandList));
+		}
+
+		ID3D12Device* m_Device;
+	};
+
+	class NullCommandQueue;
+	class NullFence;
+
+	class NullD3D12Device : public NullObject<ID3D12Device>
+	{
+	public:
+		NullD3D12Device();
+		~NullD3D12Device();
+
+		UINT STDMETHODCALLTYPE GetNodeCount( void ) override { return 1; }
+
+		HRESULT STDMETHODCALLTYPE CreateCommandQueue( const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue ) override;
+		HRESULT STDMETHODCALLTYPE CreateCommandAllocator( D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator ) override;
+		HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState( const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState ) override;
+		HRESULT STDMETHODCALLTYPE CreateComputePipelineState( const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState ) override;
+		HRESULT STDMETHODCALLTYPE CreateCommandList( UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* pCommandAllocator,
+			ID3D12PipelineState* pInitialState, REFIID riid, void** ppCommandList ) override;
+		HRESULT STDMETHODCALLTYPE CheckFeatureSupport( D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize ) override;
+		HRESULT STDMETHODCALLTYPE CreateDescriptorHeap( const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap ) override;
+		UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE ) override { return kDescriptorSize; }
+		HRESULT STDMETHODCALLTYPE CreateRootSignature( UINT nodeMask, const void* pBlobWithRootSignature, SIZE_T blobLengthInBytes,
+			REFIID riid, void** ppvRootSignature ) override;
+
+		// Descriptors have no contents, so creating and copying them does nothing
+		void STDMETHODCALLTYPE CreateConstantBufferView( const D3D12_CONSTANT_BUFFER_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE CreateShaderResourceView( ID3D12Resource*, const D3D12_SHADER_RESOURCE_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE CreateUnorderedAccessView( ID3D12Resource*, ID3D12Resource*, const D3D12_UNORDERED_ACCESS_VIEW_DESC*,
+			D3D12_CPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE CreateRenderTargetView( ID3D12Resource*, const D3D12_RENDER_TARGET_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE CreateDepthStencilView( ID3D12Resource*, const D3D12_DEPTH_STENCIL_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE CreateSampler( const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE CopyDescriptors( UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT*, UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*,
+			const UINT*, D3D12_DESCRIPTOR_HEAP_TYPE ) override {}
+		void STDMETHODCALLTYPE CopyDescriptorsSimple( UINT, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_DESCRIPTOR_HEAP_TYPE ) override {}
+
+		D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo( UINT visibleMask, UINT numResourceDescs,
+			const D3D12_RESOURCE_DESC* pResourceDescs ) override;
+		D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties( UINT nodeMask, D3D12_HEAP_TYPE heapType ) override;
+		HRESULT STDMETHODCALLTYPE CreateCommittedResource( const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags,
+			const D3D12_RESOURCE_DESC* pResourceDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+			REFIID riidResource, void** ppvResource ) override;
+		HRESULT STDMETHODCALLTYPE CreateHeap( const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap ) override;
+		HRESULT STDMETHODCALLTYPE CreatePlacedResource( ID3D12Heap* pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC* pDesc,
+			D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource ) override;
+		HRESULT STDMETHODCALLTYPE CreateReservedResource( const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialState,
+			const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource ) override;
+
+		HRESULT STDMETHODCALLTYPE CreateSharedHandle( ID3D12DeviceChild*, const SECURITY_ATTRIBUTES*, DWORD, LPCWSTR, HANDLE* ) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE OpenSharedHandle( HANDLE, REFIID, void** ) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE OpenSharedHandleByName( LPCWSTR, DWORD, HANDLE* ) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE MakeResident( UINT, ID3D12Pageable* const* ) override { return S_OK; }
+		HRESULT STDMETHODCALLTYPE Evict( UINT, ID3D12Pageable* const* ) override { return S_OK; }
+
+		HRESULT STDMETHODCALLTYPE CreateFence( UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void** ppFence ) override;
+		HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason( void ) override { return S_OK; }
+
+		void STDMETHODCALLTYPE GetCopyableFootprints( const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource, UINT NumSubresources,
+			UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes, UINT64* pTotalBytes ) override
+		{
+			ComputeCopyableFootprints(*pResourceDesc, FirstSubresource, NumSubresources, BaseOffset, pLayouts, pNumRows, pRowSizeInBytes, pTotalBytes);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateQueryHeap( const D3D12_QUERY_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap ) override;
+		HRESULT STDMETHODCALLTYPE SetStablePowerState( BOOL ) override { return S_OK; }
+		HRESULT STDMETHODCALLTYPE CreateCommandSignature( const D3D12_COMMAND_SIGNATURE_DESC* pDesc, ID3D12RootSignature* pRootSignature,
+			REFIID riid, void** ppvCommandSignature ) override;
+
+		void STDMETHODCALLTYPE GetResourceTiling( ID3D12Resource*, UINT* pNumTilesForEntireResource, D3D12_PACKED_MIP_INFO* pPackedMipDesc,
+			D3D12_TILE_SHAPE* pStandardTileShapeForNonPackedMips, UINT* pNumSubresourceTilings, UINT, D3D12_SUBRESOURCE_TILING* ) override
+		{
+			if (pNumTilesForEntireResource != nullptr)
+				*pNumTilesForEntireResource = 0;
+			if (pPackedMipDesc != nullptr)
+				std::memset(pPackedMipDesc, 0, sizeof(*pPackedMipDesc));
+			if (pStandardTileShapeForNonPackedMips != nullptr)
+				std::memset(pStandardTileShapeForNonPackedMips, 0, sizeof(*pStandardTileShapeForNonPackedMips));
+			if (pNumSubresourceTilings != nullptr)
+				*pNumSubresourceTilings = 0;
+		}
+
+		LUID STDMETHODCALLTYPE GetAdapterLuid( void ) override
+		{
+			LUID Luid = {};
+			return Luid;
+		}
+
+		// Fake addresses for memory which has no host allocation behind it
+		D3D12_GPU_VIRTUAL_ADDRESS AllocateGpuAddressRange( uint64_t Size );
+		SIZE_T AllocateDescriptorRange( uint64_t Size );
+
+		// Queue operations complete on the timeline thread, or during the call which makes them possible
+		void RegisterQueue( NullCommandQueue* Queue );
+		void UnregisterQueue( NullCommandQueue* Queue );
+		void AdvanceTimeline( void );
+		std::mutex& GetTimelineMutex( void ) { return m_TimelineMutex; }
+
+	private:
+		Clock::time_point RetireQueueOperations( void );
+		void TimelineThread( void );
+
+		std::atomic<uint64_t> m_NextGpuAddress;
+		std::atomic<uint64_t> m_NextDescriptorAddress;
+
+		std::mutex m_TimelineMutex;
+		std::condition_variable m_TimelineCondition;
+		std::vector<NullCommandQueue*> m_Queues;
+		std::thread m_TimelineThread;
+		bool m_Quit;
+	};
+
+	class NullHeap : public NullDeviceChild<ID3D12Heap>
+	{
+	public:
+		NullHeap( NullD3D12Device* Device, const D3D12_HEAP_DESC& Desc ) : NullDeviceChild(Device), m_Desc(Desc)
+		{
+			if (IsCpuVisible(Desc.Properties))
+			{
+				m_Memory = AllocateHostMemory(Desc.SizeInBytes);
+				m_GpuAddress = (D3D12_GPU_VIRTUAL_ADDRESS)m_Memory.get();
+			}
+			else
+			{
+				m_GpuAddress = Device->AllocateGpuAddressRange(Desc.SizeInBytes);
+			}
+		}
+
+		D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+
+		uint8_t* GetCpuAddress( void ) const { return m_Memory.get(); }
+		D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress( void ) const { return m_GpuAddress; }
+
+	private:
+		D3D12_HEAP_DESC m_Desc;
+		HostMemory m_Memory;
+		D3D12_GPU_VIRTUAL_ADDRESS m_GpuAddress;
+	};
+
+	class NullResource : public NullDeviceChild<ID3D12Resource>
+	{
+	public:
+		// Committed when Heap is null.  Reserved resources have no heap properties.
+		NullResource( NullD3D12Device* Device, const D3D12_RESOURCE_DESC& Desc, const D3D12_HEAP_PROPERTIES* pHeapProperties,
+			D3D12_HEAP_FLAGS HeapFlags, NullHeap* Heap, uint64_t HeapOffset ) :
+			NullDeviceChild(Device), m_Desc(Desc), m_HeapFlags(HeapFlags), m_Heap(Heap),
+			m_CpuAddress(nullptr), m_GpuAddress(0), m_IsReserved(pHeapProperties == nullptr && Heap == nullptr)
+		{
+			std::memset(&m_HeapProperties, 0, sizeof(m_HeapProperties));
+
+			if (Heap != nullptr)
+			{
+				D3D12_HEAP_DESC HeapDesc = Heap->GetDesc();
+				ASSERT(HeapOffset + GetResourceSize(Desc) <= HeapDesc.SizeInBytes, "Placed resource does not fit in its heap");
+				m_HeapProperties = HeapDesc.Properties;
+				m_HeapFlags = HeapDesc.Flags;
+
+				if (Heap->GetCpuAddress() != nullptr)
+					m_CpuAddress = Heap->GetCpuAddress() + HeapOffset;
+				m_GpuAddress = Heap->GetGpuAddress() + HeapOffset;
+			}
+			else if (pHeapProperties != nullptr)
+			{
+				m_HeapProperties = *pHeapProperties;
+
+				if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+				{
+					if (IsCpuVisible(m_HeapProperties))
+					{
+						m_Memory = AllocateHostMemory(Desc.Width);
+						m_CpuAddress = m_Memory.get();
+						m_GpuAddress = (D3D12_GPU_VIRTUAL_ADDRESS)m_CpuAddress;
+					}
+					else
+					{
+						m_GpuAddress = Device->AllocateGpuAddressRange(Desc.Width);
+					}
+				}
+			}
+		}
+
+		HRESULT STDMETHODCALLTYPE Map( UINT, const D3D12_RANGE*, void** ppData ) override
+		{
+			if (m_CpuAddress == nullptr)
+				return E_INVALIDARG;
+			if (ppData != nullptr)
+				*ppData = m_CpuAddress;
+			return S_OK;
+		}
+
+		void STDMETHODCALLTYPE Unmap( UINT, const D3D12_RANGE* ) override {}
+
+		D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+
+		D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress( void ) override
+		{
+			return m_Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? m_GpuAddress : 0;
+		}
+
+		HRESULT STDMETHODCALLTYPE WriteToSubresource( UINT, const D3D12_BOX*, const void*, UINT, UINT ) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE ReadFromSubresource( void*, UINT, UINT, UINT, const D3D12_BOX* ) override { return E_NOTIMPL; }
+
+		HRESULT STDMETHODCALLTYPE GetHeapProperties( D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags ) override
+		{
+			if (m_IsReserved)
+				return E_INVALIDARG;
+			if (pHeapProperties != nullptr)
+				*pHeapProperties = m_HeapProperties;
+			if (pHeapFlags != nullptr)
+				*pHeapFlags = m_HeapFlags;
+			return S_OK;
+		}
+
+		uint8_t* GetCpuAddress( void ) const { return m_CpuAddress; }
+
+	private:
+		D3D12_RESOURCE_DESC m_Desc;
+		D3D12_HEAP_PROPERTIES m_HeapProperties;
+		D3D12_HEAP_FLAGS m_HeapFlags;
+		Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap;
+		HostMemory m_Memory;
+		uint8_t* m_CpuAddress;
+		D3D12_GPU_VIRTUAL_ADDRESS m_GpuAddress;
+		bool m_IsReserved;
+	};
+
+	class NullFence : public NullDeviceChild<ID3D12Fence>
+	{
+	public:
+		NullFence( NullD3D12Device* Device, UINT64 InitialValue ) :
+			NullDeviceChild(Device), m_NullDevice(Device), m_CompletedValue(InitialValue)
+		{
+		}
+
+		UINT64 STDMETHODCALLTYPE GetCompletedValue( void ) override
+		{
+			return m_CompletedValue.load(std::memory_order_acquire);
+		}
+
+		HRESULT STDMETHODCALLTYPE SetEventOnCompletion( UINT64 Value, HANDLE hEvent ) override
+		{
+			std::unique_lock<std::mutex> Lock(m_EventMutex);
+
+			if (hEvent == nullptr)
+			{
+				// No event means block until the value is reached
+				m_CompletionCondition.wait(Lock, [this, Value] { return GetCompletedValue() >= Value; });
+			}
+			else if (GetCompletedValue() >= Value)
+			{
+				SetEvent(hEvent);
+			}
+			else
+			{
+				m_PendingEvents.push_back(std::make_pair(Value, hEvent));
+			}
+			return S_OK;
+		}
+
+		// Signal from the CPU
+		HRESULT STDMETHODCALLTYPE Signal( UINT64 Value ) override
+		{
+			Complete(Value);
+
+			// Queues may be waiting for this value
+			m_NullDevice->AdvanceTimeline();
+			return S_OK;
+		}
+
+		void Complete( UINT64 Value )
+		{
+			std::lock_guard<std::mutex> LockGuard(m_EventMutex);
+
+			m_CompletedValue.store(Value, std::memory_order_release);
+
+			auto Reached = std::partition(m_PendingEvents.begin(), m_PendingEvents.end(),
+				[Value]( const std::pair<UINT64, HANDLE>& Event ) { return Event.first > Value; });
+			for (auto Iter = Reached; Iter != m_PendingEvents.end(); ++Iter)
+				SetEvent(Iter->second);
+			m_PendingEvents.erase(Reached, m_PendingEvents.end());
+
+			m_CompletionCondition.notify_all();
+		}
+
+	private:
+		NullD3D12Device* m_NullDevice;
+		std::atomic<UINT64> m_CompletedValue;
+		std::mutex m_EventMutex;
+		std::condition_variable m_CompletionCondition;
+		std::vector<std::pair<UINT64, HANDLE>> m_PendingEvents;
+	};
+
+	class NullQueryHeap : public NullDeviceChild<ID3D12QueryHeap>
+	{
+	public:
+		NullQueryHeap( NullD3D12Device* Device, const D3D12_QUERY_HEAP_DESC& Desc ) :
+			NullDeviceChild(Device), m_Results(Desc.Count, 0)
+		{
+		}
+
+		// Queries are answered when they are recorded, since command lists are never replayed
+		void EndQuery( D3D12_QUERY_TYPE Type, UINT Index )
+		{
+			if (Type == D3D12_QUERY_TYPE_TIMESTAMP)
+			{
+				LARGE_INTEGER Ticks;
+				QueryPerformanceCounter(&Ticks);
+				m_Results[Index] = (UINT64)Ticks.QuadPart;
+			}
+		}
+
+		void Resolve( D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries, uint8_t* pDestination )
+		{
+			if (pDestination != nullptr && Type == D3D12_QUERY_TYPE_TIMESTAMP)
+				std::memcpy(pDestination, &m_Results[StartIndex], NumQueries * sizeof(UINT64));
+		}
+
+	private:
+		std::vector<UINT64> m_Results;
+	};
+
+	class NullDescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap>
+	{
+	public:
+		NullDescriptorHeap( NullD3D12Device* Device, const D3D12_DESCRIPTOR_HEAP_DESC& Desc ) : NullDeviceChild(Device), m_Desc(Desc)
+		{
+			uint64_t Size = (uint64_t)Desc.NumDescriptors * kDescriptorSize;
+			m_CpuStart.ptr = Device->AllocateDescriptorRange(Size);
+			m_GpuStart.ptr = (Desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) ? Device->AllocateGpuAddressRange(Size) : 0;
+		}
+
+		D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+		D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart( void ) override { return m_CpuStart; }
+		D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart( void ) override { return m_GpuStart; }
+
+	private:
+		D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+		D3D12_CPU_DESCRIPTOR_HANDLE m_CpuStart;
+		D3D12_GPU_DESCRIPTOR_HANDLE m_GpuStart;
+	};
+
+	class NullPipelineState : public NullDeviceChild<ID3D12PipelineState>
+	{
+	public:
+		NullPipelineState( NullD3D12Device* Device ) : NullDeviceChild(Device) {}
+
+		HRESULT STDMETHODCALLTYPE GetCachedBlob( ID3DBlob** ) override { return E_NOTIMPL; }
+	};
+
+	class NullRootSignature : public NullDeviceChild<ID3D12RootSignature>
+	{
+	public:
+		NullRootSignature( NullD3D12Device* Device ) : NullDeviceChild(Device) {}
+	};
+
+	class NullCommandSignature : public NullDeviceChild<ID3D12CommandSignature>
+	{
+	public:
+		NullCommandSignature( NullD3D12Device* Device ) : NullDeviceChild(Device) {}
+	};
+
+	class NullCommandAllocator : public NullDeviceChild<ID3D12CommandAllocator>
+	{
+	public:
+		NullCommandAllocator( NullD3D12Device* Device ) : NullDeviceChild(Device) {}
+
+		HRESULT STDMETHODCALLTYPE Reset( void ) override { return S_OK; }
+	};
+
+	// Records nothing.  Only the open or closed state is tracked, to catch misuse.
+	class NullCommandList : public NullDeviceChild<ID3D12GraphicsCommandList>
+	{
+	public:
+		NullCommandList( NullD3D12Device* Device, D3D12_COMMAND_LIST_TYPE Type ) :
+			NullDeviceChild(Device), m_Type(Type), m_IsOpen(true)
+		{
+		}
+
+		D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType( void ) override { return m_Type; }
+
+		HRESULT STDMETHODCALLTYPE Close( void ) override
+		{
+			if (!m_IsOpen)
+				return E_FAIL;
+			m_IsOpen = false;
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE Reset( ID3D12CommandAllocator*, ID3D12PipelineState* ) override
+		{
+			if (m_IsOpen)
+				return E_FAIL;
+			m_IsOpen = true;
+			return S_OK;
+		}
+
+		bool IsOpen( void ) const { return m_IsOpen; }
+
+		void STDMETHODCALLTYPE ClearState( ID3D12PipelineState* ) override {}
+		void STDMETHODCALLTYPE DrawInstanced( UINT, UINT, UINT, UINT ) override {}
+		void STDMETHODCALLTYPE DrawIndexedInstanced( UINT, UINT, UINT, INT, UINT ) override {}
+		void STDMETHODCALLTYPE Dispatch( UINT, UINT, UINT ) override {}
+		void STDMETHODCALLTYPE CopyBufferRegion( ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT64 ) override {}
+		void STDMETHODCALLTYPE CopyTextureRegion( const D3D12_TEXTURE_COPY_LOCATION*, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION*,
+			const D3D12_BOX* ) override {}
+		void STDMETHODCALLTYPE CopyResource( ID3D12Resource*, ID3D12Resource* ) override {}
+		void STDMETHODCALLTYPE CopyTiles( ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*,
+			ID3D12Resource*, UINT64, D3D12_TILE_COPY_FLAGS ) override {}
+		void STDMETHODCALLTYPE ResolveSubresource( ID3D12Resource*, UINT, ID3D12Resource*, UINT, DXGI_FORMAT ) override {}
+		void STDMETHODCALLTYPE IASetPrimitiveTopology( D3D12_PRIMITIVE_TOPOLOGY ) override {}
+		void STDMETHODCALLTYPE RSSetViewports( UINT, const D3D12_VIEWPORT* ) override {}
+		void STDMETHODCALLTYPE RSSetScissorRects( UINT, const D3D12_RECT* ) override {}
+		void STDMETHODCALLTYPE OMSetBlendFactor( const FLOAT[4] ) override {}
+		void STDMETHODCALLTYPE OMSetStencilRef( UINT ) override {}
+		void STDMETHODCALLTYPE SetPipelineState( ID3D12PipelineState* ) override {}
+		void STDMETHODCALLTYPE ResourceBarrier( UINT, const D3D12_RESOURCE_BARRIER* ) override {}
+		void STDMETHODCALLTYPE ExecuteBundle( ID3D12GraphicsCommandList* ) override {}
+		void STDMETHODCALLTYPE SetDescriptorHeaps( UINT, ID3D12DescriptorHeap* const* ) override {}
+		void STDMETHODCALLTYPE SetComputeRootSignature( ID3D12RootSignature* ) override {}
+		void STDMETHODCALLTYPE SetGraphicsRootSignature( ID3D12RootSignature* ) override {}
+		void STDMETHODCALLTYPE SetComputeRootDescriptorTable( UINT, D3D12_GPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable( UINT, D3D12_GPU_DESCRIPTOR_HANDLE ) override {}
+		void STDMETHODCALLTYPE SetComputeRoot32BitConstant( UINT, UINT, UINT ) override {}
+		void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant( UINT, UINT, UINT ) override {}
+		void STDMETHODCALLTYPE SetComputeRoot32BitConstants( UINT, UINT, const void*, UINT ) override {}
+		void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants( UINT, UINT, const void*, UINT ) override {}
+		void STDMETHODCALLTYPE SetComputeRootConstantBufferView( UINT, D3D12_GPU_VIRTUAL_ADDRESS ) override {}
+		void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView( UINT, D3D12_GPU_VIRTUAL_ADDRESS ) override {}
+		void STDMETHODCALLTYPE SetComputeRootShaderResourceView( UINT, D3D12_GPU_VIRTUAL_ADDRESS ) override {}
+		void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView( UINT, D3D12_GPU_VIRTUAL_ADDRESS ) override {}
+		void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView( UINT, D3D12_GPU_VIRTUAL_ADDRESS ) override {}
+		void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView( UINT, D3D12_GPU_VIRTUAL_ADDRESS ) override {}
+		void STDMETHODCALLTYPE IASetIndexBuffer( const D3D12_INDEX_BUFFER_VIEW* ) override {}
+		void STDMETHODCALLTYPE IASetVertexBuffers( UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW* ) override {}
+		void STDMETHODCALLTYPE SOSetTargets( UINT, UINT, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* ) override {}
+		void STDMETHODCALLTYPE OMSetRenderTargets( UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL, const D3D12_CPU_DESCRIPTOR_HANDLE* ) override {}
+		void STDMETHODCALLTYPE ClearDepthStencilView( D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CLEAR_FLAGS, FLOAT, UINT8, UINT, const D3D12_RECT* ) override {}
+		void STDMETHODCALLTYPE ClearRenderTargetView( D3D12_CPU_DESCRIPTOR_HANDLE, const FLOAT[4], UINT, const D3D12_RECT* ) override {}
+		void STDMETHODCALLTYPE ClearUnorderedAccessViewUint( D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, ID3D12Resource*,
+			const UINT[4], UINT, const D3D12_RECT* ) override {}
+		void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat( D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, ID3D12Resource*,
+			const FLOAT[4], UINT, const D3D12_RECT* ) override {}
+		void STDMETHODCALLTYPE DiscardResource( ID3D12Resource*, const D3D12_DISCARD_REGION* ) override {}
+		void STDMETHODCALLTYPE BeginQuery( ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT ) override {}
+
+		void STDMETHODCALLTYPE EndQuery( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index ) override
+		{
+			static_cast<NullQueryHeap*>(pQueryHeap)->EndQuery(Type, Index);
+		}
+
+		void STDMETHODCALLTYPE ResolveQueryData( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries,
+			ID3D12Resource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset ) override
+		{
+			uint8_t* pDestination = static_cast<NullResource*>(pDestinationBuffer)->GetCpuAddress();
+			if (pDestination != nullptr)
+				static_cast<NullQueryHeap*>(pQueryHeap)->Resolve(Type, StartIndex, NumQueries, pDestination + AlignedDestinationBufferOffset);
+		}
+
+		void STDMETHODCALLTYPE SetPredication( ID3D12Resource*, UINT64, D3D12_PREDICATION_OP ) override {}
+		void STDMETHODCALLTYPE SetMarker( UINT, const void*, UINT ) override {}
+		void STDMETHODCALLTYPE BeginEvent( UINT, const void*, UINT ) override {}
+		void STDMETHODCALLTYPE EndEvent( void ) override {}
+		void STDMETHODCALLTYPE ExecuteIndirect( ID3D12CommandSignature*, UINT, ID3D12Resource*, UINT64, ID3D12Resource*, UINT64 ) override {}
+
+	private:
+		D3D12_COMMAND_LIST_TYPE m_Type;
+		bool m_IsOpen;
+	};
+
+	class NullCommandQueue : public NullDeviceChild<ID3D12CommandQueue>
+	{
+	public:
+		NullCommandQueue( NullD3D12Device* Device, const D3D12_COMMAND_QUEUE_DESC& Desc ) :
+			NullDeviceChild(Device), m_NullDevice(Device), m_Desc(Desc)
+		{
+			m_NullDevice->RegisterQueue(this);
+		}
+
+		~NullCommandQueue()
+		{
+			m_NullDevice->UnregisterQueue(this);
+		}
+
+		void STDMETHODCALLTYPE UpdateTileMappings( ID3D12Resource*, UINT, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*,
+			ID3D12Heap*, UINT, const D3D12_TILE_RANGE_FLAGS*, const UINT*, const UINT*, D3D12_TILE_MAPPING_FLAGS ) override {}
+		void STDMETHODCALLTYPE CopyTileMappings( ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, ID3D12Resource*,
+			const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*, D3D12_TILE_MAPPING_FLAGS ) override {}
+
+		void STDMETHODCALLTYPE ExecuteCommandLists( UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists ) override
+		{
+			for (UINT i = 0; i < NumCommandLists; ++i)
+				ASSERT(!static_cast<NullCommandList*>(ppCommandLists[i])->IsOpen(), "Command lists must be closed before they are executed");
+
+			Submit(Operation::kExecute, nullptr, 0);
+		}
+
+		void STDMETHODCALLTYPE SetMarker( UINT, const void*, UINT ) override {}
+		void STDMETHODCALLTYPE BeginEvent( UINT, const void*, UINT ) override {}
+		void STDMETHODCALLTYPE EndEvent( void ) override {}
+
+		HRESULT STDMETHODCALLTYPE Signal( ID3D12Fence* pFence, UINT64 Value ) override
+		{
+			Submit(Operation::kSignal, static_cast<NullFence*>(pFence), Value);
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE Wait( ID3D12Fence* pFence, UINT64 Value ) override
+		{
+			Submit(Operation::kWait, static_cast<NullFence*>(pFence), Value);
+			return S_OK;
+		}
+
+		// Timestamps are CPU ticks
+		HRESULT STDMETHODCALLTYPE GetTimestampFrequency( UINT64* pFrequency ) override
+		{
+			LARGE_INTEGER Frequency;
+			QueryPerformanceFrequency(&Frequency);
+			*pFrequency = (UINT64)Frequency.QuadPart;
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetClockCalibration( UINT64* pGpuTimestamp, UINT64* pCpuTimestamp ) override
+		{
+			LARGE_INTEGER Ticks;
+			QueryPerformanceCounter(&Ticks);
+			*pGpuTimestamp = (UINT64)Ticks.QuadPart;
+			*pCpuTimestamp = (UINT64)Ticks.QuadPart;
+			return S_OK;
+		}
+
+		D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+
+		// Retire operations from the front of the queue until one cannot complete yet.  Returns whether any
+		// were retired.  Called with the timeline lock held.
+		bool RetireOperations( Clock::time_point Now, Clock::time_point& NextWakeTime )
+		{
+			bool MadeProgress = false;
+
+			while (!m_Operations.empty())
+			{
+				Operation& Front = m_Operations.front();
+
+				switch (Front.Type)
+				{
+				case Operation::kExecute:
+					if (!Front.HasStarted)
+					{
+						Front.HasStarted = true;
+						Front.FinishTime = Now + std::chrono::microseconds(s_SimulatedLatency.load());
+					}
+					if (Front.FinishTime > Now)
+					{
+						NextWakeTime = std::min(NextWakeTime, Front.FinishTime);
+						return MadeProgress;
+					}
+					break;
+
+				case Operation::kWait:
+					if (Front.Fence->GetCompletedValue() < Front.Value)
+						return MadeProgress;
+					break;
+
+				case Operation::kSignal:
+					Front.Fence->Complete(Front.Value);
+					break;
+				}
+
+				m_Operations.pop_front();
+				MadeProgress = true;
+			}
+
+			return MadeProgress;
+		}
+
+	private:
+		struct Operation
+		{
+			enum OperationType { kExecute, kSignal, kWait };
+
+			OperationType Type;
+			Microsoft::WRL::ComPtr<NullFence> Fence;
+			UINT64 Value;
+			bool HasStarted;
+			Clock::time_point FinishTime;
+		};
+
+		void Submit( Operation::OperationType Type, NullFence* Fence, UINT64 Value )
+		{
+			Operation NewOperation;
+			NewOperation.Type = Type;
+			NewOperation.Fence = Fence;
+			NewOperation.Value = Value;
+			NewOperation.HasStarted = false;
+
+			{
+				std::lock_guard<std::mutex> LockGuard(m_NullDevice->GetTimelineMutex());
+				m_Operations.push_back(NewOperation);
+			}
+			m_NullDevice->AdvanceTimeline();
+		}
+
+		NullD3D12Device* m_NullDevice;
+		D3D12_COMMAND_QUEUE_DESC m_Desc;
+		std::deque<Operation> m_Operations;
+	};
+}
+
+//
+// NullD3D12Device implementation
+//
+
+NullD3D12Device::NullD3D12Device() :
+	m_NextGpuAddress(1ull << 40),
+	m_NextDescriptorAddress(kPageSize),
+	m_Quit(false)
+{
+	m_TimelineThread = std::thread(&NullD3D12Device::TimelineThread, this);
+}
+
+NullD3D12Device::~NullD3D12Device()
+{
+	{
+		std::lock_guard<std::mutex> LockGuard(m_TimelineMutex);
+		m_Quit = true;
+	}
+	m_TimelineCondition.notify_all();
+	m_TimelineThread.join();
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS NullD3D12Device::AllocateGpuAddressRange( uint64_t Size )
+{
+	return m_NextGpuAddress.fetch_add(AlignUp(std::max<uint64_t>(Size, 1), kPageSize));
+}
+
+SIZE_T NullD3D12Device::AllocateDescriptorRange( uint64_t Size )
+{
+	return (SIZE_T)m_NextDescriptorAddress.fetch_add(AlignUp(std::max<uint64_t>(Size, 1), kPageSize));
+}
+
+void NullD3D12Device::RegisterQueue( NullCommandQueue* Queue )
+{
+	std::lock_guard<std::mutex> LockGuard(m_TimelineMutex);
+	m_Queues.push_back(Queue);
+}
+
+void NullD3D12Device::UnregisterQueue( NullCommandQueue* Queue )
+{
+	std::lock_guard<std::mutex> LockGuard(m_TimelineMutex);
+	m_Queues.erase(std::remove(m_Queues.begin(), m_Queues.end(), Queue), m_Queues.end());
+}
+
+void NullD3D12Device::AdvanceTimeline( void )
+{
+	{
+		std::lock_guard<std::mutex> LockGuard(m_TimelineMutex);
+		RetireQueueOperations();
+	}
+
+	// Let the timeline thread pick up anything which now has to wait for the simulated latency
+	m_TimelineCondition.notify_one();
+}
+
+// A signal on one queue can release a wait on another, so keep going until no queue moves
+Clock::time_point NullD3D12Device::RetireQueueOperations( void )
+{
+	Clock::time_point NextWakeTime;
+	bool MadeProgress;
+
+	do
+	{
+		MadeProgress = false;
+		NextWakeTime = Clock::time_point::max();
+		Clock::time_point Now = Clock::now();
+
+		for (auto Queue : m_Queues)
+			MadeProgress |= Queue->RetireOperations(Now, NextWakeTime);
+	}
+	while (MadeProgress);
+
+	return NextWakeTime;
+}
+
+void NullD3D12Device::TimelineThread( void )
+{
+	std::unique_lock<std::mutex> Lock(m_TimelineMutex);
+
+	while (!m_Quit)
+	{
+		Clock::time_point NextWakeTime = RetireQueueOperations();
+
+		if (NextWakeTime == Clock::time_point::max())
+			m_TimelineCondition.wait(Lock);
+		else
+			m_TimelineCondition.wait_until(Lock, NextWakeTime);
+	}
+}
+
+HRESULT NullD3D12Device::CreateCommandQueue( const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue )
+{
+	return ReturnObject(new NullCommandQueue(this, *pDesc), riid, ppCommandQueue);
+}
+
+HRESULT NullD3D12Device::CreateCommandAllocator( D3D12_COMMAND_LIST_TYPE, REFIID riid, void** ppCommandAllocator )
+{
+	return ReturnObject(new NullCommandAllocator(this), riid, ppCommandAllocator);
+}
+
+HRESULT NullD3D12Device::CreateGraphicsPipelineState( const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID riid, void** ppPipelineState )
+{
+	return ReturnObject(new NullPipelineState(this), riid, ppPipelineState);
+}
+
+HRESULT NullD3D12Device::CreateComputePipelineState( const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID riid, void** ppPipelineState )
+{
+	return ReturnObject(new NullPipelineState(this), riid, ppPipelineState);
+}
+
+HRESULT NullD3D12Device::CreateCommandList( UINT, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator*, ID3D12PipelineState*,
+	REFIID riid, void** ppCommandList )
+{
+	return ReturnObject(new NullCommandList(this, type), riid, ppCommandList);
+}
+
+HRESULT NullD3D12Device::CheckFeatureSupport( D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize )
+{
+	switch (Feature)
+	{
+	case D3D12_FEATURE_D3D12_OPTIONS:
+	{
+		if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+			return E_INVALIDARG;
+		D3D12_FEATURE_DATA_D3D12_OPTIONS& Options = *(D3D12_FEATURE_DATA_D3D12_OPTIONS*)pFeatureSupportData;
+		std::memset(&Options, 0, sizeof(Options));
+		Options.ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+		Options.ResourceHeapTier = D3D12_RESOURCE_HEAP_TIER_1;
+		Options.TypedUAVLoadAdditionalFormats = TRUE;
+		return S_OK;
+	}
+
+	case D3D12_FEATURE_ARCHITECTURE:
+	{
+		if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_ARCHITECTURE))
+			return E_INVALIDARG;
+		D3D12_FEATURE_DATA_ARCHITECTURE& Architecture = *(D3D12_FEATURE_DATA_ARCHITECTURE*)pFeatureSupportData;
+		Architecture.TileBasedRenderer = FALSE;
+		Architecture.UMA = FALSE;
+		Architecture.CacheCoherentUMA = FALSE;
+		return S_OK;
+	}
+
+	case D3D12_FEATURE_FEATURE_LEVELS:
+	{
+		if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FEATURE_LEVELS))
+			return E_INVALIDARG;
+		D3D12_FEATURE_DATA_FEATURE_LEVELS& Levels = *(D3D12_FEATURE_DATA_FEATURE_LEVELS*)pFeatureSupportData;
+		Levels.MaxSupportedFeatureLevel = (D3D_FEATURE_LEVEL)0;
+		for (UINT i = 0; i < Levels.NumFeatureLevels; ++i)
+		{
+			if (Levels.pFeatureLevelsRequested[i] <= D3D_FEATURE_LEVEL_12_1)
+				Levels.MaxSupportedFeatureLevel = std::max(Levels.MaxSupportedFeatureLevel, Levels.pFeatureLevelsRequested[i]);
+		}
+		return S_OK;
+	}
+
+	case D3D12_FEATURE_FORMAT_SUPPORT:
+	{
+		if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FORMAT_SUPPORT))
+			return E_INVALIDARG;
+		D3D12_FEATURE_DATA_FORMAT_SUPPORT& Support = *(D3D12_FEATURE_DATA_FORMAT_SUPPORT*)pFeatureSupportData;
+		Support.Support1 = (D3D12_FORMAT_SUPPORT1)0xFFFFFFFF;
+		Support.Support2 = (D3D12_FORMAT_SUPPORT2)0xFFFFFFFF;
+		return S_OK;
+	}
+
+	case D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS:
+	{
+		if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS))
+			return E_INVALIDARG;
+		D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS& Levels = *(D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS*)pFeatureSupportData;
+		Levels.NumQualityLevels = Levels.SampleCount <= 8 ? 1 : 0;
+		return S_OK;
+	}
+
+	case D3D12_FEATURE_FORMAT_INFO:
+	{
+		if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FORMAT_INFO))
+			return E_INVALIDARG;
+		D3D12_FEATURE_DATA_FORMAT_INFO& Info = *(D3D12_FEATURE_DATA_FORMAT_INFO*)pFeatureSupportData;
+		Info.PlaneCount = IsDepthStencil(Info.Format) ? 2 : 1;
+		return S_OK;
+	}
+
+	case D3D12_FEATURE_GPU_VIRTUAL_ADDRESS_SUPPORT:
+	{
+		if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_GPU_VIRTUAL_ADDRESS_SUPPORT))
+			return E_INVALIDARG;
+		D3D12_FEATURE_DATA_GPU_VIRTUAL_ADDRESS_SUPPORT& Support = *(D3D12_FEATURE_DATA_GPU_VIRTUAL_ADDRESS_SUPPORT*)pFeatureSupportData;
+		Support.MaxGPUVirtualAddressBitsPerResource = 40;
+		Support.MaxGPUVirtualAddressBitsPerProcess = 48;
+		return S_OK;
+	}
+
+	default:
+		return E_INVALIDARG;
+	}
+}
+
+HRESULT NullD3D12Device::CreateDescriptorHeap( const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap )
+{
+	return ReturnObject(new NullDescriptorHeap(this, *pDescriptorHeapDesc), riid, ppvHeap);
+}
+
+HRESULT NullD3D12Device::CreateRootSignature( UINT, const void*, SIZE_T, REFIID riid, void** ppvRootSignature )
+{
+	return ReturnObject(new NullRootSignature(this), riid, ppvRootSignature);
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO NullD3D12Device::GetResourceAllocationInfo( UINT, UINT numResourceDescs,
+	const D3D12_RESOURCE_DESC* pResourceDescs )
+{
+	D3D12_RESOURCE_ALLOCATION_INFO Info = { 0, kPageSize };
+
+	for (UINT i = 0; i < numResourceDescs; ++i)
+	{
+		const D3D12_RESOURCE_DESC& Desc = pResourceDescs[i];
+		uint64_t Alignment = Desc.Alignment != 0 ? Desc.Alignment : (Desc.SampleDesc.Count > 1 ? kMSAAPageSize : kPageSize);
+
+		Info.SizeInBytes = AlignUp(Info.SizeInBytes, Alignment) + AlignUp(GetResourceSize(Desc), Alignment);
+		Info.Alignment = std::max(Info.Alignment, Alignment);
+	}
+
+	return Info;
+}
+
+D3D12_HEAP_PROPERTIES NullD3D12Device::GetCustomHeapProperties( UINT, D3D12_HEAP_TYPE heapType )
+{
+	D3D12_HEAP_PROPERTIES Properties = {};
+	Properties.Type = D3D12_HEAP_TYPE_CUSTOM;
+	Properties.CreationNodeMask = 1;
+	Properties.VisibleNodeMask = 1;
+
+	switch (heapType)
+	{
+	case D3D12_HEAP_TYPE_UPLOAD:
+		Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
+		Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
+		break;
+	case D3D12_HEAP_TYPE_READBACK:
+		Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+		Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
+		break;
+	default:
+		Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE;
+		Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_L1;
+		break;
+	}
+
+	return Properties;
+}
+
+HRESULT NullD3D12Device::CreateCommittedResource( const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags,
+	const D3D12_RESOURCE_DESC* pResourceDesc, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID riidResource, void** ppvResource )
+{
+	return ReturnObject(new NullResource(this, *pResourceDesc, pHeapProperties, HeapFlags, nullptr, 0), riidResource, ppvResource);
+}
+
+HRESULT NullD3D12Device::CreateHeap( const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap )
+{
+	return ReturnObject(new NullHeap(this, *pDesc), riid, ppvHeap);
+}
+
+HRESULT NullD3D12Device::CreatePlacedResource( ID3D12Heap* pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC* pDesc,
+	D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID riid, void** ppvResource )
+{
+	return ReturnObject(new NullResource(this, *pDesc, nullptr, D3D12_HEAP_FLAG_NONE, static_cast<NullHeap*>(pHeap), HeapOffset),
+		riid, ppvResource);
+}
+
+HRESULT NullD3D12Device::CreateReservedResource( const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*,
+	REFIID riid, void** ppvResource )
+{
+	return ReturnObject(new NullResource(this, *pDesc, nullptr, D3D12_HEAP_FLAG_NONE, nullptr, 0), riid, ppvResource);
+}
+
+HRESULT NullD3D12Device::CreateFence( UINT64 InitialValue, D3D12_FENCE_FLAGS, REFIID riid, void** ppFence )
+{
+	return ReturnObject(new NullFence(this, InitialValue), riid, ppFence);
+}
+
+HRESULT NullD3D12Device::CreateQueryHeap( const D3D12_QUERY_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap )
+{
+	return ReturnObject(new NullQueryHeap(this, *pDesc), riid, ppvHeap);
+}
+
+HRESULT NullD3D12Device::CreateCommandSignature( const D3D12_COMMAND_SIGNATURE_DESC*, ID3D12RootSignature*, REFIID riid,
+	void** ppvCommandSignature )
+{
+	return ReturnObject(new NullCommandSignature(this), riid, ppvCommandSignature);
+}
+
+//
+// Public interface
+//
+
+HRESULT NullDevice::CreateDevice( REFIID riid, void** ppDevice )
+{
+	return ReturnObject(new NullD3D12Device, riid, ppDevice);
+}
+
+void NullDevice::SetSimulatedLatency( uint32_t Microseconds )
+{
+	s_SimulatedLatency = Microseconds;
+}
+
+uint32_t NullDevice::GetSimulatedLatency( void )
+{
+	return s_SimulatedLatency;
+}
@@ -0,0 +1,32 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  A D3D12 device which needs no GPU.  It implements the device, command queue, command list,
+// fence and resource interfaces Core uses, so that allocators, contexts and the rest of the CPU side can be
+// run and measured on machines without a D3D12 driver.  Nothing is rendered.
+//
+// Command lists record nothing.  Each ExecuteCommandLists() call takes the simulated latency to "execute",
+// and queue operations complete in submission order, including waits on fences signaled by other queues.
+// With no latency, work completes during the call that submits it.  Buffers in upload and readback heaps
+// are backed by host memory, so mapping them works as usual.  Timestamp queries return CPU ticks taken
+// when the query was recorded.
+//
+// This still needs Windows:  Core builds against the Windows SDK headers, and RootSignature serializes root
+// signatures with d3d12.dll.  It removes the need for a GPU and driver, not for the platform.
+
+#pragma once
+
+namespace NullDevice
+{
+	// Create a null device.  Pass it to the same places as a device from D3D12CreateDevice().
+	HRESULT CreateDevice( REFIID riid, void** ppDevice );
+
+	// How long each batch of command lists takes to execute, in microseconds
+	void SetSimulatedLatency( uint32_t Microseconds );
+	uint32_t GetSimulatedLatency( void );
+}
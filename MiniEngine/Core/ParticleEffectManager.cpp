@@ -548,6 +548,8 @@ void ParticleEffects::Initialize( uint32_t MaxDisplayWidth, uint32_t MaxDisplayH
 
 	if (s_ReproFrame > 0)
 		s_RNG.SetSeed(1);
+	else
+		s_RNG.SeedFromEntropy();
 	
 	TotalElapsedFrames = 0;
 	s_InitComplete = true;
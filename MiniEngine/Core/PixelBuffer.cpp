@@ -276,3 +276,19 @@ void PixelBuffer::CreateTextureResource( ID3D12Device* Device, const std::wstrin
 	CreateTextureResource(Device, Name, ResourceDesc, ClearValue);
 }
 
+void PixelBuffer::CreatePlacedTextureResource( ID3D12Device* Device, const std::wstring& Name,
+	const D3D12_RESOURCE_DESC& ResourceDesc, D3D12_CLEAR_VALUE ClearValue, ID3D12Heap* Heap, uint64_t HeapOffset )
+{
+	ASSERT_SUCCEEDED( Device->CreatePlacedResource( Heap, HeapOffset, &ResourceDesc, D3D12_RESOURCE_STATE_COMMON,
+		&ClearValue, MY_IID_PPV_ARGS(&m_pResource) ));
+
+	m_UsageState = D3D12_RESOURCE_STATE_COMMON;
+	m_GpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+
+#ifndef RELEASE
+	m_pResource->SetName(Name.c_str());
+#else
+	(Name);
+#endif
+}
+
@@ -20,6 +20,7 @@
 #include "PipelineState.h"
 #include "GraphicsCore.h"
 #include "BufferManager.h"
+#include "FrameGraph.h"
 #include "MotionBlur.h"
 #include "FXAA.h"
 
@@ -102,8 +103,12 @@ namespace PostEffects
 
 	StructuredBuffer g_Exposure;
 
+	// Schedules the bloom passes.  The intermediate bloom buffers are its transient textures.
+	FrameGraph g_BloomGraph(L"Bloom");
+
 	void UpdateExposure(ComputeContext&);
-	void BlurBuffer(ComputeContext&, ColorBuffer buffer[2], const ColorBuffer& lowerResBuf, uint32_t bufferWidth, uint32_t bufferHeight, float upsampleBlendFactor );
+	void BlurBuffer(ComputeContext&, ColorBuffer& inputBuf, const ColorBuffer& lowerResBuf, ColorBuffer& outputBuf, uint32_t bufferWidth, uint32_t bufferHeight, float upsampleBlendFactor );
+	void AddBlurPass(FrameGraph&, const std::wstring& Name, FrameGraph::ResourceHandle Input, FrameGraph::ResourceHandle LowerRes, FrameGraph::ResourceHandle Output, uint32_t Divisor, float upsampleBlendFactor );
 	void GenerateBloom(ComputeContext&);
 	void ExtractLuma(ComputeContext&);
 	void ProcessHDR(ComputeContext&);
@@ -159,29 +164,44 @@ void PostEffects::Initialize( void )
 void PostEffects::Shutdown( void )
 {
 	g_Exposure.Destroy();
+	g_BloomGraph.Destroy();
 
 	FXAA::Shutdown();
 	MotionBlur::Shutdown();
 }
 
-void PostEffects::BlurBuffer( ComputeContext& Context, ColorBuffer buffer[2], const ColorBuffer& lowerResBuf, uint32_t bufferWidth, uint32_t bufferHeight, float upsampleBlendFactor )
+void PostEffects::BlurBuffer( ComputeContext& Context, ColorBuffer& inputBuf, const ColorBuffer& lowerResBuf, ColorBuffer& outputBuf, uint32_t bufferWidth, uint32_t bufferHeight, float upsampleBlendFactor )
 {
 	// Set the shader constants
 	Context.SetConstants(0, 1.0f / bufferWidth, 1.0f / bufferHeight, upsampleBlendFactor);
 
 	// Set the input textures and output UAV
-	Context.TransitionResource( buffer[1], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	Context.SetDynamicDescriptor(1, 0, buffer[1].GetUAV());
-	D3D12_CPU_DESCRIPTOR_HANDLE SRVs[2] = { buffer[0].GetSRV(), lowerResBuf.GetSRV() };
+	Context.SetDynamicDescriptor(1, 0, outputBuf.GetUAV());
+	D3D12_CPU_DESCRIPTOR_HANDLE SRVs[2] = { inputBuf.GetSRV(), lowerResBuf.GetSRV() };
 	Context.SetDynamicDescriptors(2, 0, 2, SRVs);
 
 	// Set the shader:  upsample and blur or just blur
-	Context.SetPipelineState(&buffer[0] == &lowerResBuf ? BlurCS : UpsampleAndBlurCS);
+	Context.SetPipelineState(&inputBuf == &lowerResBuf ? BlurCS : UpsampleAndBlurCS);
 
 	// Dispatch the compute shader with default 8x8 thread groups
 	Context.Dispatch2D(bufferWidth, bufferHeight);
+}
 
-	Context.TransitionResource( buffer[1], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+void PostEffects::AddBlurPass( FrameGraph& Graph, const std::wstring& Name, FrameGraph::ResourceHandle Input,
+	FrameGraph::ResourceHandle LowerRes, FrameGraph::ResourceHandle Output, uint32_t Divisor, float upsampleBlendFactor )
+{
+	Graph.AddPass(Name,
+		[=]( FrameGraph::PassBuilder& Builder )
+		{
+			Builder.Read(Input);
+			Builder.Read(LowerRes);
+			Builder.Write(Output);
+		},
+		[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+		{
+			BlurBuffer( PassContext, Resources.GetColorBuffer(Input), Resources.GetColorBuffer(LowerRes), Resources.GetColorBuffer(Output),
+				kBloomWidth / Divisor, kBloomHeight / Divisor, upsampleBlendFactor );
+		});
 }
 
 //--------------------------------------------------------------------------------------
@@ -191,84 +211,126 @@ void PostEffects::GenerateBloom( ComputeContext& Context )
 {
 	ScopedTimer _prof(L"Generate Bloom", Context);
 
-	// We can generate a bloom buffer up to 1/4 smaller in each dimension without undersampling.  If only downsizing by 1/2 or less, a faster
-	// shader can be used which only does one bilinear sample.
+	typedef FrameGraph::ResourceHandle ResourceHandle;
 
-	Context.SetConstants(0, 1.0f / kBloomWidth, 1.0f / kBloomHeight, (float)BloomThreshold );
-	Context.TransitionResource(g_aBloomUAV1[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-	Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	Context.TransitionResource(g_Exposure, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	FrameGraph& Graph = g_BloomGraph;
+	Graph.Reset();
+
+	ResourceHandle SceneColor = Graph.ImportColorBuffer(g_SceneColorBuffer);
+	ResourceHandle Exposure = Graph.ImportResource(g_Exposure);
+	ResourceHandle LumaLR = Graph.ImportColorBuffer(g_LumaLR);
+	ResourceHandle BloomOutput = Graph.ImportColorBuffer(g_BloomBuffer);
 
+	auto CreateBloomBuffer = [&Graph]( const std::wstring& Name, uint32_t Divisor )
 	{
+		FrameGraph::TextureDesc Desc = { kBloomWidth / Divisor, kBloomHeight / Divisor, DXGI_FORMAT_R11G11B10_FLOAT };
+		return Graph.CreateTexture(Name, Desc);
+	};
 
-		D3D12_CPU_DESCRIPTOR_HANDLE UAVs[2] = { g_aBloomUAV1[0].GetUAV(), g_LumaLR.GetUAV() };
-		Context.SetDynamicDescriptors(1, 0, 2, UAVs);
-		D3D12_CPU_DESCRIPTOR_HANDLE SRVs[2] = { g_SceneColorBuffer.GetSRV(), g_Exposure.GetSRV() };
-		Context.SetDynamicDescriptors(2, 0, 2, SRVs);
+	ResourceHandle Bloom1 = CreateBloomBuffer(L"Bloom Buffer 1a", 1);
 
-		Context.SetPipelineState(EnableHDR ? BloomExtractAndDownsampleHdrCS : BloomExtractAndDownsampleLdrCS);
-		Context.Dispatch2D(kBloomWidth, kBloomHeight);
-	}
+	// We can generate a bloom buffer up to 1/4 smaller in each dimension without undersampling.  If only downsizing by 1/2 or less, a faster
+	// shader can be used which only does one bilinear sample.
 
-	Context.TransitionResource(g_aBloomUAV1[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-	Context.SetDynamicDescriptor(2, 0, g_aBloomUAV1[0].GetSRV());
+	Graph.AddPass(L"Extract Bloom",
+		[=]( FrameGraph::PassBuilder& Builder )
+		{
+			Builder.Read(SceneColor);
+			Builder.Read(Exposure);
+			Builder.Write(Bloom1);
+			Builder.Write(LumaLR);
+		},
+		[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+		{
+			PassContext.SetConstants(0, 1.0f / kBloomWidth, 1.0f / kBloomHeight, (float)BloomThreshold );
+
+			D3D12_CPU_DESCRIPTOR_HANDLE UAVs[2] = { Resources.GetColorBuffer(Bloom1).GetUAV(), g_LumaLR.GetUAV() };
+			PassContext.SetDynamicDescriptors(1, 0, 2, UAVs);
+			D3D12_CPU_DESCRIPTOR_HANDLE SRVs[2] = { g_SceneColorBuffer.GetSRV(), g_Exposure.GetSRV() };
+			PassContext.SetDynamicDescriptors(2, 0, 2, SRVs);
+
+			PassContext.SetPipelineState(EnableHDR ? BloomExtractAndDownsampleHdrCS : BloomExtractAndDownsampleLdrCS);
+			PassContext.Dispatch2D(kBloomWidth, kBloomHeight);
+		});
 
 	// The difference between high and low quality bloom is that high quality sums 5 octaves with a 2x frequency scale, and the low quality
 	// sums 3 octaves with a 4x frequency scale.
 	if (HighQualityBloom)
 	{
-		Context.TransitionResource(g_aBloomUAV2[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		Context.TransitionResource(g_aBloomUAV4[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-		// Set the UAVs
-		D3D12_CPU_DESCRIPTOR_HANDLE UAVs[4] = {
-			g_aBloomUAV2[0].GetUAV(), g_aBloomUAV3[0].GetUAV(), g_aBloomUAV4[0].GetUAV(), g_aBloomUAV5[0].GetUAV() };
-		Context.SetDynamicDescriptors(1, 0, 4, UAVs);
-
-		// Each dispatch group is 8x8 threads, but each thread reads in 2x2 source texels (bilinear filter).
-		Context.SetPipelineState(DownsampleBloom4CS);
-		Context.Dispatch2D(kBloomWidth / 2, kBloomHeight / 2);
-
-		Context.TransitionResource(g_aBloomUAV2[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		Context.TransitionResource(g_aBloomUAV4[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		ResourceHandle Bloom2[2] = { CreateBloomBuffer(L"Bloom Buffer 2a", 2), CreateBloomBuffer(L"Bloom Buffer 2b", 2) };
+		ResourceHandle Bloom3[2] = { CreateBloomBuffer(L"Bloom Buffer 3a", 4), CreateBloomBuffer(L"Bloom Buffer 3b", 4) };
+		ResourceHandle Bloom4[2] = { CreateBloomBuffer(L"Bloom Buffer 4a", 8), CreateBloomBuffer(L"Bloom Buffer 4b", 8) };
+		ResourceHandle Bloom5[2] = { CreateBloomBuffer(L"Bloom Buffer 5a", 16), CreateBloomBuffer(L"Bloom Buffer 5b", 16) };
+
+		Graph.AddPass(L"Downsample Bloom",
+			[=]( FrameGraph::PassBuilder& Builder )
+			{
+				Builder.Read(Bloom1);
+				Builder.Write(Bloom2[0]);
+				Builder.Write(Bloom3[0]);
+				Builder.Write(Bloom4[0]);
+				Builder.Write(Bloom5[0]);
+			},
+			[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+			{
+				PassContext.SetDynamicDescriptor(2, 0, Resources.GetColorBuffer(Bloom1).GetSRV());
+
+				// Set the UAVs
+				D3D12_CPU_DESCRIPTOR_HANDLE UAVs[4] = {
+					Resources.GetColorBuffer(Bloom2[0]).GetUAV(), Resources.GetColorBuffer(Bloom3[0]).GetUAV(),
+					Resources.GetColorBuffer(Bloom4[0]).GetUAV(), Resources.GetColorBuffer(Bloom5[0]).GetUAV() };
+				PassContext.SetDynamicDescriptors(1, 0, 4, UAVs);
+
+				// Each dispatch group is 8x8 threads, but each thread reads in 2x2 source texels (bilinear filter).
+				PassContext.SetPipelineState(DownsampleBloom4CS);
+				PassContext.Dispatch2D(kBloomWidth / 2, kBloomHeight / 2);
+			});
 
 		float upsampleBlendFactor = BloomUpsampleFactor;
 
 		// Blur then upsample and blur four times
-		BlurBuffer( Context, g_aBloomUAV5, g_aBloomUAV5[0], kBloomWidth/16, kBloomHeight/16, 1.0f );
-		BlurBuffer( Context, g_aBloomUAV4, g_aBloomUAV5[1], kBloomWidth/8,  kBloomHeight/8,  upsampleBlendFactor  );
-		BlurBuffer( Context, g_aBloomUAV3, g_aBloomUAV4[1], kBloomWidth/4,  kBloomHeight/4,  upsampleBlendFactor  );
-		BlurBuffer( Context, g_aBloomUAV2, g_aBloomUAV3[1], kBloomWidth/2,  kBloomHeight/2,  upsampleBlendFactor  );
-		BlurBuffer( Context, g_aBloomUAV1, g_aBloomUAV2[1], kBloomWidth,    kBloomHeight  ,  upsampleBlendFactor  );
+		AddBlurPass( Graph, L"Blur Bloom 5",     Bloom5[0], Bloom5[0], Bloom5[1],   16, 1.0f );
+		AddBlurPass( Graph, L"Upsample Bloom 4", Bloom4[0], Bloom5[1], Bloom4[1],   8,  upsampleBlendFactor );
+		AddBlurPass( Graph, L"Upsample Bloom 3", Bloom3[0], Bloom4[1], Bloom3[1],   4,  upsampleBlendFactor );
+		AddBlurPass( Graph, L"Upsample Bloom 2", Bloom2[0], Bloom3[1], Bloom2[1],   2,  upsampleBlendFactor );
+		AddBlurPass( Graph, L"Upsample Bloom 1", Bloom1,    Bloom2[1], BloomOutput, 1,  upsampleBlendFactor );
 	}
 	else
 	{
-		// Set the UAVs
-		D3D12_CPU_DESCRIPTOR_HANDLE UAVs[2] = { g_aBloomUAV3[0].GetUAV(), g_aBloomUAV5[0].GetUAV() };
-		Context.SetDynamicDescriptors(1, 0, 2, UAVs);
-
-		Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-		// Each dispatch group is 8x8 threads, but each thread reads in 2x2 source texels (bilinear filter).
-		Context.SetPipelineState(DownsampleBloom2CS);
-		Context.Dispatch2D(kBloomWidth / 2, kBloomHeight / 2);
-
-		Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		ResourceHandle Bloom3[2] = { CreateBloomBuffer(L"Bloom Buffer 3a", 4), CreateBloomBuffer(L"Bloom Buffer 3b", 4) };
+		ResourceHandle Bloom5[2] = { CreateBloomBuffer(L"Bloom Buffer 5a", 16), CreateBloomBuffer(L"Bloom Buffer 5b", 16) };
+
+		Graph.AddPass(L"Downsample Bloom",
+			[=]( FrameGraph::PassBuilder& Builder )
+			{
+				Builder.Read(Bloom1);
+				Builder.Write(Bloom3[0]);
+				Builder.Write(Bloom5[0]);
+			},
+			[=]( ComputeContext& PassContext, const FrameGraph::PassResources& Resources )
+			{
+				PassContext.SetDynamicDescriptor(2, 0, Resources.GetColorBuffer(Bloom1).GetSRV());
+
+				// Set the UAVs
+				D3D12_CPU_DESCRIPTOR_HANDLE UAVs[2] = {
+					Resources.GetColorBuffer(Bloom3[0]).GetUAV(), Resources.GetColorBuffer(Bloom5[0]).GetUAV() };
+				PassContext.SetDynamicDescriptors(1, 0, 2, UAVs);
+
+				// Each dispatch group is 8x8 threads, but each thread reads in 2x2 source texels (bilinear filter).
+				PassContext.SetPipelineState(DownsampleBloom2CS);
+				PassContext.Dispatch2D(kBloomWidth / 2, kBloomHeight / 2);
+			});
 
 		float upsampleBlendFactor = BloomUpsampleFactor * 2.0f / 3.0f;
 
 		// Blur then upsample and blur two times
-		BlurBuffer( Context, g_aBloomUAV5, g_aBloomUAV5[0], kBloomWidth/16, kBloomHeight/16, 1.0f );
-		BlurBuffer( Context, g_aBloomUAV3, g_aBloomUAV5[1], kBloomWidth/4,  kBloomHeight/4,  upsampleBlendFactor );
-		BlurBuffer( Context, g_aBloomUAV1, g_aBloomUAV3[1], kBloomWidth,    kBloomHeight  ,  upsampleBlendFactor );
+		AddBlurPass( Graph, L"Blur Bloom 5",     Bloom5[0], Bloom5[0], Bloom5[1],   16, 1.0f );
+		AddBlurPass( Graph, L"Upsample Bloom 3", Bloom3[0], Bloom5[1], Bloom3[1],   4,  upsampleBlendFactor );
+		AddBlurPass( Graph, L"Upsample Bloom 1", Bloom1,    Bloom3[1], BloomOutput, 1,  upsampleBlendFactor );
 	}
+
+	Graph.Compile();
+	Graph.Execute(Context);
 }
 
 void PostEffects::ExtractLuma( ComputeContext& Context )
@@ -331,7 +393,7 @@ void PostEffects::ProcessHDR( ComputeContext& Context )
 	if (BloomEnable)
 	{
 		GenerateBloom(Context);
-		Context.TransitionResource(g_aBloomUAV1[1], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		Context.TransitionResource(g_BloomBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	}
 	else if (EnableAdaptation)
 		ExtractLuma(Context);
@@ -352,7 +414,7 @@ void PostEffects::ProcessHDR( ComputeContext& Context )
 	// Read in original HDR value and blurred bloom buffer
 	Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetSRV());
 	Context.SetDynamicDescriptor(2, 1, g_Exposure.GetSRV());
-	Context.SetDynamicDescriptor(2, 2, BloomEnable ? g_aBloomUAV1[1].GetSRV() : TextureManager::GetBlackTex2D().GetSRV());
+	Context.SetDynamicDescriptor(2, 2, BloomEnable ? g_BloomBuffer.GetSRV() : TextureManager::GetBlackTex2D().GetSRV());
 
 	Context.Dispatch2D(g_SceneColorBuffer.GetWidth(), g_SceneColorBuffer.GetHeight());
 
@@ -372,7 +434,7 @@ void PostEffects::ProcessLDR(CommandContext& BaseContext)
 
 	if (bGenerateBloom || FXAA::DebugDraw || SSAO::DebugDraw)
 	{
-		Context.TransitionResource(g_aBloomUAV1[1], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		Context.TransitionResource(g_BloomBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 		Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		Context.TransitionResource(g_LumaBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
@@ -385,7 +447,7 @@ void PostEffects::ProcessLDR(CommandContext& BaseContext)
 
 		// Read in original LDR value and blurred bloom buffer
 		Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetSRV());
-		Context.SetDynamicDescriptor(2, 1, bGenerateBloom ? g_aBloomUAV1[1].GetSRV() : TextureManager::GetBlackTex2D().GetSRV());
+		Context.SetDynamicDescriptor(2, 1, bGenerateBloom ? g_BloomBuffer.GetSRV() : TextureManager::GetBlackTex2D().GetSRV());
 
 		Context.SetPipelineState(FXAA::DebugDraw ? DebugLuminanceLdrCS : ApplyBloomCS);
 		Context.Dispatch2D(g_SceneColorBuffer.GetWidth(), g_SceneColorBuffer.GetHeight());
@@ -0,0 +1,224 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "ResourceStateTracker.h"
+
+#define INVALID_RESOURCE_STATE ((D3D12_RESOURCE_STATES)-1)
+
+std::mutex ResourceStateTracker::sm_GlobalStateMutex;
+
+ResourceStateTracker::ResourceStateTracker(D3D12_COMMAND_LIST_TYPE Type) :
+	m_Type(Type),
+	m_NumSplitTransitions(0)
+{
+	m_PendingBarriers.reserve(16);
+}
+
+void ResourceStateTracker::Reset(void)
+{
+	ASSERT(m_PendingBarriers.empty() && m_NumSplitTransitions == 0);
+	m_LocalStates.clear();
+}
+
+void ResourceStateTracker::ValidateStates(D3D12_RESOURCE_STATES OldState, D3D12_RESOURCE_STATES NewState) const
+{
+	if (m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE)
+	{
+		ASSERT((OldState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == OldState);
+		ASSERT((NewState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == NewState);
+	}
+	(OldState); (NewState);
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::GetGlobalState(const GpuResource& Resource)
+{
+	std::lock_guard<std::mutex> LockGuard(sm_GlobalStateMutex);
+	return Resource.m_UsageState;
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::GetCurrentState(const GpuResource& Resource) const
+{
+	auto Iter = m_LocalStates.find(const_cast<GpuResource*>(&Resource));
+	return Iter == m_LocalStates.end() ? GetGlobalState(Resource) : Iter->second.CurrentState;
+}
+
+D3D12_RESOURCE_BARRIER* ResourceStateTracker::FindLastPendingBarrier(const GpuResource& Resource)
+{
+	const ID3D12Resource* pResource = Resource.GetResource();
+
+	for (size_t i = m_PendingBarriers.size(); i > 0; --i)
+	{
+		D3D12_RESOURCE_BARRIER& Barrier = m_PendingBarriers[i - 1];
+		switch (Barrier.Type)
+		{
+		case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+			if (Barrier.Transition.pResource == pResource)
+				return &Barrier;
+			break;
+		case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+			if (Barrier.UAV.pResource == pResource)
+				return &Barrier;
+			break;
+		case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+			if (Barrier.Aliasing.pResourceBefore == pResource || Barrier.Aliasing.pResourceAfter == pResource)
+				return &Barrier;
+			break;
+		}
+	}
+
+	return nullptr;
+}
+
+void ResourceStateTracker::TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState)
+{
+	auto Inserted = m_LocalStates.emplace(&Resource, LocalResourceState());
+	LocalResourceState& Local = Inserted.first->second;
+
+	if (Inserted.second)
+	{
+		// First use in this context.  The transition into NewState is left to the fix-up barriers, which
+		// know what the resource was left in by the contexts executed before this one.
+		Local.InitialState = NewState;
+		Local.CurrentState = NewState;
+		Local.TransitioningState = INVALID_RESOURCE_STATE;
+
+		// Unordered access from previously executed work must still be complete before this work reads it
+		if (NewState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+			InsertUAVBarrier(Resource);
+		return;
+	}
+
+	// Finish a split transition first
+	if (Local.TransitioningState != INVALID_RESOURCE_STATE)
+	{
+		D3D12_RESOURCE_BARRIER* Pending = FindLastPendingBarrier(Resource);
+		if (Pending != nullptr && Pending->Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION &&
+			Pending->Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+		{
+			// No work was recorded since the transition began, so there is nothing to overlap it with
+			Pending->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		}
+		else
+		{
+			m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(Resource.GetResource(),
+				Local.CurrentState, Local.TransitioningState, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+				D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+		}
+
+		Local.CurrentState = Local.TransitioningState;
+		Local.TransitioningState = INVALID_RESOURCE_STATE;
+		--m_NumSplitTransitions;
+	}
+
+	if (Local.CurrentState != NewState)
+	{
+		ValidateStates(Local.CurrentState, NewState);
+
+		// Transitions which have not been submitted yet are merged, since no work can have used the
+		// intermediate state.
+		D3D12_RESOURCE_BARRIER* Pending = FindLastPendingBarrier(Resource);
+		if (Pending != nullptr && Pending->Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION &&
+			Pending->Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE)
+		{
+			ASSERT(Pending->Transition.StateAfter == Local.CurrentState);
+			Pending->Transition.StateAfter = NewState;
+
+			if (Pending->Transition.StateBefore == NewState)
+				m_PendingBarriers.erase(m_PendingBarriers.begin() + (Pending - m_PendingBarriers.data()));
+		}
+		else
+		{
+			m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(Resource.GetResource(),
+				Local.CurrentState, NewState));
+		}
+
+		Local.CurrentState = NewState;
+	}
+	else if (NewState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+	{
+		InsertUAVBarrier(Resource);
+	}
+}
+
+void ResourceStateTracker::BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState)
+{
+	auto Iter = m_LocalStates.find(&Resource);
+	if (Iter == m_LocalStates.end())
+	{
+		// There is no earlier work in this context to overlap with, so let the fix-up barriers do it
+		TransitionResource(Resource, NewState);
+		return;
+	}
+
+	LocalResourceState& Local = Iter->second;
+
+	// If it's already transitioning, finish that transition
+	if (Local.TransitioningState != INVALID_RESOURCE_STATE)
+		TransitionResource(Resource, Local.TransitioningState);
+
+	if (Local.CurrentState != NewState)
+	{
+		ValidateStates(Local.CurrentState, NewState);
+
+		m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(Resource.GetResource(),
+			Local.CurrentState, NewState, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+			D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+
+		Local.TransitioningState = NewState;
+		++m_NumSplitTransitions;
+	}
+}
+
+void ResourceStateTracker::InsertUAVBarrier(GpuResource& Resource)
+{
+	m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(Resource.GetResource()));
+}
+
+void ResourceStateTracker::InsertAliasBarrier(GpuResource& Before, GpuResource& After)
+{
+	m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(Before.GetResource(), After.GetResource()));
+}
+
+void ResourceStateTracker::EndSplitTransitions(void)
+{
+	if (m_NumSplitTransitions == 0)
+		return;
+
+	for (auto& Entry : m_LocalStates)
+	{
+		if (Entry.second.TransitioningState != INVALID_RESOURCE_STATE)
+			TransitionResource(*Entry.first, Entry.second.TransitioningState);
+	}
+
+	ASSERT(m_NumSplitTransitions == 0);
+}
+
+void ResourceStateTracker::ResolveGlobalStates(std::vector<D3D12_RESOURCE_BARRIER>& FixupBarriers)
+{
+	ASSERT(m_PendingBarriers.empty(), "Flush the resource barriers before resolving");
+	ASSERT(m_NumSplitTransitions == 0, "Split barriers must be ended before resolving");
+
+	for (auto& Entry : m_LocalStates)
+	{
+		GpuResource& Resource = *Entry.first;
+		const LocalResourceState& Local = Entry.second;
+
+		if (Resource.m_UsageState != Local.InitialState)
+		{
+			ValidateStates(Resource.m_UsageState, Local.InitialState);
+			FixupBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(Resource.GetResource(),
+				Resource.m_UsageState, Local.InitialState));
+		}
+
+		Resource.m_UsageState = Local.CurrentState;
+	}
+
+	m_LocalStates.clear();
+}
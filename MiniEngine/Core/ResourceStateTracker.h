@@ -0,0 +1,89 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  Tracks the state of resources as seen by a single command context.  Several contexts may
+// record in parallel, so none of them can know what state a resource will be in when their command list
+// starts executing.  Instead, the first transition of each resource in a context only records the state the
+// context needs it in.  When the context is executed, ResolveGlobalStates() compares those with the global
+// state left behind by previously executed contexts, produces the fix-up barriers that must run first, and
+// publishes the context's final states as the new global states.
+//
+// Barriers are buffered until the context records GPU work.  A transition of a resource which already has a
+// buffered transition is merged into it, and a split barrier which is ended before any work was recorded
+// after its beginning is collapsed into a single barrier.
+//
+// The tracker does not touch a command list, so it can be driven without a device.
+
+#pragma once
+
+#include "GpuResource.h"
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#define VALID_COMPUTE_QUEUE_RESOURCE_STATES \
+	( D3D12_RESOURCE_STATE_UNORDERED_ACCESS \
+	| D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE \
+	| D3D12_RESOURCE_STATE_COPY_DEST \
+	| D3D12_RESOURCE_STATE_COPY_SOURCE )
+
+class ResourceStateTracker
+{
+public:
+
+	ResourceStateTracker(D3D12_COMMAND_LIST_TYPE Type);
+
+	void TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState);
+	void BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState);
+	void InsertUAVBarrier(GpuResource& Resource);
+	void InsertAliasBarrier(GpuResource& Before, GpuResource& After);
+
+	// Ends every split barrier which is still in progress
+	void EndSplitTransitions(void);
+
+	// The state of the resource at the current point in the context, or the global state if the context
+	// has not transitioned it yet.
+	D3D12_RESOURCE_STATES GetCurrentState(const GpuResource& Resource) const;
+
+	UINT GetPendingBarrierCount(void) const { return (UINT)m_PendingBarriers.size(); }
+	const D3D12_RESOURCE_BARRIER* GetPendingBarriers(void) const { return m_PendingBarriers.data(); }
+	void ClearPendingBarriers(void) { m_PendingBarriers.clear(); }
+
+	// Append the barriers needed to bring the global states to the states this context starts with, and make
+	// the context's final states the global states.  The caller must hold the global state lock from before
+	// resolving until the command lists have been submitted, so that resolution order matches queue order.
+	void ResolveGlobalStates(std::vector<D3D12_RESOURCE_BARRIER>& FixupBarriers);
+
+	// Forget all local states.  Used when a context is reused.
+	void Reset(void);
+
+	static std::mutex& GetGlobalStateMutex(void) { return sm_GlobalStateMutex; }
+
+	// The state left behind by the contexts executed so far.  Takes the global state lock, so it must not be
+	// called while holding it.
+	static D3D12_RESOURCE_STATES GetGlobalState(const GpuResource& Resource);
+
+private:
+
+	struct LocalResourceState
+	{
+		D3D12_RESOURCE_STATES InitialState;			// The state the context expects when it begins executing
+		D3D12_RESOURCE_STATES CurrentState;
+		D3D12_RESOURCE_STATES TransitioningState;	// Target of a split barrier in progress, or -1
+	};
+
+	D3D12_RESOURCE_BARRIER* FindLastPendingBarrier(const GpuResource& Resource);
+	void ValidateStates(D3D12_RESOURCE_STATES OldState, D3D12_RESOURCE_STATES NewState) const;
+
+	static std::mutex sm_GlobalStateMutex;
+
+	D3D12_COMMAND_LIST_TYPE m_Type;
+	std::unordered_map<GpuResource*, LocalResourceState> m_LocalStates;
+	std::vector<D3D12_RESOURCE_BARRIER> m_PendingBarriers;
+	UINT m_NumSplitTransitions;
+};
@@ -15,27 +15,135 @@
 #include "pch.h"
 #include "SamplerManager.h"
 #include "GraphicsCore.h"
+#include "DescriptorHeap.h"
 #include "Hash.h"
 #include <map>
+#include <mutex>
+#include <vector>
 
 using namespace std;
 using Graphics::g_Device;
 
 namespace
 {
-	map< size_t, D3D12_CPU_DESCRIPTOR_HANDLE > s_SamplerCache;
+	// Keyed by hash.  The full desc is kept to tell apart descs whose hashes collide.
+	struct CachedSampler
+	{
+		D3D12_SAMPLER_DESC Desc;
+		D3D12_CPU_DESCRIPTOR_HANDLE Handle;
+	};
+
+	struct CachedTable
+	{
+		vector<SIZE_T> Samplers;
+		D3D12_GPU_DESCRIPTOR_HANDLE Table;
+	};
+
+	mutex s_SamplerMutex;
+	multimap< size_t, CachedSampler > s_SamplerCache;
+
+	mutex s_TableMutex;
+	multimap< size_t, CachedTable > s_TableCache;
+	UserDescriptorHeap s_TableHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE);
+
+	ID3D12DescriptorHeap* GetTableHeap( void )
+	{
+		if (s_TableHeap.GetHeapPointer() == nullptr)
+			s_TableHeap.Create(L"Sampler Table Heap");
+		return s_TableHeap.GetHeapPointer();
+	}
 }
 
 void SamplerDescriptor::Create( const D3D12_SAMPLER_DESC& Desc )
 {
 	size_t hashValue = Utility::HashState(&Desc);
-	auto iter = s_SamplerCache.find(hashValue);
-	if (iter != s_SamplerCache.end())
+
+	lock_guard<mutex> LockGuard(s_SamplerMutex);
+
+	auto range = s_SamplerCache.equal_range(hashValue);
+	for (auto iter = range.first; iter != range.second; ++iter)
 	{
-		*this = SamplerDescriptor(iter->second);
-		return;
+		if (memcmp(&iter->second.Desc, &Desc, sizeof(Desc)) == 0)
+		{
+			m_hCpuDescriptorHandle = iter->second.Handle;
+			return;
+		}
 	}
 
 	m_hCpuDescriptorHandle = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
 	g_Device->CreateSampler(&Desc, m_hCpuDescriptorHandle);
+
+	CachedSampler NewSampler = { Desc, m_hCpuDescriptorHandle };
+	s_SamplerCache.insert(make_pair(hashValue, NewSampler));
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE SamplerDescriptor::GetShaderVisibleTable( UINT NumSamplers, const D3D12_CPU_DESCRIPTOR_HANDLE Samplers[] )
+{
+	ASSERT(NumSamplers > 0);
+
+	static_assert(sizeof(D3D12_CPU_DESCRIPTOR_HANDLE) == sizeof(SIZE_T), "Handles are hashed as pointers");
+	const SIZE_T* First = &Samplers[0].ptr;
+	size_t hashValue = Utility::HashRange(First, First + NumSamplers);
+
+	lock_guard<mutex> LockGuard(s_TableMutex);
+
+	auto range = s_TableCache.equal_range(hashValue);
+	for (auto iter = range.first; iter != range.second; ++iter)
+	{
+		const vector<SIZE_T>& Cached = iter->second.Samplers;
+		if (Cached.size() == NumSamplers && memcmp(Cached.data(), First, NumSamplers * sizeof(SIZE_T)) == 0)
+			return iter->second.Table;
+	}
+
+	GetTableHeap();
+
+	// Tables are never evicted, so once the heap is full only tables that already exist can be bound
+	if (!s_TableHeap.HasAvailableSpace(NumSamplers))
+	{
+		WARN_ONCE_IF(true, "Sampler table heap is full.  New sampler tables will return a null handle.");
+		D3D12_GPU_DESCRIPTOR_HANDLE Null = { 0 };
+		return Null;
+	}
+
+	DescriptorHandle Dest = s_TableHeap.Alloc(NumSamplers);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE DestStart = Dest.GetCpuHandle();
+	g_Device->CopyDescriptors(1, &DestStart, &NumSamplers, NumSamplers, Samplers, nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+
+	CachedTable NewTable;
+	NewTable.Samplers.assign(First, First + NumSamplers);
+	NewTable.Table = Dest.GetGpuHandle();
+	s_TableCache.insert(make_pair(hashValue, NewTable));
+
+	return NewTable.Table;
+}
+
+ID3D12DescriptorHeap* SamplerDescriptor::GetShaderVisibleHeap( void )
+{
+	lock_guard<mutex> LockGuard(s_TableMutex);
+	return GetTableHeap();
+}
+
+size_t SamplerDescriptor::GetNumCachedSamplers( void )
+{
+	lock_guard<mutex> LockGuard(s_SamplerMutex);
+	return s_SamplerCache.size();
+}
+
+size_t SamplerDescriptor::GetNumCachedTables( void )
+{
+	lock_guard<mutex> LockGuard(s_TableMutex);
+	return s_TableCache.size();
+}
+
+void SamplerDescriptor::DestroyAll( void )
+{
+	{
+		lock_guard<mutex> LockGuard(s_SamplerMutex);
+		s_SamplerCache.clear();
+	}
+
+	lock_guard<mutex> LockGuard(s_TableMutex);
+	s_TableCache.clear();
+	s_TableHeap.Destroy();
 }
@@ -55,6 +55,11 @@ public:
 	}
 };
 
+// Samplers are cached by their desc, so creating the same sampler twice returns the same descriptor.  Samplers
+// that are bound together can also be placed in a shader-visible table.  Tables live in a single heap for the life
+// of the program and are looked up by the samplers they hold, so binding a set of samplers a second time finds the
+// existing table instead of copying its descriptors again.  The heap holds D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE
+// (2048) descriptors and tables are never evicted, so a program should bind a bounded set of sampler combinations.
 class SamplerDescriptor
 {
 	friend class CommandContext;
@@ -64,10 +69,24 @@ public:
 	SamplerDescriptor( D3D12_CPU_DESCRIPTOR_HANDLE hCpuDescriptor )
 		: m_hCpuDescriptorHandle(hCpuDescriptor) {}
 
+	// Safe to call from multiple threads
 	void Create( const D3D12_SAMPLER_DESC& Desc );
 
 	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuDescriptorHandle() const { return m_hCpuDescriptorHandle; }
 
+	// Find or create the table holding these samplers, in order.  The samplers should come from Create() so that
+	// equal descs share a handle and therefore a table.  To bind it, set GetShaderVisibleHeap() as the context's
+	// sampler heap and pass the table to SetDescriptorTable().  Returns a null handle (ptr == 0) when the heap has no
+	// room for a new table; the caller must then skip the draw or bind its samplers some other way.
+	static D3D12_GPU_DESCRIPTOR_HANDLE GetShaderVisibleTable( UINT NumSamplers, const D3D12_CPU_DESCRIPTOR_HANDLE Samplers[] );
+	static ID3D12DescriptorHeap* GetShaderVisibleHeap( void );
+
+	static size_t GetNumCachedSamplers( void );
+	static size_t GetNumCachedTables( void );
+
+	// Forget every sampler and table.  Call before the descriptor allocators are destroyed.
+	static void DestroyAll( void );
+
 protected:
 
 	D3D12_CPU_DESCRIPTOR_HANDLE m_hCpuDescriptorHandle;
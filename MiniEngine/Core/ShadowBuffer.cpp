@@ -55,6 +55,11 @@ void ShadowBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t He
 void ShadowBuffer::BeginRendering( GraphicsContext& Context )
 {
 	Context.ClearDepth(*this);
+	BindForRendering(Context);
+}
+
+void ShadowBuffer::BindForRendering( GraphicsContext& Context )
+{
 	Context.SetDepthStencilTarget(*this);
 	Context.SetViewportAndScissor(m_Viewport, m_Scissor);
 }
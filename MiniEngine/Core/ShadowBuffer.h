@@ -33,6 +33,9 @@ public:
 	void BeginRendering( GraphicsContext& context );
 	void EndRendering( GraphicsContext& context );
 
+	// Set the shadow buffer as the target without clearing it, for additional contexts recording the same pass
+	void BindForRendering( GraphicsContext& context );
+
 private:
 	D3D12_VIEWPORT m_Viewport;
 	D3D12_RECT m_Scissor;
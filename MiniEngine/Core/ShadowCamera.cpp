@@ -13,9 +13,21 @@
 
 #include "pch.h"
 #include "ShadowCamera.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace Math;
 
+namespace
+{
+	// Cached cascades cover this much more than their slice, so the view can move a little before they are stale
+	const float kCachePadding = 1.15f;
+
+	// Sphere fits keep this many texels between the sphere and the edges of the buffer.  Snapping can move the
+	// sphere one texel, the shadow pass leaves the edge texels empty, and the filter reaches a few texels.
+	const uint32_t kEdgeTexels = 6;
+}
+
 void GameCore::ShadowCamera::UpdateMatrix(
 	Vector3 LightDirection, Vector3 ShadowCenter, Vector3 ShadowBounds,
 	uint32_t BufferWidth, uint32_t BufferHeight, uint32_t BufferPrecision )
@@ -46,3 +58,154 @@ void GameCore::ShadowCamera::UpdateMatrix(
 	// Transform from clip space to texture space
 	m_ShadowMatrix =  Matrix4( AffineTransform( Matrix3::MakeScale( 0.5f, -0.5f, 1.0f ), Vector3(0.5f, 0.5f, 0.0f) ) ) * m_ViewProjMatrix;
 }
+
+void GameCore::ShadowCamera::UpdateMatrix( Vector3 LightDirection, BoundingSphere ShadowBounds, float CasterDistance,
+	uint32_t BufferSize, uint32_t BufferPrecision )
+{
+	ASSERT(BufferSize > kEdgeTexels * 2);
+	float Radius = ShadowBounds.GetRadius();
+	float Diameter = Radius * 2.0f * BufferSize / (float)(BufferSize - kEdgeTexels * 2);
+	Vector3 FarCenter = ShadowBounds.GetCenter() + Normalize(LightDirection) * Radius;
+
+	UpdateMatrix( LightDirection, FarCenter, Vector3(Diameter, Diameter, Diameter + CasterDistance),
+		BufferSize, BufferSize, BufferPrecision );
+}
+
+GameCore::CascadedShadowCamera::CascadedShadowCamera()
+	: m_LightDirection(kZero), m_NumCascades(kMaxCascades), m_Scheme(kPracticalSplits), m_Lambda(0.75f),
+	m_FirstCachedCascade(kMaxCascades), m_UpdateInterval(1), m_FrameIndex(0), m_MaxDistance(0.0f),
+	m_CasterDistance(0.0f), m_CascadeSize(0), m_BufferPrecision(0), m_Valid(false)
+{
+	for (uint32_t i = 0; i < kMaxCascades; ++i)
+	{
+		m_CascadeScale[i] = Vector3(kOne);
+		m_CascadeOffset[i] = Vector3(kZero);
+		m_NeedsRender[i] = false;
+	}
+}
+
+void GameCore::CascadedShadowCamera::SetCascadeCount( uint32_t NumCascades )
+{
+	ASSERT(NumCascades > 0 && NumCascades <= kMaxCascades);
+	if (NumCascades != m_NumCascades)
+	{
+		m_NumCascades = NumCascades;
+		m_Valid = false;
+	}
+}
+
+void GameCore::CascadedShadowCamera::SetSplitScheme( CascadeSplitScheme Scheme, float Lambda )
+{
+	if (Scheme != m_Scheme || Lambda != m_Lambda)
+	{
+		m_Scheme = Scheme;
+		m_Lambda = Lambda;
+		m_Valid = false;
+	}
+}
+
+void GameCore::CascadedShadowCamera::SetCaching( uint32_t FirstCachedCascade, uint32_t UpdateInterval )
+{
+	ASSERT(UpdateInterval > 0);
+	m_FirstCachedCascade = FirstCachedCascade;
+	m_UpdateInterval = UpdateInterval;
+}
+
+void GameCore::CascadedShadowCamera::ComputeSplits( CascadeSplitScheme Scheme, float Lambda, float NearClip,
+	float MaxDistance, uint32_t NumCascades, float* Splits )
+{
+	ASSERT(NearClip > 0.0f && MaxDistance > NearClip && NumCascades > 0);
+
+	Splits[0] = NearClip;
+	for (uint32_t i = 1; i < NumCascades; ++i)
+	{
+		float Fraction = (float)i / (float)NumCascades;
+		float Uniform = NearClip + (MaxDistance - NearClip) * Fraction;
+		float Logarithmic = NearClip * powf(MaxDistance / NearClip, Fraction);
+
+		switch (Scheme)
+		{
+		case kUniformSplits:		Splits[i] = Uniform; break;
+		case kLogarithmicSplits:	Splits[i] = Logarithmic; break;
+		default:					Splits[i] = Uniform + (Logarithmic - Uniform) * Lambda; break;
+		}
+	}
+	Splits[NumCascades] = MaxDistance;
+}
+
+BoundingSphere GameCore::CascadedShadowCamera::ComputeSliceBounds( const Camera& ViewCamera, float SliceNear, float SliceFar )
+{
+	// The corners of a slice at distance d are d * K from the view axis
+	float TanV = tanf(ViewCamera.GetFOV() * 0.5f);
+	float TanH = TanV / ViewCamera.GetAspectRatio();
+	float K2 = TanH * TanH + TanV * TanV;
+
+	// The center which is equally far from the near and far corners, unless that lies beyond the far plane, in
+	// which case the far corners alone determine the sphere
+	float Center = std::min((SliceNear + SliceFar) * (1.0f + K2) * 0.5f, SliceFar);
+	float NearReach = (Center - SliceNear) * (Center - SliceNear) + SliceNear * SliceNear * K2;
+	float FarReach = (SliceFar - Center) * (SliceFar - Center) + SliceFar * SliceFar * K2;
+	float Radius = sqrtf(std::max(NearReach, FarReach));
+
+	return BoundingSphere(ViewCamera.GetPosition() + ViewCamera.GetForwardVec() * Center, Radius);
+}
+
+void GameCore::CascadedShadowCamera::Update( Vector3 LightDirection, const Camera& ViewCamera, float MaxDistance,
+	float CasterDistance, uint32_t CascadeSize, uint32_t BufferPrecision )
+{
+	bool RefitAll = !m_Valid || MaxDistance != m_MaxDistance || CasterDistance != m_CasterDistance ||
+		CascadeSize != m_CascadeSize || BufferPrecision != m_BufferPrecision ||
+		(float)LengthSquare(LightDirection - m_LightDirection) != 0.0f;
+
+	m_LightDirection = LightDirection;
+	m_MaxDistance = MaxDistance;
+	m_CasterDistance = CasterDistance;
+	m_CascadeSize = CascadeSize;
+	m_BufferPrecision = BufferPrecision;
+	m_Valid = true;
+
+	ComputeSplits(m_Scheme, m_Lambda, ViewCamera.GetNearClip(), MaxDistance, m_NumCascades, m_Splits);
+
+	++m_FrameIndex;
+
+	for (uint32_t i = 0; i < m_NumCascades; ++i)
+	{
+		BoundingSphere Bounds = ComputeSliceBounds(ViewCamera, m_Splits[i], m_Splits[i + 1]);
+
+		// Cached cascades take turns refitting so that no more than one is redrawn on most frames
+		bool Cached = i >= m_FirstCachedCascade && m_UpdateInterval > 1;
+		bool Refit = RefitAll || !Cached || (m_FrameIndex + i) % m_UpdateInterval == 0;
+
+		if (!Refit)
+		{
+			float Reach = Length(Bounds.GetCenter() - m_FitBounds[i].GetCenter()) + Bounds.GetRadius();
+			Refit = Reach > (float)m_FitBounds[i].GetRadius();
+		}
+
+		m_NeedsRender[i] = Refit;
+		if (!Refit)
+			continue;
+
+		if (Cached)
+			Bounds = BoundingSphere(Bounds.GetCenter(), Bounds.GetRadius() * kCachePadding);
+
+		m_FitBounds[i] = Bounds;
+		m_Cascades[i].UpdateMatrix(LightDirection, Bounds, CasterDistance, CascadeSize, BufferPrecision);
+	}
+
+	// Every cascade shares the light's orientation, so the mapping from one cascade's shadow coordinates to
+	// another's is a scale and offset per axis.  Recover it from two points whose coordinates differ in x, y and z.
+	const ShadowCamera& First = m_Cascades[0];
+	Vector3 P0 = First.GetPosition();
+	Vector3 P1 = P0 + First.GetRightVec() + First.GetUpVec() + First.GetForwardVec();
+	Vector3 A0 = Vector3(First.GetShadowMatrix() * P0);
+	Vector3 B0 = Vector3(First.GetShadowMatrix() * P1);
+
+	for (uint32_t i = 0; i < m_NumCascades; ++i)
+	{
+		Vector3 A = Vector3(m_Cascades[i].GetShadowMatrix() * P0);
+		Vector3 B = Vector3(m_Cascades[i].GetShadowMatrix() * P1);
+		m_CascadeScale[i] = (B - A) / (B0 - A0);
+		m_CascadeOffset[i] = A - A0 * m_CascadeScale[i];
+	}
+}
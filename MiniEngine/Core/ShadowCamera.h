@@ -34,6 +34,13 @@ namespace GameCore
 			uint32_t BufferPrecision	// Bit depth of shadow buffer--usually 16 or 24
 			);
 
+		// Fits a square shadow buffer to a sphere.  The shadowed region is extended by CasterDistance toward
+		// the light so that objects outside the sphere can still cast shadows into it, and a few texels of margin
+		// are kept around the sphere.  As long as the radius doesn't change, texels stay put in world space
+		// however the sphere moves.
+		void UpdateMatrix( Vector3 LightDirection, BoundingSphere ShadowBounds, float CasterDistance,
+			uint32_t BufferSize, uint32_t BufferPrecision );
+
 		// Used to transform world space to texture space for shadow sampling
 		const Matrix4& GetShadowMatrix() const { return m_ShadowMatrix; }
 
@@ -42,4 +49,93 @@ namespace GameCore
 		Matrix4 m_ShadowMatrix;
 	};
 
+	enum CascadeSplitScheme
+	{
+		kUniformSplits,			// Equal depth ranges
+		kLogarithmicSplits,		// Equal ratios of far to near, which keeps texels per pixel roughly constant
+		kPracticalSplits		// A blend of the two
+	};
+
+	// Splits the view frustum into depth slices and gives each one its own shadow map.  Each cascade is fit to
+	// a bounding sphere of its slice, whose size depends only on the slice distances and the camera's field of
+	// view, so the cascades don't change scale as the camera turns, and are snapped to whole texels so they don't
+	// shimmer as it moves.
+	//
+	// Distant cascades can be cached:  they are refit and redrawn only every few frames, in turn, unless the
+	// light turns or the view moves far enough to leave the region they cover.  Cached cascades are fit to
+	// slightly padded spheres to give the view room to move.
+	class CascadedShadowCamera
+	{
+	public:
+		static const uint32_t kMaxCascades = 4;
+
+		CascadedShadowCamera();
+
+		void SetCascadeCount( uint32_t NumCascades );
+		void SetSplitScheme( CascadeSplitScheme Scheme, float Lambda = 0.75f );
+
+		// Cascades from FirstCachedCascade on are refit every UpdateInterval frames.  An interval of one
+		// refits every cascade every frame.
+		void SetCaching( uint32_t FirstCachedCascade, uint32_t UpdateInterval );
+
+		// Forces every cascade to be refit and redrawn on the next update, e.g. when the shadow buffer is lost
+		void Invalidate( void ) { m_Valid = false; }
+
+		// Call once per frame, after the view camera has been updated
+		void Update(
+			Vector3 LightDirection,		// Direction parallel to light, in direction of travel
+			const Camera& ViewCamera,	// The camera whose view is being shadowed
+			float MaxDistance,			// Distance from the camera at which the last cascade ends
+			float CasterDistance,		// How far beyond each slice toward the light to look for casters
+			uint32_t CascadeSize,		// Width and height of each cascade's shadow buffer
+			uint32_t BufferPrecision	// Bit depth of shadow buffer--usually 16 or 24
+			);
+
+		uint32_t GetCascadeCount( void ) const { return m_NumCascades; }
+		const ShadowCamera& GetCascade( uint32_t Index ) const { return m_Cascades[Index]; }
+
+		// True when the cascade was refit by the last update and has to be redrawn
+		bool NeedsRender( uint32_t Index ) const { return m_NeedsRender[Index]; }
+
+		// View distances bounding the slices.  Slice i runs from split i to split i + 1.
+		float GetSplitDistance( uint32_t Index ) const { return m_Splits[Index]; }
+
+		// Shadow coordinates in cascade i are those in cascade 0 times its scale plus its offset, so only the
+		// first cascade's shadow matrix needs to be applied per vertex.
+		Vector3 GetCascadeScale( uint32_t Index ) const { return m_CascadeScale[Index]; }
+		Vector3 GetCascadeOffset( uint32_t Index ) const { return m_CascadeOffset[Index]; }
+
+		// Fills Splits[0] through Splits[NumCascades] with the near clip, the split distances, and MaxDistance.
+		// Lambda blends the practical scheme from uniform at 0 to logarithmic at 1.
+		static void ComputeSplits( CascadeSplitScheme Scheme, float Lambda, float NearClip, float MaxDistance,
+			uint32_t NumCascades, float* Splits );
+
+		// The smallest sphere around the part of the camera's frustum between two view distances
+		static BoundingSphere ComputeSliceBounds( const Camera& ViewCamera, float SliceNear, float SliceFar );
+
+	private:
+
+		ShadowCamera m_Cascades[kMaxCascades];
+		BoundingSphere m_FitBounds[kMaxCascades];		// The sphere each cascade was last fit to
+		Vector3 m_CascadeScale[kMaxCascades];
+		Vector3 m_CascadeOffset[kMaxCascades];
+		Vector3 m_LightDirection;
+		float m_Splits[kMaxCascades + 1];
+		bool m_NeedsRender[kMaxCascades];
+
+		uint32_t m_NumCascades;
+		CascadeSplitScheme m_Scheme;
+		float m_Lambda;
+		uint32_t m_FirstCachedCascade;
+		uint32_t m_UpdateInterval;
+		uint32_t m_FrameIndex;
+
+		// Settings the cascades were last fit with.  Changing any of them refits everything.
+		float m_MaxDistance;
+		float m_CasterDistance;
+		uint32_t m_CascadeSize;
+		uint32_t m_BufferPrecision;
+		bool m_Valid;
+	};
+
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  The minimum and maximum of the samples recorded over the last N frames, in constant time per
+// sample.  Each extreme is tracked with a monotonic queue:  a new sample evicts every queued sample it beats,
+// since none of them can be the extreme again while the new one is in the window, and samples leave the
+// front as they age out.  The queues live in fixed rings, so recording a sample never allocates.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class SlidingWindowMinMax
+{
+public:
+	// Window is in frames.  MaxSamplesPerFrame bounds how many samples may be recorded with the same frame.
+	SlidingWindowMinMax( uint32_t Window = 1, uint32_t MaxSamplesPerFrame = 1 )
+	{
+		Reset(Window, MaxSamplesPerFrame);
+	}
+
+	void Reset( uint32_t Window, uint32_t MaxSamplesPerFrame )
+	{
+		ASSERT(Window > 0 && MaxSamplesPerFrame > 0);
+		m_Window = Window;
+		m_MaxQueue.Reset(Window * MaxSamplesPerFrame);
+		m_MinQueue.Reset(Window * MaxSamplesPerFrame);
+	}
+
+	void Clear( void )
+	{
+		m_MaxQueue.Clear();
+		m_MinQueue.Clear();
+	}
+
+	// Frames must not go backward from one call to the next
+	void AddSample( uint32_t Frame, float Value )
+	{
+		m_MaxQueue.Push(Frame, Value, m_Window, true);
+		m_MinQueue.Push(Frame, Value, m_Window, false);
+	}
+
+	// Let samples older than the window expire without recording a new one
+	void Advance( uint32_t Frame )
+	{
+		m_MaxQueue.Expire(Frame, m_Window);
+		m_MinQueue.Expire(Frame, m_Window);
+	}
+
+	bool IsEmpty( void ) const { return m_MaxQueue.IsEmpty(); }
+
+	// Zero when the window is empty
+	float GetMax( void ) const { return m_MaxQueue.Front(); }
+	float GetMin( void ) const { return m_MinQueue.Front(); }
+
+private:
+	class MonotonicQueue
+	{
+	public:
+		void Reset( uint32_t Capacity )
+		{
+			m_Frames.resize(Capacity);
+			m_Values.resize(Capacity);
+			Clear();
+		}
+
+		void Clear( void )
+		{
+			m_Head = 0;
+			m_Count = 0;
+		}
+
+		bool IsEmpty( void ) const { return m_Count == 0; }
+
+		float Front( void ) const { return m_Count > 0 ? m_Values[m_Head] : 0.0f; }
+
+		void Expire( uint32_t Frame, uint32_t Window )
+		{
+			// Unsigned differences stay correct when the frame counter wraps
+			while (m_Count > 0 && Frame - m_Frames[m_Head] >= Window)
+			{
+				m_Head = Wrap(m_Head + 1);
+				--m_Count;
+			}
+		}
+
+		void Push( uint32_t Frame, float Value, uint32_t Window, bool KeepMax )
+		{
+			Expire(Frame, Window);
+
+			while (m_Count > 0)
+			{
+				float Back = m_Values[Wrap(m_Head + m_Count - 1)];
+				if (KeepMax ? Back > Value : Back < Value)
+					break;
+				--m_Count;
+			}
+
+			ASSERT(m_Count < m_Values.size(), "More samples in one frame than the window was sized for");
+			uint32_t Tail = Wrap(m_Head + m_Count);
+			m_Frames[Tail] = Frame;
+			m_Values[Tail] = Value;
+			++m_Count;
+		}
+
+	private:
+		uint32_t Wrap( uint32_t Index ) const
+		{
+			return Index < (uint32_t)m_Values.size() ? Index : Index - (uint32_t)m_Values.size();
+		}
+
+		std::vector<uint32_t> m_Frames;
+		std::vector<float> m_Values;
+		uint32_t m_Head;
+		uint32_t m_Count;
+	};
+
+	uint32_t m_Window;
+	MonotonicQueue m_MaxQueue;
+	MonotonicQueue m_MinQueue;
+};
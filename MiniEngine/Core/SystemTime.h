@@ -42,6 +42,11 @@ public:
 		return TicksToSeconds(tick2 - tick1);
 	}
 
+	static inline int64_t SecondsToTicks( double Seconds )
+	{
+		return (int64_t)(Seconds / sm_CpuTickDelta);
+	}
+
 private:
 
 	// The amount of time that elapses between ticks of the performance counter
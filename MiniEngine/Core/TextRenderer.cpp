@@ -29,7 +29,7 @@
 #include <string>
 #include <cstdio>
 #include <memory>
-#include <malloc.h>
+#include <algorithm>
 
 using namespace Graphics;
 using namespace Math;
@@ -50,11 +50,9 @@ namespace TextRenderer
 			m_BorderSize = 0;
 			m_TextureWidth = 0;
 			m_TextureHeight = 0;
-		}
 
-		~Font()
-		{
-			m_Dictionary.clear();
+			for (uint32_t i = 0; i < kDenseGlyphRange; ++i)
+				m_DenseGlyphIndex[i] = kMissingGlyph;
 		}
 
 		void LoadFromBinary( const wchar_t* fontName, const uint8_t* pBinary, const size_t binarySize )
@@ -93,8 +91,28 @@ namespace TextRenderer
 			const Glyph* glyphData = (Glyph*)(wcharList + NumGlyphs);
 			const void* texelData = glyphData + NumGlyphs;
 
+			m_Glyphs.assign(glyphData, glyphData + NumGlyphs);
+
 			for (uint16_t i = 0; i < NumGlyphs; ++i)
-				m_Dictionary[wcharList[i]] = glyphData[i];
+			{
+				if (wcharList[i] < kDenseGlyphRange)
+					m_DenseGlyphIndex[wcharList[i]] = i;
+				else
+					m_SparseGlyphIndex.push_back(make_pair(wcharList[i], i));
+			}
+
+			// Sort the rest for binary search.  If a character is listed twice, the last entry wins.
+			stable_sort(m_SparseGlyphIndex.begin(), m_SparseGlyphIndex.end(),
+				[]( const pair<wchar_t, uint16_t>& A, const pair<wchar_t, uint16_t>& B ) { return A.first < B.first; });
+			size_t NumUnique = 0;
+			for (size_t i = 0; i < m_SparseGlyphIndex.size(); ++i)
+			{
+				if (NumUnique > 0 && m_SparseGlyphIndex[NumUnique - 1].first == m_SparseGlyphIndex[i].first)
+					m_SparseGlyphIndex[NumUnique - 1] = m_SparseGlyphIndex[i];
+				else
+					m_SparseGlyphIndex[NumUnique++] = m_SparseGlyphIndex[i];
+			}
+			m_SparseGlyphIndex.resize(NumUnique);
 
 			m_Texture.Create( textureWidth, textureHeight, DXGI_FORMAT_R8_SNORM, texelData );
 
@@ -126,8 +144,15 @@ namespace TextRenderer
 
 		const Glyph* GetGlyph( wchar_t ch ) const
 		{
-			auto it = m_Dictionary.find( ch );
-			return it == m_Dictionary.end() ? nullptr : &it->second;
+			if (ch < kDenseGlyphRange)
+			{
+				uint16_t Index = m_DenseGlyphIndex[ch];
+				return Index == kMissingGlyph ? nullptr : &m_Glyphs[Index];
+			}
+
+			auto it = lower_bound(m_SparseGlyphIndex.begin(), m_SparseGlyphIndex.end(), ch,
+				[]( const pair<wchar_t, uint16_t>& Entry, wchar_t Key ) { return Entry.first < Key; });
+			return (it == m_SparseGlyphIndex.end() || it->first != ch) ? nullptr : &m_Glyphs[it->second];
 		}
 
 		// Get the texel height of the font in 12.4 fixed point
@@ -160,7 +185,15 @@ namespace TextRenderer
 		uint16_t m_TextureWidth;
 		uint16_t m_TextureHeight;
 		Texture m_Texture;
-		map<wchar_t, Glyph> m_Dictionary;
+
+		// Characters below this code point (Latin, Greek, Cyrillic and the like) are found by direct index.  The
+		// rest of the Basic Multilingual Plane is binary searched.
+		static const wchar_t kDenseGlyphRange = 0x800;
+		static const uint16_t kMissingGlyph = 0xFFFF;
+
+		vector<Glyph> m_Glyphs;
+		uint16_t m_DenseGlyphIndex[kDenseGlyphRange];
+		vector<pair<wchar_t, uint16_t>> m_SparseGlyphIndex;		// Sorted by character
 	};
 
 	map< wstring, unique_ptr<Font> > LoadedFonts;
@@ -237,6 +270,10 @@ TextContext::TextContext( GraphicsContext& CmdContext, float ViewWidth, float Vi
 {
 	m_HDR = FALSE;
 	m_CurrentFont = nullptr;
+	m_BatchVerts = nullptr;
+	m_BatchGpuAddress = 0;
+	m_BatchSize = 0;
+	m_BatchCapacity = 0;
 	m_ViewWidth = ViewWidth;
 	m_ViewHeight = ViewHeight;
 
@@ -294,6 +331,7 @@ void TextContext::EnableDropShadow(bool enable)
 
 	m_EnableShadow = enable;
 
+	Flush();
 	m_Context.SetPipelineState( m_EnableShadow ? TextRenderer::s_ShadowPSO[m_HDR] : TextRenderer::s_TextPSO[m_HDR] );
 }
 
@@ -326,6 +364,7 @@ float TextContext::GetVerticalSpacing( void )
 
 void TextContext::Begin( bool EnableHDR )
 {
+	Flush();
 	ResetSettings();
 
 	m_HDR = (BOOL)EnableHDR;
@@ -405,6 +444,8 @@ void TextContext::SetViewSize( float ViewWidth, float ViewHeight )
 
 void TextContext::End( void )
 {
+	Flush();
+
 	m_VSConstantBufferIsStale = true;
 	m_PSConstantBufferIsStale = true;
 	m_TextureIsStale = true;
@@ -414,6 +455,10 @@ void TextContext::SetRenderState( void )
 {
 	WARN_ONCE_IF(nullptr == m_CurrentFont, "Attempted to draw text without a font");
 
+	// Batched glyphs must be drawn with the constants and texture they were written for
+	if (m_VSConstantBufferIsStale || m_PSConstantBufferIsStale || m_TextureIsStale)
+		Flush();
+
 	if (m_VSConstantBufferIsStale)
 	{
 		m_Context.SetDynamicConstantBufferView(0, sizeof(m_VSParams), &m_VSParams);
@@ -434,7 +479,8 @@ void TextContext::SetRenderState( void )
 }
 
 // These are made with templates to handle char and wchar_t simultaneously.
-UINT TextContext::FillVertexBuffer( TextVert volatile* verts, const char* str, size_t stride, size_t slen )
+template <typename CharType>
+UINT TextContext::FillVertexBuffer( TextVert* verts, const CharType* str, size_t slen )
 {
 	UINT charsDrawn = 0;
 
@@ -445,11 +491,9 @@ UINT TextContext::FillVertexBuffer( TextVert volatile* verts, const char* str, s
 
 	const uint16_t texelHeight = m_CurrentFont->GetHeight();
 
-	const char* iter = str;
 	for (size_t i = 0; i < slen; ++i)
 	{
-		wchar_t wc = (stride == 2 ? *(wchar_t*)iter : *iter);
-		iter += stride;
+		wchar_t wc = (wchar_t)str[i];
 
 		// Terminate on null character (this really shouldn't happen with string or wstring)
 		if (wc == L'\0')
@@ -469,13 +513,15 @@ UINT TextContext::FillVertexBuffer( TextVert volatile* verts, const char* str, s
 		if (nullptr == gi)
 			continue;
 
-		verts->X = curX + (float)gi->bearing * UVtoPixel;
-		verts->Y = curY;
-		verts->U = gi->x;
-		verts->V = gi->y;
-		verts->W = gi->w;
-		verts->H = texelHeight;
-		++verts;
+		// Build the vertex locally so that the write-combined upload memory sees one whole 16-byte store
+		TextVert Vert;
+		Vert.X = curX + (float)gi->bearing * UVtoPixel;
+		Vert.Y = curY;
+		Vert.U = gi->x;
+		Vert.V = gi->y;
+		Vert.W = gi->w;
+		Vert.H = texelHeight;
+		*verts++ = Vert;
 
 		// Advance the cursor position
 		curX += (float)gi->advance * UVtoPixel;
@@ -488,38 +534,61 @@ UINT TextContext::FillVertexBuffer( TextVert volatile* verts, const char* str, s
 	return charsDrawn;
 }
 
-void TextContext::DrawString( const std::wstring& str )
+template <typename CharType>
+void TextContext::DrawStringInternal( const CharType* str, size_t slen )
 {
-	SetRenderState();
+	if (slen == 0)
+		return;
 
-	void* stackMem = _malloca((str.size() + 1) * 16);
-	TextVert* vbPtr = Math::AlignUp((TextVert*)stackMem, 16);
-	UINT primCount = FillVertexBuffer(vbPtr, (char*)str.c_str(), 2, str.size());
+	SetRenderState();
 
-	if (primCount > 0)
+	// Each character writes at most one vertex.  When the batch cannot hold the whole string, draw what it has
+	// and reserve more upload memory.  Reserving a few strings' worth at a time keeps short strings cheap.
+	if (m_BatchCapacity - m_BatchSize < slen)
 	{
-		m_Context.SetDynamicVB(0, primCount, sizeof(TextVert), vbPtr);
-		m_Context.DrawInstanced( 4, primCount );
+		const size_t kMinBatchCapacity = 256;
+
+		Flush();
+
+		size_t Capacity = Max(slen, kMinBatchCapacity);
+		DynAlloc BatchMemory = m_Context.ReserveUploadMemory(Capacity * sizeof(TextVert));
+		m_BatchVerts = (TextVert*)BatchMemory.DataPtr;
+		m_BatchGpuAddress = BatchMemory.GpuAddress;
+		m_BatchSize = 0;
+		m_BatchCapacity = (UINT)Capacity;
 	}
 
-	_freea(stackMem);
+	m_BatchSize += FillVertexBuffer(m_BatchVerts + m_BatchSize, str, slen);
 }
 
-void TextContext::DrawString( const std::string& str )
+void TextContext::Flush( void )
 {
-	SetRenderState();
+	if (m_BatchSize == 0)
+		return;
 
-	void* stackMem = _malloca((str.size() + 1) * 16);
-	TextVert* vbPtr = Math::AlignUp((TextVert*)stackMem, 16);
-	UINT primCount = FillVertexBuffer(vbPtr, (char*)str.c_str(), 1, str.size());
+	D3D12_VERTEX_BUFFER_VIEW VBView;
+	VBView.BufferLocation = m_BatchGpuAddress;
+	VBView.SizeInBytes = m_BatchSize * sizeof(TextVert);
+	VBView.StrideInBytes = sizeof(TextVert);
 
-	if (primCount > 0)
-	{
-		m_Context.SetDynamicVB(0, primCount, sizeof(TextVert), vbPtr);
-		m_Context.DrawInstanced( 4, primCount );
-	}
+	m_Context.SetVertexBuffer(0, VBView);
+	m_Context.DrawInstanced(4, m_BatchSize);
 
-	_freea(stackMem);
+	// The rest of the reserved memory starts the next batch
+	m_BatchVerts += m_BatchSize;
+	m_BatchGpuAddress += m_BatchSize * sizeof(TextVert);
+	m_BatchCapacity -= m_BatchSize;
+	m_BatchSize = 0;
+}
+
+void TextContext::DrawString( const std::wstring& str )
+{
+	DrawStringInternal(str.c_str(), str.size());
+}
+
+void TextContext::DrawString( const std::string& str )
+{
+	DrawStringInternal(str.c_str(), str.size());
 }
 
 void TextContext::DrawFormattedString( const wchar_t* format, ... )
@@ -527,8 +596,9 @@ void TextContext::DrawFormattedString( const wchar_t* format, ... )
 	wchar_t buffer[256];
 	va_list ap;
 	va_start(ap, format);
-	vswprintf( buffer, 256, format, ap );
-	DrawString( wstring(buffer) );
+	int len = vswprintf( buffer, 256, format, ap );
+	va_end(ap);
+	DrawStringInternal( buffer, len < 0 ? wcslen(buffer) : (size_t)len );
 }
 
 void TextContext::DrawFormattedString( const char* format, ... )
@@ -536,6 +606,7 @@ void TextContext::DrawFormattedString( const char* format, ... )
 	char buffer[256];
 	va_list ap;
 	va_start(ap, format);
-	vsprintf_s( buffer, 256, format, ap );
-	DrawString( string(buffer) );
+	int len = vsprintf_s( buffer, 256, format, ap );
+	va_end(ap);
+	DrawStringInternal( buffer, len < 0 ? strlen(buffer) : (size_t)len );
 }
@@ -37,8 +37,10 @@ class TextContext
 {
 public:
 	TextContext( GraphicsContext& CmdContext, float CanvasWidth = 1920.0f, float CanvasHeight = 1080.0f );
+	~TextContext() { Flush(); }
 
-	GraphicsContext& GetCommandContext() const { return m_Context; }
+	// Anything recorded on the command context must come after the text drawn so far, so pending text is flushed
+	GraphicsContext& GetCommandContext() { Flush(); return m_Context; }
 
 	// Put settings back to the defaults.
 	void ResetSettings( void );
@@ -90,10 +92,14 @@ public:
 	void Begin( bool EnableHDR = false );
 	void End( void );
 
-	// Draw a string
+	// Draw a string.  Consecutive strings drawn with the same font and settings are batched into one draw,
+	// which is issued when a setting changes, on End(), or when the command context is requested.
 	void DrawString( const std::wstring& str );
 	void DrawString( const std::string& str );
 
+	// Issue the draw for any batched text
+	void Flush( void );
+
 	// A more powerful function which formats text like printf().  Very slow by comparison, so use it
 	// only if you're going to format text anyway.
 	void DrawFormattedString( const wchar_t* format, ... );
@@ -127,9 +133,10 @@ private:
 		uint16_t U, V, W, H;	// Upper-left glyph UV and the width in texture space
 	};
 
-	UINT FillVertexBuffer( TextVert volatile* verts, const char* str, size_t stride, size_t slen );
-	void DrawStringInternal( const std::string& str );
-	void DrawStringInternal( const std::wstring& str );
+	template <typename CharType>
+	UINT FillVertexBuffer( TextVert* verts, const CharType* str, size_t slen );
+	template <typename CharType>
+	void DrawStringInternal( const CharType* str, size_t slen );
 
 	GraphicsContext& m_Context;
 	const TextRenderer::Font* m_CurrentFont;
@@ -148,4 +155,10 @@ private:
 	float m_ShadowOffsetX;			// Percentage of the font's TextSize should the shadow be offset
 	float m_ShadowOffsetY;			// Percentage of the font's TextSize should the shadow be offset
 	BOOL m_HDR;
+
+	// Glyphs are written straight into upload memory.  Those not yet drawn form the current batch.
+	TextVert* m_BatchVerts;
+	D3D12_GPU_VIRTUAL_ADDRESS m_BatchGpuAddress;
+	UINT m_BatchSize;
+	UINT m_BatchCapacity;
 };
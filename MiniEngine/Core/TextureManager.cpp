@@ -16,20 +16,53 @@
 #include "TextureManager.h"
 #include "FileUtility.h"
 #include "DDSTextureLoader.h"
+#include "dds.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
 #include "GraphicsCore.h"
 #include "CommandContext.h"
+#include "JobSystem.h"
 #include <map>
-#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
 
 using namespace std;
 using namespace Graphics;
 
+// Textures are only loaded once in a while, so they share one signal for finished loads
+static mutex s_LoadMutex;
+static condition_variable s_LoadFinished;
+
 static UINT BytesPerPixel( DXGI_FORMAT Format )
 {
 	return (UINT)BitsPerPixel(Format) / 8;
 };
 
+static void GetSurfacePitch( DXGI_FORMAT Format, size_t Width, size_t Height, D3D12_SUBRESOURCE_DATA& Surface )
+{
+	if (BlockCompression::IsSupported(Format))
+	{
+		Surface.RowPitch = (Width + 3) / 4 * BlockCompression::GetBlockSize(Format);
+		Surface.SlicePitch = Surface.RowPitch * ((Height + 3) / 4);
+	}
+	else
+	{
+		Surface.RowPitch = Width * BytesPerPixel(Format);
+		Surface.SlicePitch = Surface.RowPitch * Height;
+	}
+}
+
 void Texture::Create( size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitialData )
+{
+	D3D12_SUBRESOURCE_DATA texResource;
+	texResource.pData = InitialData;
+	GetSurfacePitch(Format, Width, Height, texResource);
+
+	Create(Width, Height, Format, 1, &texResource);
+}
+
+void Texture::Create( size_t Width, size_t Height, DXGI_FORMAT Format, UINT NumMips, D3D12_SUBRESOURCE_DATA InitData[] )
 {
 	m_UsageState = D3D12_RESOURCE_STATE_COMMON;
 
@@ -38,7 +71,7 @@ void Texture::Create( size_t Width, size_t Height, DXGI_FORMAT Format, const voi
 	texDesc.Width = Width;
 	texDesc.Height = (UINT)Height;
 	texDesc.DepthOrArraySize = 1;
-	texDesc.MipLevels = 1;
+	texDesc.MipLevels = (UINT16)NumMips;
 	texDesc.Format = Format;
 	texDesc.SampleDesc.Count = 1;
 	texDesc.SampleDesc.Quality = 0;
@@ -57,19 +90,15 @@ void Texture::Create( size_t Width, size_t Height, DXGI_FORMAT Format, const voi
 
 	m_pResource->SetName(L"Texture");
 
-	D3D12_SUBRESOURCE_DATA texResource;
-	texResource.pData = InitialData;
-	texResource.RowPitch = Width * BytesPerPixel(Format);
-	texResource.SlicePitch = texResource.RowPitch * Height;
-
-	CommandContext::InitializeTexture(*this, 1, &texResource);
+	CommandContext::InitializeTexture(*this, NumMips, InitData);
 
 	if (m_hCpuDescriptorHandle.ptr == ~0ull)
 		m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 	g_Device->CreateShaderResourceView(m_pResource.Get(), nullptr, m_hCpuDescriptorHandle);
 }
 
-void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
+// Expand a 24- or 32-bit uncompressed TGA to RGBA8
+static vector<uint32_t> DecodeTGA( const void* _filePtr, uint16_t& imageWidth, uint16_t& imageHeight )
 {
 	const uint8_t* filePtr = (const uint8_t*)_filePtr;
 
@@ -81,17 +110,17 @@ void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
 	// Ignore another 9 bytes
 	filePtr += 9;
 
-	uint16_t imageWidth = *(uint16_t*)filePtr;
+	imageWidth = *(uint16_t*)filePtr;
 	filePtr += sizeof(uint16_t);
-	uint16_t imageHeight = *(uint16_t*)filePtr;
+	imageHeight = *(uint16_t*)filePtr;
 	filePtr += sizeof(uint16_t);
 	uint8_t bitCount = *filePtr++;
 
 	// Ignore another byte
 	filePtr++;
 
-	uint32_t* formattedData = new uint32_t[imageWidth * imageHeight];
-	uint32_t* iter = formattedData;
+	vector<uint32_t> formattedData(imageWidth * imageHeight);
+	uint32_t* iter = formattedData.data();
 
 	uint8_t numChannels = bitCount / 8;
 	uint32_t numBytes = imageWidth * imageHeight * numChannels;
@@ -116,9 +145,126 @@ void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
 		break;
 	}
 
-	Create( imageWidth, imageHeight, sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, formattedData );
+	return formattedData;
+}
+
+// Decode a TGA and filter its mip chain
+static vector<MipGenerator::MipLevel> LoadTGAMipChain( const void* filePtr, bool sRGB, MipGenerator::FilterType MipFilter )
+{
+	vector<MipGenerator::MipLevel> Chain(1);
+
+	uint16_t imageWidth, imageHeight;
+	Chain[0].Pixels = DecodeTGA(filePtr, imageWidth, imageHeight);
+	Chain[0].Width = imageWidth;
+	Chain[0].Height = imageHeight;
+
+	if (imageWidth > 0 && imageHeight > 0)
+		MipGenerator::GenerateMipChain(Chain, MipFilter, sRGB);
+
+	return Chain;
+}
+
+static void CreateFromMipChain( Texture& Tex, const vector<MipGenerator::MipLevel>& Chain, bool sRGB )
+{
+	vector<D3D12_SUBRESOURCE_DATA> Subresources(Chain.size());
+	for (size_t i = 0; i < Chain.size(); ++i)
+	{
+		Subresources[i].pData = Chain[i].Pixels.data();
+		Subresources[i].RowPitch = Chain[i].Width * sizeof(uint32_t);
+		Subresources[i].SlicePitch = Subresources[i].RowPitch * Chain[i].Height;
+	}
+
+	Tex.Create( Chain[0].Width, Chain[0].Height, sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM,
+		(UINT)Subresources.size(), Subresources.data() );
+}
+
+// Write a 2D texture and its mips with a DX10 header.  sRGB is left to the loader, which applies it on request.
+static void WriteDDSFile( const wstring& FileName, DXGI_FORMAT Format, uint32_t Width, uint32_t Height,
+	const vector< vector<uint8_t> >& Mips )
+{
+	using namespace DirectX;
+
+	DDS_HEADER Header = {};
+	Header.size = sizeof(DDS_HEADER);
+	Header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE | DDS_HEADER_FLAGS_MIPMAP;
+	Header.height = Height;
+	Header.width = Width;
+	Header.pitchOrLinearSize = (uint32_t)Mips[0].size();
+	Header.mipMapCount = (uint32_t)Mips.size();
+	Header.ddspf = DDSPF_DX10;
+	Header.caps = DDS_SURFACE_FLAGS_TEXTURE | (Mips.size() > 1 ? DDS_SURFACE_FLAGS_MIPMAP : 0);
+
+	DDS_HEADER_DXT10 Extension = {};
+	Extension.dxgiFormat = Format;
+	Extension.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	Extension.arraySize = 1;
+
+	ofstream File(FileName, ios::out | ios::binary);
+	if (!File)
+	{
+		Utility::Printf(L"Unable to write texture cache %s\n", FileName.c_str());
+		return;
+	}
+
+	File.write((const char*)&DDS_MAGIC, sizeof(DDS_MAGIC));
+	File.write((const char*)&Header, sizeof(Header));
+	File.write((const char*)&Extension, sizeof(Extension));
+	for (const vector<uint8_t>& Mip : Mips)
+		File.write((const char*)Mip.data(), Mip.size());
+}
+
+void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB, MipGenerator::FilterType MipFilter )
+{
+	CreateFromMipChain(*this, LoadTGAMipChain(_filePtr, sRGB, MipFilter), sRGB);
+}
+
+void Texture::CreateCompressedTGAFromMemory( const void* _filePtr, size_t, bool sRGB, const std::wstring& DDSCacheFile,
+	MipGenerator::FilterType MipFilter )
+{
+	vector<MipGenerator::MipLevel> Chain = LoadTGAMipChain(_filePtr, sRGB, MipFilter);
+	const uint32_t imageWidth = Chain[0].Width;
+	const uint32_t imageHeight = Chain[0].Height;
+
+	// The top level of a block compressed texture must be a whole number of blocks.  The mips below need not be.
+	if (imageWidth == 0 || imageHeight == 0 || imageWidth % 4 != 0 || imageHeight % 4 != 0)
+	{
+		CreateFromMipChain(*this, Chain, sRGB);
+		return;
+	}
+
+	bool HasAlpha = false;
+	for (uint32_t Pixel : Chain[0].Pixels)
+	{
+		if (Pixel < 0xFF000000)
+		{
+			HasAlpha = true;
+			break;
+		}
+	}
+
+	DXGI_FORMAT Format = HasAlpha ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC1_UNORM;
+
+	vector< vector<uint8_t> > Mips(Chain.size());
+	vector<D3D12_SUBRESOURCE_DATA> Subresources(Chain.size());
+
+	for (size_t i = 0; i < Chain.size(); ++i)
+	{
+		const MipGenerator::MipLevel& Level = Chain[i];
+		Mips[i].resize(BlockCompression::GetCompressedSize(Format, Level.Width, Level.Height));
+		BlockCompression::CompressImage(Format, Level.Pixels.data(), Level.Width * sizeof(uint32_t),
+			Level.Width, Level.Height, Mips[i].data());
+
+		Subresources[i].pData = Mips[i].data();
+		GetSurfacePitch(Format, Level.Width, Level.Height, Subresources[i]);
+	}
+
+	if (!DDSCacheFile.empty())
+		WriteDDSFile(DDSCacheFile, Format, imageWidth, imageHeight, Mips);
+
+	if (sRGB)
+		Format = HasAlpha ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM_SRGB;
 
-	delete formattedData;
+	Create( imageWidth, imageHeight, Format, (UINT)Subresources.size(), Subresources.data() );
 }
 
 bool Texture::CreateDDSFromMemory( const void* filePtr, size_t fileSize, bool sRGB )
@@ -132,16 +278,61 @@ bool Texture::CreateDDSFromMemory( const void* filePtr, size_t fileSize, bool sR
 	return SUCCEEDED(hr);
 }
 
+bool Texture::CreateDDSFromFile( const std::wstring& FileName, bool sRGB, size_t MaxSize, size_t SkipMips )
+{
+	if (m_hCpuDescriptorHandle.ptr == ~0ull)
+		m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	HRESULT hr = CreateDDSTextureFromFileEx( Graphics::g_Device, FileName.c_str(), MaxSize, SkipMips,
+		sRGB ? DDS_LOADER_FORCE_SRGB : DDS_LOADER_DEFAULT, &m_pResource, m_hCpuDescriptorHandle );
+
+	return SUCCEEDED(hr);
+}
+
 namespace TextureManager
 {
 	wstring s_RootPath = L"";
 	map< wstring, unique_ptr<ManagedTexture> > s_TextureCache;
+	size_t s_DDSMaxSize = 0;
+	size_t s_DDSSkipMips = 0;
+	bool s_CompressTGA = false;
+	bool s_WriteDDSCache = false;
+	MipGenerator::FilterType s_TGAMipFilter = MipGenerator::kBoxFilter;
 
 	void Initialize( const std::wstring& TextureLibRoot )
 	{
 		s_RootPath = TextureLibRoot;
 	}
 
+	void SetDDSLoadLimits( size_t MaxSize, size_t SkipMips )
+	{
+		s_DDSMaxSize = MaxSize;
+		s_DDSSkipMips = SkipMips;
+	}
+
+	void SetTGACompression( bool Compress, bool WriteDDSCache )
+	{
+		s_CompressTGA = Compress;
+		s_WriteDDSCache = Compress && WriteDDSCache;
+	}
+
+	void SetTGAMipFilter( MipGenerator::FilterType Filter )
+	{
+		s_TGAMipFilter = Filter;
+	}
+
+	void CreateFromTGA( ManagedTexture* ManTex, const wstring& FilePath, bool sRGB )
+	{
+		Utility::ByteArray ba = Utility::ReadFileSync( FilePath );
+		if (ba->size() == 0)
+			ManTex->SetToInvalidTexture();
+		else if (!s_CompressTGA)
+			ManTex->CreateTGAFromMemory( ba->data(), ba->size(), sRGB, s_TGAMipFilter );
+		else
+			ManTex->CreateCompressedTGAFromMemory( ba->data(), ba->size(), sRGB,
+				s_WriteDDSCache ? FilePath.substr(0, FilePath.rfind(L'.')) + L".dds" : L"", s_TGAMipFilter );
+	}
+
 	void Shutdown( void )
 	{
 		s_TextureCache.clear();
@@ -180,6 +371,7 @@ namespace TextureManager
 
 		uint32_t BlackPixel = 0;
 		ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &BlackPixel);
+		ManTex->FinishLoad();
 		return *ManTex;
 	}
 
@@ -198,6 +390,7 @@ namespace TextureManager
 
 		uint32_t WhitePixel = ~0;
 		ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &WhitePixel);
+		ManTex->FinishLoad();
 		return *ManTex;
 	}
 
@@ -216,6 +409,7 @@ namespace TextureManager
 
 		uint32_t MagentaPixel = 0x00FF00FF;
 		ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &MagentaPixel);
+		ManTex->FinishLoad();
 		return *ManTex;
 	}
 
@@ -223,10 +417,41 @@ namespace TextureManager
 
 void ManagedTexture::WaitForLoad( void ) const
 {
-	volatile D3D12_CPU_DESCRIPTOR_HANDLE& VolHandle = (volatile D3D12_CPU_DESCRIPTOR_HANDLE&)m_hCpuDescriptorHandle;
-	volatile bool& VolValid = (volatile bool&)m_IsValid;
-	while (VolHandle.ptr == ~0ull && VolValid)
-		this_thread::yield();
+	// Rather than wait for a job which may be queued behind this thread, run its load here
+	const_cast<ManagedTexture*>(this)->RunPendingLoad();
+
+	unique_lock<mutex> Lock(s_LoadMutex);
+	s_LoadFinished.wait(Lock, [this] { return m_IsLoaded; });
+}
+
+void ManagedTexture::FinishLoad( void )
+{
+	{
+		lock_guard<mutex> Guard(s_LoadMutex);
+		m_IsLoaded = true;
+	}
+	s_LoadFinished.notify_all();
+}
+
+void ManagedTexture::SetPendingLoad( const function<void(void)>& Load )
+{
+	lock_guard<mutex> Guard(s_LoadMutex);
+	m_PendingLoad = Load;
+}
+
+void ManagedTexture::RunPendingLoad( void )
+{
+	function<void(void)> Load;
+	{
+		lock_guard<mutex> Guard(s_LoadMutex);
+		Load.swap(m_PendingLoad);
+	}
+
+	if (Load)
+	{
+		Load();
+		FinishLoad();
+	}
 }
 
 void ManagedTexture::SetToInvalidTexture( void )
@@ -241,11 +466,35 @@ const ManagedTexture* TextureManager::LoadFromFile( const std::wstring& fileName
 
 	const ManagedTexture* Tex = LoadDDSFromFile( CatPath + L".dds", sRGB );
 	if (!Tex->IsValid())
-		Tex = LoadTGAFromFile( CatPath + L"tga", sRGB );
+		Tex = LoadTGAFromFile( CatPath + L".tga", sRGB );
 
 	return Tex;
 }
 
+const ManagedTexture* TextureManager::LoadFromFileAsync( const std::wstring& fileName, bool sRGB )
+{
+	auto ManagedTex = FindOrLoadTexture(fileName + L".dds");
+
+	ManagedTexture* ManTex = ManagedTex.first;
+	const bool RequestsLoad = ManagedTex.second;
+
+	if (!RequestsLoad)
+		return ManTex;
+
+	ManTex->SetPendingLoad( [=]
+	{
+		if (ManTex->CreateDDSFromFile( s_RootPath + fileName + L".dds", sRGB, s_DDSMaxSize, s_DDSSkipMips ))
+			return;
+
+		// The TGA is loaded into the texture registered for the DDS, since that is the one handed out
+		CreateFromTGA( ManTex, s_RootPath + fileName + L".tga", sRGB );
+	} );
+
+	JobSystem::Run( [=] { ManTex->RunPendingLoad(); } );
+
+	return ManTex;
+}
+
 const ManagedTexture* TextureManager::LoadDDSFromFile( const std::wstring& fileName, bool sRGB )
 {
 	auto ManagedTex = FindOrLoadTexture(fileName);
@@ -259,10 +508,10 @@ const ManagedTexture* TextureManager::LoadDDSFromFile( const std::wstring& fileN
 		return ManTex;
 	}
 
-	Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
-	if (ba->size() == 0 || !ManTex->CreateDDSFromMemory( ba->data(), ba->size(), sRGB ))
+	if (!ManTex->CreateDDSFromFile( s_RootPath + fileName, sRGB, s_DDSMaxSize, s_DDSSkipMips ))
 		ManTex->SetToInvalidTexture();
 
+	ManTex->FinishLoad();
 	return ManTex;
 }
 
@@ -279,11 +528,8 @@ const ManagedTexture* TextureManager::LoadTGAFromFile( const std::wstring& fileN
 		return ManTex;
 	}
 
-	Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
-	if (ba->size() > 0)
-		ManTex->CreateTGAFromMemory( ba->data(), ba->size(), sRGB );
-	else
-		ManTex->SetToInvalidTexture();
+	CreateFromTGA( ManTex, s_RootPath + fileName, sRGB );
 
+	ManTex->FinishLoad();
 	return ManTex;
 }
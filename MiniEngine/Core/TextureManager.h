@@ -17,6 +17,8 @@
 #include "pch.h"
 #include "GpuResource.h"
 #include "Utility.h"
+#include "MipGenerator.h"
+#include <functional>
 
 class Texture : public GpuResource
 {
@@ -27,12 +29,26 @@ public:
 	Texture() { m_hCpuDescriptorHandle.ptr = ~0ull; }
 	Texture(D3D12_CPU_DESCRIPTOR_HANDLE Handle) : m_hCpuDescriptorHandle(Handle) {}
 
-	// Create a 1-level 2D texture
+	// Create a 1-level 2D texture.  InitData for a block compressed format holds rows of blocks.
 	void Create(size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitData );
 
-	void CreateTGAFromMemory( const void* memBuffer, size_t fileSize, bool sRGB );
+	// Create a 2D texture with NumMips levels, each initialized from its entry in InitData
+	void Create( size_t Width, size_t Height, DXGI_FORMAT Format, UINT NumMips, D3D12_SUBRESOURCE_DATA InitData[] );
+
+	// TGA textures get a full mip chain, generated on the CPU with MipFilter
+	void CreateTGAFromMemory( const void* memBuffer, size_t fileSize, bool sRGB,
+		MipGenerator::FilterType MipFilter = MipGenerator::kBoxFilter );
+
+	// Compress to BC1, or to BC3 if any pixel is not opaque.  Images that are not a whole number of blocks are
+	// left uncompressed.  The compressed texture is also saved as a DDS file when DDSCacheFile is not empty.
+	void CreateCompressedTGAFromMemory( const void* memBuffer, size_t fileSize, bool sRGB,
+		const std::wstring& DDSCacheFile = L"", MipGenerator::FilterType MipFilter = MipGenerator::kBoxFilter );
 	bool CreateDDSFromMemory( const void* memBuffer, size_t fileSize, bool sRGB );
 
+	// Reads only the parts of the file holding the mips that are kept.  Top mips are skipped while they are
+	// larger than MaxSize (unless it is zero), and then until at least SkipMips have been skipped.
+	bool CreateDDSFromFile( const std::wstring& FileName, bool sRGB, size_t MaxSize = 0, size_t SkipMips = 0 );
+
 	void Destroy()
 	{
 		GpuResource::Destroy();
@@ -51,11 +67,19 @@ protected:
 class ManagedTexture : public Texture
 {
 public:
-	ManagedTexture( const std::wstring& FileName ) : m_MapKey(FileName), m_IsValid(true) {}
+	ManagedTexture( const std::wstring& FileName ) : m_MapKey(FileName), m_IsValid(true), m_IsLoaded(false) {}
 
 	void operator= ( const Texture& Texture );
 
+	// Blocks until the thread loading the texture calls FinishLoad().  The loader never runs other jobs while
+	// loading (see JobSystem::ParallelFor()), so it is always making progress on some other thread.  A load
+	// whose job has not started yet is run by the waiting thread instead.
 	void WaitForLoad(void) const;
+	void FinishLoad(void);
+
+	// Hand the load to whichever comes first:  a job, or a thread waiting for the texture
+	void SetPendingLoad( const std::function<void(void)>& Load );
+	void RunPendingLoad(void);
 	void Unload(void);
 
 	void SetToInvalidTexture(void);
@@ -64,6 +88,8 @@ public:
 private:
 	std::wstring m_MapKey;		// For deleting from the map later
 	bool m_IsValid;
+	bool m_IsLoaded;
+	std::function<void(void)> m_PendingLoad;
 };
 
 namespace TextureManager
@@ -71,10 +97,25 @@ namespace TextureManager
 	void Initialize( const std::wstring& TextureLibRoot );
 	void Shutdown(void);
 
+	// Limit the resolution of DDS textures loaded from now on, to save load time and memory.  See
+	// Texture::CreateDDSFromFile().  Both default to zero, which loads every mip.
+	void SetDDSLoadLimits( size_t MaxSize, size_t SkipMips );
+
+	// Block compress TGA textures loaded from now on.  With WriteDDSCache, each compressed texture is also saved
+	// beside its TGA with a .dds extension, so that LoadFromFile() picks it up instead next time.
+	void SetTGACompression( bool Compress, bool WriteDDSCache = false );
+
+	// The filter for the mip chains of TGA textures loaded from now on.  The default is the box filter.
+	void SetTGAMipFilter( MipGenerator::FilterType Filter );
+
 	const ManagedTexture* LoadFromFile( const std::wstring& fileName, bool sRGB = false );
 	const ManagedTexture* LoadDDSFromFile( const std::wstring& fileName, bool sRGB = false );
 	const ManagedTexture* LoadTGAFromFile( const std::wstring& fileName, bool sRGB = false );
 
+	// Returns immediately and loads the texture (DDS, falling back to TGA) with a job.  Call WaitForLoad()
+	// on the result before using it.
+	const ManagedTexture* LoadFromFileAsync( const std::wstring& fileName, bool sRGB = false );
+
 	inline const ManagedTexture* LoadFromFile( const std::string& fileName, bool sRGB = false )
 	{
 		return LoadFromFile(MakeWStr(fileName), sRGB);
@@ -90,6 +131,11 @@ namespace TextureManager
 		return LoadTGAFromFile(MakeWStr(fileName), sRGB);
 	}
 
+	inline const ManagedTexture* LoadFromFileAsync( const std::string& fileName, bool sRGB = false )
+	{
+		return LoadFromFileAsync(MakeWStr(fileName), sRGB);
+	}
+
 	const Texture& GetBlackTex2D(void);
 	const Texture& GetWhiteTex2D(void);
 }
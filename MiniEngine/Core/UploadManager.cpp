@@ -0,0 +1,389 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "UploadManager.h"
+#include "ResourceStateTracker.h"
+#include "CommandListManager.h"
+#include "GraphicsCore.h"
+
+using namespace Graphics;
+
+UploadRing::UploadRing() :
+	m_RingSize(0),
+	m_RingHead(0),
+	m_RingTail(0)
+{
+}
+
+void UploadRing::Reset( size_t RingSizeInBytes )
+{
+	m_RingSize = RingSizeInBytes;
+	m_RingHead = m_RingTail = 0;
+	m_InFlightBatches = std::queue<Batch>();
+}
+
+bool UploadRing::Allocate( size_t SizeInBytes, size_t Alignment, size_t& Offset )
+{
+	ASSERT(SizeInBytes + Alignment <= m_RingSize);
+
+	// When the whole ring is free, start again from the beginning so that a large request never has to
+	// wait for padding to retire.
+	if (m_RingHead == m_RingTail && m_InFlightBatches.empty())
+		m_RingHead = m_RingTail = 0;
+
+	uint64_t Start = Math::AlignUp(m_RingHead, Alignment);
+
+	// Allocations never straddle the end of the ring.  Skip the rest of it instead.
+	if (Start % m_RingSize + SizeInBytes > m_RingSize)
+		Start = (Start / m_RingSize + 1) * m_RingSize;
+
+	if (Start + SizeInBytes - m_RingTail > m_RingSize)
+		return false;
+
+	m_RingHead = Start + SizeInBytes;
+	Offset = (size_t)(Start % m_RingSize);
+	return true;
+}
+
+void UploadRing::CloseBatch( uint64_t FenceValue )
+{
+	ASSERT(m_InFlightBatches.empty() || m_InFlightBatches.back().FenceValue < FenceValue);
+
+	Batch NewBatch;
+	NewBatch.FenceValue = FenceValue;
+	NewBatch.RingEnd = m_RingHead;
+	m_InFlightBatches.push(NewBatch);
+}
+
+void UploadRing::Retire( uint64_t CompletedFenceValue )
+{
+	while (!m_InFlightBatches.empty() && m_InFlightBatches.front().FenceValue <= CompletedFenceValue)
+	{
+		m_RingTail = m_InFlightBatches.front().RingEnd;
+		m_InFlightBatches.pop();
+	}
+}
+
+UploadManager::UploadManager() :
+	m_RingCpuAddress(nullptr),
+	m_CommandList(nullptr),
+	m_CurrentAllocator(nullptr),
+	m_OpenBatchHasWork(false),
+	m_LastCompletedUploadID(0),
+	m_LastSubmittedFence(0)
+{
+	m_OpenBatch.UploadID = 1;
+	ZeroMemory(m_QueueSyncFence, sizeof(m_QueueSyncFence));
+}
+
+void UploadManager::Create( size_t RingSizeInBytes )
+{
+	ASSERT(m_RingBuffer == nullptr);
+
+	// Keep the ring a multiple of the texture placement alignment so that aligned offsets stay aligned when
+	// the ring wraps around.
+	m_Ring.Reset(Math::AlignUp(RingSizeInBytes, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+
+	D3D12_HEAP_PROPERTIES HeapProps;
+	HeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+	HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	HeapProps.CreationNodeMask = 1;
+	HeapProps.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(m_Ring.GetSize());
+
+	ASSERT_SUCCEEDED( g_Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE,
+		&BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, MY_IID_PPV_ARGS(&m_RingBuffer)) );
+
+	m_RingBuffer->SetName(L"UploadManager Ring Buffer");
+	m_RingBuffer->Map(0, nullptr, (void**)&m_RingCpuAddress);
+}
+
+void UploadManager::Shutdown( void )
+{
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+		if (m_OpenBatchHasWork)
+			SubmitBatch();
+
+		while (!m_InFlightBatches.empty())
+			RetireBatches(true);
+
+		ASSERT(m_CurrentAllocator == nullptr);
+		if (m_CommandList != nullptr)
+		{
+			m_CommandList->Release();
+			m_CommandList = nullptr;
+		}
+
+		if (m_RingBuffer != nullptr)
+		{
+			m_RingBuffer->Unmap(0, nullptr);
+			m_RingBuffer = nullptr;
+			m_RingCpuAddress = nullptr;
+		}
+	}
+
+	InvokeCompletedCallbacks();
+}
+
+bool UploadManager::CanUpload( const GpuResource& Dest ) const
+{
+	// Resources decay to COMMON after being used on the copy queue, and are implicitly promoted to the read
+	// state they are first used in by the graphics or compute queue.  Anything which has already been
+	// transitioned to another state must be initialized on the queue which owns that state.
+	return m_RingBuffer != nullptr && ResourceStateTracker::GetGlobalState(Dest) == D3D12_RESOURCE_STATE_COMMON;
+}
+
+uint64_t UploadManager::UploadTexture( GpuResource& Dest, UINT FirstSubresource, UINT NumSubresources,
+	D3D12_SUBRESOURCE_DATA SubData[], const std::function<void(void)>& OnComplete )
+{
+	ASSERT(CanUpload(Dest));
+
+	uint64_t UploadID;
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+		UINT64 UploadSize = GetRequiredIntermediateSize(Dest.GetResource(), FirstSubresource, NumSubresources);
+		StagingAlloc Staging = AllocateStaging((size_t)UploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+		UINT64 CopiedSize = UpdateSubresources(OpenCommandList(), Dest.GetResource(), Staging.Buffer,
+			Staging.Offset, FirstSubresource, NumSubresources, SubData);
+		ASSERT(CopiedSize != 0, "Failed to record texture upload");
+		(CopiedSize);
+
+		UploadID = EndUpload(OnComplete);
+	}
+
+	InvokeCompletedCallbacks();
+	return UploadID;
+}
+
+uint64_t UploadManager::UploadBuffer( GpuResource& Dest, size_t DestOffset, const void* BufferData, size_t NumBytes,
+	const std::function<void(void)>& OnComplete )
+{
+	ASSERT(CanUpload(Dest));
+	ASSERT(BufferData != nullptr && Math::IsAligned(BufferData, 16));
+
+	uint64_t UploadID;
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+		// SIMDMemCopy() works on whole 16 byte blocks
+		StagingAlloc Staging = AllocateStaging(Math::AlignUp(NumBytes, 16), 16);
+		SIMDMemCopy(Staging.DataPtr, BufferData, Math::DivideByMultiple(NumBytes, 16));
+
+		OpenCommandList()->CopyBufferRegion(Dest.GetResource(), DestOffset, Staging.Buffer, Staging.Offset, NumBytes);
+
+		UploadID = EndUpload(OnComplete);
+	}
+
+	InvokeCompletedCallbacks();
+	return UploadID;
+}
+
+bool UploadManager::IsUploadComplete( uint64_t UploadID )
+{
+	bool Complete;
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+		RetireBatches(false);
+		Complete = UploadID <= m_LastCompletedUploadID;
+	}
+
+	InvokeCompletedCallbacks();
+	return Complete;
+}
+
+void UploadManager::WaitForUpload( uint64_t UploadID )
+{
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+		if (UploadID == m_OpenBatch.UploadID && m_OpenBatchHasWork)
+			SubmitBatch();
+
+		while (UploadID > m_LastCompletedUploadID && !m_InFlightBatches.empty())
+			RetireBatches(true);
+	}
+
+	InvokeCompletedCallbacks();
+}
+
+void UploadManager::SyncQueue( CommandQueue& Queue )
+{
+	ASSERT(Queue.m_Type != D3D12_COMMAND_LIST_TYPE_COPY);
+
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+		if (m_OpenBatchHasWork)
+			SubmitBatch();
+
+		// Only insert a GPU wait if this queue has not already waited for the most recent batch
+		uint64_t& SyncFence = m_QueueSyncFence[Queue.m_Type];
+		if (m_LastSubmittedFence > SyncFence)
+		{
+			Queue.StallForFence(m_LastSubmittedFence);
+			SyncFence = m_LastSubmittedFence;
+		}
+
+		RetireBatches(false);
+	}
+
+	InvokeCompletedCallbacks();
+}
+
+void UploadManager::RetireCompletedUploads( void )
+{
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+		RetireBatches(false);
+	}
+
+	InvokeCompletedCallbacks();
+}
+
+UploadManager::StagingAlloc UploadManager::AllocateStaging( size_t SizeInBytes, size_t Alignment )
+{
+	// Requests which cannot fit in the ring get their own upload buffer, released when the batch completes
+	if (SizeInBytes + Alignment > m_Ring.GetSize())
+	{
+		D3D12_HEAP_PROPERTIES HeapProps;
+		HeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+		HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		HeapProps.CreationNodeMask = 1;
+		HeapProps.VisibleNodeMask = 1;
+
+		D3D12_RESOURCE_DESC BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(SizeInBytes);
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> DedicatedBuffer;
+		ASSERT_SUCCEEDED( g_Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE,
+			&BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, MY_IID_PPV_ARGS(&DedicatedBuffer)) );
+
+		DedicatedBuffer->SetName(L"UploadManager Dedicated Buffer");
+
+		StagingAlloc Alloc;
+		Alloc.Buffer = DedicatedBuffer.Get();
+		Alloc.Offset = 0;
+		DedicatedBuffer->Map(0, nullptr, &Alloc.DataPtr);
+
+		m_OpenBatch.DedicatedBuffers.push_back(DedicatedBuffer);
+		return Alloc;
+	}
+
+	for (;;)
+	{
+		StagingAlloc Alloc;
+		if (m_Ring.Allocate(SizeInBytes, Alignment, Alloc.Offset))
+		{
+			Alloc.Buffer = m_RingBuffer.Get();
+			Alloc.DataPtr = m_RingCpuAddress + Alloc.Offset;
+			return Alloc;
+		}
+
+		// The ring is full.  Submit what has been recorded so far, then wait for the oldest batch to release
+		// its part of the ring.
+		if (m_OpenBatchHasWork)
+			SubmitBatch();
+
+		RetireBatches(true);
+	}
+}
+
+ID3D12GraphicsCommandList* UploadManager::OpenCommandList( void )
+{
+	// The command list is open whenever it has an allocator
+	if (m_CurrentAllocator == nullptr)
+	{
+		if (m_CommandList == nullptr)
+		{
+			g_CommandManager.CreateNewCommandList(D3D12_COMMAND_LIST_TYPE_COPY, &m_CommandList, &m_CurrentAllocator);
+			m_CommandList->SetName(L"UploadManager Command List");
+		}
+		else
+		{
+			m_CurrentAllocator = g_CommandManager.GetCopyQueue().RequestAllocator();
+			m_CommandList->Reset(m_CurrentAllocator, nullptr);
+		}
+	}
+
+	return m_CommandList;
+}
+
+uint64_t UploadManager::EndUpload( const std::function<void(void)>& OnComplete )
+{
+	m_OpenBatchHasWork = true;
+
+	if (OnComplete)
+		m_OpenBatch.Callbacks.push_back(OnComplete);
+
+	return m_OpenBatch.UploadID;
+}
+
+void UploadManager::SubmitBatch( void )
+{
+	ASSERT(m_OpenBatchHasWork && m_CurrentAllocator != nullptr);
+
+	CommandQueue& CopyQueue = g_CommandManager.GetCopyQueue();
+
+	uint64_t FenceValue = CopyQueue.ExecuteCommandList(m_CommandList);
+	CopyQueue.DiscardAllocator(FenceValue, m_CurrentAllocator);
+	m_CurrentAllocator = nullptr;
+
+	uint64_t NextUploadID = m_OpenBatch.UploadID + 1;
+
+	m_OpenBatch.FenceValue = FenceValue;
+	m_Ring.CloseBatch(FenceValue);
+	m_InFlightBatches.push(std::move(m_OpenBatch));
+	m_LastSubmittedFence = FenceValue;
+
+	m_OpenBatch = UploadBatch();
+	m_OpenBatch.UploadID = NextUploadID;
+	m_OpenBatchHasWork = false;
+}
+
+void UploadManager::RetireBatches( bool WaitForOldest )
+{
+	CommandQueue& CopyQueue = g_CommandManager.GetCopyQueue();
+
+	if (WaitForOldest && !m_InFlightBatches.empty())
+		CopyQueue.WaitForFence(m_InFlightBatches.front().FenceValue);
+
+	while (!m_InFlightBatches.empty() && CopyQueue.IsFenceComplete(m_InFlightBatches.front().FenceValue))
+	{
+		UploadBatch& Batch = m_InFlightBatches.front();
+
+		m_Ring.Retire(Batch.FenceValue);
+		m_LastCompletedUploadID = Batch.UploadID;
+
+		for (auto& Callback : Batch.Callbacks)
+			m_CompletedCallbacks.push_back(std::move(Callback));
+
+		// Releases the batch's dedicated upload buffers
+		m_InFlightBatches.pop();
+	}
+}
+
+void UploadManager::InvokeCompletedCallbacks( void )
+{
+	// Callbacks are invoked without holding the lock so that they are free to start new uploads
+	std::vector<std::function<void(void)> > Callbacks;
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+		Callbacks.swap(m_CompletedCallbacks);
+	}
+
+	for (auto& Callback : Callbacks)
+		Callback();
+}
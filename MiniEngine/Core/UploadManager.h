@@ -0,0 +1,150 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  Uploads initial resource data on the copy queue.  Staging memory is suballocated from a
+// persistently mapped ring buffer in an upload heap, and the copies are recorded into one copy command list
+// which is only submitted when the graphics or compute queue is about to execute work, when the ring is full,
+// or when a caller waits for an upload.  Loading many textures in a row therefore costs one submission and no
+// CPU stalls, instead of one committed upload buffer and one GPU flush per texture.
+//
+// Each batch of copies is fenced on the copy queue.  When a batch's fence completes, its part of the ring is
+// reclaimed and the completion callbacks of its uploads are invoked.  Requests larger than the ring get a
+// dedicated upload buffer which is released with the batch.
+
+#pragma once
+
+#include "GpuResource.h"
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <functional>
+
+class CommandQueue;
+
+// The staging ring's bookkeeping, without any D3D12 objects.  Offsets are handed out in order and released a
+// batch at a time when the fence value the batch was closed with completes, so it can be driven by a fake
+// fence as well as by the copy queue.
+class UploadRing
+{
+public:
+
+	UploadRing();
+
+	void Reset( size_t RingSizeInBytes );
+	size_t GetSize( void ) const { return m_RingSize; }
+
+	// Returns false when the request does not fit until older batches retire.  Allocations never straddle
+	// the end of the ring.
+	bool Allocate( size_t SizeInBytes, size_t Alignment, size_t& Offset );
+
+	// Everything allocated since the last call is released once FenceValue completes.  Fence values must
+	// increase from one batch to the next.
+	void CloseBatch( uint64_t FenceValue );
+
+	// Release every batch closed with a fence value at or below CompletedFenceValue
+	void Retire( uint64_t CompletedFenceValue );
+
+	bool HasBatchesInFlight( void ) const { return !m_InFlightBatches.empty(); }
+
+private:
+
+	struct Batch
+	{
+		uint64_t FenceValue;
+		uint64_t RingEnd;
+	};
+
+	size_t m_RingSize;
+
+	// Monotonic byte counters.  The ring offset is the counter modulo the ring size.
+	uint64_t m_RingHead;
+	uint64_t m_RingTail;
+
+	std::queue<Batch> m_InFlightBatches;
+};
+
+class UploadManager
+{
+public:
+
+	UploadManager();
+
+	void Create( size_t RingSizeInBytes );
+	void Shutdown( void );
+
+	// Only resources in the COMMON state can be written by the copy queue.  Callers should use a direct
+	// queue context for anything else.
+	bool CanUpload( const GpuResource& Dest ) const;
+
+	// Record the upload of initial data.  The source data is copied before returning.  The returned ID can be
+	// passed to IsUploadComplete() and WaitForUpload(), and OnComplete is invoked once the GPU copy is done.
+	uint64_t UploadTexture( GpuResource& Dest, UINT FirstSubresource, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[],
+		const std::function<void(void)>& OnComplete = nullptr );
+	uint64_t UploadTexture( GpuResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[],
+		const std::function<void(void)>& OnComplete = nullptr )
+	{
+		return UploadTexture(Dest, 0, NumSubresources, SubData, OnComplete);
+	}
+	uint64_t UploadBuffer( GpuResource& Dest, size_t DestOffset, const void* BufferData, size_t NumBytes,
+		const std::function<void(void)>& OnComplete = nullptr );
+
+	bool IsUploadComplete( uint64_t UploadID );
+	void WaitForUpload( uint64_t UploadID );
+
+	// Submit any recorded copies and have the queue wait (on the GPU) for every upload submitted so far.
+	// This is called before executing work on the graphics and compute queues.
+	void SyncQueue( CommandQueue& Queue );
+
+	// Recycle staging memory of completed batches and invoke their callbacks
+	void RetireCompletedUploads( void );
+
+private:
+
+	struct StagingAlloc
+	{
+		ID3D12Resource* Buffer;
+		size_t Offset;
+		void* DataPtr;
+	};
+
+	struct UploadBatch
+	{
+		uint64_t UploadID;
+		uint64_t FenceValue;
+		std::vector<std::function<void(void)> > Callbacks;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource> > DedicatedBuffers;
+	};
+
+	StagingAlloc AllocateStaging( size_t SizeInBytes, size_t Alignment );
+	ID3D12GraphicsCommandList* OpenCommandList( void );
+	uint64_t EndUpload( const std::function<void(void)>& OnComplete );
+	void SubmitBatch( void );
+	void RetireBatches( bool WaitForOldest );
+	void InvokeCompletedCallbacks( void );
+
+	std::mutex m_Mutex;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_RingBuffer;
+	uint8_t* m_RingCpuAddress;
+	UploadRing m_Ring;
+
+	ID3D12GraphicsCommandList* m_CommandList;
+	ID3D12CommandAllocator* m_CurrentAllocator;
+
+	// The batch being recorded, and the batches executing on the copy queue
+	UploadBatch m_OpenBatch;
+	bool m_OpenBatchHasWork;
+	std::queue<UploadBatch> m_InFlightBatches;
+	uint64_t m_LastCompletedUploadID;
+
+	// The last copy fence submitted, and the last one each queue type was made to wait on
+	uint64_t m_LastSubmittedFence;
+	uint64_t m_QueueSyncFence[4];
+
+	std::vector<std::function<void(void)> > m_CompletedCallbacks;
+};
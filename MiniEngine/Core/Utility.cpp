@@ -15,124 +15,331 @@
 #include "Utility.h"
 #include <string>
 
-// A faster version of memcopy that uses SSE instructions.  TODO:  Write an ARM variant if necessary.
-void SIMDMemCopy( void* __restrict _Dest, const void* __restrict _Source, size_t NumQuadwords )
+#include "JobSystem.h"
+#include <intrin.h>
+
+// SIMDMemCopy() and SIMDMemFill() pick an implementation based on the instruction set and the size of the
+// operation.  Small operations use regular stores so that the data stays in cache for whoever reads it next.
+// Large ones use non-temporal stores, which write around the cache rather than evicting everything in it.
+// SIMDMemCopyParallel() also splits very large copies across the job system's workers, since a single core
+// cannot saturate the memory bus on its own.
+namespace
 {
-	ASSERT(Math::IsAligned(_Dest, 16));
-	ASSERT(Math::IsAligned(_Source, 16));
+	const size_t kNonTemporalThreshold = 1024 * 1024;
+	const size_t kParallelThreshold = 16 * 1024 * 1024;
+	const size_t kParallelChunkSize = 2 * 1024 * 1024;
 
-	__m128i* __restrict Dest = (__m128i* __restrict)_Dest;
-	const __m128i* __restrict Source = (const __m128i* __restrict)_Source;
+	enum InstructionSet { kSSE2, kAVX };
 
-	// Discover how many quadwords precede a cache line boundary.  Copy them separately.
-	size_t InitialQuadwordCount = (4 - ((size_t)Source >> 4) & 3) & 3;
-	if (InitialQuadwordCount > NumQuadwords)
-		InitialQuadwordCount = NumQuadwords;
+	InstructionSet DetectInstructionSet( void )
+	{
+		int CPUInfo[4];
+		__cpuid(CPUInfo, 1);
+
+		// The OS must save the upper halves of the YMM registers for AVX to be usable
+		const bool HasOSXSAVE = (CPUInfo[2] & (1 << 27)) != 0;
+		const bool HasAVX = (CPUInfo[2] & (1 << 28)) != 0;
+		if (HasOSXSAVE && HasAVX && (_xgetbv(0) & 6) == 6)
+			return kAVX;
+
+		return kSSE2;
+	}
 
-	switch (InitialQuadwordCount)
+	InstructionSet GetInstructionSet( void )
 	{
-	case 3: _mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));	 // Fall through
-	case 2: _mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));	 // Fall through
-	case 1: _mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));	 // Fall through
-	default:
-		break;
+		static const InstructionSet s_InstructionSet = DetectInstructionSet();
+		return s_InstructionSet;
 	}
 
-	if (NumQuadwords == InitialQuadwordCount)
-		return;
+	// The original SSE2 copy.  It streams whole cache lines and prefetches well ahead of them.
+	void CopyStreamingSSE2( __m128i* __restrict Dest, const __m128i* __restrict Source, size_t NumQuadwords )
+	{
+		// Discover how many quadwords precede a cache line boundary.  Copy them separately.
+		size_t InitialQuadwordCount = (4 - ((size_t)Source >> 4) & 3) & 3;
+		if (InitialQuadwordCount > NumQuadwords)
+			InitialQuadwordCount = NumQuadwords;
 
-	Dest += InitialQuadwordCount;
-	Source += InitialQuadwordCount;
-	NumQuadwords -= InitialQuadwordCount;
+		switch (InitialQuadwordCount)
+		{
+		case 3: _mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));	 // Fall through
+		case 2: _mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));	 // Fall through
+		case 1: _mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));	 // Fall through
+		default:
+			break;
+		}
+
+		if (NumQuadwords == InitialQuadwordCount)
+			return;
+
+		Dest += InitialQuadwordCount;
+		Source += InitialQuadwordCount;
+		NumQuadwords -= InitialQuadwordCount;
+
+		size_t CacheLines = NumQuadwords >> 2;
+
+		switch (CacheLines)
+		{
+		default:
+		case 10: _mm_prefetch((char*)(Source + 36), _MM_HINT_NTA);	// Fall through
+		case 9:  _mm_prefetch((char*)(Source + 32), _MM_HINT_NTA);	// Fall through
+		case 8:  _mm_prefetch((char*)(Source + 28), _MM_HINT_NTA);	// Fall through
+		case 7:  _mm_prefetch((char*)(Source + 24), _MM_HINT_NTA);	// Fall through
+		case 6:  _mm_prefetch((char*)(Source + 20), _MM_HINT_NTA);	// Fall through
+		case 5:  _mm_prefetch((char*)(Source + 16), _MM_HINT_NTA);	// Fall through
+		case 4:  _mm_prefetch((char*)(Source + 12), _MM_HINT_NTA);	// Fall through
+		case 3:  _mm_prefetch((char*)(Source + 8 ), _MM_HINT_NTA);	// Fall through
+		case 2:  _mm_prefetch((char*)(Source + 4 ), _MM_HINT_NTA);	// Fall through
+		case 1:  _mm_prefetch((char*)(Source + 0 ), _MM_HINT_NTA);	// Fall through
+
+			// Do four quadwords per loop to minimize stalls.
+			for (size_t i = CacheLines; i > 0; --i)
+			{
+				// If this is a large copy, start prefetching future cache lines.  This also prefetches the
+				// trailing quadwords that are not part of a whole cache line.
+				if (i >= 10)
+					_mm_prefetch((char*)(Source + 40), _MM_HINT_NTA);
+
+				_mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));
+				_mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));
+				_mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));
+				_mm_stream_si128(Dest + 3, _mm_load_si128(Source + 3));
 
-	size_t CacheLines = NumQuadwords >> 2;
+				Dest += 4;
+				Source += 4;
+			}
 
-	switch (CacheLines)
+		case 0:	// No whole cache lines to read
+			break;
+		}
+
+		// Copy the remaining quadwords
+		switch (NumQuadwords & 3)
+		{
+		case 3: _mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));	 // Fall through
+		case 2: _mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));	 // Fall through
+		case 1: _mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));	 // Fall through
+		default:
+			break;
+		}
+	}
+
+	// Modern hardware prefetchers follow a linear copy on their own, so the temporal paths do not prefetch
+	void CopySSE2( __m128i* __restrict Dest, const __m128i* __restrict Source, size_t NumQuadwords )
 	{
-	default:
-	case 10: _mm_prefetch((char*)(Source + 36), _MM_HINT_NTA);	// Fall through
-	case 9:  _mm_prefetch((char*)(Source + 32), _MM_HINT_NTA);	// Fall through
-	case 8:  _mm_prefetch((char*)(Source + 28), _MM_HINT_NTA);	// Fall through
-	case 7:  _mm_prefetch((char*)(Source + 24), _MM_HINT_NTA);	// Fall through
-	case 6:  _mm_prefetch((char*)(Source + 20), _MM_HINT_NTA);	// Fall through
-	case 5:  _mm_prefetch((char*)(Source + 16), _MM_HINT_NTA);	// Fall through
-	case 4:  _mm_prefetch((char*)(Source + 12), _MM_HINT_NTA);	// Fall through
-	case 3:  _mm_prefetch((char*)(Source + 8 ), _MM_HINT_NTA);	// Fall through
-	case 2:  _mm_prefetch((char*)(Source + 4 ), _MM_HINT_NTA);	// Fall through
-	case 1:  _mm_prefetch((char*)(Source + 0 ), _MM_HINT_NTA);	// Fall through
-
-		// Do four quadwords per loop to minimize stalls.
-		for (size_t i = CacheLines; i > 0; --i)
+		for (; NumQuadwords >= 4; NumQuadwords -= 4, Dest += 4, Source += 4)
 		{
-			// If this is a large copy, start prefetching future cache lines.  This also prefetches the
-			// trailing quadwords that are not part of a whole cache line.
-			if (i >= 10)
-				_mm_prefetch((char*)(Source + 40), _MM_HINT_NTA);
-
-			_mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));
-			_mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));
-			_mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));
-			_mm_stream_si128(Dest + 3, _mm_load_si128(Source + 3));
-
-			Dest += 4;
-			Source += 4;
+			_mm_store_si128(Dest + 0, _mm_load_si128(Source + 0));
+			_mm_store_si128(Dest + 1, _mm_load_si128(Source + 1));
+			_mm_store_si128(Dest + 2, _mm_load_si128(Source + 2));
+			_mm_store_si128(Dest + 3, _mm_load_si128(Source + 3));
 		}
 
-	case 0:	// No whole cache lines to read
-		break;
+		while (NumQuadwords--)
+			_mm_store_si128(Dest++, _mm_load_si128(Source++));
 	}
 
-	// Copy the remaining quadwords
-	switch (NumQuadwords & 3)
+	// 32-byte loads and stores.  Only the destination can be brought to 32-byte alignment (which streaming
+	// stores require), so the loads are unaligned.
+	template <bool Streaming>
+	void CopyAVX( __m128i* __restrict Dest, const __m128i* __restrict Source, size_t NumQuadwords )
 	{
-	case 3: _mm_stream_si128(Dest + 2, _mm_load_si128(Source + 2));	 // Fall through
-	case 2: _mm_stream_si128(Dest + 1, _mm_load_si128(Source + 1));	 // Fall through
-	case 1: _mm_stream_si128(Dest + 0, _mm_load_si128(Source + 0));	 // Fall through
-	default:
-		break;
+		if (NumQuadwords > 0 && ((size_t)Dest & 31) != 0)
+		{
+			if (Streaming)
+				_mm_stream_si128(Dest, _mm_load_si128(Source));
+			else
+				_mm_store_si128(Dest, _mm_load_si128(Source));
+			++Dest;
+			++Source;
+			--NumQuadwords;
+		}
+
+		__m256i* __restrict Dest256 = (__m256i*)Dest;
+		const __m256i* __restrict Source256 = (const __m256i*)Source;
+		size_t Num256 = NumQuadwords >> 1;
+
+		// Two cache lines per loop
+		for (; Num256 >= 4; Num256 -= 4, Dest256 += 4, Source256 += 4)
+		{
+			__m256i A = _mm256_loadu_si256(Source256 + 0);
+			__m256i B = _mm256_loadu_si256(Source256 + 1);
+			__m256i C = _mm256_loadu_si256(Source256 + 2);
+			__m256i D = _mm256_loadu_si256(Source256 + 3);
+
+			if (Streaming)
+			{
+				_mm256_stream_si256(Dest256 + 0, A);
+				_mm256_stream_si256(Dest256 + 1, B);
+				_mm256_stream_si256(Dest256 + 2, C);
+				_mm256_stream_si256(Dest256 + 3, D);
+			}
+			else
+			{
+				_mm256_store_si256(Dest256 + 0, A);
+				_mm256_store_si256(Dest256 + 1, B);
+				_mm256_store_si256(Dest256 + 2, C);
+				_mm256_store_si256(Dest256 + 3, D);
+			}
+		}
+
+		for (; Num256 > 0; --Num256, ++Dest256, ++Source256)
+		{
+			if (Streaming)
+				_mm256_stream_si256(Dest256, _mm256_loadu_si256(Source256));
+			else
+				_mm256_store_si256(Dest256, _mm256_loadu_si256(Source256));
+		}
+
+		if (NumQuadwords & 1)
+		{
+			if (Streaming)
+				_mm_stream_si128((__m128i*)Dest256, _mm_load_si128((const __m128i*)Source256));
+			else
+				_mm_store_si128((__m128i*)Dest256, _mm_load_si128((const __m128i*)Source256));
+		}
+
+		// Avoid the penalty for mixing VEX and legacy SSE code
+		_mm256_zeroupper();
 	}
 
-	_mm_sfence();
+	template <bool Streaming>
+	void FillSSE2( __m128i* __restrict Dest, __m128i Source, size_t NumQuadwords )
+	{
+		for (; NumQuadwords >= 4; NumQuadwords -= 4, Dest += 4)
+		{
+			if (Streaming)
+			{
+				_mm_stream_si128(Dest + 0, Source);
+				_mm_stream_si128(Dest + 1, Source);
+				_mm_stream_si128(Dest + 2, Source);
+				_mm_stream_si128(Dest + 3, Source);
+			}
+			else
+			{
+				_mm_store_si128(Dest + 0, Source);
+				_mm_store_si128(Dest + 1, Source);
+				_mm_store_si128(Dest + 2, Source);
+				_mm_store_si128(Dest + 3, Source);
+			}
+		}
+
+		for (; NumQuadwords > 0; --NumQuadwords, ++Dest)
+		{
+			if (Streaming)
+				_mm_stream_si128(Dest, Source);
+			else
+				_mm_store_si128(Dest, Source);
+		}
+	}
+
+	template <bool Streaming>
+	void FillAVX( __m128i* __restrict Dest, __m128i Source, size_t NumQuadwords )
+	{
+		if (NumQuadwords > 0 && ((size_t)Dest & 31) != 0)
+		{
+			FillSSE2<Streaming>(Dest++, Source, 1);
+			--NumQuadwords;
+		}
+
+		const __m256i Source256 = _mm256_insertf128_si256(_mm256_castsi128_si256(Source), Source, 1);
+		__m256i* __restrict Dest256 = (__m256i*)Dest;
+		size_t Num256 = NumQuadwords >> 1;
+
+		for (; Num256 > 0; --Num256, ++Dest256)
+		{
+			if (Streaming)
+				_mm256_stream_si256(Dest256, Source256);
+			else
+				_mm256_store_si256(Dest256, Source256);
+		}
+
+		if (NumQuadwords & 1)
+			FillSSE2<Streaming>((__m128i*)Dest256, Source, 1);
+
+		_mm256_zeroupper();
+	}
+
+	void CopyRange( __m128i* __restrict Dest, const __m128i* __restrict Source, size_t NumQuadwords, bool Streaming )
+	{
+		if (GetInstructionSet() == kAVX)
+		{
+			if (Streaming)
+				CopyAVX<true>(Dest, Source, NumQuadwords);
+			else
+				CopyAVX<false>(Dest, Source, NumQuadwords);
+		}
+		else if (Streaming)
+			CopyStreamingSSE2(Dest, Source, NumQuadwords);
+		else
+			CopySSE2(Dest, Source, NumQuadwords);
+
+		// Streaming stores are weakly ordered.  Make them visible before anyone is told the copy is done.
+		if (Streaming)
+			_mm_sfence();
+	}
+
+	void FillRange( __m128i* __restrict Dest, __m128i Source, size_t NumQuadwords, bool Streaming )
+	{
+		if (GetInstructionSet() == kAVX)
+		{
+			if (Streaming)
+				FillAVX<true>(Dest, Source, NumQuadwords);
+			else
+				FillAVX<false>(Dest, Source, NumQuadwords);
+		}
+		else if (Streaming)
+			FillSSE2<true>(Dest, Source, NumQuadwords);
+		else
+			FillSSE2<false>(Dest, Source, NumQuadwords);
+
+		if (Streaming)
+			_mm_sfence();
+	}
 }
 
-void SIMDMemFill( void* __restrict _Dest, __m128 FillVector, size_t NumQuadwords )
+// A faster version of memcopy that uses SSE or AVX instructions.  TODO:  Write an ARM variant if necessary.
+void SIMDMemCopy( void* __restrict _Dest, const void* __restrict _Source, size_t NumQuadwords )
 {
 	ASSERT(Math::IsAligned(_Dest, 16));
+	ASSERT(Math::IsAligned(_Source, 16));
 
-	register const __m128i Source = _mm_castps_si128(FillVector);
 	__m128i* __restrict Dest = (__m128i* __restrict)_Dest;
+	const __m128i* __restrict Source = (const __m128i* __restrict)_Source;
+	const size_t NumBytes = NumQuadwords << 4;
 
-	switch (((size_t)Dest >> 4) & 3)
-	{
-	case 1: _mm_stream_si128(Dest++, Source); --NumQuadwords;	 // Fall through
-	case 2: _mm_stream_si128(Dest++, Source); --NumQuadwords;	 // Fall through
-	case 3: _mm_stream_si128(Dest++, Source); --NumQuadwords;	 // Fall through
-	default:
-		break;
-	}
+	CopyRange(Dest, Source, NumQuadwords, NumBytes >= kNonTemporalThreshold);
+}
 
-	size_t WholeCacheLines = NumQuadwords >> 2;
+void SIMDMemCopyParallel( void* __restrict _Dest, const void* __restrict _Source, size_t NumQuadwords )
+{
+	ASSERT(Math::IsAligned(_Dest, 16));
+	ASSERT(Math::IsAligned(_Source, 16));
 
-	// Do four quadwords per loop to minimize stalls.
-	while (WholeCacheLines--)
+	__m128i* __restrict Dest = (__m128i* __restrict)_Dest;
+	const __m128i* __restrict Source = (const __m128i* __restrict)_Source;
+	const size_t NumBytes = NumQuadwords << 4;
+
+	if (NumBytes < kParallelThreshold || JobSystem::GetNumWorkers() == 0)
 	{
-		_mm_stream_si128(Dest++, Source);
-		_mm_stream_si128(Dest++, Source);
-		_mm_stream_si128(Dest++, Source);
-		_mm_stream_si128(Dest++, Source);
+		SIMDMemCopy(_Dest, _Source, NumQuadwords);
+		return;
 	}
 
-	// Copy the remaining quadwords
-	switch (NumQuadwords & 3)
+	JobSystem::ParallelFor(NumQuadwords, kParallelChunkSize >> 4, [=]( size_t Begin, size_t End )
 	{
-	case 3: _mm_stream_si128(Dest++, Source);	 // Fall through
-	case 2: _mm_stream_si128(Dest++, Source);	 // Fall through
-	case 1: _mm_stream_si128(Dest++, Source);	 // Fall through
-	default:
-		break;
-	}
+		CopyRange(Dest + Begin, Source + Begin, End - Begin, true);
+	});
+}
+
+void SIMDMemFill( void* __restrict _Dest, __m128 FillVector, size_t NumQuadwords )
+{
+	ASSERT(Math::IsAligned(_Dest, 16));
+
+	const __m128i Source = _mm_castps_si128(FillVector);
+	__m128i* __restrict Dest = (__m128i* __restrict)_Dest;
+	const size_t NumBytes = NumQuadwords << 4;
 
-	_mm_sfence();
+	FillRange(Dest, Source, NumQuadwords, NumBytes >= kNonTemporalThreshold);
 }
 
 std::wstring MakeWStr( const std::string& str )
@@ -139,4 +139,8 @@ namespace Utility
 void SIMDMemCopy( void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords );
 void SIMDMemFill( void* __restrict Dest, __m128 FillVector, size_t NumQuadwords );
 
+// Like SIMDMemCopy(), but splits very large copies across the job system's workers.  Don't call it while
+// holding a lock, since the copy may wait on other threads.
+void SIMDMemCopyParallel( void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords );
+
 std::wstring MakeWStr( const std::string& str );
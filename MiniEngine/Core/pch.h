@@ -48,7 +48,6 @@
 #include <exception>
 
 #include <wrl.h>
-#include <ppltasks.h>
 
 #include "Utility.h"
 #include "VectorMath.h"
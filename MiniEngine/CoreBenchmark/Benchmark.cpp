@@ -0,0 +1,146 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "pch.h"
+#include "Benchmark.h"
+#include "SystemTime.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Benchmark
+{
+	Options s_Options;
+	std::vector<Result> s_Results;
+	volatile uint64_t s_Sink = 0;
+
+	double TimeSample( const BodyFunc& Body, uint64_t Iterations )
+	{
+		int64_t StartTick = SystemTime::GetCurrentTick();
+		Body(Iterations);
+		int64_t EndTick = SystemTime::GetCurrentTick();
+		return SystemTime::TimeBetweenTicks(StartTick, EndTick);
+	}
+
+	// Grow the iteration count until one sample takes at least the minimum sample time
+	uint64_t CalibrateIterations( const BodyFunc& Body )
+	{
+		uint64_t Iterations = 1;
+
+		for (;;)
+		{
+			double Seconds = TimeSample(Body, Iterations);
+			if (Seconds >= s_Options.MinSampleTime || Iterations >= (1ull << 40))
+				return Iterations;
+
+			// Aim a little past the target so that noise does not leave the sample just short of it
+			double Scale = Seconds > 0.0 ? s_Options.MinSampleTime * 1.2 / Seconds : 100.0;
+			Iterations = std::max(Iterations + 1, (uint64_t)(Iterations * std::min(Scale, 100.0)));
+		}
+	}
+
+	void PrintEscaped( FILE* File, const std::string& String )
+	{
+		for (char c : String)
+		{
+			if (c == '"' || c == '\\')
+				fprintf(File, "\\%c", c);
+			else if ((unsigned char)c < 0x20)
+				fprintf(File, "\\u%04x", c);
+			else
+				fputc(c, File);
+		}
+	}
+}
+
+void Benchmark::SetOptions( const Options& NewOptions )
+{
+	ASSERT(NewOptions.Samples > 0);
+	s_Options = NewOptions;
+}
+
+void Benchmark::Run( const std::string& Name, uint64_t BytesPerOp, const BodyFunc& Body )
+{
+	if (!s_Options.Filter.empty() && Name.find(s_Options.Filter) == std::string::npos)
+		return;
+
+	uint64_t Iterations = CalibrateIterations(Body);
+
+	for (uint32_t i = 0; i < s_Options.WarmupSamples; ++i)
+		TimeSample(Body, Iterations);
+
+	std::vector<double> NsPerOp(s_Options.Samples);
+	for (uint32_t i = 0; i < s_Options.Samples; ++i)
+		NsPerOp[i] = TimeSample(Body, Iterations) * 1e9 / Iterations;
+
+	std::sort(NsPerOp.begin(), NsPerOp.end());
+
+	const size_t Count = NsPerOp.size();
+
+	Result NewResult;
+	NewResult.Name = Name;
+	NewResult.Iterations = Iterations;
+	NewResult.Samples = (uint32_t)Count;
+	NewResult.MedianNsPerOp = Count % 2 == 1 ? NsPerOp[Count / 2] : (NsPerOp[Count / 2 - 1] + NsPerOp[Count / 2]) * 0.5;
+	NewResult.P99NsPerOp = NsPerOp[(size_t)std::ceil(Count * 0.99) - 1];
+	NewResult.MinNsPerOp = NsPerOp[0];
+
+	double Sum = 0.0;
+	for (double Sample : NsPerOp)
+		Sum += Sample;
+	NewResult.MeanNsPerOp = Sum / Count;
+
+	NewResult.BytesPerSecond = BytesPerOp > 0 ? BytesPerOp * 1e9 / NewResult.MedianNsPerOp : 0.0;
+
+	s_Results.push_back(NewResult);
+
+	if (BytesPerOp > 0)
+	{
+		printf("%-48s %12.1f ns/op  (p99 %12.1f)  %9.2f GB/s\n", Name.c_str(), NewResult.MedianNsPerOp,
+			NewResult.P99NsPerOp, NewResult.BytesPerSecond / 1e9);
+	}
+	else
+	{
+		printf("%-48s %12.1f ns/op  (p99 %12.1f)\n", Name.c_str(), NewResult.MedianNsPerOp, NewResult.P99NsPerOp);
+	}
+}
+
+const std::vector<Benchmark::Result>& Benchmark::GetResults( void )
+{
+	return s_Results;
+}
+
+bool Benchmark::WriteJSON( const std::string& FileName )
+{
+	FILE* File = nullptr;
+	if (fopen_s(&File, FileName.c_str(), "w") != 0 || File == nullptr)
+		return false;
+
+	fprintf(File, "{\n\t\"benchmarks\": [\n");
+
+	for (size_t i = 0; i < s_Results.size(); ++i)
+	{
+		const Result& R = s_Results[i];
+
+		fprintf(File, "\t\t{ \"name\": \"");
+		PrintEscaped(File, R.Name);
+		fprintf(File, "\", \"iterations\": %llu, \"samples\": %u, \"median_ns\": %.3f, \"p99_ns\": %.3f, "
+			"\"min_ns\": %.3f, \"mean_ns\": %.3f, \"bytes_per_second\": %.1f }%s\n",
+			(unsigned long long)R.Iterations, R.Samples, R.MedianNsPerOp, R.P99NsPerOp, R.MinNsPerOp, R.MeanNsPerOp,
+			R.BytesPerSecond, i + 1 < s_Results.size() ? "," : "");
+	}
+
+	fprintf(File, "\t]\n}\n");
+	fclose(File);
+	return true;
+}
+
+void Benchmark::Consume( uint64_t Value )
+{
+	s_Sink = s_Sink + Value;
+}
@@ -0,0 +1,63 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Description:  A minimal microbenchmark harness.  A benchmark is a function which performs an operation a
+// given number of times.  The harness first finds an iteration count which takes long enough to time
+// reliably, runs a few untimed warmup samples, then times a number of samples and reports the median and
+// 99th percentile time per operation.  When a benchmark says how many bytes one operation touches, the
+// throughput is reported as well.
+//
+// Results are printed as a table, and can also be written as JSON so that they can be collected per commit
+// and compared.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Benchmark
+{
+	struct Options
+	{
+		Options() : WarmupSamples(2), Samples(15), MinSampleTime(0.01) {}
+
+		uint32_t WarmupSamples;
+		uint32_t Samples;			// With fewer than 100, the 99th percentile is the slowest sample
+		double MinSampleTime;		// In seconds.  The iteration count grows until a sample takes this long.
+		std::string Filter;			// Only run benchmarks whose name contains this
+	};
+
+	struct Result
+	{
+		std::string Name;
+		uint64_t Iterations;		// Per sample
+		uint32_t Samples;
+		double MedianNsPerOp;
+		double P99NsPerOp;
+		double MinNsPerOp;
+		double MeanNsPerOp;
+		double BytesPerSecond;		// At the median.  Zero when the benchmark does not move memory.
+	};
+
+	// Runs the operation Iterations times
+	typedef std::function<void(uint64_t Iterations)> BodyFunc;
+
+	void SetOptions( const Options& NewOptions );
+
+	// Time a benchmark and record its result.  BytesPerOp may be zero.
+	void Run( const std::string& Name, uint64_t BytesPerOp, const BodyFunc& Body );
+
+	const std::vector<Result>& GetResults( void );
+
+	// Write every result recorded so far.  Returns false if the file could not be opened.
+	bool WriteJSON( const std::string& FileName );
+
+	// Keep the compiler from discarding a computation whose result is otherwise unused
+	void Consume( uint64_t Value );
+}
@@ -0,0 +1,2135 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Microbenchmarks for the CPU side of Core.  Everything which needs a device runs on the null device, so
+// the results measure Core itself rather than a driver, and no GPU is required.
+//
+// usage:  CoreBenchmark [-filter <substring>] [-json <file>] [-samples <count>] [-warmup <count>]
+//
+
+#include "pch.h"
+#include "Benchmark.h"
+#include "SystemTime.h"
+#include "GraphicsCore.h"
+#include "CommandListManager.h"
+#include "CommandContext.h"
+#include "EngineProfiling.h"
+#include "GpuTimeManager.h"
+#include "LinearAllocator.h"
+#include "DynamicDescriptorHeap.h"
+#include "BuddyAllocator.h"
+#include "RootSignature.h"
+#include "PipelineState.h"
+#include "SamplerManager.h"
+#include "DDSTextureLoader.h"
+#include "dds.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+#include "SlidingWindowMinMax.h"
+#include "TextRenderer.h"
+#include "Camera.h"
+#include "ShadowCamera.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "NullDevice.h"
+#include "UploadManager.h"
+#include "ResourceStateTracker.h"
+#include "FramePacer.h"
+#include "FrameGraph.h"
+#include "Math/Random.h"
+#include "Math/BatchTransform.h"
+#include "Math/BoundingVolumes.h"
+#include "../ModelConverter/IndexOptimizePostTransform.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cfloat>
+
+using namespace Math;
+
+namespace
+{
+	const char* kSizeNames[] = { "64B", "1KB", "16KB", "256KB", "1MB", "4MB", "16MB", "64MB", "256MB" };
+	const size_t kSizes[] = { 64, 1 << 10, 16 << 10, 256 << 10, 1 << 20, 4 << 20, 16 << 20, 64 << 20, 256 << 20 };
+
+	void BenchmarkMemory( void )
+	{
+		const size_t MaxSize = kSizes[_countof(kSizes) - 1];
+		void* Source = _aligned_malloc(MaxSize, 64);
+		void* Dest = _aligned_malloc(MaxSize, 64);
+		memset(Source, 0x5A, MaxSize);
+		memset(Dest, 0, MaxSize);
+
+		// SIMDMemCopyParallel() splits very large copies across the job system's workers
+		JobSystem::Initialize();
+
+		for (size_t i = 0; i < _countof(kSizes); ++i)
+		{
+			const size_t Size = kSizes[i];
+
+			Benchmark::Run(std::string("SIMDMemCopy/") + kSizeNames[i], Size, [=]( uint64_t Iterations )
+			{
+				for (uint64_t n = 0; n < Iterations; ++n)
+					SIMDMemCopy(Dest, Source, Size >> 4);
+			});
+
+			if (Size >= (16 << 20))
+			{
+				Benchmark::Run(std::string("SIMDMemCopyParallel/") + kSizeNames[i], Size, [=]( uint64_t Iterations )
+				{
+					for (uint64_t n = 0; n < Iterations; ++n)
+						SIMDMemCopyParallel(Dest, Source, Size >> 4);
+				});
+			}
+
+			Benchmark::Run(std::string("SIMDMemFill/") + kSizeNames[i], Size, [=]( uint64_t Iterations )
+			{
+				__m128 FillVector = _mm_set1_ps(1.0f);
+				for (uint64_t n = 0; n < Iterations; ++n)
+					SIMDMemFill(Dest, FillVector, Size >> 4);
+			});
+
+			// The baseline the SIMD versions have to beat
+			Benchmark::Run(std::string("memcpy/") + kSizeNames[i], Size, [=]( uint64_t Iterations )
+			{
+				for (uint64_t n = 0; n < Iterations; ++n)
+					memcpy(Dest, Source, Size);
+			});
+		}
+
+		JobSystem::Shutdown();
+
+		_aligned_free(Source);
+		_aligned_free(Dest);
+	}
+
+	void BenchmarkHashing( void )
+	{
+		// Pipeline state descriptions are the most common thing hashed every frame
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC PSODesc = {};
+		PSODesc.SampleMask = 0xFFFFFFFFu;
+		PSODesc.NumRenderTargets = 1;
+		PSODesc.RTVFormats[0] = DXGI_FORMAT_R11G11B10_FLOAT;
+
+		Benchmark::Run("HashState/GraphicsPSODesc", sizeof(PSODesc), [&]( uint64_t Iterations )
+		{
+			size_t Hash = 0;
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Hash = Utility::HashState(&PSODesc, Hash);
+			Benchmark::Consume(Hash);
+		});
+
+		std::vector<uint32_t> Data(1024);
+		for (size_t i = 0; i < Data.size(); ++i)
+			Data[i] = (uint32_t)(i * 2654435761u);
+
+		Benchmark::Run("HashRange/4KB", Data.size() * sizeof(uint32_t), [&]( uint64_t Iterations )
+		{
+			size_t Hash = 0;
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Hash = Utility::HashRange(Data.data(), Data.data() + Data.size(), Hash);
+			Benchmark::Consume(Hash);
+		});
+	}
+
+	// The null device's queues, through CommandListManager.  Without a simulated latency work completes as it is
+	// submitted.  With one, waiting on a fence takes at least that long per batch and leaves the fence complete,
+	// a batch which waits on another queue does not start until that queue's fence completes, and fence
+	// callbacks run once their fence has completed.
+	bool CheckNullDevice( void )
+	{
+		using namespace Graphics;
+
+		const uint32_t kLatency = 2000;
+		CommandQueue& GraphicsQueue = g_CommandManager.GetGraphicsQueue();
+		CommandQueue& ComputeQueue = g_CommandManager.GetComputeQueue();
+
+		NullDevice::SetSimulatedLatency(0);
+		uint64_t ImmediateFence = CommandContext::Begin().Finish();
+		bool Passed = g_CommandManager.IsFenceComplete(ImmediateFence);
+
+		NullDevice::SetSimulatedLatency(kLatency);
+
+		int64_t SubmitTick = SystemTime::GetCurrentTick();
+		uint64_t GraphicsFence = CommandContext::Begin().Finish();
+
+		bool CallbackRan = false;
+		GraphicsQueue.OnFenceComplete(GraphicsFence, [&] { CallbackRan = true; });
+
+		ComputeQueue.StallForProducer(GraphicsQueue);
+		uint64_t ComputeFence = ComputeContext::Begin(L"", true).Finish();
+
+		g_CommandManager.WaitForFence(ComputeFence);
+		double WaitTime = SystemTime::TimeBetweenTicks(SubmitTick, SystemTime::GetCurrentTick());
+		GraphicsQueue.ProcessCompletedFences();
+
+		Passed = Passed && g_CommandManager.IsFenceComplete(ComputeFence) && g_CommandManager.IsFenceComplete(GraphicsFence);
+		Passed = Passed && WaitTime >= 2.0 * kLatency * 1e-6;
+		Passed = Passed && CallbackRan;
+
+		NullDevice::SetSimulatedLatency(0);
+
+		printf("%-48s %s\n", "Null device queues", Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	// Contexts go back to the pool after being begun with a profiling block name.  The same contexts handed
+	// out again by BeginMultiple() have no name, so flushing or finishing them must not end a block.
+	bool CheckPooledContextProfiling( void )
+	{
+		// Name more contexts than the pool holds, so that every pooled context has been named
+		CommandContext* Named[CommandContext::kMaxBatchContexts];
+		for (UINT i = 0; i < CommandContext::kMaxBatchContexts; ++i)
+			Named[i] = &CommandContext::Begin(L"Named Context");
+		CommandContext::FinishBatch(Named, CommandContext::kMaxBatchContexts);
+
+		const UINT kNumContexts = 4;
+		GraphicsContext* Pooled[kNumContexts];
+
+		EngineProfiling::BeginBlock(L"Pooled Context Check");
+
+		GraphicsContext& MainContext = GraphicsContext::Begin();
+		GraphicsContext::BeginMultiple(kNumContexts, Pooled);
+		MainContext.FlushWith((CommandContext**)Pooled, kNumContexts);
+		bool Passed = EngineProfiling::GetBlockDepth() == 1;
+
+		if (Passed)
+		{
+			GraphicsContext::BeginMultiple(kNumContexts, Pooled);
+			CommandContext::FinishBatch((CommandContext**)Pooled, kNumContexts);
+			Passed = EngineProfiling::GetBlockDepth() == 1;
+		}
+
+		MainContext.Finish();
+
+		// Otherwise an unmatched EndBlock() has already closed the outer block
+		if (Passed)
+			EngineProfiling::EndBlock();
+		Passed = Passed && EngineProfiling::GetBlockDepth() == 0;
+
+		printf("%-48s %s\n", "Pooled context profiling", Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	void BenchmarkLinearAllocator( void )
+	{
+		const size_t kAllocationsPerFrame = 1024;
+
+		for (size_t AllocationSize : { (size_t)256, (size_t)4096 })
+		{
+			LinearAllocator Allocator(kCpuWritable);
+
+			// Retire the pages every "frame" as a context would, so the steady state reuses pages
+			Benchmark::Run("LinearAllocator::Allocate/" + std::to_string(AllocationSize) + "B", 0, [&]( uint64_t Iterations )
+			{
+				for (uint64_t n = 0; n < Iterations; ++n)
+				{
+					DynAlloc Allocation = Allocator.Allocate(AllocationSize);
+					Benchmark::Consume((uint64_t)Allocation.DataPtr);
+
+					if (n % kAllocationsPerFrame == kAllocationsPerFrame - 1)
+						Allocator.CleanupUsedPages(Graphics::g_CommandManager.GetGraphicsQueue().IncrementFence());
+				}
+				Allocator.CleanupUsedPages(Graphics::g_CommandManager.GetGraphicsQueue().IncrementFence());
+			});
+		}
+	}
+
+	void BenchmarkDynamicDescriptors( void )
+	{
+		const UINT kTableSize = 8;
+		const uint64_t kDispatchesPerContext = 1024;
+
+		RootSignature RootSig(1);
+		RootSig[0].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, kTableSize);
+		RootSig.Finalize();
+
+		D3D12_CPU_DESCRIPTOR_HANDLE Handles[kTableSize];
+		for (UINT i = 0; i < kTableSize; ++i)
+			Handles[i] = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+		// Each dispatch stages a full table and then copies and binds it.  Contexts are finished periodically
+		// so that used descriptor heaps are retired and recycled as they are in a real frame.
+		Benchmark::Run("DynamicDescriptorHeap/CopyAndBindStagedTables", 0, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; n += kDispatchesPerContext)
+			{
+				ComputeContext& Context = ComputeContext::Begin();
+				Context.SetRootSignature(RootSig);
+
+				uint64_t Count = std::min(kDispatchesPerContext, Iterations - n);
+				for (uint64_t i = 0; i < Count; ++i)
+				{
+					Context.SetDynamicDescriptors(0, 0, kTableSize, Handles);
+					Context.Dispatch();
+				}
+
+				Context.Finish();
+			}
+		});
+	}
+
+	// Besides timing them, check that the sampler and sampler table caches return one descriptor per distinct desc
+	bool BenchmarkSamplers( void )
+	{
+		const uint32_t kNumCreates = 1000;
+		bool Passed = true;
+
+		SamplerDesc Desc;
+		Desc.SetTextureAddressMode(D3D12_TEXTURE_ADDRESS_MODE_CLAMP);
+
+		size_t SamplersBefore = SamplerDescriptor::GetNumCachedSamplers();
+		SamplerDescriptor First;
+		First.Create(Desc);
+
+		for (uint32_t i = 1; i < kNumCreates; ++i)
+		{
+			SamplerDescriptor Sampler;
+			Sampler.Create(Desc);
+			if (Sampler.GetCpuDescriptorHandle().ptr != First.GetCpuDescriptorHandle().ptr)
+				Passed = false;
+		}
+
+		if (SamplerDescriptor::GetNumCachedSamplers() != SamplersBefore + 1)
+			Passed = false;
+
+		SamplerDesc PointDesc;
+		PointDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+		SamplerDescriptor Point;
+		Point.Create(PointDesc);
+
+		D3D12_CPU_DESCRIPTOR_HANDLE Table[2] = { First.GetCpuDescriptorHandle(), Point.GetCpuDescriptorHandle() };
+
+		size_t TablesBefore = SamplerDescriptor::GetNumCachedTables();
+		D3D12_GPU_DESCRIPTOR_HANDLE FirstTable = SamplerDescriptor::GetShaderVisibleTable(2, Table);
+
+		for (uint32_t i = 1; i < kNumCreates; ++i)
+		{
+			if (SamplerDescriptor::GetShaderVisibleTable(2, Table).ptr != FirstTable.ptr)
+				Passed = false;
+		}
+
+		if (SamplerDescriptor::GetNumCachedTables() != TablesBefore + 1)
+			Passed = false;
+
+		printf("%-48s %s\n", "SamplerDescriptor cache", Passed ? "passed" : "FAILED:  identical samplers were created twice");
+
+		// Fill the table heap with ever longer tables.  Once it is full, new tables come back null and old ones still resolve.
+		bool HeapFilled = false;
+		std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> LongTable;
+		for (uint32_t i = 0; i < D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE && !HeapFilled; ++i)
+		{
+			LongTable.push_back(Point.GetCpuDescriptorHandle());
+			HeapFilled = SamplerDescriptor::GetShaderVisibleTable((UINT)LongTable.size(), LongTable.data()).ptr == 0;
+		}
+
+		bool CapacityPassed = HeapFilled && SamplerDescriptor::GetShaderVisibleTable(2, Table).ptr == FirstTable.ptr;
+		printf("%-48s %s\n", "SamplerDescriptor table heap capacity", CapacityPassed ? "passed" : "FAILED:  a full table heap did not return a null handle");
+		Passed = Passed && CapacityPassed;
+
+		Benchmark::Run("SamplerDescriptor::Create/Cached", 0, [&]( uint64_t Iterations )
+		{
+			SamplerDescriptor Sampler;
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Sampler.Create(Desc);
+			Benchmark::Consume(Sampler.GetCpuDescriptorHandle().ptr);
+		});
+
+		RootSignature RootSig(1);
+		RootSig[0].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 0, 2);
+		RootSig.Finalize();
+
+		// Binding a sampler table:  look it up by its samplers, then set it on the shared sampler heap
+		Benchmark::Run("ComputeContext/SamplerTable", 0, [&]( uint64_t Iterations )
+		{
+			const uint64_t kDispatchesPerContext = 1024;
+
+			for (uint64_t n = 0; n < Iterations; n += kDispatchesPerContext)
+			{
+				ComputeContext& Context = ComputeContext::Begin();
+				Context.SetRootSignature(RootSig);
+				Context.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, SamplerDescriptor::GetShaderVisibleHeap());
+
+				uint64_t Count = std::min(kDispatchesPerContext, Iterations - n);
+				for (uint64_t i = 0; i < Count; ++i)
+				{
+					Context.SetDescriptorTable(0, SamplerDescriptor::GetShaderVisibleTable(2, Table));
+					Context.Dispatch();
+				}
+
+				Context.Finish();
+			}
+		});
+
+		return Passed;
+	}
+
+	void BenchmarkBuddyAllocator( void )
+	{
+		const uint32_t kBlocksPerRound = 256;
+
+		BuddyAllocator Allocator(kManualSubAllocationStrategy, D3D12_HEAP_TYPE_DEFAULT, 64 << 20, 256);
+		Allocator.Initialize();
+
+		RandomNumberGenerator Random;
+		std::vector<uint32_t> Sizes(kBlocksPerRound);
+		for (uint32_t i = 0; i < kBlocksPerRound; ++i)
+			Sizes[i] = (uint32_t)Random.NextInt(16, 64 << 10);
+
+		std::vector<BuddyBlock*> Blocks;
+		Blocks.reserve(kBlocksPerRound);
+
+		// Fill the allocator with blocks of mixed sizes, then release everything at once
+		Benchmark::Run("BuddyAllocator::Allocate/Mixed", 0, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				Blocks.push_back(Allocator.Allocate(Sizes[n % kBlocksPerRound], 1));
+
+				if (Blocks.size() == kBlocksPerRound || n + 1 == Iterations)
+				{
+					for (BuddyBlock* Block : Blocks)
+						delete Block;
+					Blocks.clear();
+					Allocator.Reset();
+				}
+			}
+		});
+
+		Allocator.Destroy();
+	}
+
+	// One operation is one glyph, so the rate in glyphs per microsecond is 1000 over the time per operation
+	template <typename StringType>
+	void BenchmarkDrawString( const std::string& Name, const StringType& Line )
+	{
+		const uint64_t kLinesPerContext = 1024;
+
+		Benchmark::Run(Name, 0, [&]( uint64_t Iterations )
+		{
+			const uint64_t NumLines = std::max(Iterations / Line.size(), (uint64_t)1);
+
+			for (uint64_t n = 0; n < NumLines; n += kLinesPerContext)
+			{
+				GraphicsContext& Context = GraphicsContext::Begin();
+				TextContext Text(Context);
+				Text.Begin();
+
+				uint64_t Count = std::min(kLinesPerContext, NumLines - n);
+				for (uint64_t i = 0; i < Count; ++i)
+				{
+					Text.ResetCursor(10.0f, 10.0f);
+					Text.DrawString(Line);
+				}
+
+				Text.End();
+				Context.Finish();
+			}
+		});
+	}
+
+	void BenchmarkTextRenderer( void )
+	{
+		TextRenderer::Initialize();
+
+		// The length of a typical line in the tuning menu or the profiler
+		BenchmarkDrawString("TextContext::DrawString/ASCII (per glyph)",
+			std::string("Graphics/Display/Native Resolution:  1920x1080"));
+		BenchmarkDrawString("TextContext::DrawString/Wide (per glyph)",
+			std::wstring(L"Graphics/Display/Native Resolution:  1920x1080"));
+
+		TextRenderer::Shutdown();
+	}
+
+	void BenchmarkFrustumCulling( void )
+	{
+		const uint32_t kNumSpheres = 4096;
+
+		Camera Cam;
+		Cam.SetEyeAtUp(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, -1.0f), Vector3(kYUnitVector));
+		Cam.Update();
+		Frustum WorldFrustum = Cam.GetWorldSpaceFrustum();
+
+		RandomNumberGenerator Random;
+		std::vector<BoundingSphere> Spheres;
+		Spheres.reserve(kNumSpheres);
+		for (uint32_t i = 0; i < kNumSpheres; ++i)
+		{
+			Vector3 Center(Random.NextFloat(-500.0f, 500.0f), Random.NextFloat(-500.0f, 500.0f), Random.NextFloat(-1000.0f, 0.0f));
+			Spheres.push_back(BoundingSphere(Center, Scalar(Random.NextFloat(1.0f, 20.0f))));
+		}
+
+		Benchmark::Run("Frustum::IntersectSphere", 0, [&]( uint64_t Iterations )
+		{
+			uint64_t NumVisible = 0;
+			for (uint64_t n = 0; n < Iterations; ++n)
+				NumVisible += WorldFrustum.IntersectSphere(Spheres[n % kNumSpheres]) ? 1 : 0;
+			Benchmark::Consume(NumVisible);
+		});
+
+		// The same objects as boxes, axis-aligned and then rotated
+		std::vector<AxisAlignedBox> Boxes;
+		Boxes.reserve(kNumSpheres);
+		for (uint32_t i = 0; i < kNumSpheres; ++i)
+		{
+			Vector3 Extent = Vector3(Spheres[i].GetRadius()) * 0.577f;
+			Boxes.push_back(AxisAlignedBox(Spheres[i].GetCenter() - Extent, Spheres[i].GetCenter() + Extent));
+		}
+
+		const AffineTransform Rotation(Matrix3::MakeYRotation(0.5f));
+		std::vector<OrientedBox> OrientedBoxes;
+		OrientedBoxes.reserve(kNumSpheres);
+		for (uint32_t i = 0; i < kNumSpheres; ++i)
+			OrientedBoxes.push_back(OrientedBox(Rotation, Boxes[i]));
+
+		Benchmark::Run("Frustum::IntersectBoundingBox", 0, [&]( uint64_t Iterations )
+		{
+			uint64_t NumVisible = 0;
+			for (uint64_t n = 0; n < Iterations; ++n)
+				NumVisible += WorldFrustum.IntersectBoundingBox(Boxes[n % kNumSpheres]) ? 1 : 0;
+			Benchmark::Consume(NumVisible);
+		});
+
+		Benchmark::Run("Frustum::IntersectOrientedBox", 0, [&]( uint64_t Iterations )
+		{
+			uint64_t NumVisible = 0;
+			for (uint64_t n = 0; n < Iterations; ++n)
+				NumVisible += WorldFrustum.IntersectOrientedBox(OrientedBoxes[n % kNumSpheres]) ? 1 : 0;
+			Benchmark::Consume(NumVisible);
+		});
+	}
+
+	void BenchmarkOptimizeFaces( void )
+	{
+		// A 128x128 quad grid with its triangles shuffled, which is about as cache-unfriendly as meshes get
+		const uint32_t kGridSize = 128;
+		std::vector<uint16_t> Indices;
+		Indices.reserve(kGridSize * kGridSize * 6);
+
+		for (uint32_t y = 0; y < kGridSize; ++y)
+		{
+			for (uint32_t x = 0; x < kGridSize; ++x)
+			{
+				uint32_t Corner = y * (kGridSize + 1) + x;
+				uint32_t Quad[6] = { Corner, Corner + 1, Corner + kGridSize + 1, Corner + 1, Corner + kGridSize + 2, Corner + kGridSize + 1 };
+				for (uint32_t k = 0; k < 6; ++k)
+					Indices.push_back((uint16_t)Quad[k]);
+			}
+		}
+
+		RandomNumberGenerator Random;
+		const uint32_t NumTriangles = (uint32_t)Indices.size() / 3;
+		for (uint32_t i = NumTriangles - 1; i > 0; --i)
+		{
+			uint32_t j = (uint32_t)Random.NextInt(0, i);
+			for (uint32_t k = 0; k < 3; ++k)
+				std::swap(Indices[i * 3 + k], Indices[j * 3 + k]);
+		}
+
+		std::vector<uint16_t> Optimized(Indices.size());
+
+		Benchmark::Run("OptimizeFaces/128x128Grid", Indices.size() * sizeof(uint16_t), [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Graphics::OptimizeFaces<uint16_t>(Indices.data(), (uint32_t)Indices.size(), Optimized.data(), 64);
+		});
+	}
+
+	void BenchmarkJobSystem( void )
+	{
+		// Scheduling overhead:  the cost of running an empty job, from Run() until Wait() sees it complete
+		JobSystem::Initialize();
+
+		Benchmark::Run("JobSystem/RunAndWait", 0, [&]( uint64_t Iterations )
+		{
+			JobSystem::Counter JobCounter;
+			for (uint64_t n = 0; n < Iterations; ++n)
+				JobSystem::Run([]{}, &JobCounter);
+			JobSystem::Wait(JobCounter);
+		});
+
+		JobSystem::Shutdown();
+
+		// Scaling:  a fixed amount of arithmetic split with ParallelFor over an increasing number of workers
+		const size_t kNumElements = 1 << 20;
+		std::vector<float> Elements(kNumElements);
+		for (size_t i = 0; i < kNumElements; ++i)
+			Elements[i] = (float)i;
+
+		uint32_t NumHardwareThreads = std::thread::hardware_concurrency();
+		uint32_t MaxWorkers = NumHardwareThreads > 1 ? NumHardwareThreads - 1 : 1;
+
+		for (uint32_t NumWorkers = 1; ; NumWorkers = std::min(NumWorkers * 2, MaxWorkers))
+		{
+			JobSystem::Initialize(NumWorkers);
+
+			Benchmark::Run("JobSystem/ParallelFor/Workers:" + std::to_string(NumWorkers), 0, [&]( uint64_t Iterations )
+			{
+				for (uint64_t n = 0; n < Iterations; ++n)
+				{
+					JobSystem::ParallelFor(kNumElements, 0, [&]( size_t Begin, size_t End )
+					{
+						for (size_t i = Begin; i < End; ++i)
+							Elements[i] = sqrtf(Elements[i] * 0.5f + 1.0f);
+					});
+				}
+			});
+
+			JobSystem::Shutdown();
+
+			if (NumWorkers == MaxWorkers)
+				break;
+		}
+	}
+
+	// Compute the layout of a synthetic DDS header:  a two-slice array of 256x256 BC1 textures with full mip chains
+	bool CheckDDSLayout( void )
+	{
+		uint8_t HeaderData[DDS_MAX_HEADER_SIZE] = {};
+		*(uint32_t*)HeaderData = DDS_MAGIC;
+
+		DDS_HEADER* Header = (DDS_HEADER*)(HeaderData + sizeof(uint32_t));
+		Header->size = sizeof(DDS_HEADER);
+		Header->flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_MIPMAP;
+		Header->width = 256;
+		Header->height = 256;
+		Header->mipMapCount = 9;
+		Header->ddspf.size = sizeof(DDS_PIXELFORMAT);
+		Header->ddspf.flags = DDS_FOURCC;
+		Header->ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		DDS_HEADER_DXT10* Header10 = (DDS_HEADER_DXT10*)(Header + 1);
+		Header10->dxgiFormat = DXGI_FORMAT_BC1_UNORM;
+		Header10->resourceDimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		Header10->arraySize = 2;
+
+		// BC1 mips take 32768, 8192, 2048, 512, 128, 32, 8, 8 and 8 bytes
+		const size_t kSliceSize = 43704;
+		bool Passed = true;
+
+		DDS_TEXTURE_LAYOUT Layout;
+		Passed = Passed && SUCCEEDED(GetDDSTextureLayout(HeaderData, sizeof(HeaderData), 0, 0, &Layout));
+		Passed = Passed && Layout.mipCount == 9 && Layout.arraySize == 2 && Layout.skipMip == 0;
+		Passed = Passed && Layout.dataOffset == DDS_MAX_HEADER_SIZE && Layout.sliceSize == kSliceSize;
+		Passed = Passed && Layout.mips[0].rowPitch == 512 && Layout.mips[8].offset == kSliceSize - 8;
+
+		// Mips larger than 64 texels are skipped
+		Passed = Passed && SUCCEEDED(GetDDSTextureLayout(HeaderData, sizeof(HeaderData), 64, 0, &Layout));
+		Passed = Passed && Layout.skipMip == 2 && Layout.mips[2].width == 64 && Layout.mips[2].offset == 40960;
+
+		// A BC1 top mip must be a whole number of blocks, so the 4x4 mip is always kept
+		Passed = Passed && SUCCEEDED(GetDDSTextureLayout(HeaderData, sizeof(HeaderData), 0, 20, &Layout));
+		Passed = Passed && Layout.skipMip == 6 && Layout.mips[6].width == 4;
+
+		// Without blocks, the smallest mip is always kept
+		Header10->dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+		Passed = Passed && SUCCEEDED(GetDDSTextureLayout(HeaderData, sizeof(HeaderData), 0, 20, &Layout));
+		Passed = Passed && Layout.skipMip == 8;
+		Header10->dxgiFormat = DXGI_FORMAT_BC1_UNORM;
+
+		// A truncated header is rejected
+		Passed = Passed && FAILED(GetDDSTextureLayout(HeaderData, DDS_MAX_HEADER_SIZE - 1, 0, 0, &Layout));
+
+		printf("%-48s %s\n", "DDS layout", Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	// A GpuResource with a made up ID3D12Resource pointer.  The state tracker only compares and stores the
+	// pointers, so nothing is ever called through them.
+	class FakeResource : public GpuResource
+	{
+	public:
+		FakeResource( uintptr_t ID, D3D12_RESOURCE_STATES State )
+		{
+			m_pResource.Attach((ID3D12Resource*)ID);
+			m_UsageState = State;
+		}
+
+		~FakeResource() { m_pResource.Detach(); }
+	};
+
+	bool IsTransition( const D3D12_RESOURCE_BARRIER& Barrier, const GpuResource& Resource, D3D12_RESOURCE_STATES Before,
+		D3D12_RESOURCE_STATES After, D3D12_RESOURCE_BARRIER_FLAGS Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE )
+	{
+		return Barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && Barrier.Flags == Flags &&
+			Barrier.Transition.pResource == Resource.GetResource() &&
+			Barrier.Transition.StateBefore == Before && Barrier.Transition.StateAfter == After;
+	}
+
+	// Record on several state trackers as if on parallel contexts, then resolve them in execution order and
+	// check the barriers each one produced
+	bool CheckResourceStateTracker( void )
+	{
+		const D3D12_RESOURCE_STATES kCommon = D3D12_RESOURCE_STATE_COMMON;
+		const D3D12_RESOURCE_STATES kRenderTarget = D3D12_RESOURCE_STATE_RENDER_TARGET;
+		const D3D12_RESOURCE_STATES kShaderResource = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+		const D3D12_RESOURCE_STATES kUnorderedAccess = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+		const D3D12_RESOURCE_STATES kCopySource = D3D12_RESOURCE_STATE_COPY_SOURCE;
+		const D3D12_RESOURCE_STATES kCopyDest = D3D12_RESOURCE_STATE_COPY_DEST;
+
+		FakeResource Texture(0x1000, kCommon);
+		FakeResource Buffer(0x2000, kCopyDest);
+		FakeResource Target(0x3000, kShaderResource);
+
+		ResourceStateTracker First(D3D12_COMMAND_LIST_TYPE_DIRECT);
+		ResourceStateTracker Second(D3D12_COMMAND_LIST_TYPE_DIRECT);
+		ResourceStateTracker Third(D3D12_COMMAND_LIST_TYPE_DIRECT);
+		std::vector<D3D12_RESOURCE_BARRIER> Fixups[3];
+		bool Passed = true;
+
+		// The first use in a context needs no barrier, only a fix-up at execution.  The second context does
+		// not see the first one's states while recording.
+		First.TransitionResource(Texture, kRenderTarget);
+		Passed = Passed && First.GetPendingBarrierCount() == 0 && First.GetCurrentState(Texture) == kRenderTarget;
+		First.TransitionResource(Texture, kShaderResource);
+		Passed = Passed && First.GetPendingBarrierCount() == 1 &&
+			IsTransition(First.GetPendingBarriers()[0], Texture, kRenderTarget, kShaderResource);
+		First.ClearPendingBarriers();
+
+		Passed = Passed && Second.GetCurrentState(Texture) == kCommon;
+		Second.TransitionResource(Texture, kUnorderedAccess);
+		Passed = Passed && Second.GetPendingBarrierCount() == 1 &&
+			Second.GetPendingBarriers()[0].Type == D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		Second.ClearPendingBarriers();
+
+		// Buffered transitions of one resource merge, and disappear when they return to where they started
+		Third.TransitionResource(Buffer, kCopySource);
+		Third.ClearPendingBarriers();
+		Third.TransitionResource(Buffer, kCopyDest);
+		Third.TransitionResource(Buffer, kShaderResource);
+		Passed = Passed && Third.GetPendingBarrierCount() == 1 &&
+			IsTransition(Third.GetPendingBarriers()[0], Buffer, kCopySource, kShaderResource);
+		Third.TransitionResource(Buffer, kCopySource);
+		Passed = Passed && Third.GetPendingBarrierCount() == 0;
+
+		// A split barrier with no work between its halves collapses into one barrier.  With work between
+		// them it ends with an END_ONLY barrier.
+		Third.TransitionResource(Target, kShaderResource);
+		Third.BeginResourceTransition(Target, kRenderTarget);
+		Passed = Passed && Third.GetPendingBarrierCount() == 1 && IsTransition(Third.GetPendingBarriers()[0], Target,
+			kShaderResource, kRenderTarget, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+		Third.TransitionResource(Target, kRenderTarget);
+		Passed = Passed && Third.GetPendingBarrierCount() == 1 &&
+			IsTransition(Third.GetPendingBarriers()[0], Target, kShaderResource, kRenderTarget);
+		Third.ClearPendingBarriers();
+
+		Third.BeginResourceTransition(Target, kShaderResource);
+		Third.ClearPendingBarriers();
+		Third.EndSplitTransitions();
+		Passed = Passed && Third.GetPendingBarrierCount() == 1 && IsTransition(Third.GetPendingBarriers()[0], Target,
+			kRenderTarget, kShaderResource, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+		Third.ClearPendingBarriers();
+
+		// Resolving in execution order chains each context's final states into the next one's fix-ups
+		{
+			std::lock_guard<std::mutex> LockGuard(ResourceStateTracker::GetGlobalStateMutex());
+			First.ResolveGlobalStates(Fixups[0]);
+			Second.ResolveGlobalStates(Fixups[1]);
+			Third.ResolveGlobalStates(Fixups[2]);
+		}
+
+		Passed = Passed && Fixups[0].size() == 1 && IsTransition(Fixups[0][0], Texture, kCommon, kRenderTarget);
+		Passed = Passed && Fixups[1].size() == 1 && IsTransition(Fixups[1][0], Texture, kShaderResource, kUnorderedAccess);
+		Passed = Passed && Fixups[2].size() == 1 && IsTransition(Fixups[2][0], Buffer, kCopyDest, kCopySource);
+
+		Passed = Passed && ResourceStateTracker::GetGlobalState(Texture) == kUnorderedAccess;
+		Passed = Passed && ResourceStateTracker::GetGlobalState(Buffer) == kCopySource;
+		Passed = Passed && ResourceStateTracker::GetGlobalState(Target) == kShaderResource;
+		Passed = Passed && First.GetCurrentState(Texture) == kUnorderedAccess;
+
+		printf("%-48s %s\n", "Resource state tracker", Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	// Compile a made up pass list with a fake size query, so no device is needed.  One pass is culled, and the
+	// first and last textures alias because their lifetimes do not overlap.
+	bool CheckFrameGraph( void )
+	{
+		typedef FrameGraph::ResourceHandle ResourceHandle;
+		const D3D12_RESOURCE_STATES kShaderResource = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+		const D3D12_RESOURCE_STATES kUnorderedAccess = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+		const uint64_t kAlignment = 64 * 1024;
+
+		FakeResource Output(0x4000, kShaderResource);
+
+		FrameGraph Graph(L"Check");
+		Graph.Reset();
+
+		FrameGraph::TextureDesc Large = { 512, 512, DXGI_FORMAT_R8G8B8A8_UNORM };
+		FrameGraph::TextureDesc Small = { 256, 256, DXGI_FORMAT_R8G8B8A8_UNORM };
+		ResourceHandle Imported = Graph.ImportResource(Output);
+		ResourceHandle Textures[3] = { Graph.CreateTexture(L"A", Large), Graph.CreateTexture(L"B", Large), Graph.CreateTexture(L"C", Small) };
+		ResourceHandle Unused = Graph.CreateTexture(L"Unused", Large);
+		const ResourceHandle A = Textures[0], B = Textures[1], C = Textures[2];
+
+		// The first and last pass each texture is used in
+		const uint32_t kLifetimes[3][2] = { { 0, 1 }, { 1, 3 }, { 3, 5 } };
+
+		auto NoWork = []( ComputeContext&, const FrameGraph::PassResources& ) {};
+		Graph.AddPass(L"Write A", [=]( FrameGraph::PassBuilder& Builder ) { Builder.Write(A); }, NoWork);
+		Graph.AddPass(L"A to B", [=]( FrameGraph::PassBuilder& Builder ) { Builder.Read(A); Builder.Write(B); }, NoWork);
+		Graph.AddPass(L"Nobody reads this", [=]( FrameGraph::PassBuilder& Builder ) { Builder.Read(B); Builder.Write(Unused); }, NoWork);
+		Graph.AddPass(L"B to C", [=]( FrameGraph::PassBuilder& Builder ) { Builder.Read(B); Builder.Write(C); }, NoWork);
+		Graph.AddPass(L"C in place", [=]( FrameGraph::PassBuilder& Builder ) { Builder.Read(C, kUnorderedAccess); Builder.Write(C); }, NoWork);
+		Graph.AddPass(L"C to output", [=]( FrameGraph::PassBuilder& Builder ) { Builder.Read(C); Builder.Write(Imported); }, NoWork);
+
+		Graph.Compile([=]( const FrameGraph::TextureDesc& Desc )
+		{
+			uint64_t Size = ((uint64_t)Desc.Width * Desc.Height * 4 + kAlignment - 1) & ~(kAlignment - 1);
+			FrameGraph::AllocationInfo Info = { Size, kAlignment };
+			return Info;
+		});
+
+		const FrameGraph::Stats& Stats = Graph.GetStats();
+		bool Passed = Stats.NumPasses == 6 && Stats.NumCulledPasses == 1 && Graph.IsPassCulled(2);
+		Passed = Passed && Stats.NumTransientTextures == 3;
+		Passed = Passed && Stats.HeapBytes == 2 * 1024 * 1024 && Stats.UnaliasedBytes == 2 * 1024 * 1024 + 256 * 1024;
+
+		// Textures alive at the same time never share memory
+		auto SizeOf = [=]( ResourceHandle Texture ) { return Texture == C ? 256 * 1024ull : 1024 * 1024ull; };
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			for (uint32_t j = i + 1; j < 3; ++j)
+			{
+				bool LifetimesOverlap = kLifetimes[i][0] <= kLifetimes[j][1] && kLifetimes[j][0] <= kLifetimes[i][1];
+				uint64_t Offsets[2] = { Graph.GetHeapOffset(Textures[i]), Graph.GetHeapOffset(Textures[j]) };
+				bool MemoryOverlaps = Offsets[0] < Offsets[1] + SizeOf(Textures[j]) && Offsets[1] < Offsets[0] + SizeOf(Textures[i]);
+				Passed = Passed && !(LifetimesOverlap && MemoryOverlaps);
+			}
+		}
+		Passed = Passed && Graph.GetHeapOffset(C) == Graph.GetHeapOffset(A);
+
+		auto FindBarrier = [&Graph]( uint32_t PassIndex, FrameGraph::BarrierType Type, ResourceHandle Resource )
+		{
+			const std::vector<FrameGraph::Barrier>& Barriers = Graph.GetPassBarriers(PassIndex);
+			for (size_t i = 0; i < Barriers.size(); ++i)
+			{
+				if (Barriers[i].Type == Type && Barriers[i].Resource == Resource)
+					return (int)i;
+			}
+			return -1;
+		};
+
+		// Each texture is discarded once, at its first use, after the aliasing barrier which hands it the memory
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			uint32_t NumDiscards = 0;
+			for (uint32_t PassIndex = 0; PassIndex < Stats.NumPasses; ++PassIndex)
+				NumDiscards += FindBarrier(PassIndex, FrameGraph::kDiscard, Textures[i]) >= 0 ? 1 : 0;
+
+			int Discard = FindBarrier(kLifetimes[i][0], FrameGraph::kDiscard, Textures[i]);
+			Passed = Passed && NumDiscards == 1 && Discard >= 0 &&
+				Graph.GetPassBarriers(kLifetimes[i][0])[Discard].StateAfter == kUnorderedAccess;
+		}
+
+		int AliasC = FindBarrier(3, FrameGraph::kAliasingBarrier, C);
+		Passed = Passed && AliasC >= 0 && Graph.GetPassBarriers(3)[AliasC].AliasedResource == A;
+		Passed = Passed && AliasC < FindBarrier(3, FrameGraph::kDiscard, C);
+		Passed = Passed && FindBarrier(1, FrameGraph::kAliasingBarrier, B) < 0;
+
+		// Writing C twice in a row needs a UAV barrier, and reading it after needs a transition
+		Passed = Passed && FindBarrier(4, FrameGraph::kUAVBarrier, C) >= 0;
+		int ReadC = FindBarrier(5, FrameGraph::kTransitionBarrier, C);
+		Passed = Passed && ReadC >= 0 && Graph.GetPassBarriers(5)[ReadC].StateAfter == kShaderResource;
+		Passed = Passed && FindBarrier(5, FrameGraph::kTransitionBarrier, Imported) >= 0;
+
+		printf("%-48s %s\n", "Frame graph aliasing", Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	// Drive the upload ring with a fake fence.  Fill it, retire part of it, and check that allocations wrap
+	// around to the retired space without overlapping anything still in flight.
+	bool CheckUploadRing( void )
+	{
+		struct Range
+		{
+			size_t Offset;
+			size_t Size;
+			uint64_t FenceValue;
+		};
+
+		const size_t kRingSize = 1024 * 1024;
+		const size_t kChunk = 64 * 1024;
+
+		UploadRing Ring;
+		Ring.Reset(kRingSize);
+		std::vector<Range> InFlight;
+		uint64_t NextFence = 1;
+		uint64_t CompletedFence = 0;
+
+		auto Overlaps = [&]( size_t Offset, size_t Size )
+		{
+			for (const Range& R : InFlight)
+			{
+				if (R.FenceValue > CompletedFence && Offset < R.Offset + R.Size && R.Offset < Offset + Size)
+					return true;
+			}
+			return false;
+		};
+
+		// Four batches of four chunks fill the ring
+		bool Passed = true;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			size_t Offset;
+			Passed = Passed && Ring.Allocate(kChunk, 16, Offset) && Offset == i * kChunk;
+			InFlight.push_back({ Offset, kChunk, NextFence });
+			if (i % 4 == 3)
+				Ring.CloseBatch(NextFence++);
+		}
+
+		size_t Offset;
+		Passed = Passed && !Ring.Allocate(16, 16, Offset);
+
+		// Completing the first two batches frees the first half, and the next allocations wrap into it
+		CompletedFence = 2;
+		Ring.Retire(CompletedFence);
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			Passed = Passed && Ring.Allocate(kChunk, 16, Offset) && Offset == i * kChunk && !Overlaps(Offset, kChunk);
+			InFlight.push_back({ Offset, kChunk, NextFence });
+		}
+		Ring.CloseBatch(NextFence++);
+		Passed = Passed && !Ring.Allocate(16, 16, Offset);
+
+		// Random sizes and alignments.  Allocations which would straddle the end skip to the start, and a
+		// full ring retires its oldest batch.
+		RandomNumberGenerator Random;
+		uint32_t NumWraps = 0;
+		size_t LastOffset = 0;
+		for (uint32_t i = 0; i < 100000 && Passed; ++i)
+		{
+			size_t Size = Random.NextInt(1, (int32_t)kChunk * 3);
+			size_t Alignment = (size_t)16 << Random.NextInt(0, 5);
+
+			bool Allocated;
+			while (!(Allocated = Ring.Allocate(Size, Alignment, Offset)))
+			{
+				if (!InFlight.empty() && InFlight.back().FenceValue == NextFence)
+					Ring.CloseBatch(NextFence++);
+
+				// An empty ring must fit anything
+				if (!Ring.HasBatchesInFlight())
+					break;
+
+				Ring.Retire(++CompletedFence);
+			}
+
+			Passed = Passed && Allocated && Offset % Alignment == 0 && Offset + Size <= kRingSize && !Overlaps(Offset, Size);
+			NumWraps += Offset < LastOffset ? 1 : 0;
+			LastOffset = Offset;
+
+			InFlight.push_back({ Offset, Size, NextFence });
+			if (Random.NextInt(0, 3) == 0)
+				Ring.CloseBatch(NextFence++);
+
+			InFlight.erase(std::remove_if(InFlight.begin(), InFlight.end(),
+				[&]( const Range& R ) { return R.FenceValue <= CompletedFence; }), InFlight.end());
+		}
+
+		Passed = Passed && NumWraps > 0;
+		printf("%-48s %s\n", "Upload ring", Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	// Loading a model's textures the way ModelH3D does:  a job runs a ParallelFor over the materials, and the
+	// first material to request a texture loads it with a nested ParallelFor while the rest block until it is
+	// done.  If a thread waiting inside the loader picked up one of those materials, neither could finish.  A
+	// deadlock can't be reported from the stuck thread, so a watchdog gives up after a few seconds.
+	bool CheckNestedJobs( void )
+	{
+		const size_t kNumTextures = 4;
+		const size_t kNumMaterials = 64;
+		const size_t kTexelsPerTexture = 1 << 16;
+		const int kNumRounds = 50;
+
+		struct FakeTexture
+		{
+			std::atomic<bool> Requested;
+			bool Loaded;
+			uint64_t Sum;
+		};
+
+		std::mutex LoadMutex;
+		std::condition_variable LoadFinished;
+		std::atomic<bool> Finished(false);
+		bool Passed = true;
+
+		JobSystem::Initialize(3);
+
+		std::thread Loader([&]
+		{
+			for (int Round = 0; Round < kNumRounds; ++Round)
+			{
+				FakeTexture Textures[kNumTextures];
+				for (FakeTexture& Texture : Textures)
+				{
+					Texture.Requested = false;
+					Texture.Loaded = false;
+					Texture.Sum = 0;
+				}
+
+				uint64_t MaterialSums[kNumMaterials] = {};
+
+				JobSystem::Counter LoadCounter;
+				JobSystem::Run([&]
+				{
+					JobSystem::ParallelFor(kNumMaterials, 1, [&]( size_t Begin, size_t End )
+					{
+						for (size_t i = Begin; i < End; ++i)
+						{
+							FakeTexture& Texture = Textures[i % kNumTextures];
+
+							if (!Texture.Requested.exchange(true))
+							{
+								std::atomic<uint64_t> Sum(0);
+								JobSystem::ParallelFor(kTexelsPerTexture, 1024, [&]( size_t TexelBegin, size_t TexelEnd )
+								{
+									uint64_t ChunkSum = 0;
+									for (size_t Texel = TexelBegin; Texel < TexelEnd; ++Texel)
+										ChunkSum += Texel;
+									Sum += ChunkSum;
+								});
+
+								std::lock_guard<std::mutex> Guard(LoadMutex);
+								Texture.Sum = Sum;
+								Texture.Loaded = true;
+								LoadFinished.notify_all();
+							}
+
+							std::unique_lock<std::mutex> Lock(LoadMutex);
+							LoadFinished.wait(Lock, [&] { return Texture.Loaded; });
+							MaterialSums[i] = Texture.Sum;
+						}
+					});
+				}, &LoadCounter);
+				JobSystem::Wait(LoadCounter);
+
+				for (size_t i = 0; i < kNumMaterials; ++i)
+					Passed = Passed && MaterialSums[i] == (uint64_t)kTexelsPerTexture * (kTexelsPerTexture - 1) / 2;
+			}
+
+			Finished = true;
+		});
+
+		for (int Step = 0; Step < 1000 && !Finished; ++Step)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+		if (!Finished)
+		{
+			printf("%-48s %s\n", "Nested jobs", "FAILED (deadlocked)");
+			fflush(stdout);
+			std::quick_exit(1);
+		}
+
+		Loader.join();
+		JobSystem::Shutdown();
+
+		printf("%-48s %s\n", "Nested jobs", Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	// Replay a trace of CPU and GPU frame times through FramePacer, the way Graphics::Present() uses it, with
+	// the default maximum frame latency of two.  A frame starts once the frame two back has left the GPU, plus
+	// the pacing delay, and the GPU starts it once it is presented and the previous frame is done.  The GPU's
+	// time for a frame is only known a frame later.  While GPU bound, pacing must cut the time from the start
+	// of a frame (when input is sampled) to the end of its GPU work without spacing presents further apart.
+	// While CPU bound it must not change anything.
+	bool CheckFramePacer( void )
+	{
+		const uint32_t kNumFrames = 600;
+		const uint32_t kNumGpuBoundFrames = 400;
+		const uint32_t kMaxFrameLatency = 2;
+
+		// About 60 Hz on the GPU with a 6 ms CPU frame and a spike every 50 frames, then CPU bound at 50 Hz
+		RandomNumberGenerator Random;
+		Random.SetSeed(7);
+
+		std::vector<float> CpuTimes(kNumFrames), GpuTimes(kNumFrames);
+		for (uint32_t i = 0; i < kNumFrames; ++i)
+		{
+			bool GpuBound = i < kNumGpuBoundFrames;
+			CpuTimes[i] = (GpuBound ? 0.006f : 0.020f) + Random.NextFloat(-0.0005f, 0.0005f) + (i % 50 == 25 ? 0.004f : 0.0f);
+			GpuTimes[i] = (GpuBound ? 0.016f : 0.010f) + Random.NextFloat(-0.0005f, 0.0005f);
+		}
+
+		struct Replay
+		{
+			double PresentInterval[2];	// Mean time between the ends of GPU frames, while GPU and CPU bound
+			double Latency[2];			// Mean time from the start of a frame to the end of its GPU work
+		};
+
+		auto ReplayTrace = [&]( bool EnablePacing )
+		{
+			FramePacer Pacer;
+			std::vector<double> StartTimes(kNumFrames), GpuEndTimes(kNumFrames);
+			double PresentTime = 0.0;
+
+			for (uint32_t i = 0; i < kNumFrames; ++i)
+			{
+				double ReadyTime = PresentTime;
+				if (i >= kMaxFrameLatency)
+					ReadyTime = std::max(ReadyTime, GpuEndTimes[i - kMaxFrameLatency]);
+
+				StartTimes[i] = ReadyTime + (EnablePacing ? Pacer.GetStartDelay() : 0.0f);
+				PresentTime = StartTimes[i] + CpuTimes[i];
+
+				double GpuStartTime = i > 0 ? std::max(PresentTime, GpuEndTimes[i - 1]) : PresentTime;
+				GpuEndTimes[i] = GpuStartTime + GpuTimes[i];
+
+				Pacer.RecordFrame(CpuTimes[i], i > 0 ? GpuTimes[i - 1] : 0.0f);
+			}
+
+			// Skip the frames where the averages are still settling
+			const uint32_t kRanges[2][2] = { { 50, kNumGpuBoundFrames }, { kNumGpuBoundFrames + 50, kNumFrames } };
+
+			Replay Result;
+			for (uint32_t r = 0; r < 2; ++r)
+			{
+				uint32_t First = kRanges[r][0], End = kRanges[r][1];
+				Result.PresentInterval[r] = (GpuEndTimes[End - 1] - GpuEndTimes[First - 1]) / (End - First);
+
+				double TotalLatency = 0.0;
+				for (uint32_t i = First; i < End; ++i)
+					TotalLatency += GpuEndTimes[i] - StartTimes[i];
+				Result.Latency[r] = TotalLatency / (End - First);
+			}
+			return Result;
+		};
+
+		Replay Unpaced = ReplayTrace(false);
+		Replay Paced = ReplayTrace(true);
+
+		bool Passed = Paced.PresentInterval[0] <= Unpaced.PresentInterval[0] * 1.01;
+		Passed = Passed && Paced.Latency[0] <= Unpaced.Latency[0] - 0.005;
+		Passed = Passed && fabs(Paced.PresentInterval[1] - Unpaced.PresentInterval[1]) < 1e-6;
+		Passed = Passed && fabs(Paced.Latency[1] - Unpaced.Latency[1]) < 1e-6;
+
+		char Name[64];
+		sprintf_s(Name, "FramePacer trace (%.1f ms -> %.1f ms latency)", Unpaced.Latency[0] * 1000.0, Paced.Latency[0] * 1000.0);
+		printf("%-48s %s\n", Name, Passed ? "passed" : "FAILED");
+		return Passed;
+	}
+
+	// Round trip a procedural image through each encoder and decoder, and time the encoders.  The image has
+	// smooth gradients, a hard edge and an alpha ramp.  The job system is not running while timing, so this is
+	// one thread.
+	bool BenchmarkBlockCompression( void )
+	{
+		const uint32_t kWidth = 256;
+		const uint32_t kHeight = 256;
+
+		std::vector<uint32_t> Image(kWidth * kHeight);
+		for (uint32_t y = 0; y < kHeight; ++y)
+		{
+			for (uint32_t x = 0; x < kWidth; ++x)
+			{
+				float u = (float)x / kWidth, v = (float)y / kHeight;
+				uint32_t R = (uint32_t)(127.5f + 127.5f * sinf(u * 6.2831853f * 3.0f));
+				uint32_t G = (uint32_t)(255.0f * v);
+				uint32_t B = x < kWidth / 2 ? 32 : (uint32_t)(127.5f + 127.5f * cosf((u + v) * 6.2831853f * 2.0f));
+				uint32_t A = (uint32_t)(255.0f * u);
+				Image[y * kWidth + x] = R | G << 8 | B << 16 | A << 24;
+			}
+		}
+
+		struct FormatCheck
+		{
+			const char* Name;
+			DXGI_FORMAT Format;
+			uint32_t NumChannels;	// Compared, starting with red
+			double MinPSNR;
+		};
+
+		const FormatCheck kChecks[] =
+		{
+			{ "BC1", DXGI_FORMAT_BC1_UNORM, 3, 35.0 },
+			{ "BC3", DXGI_FORMAT_BC3_UNORM, 4, 36.0 },
+			{ "BC4", DXGI_FORMAT_BC4_UNORM, 1, 45.0 },
+			{ "BC5", DXGI_FORMAT_BC5_UNORM, 2, 45.0 },
+			{ "BC7", DXGI_FORMAT_BC7_UNORM, 4, 38.0 },
+		};
+
+		bool Passed = true;
+		std::vector<uint32_t> Decoded(Image.size());
+
+		for (const FormatCheck& Check : kChecks)
+		{
+			std::vector<uint8_t> Blocks(BlockCompression::GetCompressedSize(Check.Format, kWidth, kHeight));
+			BlockCompression::CompressImage(Check.Format, Image.data(), kWidth * 4, kWidth, kHeight, Blocks.data());
+			bool Decodes = BlockCompression::DecompressImage(Check.Format, Blocks.data(), kWidth, kHeight,
+				Decoded.data(), kWidth * 4);
+
+			double SquaredError = 0.0;
+			for (size_t i = 0; i < Image.size(); ++i)
+			{
+				for (uint32_t c = 0; c < Check.NumChannels; ++c)
+				{
+					int Diff = (int)(Image[i] >> (8 * c) & 0xFF) - (int)(Decoded[i] >> (8 * c) & 0xFF);
+					SquaredError += Diff * Diff;
+				}
+			}
+
+			double MeanSquaredError = SquaredError / (Image.size() * Check.NumChannels);
+			double PSNR = MeanSquaredError > 0.0 ? 10.0 * log10(255.0 * 255.0 / MeanSquaredError) : 99.0;
+			bool CheckPassed = Decodes && PSNR >= Check.MinPSNR;
+			Passed = Passed && CheckPassed;
+
+			char Name[64];
+			sprintf_s(Name, "BlockCompression/%s (%.1f dB)", Check.Name, PSNR);
+			printf("%-48s %s\n", Name, CheckPassed ? "passed" : "FAILED");
+
+			// Bytes are those of the source pixels, so throughput reads as pixels per second times four
+			Benchmark::Run(std::string("BlockCompression/Encode") + Check.Name, Image.size() * 4, [&]( uint64_t Iterations )
+			{
+				for (uint64_t n = 0; n < Iterations; ++n)
+					BlockCompression::CompressImage(Check.Format, Image.data(), kWidth * 4, kWidth, kHeight, Blocks.data());
+				Benchmark::Consume(Blocks[0]);
+			});
+		}
+
+		// Textures are compressed while loading, from inside jobs, so compress several images at once from jobs
+		// and compare the blocks with those compressed on this thread
+		{
+			const size_t kNumJobs = 8;
+			const DXGI_FORMAT Format = DXGI_FORMAT_BC3_UNORM;
+			const size_t CompressedSize = BlockCompression::GetCompressedSize(Format, kWidth, kHeight);
+
+			std::vector<uint8_t> Expected(CompressedSize);
+			BlockCompression::CompressImage(Format, Image.data(), kWidth * 4, kWidth, kHeight, Expected.data());
+
+			std::vector<std::vector<uint8_t>> Results(kNumJobs, std::vector<uint8_t>(CompressedSize));
+
+			JobSystem::Initialize(3);
+			JobSystem::Counter CompressCounter;
+			for (size_t i = 0; i < kNumJobs; ++i)
+			{
+				JobSystem::Run([&, i]
+				{
+					BlockCompression::CompressImage(Format, Image.data(), kWidth * 4, kWidth, kHeight, Results[i].data());
+				}, &CompressCounter);
+			}
+			JobSystem::Wait(CompressCounter);
+			JobSystem::Shutdown();
+
+			bool CheckPassed = std::all_of(Results.begin(), Results.end(),
+				[&]( const std::vector<uint8_t>& Result ) { return Result == Expected; });
+			Passed = Passed && CheckPassed;
+			printf("%-48s %s\n", "BlockCompression/From jobs", CheckPassed ? "passed" : "FAILED");
+		}
+
+		return Passed;
+	}
+
+	// Compare the SIMD mip filters with the scalar reference on odd sized images, where the filters have the
+	// most to cover, and time a level of each.  The job system is not running, so this is one thread.
+	bool BenchmarkMipGenerator( void )
+	{
+		using namespace MipGenerator;
+
+		RandomNumberGenerator Random;
+		Random.SetSeed(1);
+
+		const uint32_t kSizes[][2] = { { 255, 129 }, { 7, 3 }, { 1, 9 }, { 33, 1 } };
+		const char* kFilterNames[] = { "Box", "Kaiser" };
+
+		bool MatchesReference = true;
+		for (const uint32_t* Size : kSizes)
+		{
+			std::vector<uint32_t> Source(Size[0] * Size[1]);
+			for (uint32_t& Pixel : Source)
+				Pixel = (uint32_t)Random.NextInt(0xFFFF) | (uint32_t)Random.NextInt(0xFFFF) << 16;
+
+			const uint32_t DestWidth = std::max(Size[0] >> 1, 1u);
+			const uint32_t DestHeight = std::max(Size[1] >> 1, 1u);
+			std::vector<uint32_t> Fast(DestWidth * DestHeight), Reference(DestWidth * DestHeight);
+
+			for (FilterType Filter : { kBoxFilter, kKaiserFilter })
+			{
+				for (bool sRGB : { false, true })
+				{
+					Downsample(Filter, sRGB, Source.data(), Size[0] * 4, Size[0], Size[1], Fast.data(), DestWidth * 4);
+					DownsampleReference(Filter, sRGB, Source.data(), Size[0] * 4, Size[0], Size[1], Reference.data(), DestWidth * 4);
+
+					for (size_t i = 0; i < Fast.size(); ++i)
+					{
+						for (uint32_t c = 0; c < 4; ++c)
+						{
+							int Diff = (int)(Fast[i] >> (8 * c) & 0xFF) - (int)(Reference[i] >> (8 * c) & 0xFF);
+							MatchesReference = MatchesReference && Diff >= -1 && Diff <= 1;
+						}
+					}
+				}
+			}
+		}
+
+		// Five texels become two with weights of 1, 1 and 0.5
+		const uint32_t Row[5] = { 0, 30, 60, 90, 120 };
+		uint32_t Halved[2];
+		Downsample(kBoxFilter, false, Row, sizeof(Row), 5, 1, Halved, sizeof(Halved));
+		bool OddWeights = Halved[0] == 24 && Halved[1] == 96;
+
+		// A flat sRGB image stays flat all the way down
+		std::vector<MipLevel> Chain(1);
+		Chain[0].Width = 100;
+		Chain[0].Height = 60;
+		Chain[0].Pixels.assign(100 * 60, 0x80402010);
+		GenerateMipChain(Chain, kKaiserFilter, true);
+		bool KeepsFlat = Chain.size() == 7 && Chain.back().Width == 1 && Chain.back().Height == 1;
+		for (const MipLevel& Level : Chain)
+			KeepsFlat = KeepsFlat && std::all_of(Level.Pixels.begin(), Level.Pixels.end(), []( uint32_t p ) { return p == 0x80402010; });
+
+		// TGA mips are generated while loading, from inside jobs, so build several chains at once from jobs and
+		// compare them with one built on this thread.  The top level is large enough to filter rows in parallel.
+		std::vector<MipLevel> Expected(1);
+		Expected[0].Width = 300;
+		Expected[0].Height = 200;
+		Expected[0].Pixels.resize(300 * 200);
+		for (uint32_t& Pixel : Expected[0].Pixels)
+			Pixel = (uint32_t)Random.NextInt(0xFFFF) | (uint32_t)Random.NextInt(0xFFFF) << 16;
+
+		std::vector<std::vector<MipLevel>> Chains(8, Expected);
+		GenerateMipChain(Expected, kKaiserFilter, true);
+
+		JobSystem::Initialize(3);
+		JobSystem::Counter MipCounter;
+		for (std::vector<MipLevel>& JobChain : Chains)
+			JobSystem::Run([&JobChain] { GenerateMipChain(JobChain, kKaiserFilter, true); }, &MipCounter);
+		JobSystem::Wait(MipCounter);
+		JobSystem::Shutdown();
+
+		bool MatchesFromJobs = true;
+		for (const std::vector<MipLevel>& JobChain : Chains)
+		{
+			MatchesFromJobs = MatchesFromJobs && JobChain.size() == Expected.size();
+			for (size_t i = 0; MatchesFromJobs && i < Expected.size(); ++i)
+				MatchesFromJobs = JobChain[i].Pixels == Expected[i].Pixels;
+		}
+
+		bool Passed = MatchesReference && OddWeights && KeepsFlat && MatchesFromJobs;
+		printf("%-48s %s\n", "MipGenerator", Passed ? "passed" : "FAILED");
+
+		const uint32_t kWidth = 1024;
+		const uint32_t kHeight = 1024;
+		std::vector<uint32_t> Source(kWidth * kHeight);
+		for (uint32_t& Pixel : Source)
+			Pixel = (uint32_t)Random.NextInt(0xFFFF) | (uint32_t)Random.NextInt(0xFFFF) << 16;
+		std::vector<uint32_t> Dest(kWidth * kHeight / 4);
+
+		for (FilterType Filter : { kBoxFilter, kKaiserFilter })
+		{
+			for (bool sRGB : { false, true })
+			{
+				std::string Name = std::string("MipGenerator/") + kFilterNames[Filter] + (sRGB ? "/sRGB" : "/Linear");
+
+				Benchmark::Run(Name, Source.size() * 4, [&]( uint64_t Iterations )
+				{
+					for (uint64_t n = 0; n < Iterations; ++n)
+						Downsample(Filter, sRGB, Source.data(), kWidth * 4, kWidth, kHeight, Dest.data(), kWidth * 2);
+					Benchmark::Consume(Dest[0]);
+				});
+
+				Benchmark::Run(Name + "/Reference", Source.size() * 4, [&]( uint64_t Iterations )
+				{
+					for (uint64_t n = 0; n < Iterations; ++n)
+						DownsampleReference(Filter, sRGB, Source.data(), kWidth * 4, kWidth, kHeight, Dest.data(), kWidth * 2);
+					Benchmark::Consume(Dest[0]);
+				});
+			}
+		}
+
+		return Passed;
+	}
+
+	// Compare the sliding window extremes with a scan of the window after every frame, with several samples
+	// in some frames and none in others, and time recording a sample.
+	bool BenchmarkSlidingWindowMinMax( void )
+	{
+		const uint32_t kWindow = 64;
+		const uint32_t kMaxSamplesPerFrame = 3;
+
+		RandomNumberGenerator Random;
+		Random.SetSeed(1);
+
+		struct Sample { uint32_t Frame; float Value; };
+		std::vector<Sample> History;
+		SlidingWindowMinMax Window(kWindow, kMaxSamplesPerFrame);
+
+		// Start near the top of the range so the frame counter wraps partway through
+		bool MatchesScan = true;
+		for (uint32_t Frame = 0xFFFFFFFFu - 1000; Frame != 3000; ++Frame)
+		{
+			uint32_t SampleCount = (uint32_t)Random.NextInt(kMaxSamplesPerFrame);
+			for (uint32_t i = 0; i < SampleCount; ++i)
+			{
+				Sample New = { Frame, (float)Random.NextInt(1000) };
+				History.push_back(New);
+				Window.AddSample(Frame, New.Value);
+			}
+			Window.Advance(Frame);
+
+			float Max = 0.0f, Min = 0.0f;
+			bool Empty = true;
+			for (const Sample& Old : History)
+			{
+				if (Frame - Old.Frame >= kWindow)
+					continue;
+				Max = Empty ? Old.Value : std::max(Max, Old.Value);
+				Min = Empty ? Old.Value : std::min(Min, Old.Value);
+				Empty = false;
+			}
+
+			MatchesScan = MatchesScan && Window.IsEmpty() == Empty && Window.GetMax() == Max && Window.GetMin() == Min;
+		}
+
+		printf("%-48s %s\n", "SlidingWindowMinMax", MatchesScan ? "passed" : "FAILED");
+
+		std::vector<float> Values(4096);
+		for (float& Value : Values)
+			Value = (float)Random.NextInt(1000);
+
+		// Window and node count of the global perf graphs
+		SlidingWindowMinMax GraphWindow(512, 1);
+		uint32_t Frame = 0;
+
+		Benchmark::Run("SlidingWindowMinMax/AddSample", 0, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n, ++Frame)
+				GraphWindow.AddSample(Frame, Values[Frame & 4095]);
+			Benchmark::Consume((uint64_t)GraphWindow.GetMax());
+		});
+
+		return MatchesScan;
+	}
+
+	// Chi-square of a histogram against a uniform distribution
+	double ChiSquare( const std::vector<uint32_t>& Histogram, uint32_t SampleCount )
+	{
+		const double Expected = (double)SampleCount / Histogram.size();
+		double Sum = 0.0;
+		for (uint32_t Observed : Histogram)
+			Sum += (Observed - Expected) * (Observed - Expected) / Expected;
+		return Sum;
+	}
+
+	// Smoke test the generator's distributions with chi-square over 64 bins, check that a seed reproduces its
+	// sequence and that streams differ, and time it against std::minstd_rand with a distribution per call, which
+	// it replaced.  Each operation makes 1024 numbers.
+	bool BenchmarkRandom( void )
+	{
+		const uint32_t kBins = 64;
+		const uint32_t kSamples = 1 << 20;
+		// 99.9th percentile of chi-square with 63 degrees of freedom
+		const double kMaxChiSquare = 103.4;
+
+		RandomNumberGenerator Random(1);
+		std::vector<uint32_t> Histogram(kBins);
+		std::vector<float> Floats(kSamples);
+		std::vector<int32_t> Ints(kSamples);
+
+		struct DistributionCheck { const char* Name; double ChiSquare; };
+		std::vector<DistributionCheck> Checks;
+
+		Histogram.assign(kBins, 0);
+		for (uint32_t i = 0; i < kSamples; ++i)
+			++Histogram[(uint32_t)(Random.NextFloat() * kBins)];
+		Checks.push_back({ "NextFloat", ChiSquare(Histogram, kSamples) });
+
+		Histogram.assign(kBins, 0);
+		for (uint32_t i = 0; i < kSamples; ++i)
+			++Histogram[Random.NextInt(kBins - 1)];
+		Checks.push_back({ "NextInt", ChiSquare(Histogram, kSamples) });
+
+		Histogram.assign(kBins, 0);
+		Random.FillFloats(Floats.data(), kSamples, -2.0f, 6.0f);
+		for (float Value : Floats)
+			++Histogram[std::min((uint32_t)((Value + 2.0f) * (kBins / 8.0f)), kBins - 1)];
+		Checks.push_back({ "FillFloats", ChiSquare(Histogram, kSamples) });
+
+		Histogram.assign(kBins, 0);
+		Random.FillInts(Ints.data(), kSamples, -10, kBins - 11);
+		for (int32_t Value : Ints)
+			++Histogram[std::min((uint32_t)(Value + 10), kBins - 1)];
+		Checks.push_back({ "FillInts", ChiSquare(Histogram, kSamples) });
+
+		bool Passed = true;
+		for (const DistributionCheck& Check : Checks)
+		{
+			bool CheckPassed = Check.ChiSquare <= kMaxChiSquare;
+			Passed = Passed && CheckPassed;
+			printf("%-48s %s (chi-square %.1f)\n", (std::string("Random/") + Check.Name).c_str(),
+				CheckPassed ? "passed" : "FAILED", Check.ChiSquare);
+		}
+
+		RandomNumberGenerator First(7), Second(7), OtherStream(7, 1);
+		bool Reproducible = true, StreamsDiffer = false;
+		for (uint32_t i = 0; i < 1024; ++i)
+		{
+			int32_t Value = First.NextInt();
+			Reproducible = Reproducible && Value == Second.NextInt();
+			StreamsDiffer = StreamsDiffer || Value != OtherStream.NextInt();
+		}
+		Passed = Passed && Reproducible && StreamsDiffer;
+		printf("%-48s %s\n", "Random/Seeding", Reproducible && StreamsDiffer ? "passed" : "FAILED");
+
+		const uint32_t kBatch = 1024;
+		float* Batch = Floats.data();
+
+		Benchmark::Run("Random/NextFloat", kBatch * sizeof(float), [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				for (uint32_t i = 0; i < kBatch; ++i)
+					Batch[i] = Random.NextFloat(-1.0f, 1.0f);
+			}
+			Benchmark::Consume((uint64_t)fabsf(Batch[0]));
+		});
+
+		Benchmark::Run("Random/FillFloats", kBatch * sizeof(float), [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Random.FillFloats(Batch, kBatch, -1.0f, 1.0f);
+			Benchmark::Consume((uint64_t)fabsf(Batch[0]));
+		});
+
+		std::minstd_rand MinStd(1);
+		Benchmark::Run("Random/NextFloat/minstd_rand", kBatch * sizeof(float), [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				for (uint32_t i = 0; i < kBatch; ++i)
+					Batch[i] = std::uniform_real_distribution<float>(-1.0f, 1.0f)(MinStd);
+			}
+			Benchmark::Consume((uint64_t)fabsf(Batch[0]));
+		});
+
+		int32_t* IntBatch = Ints.data();
+
+		Benchmark::Run("Random/NextInt", kBatch * sizeof(int32_t), [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				for (uint32_t i = 0; i < kBatch; ++i)
+					IntBatch[i] = Random.NextInt(999);
+			}
+			Benchmark::Consume((uint64_t)IntBatch[0]);
+		});
+
+		Benchmark::Run("Random/FillInts", kBatch * sizeof(int32_t), [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Random.FillInts(IntBatch, kBatch, 0, 999);
+			Benchmark::Consume((uint64_t)IntBatch[0]);
+		});
+
+		Benchmark::Run("Random/NextInt/minstd_rand", kBatch * sizeof(int32_t), [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				for (uint32_t i = 0; i < kBatch; ++i)
+					IntBatch[i] = std::uniform_int_distribution<int32_t>(0, 999)(MinStd);
+			}
+			Benchmark::Consume((uint64_t)IntBatch[0]);
+		});
+
+		return Passed;
+	}
+
+	bool NearlyEqual( float a, float b )
+	{
+		return fabsf(a - b) <= 1e-5f * std::max(1.0f, fabsf(b));
+	}
+
+	// Check the batch transforms against Matrix4 one object at a time, and time both over 4096 objects, a
+	// typical count of instances or particles.  The job system is not running, so this is one core.
+	bool BenchmarkBatchTransform( void )
+	{
+		using namespace BatchTransform;
+
+		const uint32_t kCount = 4096 + 3;	// Not a multiple of eight, so the remainder is covered too
+
+		RandomNumberGenerator Random(1);
+
+		// An affine transform with rotation, uniform scale and translation, and an arbitrary one
+		const Matrix4 Affine = Matrix4(AffineTransform(Quaternion(Normalize(Vector3(1.0f, 2.0f, 3.0f)), 0.7f),
+			Vector3(3.0f, -4.0f, 5.0f))) * Matrix4::MakeScale(2.0f);
+		Matrix4 General;
+		General.SetX(Vector4(Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f)));
+		General.SetY(Vector4(Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f)));
+		General.SetZ(Vector4(Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f)));
+		General.SetW(Vector4(Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f), Random.NextFloat(-2.0f, 2.0f)));
+
+		std::vector<float> Streams[10];
+		for (std::vector<float>& Stream : Streams)
+			Stream.resize(kCount);
+		Random.FillFloats(Streams[0].data(), kCount, -100.0f, 100.0f);
+		Random.FillFloats(Streams[1].data(), kCount, -100.0f, 100.0f);
+		Random.FillFloats(Streams[2].data(), kCount, -100.0f, 100.0f);
+		Random.FillFloats(Streams[3].data(), kCount, 0.0f, 10.0f);
+
+		const PointStreams Points = { Streams[0].data(), Streams[1].data(), Streams[2].data() };
+		const PointStreams OutPoints = { Streams[4].data(), Streams[5].data(), Streams[6].data() };
+		float* OutW = Streams[7].data();
+
+		TransformPoints(General, Points, OutPoints, OutW, kCount);
+		bool PointsMatch = true;
+		for (uint32_t i = 0; i < kCount; ++i)
+		{
+			Vector4 Expected = General * Vector4(Points.X[i], Points.Y[i], Points.Z[i], 1.0f);
+			PointsMatch = PointsMatch && NearlyEqual(OutPoints.X[i], Expected.GetX()) && NearlyEqual(OutPoints.Y[i], Expected.GetY()) &&
+				NearlyEqual(OutPoints.Z[i], Expected.GetZ()) && NearlyEqual(OutW[i], Expected.GetW());
+		}
+
+		const SphereStreams Spheres = { Streams[0].data(), Streams[1].data(), Streams[2].data(), Streams[3].data() };
+		const SphereStreams OutSpheres = { Streams[4].data(), Streams[5].data(), Streams[6].data(), Streams[7].data() };
+
+		TransformSpheres(Affine, Spheres, OutSpheres, kCount);
+		bool SpheresMatch = true;
+		for (uint32_t i = 0; i < kCount; ++i)
+		{
+			Vector4 Expected = Affine * Vector4(Spheres.X[i], Spheres.Y[i], Spheres.Z[i], 1.0f);
+			SpheresMatch = SpheresMatch && NearlyEqual(OutSpheres.X[i], Expected.GetX()) && NearlyEqual(OutSpheres.Y[i], Expected.GetY()) &&
+				NearlyEqual(OutSpheres.Z[i], Expected.GetZ()) && NearlyEqual(OutSpheres.Radius[i], Spheres.Radius[i] * 2.0f);
+		}
+
+		// Boxes from each point to the point plus its radius on every axis.  The result must be the tightest box
+		// around the transformed corners.
+		for (uint32_t i = 0; i < kCount; ++i)
+		{
+			Streams[3][i] += Streams[0][i];
+			Streams[8][i] = Streams[1][i] + 1.0f;
+			Streams[9][i] = Streams[2][i] + 2.0f;
+		}
+		const BoxStreams Boxes = { Streams[0].data(), Streams[1].data(), Streams[2].data(), Streams[3].data(), Streams[8].data(), Streams[9].data() };
+		std::vector<float> OutBoxStreams(kCount * 6);
+		const BoxStreams OutBoxes = { &OutBoxStreams[0], &OutBoxStreams[kCount], &OutBoxStreams[kCount * 2],
+			&OutBoxStreams[kCount * 3], &OutBoxStreams[kCount * 4], &OutBoxStreams[kCount * 5] };
+
+		TransformBoxes(Affine, Boxes, OutBoxes, kCount);
+		bool BoxesMatch = true;
+		for (uint32_t i = 0; i < kCount; ++i)
+		{
+			Vector3 Min(Scalar(FLT_MAX)), Max(Scalar(-FLT_MAX));
+			for (uint32_t Corner = 0; Corner < 8; ++Corner)
+			{
+				Vector4 Transformed = Affine * Vector4(
+					Corner & 1 ? Boxes.MaxX[i] : Boxes.MinX[i],
+					Corner & 2 ? Boxes.MaxY[i] : Boxes.MinY[i],
+					Corner & 4 ? Boxes.MaxZ[i] : Boxes.MinZ[i], 1.0f);
+				Min = Math::Min(Min, Vector3(Transformed));
+				Max = Math::Max(Max, Vector3(Transformed));
+			}
+			BoxesMatch = BoxesMatch && NearlyEqual(OutBoxes.MinX[i], Min.GetX()) && NearlyEqual(OutBoxes.MinY[i], Min.GetY()) &&
+				NearlyEqual(OutBoxes.MinZ[i], Min.GetZ()) && NearlyEqual(OutBoxes.MaxX[i], Max.GetX()) &&
+				NearlyEqual(OutBoxes.MaxY[i], Max.GetY()) && NearlyEqual(OutBoxes.MaxZ[i], Max.GetZ());
+		}
+
+		// Matrix4 needs 64-byte alignment, which std::vector does not provide
+		Matrix4* Matrices = (Matrix4*)_aligned_malloc(sizeof(Matrix4) * kCount * 2, 64);
+		Matrix4* OutMatrices = Matrices + kCount;
+		for (uint32_t i = 0; i < kCount; ++i)
+		{
+			Quaternion Rotation(Normalize(Vector3(Streams[0][i], Streams[1][i], Streams[2][i])), Streams[3][i]);
+			Matrices[i] = Matrix4(OrthogonalTransform(Rotation, Vector3(Streams[4][i], Streams[5][i], Streams[6][i])));
+		}
+
+		auto MatricesMatch = [&]( const Matrix4& Expected, const Matrix4& Actual )
+		{
+			const float* e = (const float*)&Expected;
+			const float* a = (const float*)&Actual;
+			for (uint32_t k = 0; k < 16; ++k)
+			{
+				if (!NearlyEqual(a[k], e[k]))
+					return false;
+			}
+			return true;
+		};
+
+		MultiplyMatrices(General, Matrices, OutMatrices, kCount);
+		bool ProductsMatch = true;
+		for (uint32_t i = 0; i < kCount; ++i)
+			ProductsMatch = ProductsMatch && MatricesMatch(General * Matrices[i], OutMatrices[i]);
+
+		OrthoInvertMatrices(Matrices, OutMatrices, kCount);
+		bool InversesMatch = true;
+		for (uint32_t i = 0; i < kCount; ++i)
+			InversesMatch = InversesMatch && MatricesMatch(OrthoInvert(Matrices[i]), OutMatrices[i]);
+
+		bool Passed = PointsMatch && SpheresMatch && BoxesMatch && ProductsMatch && InversesMatch;
+		printf("%-48s %s\n", "BatchTransform", Passed ? "passed" : "FAILED");
+
+		Benchmark::Run("BatchTransform/TransformPoints", sizeof(float) * 6 * kCount, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				TransformPoints(Affine, Points, OutPoints, nullptr, kCount);
+			Benchmark::Consume((uint64_t)fabsf(OutPoints.X[0]));
+		});
+
+		Benchmark::Run("BatchTransform/TransformPoints/Scalar", sizeof(float) * 6 * kCount, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				for (uint32_t i = 0; i < kCount; ++i)
+				{
+					Vector4 Point = Affine * Vector3(Points.X[i], Points.Y[i], Points.Z[i]);
+					OutPoints.X[i] = Point.GetX();
+					OutPoints.Y[i] = Point.GetY();
+					OutPoints.Z[i] = Point.GetZ();
+				}
+			}
+			Benchmark::Consume((uint64_t)fabsf(OutPoints.X[0]));
+		});
+
+		Benchmark::Run("BatchTransform/TransformBoxes", sizeof(float) * 12 * kCount, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				TransformBoxes(Affine, Boxes, OutBoxes, kCount);
+			Benchmark::Consume((uint64_t)fabsf(OutBoxes.MinX[0]));
+		});
+
+		Benchmark::Run("BatchTransform/MultiplyMatrices", sizeof(Matrix4) * 2 * kCount, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				MultiplyMatrices(General, Matrices, OutMatrices, kCount);
+			Benchmark::Consume((uint64_t)fabsf(OutMatrices[0].GetX().GetX()));
+		});
+
+		Benchmark::Run("BatchTransform/MultiplyMatrices/Scalar", sizeof(Matrix4) * 2 * kCount, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				for (uint32_t i = 0; i < kCount; ++i)
+					OutMatrices[i] = General * Matrices[i];
+			}
+			Benchmark::Consume((uint64_t)fabsf(OutMatrices[0].GetX().GetX()));
+		});
+
+		Benchmark::Run("BatchTransform/OrthoInvertMatrices", sizeof(Matrix4) * 2 * kCount, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				OrthoInvertMatrices(Matrices, OutMatrices, kCount);
+			Benchmark::Consume((uint64_t)fabsf(OutMatrices[0].GetX().GetX()));
+		});
+
+		Benchmark::Run("BatchTransform/OrthoInvertMatrices/Scalar", sizeof(Matrix4) * 2 * kCount, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				for (uint32_t i = 0; i < kCount; ++i)
+					OutMatrices[i] = OrthoInvert(Matrices[i]);
+			}
+			Benchmark::Consume((uint64_t)fabsf(OutMatrices[0].GetX().GetX()));
+		});
+
+		_aligned_free(Matrices);
+
+		return Passed;
+	}
+
+	bool BenchmarkShadowCascades( void )
+	{
+		const uint32_t kNumCascades = CascadedShadowCamera::kMaxCascades;
+		const uint32_t kCascadeSize = 2048;
+		const float kNearClip = 1.0f;
+		const float kMaxDistance = 4000.0f;
+		const float kCasterDistance = 1000.0f;
+
+		// The split schemes keep their endpoints and increase, uniform splits are evenly spaced, logarithmic
+		// splits have a constant ratio, and the practical scheme lies between them
+		float Uniform[kNumCascades + 1];
+		float Logarithmic[kNumCascades + 1];
+		float Practical[kNumCascades + 1];
+		CascadedShadowCamera::ComputeSplits(kUniformSplits, 0.0f, kNearClip, kMaxDistance, kNumCascades, Uniform);
+		CascadedShadowCamera::ComputeSplits(kLogarithmicSplits, 0.0f, kNearClip, kMaxDistance, kNumCascades, Logarithmic);
+		CascadedShadowCamera::ComputeSplits(kPracticalSplits, 0.5f, kNearClip, kMaxDistance, kNumCascades, Practical);
+
+		bool SplitsValid = Uniform[0] == kNearClip && Logarithmic[0] == kNearClip && Practical[0] == kNearClip &&
+			Uniform[kNumCascades] == kMaxDistance && Logarithmic[kNumCascades] == kMaxDistance &&
+			Practical[kNumCascades] == kMaxDistance;
+		for (uint32_t i = 1; i <= kNumCascades; ++i)
+		{
+			SplitsValid = SplitsValid && Uniform[i] > Uniform[i - 1] && Logarithmic[i] > Logarithmic[i - 1] &&
+				Practical[i] > Practical[i - 1];
+			SplitsValid = SplitsValid && fabsf((Uniform[i] - Uniform[i - 1]) - (Uniform[1] - Uniform[0])) < 0.01f;
+			SplitsValid = SplitsValid && fabsf(Logarithmic[i] / Logarithmic[i - 1] - Logarithmic[1] / Logarithmic[0]) < 0.001f;
+			SplitsValid = SplitsValid && fabsf(Practical[i] - (Uniform[i] + Logarithmic[i]) * 0.5f) < 0.01f;
+		}
+
+		// Walk and turn the camera.  The last two cascades are cached, so they are only refit now and then, but
+		// every cascade must still cover its whole slice.  Texels must not change size or drift within the world,
+		// which shows up as the world origin staying at the same fraction of a texel.
+		Camera Cam;
+		Cam.SetPerspectiveMatrix(XM_PIDIV4, 9.0f / 16.0f, kNearClip, 10000.0f);
+
+		CascadedShadowCamera Cascades;
+		Cascades.SetCascadeCount(kNumCascades);
+		Cascades.SetSplitScheme(kPracticalSplits, 0.75f);
+		Cascades.SetCaching(2, 4);
+
+		const Vector3 LightDirection = Normalize(Vector3(0.3f, -1.0f, 0.2f));
+		const float TanV = tanf(Cam.GetFOV() * 0.5f);
+		const float TanH = TanV / Cam.GetAspectRatio();
+
+		bool SlicesCovered = true;
+		bool TexelsStable = true;
+		bool CullingCorrect = true;
+		uint32_t Refits[kNumCascades] = {};
+		float FirstScale[kNumCascades];
+		float FirstFraction[kNumCascades][2];
+
+		const uint32_t kNumFrames = 512;
+		for (uint32_t Frame = 0; Frame < kNumFrames; ++Frame)
+		{
+			float Yaw = Frame * 0.02f;
+			float Pitch = sinf(Frame * 0.05f) * 0.4f;
+			Vector3 Eye(Frame * 1.5f, 50.0f + sinf(Frame * 0.1f) * 20.0f, Frame * -0.75f);
+			Vector3 Forward(cosf(Pitch) * sinf(Yaw), sinf(Pitch), -cosf(Pitch) * cosf(Yaw));
+			Cam.SetEyeAtUp(Eye, Eye + Forward, Vector3(kYUnitVector));
+			Cam.Update();
+
+			Cascades.Update(LightDirection, Cam, kMaxDistance, kCasterDistance, kCascadeSize, 16);
+
+			const Matrix4& FirstShadowMatrix = Cascades.GetCascade(0).GetShadowMatrix();
+
+			for (uint32_t i = 0; i < kNumCascades; ++i)
+			{
+				const ShadowCamera& Cascade = Cascades.GetCascade(i);
+				Refits[i] += Cascades.NeedsRender(i) ? 1 : 0;
+
+				for (uint32_t Corner = 0; Corner < 8; ++Corner)
+				{
+					float Distance = Cascades.GetSplitDistance(i + (Corner >> 2));
+					float X = (Corner & 1) ? TanH : -TanH;
+					float Y = (Corner & 2) ? TanV : -TanV;
+					Vector3 Point = Eye + (Cam.GetForwardVec() + Cam.GetRightVec() * X + Cam.GetUpVec() * Y) * Distance;
+
+					Vector3 Coord = Vector3(Cascade.GetShadowMatrix() * Point);
+					Vector3 Mapped = Vector3(FirstShadowMatrix * Point) * Cascades.GetCascadeScale(i) + Cascades.GetCascadeOffset(i);
+
+					SlicesCovered = SlicesCovered && Coord.GetX() >= 0.0f && Coord.GetX() <= 1.0f &&
+						Coord.GetY() >= 0.0f && Coord.GetY() <= 1.0f && Coord.GetZ() >= 0.0f && Coord.GetZ() <= 1.0f;
+					SlicesCovered = SlicesCovered && (float)Length(Mapped - Coord) < 0.001f;
+				}
+
+				Vector3 Origin = Vector3(Cascade.GetShadowMatrix() * Vector3(kZero));
+				float U = Origin.GetX() * kCascadeSize;
+				float V = Origin.GetY() * kCascadeSize;
+				float Fraction[2] = { U - floorf(U), V - floorf(V) };
+				float Scale = Cascade.GetProjMatrix().GetX().GetX();
+
+				if (Frame == 0)
+				{
+					FirstScale[i] = Scale;
+					FirstFraction[i][0] = Fraction[0];
+					FirstFraction[i][1] = Fraction[1];
+				}
+				else
+				{
+					TexelsStable = TexelsStable && Scale == FirstScale[i];
+					for (uint32_t Axis = 0; Axis < 2; ++Axis)
+					{
+						float Drift = fabsf(Fraction[Axis] - FirstFraction[i][Axis]);
+						TexelsStable = TexelsStable && std::min(Drift, 1.0f - Drift) < 0.02f;
+					}
+				}
+
+				// Casters toward the light are kept, while objects past the far side of the cascade are culled
+				BoundingSphere Slice = CascadedShadowCamera::ComputeSliceBounds(Cam,
+					Cascades.GetSplitDistance(i), Cascades.GetSplitDistance(i + 1));
+				Vector3 Caster = Slice.GetCenter() - LightDirection * (Slice.GetRadius() + kCasterDistance * 0.5f);
+				Vector3 Beyond = Slice.GetCenter() + LightDirection * (Slice.GetRadius() * 2.0f);
+				const Frustum& Bounds = Cascade.GetWorldSpaceFrustum();
+				CullingCorrect = CullingCorrect && Bounds.IntersectSphere(BoundingSphere(Slice.GetCenter(), 1.0f)) &&
+					Bounds.IntersectSphere(BoundingSphere(Caster, 1.0f)) && !Bounds.IntersectSphere(BoundingSphere(Beyond, 1.0f));
+			}
+		}
+
+		bool CachingWorks = Refits[0] == kNumFrames && Refits[1] == kNumFrames &&
+			Refits[2] < kNumFrames / 2 && Refits[3] < kNumFrames / 2;
+
+		bool Passed = SplitsValid && SlicesCovered && TexelsStable && CullingCorrect && CachingWorks;
+		printf("%-48s %s\n", "CascadedShadowCamera", Passed ? "passed" : "FAILED");
+
+		Benchmark::Run("CascadedShadowCamera::Update", 0, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Cascades.Update(LightDirection, Cam, kMaxDistance, kCasterDistance, kCascadeSize, 16);
+			Benchmark::Consume((uint64_t)fabsf(Cascades.GetSplitDistance(1)));
+		});
+
+		return Passed;
+	}
+
+	// Check the bounding volumes computed from an interleaved vertex buffer and the frustum box tests, and time
+	// them over a mesh sized vertex buffer
+	bool BenchmarkBoundingVolumes( void )
+	{
+		// Position, texcoord, normal, tangent and bitangent, as in the ModelViewer's vertices
+		const size_t kStride = sizeof(float) * 14;
+		const size_t kNumVertices = 16387;
+
+		RandomNumberGenerator Random;
+		std::vector<float> Vertices(kNumVertices * 14);
+		for (size_t i = 0; i < Vertices.size(); ++i)
+			Vertices[i] = (i % 14) < 3 ? Random.NextFloat(-100.0f, 100.0f) : 1e30f;
+
+		// Boxes must match a scan exactly, including for counts which leave a remainder after the unrolled loop
+		bool BoxesMatch = true;
+		const size_t Counts[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, kNumVertices };
+		for (size_t Count : Counts)
+		{
+			AxisAlignedBox Expected;
+			for (size_t i = 0; i < Count; ++i)
+				Expected.AddPoint(Vector3(Vertices[i * 14], Vertices[i * 14 + 1], Vertices[i * 14 + 2]));
+
+			AxisAlignedBox Box = ComputeBoundingBox(Vertices.data(), kStride, Count);
+			BoxesMatch = BoxesMatch && XMVector3Equal(Box.GetMin(), Expected.GetMin()) && XMVector3Equal(Box.GetMax(), Expected.GetMax());
+		}
+
+		// Spheres must hold every point.  Points on a sphere of radius 50 show how close to the smallest sphere
+		// each method gets.
+		std::vector<float> Shell(kNumVertices * 3);
+		for (size_t i = 0; i < kNumVertices; ++i)
+		{
+			Vector3 Direction = Normalize(Vector3(Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f)));
+			Vector3 Point = Vector3(10.0f, -20.0f, 30.0f) + Direction * 50.0f;
+			Shell[i * 3] = Point.GetX();
+			Shell[i * 3 + 1] = Point.GetY();
+			Shell[i * 3 + 2] = Point.GetZ();
+		}
+
+		auto Encloses = [&]( const BoundingSphere& Sphere, const float* Points, size_t Stride, size_t Count )
+		{
+			float Limit = Sphere.GetRadius() * 1.0001f + 1e-4f;
+			for (size_t i = 0; i < Count; ++i)
+			{
+				const float* p = (const float*)((const uint8_t*)Points + Stride * i);
+				if (Length(Vector3(p[0], p[1], p[2]) - Sphere.GetCenter()) > Limit)
+					return false;
+			}
+			return true;
+		};
+
+		bool SpheresEnclose = true;
+		for (size_t Count : Counts)
+		{
+			SpheresEnclose = SpheresEnclose && Encloses(ComputeBoundingSphereRitter(Vertices.data(), kStride, Count), Vertices.data(), kStride, Count);
+			for (uint32_t NumDirections = 3; NumDirections <= 13; NumDirections += NumDirections == 3 ? 4 : 6)
+			{
+				SpheresEnclose = SpheresEnclose && Encloses(ComputeBoundingSphereEPOS(Vertices.data(), kStride, Count, NumDirections),
+					Vertices.data(), kStride, Count);
+			}
+		}
+
+		BoundingSphere RitterShell = ComputeBoundingSphereRitter(Shell.data(), sizeof(float) * 3, kNumVertices);
+		BoundingSphere EPOSShell = ComputeBoundingSphereEPOS(Shell.data(), sizeof(float) * 3, kNumVertices, 13);
+		SpheresEnclose = SpheresEnclose && Encloses(RitterShell, Shell.data(), sizeof(float) * 3, kNumVertices) &&
+			Encloses(EPOSShell, Shell.data(), sizeof(float) * 3, kNumVertices);
+		bool SpheresTight = EPOSShell.GetRadius() <= 50.0f * 1.02f && RitterShell.GetRadius() <= 50.0f * 1.2f;
+
+		// The box tests must agree with testing every corner against every plane, except where a corner is so
+		// close to a plane that rounding decides
+		Camera Cam;
+		Cam.SetEyeAtUp(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.3f, -0.2f, -1.0f), Vector3(kYUnitVector));
+		Cam.Update();
+		const Frustum& WorldFrustum = Cam.GetWorldSpaceFrustum();
+
+		auto Classify = [&]( const Vector3* Corners, bool& Outside, bool& Inside, bool& Ambiguous )
+		{
+			Outside = false;
+			Inside = true;
+			Ambiguous = false;
+			for (int Plane = 0; Plane < 6; ++Plane)
+			{
+				BoundingPlane P = WorldFrustum.GetFrustumPlane((Frustum::PlaneID)Plane);
+				float Nearest = FLT_MAX, Farthest = -FLT_MAX;
+				for (int c = 0; c < 8; ++c)
+				{
+					float Distance = P.DistanceFromPoint(Corners[c]);
+					Nearest = std::min(Nearest, Distance);
+					Farthest = std::max(Farthest, Distance);
+				}
+				Outside = Outside || Farthest < 0.0f;
+				Inside = Inside && Nearest >= 0.0f;
+				Ambiguous = Ambiguous || fabsf(Nearest) < 1e-3f || fabsf(Farthest) < 1e-3f;
+			}
+		};
+
+		bool BoxTestsMatch = true;
+		for (uint32_t i = 0; i < 4096; ++i)
+		{
+			Vector3 Center(Random.NextFloat(-500.0f, 500.0f), Random.NextFloat(-500.0f, 500.0f), Random.NextFloat(-1000.0f, 100.0f));
+			Vector3 Extent(Random.NextFloat(1.0f, 100.0f), Random.NextFloat(1.0f, 100.0f), Random.NextFloat(1.0f, 100.0f));
+			AxisAlignedBox Box(Center - Extent, Center + Extent);
+
+			Vector3 Corners[8];
+			for (int c = 0; c < 8; ++c)
+				Corners[c] = Select(Box.GetMin(), Box.GetMax(), Vector3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f) > Vector3(kZero));
+
+			bool Outside, Inside, Ambiguous;
+			Classify(Corners, Outside, Inside, Ambiguous);
+			if (!Ambiguous)
+				BoxTestsMatch = BoxTestsMatch && WorldFrustum.IntersectBoundingBox(Box) == !Outside && WorldFrustum.ContainsBoundingBox(Box) == Inside;
+
+			AffineTransform Xform(Quaternion(Normalize(Vector3(Random.NextFloat(-1.0f, 1.0f), 1.0f, 0.5f)), Random.NextFloat(0.0f, 3.0f)), Vector3(kZero));
+			OrientedBox Oriented(Xform, Box);
+			const Matrix3& Axes = Oriented.GetHalfAxes();
+			for (int c = 0; c < 8; ++c)
+			{
+				Corners[c] = Oriented.GetCenter() + Axes.GetX() * ((c & 1) ? 1.0f : -1.0f) + Axes.GetY() * ((c & 2) ? 1.0f : -1.0f) +
+					Axes.GetZ() * ((c & 4) ? 1.0f : -1.0f);
+			}
+
+			Classify(Corners, Outside, Inside, Ambiguous);
+			if (!Ambiguous)
+				BoxTestsMatch = BoxTestsMatch && WorldFrustum.IntersectOrientedBox(Oriented) == !Outside;
+		}
+
+		bool Passed = BoxesMatch && SpheresEnclose && SpheresTight && BoxTestsMatch;
+		printf("%-48s %s\n", "Bounding volumes", Passed ? "passed" : "FAILED");
+
+		Benchmark::Run("ComputeBoundingBox", kStride * kNumVertices, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				AxisAlignedBox Box = ComputeBoundingBox(Vertices.data(), kStride, kNumVertices);
+				Benchmark::Consume((uint64_t)fabsf(Box.GetMax().GetX()));
+			}
+		});
+
+		// The loop Model used before
+		Benchmark::Run("ComputeBoundingBox/Scalar", kStride * kNumVertices, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+			{
+				Vector3 BoxMin(FLT_MAX, FLT_MAX, FLT_MAX), BoxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+				for (const float* p = Vertices.data(); p < Vertices.data() + Vertices.size(); p += 14)
+				{
+					Vector3 Position(p[0], p[1], p[2]);
+					BoxMin = Min(BoxMin, Position);
+					BoxMax = Max(BoxMax, Position);
+				}
+				Benchmark::Consume((uint64_t)fabsf(BoxMax.GetX()));
+			}
+		});
+
+		Benchmark::Run("ComputeBoundingSphereRitter", kStride * kNumVertices, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Benchmark::Consume((uint64_t)ComputeBoundingSphereRitter(Vertices.data(), kStride, kNumVertices).GetRadius());
+		});
+
+		Benchmark::Run("ComputeBoundingSphereEPOS/7", kStride * kNumVertices, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Benchmark::Consume((uint64_t)ComputeBoundingSphereEPOS(Vertices.data(), kStride, kNumVertices, 7).GetRadius());
+		});
+
+		Benchmark::Run("ComputeBoundingSphereEPOS/13", kStride * kNumVertices, [&]( uint64_t Iterations )
+		{
+			for (uint64_t n = 0; n < Iterations; ++n)
+				Benchmark::Consume((uint64_t)ComputeBoundingSphereEPOS(Vertices.data(), kStride, kNumVertices, 13).GetRadius());
+		});
+
+		return Passed;
+	}
+
+	void InitializeNullDevice( void )
+	{
+		ASSERT_SUCCEEDED(NullDevice::CreateDevice(MY_IID_PPV_ARGS(&Graphics::g_Device)));
+		Graphics::g_CommandManager.Create(Graphics::g_Device);
+		GpuTimeManager::Initialize(4096);
+	}
+
+	void ShutdownNullDevice( void )
+	{
+		CommandContext::DestroyAllContexts();
+		Graphics::g_CommandManager.Shutdown();
+		GpuTimeManager::Shutdown();
+		PSO::DestroyAll();
+		RootSignature::DestroyAll();
+		SamplerDescriptor::DestroyAll();
+		DescriptorAllocator::DestroyAll();
+		SAFE_RELEASE(Graphics::g_Device);
+	}
+
+	void PrintHelp( void )
+	{
+		printf("usage:  CoreBenchmark [-filter <substring>] [-json <file>] [-samples <count>] [-warmup <count>]\n");
+	}
+}
+
+int main( int argc, char* argv[] )
+{
+	Benchmark::Options Options;
+	std::string JSONFile;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string Arg = argv[i];
+		bool HasValue = i + 1 < argc;
+
+		if (Arg == "-filter" && HasValue)
+			Options.Filter = argv[++i];
+		else if (Arg == "-json" && HasValue)
+			JSONFile = argv[++i];
+		else if (Arg == "-samples" && HasValue)
+			Options.Samples = std::max(1, atoi(argv[++i]));
+		else if (Arg == "-warmup" && HasValue)
+			Options.WarmupSamples = std::max(0, atoi(argv[++i]));
+		else
+		{
+			PrintHelp();
+			return 1;
+		}
+	}
+
+	SystemTime::Initialize();
+	Benchmark::SetOptions(Options);
+
+	bool Passed = CheckDDSLayout();
+	Passed = CheckUploadRing() && Passed;
+	Passed = CheckResourceStateTracker() && Passed;
+	Passed = CheckNestedJobs() && Passed;
+	Passed = CheckFramePacer() && Passed;
+	Passed = CheckFrameGraph() && Passed;
+	Passed = BenchmarkBlockCompression() && Passed;
+	Passed = BenchmarkMipGenerator() && Passed;
+	Passed = BenchmarkSlidingWindowMinMax() && Passed;
+	Passed = BenchmarkRandom() && Passed;
+	Passed = BenchmarkBatchTransform() && Passed;
+	Passed = BenchmarkShadowCascades() && Passed;
+	Passed = BenchmarkBoundingVolumes() && Passed;
+
+	BenchmarkMemory();
+	BenchmarkHashing();
+	BenchmarkFrustumCulling();
+	BenchmarkOptimizeFaces();
+	BenchmarkJobSystem();
+
+	InitializeNullDevice();
+	Passed = CheckNullDevice() && Passed;
+	Passed = CheckPooledContextProfiling() && Passed;
+	BenchmarkLinearAllocator();
+	BenchmarkDynamicDescriptors();
+	Passed = BenchmarkSamplers() && Passed;
+	BenchmarkBuddyAllocator();
+	BenchmarkTextRenderer();
+	ShutdownNullDevice();
+
+	if (!JSONFile.empty() && !Benchmark::WriteJSON(JSONFile))
+	{
+		printf("Unable to write %s\n", JSONFile.c_str());
+		return 1;
+	}
+
+	return Passed ? 0 : 1;
+}
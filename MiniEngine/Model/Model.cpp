@@ -13,6 +13,7 @@
 
 #include "pch.h"
 #include "Model.h"
+#include "Math/BoundingVolumes.h"
 #include <string.h>
 #include <float.h>
 
@@ -46,6 +47,7 @@ int Model::FormatFromFilename(const char *filename)
 
 Model::Model()
 	: m_pMesh(nullptr)
+	, m_pMeshSphere(nullptr)
 	, m_pMaterial(nullptr)
 	, m_pVertexData(nullptr)
 	, m_pIndexData(nullptr)
@@ -68,6 +70,8 @@ void Model::Clear()
 
 	delete [] m_pMesh;
 	m_pMesh = nullptr;
+	delete [] m_pMeshSphere;
+	m_pMeshSphere = nullptr;
 	m_Header.meshCount = 0;
 
 	delete [] m_pMaterial;
@@ -148,22 +152,11 @@ void Model::ComputeMeshBoundingBox(unsigned int meshIndex, BoundingBox &bbox) co
 
 	if (mesh->vertexCount > 0)
 	{
-		unsigned int vertexStride = mesh->vertexStride;
+		const unsigned char *positions = m_pVertexData + mesh->vertexDataByteOffset + mesh->attrib[attrib_position].offset;
+		AxisAlignedBox box = ComputeBoundingBox(positions, mesh->vertexStride, mesh->vertexCount);
 
-		const float *p = (float*)(m_pVertexData + mesh->vertexDataByteOffset + mesh->attrib[attrib_position].offset);
-		const float *pEnd = (float*)(m_pVertexData + mesh->vertexDataByteOffset + mesh->vertexCount * mesh->vertexStride + mesh->attrib[attrib_position].offset);
-		bbox.min = Scalar(FLT_MAX);
-		bbox.max = Scalar(-FLT_MAX);
-
-		while (p < pEnd)
-		{
-			Vector3 pos(*(p + 0), *(p + 1), *(p + 2));
-
-			bbox.min = Min(bbox.min, pos);
-			bbox.max = Max(bbox.max, pos);
-
-			(*(uint8_t**)&p) += vertexStride;
-		}
+		bbox.min = box.GetMin();
+		bbox.max = box.GetMax();
 	}
 	else
 	{
@@ -203,6 +196,19 @@ void Model::ComputeAllBoundingBoxes()
 	ComputeGlobalBoundingBox(m_Header.boundingBox);
 }
 
+void Model::ComputeAllBoundingSpheres()
+{
+	delete [] m_pMeshSphere;
+	m_pMeshSphere = new BoundingSphere[m_Header.meshCount];
+
+	for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+	{
+		const Mesh *mesh = m_pMesh + meshIndex;
+		const unsigned char *positions = m_pVertexData + mesh->vertexDataByteOffset + mesh->attrib[attrib_position].offset;
+		m_pMeshSphere[meshIndex] = ComputeBoundingSphereEPOS(positions, mesh->vertexStride, mesh->vertexCount);
+	}
+}
+
 void Model::LoadPostProcess(bool needToOptimize)
 {
 	if (needToOptimize)
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "VectorMath.h"
+#include "Math/BoundingSphere.h"
 #include "TextureManager.h"
 #include "GpuBuffer.h"
 
@@ -164,6 +165,10 @@ public:
 	};
 	Mesh *m_pMesh;
 
+	// One per mesh, and usually much tighter than spheres around the bounding boxes.  The mesh records in the
+	// file don't have room for them, so they are computed from the vertices on load.
+	BoundingSphere *m_pMeshSphere;
+
 	struct Material
 	{
 		Vector3 diffuse;
@@ -222,6 +227,7 @@ private:
 	// requires all mesh bounding boxes to be computed
 	void ComputeGlobalBoundingBox(BoundingBox &bbox) const;
 	void ComputeAllBoundingBoxes();
+	void ComputeAllBoundingSpheres();
 
 #ifdef MODEL_ENABLE_OPTIMIZER
 	void Optimize();
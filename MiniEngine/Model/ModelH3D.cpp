@@ -18,6 +18,7 @@
 #include "GraphicsCore.h"
 #include "DescriptorHeap.h"
 #include "CommandContext.h"
+#include "JobSystem.h"
 #include <stdio.h>
 
 using namespace Graphics;
@@ -29,6 +30,7 @@ bool Model::LoadH3D(const char *filename)
 		return false;
 
 	bool ok = false;
+	JobSystem::Counter TextureCounter;
 
 	if (1 != fread(&m_Header, sizeof(Header), 1, file)) goto h3d_load_fail;
 
@@ -67,6 +69,9 @@ bool Model::LoadH3D(const char *filename)
 	}
 #endif
 
+	// Textures only depend on the materials, so load them while the geometry is read and uploaded
+	JobSystem::Run( [this] { LoadTextures(); }, &TextureCounter );
+
 	m_pVertexData = new unsigned char[ m_Header.vertexDataByteSize ];
 	m_pIndexData = new unsigned char[ m_Header.indexDataByteSize ];
 	m_pVertexDataDepth = new unsigned char[ m_Header.vertexDataByteSizeDepth ];
@@ -82,6 +87,8 @@ bool Model::LoadH3D(const char *filename)
 	if (m_Header.indexDataByteSize > 0)
 		if (1 != fread(m_pIndexDataDepth, m_Header.indexDataByteSize, 1, file)) goto h3d_load_fail;
 
+	ComputeAllBoundingSpheres();
+
 	m_VertexBuffer.Create(L"VertexBuffer", m_Header.vertexDataByteSize / m_VertexStride, m_VertexStride, m_pVertexData);
 	m_IndexBuffer.Create(L"IndexBuffer", m_Header.indexDataByteSize / sizeof(uint16_t), sizeof(uint16_t), m_pIndexData);
 	delete [] m_pVertexData;
@@ -96,12 +103,12 @@ bool Model::LoadH3D(const char *filename)
 	delete [] m_pIndexDataDepth;
 	m_pIndexDataDepth = nullptr;
 
-	LoadTextures();
-
 	ok = true;
 
 h3d_load_fail:
 
+	JobSystem::Wait(TextureCounter);
+
 	if (EOF == fclose(file))
 		ok = false;
 
@@ -168,49 +175,54 @@ void Model::LoadTextures(void)
 
 	m_SRVs = new D3D12_CPU_DESCRIPTOR_HANDLE[m_Header.materialCount * 6];
 
-	const ManagedTexture* MatTextures[6] = {};
-
-	for (uint32_t materialIdx = 0; materialIdx < m_Header.materialCount; ++materialIdx)
+	// Each material's fallback chain is resolved by one job.  Materials sharing a texture wait for whichever
+	// job requested it first.
+	JobSystem::ParallelFor(m_Header.materialCount, 1, [this](size_t Begin, size_t End)
 	{
-		const Material& pMaterial = m_pMaterial[materialIdx];
+		const ManagedTexture* MatTextures[6] = {};
 
-		// Load diffuse
-		MatTextures[0] = TextureManager::LoadFromFile(pMaterial.texDiffusePath, true);
-		if (!MatTextures[0]->IsValid())
-			MatTextures[0] = TextureManager::LoadFromFile("default", true);
-
-		// Load specular
-		MatTextures[1] = TextureManager::LoadFromFile(pMaterial.texSpecularPath, true);
-		if (!MatTextures[1]->IsValid())
+		for (uint32_t materialIdx = (uint32_t)Begin; materialIdx < (uint32_t)End; ++materialIdx)
 		{
-			MatTextures[1] = TextureManager::LoadFromFile(std::string(pMaterial.texDiffusePath) + "_specular", true);
+			const Material& pMaterial = m_pMaterial[materialIdx];
+
+			// Load diffuse
+			MatTextures[0] = TextureManager::LoadFromFile(pMaterial.texDiffusePath, true);
+			if (!MatTextures[0]->IsValid())
+				MatTextures[0] = TextureManager::LoadFromFile("default", true);
+
+			// Load specular
+			MatTextures[1] = TextureManager::LoadFromFile(pMaterial.texSpecularPath, true);
 			if (!MatTextures[1]->IsValid())
-				MatTextures[1] = TextureManager::LoadFromFile("default_specular", true);
-		}
+			{
+				MatTextures[1] = TextureManager::LoadFromFile(std::string(pMaterial.texDiffusePath) + "_specular", true);
+				if (!MatTextures[1]->IsValid())
+					MatTextures[1] = TextureManager::LoadFromFile("default_specular", true);
+			}
 
-		// Load emissive
-		//MatTextures[2] = TextureManager::LoadFromFile(pMaterial.texEmissivePath, true);
+			// Load emissive
+			//MatTextures[2] = TextureManager::LoadFromFile(pMaterial.texEmissivePath, true);
 
-		// Load normal
-		MatTextures[3] = TextureManager::LoadFromFile(pMaterial.texNormalPath, false);
-		if (!MatTextures[3]->IsValid())
-		{
-			MatTextures[3] = TextureManager::LoadFromFile(std::string(pMaterial.texDiffusePath) + "_normal", false);
+			// Load normal
+			MatTextures[3] = TextureManager::LoadFromFile(pMaterial.texNormalPath, false);
 			if (!MatTextures[3]->IsValid())
-				MatTextures[3] = TextureManager::LoadFromFile("default_normal", false);
-		}
+			{
+				MatTextures[3] = TextureManager::LoadFromFile(std::string(pMaterial.texDiffusePath) + "_normal", false);
+				if (!MatTextures[3]->IsValid())
+					MatTextures[3] = TextureManager::LoadFromFile("default_normal", false);
+			}
 
-		// Load lightmap
-		//MatTextures[4] = TextureManager::LoadFromFile(pMaterial.texLightmapPath, true);
+			// Load lightmap
+			//MatTextures[4] = TextureManager::LoadFromFile(pMaterial.texLightmapPath, true);
 
-		// Load reflection
-		//MatTextures[5] = TextureManager::LoadFromFile(pMaterial.texReflectionPath, true);
+			// Load reflection
+			//MatTextures[5] = TextureManager::LoadFromFile(pMaterial.texReflectionPath, true);
 
-		m_SRVs[materialIdx * 6 + 0] = MatTextures[0]->GetSRV();
-		m_SRVs[materialIdx * 6 + 1] = MatTextures[1]->GetSRV();
-		m_SRVs[materialIdx * 6 + 2] = MatTextures[0]->GetSRV();
-		m_SRVs[materialIdx * 6 + 3] = MatTextures[3]->GetSRV();
-		m_SRVs[materialIdx * 6 + 4] = MatTextures[0]->GetSRV();
-		m_SRVs[materialIdx * 6 + 5] = MatTextures[0]->GetSRV();
-	}
+			m_SRVs[materialIdx * 6 + 0] = MatTextures[0]->GetSRV();
+			m_SRVs[materialIdx * 6 + 1] = MatTextures[1]->GetSRV();
+			m_SRVs[materialIdx * 6 + 2] = MatTextures[0]->GetSRV();
+			m_SRVs[materialIdx * 6 + 3] = MatTextures[3]->GetSRV();
+			m_SRVs[materialIdx * 6 + 4] = MatTextures[0]->GetSRV();
+			m_SRVs[materialIdx * 6 + 5] = MatTextures[0]->GetSRV();
+		}
+	});
 }
@@ -334,6 +334,7 @@ bool Model::LoadAssimp(const char *filename)
 	}
 
 	ComputeAllBoundingBoxes();
+	ComputeAllBoundingSpheres();
 
 	return true;
 }
@@ -30,6 +30,8 @@
 #include "ShadowCamera.h"
 #include "ParticleEffectManager.h"
 #include "GameInput.h"
+#include "JobSystem.h"
+#include <functional>
 
 #include "CompiledShaders/DepthViewerVS.h"
 #include "CompiledShaders/DepthViewerPS.h"
@@ -48,7 +50,7 @@ class ModelViewer : public GameCore::IGameApp
 public:
 
 	ModelViewer()
-		: m_pCameraController(nullptr)
+		: m_pCameraController(nullptr), m_ShadowAtlas(nullptr)
 	{
 	}
 
@@ -60,7 +62,10 @@ public:
 
 private:
 
-	void RenderObjects( GraphicsContext& Context, const Matrix4& ViewProjMat );
+	void RenderObjects( GraphicsContext& Context, const Matrix4& ViewProjMat, uint32_t FirstMesh, uint32_t EndMesh,
+		const Frustum* CullFrustum );
+	void RenderPass( GraphicsContext& Context, const Matrix4& ViewProjMat, const std::function<void(GraphicsContext&)>& SetupPass,
+		const Frustum* CullFrustum = nullptr );
 	void CreateParticleEffects();
 	Camera m_Camera;
 	CameraController* m_pCameraController;
@@ -77,7 +82,8 @@ private:
 	Model m_Model;
 
 	Vector3 m_SunDirection;
-	ShadowCamera m_SunShadow;
+	CascadedShadowCamera m_SunShadow;
+	ID3D12Resource* m_ShadowAtlas;		// Cached cascades are lost when the shadow buffer is recreated
 };
 
 CREATE_APPLICATION( ModelViewer )
@@ -85,9 +91,14 @@ CREATE_APPLICATION( ModelViewer )
 ExpVar m_SunLightIntensity("Application/Sun Intensity", 4.0f, 0.0f, 16.0f, 0.25f);
 NumVar m_SunOrientation("Application/Sun Orientation", -0.5f, -100.0f, 100.0f, 0.1f );
 NumVar m_SunInclination("Application/Sun Inclination", 0.75f, 0.0f, 1.0f, 0.01f );
-NumVar ShadowDimX("Application/Shadow Dim X", 5000, 1000, 10000, 100 );
-NumVar ShadowDimY("Application/Shadow Dim Y", 3000, 1000, 10000, 100 );
-NumVar ShadowDimZ("Application/Shadow Dim Z", 3000, 1000, 10000, 100 );
+IntVar ShadowCascades("Application/Shadows/Cascade Count", 4, 1, CascadedShadowCamera::kMaxCascades );
+NumVar ShadowDistance("Application/Shadows/Distance", 4000, 500, 10000, 100 );
+const char* ShadowSplitLabels[] = { "Uniform", "Logarithmic", "Practical" };
+EnumVar ShadowSplits("Application/Shadows/Split Scheme", kPracticalSplits, 3, ShadowSplitLabels );
+NumVar ShadowSplitLambda("Application/Shadows/Practical Lambda", 0.75f, 0.0f, 1.0f, 0.05f );
+IntVar ShadowCacheInterval("Application/Shadows/Cached Cascade Interval", 4, 1, 16 );	// Applies past the first two cascades
+NumVar ShadowCasterDistance("Application/Shadows/Caster Distance", 3000, 0, 10000, 100 );
+IntVar RecordingContexts("Application/Recording Contexts", 4, 1, 16 );
 
 void ModelViewer::Startup( void )
 {
@@ -210,6 +221,18 @@ void ModelViewer::Update( float deltaT )
 	float sinphi = sinf(m_SunInclination * 3.14159f * 0.5f);
 	m_SunDirection = Normalize(Vector3( costheta * cosphi, sinphi, sintheta * cosphi ));
 
+	if (g_ShadowBuffer.GetResource() != m_ShadowAtlas)
+	{
+		m_ShadowAtlas = g_ShadowBuffer.GetResource();
+		m_SunShadow.Invalidate();
+	}
+
+	m_SunShadow.SetCascadeCount(ShadowCascades);
+	m_SunShadow.SetSplitScheme((CascadeSplitScheme)(int32_t)ShadowSplits, ShadowSplitLambda);
+	m_SunShadow.SetCaching(2, ShadowCacheInterval);
+	m_SunShadow.Update(-m_SunDirection, m_Camera, ShadowDistance, ShadowCasterDistance,
+		(uint32_t)g_ShadowBuffer.GetWidth() / 2, 16);
+
 	// We use viewport offsets to jitter our color samples from frame to frame (with TAA.)
 	// D3D has a design quirk with fractional offsets such that the implicit scissor
 	// region of a viewport is floor(TopLeftXY) and floor(TopLeftXY + WidthHeight), so
@@ -260,7 +283,8 @@ void ModelViewer::Update( float deltaT )
 	m_MainScissor.bottom = (LONG)g_SceneColorBuffer.GetHeight();
 }
 
-void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& ViewProjMat )
+void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& ViewProjMat, uint32_t FirstMesh, uint32_t EndMesh,
+	const Frustum* CullFrustum )
 {
 	struct VSConstants
 	{
@@ -269,7 +293,7 @@ void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& Vie
 		XMFLOAT3 viewerPos;
 	} vsConstants;
 	vsConstants.modelToProjection = ViewProjMat;
-	vsConstants.modelToShadow = m_SunShadow.GetShadowMatrix();
+	vsConstants.modelToShadow = m_SunShadow.GetCascade(0).GetShadowMatrix();
 	XMStoreFloat3(&vsConstants.viewerPos, m_Camera.GetPosition());
 
 	gfxContext.SetDynamicConstantBufferView(0, sizeof(vsConstants), &vsConstants);
@@ -278,10 +302,15 @@ void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& Vie
 
 	uint32_t VertexStride = m_Model.m_VertexStride;
 
-	for (unsigned int meshIndex = 0; meshIndex < m_Model.m_Header.meshCount; meshIndex++)
+	for (unsigned int meshIndex = FirstMesh; meshIndex < EndMesh; meshIndex++)
 	{
 		const Model::Mesh& mesh = m_Model.m_pMesh[meshIndex];
 
+		// The sphere test is cheaper and rejects most meshes, and the box is tighter for the rest
+		if (CullFrustum != nullptr && (!CullFrustum->IntersectSphere(m_Model.m_pMeshSphere[meshIndex]) ||
+			!CullFrustum->IntersectBoundingBox(AxisAlignedBox(mesh.boundingBox.min, mesh.boundingBox.max))))
+			continue;
+
 		uint32_t indexCount = mesh.indexCount;
 		uint32_t startIndex = mesh.indexDataByteOffset / sizeof(uint16_t);
 		uint32_t baseVertex = mesh.vertexDataByteOffset / VertexStride;
@@ -301,6 +330,39 @@ void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& Vie
 	}
 }
 
+// Record the meshes of a pass.  With more than one recording context, the meshes are split into ranges which
+// are recorded in parallel on their own contexts.  Those are executed right after the commands recorded so far
+// on the main context, with one ExecuteCommandLists call.  SetupPass must set all of the state the draws need,
+// since it is applied to each context.  Meshes outside CullFrustum, when there is one, are skipped.
+void ModelViewer::RenderPass( GraphicsContext& gfxContext, const Matrix4& ViewProjMat,
+	const std::function<void(GraphicsContext&)>& SetupPass, const Frustum* CullFrustum )
+{
+	uint32_t MeshCount = m_Model.m_Header.meshCount;
+	uint32_t NumContexts = std::min((uint32_t)RecordingContexts, MeshCount);
+
+	if (NumContexts <= 1)
+	{
+		SetupPass(gfxContext);
+		RenderObjects(gfxContext, ViewProjMat, 0, MeshCount, CullFrustum);
+		return;
+	}
+
+	GraphicsContext* Contexts[16];
+	GraphicsContext::BeginMultiple(NumContexts, Contexts);
+
+	JobSystem::ParallelFor(NumContexts, 1, [&](size_t Begin, size_t End)
+	{
+		for (size_t i = Begin; i < End; ++i)
+		{
+			SetupPass(*Contexts[i]);
+			RenderObjects(*Contexts[i], ViewProjMat, (uint32_t)(MeshCount * i / NumContexts),
+				(uint32_t)(MeshCount * (i + 1) / NumContexts), CullFrustum);
+		}
+	});
+
+	gfxContext.FlushWith((CommandContext**)Contexts, NumContexts);
+}
+
 void ModelViewer::RenderScene( void )
 {
 	GraphicsContext& gfxContext = GraphicsContext::Begin(L"Scene Render");
@@ -313,34 +375,51 @@ void ModelViewer::RenderScene( void )
 		Vector3 sunLight;
 		Vector3 ambientLight;
 		float ShadowTexelSize;
+		uint32_t CascadeCount;
+		Vector4 CascadeScale[CascadedShadowCamera::kMaxCascades];
+		Vector4 CascadeOffset[CascadedShadowCamera::kMaxCascades];
 	} psConstants;
 
 	psConstants.sunDirection = m_SunDirection;
 	psConstants.sunLight = Vector3(1.0f, 1.0f, 1.0f) * m_SunLightIntensity;
 	psConstants.ambientLight = Vector3(0.2f, 0.2f, 0.2f);
 	psConstants.ShadowTexelSize = 1.0f / g_ShadowBuffer.GetWidth();
-
+	psConstants.CascadeCount = m_SunShadow.GetCascadeCount();
+	for (uint32_t i = 0; i < CascadedShadowCamera::kMaxCascades; ++i)
 	{
-		ScopedTimer _prof(L"Z PrePass", gfxContext);
-
-		gfxContext.ClearDepth(g_SceneDepthBuffer);
+		psConstants.CascadeScale[i] = Vector4(m_SunShadow.GetCascadeScale(i));
+		psConstants.CascadeOffset[i] = Vector4(m_SunShadow.GetCascadeOffset(i));
+	}
 
-		gfxContext.SetRootSignature(m_RootSig);
-		gfxContext.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		gfxContext.SetIndexBuffer(m_Model.m_IndexBuffer.IndexBufferView());
+	// Set the default state for command lists
+	auto pfnSetupGraphicsState = [&](GraphicsContext& Context)
+	{
+		Context.SetRootSignature(m_RootSig);
+		Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		Context.SetIndexBuffer(m_Model.m_IndexBuffer.IndexBufferView());
 #if USE_VERTEX_BUFFER
-		gfxContext.SetVertexBuffer(0, m_Model.m_VertexBuffer.VertexBufferView());
+		Context.SetVertexBuffer(0, m_Model.m_VertexBuffer.VertexBufferView());
 #elif USE_ROOT_BUFFER_SRV
-		gfxContext.SetBufferSRV(2, m_Model.m_VertexBuffer);
+		Context.SetBufferSRV(2, m_Model.m_VertexBuffer);
 #else
-		gfxContext.SetDynamicDescriptor(2, 0, m_Model.m_VertexBuffer.GetSRV());
+		Context.SetDynamicDescriptor(2, 0, m_Model.m_VertexBuffer.GetSRV());
 #endif
-		gfxContext.SetDynamicConstantBufferView(1, sizeof(psConstants), &psConstants);
+		Context.SetDynamicDescriptors(4, 0, 2, m_ExtraTextures);
+		Context.SetDynamicConstantBufferView(1, sizeof(psConstants), &psConstants);
+	};
+
+	{
+		ScopedTimer _prof(L"Z PrePass", gfxContext);
+
+		gfxContext.ClearDepth(g_SceneDepthBuffer);
 
-		gfxContext.SetPipelineState(m_DepthPSO);
-		gfxContext.SetDepthStencilTarget(g_SceneDepthBuffer);
-		gfxContext.SetViewportAndScissor(m_MainViewport, m_MainScissor);
-		RenderObjects(gfxContext, m_ViewProjMatrix );
+		RenderPass(gfxContext, m_ViewProjMatrix, [&](GraphicsContext& Context)
+		{
+			pfnSetupGraphicsState(Context);
+			Context.SetPipelineState(m_DepthPSO);
+			Context.SetDepthStencilTarget(g_SceneDepthBuffer);
+			Context.SetViewportAndScissor(m_MainViewport, m_MainScissor);
+		}, &m_Camera.GetWorldSpaceFrustum());
 	}
 
 	SSAO::Render(gfxContext, m_Camera);
@@ -351,41 +430,57 @@ void ModelViewer::RenderScene( void )
 
 		gfxContext.ClearColor(g_SceneColorBuffer);
 
-		// Set the default state for command lists
-		auto& pfnSetupGraphicsState = [&](void)
-		{
-			gfxContext.SetRootSignature(m_RootSig);
-			gfxContext.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			gfxContext.SetIndexBuffer(m_Model.m_IndexBuffer.IndexBufferView());
-#if USE_VERTEX_BUFFER
-			gfxContext.SetVertexBuffer(0, m_Model.m_VertexBuffer.VertexBufferView());
-#elif USE_ROOT_BUFFER_SRV
-			gfxContext.SetBufferSRV(2, m_Model.m_VertexBuffer);
-#else
-			gfxContext.SetDynamicDescriptor(2, 0, m_Model.m_VertexBuffer.GetSRV());
-#endif
-			gfxContext.SetDynamicDescriptors(4, 0, 2, m_ExtraTextures);
-			gfxContext.SetDynamicConstantBufferView(1, sizeof(psConstants), &psConstants);
-		};
-
-		pfnSetupGraphicsState();
-
 		{
 			ScopedTimer _prof(L"Render Shadow Map", gfxContext);
 
-			m_SunShadow.UpdateMatrix(-m_SunDirection, Vector3(0, -500.0f, 0), Vector3(ShadowDimX, ShadowDimY, ShadowDimZ),
-				(uint32_t)g_ShadowBuffer.GetWidth(), (uint32_t)g_ShadowBuffer.GetHeight(), 16);
+			// Each cascade has a quarter of the shadow buffer.  Cached cascades keep what they drew before.
+			LONG TileSize = (LONG)g_ShadowBuffer.GetWidth() / 2;
+
+			for (uint32_t i = 0; i < m_SunShadow.GetCascadeCount(); ++i)
+			{
+				if (!m_SunShadow.NeedsRender(i))
+					continue;
+
+				const ShadowCamera& Cascade = m_SunShadow.GetCascade(i);
+
+				D3D12_RECT Tile;
+				Tile.left = (LONG)(i & 1) * TileSize;
+				Tile.top = (LONG)(i >> 1) * TileSize;
+				Tile.right = Tile.left + TileSize;
+				Tile.bottom = Tile.top + TileSize;
+
+				D3D12_VIEWPORT Viewport;
+				Viewport.TopLeftX = (float)Tile.left;
+				Viewport.TopLeftY = (float)Tile.top;
+				Viewport.Width = (float)TileSize;
+				Viewport.Height = (float)TileSize;
+				Viewport.MinDepth = 0.0f;
+				Viewport.MaxDepth = 1.0f;
+
+				// Like ShadowBuffer, leave the boundary texels empty so that shadows don't stretch past the tile
+				D3D12_RECT Scissor = Tile;
+				Scissor.left += 1;
+				Scissor.top += 1;
+				Scissor.right -= 1;
+				Scissor.bottom -= 1;
+
+				gfxContext.ClearDepth(g_ShadowBuffer, Tile);
+
+				RenderPass(gfxContext, Cascade.GetViewProjMatrix(), [&](GraphicsContext& Context)
+				{
+					pfnSetupGraphicsState(Context);
+					Context.SetPipelineState(m_ShadowPSO);
+					Context.SetDepthStencilTarget(g_ShadowBuffer);
+					Context.SetViewportAndScissor(Viewport, Scissor);
+				}, &Cascade.GetWorldSpaceFrustum());
+			}
 
-			gfxContext.SetPipelineState(m_ShadowPSO);
-			g_ShadowBuffer.BeginRendering(gfxContext);
-			RenderObjects(gfxContext, m_SunShadow.GetViewProjMatrix());
 			g_ShadowBuffer.EndRendering(gfxContext);
 		}
 
 		if (SSAO::AsyncCompute)
 		{
 			gfxContext.Flush();
-			pfnSetupGraphicsState();
 
 			// Make the 3D queue wait for the Compute queue to finish SSAO
 			g_CommandManager.GetGraphicsQueue().StallForProducer(g_CommandManager.GetComputeQueue());
@@ -393,14 +488,23 @@ void ModelViewer::RenderScene( void )
 
 		{
 			ScopedTimer _prof(L"Render Color", gfxContext);
-			gfxContext.SetPipelineState(m_ModelPSO);
+
 			gfxContext.TransitionResource(g_SSAOFullScreen, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			gfxContext.SetRenderTarget(g_SceneColorBuffer, g_SceneDepthBuffer, true);
-			gfxContext.SetViewportAndScissor(m_MainViewport, m_MainScissor);
-			RenderObjects( gfxContext, m_ViewProjMatrix );
+
+			RenderPass(gfxContext, m_ViewProjMatrix, [&](GraphicsContext& Context)
+			{
+				pfnSetupGraphicsState(Context);
+				Context.SetPipelineState(m_ModelPSO);
+				Context.SetRenderTarget(g_SceneColorBuffer, g_SceneDepthBuffer, true);
+				Context.SetViewportAndScissor(m_MainViewport, m_MainScissor);
+			}, &m_Camera.GetWorldSpaceFrustum());
 		}
 	}
 
+	// The cascades refit for this frame weren't drawn
+	if (SSAO::DebugDraw)
+		m_SunShadow.Invalidate();
+
 	ParticleEffects::Render(gfxContext, m_Camera, g_SceneColorBuffer, g_SceneDepthBuffer, g_LinearDepth);
 
 	MotionBlur::RenderCameraBlur(gfxContext, m_Camera);
@@ -41,6 +41,9 @@ cbuffer PSConstants : register(b0)
 	float3 AmbientColor;
 	uint _pad;
 	float  ShadowTexelSize;
+	uint CascadeCount;
+	float4 CascadeScale[4];		// Maps cascade 0's shadow coordinates to each cascade's
+	float4 CascadeOffset[4];
 }
 
 SamplerState sampler0 : register(s0);
@@ -63,7 +66,7 @@ float3 ApplyAmbientLight(
 	return ao * diffuse * lightColor;
 }
 
-float GetShadow( float3 ShadowCoord )
+float FilterShadow( float3 ShadowCoord )
 {
 #ifdef SINGLE_SAMPLE
 	float result = ShadowMap.SampleCmpLevelZero( ShadowSampler, ShadowCoord.xy, ShadowCoord.z );
@@ -88,6 +91,26 @@ float GetShadow( float3 ShadowCoord )
 	return result * result;
 }
 
+// The cascades are tiled two by two in the shadow buffer.  Use the first one which covers the whole filter
+// footprint, leaving a margin for the texels the shadow pass doesn't draw at the tile edges.
+float GetShadow( float3 ShadowCoord )
+{
+	const float Border = 8.0 * ShadowTexelSize;
+
+	for (uint i = 0; i < CascadeCount; ++i)
+	{
+		float3 CascadeCoord = ShadowCoord * CascadeScale[i].xyz + CascadeOffset[i].xyz;
+		if (all(CascadeCoord.xy >= Border && CascadeCoord.xy <= 1.0 - Border))
+		{
+			CascadeCoord.xy = (CascadeCoord.xy + float2(i & 1, i >> 1)) * 0.5;
+			return FilterShadow(CascadeCoord);
+		}
+	}
+
+	// Beyond the shadow distance
+	return 1.0;
+}
+
 float3 ApplyDirectionalLight(
 	float3 diffuseColor,	// Diffuse albedo
 	float3 specularColor,	// Specular albedo
@@ -109,4 +109,10 @@ public:
 	{
 		return m_LastCompletedFence;
 	}
+
+	// Queries the fence object directly, which may be ahead of the last retired frame.
+	inline UINT64 GetCompletedFence() const
+	{
+		return m_pFenceObject->GetCompletedValue();
+	}
 };
@@ -485,7 +485,7 @@ bool D3D12MemoryManagement::HandleMessage(HWND hwnd, UINT Message, WPARAM wParam
 	return false;
 }
 
-void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBounds, const Image* pImage, UINT8* pVisibleMip, UINT8* pPrefetchMip)
+void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBounds, const Image* pImage, UINT8* pVisibleMip, UINT8* pPrefetchMip, float* pScreenCoverage, float* pViewDistance)
 {
 	float ImageScale = (pImage->Bounds.Right - pImage->Bounds.Left) * m_pSceneCamera->GetZoom();
 	UINT8 RequiredMip = (UINT8)CalculateRequiredMipLevel(pImage->pResource, ImageScale);
@@ -520,8 +520,27 @@ void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBound
 		PrefetchMip = UNDEFINED_MIPMAP_INDEX;
 	}
 
+	//
+	// Calculate how much of the viewport the image covers, and how far its center is from the
+	// center of the viewport, relative to the viewport diagonal. The paging thread uses these
+	// to order resources within a priority class.
+	//
+	float ViewportWidth = pViewportBounds->Right - pViewportBounds->Left;
+	float ViewportHeight = pViewportBounds->Bottom - pViewportBounds->Top;
+
+	float CoveredWidth = max(0.0f, min(pViewportBounds->Right, pImage->Bounds.Right) - max(pViewportBounds->Left, pImage->Bounds.Left));
+	float CoveredHeight = max(0.0f, min(pViewportBounds->Bottom, pImage->Bounds.Bottom) - max(pViewportBounds->Top, pImage->Bounds.Top));
+
+	float DeltaX = (pImage->Bounds.Left + pImage->Bounds.Right - pViewportBounds->Left - pViewportBounds->Right) * 0.5f;
+	float DeltaY = (pImage->Bounds.Top + pImage->Bounds.Bottom - pViewportBounds->Top - pViewportBounds->Bottom) * 0.5f;
+
+	float ViewportArea = ViewportWidth * ViewportHeight;
+	float ViewportDiagonal = sqrtf(ViewportWidth * ViewportWidth + ViewportHeight * ViewportHeight);
+
 	*pVisibleMip = VisibleMip;
 	*pPrefetchMip = PrefetchMip;
+	*pScreenCoverage = ViewportArea > 0.0f ? (CoveredWidth * CoveredHeight) / ViewportArea : 0.0f;
+	*pViewDistance = ViewportDiagonal > 0.0f ? sqrtf(DeltaX * DeltaX + DeltaY * DeltaY) / ViewportDiagonal : 0.0f;
 }
 
 HRESULT D3D12MemoryManagement::RenderScene(const RectF& ViewportBounds)
@@ -537,16 +556,21 @@ HRESULT D3D12MemoryManagement::RenderScene(const RectF& ViewportBounds)
 		//
 		UINT8 VisibleMip;
 		UINT8 PrefetchMip;
-		CalculateImagePagingData(&SceneBounds, &Img, &VisibleMip, &PrefetchMip);
+		float ScreenCoverage;
+		float ViewDistance;
+		CalculateImagePagingData(&SceneBounds, &Img, &VisibleMip, &PrefetchMip, &ScreenCoverage, &ViewDistance);
 
 		//
 		// If the visibility or prefetch values have changed, notify the paging thread
-		// so it can update this resource's priority.
+		// so it can update this resource's priority. The coverage and distance only
+		// refine the ordering, so they are refreshed along with a priority change.
 		//
 		if (pResource->VisibleMip != VisibleMip || pResource->PrefetchMip != PrefetchMip)
 		{
 			pResource->VisibleMip = VisibleMip;
 			pResource->PrefetchMip = PrefetchMip;
+			pResource->ScreenCoverage = ScreenCoverage;
+			pResource->ViewDistance = ViewDistance;
 			NotifyPagingWork(pResource);
 		}
 
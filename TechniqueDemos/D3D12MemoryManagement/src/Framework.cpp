@@ -63,9 +63,12 @@ DX12Framework::DX12Framework() :
 	InitializeListHead(&m_DynamicDescriptorHeapListHead);
 	InitializeListHead(&m_UnreferencedResourceListHead);
 	InitializeListHead(&m_UncommittedListHead);
-	for (int i = 0; i < MAX_MIP_COUNT; ++i)
+	for (int Pass = 0; Pass < _ERTP_COUNT; ++Pass)
 	{
-		InitializeListHead(&m_CommitmentListHeads[i]);
+		for (int i = 0; i < MAX_MIP_COUNT; ++i)
+		{
+			InitializeListHead(&m_CommitmentListHeads[Pass][i]);
+		}
 	}
 
 	ZeroMemory(m_StatTimeBetweenFrames, sizeof(m_StatTimeBetweenFrames));
@@ -1180,6 +1183,7 @@ HRESULT DX12Framework::CreateResource(LPCWSTR pFileName, Resource** ppResource)
 	}
 
 	ZeroMemory(pResource, sizeof(Resource));
+	pResource->PagingHeapIndex = INVALID_PAGING_HEAP_INDEX;
 
 	IWICBitmapDecoder* pDecoder = nullptr;
 	static UINT GeneratedImageIndex = 0;
@@ -1433,8 +1437,9 @@ HRESULT DX12Framework::CreateResourceDeviceState(Resource* pResource, UINT NumMi
 
 	pResource->TrimLimit = ERTP_None;
 	pResource->bIgnoreBudget = false;
+	pResource->bInPagingBatch = false;
 
-	pResource->PagingEntry.Flink = nullptr;
+	pResource->PagingHeapIndex = INVALID_PAGING_HEAP_INDEX;
 
 	//
 	// Notify the paging thread of this resource so it can be prioritized. Although
@@ -1833,16 +1838,17 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
 
 	UINT32 CurrentRow = 0;
 
+	//
+	// Inside a paging batch the whole mip is copied in one transfer, recorded into the
+	// batch's paging frame. The shared staging surface is reused for every transfer, so
+	// it must still be flushed after each one.
+	//
+	bool bBatched = m_bPagingBatchOpen && !m_bUseSharedStagingSurface;
+
 	while (RemainingBytes > 0)
 	{
 		UINT32 MaxTransferHeightInBlocks;
 
-		//
-		// Begin a paging frame. Each paging operation (i.e. a copy/transfer) must be contained
-		// within a paging frame so we can track and synchronize the operation on the context.
-		//
-		m_PagingContext.Begin();
-
 		UINT64 BytesInTransfer;
 		if (m_bUseSharedStagingSurface)
 		{
@@ -1887,6 +1893,17 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
 			return hr;
 		}
 
+		//
+		// Begin a paging frame. Each paging operation (i.e. a copy/transfer) must be contained
+		// within a paging frame so we can track and synchronize the operation on the context.
+		// A batch opens its frame for the first mip recorded into it. The frame is only begun
+		// once the data is staged, so a failed mip never leaves it open, in a batch or not.
+		//
+		if (!bBatched || m_PagingBatch.empty())
+		{
+			m_PagingContext.Begin();
+		}
+
 		//
 		// Copy the texture region on the copy command queue.
 		//
@@ -1908,6 +1925,14 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
 		Src.PlacedFootprint.Offset = 0;
 		pPagingFrame->pCommandList->CopyTextureRegion(&Dst, 0, CurrentRow, 0, &Src, &SrcBox);
 
+		CurrentRow += TransferHeightInRows;
+		RemainingBytes -= BytesInTransfer;
+
+		if (bBatched)
+		{
+			continue;
+		}
+
 		//
 		// Synchronize on this transfer. An application may extend this implementation
 		// to support multiple operations at a time (by allowing multiple paging frames
@@ -1916,17 +1941,25 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
 		// easier to understand.
 		//
 		hr = m_PagingContext.Execute();
+
+		m_PagingContext.End();
+		m_PagingContext.Flush();
+
 		if (FAILED(hr))
 		{
 			LOG_WARNING("Failed to transfer content for resource 0x%p, mip %d. hr=0x%.8x", pResource, Mip, hr);
 			return hr;
 		}
+	}
 
-		m_PagingContext.End();
-		m_PagingContext.Flush();
-
-		CurrentRow += TransferHeightInRows;
-		RemainingBytes -= BytesInTransfer;
+	if (bBatched)
+	{
+		//
+		// The copy is submitted with the rest of the batch in EndPagingBatch.
+		//
+		PendingMip Pending = { pResource, static_cast<UINT8>(Mip), pUploadBuffer };
+		m_PagingBatch.push_back(Pending);
+		return S_OK;
 	}
 
 	pResource->MostDetailedMipResident = Mip;
@@ -2557,6 +2590,71 @@ HRESULT DX12Framework::PageInNextLevelOfDetail(Resource* pResource)
 	return S_OK;
 }
 
+//
+// Paging batches let the worker thread record the copies for several mipmaps into a single
+// paging frame, so they are submitted to the copy queue and waited on once.
+//
+void DX12Framework::BeginPagingBatch()
+{
+	assert(!m_bPagingBatchOpen && m_PagingBatch.empty());
+	m_bPagingBatchOpen = true;
+}
+
+HRESULT DX12Framework::EndPagingBatch()
+{
+	assert(m_bPagingBatchOpen);
+	m_bPagingBatchOpen = false;
+
+	if (m_PagingBatch.empty())
+	{
+		return S_OK;
+	}
+
+	HRESULT hr = m_PagingContext.Execute();
+	if (FAILED(hr))
+	{
+		LOG_WARNING("Failed to transfer content for a batch of %d mips. hr=0x%.8x", m_PagingBatch.size(), hr);
+	}
+
+	m_PagingContext.End();
+	m_PagingContext.Flush();
+
+	if (SUCCEEDED(hr))
+	{
+		for (PendingMip& Pending : m_PagingBatch)
+		{
+			Pending.pResource->MostDetailedMipResident = Pending.Mip;
+
+			AddResourceCommitment(Pending.pResource);
+		}
+	}
+
+	//
+	// The copies have completed, so the upload buffers can be released.
+	//
+	m_PagingBatch.clear();
+
+	return hr;
+}
+
+//
+// Returns the first trimming pass which is allowed to trim the given mipmap of a resource.
+// Mipmaps more detailed than the prefetch mip are not needed at all, and mipmaps more
+// detailed than the visible mip are not needed to render what is on screen.
+//
+static ResourceTrimPass GetMipTrimPass(const Resource* pResource, UINT8 Mip)
+{
+	if (IsLessDetailedMip(Mip, pResource->PrefetchMip))
+	{
+		return ERTP_NonPrefetchable;
+	}
+	else if (IsLessDetailedMip(Mip, pResource->VisibleMip))
+	{
+		return ERTP_NonVisible;
+	}
+	return ERTP_Visible;
+}
+
 bool DX12Framework::TrimToTarget(ResourceTrimPass MaxPass, UINT64 TargetUsage)
 {
 	//
@@ -2568,88 +2666,165 @@ bool DX12Framework::TrimToTarget(ResourceTrimPass MaxPass, UINT64 TargetUsage)
 	// by allowing the paging thread to issue trimming calls to page in the visible mip,
 	// which may trim the prefetched mip.
 	//
-	for (ResourceTrimPass CurrentPass = ERTP_NonPrefetchable;
-		CurrentPass <= MaxPass;
-		CurrentPass = static_cast<ResourceTrimPass>(CurrentPass + 1))
+	// Mipmaps are collected into a batch until their sizes add up to the memory we need
+	// to release, the whole batch is trimmed, and only then is the budget queried again.
+	// If the kernel reports that we are still above the target (e.g. the budget changed),
+	// another batch is collected.
+	//
+	while (m_LocalVideoMemoryInfo.CurrentUsage >= TargetUsage)
 	{
-		//
-		// Go through the commitment list for each mip level.
-		//
-		for (UINT8 Mip = 0; Mip < MAX_MIP_COUNT; ++Mip)
+		UINT64 RequiredSize = m_LocalVideoMemoryInfo.CurrentUsage - TargetUsage + 1;
+		UINT64 BatchSize = 0;
+		UINT64 WaitFence = 0;
+		UINT64 CompletedFence = m_RenderContext.GetCompletedFence();
+
+		m_TrimBatch.clear();
+
+		for (ResourceTrimPass CurrentPass = ERTP_NonPrefetchable;
+			CurrentPass <= MaxPass && BatchSize < RequiredSize;
+			CurrentPass = static_cast<ResourceTrimPass>(CurrentPass + 1))
 		{
-			LIST_ENTRY* pResourceListHead = &m_CommitmentListHeads[Mip];
+			m_InFlightTrimCandidates.clear();
 
-			LIST_ENTRY* pEntry = pResourceListHead->Flink;
-			while (pEntry != pResourceListHead)
+			//
+			// Go through the commitment lists of this pass, from the most detailed mip level.
+			// Each list only holds resources whose most detailed resident mip is first
+			// trimmable at this pass, so earlier passes never have to be revisited.
+			//
+			for (UINT8 Mip = 0; Mip < MAX_MIP_COUNT && BatchSize < RequiredSize; ++Mip)
 			{
-				Resource* pResource = CONTAINING_RECORD(pEntry, Resource, CommittedListEntry);
-				pEntry = pEntry->Flink;
+				LIST_ENTRY* pResourceListHead = &m_CommitmentListHeads[CurrentPass][Mip];
 
-				if (Mip >= GetLeastDetailedMipHeapIndex(pResource))
+				LIST_ENTRY* pEntry = pResourceListHead->Flink;
+				while (pEntry != pResourceListHead && BatchSize < RequiredSize)
 				{
+					Resource* pResource = CONTAINING_RECORD(pEntry, Resource, CommittedListEntry);
+					pEntry = pEntry->Flink;
+
+					if (pResource->bInPagingBatch)
+					{
+						//
+						// The open paging batch builds on this resource's resident mips.
+						//
+						continue;
+					}
+
+					if (Mip >= GetLeastDetailedMipHeapIndex(pResource))
+					{
+						//
+						// Skip least detailed/packed mips, we cannot evict them.
+						//
+						continue;
+					}
+
+					ResourceMip* pResourceMip = &pResource->pDeviceState->Mips[Mip];
+
 					//
-					// Skip least detailed/packed mips, we cannot evict them.
+					// Take the reference lock so we can restrict mipmap detail for the rendering
+					// thread, while simultaneously querying the reference fence. Mipmaps which
+					// are still in use by the GPU are not restricted yet, since resources which
+					// are idle may release enough memory on their own.
 					//
-					continue;
+					EnterCriticalSection(&pResource->ReferenceLock);
+
+					ResourceTrimPass TrimPass = GetMipTrimPass(pResource, Mip);
+					UINT64 ReferenceFence = pResourceMip->ReferenceFence;
+					bool bInFlight = ReferenceFence > CompletedFence;
+
+					if (TrimPass == CurrentPass && !bInFlight)
+					{
+						pResource->MipRestriction = DecreaseMipQuality(Mip, 1);
+					}
+
+					LeaveCriticalSection(&pResource->ReferenceLock);
+
+					if (TrimPass != CurrentPass)
+					{
+						//
+						// The visibility of the resource changed since it was committed, and
+						// the paging thread has not reprioritized it yet.
+						//
+						AddResourceCommitment(pResource);
+						continue;
+					}
+
+					TrimCandidate Candidate = { pResource, Mip, ReferenceFence };
+					if (bInFlight)
+					{
+						m_InFlightTrimCandidates.push_back(Candidate);
+						continue;
+					}
+
+					m_TrimBatch.push_back(Candidate);
+					BatchSize += GetNonPackedMipSize(pResource, Mip);
 				}
+			}
 
-				ResourceMip* pResourceMip = &pResource->pDeviceState->Mips[Mip];
+			if (BatchSize >= RequiredSize || m_InFlightTrimCandidates.empty())
+			{
+				continue;
+			}
 
-				UINT64 WaitFence = 0;
+			//
+			// The idle mipmaps of this pass were not enough. Take the mipmaps which were
+			// referenced the longest time ago, so we wait as little as possible, and wait
+			// once for the whole batch rather than for each mipmap.
+			//
+			std::sort(m_InFlightTrimCandidates.begin(), m_InFlightTrimCandidates.end(),
+				[](const TrimCandidate& A, const TrimCandidate& B) { return A.ReferenceFence < B.ReferenceFence; });
+
+			for (TrimCandidate& Candidate : m_InFlightTrimCandidates)
+			{
+				Resource* pResource = Candidate.pResource;
 
-				//
-				// Take the reference lock so we can restrict mipmap detail for the rendering
-				// thread, while simultaneously querying the reference fence that we'll need
-				// to wait on in order to trim the mip.
-				//
 				EnterCriticalSection(&pResource->ReferenceLock);
 
-				if (pResourceMip->ReferenceFence > m_RenderContext.GetLastCompletedFence())
+				bool bTrimmable = GetMipTrimPass(pResource, Candidate.Mip) == CurrentPass;
+				if (bTrimmable)
 				{
-					WaitFence = pResourceMip->ReferenceFence;
+					pResource->MipRestriction = DecreaseMipQuality(Candidate.Mip, 1);
+					Candidate.ReferenceFence = pResource->pDeviceState->Mips[Candidate.Mip].ReferenceFence;
 				}
 
-				if (CurrentPass == ERTP_Visible)
-				{
-					pResource->MipRestriction = DecreaseMipQuality(Mip, 1);
-				}
-				else if (CurrentPass == ERTP_NonVisible && IsLessDetailedMip(Mip, pResource->VisibleMip))
-				{
-					pResource->MipRestriction = DecreaseMipQuality(Mip, 1);
-				}
-				else if (CurrentPass == ERTP_NonPrefetchable && IsLessDetailedMip(Mip, pResource->PrefetchMip))
-				{
-					pResource->MipRestriction = DecreaseMipQuality(Mip, 1);
-				}
 				LeaveCriticalSection(&pResource->ReferenceLock);
 
-				if (pResource->MipRestriction > Mip)
+				if (bTrimmable)
 				{
-					//
-					// This mip was used in a render operation that has not been completed. We must wait
-					// for the operation to complete before we trim the mipmap.
-					//
-					if (WaitFence > 0)
-					{
-						m_RenderContext.WaitForFence(WaitFence);
-					}
-
-					//
-					// Trim the mipmap, and check if our budget constraints have been met.
-					//
-					TrimMip(pResource, Mip);
+					WaitFence = max(WaitFence, Candidate.ReferenceFence);
 
-					UpdateVideoMemoryInfo();
-					if (m_LocalVideoMemoryInfo.CurrentUsage < TargetUsage)
+					m_TrimBatch.push_back(Candidate);
+					BatchSize += GetNonPackedMipSize(pResource, Candidate.Mip);
+					if (BatchSize >= RequiredSize)
 					{
-						return true;
+						break;
 					}
 				}
 			}
 		}
+
+		if (m_TrimBatch.empty())
+		{
+			return false;
+		}
+
+		//
+		// Some of these mips were used in render operations that have not been completed. We
+		// must wait for those operations to complete before we trim the mipmaps.
+		//
+		if (WaitFence > CompletedFence)
+		{
+			m_RenderContext.WaitForFence(WaitFence);
+		}
+
+		for (const TrimCandidate& Candidate : m_TrimBatch)
+		{
+			TrimMip(Candidate.pResource, Candidate.Mip);
+		}
+
+		UpdateVideoMemoryInfo();
 	}
 
-	return false;
+	return true;
 }
 
 void DX12Framework::TrimMip(Resource* pResource, UINT8 Mip)
@@ -2702,14 +2877,32 @@ void DX12Framework::AddResourceCommitment(Resource* pResource)
 	// providing a "level of detail" based not explicitly on the mip levels, but by
 	// total detail level.
 	//
+	// The commitment lists are also split by the first trimming pass which may trim the
+	// resource, so a trimming pass only has to look at the resources it can trim.
+	//
 	UINT CommittedListIndex = pResource->MostDetailedMipResident;
-	InsertTailList(&m_CommitmentListHeads[CommittedListIndex], &pResource->CommittedListEntry);
+	pResource->CommittedTrimPass = GetMipTrimPass(pResource, pResource->MostDetailedMipResident);
+	InsertTailList(&m_CommitmentListHeads[pResource->CommittedTrimPass][CommittedListIndex], &pResource->CommittedListEntry);
 }
 
 void DX12Framework::RemoveResourceCommitment(Resource* pResource)
 {
 	RemoveEntryList(&pResource->CommittedListEntry);
 	InsertTailList(&m_UncommittedListHead, &pResource->CommittedListEntry);
+	pResource->CommittedTrimPass = ERTP_None;
+}
+
+//
+// Moves a committed resource to the commitment list for its current trimming pass, after
+// its visible or prefetch mip has changed.
+//
+void DX12Framework::UpdateResourceCommitment(Resource* pResource)
+{
+	if (pResource->CommittedTrimPass != ERTP_None &&
+		pResource->CommittedTrimPass != GetMipTrimPass(pResource, pResource->MostDetailedMipResident))
+	{
+		AddResourceCommitment(pResource);
+	}
 }
 
 void DX12Framework::LoadConfig(int argc, LPCSTR argv[])
@@ -163,6 +163,20 @@ protected:
 
 	PagingWorkerThread* m_pWorkerThread = nullptr;
 
+	//
+	// Mipmaps whose copies have been recorded into the open paging batch. The upload
+	// buffers are kept alive until the copies complete, and the mipmaps are only made
+	// available to the renderer when the batch ends.
+	//
+	struct PendingMip
+	{
+		Resource* pResource;
+		UINT8 Mip;
+		ComPtr<ID3D12Resource> pUploadBuffer;
+	};
+	std::vector<PendingMip> m_PagingBatch;
+	bool m_bPagingBatchOpen = false;
+
 	DescriptorInfo m_DescriptorInfo;
 
 	D3D12_FEATURE_DATA_D3D12_OPTIONS m_Options;
@@ -176,7 +190,20 @@ protected:
 	LIST_ENTRY m_DynamicDescriptorHeapListHead;
 	LIST_ENTRY m_UnreferencedResourceListHead;
 	LIST_ENTRY m_UncommittedListHead;
-	LIST_ENTRY m_CommitmentListHeads[MAX_MIP_COUNT];
+	LIST_ENTRY m_CommitmentListHeads[_ERTP_COUNT][MAX_MIP_COUNT];
+
+	//
+	// Mipmaps selected by TrimToTarget. These are only used by the paging thread, and
+	// are kept between calls to avoid reallocating them for every trim.
+	//
+	struct TrimCandidate
+	{
+		Resource* pResource;
+		UINT8 Mip;
+		UINT64 ReferenceFence;
+	};
+	std::vector<TrimCandidate> m_TrimBatch;
+	std::vector<TrimCandidate> m_InFlightTrimCandidates;
 
 	TextureShader m_TextureShader;
 	ColorShader m_ColorShader;
@@ -249,7 +276,10 @@ public:
 		m_pWorkerThread->EnqueueResource(pResource);
 	}
 	HRESULT PageInNextLevelOfDetail(Resource* pResource);
+	void BeginPagingBatch();
+	HRESULT EndPagingBatch();
 	bool TrimToTarget(ResourceTrimPass TrimLimit, UINT64 TargetUsage);
+	void UpdateResourceCommitment(Resource* pResource);
 	inline bool TrimToBudget(ResourceTrimPass TrimLimit)
 	{
 		return TrimToTarget(TrimLimit, m_LocalVideoMemoryInfo.Budget);
@@ -11,6 +11,28 @@
 
 #include "stdafx.h"
 
+//
+// Limits on the paging work selected for a single batch. All of the copies in a batch are
+// submitted to the copy queue together, so larger batches mean fewer submissions and budget
+// queries, at the cost of a newly visible mipmap waiting behind a larger batch.
+//
+#define MAX_PAGING_BATCH_MIPS 16
+#define MAX_PAGING_BATCH_SIZE _64MB
+
+//
+// Returns the size of the next mipmap that will be paged in for the resource. Packed
+// mipmaps are not counted, since they are not restricted by the budget.
+//
+static UINT64 GetNextMipSize(const Resource* pResource)
+{
+	UINT NextMip = IncreaseMipQuality(pResource->MostDetailedMipResident, 1);
+	if (NextMip < pResource->PackedMipHeapIndex)
+	{
+		return GetNonPackedMipSize(pResource, NextMip);
+	}
+	return 0;
+}
+
 //
 // PagingWorkerThread
 //
@@ -24,13 +46,10 @@ PagingWorkerThread::PagingWorkerThread(DX12Framework* pFramework) :
 	m_hThread(nullptr),
 	m_CurrentStatus(EWTS_Suspended),
 	m_RequestedStatus(EWTS_Suspended),
-	m_BudgetNotificationCookie(0)
+	m_BudgetNotificationCookie(0),
+	m_PrioritizationCount(0)
 {
 	InitializeListHead(&m_PrioritizationListHead);
-	for (int i = 0; i < _ERP_COUNT; ++i)
-	{
-		InitializeListHead(&m_PriorityQueues[i]);
-	}
 
 	InitializeCriticalSection(&m_PrioritizationListLock);
 
@@ -233,7 +252,7 @@ void PagingWorkerThread::DiscardPendingWork()
 {
 	for (int i = 0; i < _ERP_COUNT; ++i)
 	{
-		InitializeListHead(&m_PriorityQueues[i]);
+		m_PriorityHeaps[i].Clear();
 	}
 }
 
@@ -260,40 +279,85 @@ void PagingWorkerThread::ProcessSubmission(bool* pMoreWork)
 	*pMoreWork = true;
 
 	//
-	// Select the highest priority paging operation from the priority queues. SelectResource
+	// Query the budget once per batch. Selection works from this cached information plus
+	// the size of the mipmaps already selected, and only goes back to the kernel when it
+	// needs to trim.
+	//
+	m_pFramework->UpdateVideoMemoryInfo();
+
+	//
+	// Select the highest priority paging operations from the priority heaps. SelectResource
 	// may return null if there are no entries, or if none of the operations can be selected
 	// (e.g. paging in the resources may go over the budget)
 	//
-	Resource* pResource = SelectResource();
-	if (pResource == nullptr)
+	Resource* pBatch[MAX_PAGING_BATCH_MIPS];
+	UINT BatchCount = 0;
+	UINT64 BatchSize = 0;
+
+	while (BatchCount < MAX_PAGING_BATCH_MIPS && BatchSize < MAX_PAGING_BATCH_SIZE)
+	{
+		Resource* pResource = SelectResource(BatchSize);
+		if (pResource == nullptr)
+		{
+			break;
+		}
+
+		pResource->bInPagingBatch = true;
+		pBatch[BatchCount++] = pResource;
+		BatchSize += GetNextMipSize(pResource);
+	}
+
+	if (BatchCount == 0)
 	{
 		*pMoreWork = false;
 		return;
 	}
 
 	//
-	// Process the request.
+	// Process the requests. The copies for the whole batch are recorded into one paging
+	// frame and submitted to the copy queue together.
 	//
-	HRESULT hr = m_pFramework->PageInNextLevelOfDetail(pResource);
+	ResourceTrimPass TrimLimit = ERTP_None;
+
+	m_pFramework->BeginPagingBatch();
+	for (UINT i = 0; i < BatchCount; ++i)
+	{
+		HRESULT hr = m_pFramework->PageInNextLevelOfDetail(pBatch[i]);
+		if (FAILED(hr))
+		{
+			*pMoreWork = false;
+		}
+
+		if (pBatch[i]->TrimLimit > TrimLimit)
+		{
+			TrimLimit = pBatch[i]->TrimLimit;
+		}
+	}
+
+	HRESULT hr = m_pFramework->EndPagingBatch();
 	if (FAILED(hr))
 	{
 		*pMoreWork = false;
 	}
 
 	//
-	// After the paging operation completes, we need to reprioritize this specific resource.
+	// After the paging operations complete, we need to reprioritize these specific resources.
 	//
-	PrioritizeResource(pResource);
+	for (UINT i = 0; i < BatchCount; ++i)
+	{
+		pBatch[i]->bInPagingBatch = false;
+		PrioritizeResource(pBatch[i]);
+	}
 
 	//
 	// Update the video memory info to see if we need to trim anything. This may be the case
-	// if the kernel recalculated the budget while processing the operation, or if we paged in
+	// if the kernel recalculated the budget while processing the operations, or if we paged in
 	// a critical resource (such as a packed mipmap), which can let us go over budget.
 	//
 	m_pFramework->UpdateVideoMemoryInfo();
 	if (m_pFramework->IsOverBudget())
 	{
-		m_pFramework->TrimToBudget(pResource->TrimLimit);
+		m_pFramework->TrimToBudget(TrimLimit);
 	}
 }
 
@@ -357,31 +421,57 @@ void PagingWorkerThread::ReprioritizeResources()
 	LeaveCriticalSection(&m_PrioritizationListLock);
 }
 
+//
+// Weights used to order resources within the same priority. Resources which cover more of
+// the screen, are closer to the center of the view, and are further away from the mipmap
+// they need are paged in first. Every prioritization also ages the resources already
+// waiting, so that resources with a low score are not starved by a steady stream of new work.
+//
+static const double CoverageWeight = 4.0;
+static const double DistanceWeight = 1.0;
+static const double MipDeltaWeight = 0.5;
+static const double AgeWeight = 0.01;
+
+//
+// Missing packed mipmaps are paged in ahead of any proximity prefetching that shares
+// their priority.
+//
+static const double PackedMipBonus = 1000.0;
+
 void PagingWorkerThread::PrioritizeResource(Resource* pResource)
 {
 	UINT8 MostDetailedMipResident = pResource->MostDetailedMipResident;
 	UINT8 VisibleMip = pResource->VisibleMip;
 	UINT8 PrefetchMip = pResource->PrefetchMip;
 
-	if (pResource->PagingEntry.Flink != nullptr)
+	if (pResource->PagingHeapIndex != INVALID_PAGING_HEAP_INDEX)
 	{
-		RemoveEntryList(&pResource->PagingEntry);
-		pResource->PagingEntry.Flink = nullptr;
+		m_PriorityHeaps[pResource->Priority].Remove(pResource);
 	}
 
+	//
+	// The visible and prefetch mips determine which trimming pass may trim this resource,
+	// so keep the framework's commitment lists in sync with them.
+	//
+	m_pFramework->UpdateResourceCommitment(pResource);
+
 	bool AnyPackedMipsMissing = MostDetailedMipResident > GetLeastDetailedMipHeapIndex(pResource);
 	bool IsInPrefetchZone = (PrefetchMip != UNDEFINED_MIPMAP_INDEX);
 
+	ResourcePriority Priority;
+	UINT8 TargetMip;
+	double Score = 0.0;
+
 	if (AnyPackedMipsMissing && IsInPrefetchZone)
 	{
 		//
 		// If the resource has not been loaded at all, and it's in the prefetch zone,
-		// consider it very high priority. We will not only add it to the high priority
-		// queue, but also push it in at the front to ensure this occurs before anything
-		// else. We want to make sure the user has *something* to see, even if it's just
+		// consider it very high priority. This is processed before anything else, since
+		// we want to make sure the user has *something* to see, even if it's just
 		// the 1x1 mipmap of a rough color.
 		//
-		InsertTailList(&m_PriorityQueues[ERP_VeryHigh], &pResource->PagingEntry);
+		Priority = ERP_VeryHigh;
+		TargetMip = GetLeastDetailedMipHeapIndex(pResource);
 		pResource->TrimLimit = ERTP_Visible;
 		pResource->bIgnoreBudget = true;
 	}
@@ -392,7 +482,8 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
 		// one currently resident. This is high priority, because we want what's on screen
 		// to be visually correct.
 		//
-		InsertTailList(&m_PriorityQueues[ERP_High], &pResource->PagingEntry);
+		Priority = ERP_High;
+		TargetMip = VisibleMip;
 		pResource->TrimLimit = ERTP_NonVisible;
 	}
 	else if (AnyPackedMipsMissing)
@@ -402,7 +493,9 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
 		// camera to be considered a lower priority. We will make sure that the stuff the user
 		// sees on screen gets loaded before this.
 		//
-		InsertHeadList(&m_PriorityQueues[ERP_Medium], &pResource->PagingEntry);
+		Priority = ERP_Medium;
+		TargetMip = GetLeastDetailedMipHeapIndex(pResource);
+		Score = PackedMipBonus;
 		pResource->TrimLimit = ERTP_Visible;
 		pResource->bIgnoreBudget = true;
 	}
@@ -412,7 +505,8 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
 		// This is a proximity prefetched mipmap. The user cannot see this mipmap yet, but it
 		// is nearby. We want to reduce any texture popping that may occur as the user scrolls
 		//
-		InsertTailList(&m_PriorityQueues[ERP_Medium], &pResource->PagingEntry);
+		Priority = ERP_Medium;
+		TargetMip = PrefetchMip;
 		pResource->TrimLimit = ERTP_NonPrefetchable;
 
 		assert(PrefetchMip != UNDEFINED_MIPMAP_INDEX);
@@ -425,17 +519,36 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
 		// occur after everything else, but will help guarantee that the user gets a smooth
 		// experience at all times by prefetching the texture data prior to being needed.
 		//
-		InsertTailList(&m_PriorityQueues[ERP_Low], &pResource->PagingEntry);
+		Priority = ERP_Low;
+		TargetMip = 0;
 		pResource->TrimLimit = ERTP_None;
 	}
+	else
+	{
+		//
+		// Every mipmap is resident, there is nothing left to page in.
+		//
+		return;
+	}
+
+	Score += CoverageWeight * pResource->ScreenCoverage;
+	Score -= DistanceWeight * pResource->ViewDistance;
+	Score += MipDeltaWeight * (MostDetailedMipResident - TargetMip);
+	Score -= AgeWeight * m_PrioritizationCount++;
+
+	pResource->Priority = Priority;
+	pResource->PagingScore = Score;
+	m_PriorityHeaps[Priority].Insert(pResource);
 }
 
 //
-// SelectResource will look at each of the priority queues and select the best operation
+// SelectResource will look at each of the priority heaps and select the best operation
 // to process. Unless marked otherwise, paging operations will not be selected if the
 // resulting paging operation is within a specific threshold of going over the budget.
+// PendingSize is the size of the mipmaps already selected for the current batch, which
+// are not yet included in the cached video memory usage.
 //
-Resource* PagingWorkerThread::SelectResource()
+Resource* PagingWorkerThread::SelectResource(UINT64 PendingSize)
 {
 	for (int i = 0; i < _ERP_COUNT; ++i)
 	{
@@ -450,16 +563,15 @@ Resource* PagingWorkerThread::SelectResource()
 		//
 		UINT64 BudgetBias = _1MB + _8MB * i;
 
-		if (!IsListEmpty(&m_PriorityQueues[i]))
+		if (!m_PriorityHeaps[i].IsEmpty())
 		{
-			LIST_ENTRY* pEntry = m_PriorityQueues[i].Flink;
-			Resource* pResource = CONTAINING_RECORD(pEntry, Resource, PagingEntry);
+			Resource* pResource = m_PriorityHeaps[i].Top();
 
 			//
-			// The paging thread will only page in one mipmap at a time to be fair to all
-			// resources. This allows resources to be selected in a round-robin sequence,
-			// preventing prefetching of low priority allocations to delay visibility changes
-			// from reprioritizing operations.
+			// The paging thread will only page in one mipmap of a resource at a time to be fair
+			// to all resources. After the mipmap is paged in, the resource is reprioritized,
+			// and is aged behind the resources which have been waiting longer. This prevents
+			// prefetching of low priority allocations from delaying visibility changes.
 			//
 			// Even though the paging operations are asycnhronous from rendering (i.e. they
 			// should not impact performance), it is still possible for the paging operations,
@@ -467,12 +579,7 @@ Resource* PagingWorkerThread::SelectResource()
 			// loading a large 8Kx8K mipmap far off screen could cause a significant enough delay
 			// to prevent a mipmap on screen from being loaded by the time it is actually visible.
 			//
-			UINT NextMip = IncreaseMipQuality(pResource->MostDetailedMipResident, 1);
-			UINT64 MipSize = 0;
-			if (NextMip < pResource->PackedMipHeapIndex)
-			{
-				MipSize = GetNonPackedMipSize(pResource, NextMip);
-			}
+			UINT64 MipSize = GetNextMipSize(pResource);
 
 			//
 			// When prioritizing operations, packed mipmaps are considered critical operations,
@@ -486,20 +593,23 @@ Resource* PagingWorkerThread::SelectResource()
 			//
 			if (!pResource->bIgnoreBudget)
 			{
-				DXGI_QUERY_VIDEO_MEMORY_INFO MemoryInfo = m_pFramework->GetLocalVideoMemoryInfo();
-				UINT64 TargetUsage = MemoryInfo.Budget - (MipSize + BudgetBias);
+				const DXGI_QUERY_VIDEO_MEMORY_INFO& MemoryInfo = m_pFramework->GetLocalVideoMemoryInfo();
+				UINT64 RequiredSize = MipSize + BudgetBias + PendingSize;
+				if (RequiredSize > MemoryInfo.Budget)
+				{
+					continue;
+				}
 
-				if (!m_pFramework->IsWithinBudgetThreshold(MipSize + BudgetBias))
+				if (!m_pFramework->IsWithinBudgetThreshold(RequiredSize))
 				{
-					if (!m_pFramework->TrimToTarget(pResource->TrimLimit, TargetUsage))
+					if (!m_pFramework->TrimToTarget(pResource->TrimLimit, MemoryInfo.Budget - RequiredSize))
 					{
 						continue;
 					}
 				}
 			}
 
-			RemoveEntryList(pEntry);
-			pEntry->Flink = nullptr;
+			m_PriorityHeaps[i].Remove(pResource);
 			pResource->bIgnoreBudget = false;
 
 			return pResource;
@@ -509,6 +619,103 @@ Resource* PagingWorkerThread::SelectResource()
 	return nullptr;
 }
 
+//
+// PagingHeap
+//
+// Resources are ordered by PagingScore, with the highest score at the top of the heap.
+//
+
+void PagingHeap::Insert(Resource* pResource)
+{
+	assert(pResource->PagingHeapIndex == INVALID_PAGING_HEAP_INDEX);
+
+	pResource->PagingHeapIndex = static_cast<UINT32>(m_Resources.size());
+	m_Resources.push_back(pResource);
+	SiftUp(pResource->PagingHeapIndex);
+}
+
+void PagingHeap::Remove(Resource* pResource)
+{
+	UINT32 Index = pResource->PagingHeapIndex;
+	assert(Index < m_Resources.size() && m_Resources[Index] == pResource);
+
+	UINT32 LastIndex = static_cast<UINT32>(m_Resources.size() - 1);
+	if (Index != LastIndex)
+	{
+		Swap(Index, LastIndex);
+	}
+	m_Resources.pop_back();
+	pResource->PagingHeapIndex = INVALID_PAGING_HEAP_INDEX;
+
+	//
+	// The resource moved into the hole may belong either above or below it.
+	//
+	if (Index < m_Resources.size())
+	{
+		SiftUp(Index);
+		SiftDown(Index);
+	}
+}
+
+void PagingHeap::Clear()
+{
+	for (Resource* pResource : m_Resources)
+	{
+		pResource->PagingHeapIndex = INVALID_PAGING_HEAP_INDEX;
+	}
+	m_Resources.clear();
+}
+
+void PagingHeap::SiftUp(UINT32 Index)
+{
+	while (Index > 0)
+	{
+		UINT32 Parent = (Index - 1) / 2;
+		if (m_Resources[Parent]->PagingScore >= m_Resources[Index]->PagingScore)
+		{
+			break;
+		}
+		Swap(Parent, Index);
+		Index = Parent;
+	}
+}
+
+void PagingHeap::SiftDown(UINT32 Index)
+{
+	UINT32 Count = static_cast<UINT32>(m_Resources.size());
+	for (;;)
+	{
+		UINT32 Largest = Index;
+		UINT32 Left = Index * 2 + 1;
+		UINT32 Right = Left + 1;
+
+		if (Left < Count && m_Resources[Left]->PagingScore > m_Resources[Largest]->PagingScore)
+		{
+			Largest = Left;
+		}
+		if (Right < Count && m_Resources[Right]->PagingScore > m_Resources[Largest]->PagingScore)
+		{
+			Largest = Right;
+		}
+		if (Largest == Index)
+		{
+			break;
+		}
+		Swap(Largest, Index);
+		Index = Largest;
+	}
+}
+
+void PagingHeap::Swap(UINT32 A, UINT32 B)
+{
+	Resource* pTemp = m_Resources[A];
+	m_Resources[A] = m_Resources[B];
+	m_Resources[B] = pTemp;
+
+	m_Resources[A]->PagingHeapIndex = A;
+	m_Resources[B]->PagingHeapIndex = B;
+}
+
 //
 // PagingContext
 //
@@ -47,6 +47,36 @@ enum WorkerThreadStatus
 	_EWTS_COUNT
 };
 
+//
+// An indexed binary max-heap of resources, ordered by paging score. Each resource stores
+// its own position in the heap, so that it can be removed and reinserted in O(log n) when
+// its visibility changes, instead of searching for it.
+//
+class PagingHeap
+{
+public:
+	inline bool IsEmpty() const
+	{
+		return m_Resources.empty();
+	}
+
+	inline Resource* Top() const
+	{
+		return m_Resources.front();
+	}
+
+	void Insert(Resource* pResource);
+	void Remove(Resource* pResource);
+	void Clear();
+
+private:
+	void SiftUp(UINT32 Index);
+	void SiftDown(UINT32 Index);
+	void Swap(UINT32 A, UINT32 B);
+
+	std::vector<Resource*> m_Resources;
+};
+
 //
 // The paging worker thread is the powerhouse behind all paging and texture streaming
 // for the sample.
@@ -82,9 +112,13 @@ private:
 	// the resource.
 	LIST_ENTRY m_PrioritizationListHead;
 
-	// An array of priority-ordered linked list heads. The worker thread will process
-	// resources in these arrays in strict order.
-	LIST_ENTRY m_PriorityQueues[_ERP_COUNT];
+	// An array of priority-ordered heaps. The worker thread will process resources in
+	// strict priority order, and in score order within each priority.
+	PagingHeap m_PriorityHeaps[_ERP_COUNT];
+
+	// Incremented every time a resource is prioritized, and used to age resources which
+	// have been waiting in the heaps for a long time.
+	UINT64 m_PrioritizationCount;
 
 private:
 	PagingWorkerThread(DX12Framework* pFramework);
@@ -99,7 +133,7 @@ private:
 	void EnqueueResource(Resource* pResource);
 	void ReprioritizeResources();
 	void PrioritizeResource(Resource* pResource);
-	Resource* SelectResource();
+	Resource* SelectResource(UINT64 PendingSize);
 
 	void ProcessStatusChangeRequest();
 	void ProcessSubmission(bool* pMoreWork);
@@ -52,6 +52,11 @@ enum ResourcePriority
 	_ERP_COUNT
 };
 
+//
+// Marks a resource which is not in any of the paging thread's priority heaps.
+//
+#define INVALID_PAGING_HEAP_INDEX 0xFFFFFFFF
+
 //
 // This enum is used to restrict the extent of trimming operations when the process
 // is over its local memory budget. This helps ensure that lower priority resources not
@@ -66,6 +71,7 @@ enum ResourceTrimPass
 	ERTP_NonPrefetchable,
 	ERTP_NonVisible,
 	ERTP_Visible,
+	_ERTP_COUNT
 };
 
 //
@@ -102,11 +108,27 @@ struct Resource
 	// List entry for tracking the commitment of mipmaps for this resource.
 	LIST_ENTRY CommittedListEntry;
 
+	// The trimming pass whose commitment lists contain the resource, or ERTP_None if
+	// the resource has no committed mipmaps.
+	ResourceTrimPass CommittedTrimPass;
+
 	// List entry used by the worker thread to prioritize paging operations.
 	LIST_ENTRY PrioritizationEntry;
 
-	// List entry used to track paging requests.
-	LIST_ENTRY PagingEntry;
+	// Position of the resource in the paging thread's priority heap for Priority, or
+	// INVALID_PAGING_HEAP_INDEX if the resource has no outstanding paging work.
+	UINT32 PagingHeapIndex;
+
+	// Set by the paging thread when the resource is prioritized. Resources are paged
+	// in by priority first, and by score within the same priority.
+	ResourcePriority Priority;
+	double PagingScore;
+
+	// The fraction of the viewport covered by the resource, and the distance of the
+	// resource from the center of the viewport (in viewport sizes). These are updated by
+	// the render thread along with VisibleMip and PrefetchMip.
+	float ScreenCoverage;
+	float ViewDistance;
 
 	CRITICAL_SECTION ReferenceLock;
 
@@ -157,6 +179,11 @@ struct Resource
 	// to ensure that every resource has at least some low quality content.
 	bool bIgnoreBudget : 1;
 
+	// Set by the paging thread while the resource is part of a paging batch. The batch
+	// pages in the next mip on top of the ones already resident, so TrimToTarget leaves
+	// the resource alone until the batch ends.
+	bool bInPagingBatch : 1;
+
 	// The maximum trimming pass that should be used to help resolve paging failures
 	// when paging in a resource would normally go over the budget. This limitation
 	// prevents resources from recursively trimming one another by preventing lower
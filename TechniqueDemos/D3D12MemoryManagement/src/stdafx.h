@@ -66,6 +66,7 @@
 #include <stdio.h>
 #include <new>
 #include <vector>
+#include <algorithm>
 #include <wrl.h>
 
 using Microsoft::WRL::ComPtr;